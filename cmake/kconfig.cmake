@@ -58,6 +58,8 @@ set(CONFIG_HEADERS
     ${CMAKE_SOURCE_DIR}/src/boards/board_config.h
     ${CMAKE_SOURCE_DIR}/src/boards/system_config.h
     ${CMAKE_SOURCE_DIR}/src/drivers/driver_config.h
+    ${CMAKE_SOURCE_DIR}/src/control/control_config.h
+    ${CMAKE_SOURCE_DIR}/src/services/service_config.h
     ${CMAKE_SOURCE_DIR}/src/application/app_config.h
 )
 
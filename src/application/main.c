@@ -2,16 +2,79 @@
 #include "drivers/led/led.h"
 #include "boards/led.h"
 #include "boards/board_config.h"
+#include "boards/cpu_load.h"
+#include "boards/gpio.h"
+#include "boards/irq.h"
+#include "services/deferred/deferred.h"
+#include "services/executive/executive.h"
+#include "service_config.h"
+#include "app_config.h"
+
+#define HEARTBEAT_PERIOD_US 500000U
 
 void SystemClock_Config(void);
 
+#if SERVICE_EXECUTIVE_ENABLE
+static executive_t executive;
+
+#if BOARD_HAS_LED1 && APP_DIAG_LED_HEARTBEAT
+static led_t heartbeat_led;
+static executive_timer_t heartbeat_timer;
+
+static void heartbeat_task(void *context)
+{
+    led_toggle((led_t *)context);
+}
+#endif
+
+#if APP_DIAG_CPU_LOAD
+static board_cpu_load_t cpu_load;
+static executive_timer_t cpu_load_timer;
+
+static void cpu_load_task(void *context)
+{
+    board_cpu_load_update((board_cpu_load_t *)context);
+}
+#endif
+#endif
+
 int main(void)
 {
     HAL_Init();
     SystemClock_Config();
+    board_irq_init();
+#if APP_DIAG_CPU_LOAD
+    board_cpu_load_init();
+#endif
     MX_GPIO_Init();
+    board_gpio_init();
+
+#if SERVICE_DEFERRED_ENABLE
+    deferred_init();
+#endif
+
+#if SERVICE_EXECUTIVE_ENABLE
+    executive_init(&executive);
+
+#if BOARD_HAS_LED1 && APP_DIAG_LED_HEARTBEAT
+    uint8_t heartbeat_id;
+    led_init(&heartbeat_led, board_led_get_config(BOARD_LED_1));
+    if (executive_add_task(&executive, "heartbeat", heartbeat_task, &heartbeat_led, &heartbeat_id) ==
+        EXECUTIVE_SUCCESS) {
+        executive_timer_start(&executive, &heartbeat_timer, heartbeat_id, HEARTBEAT_PERIOD_US, HEARTBEAT_PERIOD_US);
+    }
+#endif
+
+#if APP_DIAG_CPU_LOAD
+    uint8_t cpu_load_id;
+    if (executive_add_task(&executive, "cpu_load", cpu_load_task, &cpu_load, &cpu_load_id) == EXECUTIVE_SUCCESS) {
+        executive_timer_start(&executive, &cpu_load_timer, cpu_load_id, APP_DIAG_CPU_LOAD_WINDOW_MS * 1000U,
+                              APP_DIAG_CPU_LOAD_WINDOW_MS * 1000U);
+    }
+#endif
 
-#if BOARD_HAS_LED1
+    executive_run(&executive);
+#elif BOARD_HAS_LED1
     const board_led_config_t *led1_hw_config = board_led_get_config(BOARD_LED_1);
 
     led_t led1;
@@ -19,7 +82,7 @@ int main(void)
 
     while (1) {
         led_toggle(&led1);
-        HAL_Delay(500);
+        HAL_Delay(HEARTBEAT_PERIOD_US / 1000U);
     }
 #else
     while (1) {
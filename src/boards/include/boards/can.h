@@ -0,0 +1,85 @@
+#ifndef BOARD_CAN_H
+#define BOARD_CAN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOARD_CAN_MAX_DATA 64U
+#define BOARD_CAN_MAX_STD_FILTERS 28U
+#define BOARD_CAN_MAX_EXT_FILTERS 8U
+
+/* Frame flags */
+#define BOARD_CAN_FLAG_EXTENDED 0x01U /* 29-bit identifier */
+#define BOARD_CAN_FLAG_FD 0x02U       /* CAN FD frame format */
+#define BOARD_CAN_FLAG_BRS 0x04U      /* data phase at the data bit rate */
+
+typedef enum {
+    BOARD_CAN_NONE = -1,
+    BOARD_CAN_1 = 0,
+    BOARD_CAN_COUNT
+} board_can_id_t;
+
+struct board_can_config_t {
+    uint8_t instance_index;
+    uint8_t port_index;
+    uint8_t tx_pin;
+    uint8_t rx_pin;
+    uint8_t alternate;
+};
+
+typedef struct board_can_config_t board_can_config_t;
+
+typedef struct {
+    uint32_t nominal_bitrate;
+    uint32_t data_bitrate; /* 0 for classic CAN only */
+} board_can_bitrate_t;
+
+/* Accepts frames whose identifier matches id in every bit set in mask */
+typedef struct {
+    uint32_t id;
+    uint32_t mask;
+    bool extended;
+} board_can_filter_t;
+
+typedef struct {
+    uint32_t id;
+    uint8_t flags;
+    uint8_t length;      /* [bytes] */
+    uint32_t timestamp;  /* start of frame on the board timebase (boards/timebase.h) */
+    const uint8_t *data; /* points into the receive FIFO element; only valid during the callback */
+} board_can_rx_frame_t;
+
+/*
+ * Called from the CAN interrupt for each received frame. filter_index is the
+ * position in the filter list passed to board_can_init() that accepted it.
+ */
+typedef void (*board_can_rx_callback_t)(uint8_t filter_index, const board_can_rx_frame_t *frame, void *context);
+
+const board_can_config_t *board_can_get_config(board_can_id_t can_id);
+int board_can_is_supported(board_can_id_t can_id);
+
+/*
+ * Configure bit timing and acceptance filters and join the bus. Frames no
+ * filter matches are dropped by the hardware. Up to BOARD_CAN_MAX_STD_FILTERS
+ * standard and BOARD_CAN_MAX_EXT_FILTERS extended filters.
+ */
+bool board_can_init(const board_can_config_t *config, const board_can_bitrate_t *bitrate,
+                    const board_can_filter_t *filters, uint8_t filter_count, board_can_rx_callback_t rx_callback,
+                    void *context);
+
+/* Queue a frame without blocking; false when the transmit FIFO is full. Lengths round up to a valid DLC */
+bool board_can_transmit(const board_can_config_t *config, uint32_t id, uint8_t flags, const void *data,
+                        uint8_t length);
+
+bool board_can_is_bus_off(const board_can_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef BOARD_CLOCK_H
+#define BOARD_CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Free-running microsecond clock with one compare alarm, the wake-up source
+ * for the idle loop and the timestamp source for logging, protocols and
+ * profiling. board_clock_now() wraps every 71 minutes, so compare its times
+ * by unsigned subtraction only; board_clock_now64() does not wrap.
+ */
+typedef void (*board_clock_alarm_callback_t)(void *context);
+
+/* Starts the clock on the first call; later calls only replace the alarm callback */
+void board_clock_init(board_clock_alarm_callback_t callback, void *context);
+uint32_t board_clock_now(void); /* [us] */
+
+/*
+ * Monotonic time since board_clock_init() [us]. Lock-free and callable from
+ * any context, including with interrupts masked for up to 35 minutes.
+ */
+uint64_t board_clock_now64(void);
+
+/*
+ * Raise the alarm at time, or at once if time is not ahead of the clock.
+ * The callback runs from the alarm interrupt. A later call replaces the
+ * pending alarm.
+ */
+void board_clock_set_alarm(uint32_t time);
+void board_clock_cancel_alarm(void);
+
+/*
+ * Sleep until the next interrupt unless ready(context) returns true, which
+ * is checked with interrupts masked so a wake-up event cannot slip in
+ * between the check and the sleep. The 1 kHz HAL tick is stopped while
+ * asleep and HAL_GetTick() is advanced by the time slept on wake-up.
+ * Returns the time slept [us].
+ */
+uint32_t board_clock_sleep(bool (*ready)(void *context), void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef BOARD_CPU_LOAD_H
+#define BOARD_CPU_LOAD_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* What the core is running: thread mode, asleep, or one of the board's interrupts */
+typedef enum {
+    BOARD_CPU_LOAD_THREAD = 0,
+    BOARD_CPU_LOAD_IDLE,
+    BOARD_CPU_LOAD_TICK,
+    BOARD_CPU_LOAD_CLOCK,
+    BOARD_CPU_LOAD_DEFERRED,
+    BOARD_CPU_LOAD_RTOS_TICK,
+    BOARD_CPU_LOAD_UART1,
+    BOARD_CPU_LOAD_UART2,
+    BOARD_CPU_LOAD_RS485,
+    BOARD_CPU_LOAD_CAN,
+    BOARD_CPU_LOAD_USB,
+    BOARD_CPU_LOAD_CONTEXTS
+} board_cpu_load_context_t;
+
+typedef struct {
+    uint32_t cycles[BOARD_CPU_LOAD_CONTEXTS];    /* running totals, wrap */
+    uint32_t entries[BOARD_CPU_LOAD_CONTEXTS];   /* running totals, wrap */
+    uint32_t window;                             /* cycles in the last window */
+    uint16_t load[BOARD_CPU_LOAD_CONTEXTS];      /* share of the last window [permille] */
+    uint16_t load_max[BOARD_CPU_LOAD_CONTEXTS];  /* highest share of any window [permille] */
+} board_cpu_load_t;
+
+/*
+ * Cycle accounting on the board timebase (BOARD_CPU_LOAD_ENABLE). Every
+ * cycle is charged to the context running it. An interrupt charges its
+ * own time only, not that of interrupts nesting in it, and interrupts
+ * the board does not account for are charged to whatever they preempt.
+ */
+void board_cpu_load_init(void);
+
+/* First and last thing in an interrupt; pass the value enter returned to exit */
+uint32_t board_cpu_load_enter(board_cpu_load_context_t context);
+void board_cpu_load_exit(uint32_t preempted);
+
+/*
+ * Closes a window: the load of each context since the previous call into
+ * load, which starts zeroed. Call it periodically, within the 25 s it
+ * takes the timebase to wrap.
+ */
+void board_cpu_load_update(board_cpu_load_t *load);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef BOARD_CRC_H
+#define BOARD_CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Hardware CRC unit. The register holds the CRC shifted MSB first, right
+ * aligned to the polynomial width; reflected algorithms are computed by
+ * bit-reversing the input, and reflecting the result is left to the caller.
+ * Only one user at a time: callers arbitrate access themselves.
+ */
+int board_crc_is_supported(void);
+
+void board_crc_init(void);
+
+/* Load polynomial (without the top bit), width 7/8/16/32, input bit order and starting register value */
+void board_crc_configure(uint32_t polynomial, uint8_t width, bool reflect_in, uint32_t state);
+
+void board_crc_feed(const uint8_t *data, size_t length);
+
+uint32_t board_crc_read(void);
+
+/*
+ * Feed whole words by DMA in the background; reflected algorithms only, as
+ * the unit cannot byte-swap words read by DMA. false if the transfer cannot
+ * be started.
+ */
+bool board_crc_feed_dma_start(const uint32_t *words, size_t count);
+bool board_crc_feed_dma_busy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef BOARD_FLASH_H
+#define BOARD_FLASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Flash area reserved by the linker script for persistent parameters */
+struct board_flash_region_t {
+    uint32_t start;
+    uint32_t size;
+    uint32_t page_size;
+};
+
+typedef struct board_flash_region_t board_flash_region_t;
+
+/* Smallest programmable unit; writes must be aligned to and sized in multiples of it */
+#define BOARD_FLASH_PROGRAM_UNIT 8U
+
+const board_flash_region_t *board_flash_get_param_region(void);
+
+bool board_flash_erase(uint32_t address, uint32_t size);
+bool board_flash_program(uint32_t address, const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
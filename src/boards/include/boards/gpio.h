@@ -0,0 +1,89 @@
+#ifndef BOARD_GPIO_H
+#define BOARD_GPIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "boards/board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Board pins known at compile time. gen_config.py writes a descriptor into
+ * board_config.h for each pin enabled in Kconfig: BOARD_GPIO_<NAME>_PORT,
+ * _PORT_INDEX, _PIN, _MASK and _ACTIVE_LOW, for LED1, GATE_EN_U/V/W, FAULT,
+ * DEBUG1 and DEBUG2. The macros below take the pin name and fold into one
+ * store to BSRR, or one load of IDR, so they expand against the MCU header:
+ * use them where main.h is included. Test for a pin with
+ * #ifdef BOARD_GPIO_<NAME>_PORT.
+ */
+
+/* BSRR bits driving the pin to its active or inactive level; OR them together for pins of one port */
+#define BOARD_GPIO_ACTIVE_BITS(name)                                                                                   \
+    (BOARD_GPIO_##name##_ACTIVE_LOW ? (uint32_t)BOARD_GPIO_##name##_MASK << 16 : (uint32_t)BOARD_GPIO_##name##_MASK)
+#define BOARD_GPIO_INACTIVE_BITS(name)                                                                                 \
+    (BOARD_GPIO_##name##_ACTIVE_LOW ? (uint32_t)BOARD_GPIO_##name##_MASK : (uint32_t)BOARD_GPIO_##name##_MASK << 16)
+
+/* One write of BSRR bits to the port of name, which must be the port of every pin in bits */
+#define BOARD_GPIO_STORE(name, bits) (BOARD_GPIO_##name##_PORT->BSRR = (bits))
+
+#define BOARD_GPIO_ACTIVATE(name) BOARD_GPIO_STORE(name, BOARD_GPIO_ACTIVE_BITS(name))
+#define BOARD_GPIO_DEACTIVATE(name) BOARD_GPIO_STORE(name, BOARD_GPIO_INACTIVE_BITS(name))
+#define BOARD_GPIO_WRITE(name, active)                                                                                 \
+    BOARD_GPIO_STORE(name, (active) ? BOARD_GPIO_ACTIVE_BITS(name) : BOARD_GPIO_INACTIVE_BITS(name))
+
+/* A load of ODR and a store to BSRR, so an interrupt changing other pins of the port is not undone */
+#define BOARD_GPIO_TOGGLE(name)                                                                                        \
+    BOARD_GPIO_STORE(name, (BOARD_GPIO_##name##_PORT->ODR & BOARD_GPIO_##name##_MASK)                                  \
+                               ? (uint32_t)BOARD_GPIO_##name##_MASK << 16                                              \
+                               : (uint32_t)BOARD_GPIO_##name##_MASK)
+
+#define BOARD_GPIO_IS_ACTIVE(name)                                                                                     \
+    (((BOARD_GPIO_##name##_PORT->IDR & BOARD_GPIO_##name##_MASK) != 0U) != (BOARD_GPIO_##name##_ACTIVE_LOW != 0))
+
+/* Build check to put before merging the bits of two pins into one store */
+#define BOARD_GPIO_SAME_PORT(a, b)                                                                                     \
+    _Static_assert(BOARD_GPIO_##a##_PORT_INDEX == BOARD_GPIO_##b##_PORT_INDEX, #a " and " #b " are on different ports")
+
+#ifdef BOARD_GPIO_GATE_EN_U_PORT
+#if BOARD_GPIO_GATE_EN_U_PORT_INDEX == BOARD_GPIO_GATE_EN_V_PORT_INDEX &&                                              \
+    BOARD_GPIO_GATE_EN_U_PORT_INDEX == BOARD_GPIO_GATE_EN_W_PORT_INDEX
+/* All three half-bridges in one write */
+#define BOARD_GPIO_GATE_EN_MERGED 1
+#define BOARD_GPIO_GATES_ENABLE()                                                                                      \
+    BOARD_GPIO_STORE(GATE_EN_U, BOARD_GPIO_ACTIVE_BITS(GATE_EN_U) | BOARD_GPIO_ACTIVE_BITS(GATE_EN_V) |                \
+                                    BOARD_GPIO_ACTIVE_BITS(GATE_EN_W))
+#define BOARD_GPIO_GATES_DISABLE()                                                                                     \
+    BOARD_GPIO_STORE(GATE_EN_U, BOARD_GPIO_INACTIVE_BITS(GATE_EN_U) | BOARD_GPIO_INACTIVE_BITS(GATE_EN_V) |            \
+                                    BOARD_GPIO_INACTIVE_BITS(GATE_EN_W))
+#else
+#define BOARD_GPIO_GATE_EN_MERGED 0
+#define BOARD_GPIO_GATES_ENABLE()                                                                                      \
+    do {                                                                                                               \
+        BOARD_GPIO_ACTIVATE(GATE_EN_U);                                                                                \
+        BOARD_GPIO_ACTIVATE(GATE_EN_V);                                                                                \
+        BOARD_GPIO_ACTIVATE(GATE_EN_W);                                                                                \
+    } while (0)
+#define BOARD_GPIO_GATES_DISABLE()                                                                                     \
+    do {                                                                                                               \
+        BOARD_GPIO_DEACTIVATE(GATE_EN_U);                                                                              \
+        BOARD_GPIO_DEACTIVATE(GATE_EN_V);                                                                              \
+        BOARD_GPIO_DEACTIVATE(GATE_EN_W);                                                                              \
+    } while (0)
+#endif
+#endif
+
+/*
+ * Configures every pin with a descriptor: outputs are driven inactive before they
+ * leave the reset state, the fault input is pulled towards inactive.
+ * Call it once, after MX_GPIO_Init().
+ */
+void board_gpio_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
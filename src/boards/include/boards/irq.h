@@ -0,0 +1,47 @@
+#ifndef BOARD_IRQ_H
+#define BOARD_IRQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Interrupt priorities are planned in Kconfig (BOARD_IRQ_PRIORITY_*), 0
+ * the most urgent, and each board file applies its own. board_irq_init()
+ * applies the plan to the vectors the generated HAL code sets up itself.
+ *
+ * With BOARD_IRQ_VECTORS_IN_RAM it also copies the vector table to SRAM
+ * and points VTOR at the copy, so handlers can be installed at run time.
+ * The HAL tick then skips HAL_TIM_IRQHandler() and its callback.
+ */
+void board_irq_init(void);
+
+typedef void (*board_irq_handler_t)(void);
+
+/*
+ * Points a device interrupt (the IRQn of the MCU) straight at a handler.
+ * Fails while the vector table is in flash. Install a handler before
+ * enabling its interrupt, or with the interrupt disabled.
+ */
+bool board_irq_set_handler(int32_t irqn, board_irq_handler_t handler);
+board_irq_handler_t board_irq_get_handler(int32_t irqn);
+
+/*
+ * Software interrupt at BOARD_IRQ_PRIORITY_DEFERRED, on a vector no
+ * peripheral of the board uses. Pending it from an interrupt of higher
+ * priority runs the handler once that interrupt and any others above it
+ * have returned.
+ */
+typedef void (*board_irq_soft_handler_t)(void);
+
+void board_irq_soft_init(board_irq_soft_handler_t handler);
+void board_irq_soft_pend(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
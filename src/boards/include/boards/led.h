@@ -17,9 +17,10 @@ typedef enum {
     BOARD_LED_COUNT
 } board_led_id_t;
 
+/* Resolved from the GPIO descriptors at build time, so a call is one register access */
 struct board_led_config_t {
-    uint8_t port_index;
-    uint16_t pin;
+    void *port;        /* GPIO port registers, NULL if the LED is not fitted */
+    uint16_t pin_mask;
 };
 
 typedef struct board_led_config_t board_led_config_t;
@@ -0,0 +1,75 @@
+#ifndef BOARD_RS485_H
+#define BOARD_RS485_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BOARD_RS485_NONE = -1,
+    BOARD_RS485_1 = 0,
+    BOARD_RS485_COUNT
+} board_rs485_id_t;
+
+typedef enum {
+    BOARD_RS485_PARITY_NONE = 0, /* with two stop bits */
+    BOARD_RS485_PARITY_EVEN,
+    BOARD_RS485_PARITY_ODD
+} board_rs485_parity_t;
+
+struct board_rs485_config_t {
+    uint8_t instance_index;
+    uint8_t port_index;
+    uint8_t tx_pin;
+    uint8_t rx_pin;
+    uint8_t de_pin;
+    uint8_t alternate;
+};
+
+typedef struct board_rs485_config_t board_rs485_config_t;
+
+/*
+ * Called from the UART interrupt when a frame ended: the line stayed idle for
+ * the receiver timeout after at least one byte. length bytes are in the
+ * receive buffer; error when any of them had a parity, framing or noise
+ * error, or the frame did not fit the buffer. timestamp is the board
+ * timebase at the interrupt. Reception stays stopped until
+ * board_rs485_receive().
+ */
+typedef void (*board_rs485_rx_callback_t)(size_t length, bool error, uint32_t timestamp, void *context);
+
+/* Called from the UART interrupt once the last stop bit left and the driver is disabled again */
+typedef void (*board_rs485_tx_callback_t)(void *context);
+
+const board_rs485_config_t *board_rs485_get_config(board_rs485_id_t rs485_id);
+int board_rs485_is_supported(board_rs485_id_t rs485_id);
+
+/*
+ * Half-duplex UART with the transceiver's driver enable on the UART's DE
+ * output, asserted by the hardware one bit before the start bit and released
+ * one bit after the last stop bit. Frames are received by DMA into
+ * rx_buffer and delimited by the hardware receiver timeout, timeout_bits
+ * bit times of idle line.
+ */
+bool board_rs485_init(const board_rs485_config_t *config, uint32_t baudrate, board_rs485_parity_t parity,
+                      uint32_t timeout_bits, uint8_t *rx_buffer, size_t rx_size, board_rs485_rx_callback_t rx_callback,
+                      board_rs485_tx_callback_t tx_callback, void *context);
+
+/* Receive the next frame into the start of the receive buffer */
+void board_rs485_receive(const board_rs485_config_t *config);
+
+/*
+ * Send a frame by DMA; data must stay untouched until the transmit callback.
+ * false while a transmission is in progress.
+ */
+bool board_rs485_transmit(const board_rs485_config_t *config, const uint8_t *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef BOARD_RTOS_PORT_H
+#define BOARD_RTOS_PORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Context switching for the kernel in services/rtos. The kernel's thread
+ * control block starts with a board_rtos_thread_t, where the switch code
+ * keeps the saved context.
+ */
+typedef struct {
+    void *context;
+} board_rtos_thread_t;
+
+/* The thread whose context is live, and the one the next switch moves to */
+extern board_rtos_thread_t *volatile board_rtos_current;
+extern board_rtos_thread_t *volatile board_rtos_next;
+
+/* Board timebase at the end of the last switch */
+extern volatile uint32_t board_rtos_switched_at;
+
+/*
+ * Lay out the initial context of a thread that calls entry(argument) and
+ * then exit(). Returns false if the stack cannot hold it.
+ */
+bool board_rtos_thread_init(board_rtos_thread_t *thread, void *stack, size_t stack_size, void (*entry)(void *),
+                            void *argument, void (*exit)(void));
+
+/* Start the tick, which calls tick() at tick_frequency, and switch to first. Never returns */
+void board_rtos_start(board_rtos_thread_t *first, uint32_t tick_frequency, void (*tick)(void));
+
+/*
+ * Switch to board_rtos_next once the caller leaves its critical section,
+ * or its interrupt. Calling it again before then is harmless.
+ */
+void board_rtos_switch(void);
+
+/* Mask interrupts, nesting: unlock with what lock returned */
+uint32_t board_rtos_lock(void);
+void board_rtos_unlock(uint32_t state);
+
+bool board_rtos_in_isr(void);
+
+/* Called in a loop by the idle thread: wait for an interrupt */
+void board_rtos_idle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef BOARD_TIMEBASE_H
+#define BOARD_TIMEBASE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Free-running 32-bit counter shared by every timestamp on the board. It
+ * wraps, so compare values by unsigned subtraction only.
+ */
+void board_timebase_init(void);
+uint32_t board_timebase_now(void);
+uint32_t board_timebase_frequency(void); /* [Hz] */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
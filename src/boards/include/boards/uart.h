@@ -0,0 +1,48 @@
+#ifndef BOARD_UART_H
+#define BOARD_UART_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BOARD_UART_NONE = -1,
+    BOARD_UART_1 = 0,
+    BOARD_UART_2,
+    BOARD_UART_COUNT
+} board_uart_id_t;
+
+struct board_uart_config_t {
+    uint8_t instance_index;
+    uint8_t port_index;
+    uint8_t tx_pin;
+    uint8_t rx_pin;
+    uint8_t alternate;
+};
+
+typedef struct board_uart_config_t board_uart_config_t;
+
+/* Called from the UART interrupt; returns the next byte to send or -1 when there is none */
+typedef int (*board_uart_tx_callback_t)(void *context);
+
+/* Called from the UART interrupt for every received byte */
+typedef void (*board_uart_rx_callback_t)(uint8_t byte, void *context);
+
+const board_uart_config_t *board_uart_get_config(board_uart_id_t uart_id);
+int board_uart_is_supported(board_uart_id_t uart_id);
+
+bool board_uart_init(const board_uart_config_t *config, uint32_t baudrate, board_uart_tx_callback_t tx_callback,
+                     board_uart_rx_callback_t rx_callback, void *context);
+
+/* Enable the transmit-empty interrupt; it disables itself once the callback runs dry */
+void board_uart_start_tx(const board_uart_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef BOARD_USB_H
+#define BOARD_USB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOARD_USB_SETUP_SIZE 8U
+#define BOARD_USB_MAX_ENDPOINTS 8U
+
+/* Endpoint addresses carry the direction in bit 7, as in descriptors */
+#define BOARD_USB_EP_IN 0x80U
+#define BOARD_USB_EP_NUMBER(address) ((uint8_t)((address) & 0x0FU))
+#define BOARD_USB_EP_IS_IN(address) (((address) & BOARD_USB_EP_IN) != 0U)
+
+typedef enum {
+    BOARD_USB_EP_CONTROL = 0,
+    BOARD_USB_EP_BULK,
+    BOARD_USB_EP_INTERRUPT
+} board_usb_ep_type_t;
+
+/*
+ * Called from the USB interrupt. reset: bus reset, endpoint 0 is open again
+ * and every other endpoint closed. setup: a SETUP packet on endpoint 0,
+ * which is also no longer stalled. out: a packet is waiting on an OUT
+ * endpoint (board_usb_ep_rx_length()); it stays there, and the endpoint NAKs
+ * once its buffers are full, until it is read. in: an IN endpoint has a free
+ * buffer. suspend: the bus went idle (true) or resumed (false).
+ *
+ * The endpoint buffers belong to the interrupt: apart from
+ * board_usb_ep_service(), call the endpoint functions from the callbacks.
+ */
+typedef struct {
+    void (*reset)(void *context);
+    void (*setup)(const uint8_t *packet, void *context);
+    void (*out)(uint8_t address, void *context);
+    void (*in)(uint8_t address, void *context);
+    void (*suspend)(bool suspended, void *context);
+} board_usb_callbacks_t;
+
+int board_usb_is_supported(void);
+
+/* Start the 48 MHz clock, reset the peripheral and attach to the bus */
+bool board_usb_init(const board_usb_callbacks_t *callbacks, void *context);
+
+/* Unique per chip, for the serial number string */
+uint32_t board_usb_get_unique_id(void);
+
+/* Apply the address from SET_ADDRESS; call once its status stage completed */
+void board_usb_set_address(uint8_t address);
+
+/*
+ * Open an endpoint with buffers in packet memory until the next bus reset.
+ * Double buffering lets the hardware move one packet while the other buffer
+ * is filled or drained, and is available on bulk endpoints only.
+ */
+bool board_usb_ep_open(uint8_t address, board_usb_ep_type_t type, uint16_t max_packet, bool double_buffered);
+
+/*
+ * Queue one packet of length + length2 bytes, gathered from two blocks so a
+ * ring can be sent across its end; length 0 sends a zero-length packet.
+ * false when every buffer of the endpoint is still in use.
+ */
+bool board_usb_ep_write(uint8_t address, const uint8_t *data, size_t length, const uint8_t *data2, size_t length2);
+
+/* Size of the oldest packet waiting on an OUT endpoint, or -1 when there is none */
+int board_usb_ep_rx_length(uint8_t address);
+
+/*
+ * Copy the oldest waiting packet into two blocks, length bytes first, and
+ * hand its buffer back to the hardware. The blocks must hold the packet.
+ */
+void board_usb_ep_read(uint8_t address, uint8_t *data, size_t length, uint8_t *data2, size_t length2);
+
+void board_usb_ep_stall(uint8_t address, bool stalled);
+bool board_usb_ep_is_stalled(uint8_t address);
+
+/* From any context: have the interrupt call in() or out() for the endpoint, e.g. when data or room appeared */
+void board_usb_ep_service(uint8_t address);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,3 +1,4 @@
+# Generated by CubeMX, plus the PARAMS region edited in by hand: reapply that after regenerating
 set(LINKER_SCRIPT_PATH ${BOARD_DIR}/stm32cubemx_generated/STM32G431XX_FLASH.ld)
 if(COMMAND set_linker_script)
     set_linker_script(${LINKER_SCRIPT_PATH})
@@ -0,0 +1,200 @@
+#ifndef BOARD_LL_H
+#define BOARD_LL_H
+
+/*
+ * Register-level helpers for the hot paths of the board, on the vendored
+ * LL headers. Everything is inline, so a call with a constant port, pin
+ * or channel compiles down to the register access itself. HAL is left to
+ * one-time setup. BOARD_HOT_PATH_HAL swaps the HAL calls back in where HAL
+ * has a function for the job, to compare the two.
+ */
+
+#include "boards/board_config.h"
+#include "main.h"
+#include "stm32g4xx.h"
+#include "stm32g4xx_ll_adc.h"
+#include "stm32g4xx_ll_dma.h"
+#include "stm32g4xx_ll_gpio.h"
+#include "stm32g4xx_ll_tim.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ---- GPIO: pins is a mask of one or more pins of the port ---- */
+
+static inline void board_ll_gpio_set(GPIO_TypeDef *port, uint32_t pins)
+{
+#if BOARD_HOT_PATH_HAL
+    HAL_GPIO_WritePin(port, (uint16_t)pins, GPIO_PIN_SET);
+#else
+    LL_GPIO_SetOutputPin(port, pins);
+#endif
+}
+
+static inline void board_ll_gpio_reset(GPIO_TypeDef *port, uint32_t pins)
+{
+#if BOARD_HOT_PATH_HAL
+    HAL_GPIO_WritePin(port, (uint16_t)pins, GPIO_PIN_RESET);
+#else
+    LL_GPIO_ResetOutputPin(port, pins);
+#endif
+}
+
+static inline void board_ll_gpio_write(GPIO_TypeDef *port, uint32_t pins, bool state)
+{
+    if (state) {
+        board_ll_gpio_set(port, pins);
+    } else {
+        board_ll_gpio_reset(port, pins);
+    }
+}
+
+/* One BSRR write, so an interrupt changing other pins of the port in between is not undone */
+static inline void board_ll_gpio_toggle(GPIO_TypeDef *port, uint32_t pins)
+{
+#if BOARD_HOT_PATH_HAL
+    HAL_GPIO_TogglePin(port, (uint16_t)pins);
+#else
+    LL_GPIO_TogglePin(port, pins);
+#endif
+}
+
+/* True if any of the pins reads high */
+static inline bool board_ll_gpio_read(GPIO_TypeDef *port, uint32_t pins)
+{
+#if BOARD_HOT_PATH_HAL
+    return HAL_GPIO_ReadPin(port, (uint16_t)pins) == GPIO_PIN_SET;
+#else
+    return (LL_GPIO_ReadInputPort(port) & pins) != 0U;
+#endif
+}
+
+/* ---- TIM ---- */
+
+static inline bool board_ll_tim_update_pending(const TIM_TypeDef *tim)
+{
+    return LL_TIM_IsActiveFlag_UPDATE(tim) != 0U;
+}
+
+static inline void board_ll_tim_clear_update(TIM_TypeDef *tim)
+{
+    LL_TIM_ClearFlag_UPDATE(tim);
+}
+
+static inline bool board_ll_tim_update_enabled(const TIM_TypeDef *tim)
+{
+    return LL_TIM_IsEnabledIT_UPDATE(tim) != 0U;
+}
+
+static inline uint32_t board_ll_tim_count(const TIM_TypeDef *tim)
+{
+    return LL_TIM_GetCounter(tim);
+}
+
+/* channel is 1 to 4 */
+static inline void board_ll_tim_set_compare(TIM_TypeDef *tim, uint32_t channel, uint32_t value)
+{
+    switch (channel) {
+        case 1U: LL_TIM_OC_SetCompareCH1(tim, value); break;
+        case 2U: LL_TIM_OC_SetCompareCH2(tim, value); break;
+        case 3U: LL_TIM_OC_SetCompareCH3(tim, value); break;
+        case 4U: LL_TIM_OC_SetCompareCH4(tim, value); break;
+        default: break;
+    }
+}
+
+/* The HAL tick on TIM3, as HAL_SuspendTick() and HAL_ResumeTick() but without the handle */
+static inline void board_ll_tick_suspend(void)
+{
+#if BOARD_HOT_PATH_HAL
+    HAL_SuspendTick();
+#else
+    LL_TIM_DisableIT_UPDATE(TIM3);
+#endif
+}
+
+static inline void board_ll_tick_resume(void)
+{
+#if BOARD_HOT_PATH_HAL
+    HAL_ResumeTick();
+#else
+    LL_TIM_EnableIT_UPDATE(TIM3);
+#endif
+}
+
+/* ---- ADC: rank is LL_ADC_INJ_RANK_1 to 4 ---- */
+
+static inline bool board_ll_adc_injected_done(const ADC_TypeDef *adc)
+{
+    return LL_ADC_IsActiveFlag_JEOS(adc) != 0U;
+}
+
+static inline void board_ll_adc_clear_injected(ADC_TypeDef *adc)
+{
+    LL_ADC_ClearFlag_JEOS(adc);
+}
+
+static inline uint16_t board_ll_adc_injected(const ADC_TypeDef *adc, uint32_t rank)
+{
+    return LL_ADC_INJ_ReadConversionData12(adc, rank);
+}
+
+static inline void board_ll_adc_start_regular(ADC_TypeDef *adc)
+{
+    LL_ADC_REG_StartConversion(adc);
+}
+
+static inline uint16_t board_ll_adc_regular(const ADC_TypeDef *adc)
+{
+    return LL_ADC_REG_ReadConversionData12(adc);
+}
+
+/* ---- DMA: channel is LL_DMA_CHANNEL_1 to 6 ---- */
+
+/*
+ * configuration is the LL_DMA_DIRECTION_* with the increment, size, mode
+ * and priority options; options left out take their reset value. The
+ * channel must be stopped.
+ */
+static inline void board_ll_dma_configure(DMA_TypeDef *dma, uint32_t channel, uint32_t periph, uint32_t memory,
+                                          uint32_t configuration)
+{
+    LL_DMA_ConfigTransfer(dma, channel, configuration);
+    LL_DMA_SetPeriphAddress(dma, channel, periph);
+    LL_DMA_SetMemoryAddress(dma, channel, memory);
+}
+
+static inline void board_ll_dma_start(DMA_TypeDef *dma, uint32_t channel, uint32_t count)
+{
+    LL_DMA_SetDataLength(dma, channel, count);
+    LL_DMA_EnableChannel(dma, channel);
+}
+
+static inline void board_ll_dma_stop(DMA_TypeDef *dma, uint32_t channel)
+{
+    LL_DMA_DisableChannel(dma, channel);
+}
+
+static inline bool board_ll_dma_enabled(DMA_TypeDef *dma, uint32_t channel)
+{
+    return LL_DMA_IsEnabledChannel(dma, channel) != 0U;
+}
+
+/* Transfers left of the count given to board_ll_dma_start() */
+static inline uint32_t board_ll_dma_remaining(DMA_TypeDef *dma, uint32_t channel)
+{
+    return LL_DMA_GetDataLength(dma, channel);
+}
+
+/* Transfer complete or transfer error */
+static inline bool board_ll_dma_finished(DMA_TypeDef *dma, uint32_t channel)
+{
+    return (dma->ISR & ((DMA_ISR_TCIF1 | DMA_ISR_TEIF1) << (channel * 4U))) != 0U;
+}
+
+static inline void board_ll_dma_clear(DMA_TypeDef *dma, uint32_t channel)
+{
+    WRITE_REG(dma->IFCR, DMA_IFCR_CGIF1 << (channel * 4U));
+}
+
+#endif
@@ -0,0 +1,445 @@
+#include "boards/can.h"
+#include "boards/board_config.h"
+#include "boards/cpu_load.h"
+#include "boards/timebase.h"
+#include "main.h"
+#include "stm32g4xx.h"
+
+#include <string.h>
+
+/* Fixed message RAM layout of the G4 FDCAN, in 32-bit words */
+#define CAN_RAM_STD_FILTER_OFFSET 0U
+#define CAN_RAM_EXT_FILTER_OFFSET (CAN_RAM_STD_FILTER_OFFSET + BOARD_CAN_MAX_STD_FILTERS)
+#define CAN_RAM_RX_FIFO0_OFFSET (CAN_RAM_EXT_FILTER_OFFSET + 2U * BOARD_CAN_MAX_EXT_FILTERS)
+#define CAN_RAM_RX_FIFO1_OFFSET (CAN_RAM_RX_FIFO0_OFFSET + 3U * CAN_RAM_ELEMENT_WORDS)
+#define CAN_RAM_TX_EVENT_OFFSET (CAN_RAM_RX_FIFO1_OFFSET + 3U * CAN_RAM_ELEMENT_WORDS)
+#define CAN_RAM_TX_FIFO_OFFSET (CAN_RAM_TX_EVENT_OFFSET + 3U * 2U)
+#define CAN_RAM_WORDS (CAN_RAM_TX_FIFO_OFFSET + 3U * CAN_RAM_ELEMENT_WORDS)
+#define CAN_RAM_ELEMENT_WORDS 18U
+
+/* Element fields */
+#define CAN_ELEMENT_XTD (1UL << 30)
+#define CAN_ELEMENT_STD_ID_POS 18U
+#define CAN_ELEMENT_FDF (1UL << 21)
+#define CAN_ELEMENT_BRS (1UL << 20)
+#define CAN_ELEMENT_DLC_POS 16U
+#define CAN_ELEMENT_FIDX_POS 24U
+#define CAN_FILTER_CLASSIC 2UL   /* SFT/EFT: id and mask */
+#define CAN_FILTER_TO_FIFO0 1UL  /* SFEC/EFEC: store in RX FIFO 0 */
+#define CAN_FILTER_REJECT 2UL    /* ANFS/ANFE: drop non-matching frames */
+
+#define CAN_SAMPLE_POINT_NOMINAL 800U /* [per mille] */
+#define CAN_SAMPLE_POINT_DATA 750U
+#define CAN_BITRATE_TOLERANCE 5000U /* [ppm] */
+
+typedef struct {
+    board_can_rx_callback_t rx_callback;
+    void *context;
+    uint32_t timebase_per_us;
+    /* Hardware filter index to position in the caller's filter list */
+    uint8_t std_filter_map[BOARD_CAN_MAX_STD_FILTERS];
+    uint8_t ext_filter_map[BOARD_CAN_MAX_EXT_FILTERS];
+} board_can_state_t;
+
+typedef struct {
+    uint32_t prescaler;
+    uint32_t tseg1;
+    uint32_t tseg2;
+} can_bit_timing_t;
+
+typedef struct {
+    uint32_t prescaler;
+    uint32_t tseg1;
+    uint32_t tseg2;
+} can_timing_limits_t;
+
+static const uint8_t dlc_to_length[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+
+static const can_timing_limits_t nominal_limits = {.prescaler = 512U, .tseg1 = 256U, .tseg2 = 128U};
+static const can_timing_limits_t data_limits = {.prescaler = 32U, .tseg1 = 32U, .tseg2 = 16U};
+
+static board_can_state_t can_states[BOARD_CAN_COUNT];
+
+static const board_can_config_t board_can_configs[BOARD_CAN_COUNT] = {
+#if BOARD_HAS_CAN1
+    /* Morpho CN10 pins 3/5 to an external transceiver */
+    [BOARD_CAN_1] = {.instance_index = BOARD_CAN_1, .port_index = 1, .tx_pin = 9, .rx_pin = 8,
+                     .alternate = GPIO_AF9_FDCAN1},
+#endif
+};
+
+static GPIO_TypeDef *get_gpio_port_from_index(int port_index)
+{
+    switch (port_index) {
+        case 0: return GPIOA;
+        case 1: return GPIOB;
+        case 2: return GPIOC;
+        case 3: return GPIOD;
+        default: return NULL;
+    }
+}
+
+static FDCAN_GlobalTypeDef *get_fdcan_from_index(int instance_index)
+{
+    switch (instance_index) {
+        case BOARD_CAN_1: return FDCAN1;
+        default: return NULL;
+    }
+}
+
+static volatile uint32_t *get_message_ram(int instance_index)
+{
+    return (volatile uint32_t *)(SRAMCAN_BASE + (uint32_t)instance_index * CAN_RAM_WORDS * 4U);
+}
+
+static uint8_t length_to_dlc(uint8_t length)
+{
+    uint8_t dlc = 0U;
+    while (dlc < 15U && dlc_to_length[dlc] < length) {
+        dlc++;
+    }
+    return dlc;
+}
+
+/*
+ * Prescaler and quanta with the bit rate closest to the one asked for, the
+ * smallest prescaler among equals for the finest sample point. 170 MHz
+ * divides few rates exactly, so up to CAN_BITRATE_TOLERANCE is accepted.
+ */
+static bool compute_bit_timing(uint32_t clock, uint32_t bitrate, uint32_t sample_point,
+                               const can_timing_limits_t *limits, can_bit_timing_t *timing)
+{
+    uint32_t best_error = CAN_BITRATE_TOLERANCE + 1U;
+
+    for (uint32_t prescaler = 1U; prescaler <= limits->prescaler; prescaler++) {
+        const uint32_t quanta = (clock + prescaler * bitrate / 2U) / (prescaler * bitrate);
+        if (quanta < 4U || quanta > 1U + limits->tseg1 + limits->tseg2) {
+            continue;
+        }
+
+        const uint64_t actual = (uint64_t)prescaler * quanta * bitrate;
+        const uint64_t deviation = (actual > clock) ? actual - clock : clock - actual;
+        const uint32_t error = (uint32_t)(deviation * 1000000U / actual);
+        if (error >= best_error) {
+            continue;
+        }
+
+        uint32_t tseg2 = quanta - (quanta * sample_point + 500U) / 1000U;
+        if (tseg2 < 1U) {
+            tseg2 = 1U;
+        } else if (tseg2 > limits->tseg2) {
+            tseg2 = limits->tseg2;
+        }
+        const uint32_t tseg1 = quanta - 1U - tseg2;
+        if (tseg1 > limits->tseg1) {
+            continue;
+        }
+
+        timing->prescaler = prescaler;
+        timing->tseg1 = tseg1;
+        timing->tseg2 = tseg2;
+        best_error = error;
+    }
+
+    return best_error <= CAN_BITRATE_TOLERANCE;
+}
+
+static bool configure_bit_timing(FDCAN_GlobalTypeDef *fdcan, const board_can_bitrate_t *bitrate)
+{
+    uint32_t clock = HAL_RCC_GetPCLK1Freq();
+    can_bit_timing_t nominal;
+
+    if (!compute_bit_timing(clock, bitrate->nominal_bitrate, CAN_SAMPLE_POINT_NOMINAL, &nominal_limits, &nominal)) {
+        return false;
+    }
+
+    /* SJW as long as phase segment 2 for the widest resynchronisation range */
+    fdcan->NBTP = ((nominal.tseg2 - 1U) << FDCAN_NBTP_NSJW_Pos) | ((nominal.prescaler - 1U) << FDCAN_NBTP_NBRP_Pos) |
+                  ((nominal.tseg1 - 1U) << FDCAN_NBTP_NTSEG1_Pos) | ((nominal.tseg2 - 1U) << FDCAN_NBTP_NTSEG2_Pos);
+
+    if (bitrate->data_bitrate == 0U) {
+        return true;
+    }
+
+    can_bit_timing_t data;
+    if (!compute_bit_timing(clock, bitrate->data_bitrate, CAN_SAMPLE_POINT_DATA, &data_limits, &data)) {
+        return false;
+    }
+
+    fdcan->DBTP = ((data.prescaler - 1U) << FDCAN_DBTP_DBRP_Pos) | ((data.tseg1 - 1U) << FDCAN_DBTP_DTSEG1_Pos) |
+                  ((data.tseg2 - 1U) << FDCAN_DBTP_DTSEG2_Pos) | ((data.tseg2 - 1U) << FDCAN_DBTP_DSJW_Pos);
+
+    /*
+     * Transmitter delay compensation: secondary sample point at the data
+     * sample point. Out of range only at the slow data rates, e.g.
+     * 1 Mbit/s, where the transceiver loop delay fits in the bit anyway.
+     */
+    const uint32_t tdc_offset = data.prescaler * (1U + data.tseg1);
+    if (tdc_offset <= (FDCAN_TDCR_TDCO_Msk >> FDCAN_TDCR_TDCO_Pos)) {
+        fdcan->DBTP |= FDCAN_DBTP_TDC;
+        fdcan->TDCR = tdc_offset << FDCAN_TDCR_TDCO_Pos;
+    }
+    fdcan->CCCR |= FDCAN_CCCR_FDOE | FDCAN_CCCR_BRSE;
+
+    return true;
+}
+
+static bool configure_filters(int instance_index, const board_can_filter_t *filters, uint8_t filter_count,
+                              uint32_t *std_count, uint32_t *ext_count)
+{
+    volatile uint32_t *ram = get_message_ram(instance_index);
+    board_can_state_t *state = &can_states[instance_index];
+
+    *std_count = 0U;
+    *ext_count = 0U;
+
+    for (uint8_t i = 0U; i < filter_count; i++) {
+        const board_can_filter_t *filter = &filters[i];
+
+        if (filter->extended) {
+            if (*ext_count >= BOARD_CAN_MAX_EXT_FILTERS) {
+                return false;
+            }
+            volatile uint32_t *element = &ram[CAN_RAM_EXT_FILTER_OFFSET + 2U * *ext_count];
+            element[0] = (CAN_FILTER_TO_FIFO0 << 29) | (filter->id & 0x1FFFFFFFUL);
+            element[1] = (CAN_FILTER_CLASSIC << 30) | (filter->mask & 0x1FFFFFFFUL);
+            state->ext_filter_map[(*ext_count)++] = i;
+        } else {
+            if (*std_count >= BOARD_CAN_MAX_STD_FILTERS) {
+                return false;
+            }
+            ram[CAN_RAM_STD_FILTER_OFFSET + *std_count] = (CAN_FILTER_CLASSIC << 30) | (CAN_FILTER_TO_FIFO0 << 27) |
+                                                          ((filter->id & 0x7FFUL) << 16) | (filter->mask & 0x7FFUL);
+            state->std_filter_map[(*std_count)++] = i;
+        }
+    }
+
+    return true;
+}
+
+const board_can_config_t *board_can_get_config(board_can_id_t can_id)
+{
+    if (can_id < 0 || can_id >= BOARD_CAN_COUNT || !board_can_is_supported(can_id)) {
+        return NULL;
+    }
+
+    return &board_can_configs[can_id];
+}
+
+int board_can_is_supported(board_can_id_t can_id)
+{
+    switch (can_id) {
+#if BOARD_HAS_CAN1
+        case BOARD_CAN_1: return 1;
+#endif
+        default: return 0;
+    }
+}
+
+bool board_can_init(const board_can_config_t *config, const board_can_bitrate_t *bitrate,
+                    const board_can_filter_t *filters, uint8_t filter_count, board_can_rx_callback_t rx_callback,
+                    void *context)
+{
+    if (config == NULL || bitrate == NULL || bitrate->nominal_bitrate == 0U || (filters == NULL && filter_count > 0U)) {
+        return false;
+    }
+
+    FDCAN_GlobalTypeDef *fdcan = get_fdcan_from_index(config->instance_index);
+    GPIO_TypeDef *port = get_gpio_port_from_index(config->port_index);
+    if (fdcan == NULL || port == NULL) {
+        return false;
+    }
+
+    board_timebase_init();
+    can_states[config->instance_index].rx_callback = rx_callback;
+    can_states[config->instance_index].context = context;
+    can_states[config->instance_index].timebase_per_us = board_timebase_frequency() / 1000000U;
+
+    /* PCLK1 is derived from the HSE crystal and divides evenly into the common bit rates */
+    __HAL_RCC_FDCAN_CONFIG(RCC_FDCANCLKSOURCE_PCLK1);
+    __HAL_RCC_FDCAN_CLK_ENABLE();
+
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Pin = (uint16_t)((1U << config->tx_pin) | (1U << config->rx_pin));
+    gpio.Mode = GPIO_MODE_AF_PP;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+    gpio.Alternate = config->alternate;
+    HAL_GPIO_Init(port, &gpio);
+
+    fdcan->CCCR |= FDCAN_CCCR_INIT;
+    while ((fdcan->CCCR & FDCAN_CCCR_INIT) == 0U) {
+    }
+    fdcan->CCCR |= FDCAN_CCCR_CCE;
+    fdcan->CCCR &= ~(FDCAN_CCCR_FDOE | FDCAN_CCCR_BRSE | FDCAN_CCCR_DAR);
+
+    if (!configure_bit_timing(fdcan, bitrate)) {
+        return false;
+    }
+
+    volatile uint32_t *ram = get_message_ram(config->instance_index);
+    for (uint32_t i = 0U; i < CAN_RAM_WORDS; i++) {
+        ram[i] = 0U;
+    }
+
+    uint32_t std_count;
+    uint32_t ext_count;
+    if (!configure_filters(config->instance_index, filters, filter_count, &std_count, &ext_count)) {
+        return false;
+    }
+    fdcan->RXGFC = (ext_count << FDCAN_RXGFC_LSE_Pos) | (std_count << FDCAN_RXGFC_LSS_Pos) |
+                   (CAN_FILTER_REJECT << FDCAN_RXGFC_ANFS_Pos) | (CAN_FILTER_REJECT << FDCAN_RXGFC_ANFE_Pos) |
+                   FDCAN_RXGFC_RRFS | FDCAN_RXGFC_RRFE;
+
+    /*
+     * Timestamps from the TIM3 counter (the 1 MHz HAL tick timer). The
+     * internal counter counts bit times, which vary once frames switch to
+     * the data bit rate, so it cannot date frames across FD traffic.
+     */
+    fdcan->TSCC = 2U << FDCAN_TSCC_TSS_Pos;
+    fdcan->TXBC = 0U;
+
+    /* New and lost messages of RX FIFO 0 on interrupt line 0 */
+    fdcan->IR = 0xFFFFFFFFU;
+    fdcan->IE = FDCAN_IE_RF0NE | FDCAN_IE_RF0LE;
+    fdcan->ILS = 0U;
+    fdcan->ILE = FDCAN_ILE_EINT0;
+
+    HAL_NVIC_SetPriority(FDCAN1_IT0_IRQn, BOARD_IRQ_PRIORITY_CAN, 0U);
+    HAL_NVIC_EnableIRQ(FDCAN1_IT0_IRQn);
+
+    fdcan->CCCR &= ~FDCAN_CCCR_INIT;
+    while ((fdcan->CCCR & FDCAN_CCCR_INIT) != 0U) {
+    }
+
+    return true;
+}
+
+bool board_can_transmit(const board_can_config_t *config, uint32_t id, uint8_t flags, const void *data,
+                        uint8_t length)
+{
+    if (config == NULL || (data == NULL && length > 0U) || length > BOARD_CAN_MAX_DATA ||
+        ((flags & BOARD_CAN_FLAG_FD) == 0U && length > 8U)) {
+        return false;
+    }
+
+    FDCAN_GlobalTypeDef *fdcan = get_fdcan_from_index(config->instance_index);
+    if (fdcan == NULL) {
+        return false;
+    }
+
+    uint8_t dlc = length_to_dlc(length);
+    uint32_t header0 = ((flags & BOARD_CAN_FLAG_EXTENDED) != 0U) ? (CAN_ELEMENT_XTD | (id & 0x1FFFFFFFUL))
+                                                                  : ((id & 0x7FFUL) << CAN_ELEMENT_STD_ID_POS);
+    uint32_t header1 = (uint32_t)dlc << CAN_ELEMENT_DLC_POS;
+    if ((flags & BOARD_CAN_FLAG_FD) != 0U) {
+        header1 |= CAN_ELEMENT_FDF;
+        if ((flags & BOARD_CAN_FLAG_BRS) != 0U) {
+            header1 |= CAN_ELEMENT_BRS;
+        }
+    }
+
+    /* The control ISR and the background both transmit: claim the FIFO slot atomically */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if ((fdcan->TXFQS & FDCAN_TXFQS_TFQF) != 0U) {
+        __set_PRIMASK(primask);
+        return false;
+    }
+
+    uint32_t index = (fdcan->TXFQS & FDCAN_TXFQS_TFQPI) >> FDCAN_TXFQS_TFQPI_Pos;
+    volatile uint32_t *element =
+        &get_message_ram(config->instance_index)[CAN_RAM_TX_FIFO_OFFSET + index * CAN_RAM_ELEMENT_WORDS];
+    element[0] = header0;
+    element[1] = header1;
+
+    /* Message RAM takes word writes; pad up to the DLC length with zeros */
+    const uint8_t *src = (const uint8_t *)data;
+    for (uint32_t offset = 0U; offset < dlc_to_length[dlc]; offset += 4U) {
+        uint32_t word = 0U;
+        if (offset < length) {
+            memcpy(&word, &src[offset], (length - offset < 4U) ? (length - offset) : 4U);
+        }
+        element[2U + offset / 4U] = word;
+    }
+
+    fdcan->TXBAR = 1UL << index;
+    __set_PRIMASK(primask);
+
+    return true;
+}
+
+bool board_can_is_bus_off(const board_can_config_t *config)
+{
+    FDCAN_GlobalTypeDef *fdcan = (config != NULL) ? get_fdcan_from_index(config->instance_index) : NULL;
+    return fdcan != NULL && (fdcan->PSR & FDCAN_PSR_BO) != 0U;
+}
+
+/* Handlers read each frame in place from its FIFO element; the slot is released after they return */
+static void can_irq_handler(int instance_index)
+{
+    FDCAN_GlobalTypeDef *fdcan = get_fdcan_from_index(instance_index);
+    board_can_state_t *state = &can_states[instance_index];
+    volatile uint32_t *ram = get_message_ram(instance_index);
+
+    fdcan->IR = FDCAN_IR_RF0N | FDCAN_IR_RF0L;
+
+    while ((fdcan->RXF0S & FDCAN_RXF0S_F0FL) != 0U) {
+        /*
+         * Date the frame on the board timebase: its TIM3 timestamp gives the
+         * age in microseconds, modulo the 1 ms TIM3 period, which is far
+         * longer than any frame waits for this interrupt.
+         */
+        uint32_t now = board_timebase_now();
+        uint32_t now_us = TIM3->CNT;
+        uint32_t wrap_us = TIM3->ARR + 1U;
+
+        uint32_t index = (fdcan->RXF0S & FDCAN_RXF0S_F0GI) >> FDCAN_RXF0S_F0GI_Pos;
+        const volatile uint32_t *element = &ram[CAN_RAM_RX_FIFO0_OFFSET + index * CAN_RAM_ELEMENT_WORDS];
+        uint32_t header0 = element[0];
+        uint32_t header1 = element[1];
+
+        board_can_rx_frame_t frame;
+        uint8_t filter = (uint8_t)((header1 >> CAN_ELEMENT_FIDX_POS) & 0x7FU);
+        uint8_t filter_index;
+        if ((header0 & CAN_ELEMENT_XTD) != 0U) {
+            frame.id = header0 & 0x1FFFFFFFUL;
+            frame.flags = BOARD_CAN_FLAG_EXTENDED;
+            filter_index = state->ext_filter_map[filter % BOARD_CAN_MAX_EXT_FILTERS];
+        } else {
+            frame.id = (header0 >> CAN_ELEMENT_STD_ID_POS) & 0x7FFUL;
+            frame.flags = 0U;
+            filter_index = state->std_filter_map[filter % BOARD_CAN_MAX_STD_FILTERS];
+        }
+        if ((header1 & CAN_ELEMENT_FDF) != 0U) {
+            frame.flags |= BOARD_CAN_FLAG_FD;
+        }
+        if ((header1 & CAN_ELEMENT_BRS) != 0U) {
+            frame.flags |= BOARD_CAN_FLAG_BRS;
+        }
+        frame.length = dlc_to_length[(header1 >> CAN_ELEMENT_DLC_POS) & 0xFU];
+        uint32_t age_us = (now_us + wrap_us - (header1 & 0xFFFFU)) % wrap_us;
+        frame.timestamp = now - age_us * state->timebase_per_us;
+        frame.data = (const uint8_t *)&element[2];
+
+        if (state->rx_callback != NULL) {
+            state->rx_callback(filter_index, &frame, state->context);
+        }
+
+        fdcan->RXF0A = index;
+    }
+}
+
+#if BOARD_HAS_CAN1
+void FDCAN1_IT0_IRQHandler(void)
+{
+#if BOARD_CPU_LOAD_ENABLE
+    const uint32_t preempted = board_cpu_load_enter(BOARD_CPU_LOAD_CAN);
+#endif
+    can_irq_handler(BOARD_CAN_1);
+#if BOARD_CPU_LOAD_ENABLE
+    board_cpu_load_exit(preempted);
+#endif
+}
+#endif
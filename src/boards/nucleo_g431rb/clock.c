@@ -0,0 +1,186 @@
+#include "boards/clock.h"
+#include "boards/board_config.h"
+#include "boards/cpu_load.h"
+#include "board_ll.h"
+#include "main.h"
+#include "stm32g4xx.h"
+
+#define CLOCK_FREQUENCY 1000000U
+
+typedef struct {
+    board_clock_alarm_callback_t callback;
+    void *context;
+} board_clock_state_t;
+
+static board_clock_state_t clock_state;
+
+/* Halves of the counter's range passed, counted by the interrupt at 0 and at CLOCK_HALF_PERIOD */
+static volatile uint32_t clock_half_periods;
+
+#define CLOCK_HALF_PERIOD 0x80000000U
+
+/*
+ * TIM2 counts microseconds over its full 32 bits. Compare channel 1 is the
+ * alarm; the update event and compare channel 2 mark the half periods that
+ * extend the count to 64 bits.
+ */
+void board_clock_init(board_clock_alarm_callback_t callback, void *context)
+{
+    clock_state.callback = callback;
+    clock_state.context = context;
+
+    if ((TIM2->CR1 & TIM_CR1_CEN) != 0U) {
+        return;
+    }
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    __HAL_RCC_TIM2_FORCE_RESET();
+    __HAL_RCC_TIM2_RELEASE_RESET();
+
+    /* APB1 timers run at twice PCLK1 whenever APB1 is divided */
+    uint32_t timer_clock = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1_2) != 0U) {
+        timer_clock *= 2U;
+    }
+
+    TIM2->PSC = timer_clock / CLOCK_FREQUENCY - 1U;
+    TIM2->ARR = 0xFFFFFFFFU;
+    TIM2->CCR2 = CLOCK_HALF_PERIOD;
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->SR = 0U;
+    TIM2->DIER = TIM_DIER_UIE | TIM_DIER_CC2IE;
+    TIM2->CR1 = TIM_CR1_URS | TIM_CR1_CEN;
+
+    HAL_NVIC_SetPriority(TIM2_IRQn, BOARD_IRQ_PRIORITY_CLOCK, 0U);
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+uint32_t board_clock_now(void)
+{
+    return TIM2->CNT;
+}
+
+/*
+ * The half period count is read before the counter and is never ahead of
+ * it. It can lag by one, when the interrupt is still pending or comes in
+ * between the two reads; the counter's top bit then disagrees with its
+ * parity. No lock is needed, as long as the interrupt is not held off for
+ * a whole half period.
+ */
+uint64_t board_clock_now64(void)
+{
+    uint32_t half_periods = clock_half_periods;
+    const uint32_t count = TIM2->CNT;
+
+    if ((half_periods & 1U) != (count >> 31)) {
+        half_periods++;
+    }
+    return ((uint64_t)(half_periods >> 1) << 32) | count;
+}
+
+void board_clock_set_alarm(uint32_t time)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    TIM2->CCR1 = time;
+    TIM2->SR = ~TIM_SR_CC1IF;
+    TIM2->DIER |= TIM_DIER_CC1IE;
+
+    /* The compare only matches on equality, so a time already passed would wait a full wrap */
+    if ((int32_t)(time - TIM2->CNT) <= 0) {
+        TIM2->EGR = TIM_EGR_CC1G;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+void board_clock_cancel_alarm(void)
+{
+    TIM2->DIER &= ~TIM_DIER_CC1IE;
+    TIM2->SR = ~TIM_SR_CC1IF;
+}
+
+/*
+ * The HAL tick is TIM3 wrapping every millisecond. Its update interrupt is
+ * masked while asleep, but the counter keeps running: the ticks missed are
+ * the TIM3 wraps, counted from the time slept on TIM2 and the TIM3 phase
+ * before and after. Every wrap is counted once, either here or by the tick
+ * interrupt after it is resumed.
+ */
+uint32_t board_clock_sleep(bool (*ready)(void *context), void *context)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (ready != NULL && ready(context)) {
+        __set_PRIMASK(primask);
+        return 0U;
+    }
+
+    board_ll_tick_suspend();
+
+    /* A tick already due is cleared below along with the ones slept through */
+    if (board_ll_tim_update_pending(TIM3)) {
+        board_ll_tim_clear_update(TIM3);
+        uwTick += (uint32_t)uwTickFreq;
+    }
+    const uint32_t tick_period = TIM3->ARR + 1U;
+    const uint32_t phase_before = board_ll_tim_count(TIM3);
+    const uint32_t start = TIM2->CNT;
+
+#if BOARD_CPU_LOAD_ENABLE
+    const uint32_t awake = board_cpu_load_enter(BOARD_CPU_LOAD_IDLE);
+#endif
+    __DSB();
+    __WFI();
+#if BOARD_CPU_LOAD_ENABLE
+    board_cpu_load_exit(awake);
+#endif
+
+    const uint32_t slept = TIM2->CNT - start;
+    const uint32_t phase_after = board_ll_tim_count(TIM3);
+    board_ll_tim_clear_update(TIM3);
+    NVIC_ClearPendingIRQ(TIM3_IRQn);
+
+    /* Rounded, as the two timers' prescalers are not in step */
+    uint32_t ticks = (slept + phase_before - phase_after + tick_period / 2U) / tick_period;
+
+    /* A wrap between reading the phase and clearing the flag would be lost */
+    if (TIM3->CNT < phase_after && (TIM3->SR & TIM_SR_UIF) == 0U) {
+        ticks++;
+    }
+    uwTick += ticks * (uint32_t)uwTickFreq;
+
+    board_ll_tick_resume();
+    __set_PRIMASK(primask);
+    return slept;
+}
+
+void TIM2_IRQHandler(void)
+{
+#if BOARD_CPU_LOAD_ENABLE
+    const uint32_t preempted = board_cpu_load_enter(BOARD_CPU_LOAD_CLOCK);
+#endif
+
+    /* Only one of the two is due at a time, half a period apart */
+    if ((TIM2->SR & TIM_SR_UIF) != 0U) {
+        TIM2->SR = ~TIM_SR_UIF;
+        clock_half_periods++;
+    }
+    if ((TIM2->SR & TIM_SR_CC2IF) != 0U) {
+        TIM2->SR = ~TIM_SR_CC2IF;
+        clock_half_periods++;
+    }
+
+    if ((TIM2->SR & TIM_SR_CC1IF) != 0U && (TIM2->DIER & TIM_DIER_CC1IE) != 0U) {
+        TIM2->DIER &= ~TIM_DIER_CC1IE;
+        TIM2->SR = ~TIM_SR_CC1IF;
+        if (clock_state.callback != NULL) {
+            clock_state.callback(clock_state.context);
+        }
+    }
+#if BOARD_CPU_LOAD_ENABLE
+    board_cpu_load_exit(preempted);
+#endif
+}
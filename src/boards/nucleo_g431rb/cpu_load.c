@@ -0,0 +1,99 @@
+#include "boards/cpu_load.h"
+#include "boards/board_config.h"
+#include "boards/timebase.h"
+#include "main.h"
+#include "stm32g4xx.h"
+
+#include <string.h>
+
+#if BOARD_CPU_LOAD_ENABLE
+
+static uint32_t load_cycles[BOARD_CPU_LOAD_CONTEXTS];
+static uint32_t load_entries[BOARD_CPU_LOAD_CONTEXTS];
+static uint32_t load_current; /* context running */
+static uint32_t load_since;   /* cycle count when it started running, or was last charged */
+
+/* Charges the running context up to now; interrupts masked */
+static inline void charge(void)
+{
+    const uint32_t now = DWT->CYCCNT;
+    load_cycles[load_current] += now - load_since;
+    load_since = now;
+}
+
+void board_cpu_load_init(void)
+{
+    board_timebase_init();
+
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    memset(load_cycles, 0, sizeof(load_cycles));
+    memset(load_entries, 0, sizeof(load_entries));
+    load_current = BOARD_CPU_LOAD_THREAD;
+    load_since = DWT->CYCCNT;
+
+    __set_PRIMASK(primask);
+}
+
+/* Masked for a dozen cycles, so an interrupt nesting in here cannot charge the same time twice */
+uint32_t board_cpu_load_enter(board_cpu_load_context_t context)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    charge();
+    const uint32_t preempted = load_current;
+    load_current = (uint32_t)context;
+    load_entries[context]++;
+
+    __set_PRIMASK(primask);
+    return preempted;
+}
+
+void board_cpu_load_exit(uint32_t preempted)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    charge();
+    load_current = preempted;
+
+    __set_PRIMASK(primask);
+}
+
+void board_cpu_load_update(board_cpu_load_t *load)
+{
+    if (load == NULL) {
+        return;
+    }
+
+    uint32_t cycles[BOARD_CPU_LOAD_CONTEXTS];
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    charge();
+    memcpy(cycles, load_cycles, sizeof(cycles));
+    memcpy(load->entries, load_entries, sizeof(load->entries));
+    __set_PRIMASK(primask);
+
+    /* Every cycle since the last call was charged to exactly one context */
+    uint32_t window = 0U;
+    for (uint32_t i = 0U; i < BOARD_CPU_LOAD_CONTEXTS; i++) {
+        window += cycles[i] - load->cycles[i];
+    }
+    load->window = window;
+    if (window == 0U) {
+        return;
+    }
+
+    for (uint32_t i = 0U; i < BOARD_CPU_LOAD_CONTEXTS; i++) {
+        const uint32_t used = cycles[i] - load->cycles[i];
+        load->cycles[i] = cycles[i];
+        load->load[i] = (uint16_t)(((uint64_t)used * 1000U + window / 2U) / window);
+        if (load->load[i] > load->load_max[i]) {
+            load->load_max[i] = load->load[i];
+        }
+    }
+}
+
+#endif
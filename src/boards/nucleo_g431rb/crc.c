@@ -0,0 +1,128 @@
+#include "boards/crc.h"
+#include "board_ll.h"
+
+#define CRC_DMA DMA1
+#define CRC_DMA_LL_CHANNEL LL_DMA_CHANNEL_1
+#define CRC_DMA_CHANNEL DMA1_Channel1
+#define CRC_DMAMUX_CHANNEL DMAMUX1_Channel0
+#define CRC_DMA_MAX_WORDS 0xFFFFU
+
+/* CR field values */
+#define CRC_REV_IN_NONE 0U
+#define CRC_REV_IN_BYTE (1U << CRC_CR_REV_IN_Pos)
+#define CRC_REV_IN_WORD (3U << CRC_CR_REV_IN_Pos)
+
+static bool reflected;
+
+static uint32_t get_polysize(uint8_t width)
+{
+    switch (width) {
+        case 7: return 3U << CRC_CR_POLYSIZE_Pos;
+        case 8: return 2U << CRC_CR_POLYSIZE_Pos;
+        case 16: return 1U << CRC_CR_POLYSIZE_Pos;
+        default: return 0U;
+    }
+}
+
+static void set_input_reversal(uint32_t rev_in)
+{
+    CRC->CR = (CRC->CR & ~CRC_CR_REV_IN) | rev_in;
+}
+
+int board_crc_is_supported(void)
+{
+    return 1;
+}
+
+void board_crc_init(void)
+{
+    __HAL_RCC_CRC_CLK_ENABLE();
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+}
+
+void board_crc_configure(uint32_t polynomial, uint8_t width, bool reflect_in, uint32_t state)
+{
+    reflected = reflect_in;
+    CRC->POL = polynomial;
+    CRC->INIT = state;
+    CRC->CR = get_polysize(width) | CRC_CR_RESET;
+}
+
+/*
+ * Words go in as single 32-bit writes, which the unit shifts in MSB first.
+ * Memory is little endian, so plain algorithms need the bytes swapped and
+ * reflected ones a full-word bit reversal, which puts the first byte's
+ * lowest bit first. Ragged ends are written bytewise.
+ */
+void board_crc_feed(const uint8_t *data, size_t length)
+{
+    uint32_t rev_byte = reflected ? CRC_REV_IN_BYTE : CRC_REV_IN_NONE;
+
+    set_input_reversal(rev_byte);
+    while (length > 0U && ((uintptr_t)data & 3U) != 0U) {
+        *(volatile uint8_t *)&CRC->DR = *data++;
+        length--;
+    }
+
+    const uint32_t *words = (const uint32_t *)(const void *)data;
+    size_t count = length / 4U;
+    if (reflected) {
+        set_input_reversal(CRC_REV_IN_WORD);
+        for (size_t i = 0U; i < count; i++) {
+            CRC->DR = words[i];
+        }
+        set_input_reversal(rev_byte);
+    } else {
+        for (size_t i = 0U; i < count; i++) {
+            CRC->DR = __REV(words[i]);
+        }
+    }
+
+    data += count * 4U;
+    for (size_t i = 0U; i < (length & 3U); i++) {
+        *(volatile uint8_t *)&CRC->DR = data[i];
+    }
+}
+
+uint32_t board_crc_read(void)
+{
+    return CRC->DR;
+}
+
+/* Memory-to-memory transfer: the buffer is the "peripheral" side, CRC->DR the fixed destination */
+bool board_crc_feed_dma_start(const uint32_t *words, size_t count)
+{
+    if (!reflected || words == NULL || count == 0U || count > CRC_DMA_MAX_WORDS ||
+        board_ll_dma_enabled(CRC_DMA, CRC_DMA_LL_CHANNEL)) {
+        return false;
+    }
+
+    set_input_reversal(CRC_REV_IN_WORD);
+
+    CRC_DMAMUX_CHANNEL->CCR = 0U;
+    board_ll_dma_clear(CRC_DMA, CRC_DMA_LL_CHANNEL);
+    CRC_DMA_CHANNEL->CPAR = (uint32_t)(uintptr_t)words;
+    CRC_DMA_CHANNEL->CMAR = (uint32_t)(uintptr_t)&CRC->DR;
+    CRC_DMA_CHANNEL->CNDTR = (uint32_t)count;
+    /* The whole configuration and the enable in one write */
+    CRC_DMA_CHANNEL->CCR = DMA_CCR_MEM2MEM | DMA_CCR_PINC | (2U << DMA_CCR_PSIZE_Pos) | (2U << DMA_CCR_MSIZE_Pos) |
+                           DMA_CCR_EN;
+
+    return true;
+}
+
+bool board_crc_feed_dma_busy(void)
+{
+    if (!board_ll_dma_enabled(CRC_DMA, CRC_DMA_LL_CHANNEL)) {
+        return false;
+    }
+    if (!board_ll_dma_finished(CRC_DMA, CRC_DMA_LL_CHANNEL)) {
+        return true;
+    }
+
+    board_ll_dma_stop(CRC_DMA, CRC_DMA_LL_CHANNEL);
+    board_ll_dma_clear(CRC_DMA, CRC_DMA_LL_CHANNEL);
+    set_input_reversal(CRC_REV_IN_BYTE);
+    return false;
+}
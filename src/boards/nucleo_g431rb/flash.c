@@ -0,0 +1,62 @@
+#include "boards/flash.h"
+#include "main.h"
+#include "stm32g4xx.h"
+
+#include <string.h>
+
+/* Provided by STM32G431XX_FLASH.ld, in an edit that CubeMX does not keep */
+extern uint32_t _sparams;
+extern uint32_t _eparams;
+
+static board_flash_region_t param_region;
+
+const board_flash_region_t *board_flash_get_param_region(void)
+{
+    if (param_region.size == 0U) {
+        param_region.start = (uint32_t)&_sparams;
+        param_region.size = (uint32_t)&_eparams - (uint32_t)&_sparams;
+        param_region.page_size = FLASH_PAGE_SIZE;
+    }
+
+    return &param_region;
+}
+
+bool board_flash_erase(uint32_t address, uint32_t size)
+{
+    if (size == 0U || ((address - FLASH_BASE) % FLASH_PAGE_SIZE) != 0U) {
+        return false;
+    }
+
+    FLASH_EraseInitTypeDef erase = {0};
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.Banks = FLASH_BANK_1;
+    erase.Page = (address - FLASH_BASE) / FLASH_PAGE_SIZE;
+    erase.NbPages = (size + FLASH_PAGE_SIZE - 1U) / FLASH_PAGE_SIZE;
+
+    uint32_t page_error = 0;
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &page_error);
+    HAL_FLASH_Lock();
+
+    return (status == HAL_OK);
+}
+
+bool board_flash_program(uint32_t address, const void *data, size_t size)
+{
+    if (data == NULL || (address % BOARD_FLASH_PROGRAM_UNIT) != 0U || (size % BOARD_FLASH_PROGRAM_UNIT) != 0U) {
+        return false;
+    }
+
+    const uint8_t *src = (const uint8_t *)data;
+    HAL_StatusTypeDef status = HAL_OK;
+
+    HAL_FLASH_Unlock();
+    for (size_t offset = 0; offset < size && status == HAL_OK; offset += BOARD_FLASH_PROGRAM_UNIT) {
+        uint64_t word;
+        memcpy(&word, &src[offset], sizeof(word));
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + offset, word);
+    }
+    HAL_FLASH_Lock();
+
+    return (status == HAL_OK);
+}
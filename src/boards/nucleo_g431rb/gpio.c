@@ -0,0 +1,55 @@
+#include "boards/gpio.h"
+#include "boards/board_config.h"
+#include "main.h"
+#include "stm32g4xx.h"
+
+/* Clock on, level set while the pin is still an input, then the mode */
+#define GPIO_INIT_OUTPUT(name)                                                                                         \
+    do {                                                                                                               \
+        enable_port_clock(BOARD_GPIO_##name##_PORT_INDEX);                                                             \
+        BOARD_GPIO_DEACTIVATE(name);                                                                                   \
+        init_pin(BOARD_GPIO_##name##_PORT, BOARD_GPIO_##name##_MASK, GPIO_MODE_OUTPUT_PP, GPIO_NOPULL);                \
+    } while (0)
+
+#define GPIO_INIT_INPUT(name)                                                                                          \
+    do {                                                                                                               \
+        enable_port_clock(BOARD_GPIO_##name##_PORT_INDEX);                                                             \
+        init_pin(BOARD_GPIO_##name##_PORT, BOARD_GPIO_##name##_MASK, GPIO_MODE_INPUT,                                  \
+                 BOARD_GPIO_##name##_ACTIVE_LOW ? GPIO_PULLUP : GPIO_PULLDOWN);                                        \
+    } while (0)
+
+/* GPIOAEN to GPIOGEN are bits 0 to 6 */
+static inline void enable_port_clock(uint32_t port_index)
+{
+    SET_BIT(RCC->AHB2ENR, RCC_AHB2ENR_GPIOAEN << port_index);
+    (void)READ_BIT(RCC->AHB2ENR, RCC_AHB2ENR_GPIOAEN << port_index);
+}
+
+static inline void init_pin(GPIO_TypeDef *port, uint32_t mask, uint32_t mode, uint32_t pull)
+{
+    GPIO_InitTypeDef init = {0};
+    init.Pin = mask;
+    init.Mode = mode;
+    init.Pull = pull;
+    init.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(port, &init);
+}
+
+void board_gpio_init(void)
+{
+#ifdef BOARD_GPIO_LED1_PORT
+    GPIO_INIT_OUTPUT(LED1);
+#endif
+#ifdef BOARD_GPIO_GATE_EN_U_PORT
+    GPIO_INIT_OUTPUT(GATE_EN_U);
+    GPIO_INIT_OUTPUT(GATE_EN_V);
+    GPIO_INIT_OUTPUT(GATE_EN_W);
+#endif
+#ifdef BOARD_GPIO_FAULT_PORT
+    GPIO_INIT_INPUT(FAULT);
+#endif
+#ifdef BOARD_GPIO_DEBUG1_PORT
+    GPIO_INIT_OUTPUT(DEBUG1);
+    GPIO_INIT_OUTPUT(DEBUG2);
+#endif
+}
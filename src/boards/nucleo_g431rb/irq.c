@@ -0,0 +1,131 @@
+#include "boards/irq.h"
+#include "boards/board_config.h"
+#include "boards/cpu_load.h"
+#include "board_ll.h"
+#include "main.h"
+#include "stm32g4xx.h"
+
+#include <string.h>
+
+/* The firmware has no use for SAI1, so its vector is free to pend by software */
+#define IRQ_SOFT_IRQN SAI1_IRQn
+
+/* The 16 system exceptions, then FMAC_IRQn, the last device interrupt */
+#define IRQ_EXCEPTIONS 16U
+#define IRQ_DEVICE_COUNT ((uint32_t)FMAC_IRQn + 1U)
+#define IRQ_VECTOR_COUNT (IRQ_EXCEPTIONS + IRQ_DEVICE_COUNT)
+
+static board_irq_soft_handler_t soft_handler;
+
+#if BOARD_IRQ_VECTORS_IN_RAM
+/* VTOR takes a table aligned to its size rounded up to a power of two */
+static board_irq_handler_t irq_vectors[IRQ_VECTOR_COUNT] __attribute__((aligned(512)));
+
+_Static_assert(IRQ_VECTOR_COUNT * 4U <= 512U, "vector table outgrows its alignment");
+
+/* What HAL_TIM_IRQHandler() and HAL_TIM_PeriodElapsedCallback() come down to for TIM3 */
+static void irq_tick_handler(void)
+{
+#if BOARD_CPU_LOAD_ENABLE
+    const uint32_t preempted = board_cpu_load_enter(BOARD_CPU_LOAD_TICK);
+#endif
+    /* HAL_SuspendTick() only masks the update; board_clock_sleep() counts what it misses */
+    if (board_ll_tim_update_pending(TIM3) && board_ll_tim_update_enabled(TIM3)) {
+        board_ll_tim_clear_update(TIM3);
+        uwTick += (uint32_t)uwTickFreq;
+    }
+#if BOARD_CPU_LOAD_ENABLE
+    board_cpu_load_exit(preempted);
+#endif
+}
+
+/* Runs once, from thread mode, before any handler is installed */
+static void irq_vectors_init(void)
+{
+    if (SCB->VTOR == (uint32_t)(uintptr_t)irq_vectors) {
+        return;
+    }
+
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    memcpy(irq_vectors, (const void *)(uintptr_t)SCB->VTOR, sizeof(irq_vectors));
+    irq_vectors[IRQ_EXCEPTIONS + (uint32_t)TIM3_IRQn] = irq_tick_handler;
+    SCB->VTOR = (uint32_t)(uintptr_t)irq_vectors;
+    __DSB();
+    __ISB();
+
+    __set_PRIMASK(primask);
+}
+#endif
+
+/* The HAL tick is set up by HAL_Init() and again by every clock change, each time at uwTickPrio */
+void board_irq_init(void)
+{
+    uwTickPrio = BOARD_IRQ_PRIORITY_TICK;
+    HAL_NVIC_SetPriority(TIM3_IRQn, BOARD_IRQ_PRIORITY_TICK, 0U);
+
+#if BOARD_IRQ_VECTORS_IN_RAM
+    irq_vectors_init();
+#endif
+}
+
+bool board_irq_set_handler(int32_t irqn, board_irq_handler_t handler)
+{
+#if BOARD_IRQ_VECTORS_IN_RAM
+    if (irqn < 0 || (uint32_t)irqn >= IRQ_DEVICE_COUNT || handler == NULL ||
+        SCB->VTOR != (uint32_t)(uintptr_t)irq_vectors) {
+        return false;
+    }
+
+    irq_vectors[IRQ_EXCEPTIONS + (uint32_t)irqn] = handler;
+    __DSB();
+    return true;
+#else
+    (void)irqn;
+    (void)handler;
+    return false;
+#endif
+}
+
+board_irq_handler_t board_irq_get_handler(int32_t irqn)
+{
+    if (irqn < 0 || (uint32_t)irqn >= IRQ_DEVICE_COUNT) {
+        return NULL;
+    }
+
+    const board_irq_handler_t *vectors = (const board_irq_handler_t *)(uintptr_t)SCB->VTOR;
+    return vectors[IRQ_EXCEPTIONS + (uint32_t)irqn];
+}
+
+void board_irq_soft_init(board_irq_soft_handler_t handler)
+{
+    soft_handler = handler;
+
+#if !BOARD_CPU_LOAD_ENABLE
+    /* Nothing to do around the handler, so it can take the vector itself */
+    board_irq_set_handler(IRQ_SOFT_IRQN, handler);
+#endif
+
+    HAL_NVIC_SetPriority(IRQ_SOFT_IRQN, BOARD_IRQ_PRIORITY_DEFERRED, 0U);
+    NVIC_ClearPendingIRQ(IRQ_SOFT_IRQN);
+    HAL_NVIC_EnableIRQ(IRQ_SOFT_IRQN);
+}
+
+void board_irq_soft_pend(void)
+{
+    NVIC->STIR = (uint32_t)IRQ_SOFT_IRQN;
+}
+
+void SAI1_IRQHandler(void)
+{
+#if BOARD_CPU_LOAD_ENABLE
+    const uint32_t preempted = board_cpu_load_enter(BOARD_CPU_LOAD_DEFERRED);
+#endif
+    if (soft_handler != NULL) {
+        soft_handler();
+    }
+#if BOARD_CPU_LOAD_ENABLE
+    board_cpu_load_exit(preempted);
+#endif
+}
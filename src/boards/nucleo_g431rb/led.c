@@ -1,32 +1,13 @@
 #include "boards/led.h"
 #include "boards/board_config.h"
-#include "main.h"
-#include "stm32g4xx.h"
+#include "boards/gpio.h"
+#include "board_ll.h"
 
 #define SUPPORTED_LED_COUNT BOARD_LED_COUNT
 
-static GPIO_TypeDef *get_gpio_port_from_index(int port_index)
-{
-    switch (port_index) {
-        case 0: return GPIOA;
-        case 1: return GPIOB;
-        case 2: return GPIOC;
-        case 3: return GPIOD;
-        default: return NULL;
-    }
-}
-
-static uint16_t get_gpio_pin_mask(int pin_number)
-{
-    if (pin_number < 0 || pin_number > 15) {
-        return 0;
-    }
-    return (uint16_t)(1U << pin_number);
-}
-
 static const board_led_config_t board_led_configs[BOARD_LED_COUNT] = {
-#if BOARD_HAS_LED1
-    [BOARD_LED_1] = {.port_index = BOARD_LED1_PORT, .pin = BOARD_LED1_PIN}
+#ifdef BOARD_GPIO_LED1_PORT
+    [BOARD_LED_1] = {.port = BOARD_GPIO_LED1_PORT, .pin_mask = BOARD_GPIO_LED1_MASK}
 #endif
 };
 
@@ -57,46 +38,27 @@ int board_led_is_supported(board_led_id_t led_id)
 
 void board_led_set_state(const board_led_config_t *config, bool state)
 {
-    if (config == NULL) {
+    if (config == NULL || config->port == NULL) {
         return;
     }
 
-    GPIO_TypeDef *port = get_gpio_port_from_index(config->port_index);
-    if (port == NULL) {
-        return;
-    }
-
-    uint16_t pin_mask = get_gpio_pin_mask(config->pin);
-    HAL_GPIO_WritePin(port, pin_mask, state ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    board_ll_gpio_write((GPIO_TypeDef *)config->port, config->pin_mask, state);
 }
 
 void board_led_toggle(const board_led_config_t *config)
 {
-    if (config == NULL) {
+    if (config == NULL || config->port == NULL) {
         return;
     }
 
-    GPIO_TypeDef *port = get_gpio_port_from_index(config->port_index);
-    if (port == NULL) {
-        return;
-    }
-
-    uint16_t pin_mask = get_gpio_pin_mask(config->pin);
-    HAL_GPIO_TogglePin(port, pin_mask);
+    board_ll_gpio_toggle((GPIO_TypeDef *)config->port, config->pin_mask);
 }
 
 bool board_led_get_state(const board_led_config_t *config)
 {
-    if (config == NULL) {
-        return false;
-    }
-
-    GPIO_TypeDef *port = get_gpio_port_from_index(config->port_index);
-    if (port == NULL) {
+    if (config == NULL || config->port == NULL) {
         return false;
     }
 
-    uint16_t pin_mask = get_gpio_pin_mask(config->pin);
-    GPIO_PinState pin_state = HAL_GPIO_ReadPin(port, pin_mask);
-    return (pin_state == GPIO_PIN_SET);
+    return board_ll_gpio_read((GPIO_TypeDef *)config->port, config->pin_mask);
 }
@@ -0,0 +1,252 @@
+#include "boards/rs485.h"
+#include "boards/board_config.h"
+#include "boards/cpu_load.h"
+#include "boards/timebase.h"
+#include "board_ll.h"
+#include "stm32g4xx_ll_usart.h"
+
+/* DMA1 channel 1 belongs to the CRC unit */
+#define RS485_DMA DMA1
+#define RS485_RX_DMA_CHANNEL LL_DMA_CHANNEL_2
+#define RS485_RX_DMAMUX_CHANNEL DMAMUX1_Channel1
+#define RS485_TX_DMA_CHANNEL LL_DMA_CHANNEL_3
+#define RS485_TX_DMAMUX_CHANNEL DMAMUX1_Channel2
+#define RS485_DMA_MAX_LENGTH 0xFFFFU
+
+/* Driver enable lead and lag around the frame, in sample times: one bit at 16x oversampling */
+#define RS485_DE_TIME 16U
+
+#define RS485_LINE_ERRORS (USART_ISR_PE | USART_ISR_FE | USART_ISR_NE | USART_ISR_ORE)
+
+typedef struct {
+    board_rs485_rx_callback_t rx_callback;
+    board_rs485_tx_callback_t tx_callback;
+    void *context;
+    uint8_t *rx_buffer;
+    size_t rx_size;
+    volatile bool receiving;
+    volatile bool transmitting;
+} board_rs485_state_t;
+
+static board_rs485_state_t rs485_states[BOARD_RS485_COUNT];
+
+static const board_rs485_config_t board_rs485_configs[BOARD_RS485_COUNT] = {
+#if BOARD_HAS_RS485
+    /* USART3 on the morpho connector: PB10 TX (also Arduino D6), PB11 RX, PB14 DE */
+    [BOARD_RS485_1] = {.instance_index = BOARD_RS485_1, .port_index = 1, .tx_pin = 10, .rx_pin = 11, .de_pin = 14,
+                       .alternate = GPIO_AF7_USART3},
+#endif
+};
+
+static GPIO_TypeDef *get_gpio_port_from_index(int port_index)
+{
+    switch (port_index) {
+        case 0: return GPIOA;
+        case 1: return GPIOB;
+        case 2: return GPIOC;
+        case 3: return GPIOD;
+        default: return NULL;
+    }
+}
+
+static USART_TypeDef *get_usart_from_index(int instance_index)
+{
+    switch (instance_index) {
+        case BOARD_RS485_1: return USART3;
+        default: return NULL;
+    }
+}
+
+static void stop_dma(uint32_t channel)
+{
+    board_ll_dma_stop(RS485_DMA, channel);
+    board_ll_dma_clear(RS485_DMA, channel);
+}
+
+const board_rs485_config_t *board_rs485_get_config(board_rs485_id_t rs485_id)
+{
+    if (rs485_id < 0 || rs485_id >= BOARD_RS485_COUNT || !board_rs485_is_supported(rs485_id)) {
+        return NULL;
+    }
+
+    return &board_rs485_configs[rs485_id];
+}
+
+int board_rs485_is_supported(board_rs485_id_t rs485_id)
+{
+    switch (rs485_id) {
+#if BOARD_HAS_RS485
+        case BOARD_RS485_1: return 1;
+#endif
+        default: return 0;
+    }
+}
+
+bool board_rs485_init(const board_rs485_config_t *config, uint32_t baudrate, board_rs485_parity_t parity,
+                      uint32_t timeout_bits, uint8_t *rx_buffer, size_t rx_size, board_rs485_rx_callback_t rx_callback,
+                      board_rs485_tx_callback_t tx_callback, void *context)
+{
+    if (config == NULL || baudrate == 0U || timeout_bits == 0U || timeout_bits > USART_RTOR_RTO_Msk ||
+        rx_buffer == NULL || rx_size == 0U || rx_size > RS485_DMA_MAX_LENGTH) {
+        return false;
+    }
+
+    USART_TypeDef *usart = get_usart_from_index(config->instance_index);
+    GPIO_TypeDef *port = get_gpio_port_from_index(config->port_index);
+    if (usart == NULL || port == NULL) {
+        return false;
+    }
+
+    board_rs485_state_t *state = &rs485_states[config->instance_index];
+    state->rx_callback = rx_callback;
+    state->tx_callback = tx_callback;
+    state->context = context;
+    state->rx_buffer = rx_buffer;
+    state->rx_size = rx_size;
+    state->receiving = false;
+    state->transmitting = false;
+
+    board_timebase_init();
+    __HAL_RCC_USART3_CLK_ENABLE();
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Pin = (uint16_t)((1U << config->tx_pin) | (1U << config->rx_pin) | (1U << config->de_pin));
+    gpio.Mode = GPIO_MODE_AF_PP;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_LOW;
+    gpio.Alternate = config->alternate;
+    HAL_GPIO_Init(port, &gpio);
+
+    LL_USART_Disable(usart);
+    /* Kernel clock left at its reset source, PCLK1 */
+    LL_USART_SetBaudRate(usart, HAL_RCC_GetPCLK1Freq(), LL_USART_PRESCALER_DIV1, LL_USART_OVERSAMPLING_16, baudrate);
+    switch (parity) {
+        case BOARD_RS485_PARITY_EVEN:
+            LL_USART_ConfigCharacter(usart, LL_USART_DATAWIDTH_9B, LL_USART_PARITY_EVEN, LL_USART_STOPBITS_1);
+            break;
+        case BOARD_RS485_PARITY_ODD:
+            LL_USART_ConfigCharacter(usart, LL_USART_DATAWIDTH_9B, LL_USART_PARITY_ODD, LL_USART_STOPBITS_1);
+            break;
+        default:
+            LL_USART_ConfigCharacter(usart, LL_USART_DATAWIDTH_8B, LL_USART_PARITY_NONE, LL_USART_STOPBITS_2);
+            break;
+    }
+    LL_USART_SetTransferDirection(usart, LL_USART_DIRECTION_TX_RX);
+
+    /* The transceiver's driver enable follows the transmitter without software timing */
+    LL_USART_EnableDEMode(usart);
+    LL_USART_SetDESignalPolarity(usart, LL_USART_DE_POLARITY_HIGH);
+    LL_USART_SetDEAssertionTime(usart, RS485_DE_TIME);
+    LL_USART_SetDEDeassertionTime(usart, RS485_DE_TIME);
+
+    LL_USART_SetRxTimeout(usart, timeout_bits);
+    LL_USART_EnableRxTimeout(usart);
+    LL_USART_EnableDMAReq_RX(usart);
+    LL_USART_EnableDMAReq_TX(usart);
+    LL_USART_EnableIT_RTO(usart);
+    LL_USART_Enable(usart);
+
+    RS485_RX_DMAMUX_CHANNEL->CCR = DMA_REQUEST_USART3_RX;
+    RS485_TX_DMAMUX_CHANNEL->CCR = DMA_REQUEST_USART3_TX;
+
+    HAL_NVIC_SetPriority(USART3_IRQn, BOARD_IRQ_PRIORITY_RS485, 0U);
+    HAL_NVIC_EnableIRQ(USART3_IRQn);
+
+    board_rs485_receive(config);
+    return true;
+}
+
+void board_rs485_receive(const board_rs485_config_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    USART_TypeDef *usart = get_usart_from_index(config->instance_index);
+    board_rs485_state_t *state = &rs485_states[config->instance_index];
+    if (usart == NULL || state->rx_buffer == NULL) {
+        return;
+    }
+
+    /* Whatever arrived while reception was stopped belongs to no frame */
+    stop_dma(RS485_RX_DMA_CHANNEL);
+    LL_USART_RequestRxDataFlush(usart);
+    usart->ICR = USART_ICR_PECF | USART_ICR_FECF | USART_ICR_NECF | USART_ICR_ORECF | USART_ICR_RTOCF;
+
+    board_ll_dma_configure(RS485_DMA, RS485_RX_DMA_CHANNEL, (uint32_t)(uintptr_t)&usart->RDR,
+                           (uint32_t)(uintptr_t)state->rx_buffer,
+                           LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_MEMORY_INCREMENT);
+    state->receiving = true;
+    board_ll_dma_start(RS485_DMA, RS485_RX_DMA_CHANNEL, (uint32_t)state->rx_size);
+}
+
+bool board_rs485_transmit(const board_rs485_config_t *config, const uint8_t *data, size_t length)
+{
+    if (config == NULL || data == NULL || length == 0U || length > RS485_DMA_MAX_LENGTH) {
+        return false;
+    }
+
+    USART_TypeDef *usart = get_usart_from_index(config->instance_index);
+    board_rs485_state_t *state = &rs485_states[config->instance_index];
+    if (usart == NULL || state->transmitting) {
+        return false;
+    }
+
+    state->transmitting = true;
+    stop_dma(RS485_TX_DMA_CHANNEL);
+    board_ll_dma_configure(RS485_DMA, RS485_TX_DMA_CHANNEL, (uint32_t)(uintptr_t)&usart->TDR, (uint32_t)(uintptr_t)data,
+                           LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_MEMORY_INCREMENT);
+
+    /* Transmission complete, not DMA complete: the last byte must have left the shift register */
+    LL_USART_ClearFlag_TC(usart);
+    LL_USART_EnableIT_TC(usart);
+    board_ll_dma_start(RS485_DMA, RS485_TX_DMA_CHANNEL, (uint32_t)length);
+    return true;
+}
+
+static void rs485_irq_handler(int instance_index)
+{
+    USART_TypeDef *usart = get_usart_from_index(instance_index);
+    board_rs485_state_t *state = &rs485_states[instance_index];
+    uint32_t isr = usart->ISR;
+
+    if ((isr & USART_ISR_RTOF) != 0U) {
+        uint32_t timestamp = board_timebase_now();
+        LL_USART_ClearFlag_RTO(usart);
+
+        /* Bytes while reception is stopped, e.g. the echo of our own reply, are not a frame */
+        if (state->receiving) {
+            size_t length = state->rx_size - board_ll_dma_remaining(RS485_DMA, RS485_RX_DMA_CHANNEL);
+            stop_dma(RS485_RX_DMA_CHANNEL);
+            state->receiving = false;
+            if (length > 0U && state->rx_callback != NULL) {
+                state->rx_callback(length, (isr & RS485_LINE_ERRORS) != 0U, timestamp, state->context);
+            }
+        }
+    }
+
+    if (LL_USART_IsEnabledIT_TC(usart) && (isr & USART_ISR_TC) != 0U) {
+        LL_USART_DisableIT_TC(usart);
+        LL_USART_ClearFlag_TC(usart);
+        stop_dma(RS485_TX_DMA_CHANNEL);
+        state->transmitting = false;
+        if (state->tx_callback != NULL) {
+            state->tx_callback(state->context);
+        }
+    }
+}
+
+#if BOARD_HAS_RS485
+void USART3_IRQHandler(void)
+{
+#if BOARD_CPU_LOAD_ENABLE
+    const uint32_t preempted = board_cpu_load_enter(BOARD_CPU_LOAD_RS485);
+#endif
+    rs485_irq_handler(BOARD_RS485_1);
+#if BOARD_CPU_LOAD_ENABLE
+    board_cpu_load_exit(preempted);
+#endif
+}
+#endif
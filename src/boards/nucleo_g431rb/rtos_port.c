@@ -0,0 +1,168 @@
+#include "boards/rtos_port.h"
+#include "boards/board_config.h"
+#include "boards/cpu_load.h"
+#include "main.h"
+#include "service_config.h"
+#include "stm32g4xx.h"
+
+#if SERVICE_RTOS_ENABLE
+
+/* r4-r11 and EXC_RETURN saved by PendSV, below the frame stacked by the exception entry */
+#define RTOS_SOFTWARE_FRAME_WORDS 9U
+#define RTOS_HARDWARE_FRAME_WORDS 8U
+#define RTOS_FRAME_WORDS (RTOS_SOFTWARE_FRAME_WORDS + RTOS_HARDWARE_FRAME_WORDS)
+
+/* Return to thread mode on the process stack, basic frame */
+#define RTOS_EXC_RETURN_THREAD 0xFFFFFFFDU
+#define RTOS_XPSR_THUMB 0x01000000U
+
+/* Room for main's registers, FPU included, saved by the first switch and never restored */
+#define RTOS_START_STACK_WORDS 32U
+
+board_rtos_thread_t *volatile board_rtos_current;
+board_rtos_thread_t *volatile board_rtos_next;
+volatile uint32_t board_rtos_switched_at;
+
+static void (*rtos_tick)(void);
+
+bool board_rtos_thread_init(board_rtos_thread_t *thread, void *stack, size_t stack_size, void (*entry)(void *),
+                            void *argument, void (*exit)(void))
+{
+    if (thread == NULL || stack == NULL || entry == NULL || stack_size < 2U * RTOS_FRAME_WORDS * sizeof(uint32_t)) {
+        return false;
+    }
+
+    /* AAPCS: 8-byte aligned stack at every public interface */
+    uint32_t *frame = (uint32_t *)(((uintptr_t)stack + stack_size) & ~(uintptr_t)7U) - RTOS_FRAME_WORDS;
+    for (uint32_t i = 0U; i < RTOS_SOFTWARE_FRAME_WORDS - 1U; i++) {
+        frame[i] = 0U; /* r4-r11 */
+    }
+    frame[8] = RTOS_EXC_RETURN_THREAD;
+    frame[9] = (uint32_t)(uintptr_t)argument; /* r0 */
+    frame[10] = 0U;                           /* r1 */
+    frame[11] = 0U;                           /* r2 */
+    frame[12] = 0U;                           /* r3 */
+    frame[13] = 0U;                           /* r12 */
+    frame[14] = (uint32_t)(uintptr_t)exit;    /* lr */
+    frame[15] = (uint32_t)(uintptr_t)entry & ~1U;
+    frame[16] = RTOS_XPSR_THUMB;
+
+    thread->context = frame;
+    return true;
+}
+
+void board_rtos_start(board_rtos_thread_t *first, uint32_t tick_frequency, void (*tick)(void))
+{
+    static uint32_t start_stack[RTOS_START_STACK_WORDS];
+    static board_rtos_thread_t start_thread;
+
+    __disable_irq();
+    rtos_tick = tick;
+
+    /* Lazy stacking: threads that never touch the FPU switch without saving it */
+    FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+
+    /* Switch and tick below every peripheral interrupt */
+    NVIC_SetPriority(PendSV_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+    SysTick_Config(SystemCoreClock / tick_frequency);
+
+    __set_PSP((uint32_t)(uintptr_t)&start_stack[RTOS_START_STACK_WORDS]);
+    board_rtos_current = &start_thread;
+    board_rtos_next = first;
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+
+    __DSB();
+    __enable_irq();
+    __ISB();
+
+    for (;;) {
+    }
+}
+
+void board_rtos_switch(void)
+{
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+uint32_t board_rtos_lock(void)
+{
+    const uint32_t state = __get_PRIMASK();
+    __disable_irq();
+    return state;
+}
+
+void board_rtos_unlock(uint32_t state)
+{
+    __set_PRIMASK(state);
+}
+
+bool board_rtos_in_isr(void)
+{
+    return __get_IPSR() != 0U;
+}
+
+void board_rtos_idle(void)
+{
+    __DSB();
+    __WFI();
+}
+
+/*
+ * Save r4-r11 and EXC_RETURN on the outgoing thread's stack, and s16-s31
+ * only if EXC_RETURN says the thread has an FPU frame; s0-s15 are left to
+ * lazy stacking. A higher interrupt changing board_rtos_next meanwhile pends
+ * this handler again, so no masking is needed.
+ */
+__attribute__((naked)) void PendSV_Handler(void)
+{
+    __asm volatile(
+        "    mrs      r0, psp\n"
+        "    tst      lr, #0x10\n"
+        "    it       eq\n"
+        "    vstmdbeq r0!, {s16-s31}\n"
+        "    stmdb    r0!, {r4-r11, lr}\n"
+        "    ldr      r1, =board_rtos_current\n"
+        "    ldr      r2, [r1]\n"
+        "    str      r0, [r2]\n"
+        "    ldr      r2, =board_rtos_next\n"
+        "    ldr      r2, [r2]\n"
+        "    str      r2, [r1]\n"
+        "    ldr      r0, [r2]\n"
+        "    ldr      r1, =0xE0001004\n" /* DWT->CYCCNT, the board timebase */
+        "    ldr      r1, [r1]\n"
+        "    ldr      r2, =board_rtos_switched_at\n"
+        "    str      r1, [r2]\n"
+        "    ldmia    r0!, {r4-r11, lr}\n"
+        "    tst      lr, #0x10\n"
+        "    it       eq\n"
+        "    vldmiaeq r0!, {s16-s31}\n"
+        "    msr      psp, r0\n"
+        "    bx       lr\n"
+        "    .ltorg\n");
+}
+
+void SysTick_Handler(void)
+{
+#if BOARD_CPU_LOAD_ENABLE
+    const uint32_t preempted = board_cpu_load_enter(BOARD_CPU_LOAD_RTOS_TICK);
+#endif
+    if (rtos_tick != NULL) {
+        rtos_tick();
+    }
+#if BOARD_CPU_LOAD_ENABLE
+    board_cpu_load_exit(preempted);
+#endif
+}
+
+#else
+
+/* Without the kernel: the empty handlers CubeMX no longer generates; the HAL tick runs on TIM3 */
+void PendSV_Handler(void)
+{
+}
+
+void SysTick_Handler(void)
+{
+}
+
+#endif
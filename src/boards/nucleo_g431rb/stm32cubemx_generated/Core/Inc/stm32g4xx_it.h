@@ -53,8 +53,6 @@ void BusFault_Handler(void);
 void UsageFault_Handler(void);
 void SVC_Handler(void);
 void DebugMon_Handler(void);
-void PendSV_Handler(void);
-void SysTick_Handler(void);
 void TIM3_IRQHandler(void);
 /* USER CODE BEGIN EFP */
 
@@ -0,0 +1,25 @@
+#include "boards/timebase.h"
+#include "main.h"
+#include "stm32g4xx.h"
+
+/* DWT cycle counter: one tick per core clock, wraps every 25 s at 170 MHz */
+void board_timebase_init(void)
+{
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0U) {
+        return;
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t board_timebase_now(void)
+{
+    return DWT->CYCCNT;
+}
+
+uint32_t board_timebase_frequency(void)
+{
+    return SystemCoreClock;
+}
@@ -0,0 +1,196 @@
+#include "boards/uart.h"
+#include "boards/board_config.h"
+#include "boards/cpu_load.h"
+#include "main.h"
+#include "stm32g4xx.h"
+#include "stm32g4xx_ll_usart.h"
+
+typedef struct {
+    board_uart_tx_callback_t tx_callback;
+    board_uart_rx_callback_t rx_callback;
+    void *context;
+} board_uart_state_t;
+
+static board_uart_state_t uart_states[BOARD_UART_COUNT];
+
+static const board_uart_config_t board_uart_configs[BOARD_UART_COUNT] = {
+#if BOARD_HAS_UART1
+    /* Arduino D1/D0 */
+    [BOARD_UART_1] = {.instance_index = BOARD_UART_1, .port_index = 2, .tx_pin = 4, .rx_pin = 5,
+                      .alternate = GPIO_AF7_USART1},
+#endif
+#if BOARD_HAS_UART2
+    /* ST-LINK virtual COM port */
+    [BOARD_UART_2] = {.instance_index = BOARD_UART_2, .port_index = 0, .tx_pin = 2, .rx_pin = 3,
+                      .alternate = GPIO_AF7_USART2},
+#endif
+};
+
+static GPIO_TypeDef *get_gpio_port_from_index(int port_index)
+{
+    switch (port_index) {
+        case 0: return GPIOA;
+        case 1: return GPIOB;
+        case 2: return GPIOC;
+        case 3: return GPIOD;
+        default: return NULL;
+    }
+}
+
+static USART_TypeDef *get_usart_from_index(int instance_index)
+{
+    switch (instance_index) {
+        case BOARD_UART_1: return USART1;
+        case BOARD_UART_2: return USART2;
+        default: return NULL;
+    }
+}
+
+static void enable_clocks(int instance_index)
+{
+    switch (instance_index) {
+        case BOARD_UART_1: __HAL_RCC_USART1_CLK_ENABLE(); break;
+        case BOARD_UART_2: __HAL_RCC_USART2_CLK_ENABLE(); break;
+        default: break;
+    }
+}
+
+static uint32_t get_kernel_clock(int instance_index)
+{
+    /* Kernel clock left at its reset source: PCLK2 for USART1, PCLK1 otherwise */
+    return (instance_index == BOARD_UART_1) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+}
+
+static IRQn_Type get_irqn(int instance_index)
+{
+    return (instance_index == BOARD_UART_1) ? USART1_IRQn : USART2_IRQn;
+}
+
+const board_uart_config_t *board_uart_get_config(board_uart_id_t uart_id)
+{
+    if (uart_id < 0 || uart_id >= BOARD_UART_COUNT || !board_uart_is_supported(uart_id)) {
+        return NULL;
+    }
+
+    return &board_uart_configs[uart_id];
+}
+
+int board_uart_is_supported(board_uart_id_t uart_id)
+{
+    switch (uart_id) {
+#if BOARD_HAS_UART1
+        case BOARD_UART_1: return 1;
+#endif
+#if BOARD_HAS_UART2
+        case BOARD_UART_2: return 1;
+#endif
+        default: return 0;
+    }
+}
+
+bool board_uart_init(const board_uart_config_t *config, uint32_t baudrate, board_uart_tx_callback_t tx_callback,
+                     board_uart_rx_callback_t rx_callback, void *context)
+{
+    if (config == NULL || baudrate == 0U) {
+        return false;
+    }
+
+    USART_TypeDef *usart = get_usart_from_index(config->instance_index);
+    GPIO_TypeDef *port = get_gpio_port_from_index(config->port_index);
+    if (usart == NULL || port == NULL) {
+        return false;
+    }
+
+    uart_states[config->instance_index].tx_callback = tx_callback;
+    uart_states[config->instance_index].rx_callback = rx_callback;
+    uart_states[config->instance_index].context = context;
+
+    enable_clocks(config->instance_index);
+
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Pin = (uint16_t)((1U << config->tx_pin) | (1U << config->rx_pin));
+    gpio.Mode = GPIO_MODE_AF_PP;
+    gpio.Pull = GPIO_PULLUP;
+    gpio.Speed = GPIO_SPEED_FREQ_LOW;
+    gpio.Alternate = config->alternate;
+    HAL_GPIO_Init(port, &gpio);
+
+    LL_USART_Disable(usart);
+    LL_USART_SetBaudRate(usart, get_kernel_clock(config->instance_index), LL_USART_PRESCALER_DIV1,
+                         LL_USART_OVERSAMPLING_16, baudrate);
+    LL_USART_SetTransferDirection(usart, LL_USART_DIRECTION_TX_RX);
+    LL_USART_Enable(usart);
+    if (rx_callback != NULL) {
+        LL_USART_EnableIT_RXNE_RXFNE(usart);
+    }
+
+    IRQn_Type irqn = get_irqn(config->instance_index);
+    HAL_NVIC_SetPriority(irqn, BOARD_IRQ_PRIORITY_UART, 0U);
+    HAL_NVIC_EnableIRQ(irqn);
+
+    return true;
+}
+
+void board_uart_start_tx(const board_uart_config_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    USART_TypeDef *usart = get_usart_from_index(config->instance_index);
+    if (usart != NULL) {
+        LL_USART_EnableIT_TXE_TXFNF(usart);
+    }
+}
+
+static void uart_irq_handler(int instance_index)
+{
+    USART_TypeDef *usart = get_usart_from_index(instance_index);
+    board_uart_state_t *state = &uart_states[instance_index];
+
+    /* An overrun also raises this interrupt and stops reception until cleared; the lost byte is gone */
+    if (LL_USART_IsActiveFlag_ORE(usart)) {
+        LL_USART_ClearFlag_ORE(usart);
+    }
+    if (LL_USART_IsActiveFlag_RXNE_RXFNE(usart)) {
+        uint8_t byte = LL_USART_ReceiveData8(usart);
+        if (state->rx_callback != NULL) {
+            state->rx_callback(byte, state->context);
+        }
+    }
+
+    if (LL_USART_IsEnabledIT_TXE_TXFNF(usart) && LL_USART_IsActiveFlag_TXE_TXFNF(usart)) {
+        int next = (state->tx_callback != NULL) ? state->tx_callback(state->context) : -1;
+        if (next < 0) {
+            LL_USART_DisableIT_TXE_TXFNF(usart);
+        } else {
+            LL_USART_TransmitData8(usart, (uint8_t)next);
+        }
+    }
+}
+
+#if BOARD_HAS_UART1
+void USART1_IRQHandler(void)
+{
+#if BOARD_CPU_LOAD_ENABLE
+    const uint32_t preempted = board_cpu_load_enter(BOARD_CPU_LOAD_UART1);
+#endif
+    uart_irq_handler(BOARD_UART_1);
+#if BOARD_CPU_LOAD_ENABLE
+    board_cpu_load_exit(preempted);
+#endif
+}
+#endif
+
+#if BOARD_HAS_UART2
+void USART2_IRQHandler(void)
+{
+#if BOARD_CPU_LOAD_ENABLE
+    const uint32_t preempted = board_cpu_load_enter(BOARD_CPU_LOAD_UART2);
+#endif
+    uart_irq_handler(BOARD_UART_2);
+#if BOARD_CPU_LOAD_ENABLE
+    board_cpu_load_exit(preempted);
+#endif
+}
+#endif
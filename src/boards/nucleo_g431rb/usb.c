@@ -0,0 +1,577 @@
+#include "boards/usb.h"
+#include "boards/board_config.h"
+#include "boards/cpu_load.h"
+#include "main.h"
+#include "stm32g4xx.h"
+
+/* Packet memory: the buffer descriptor table at its start, then endpoint buffers allocated upwards */
+#define USB_PMA_SIZE 1024U
+#define USB_BTABLE_OFFSET 0U
+#define USB_PMA_FIRST_BUFFER (USB_BTABLE_OFFSET + BOARD_USB_MAX_ENDPOINTS * 8U)
+
+/* Reception byte count words: size of the buffer in 2 or 32 byte blocks, and the received count */
+#define USB_COUNT_RX_BLSIZE 0x8000U
+#define USB_COUNT_RX_NUM_BLOCK_POS 10U
+#define USB_COUNT_RX_COUNT 0x03FFU
+
+#define USB_EP_REGISTER(number) (*(&USB->EP0R + 2U * (number)))
+#define USB_PMA_WORD(offset) (*(volatile uint16_t *)(USB_PMAADDR + (offset)))
+
+/*
+ * Descriptor words of an endpoint. A double buffered endpoint uses both
+ * pairs for its one direction: the transmit pair for buffer 0 and the
+ * receive pair for buffer 1.
+ */
+#define USB_BD_ADDR(number, buffer) USB_PMA_WORD(USB_BTABLE_OFFSET + 8U * (number) + 4U * (buffer))
+#define USB_BD_COUNT(number, buffer) USB_PMA_WORD(USB_BTABLE_OFFSET + 8U * (number) + 4U * (buffer) + 2U)
+
+typedef struct {
+    uint16_t max_packet;
+    uint16_t buffer; /* packet memory offset of the first buffer */
+    board_usb_ep_type_t type;
+    bool open;
+    bool double_buffered;
+    /*
+     * Packets written and not yet sent (IN), or received and not yet read
+     * (OUT), and the buffer the next one is written to or read from. The
+     * hardware works on the oldest one, the buffer its data toggle selects.
+     */
+    uint8_t queued;
+    uint8_t next;
+} board_usb_ep_state_t;
+
+static const board_usb_callbacks_t *usb_callbacks;
+static void *usb_context;
+static uint16_t pma_next;
+
+/* Indexed [number][direction], OUT first */
+static board_usb_ep_state_t ep_states[BOARD_USB_MAX_ENDPOINTS][2];
+static volatile bool ep_service[BOARD_USB_MAX_ENDPOINTS][2];
+
+static board_usb_ep_state_t *get_ep_state(uint8_t address)
+{
+    uint8_t number = BOARD_USB_EP_NUMBER(address);
+    if (number >= BOARD_USB_MAX_ENDPOINTS) {
+        return NULL;
+    }
+
+    return &ep_states[number][BOARD_USB_EP_IS_IN(address) ? 1 : 0];
+}
+
+/*
+ * EPnR fields are mixed: CTR bits clear on 0, DTOG and STAT bits toggle on
+ * 1, the rest is plain. Each write keeps the plain fields, writes 1 to the
+ * CTR bits it leaves alone and 1 only to the toggle bits it changes.
+ */
+static void set_tx_status(uint8_t number, uint16_t status)
+{
+    uint16_t reg = USB_EP_REGISTER(number) & USB_EPTX_DTOGMASK;
+    USB_EP_REGISTER(number) = (uint16_t)((reg ^ status) | USB_EP_CTR_RX | USB_EP_CTR_TX);
+}
+
+static void set_rx_status(uint8_t number, uint16_t status)
+{
+    uint16_t reg = USB_EP_REGISTER(number) & USB_EPRX_DTOGMASK;
+    USB_EP_REGISTER(number) = (uint16_t)((reg ^ status) | USB_EP_CTR_RX | USB_EP_CTR_TX);
+}
+
+static void toggle_bits(uint8_t number, uint16_t toggles)
+{
+    uint16_t reg = USB_EP_REGISTER(number) & USB_EPREG_MASK;
+    USB_EP_REGISTER(number) = (uint16_t)(reg | USB_EP_CTR_RX | USB_EP_CTR_TX | toggles);
+}
+
+static void clear_ctr(uint8_t number, uint16_t ctr)
+{
+    uint16_t reg = USB_EP_REGISTER(number) & USB_EPREG_MASK;
+    USB_EP_REGISTER(number) = (uint16_t)((reg | USB_EP_CTR_RX | USB_EP_CTR_TX) & ~ctr);
+}
+
+static uint16_t rx_count_field(uint16_t size)
+{
+    if (size > 62U) {
+        return (uint16_t)(USB_COUNT_RX_BLSIZE | ((((size + 31U) / 32U) - 1U) << USB_COUNT_RX_NUM_BLOCK_POS));
+    }
+    return (uint16_t)(((size + 1U) / 2U) << USB_COUNT_RX_NUM_BLOCK_POS);
+}
+
+/* Packet memory takes 16-bit accesses; the blocks may split a halfword */
+static void pma_write(uint16_t offset, const uint8_t *data, size_t length, const uint8_t *data2, size_t length2)
+{
+    volatile uint16_t *pma = &USB_PMA_WORD(offset);
+    uint16_t carry = 0U;
+    bool odd = false;
+
+    for (int block = 0; block < 2; block++) {
+        const uint8_t *src = (block == 0) ? data : data2;
+        size_t left = (block == 0) ? length : length2;
+
+        if (odd && left > 0U) {
+            *pma++ = (uint16_t)(carry | ((uint16_t)*src++ << 8));
+            left--;
+            odd = false;
+        }
+        for (; left >= 2U; left -= 2U, src += 2) {
+            *pma++ = (uint16_t)(src[0] | ((uint16_t)src[1] << 8));
+        }
+        if (left > 0U) {
+            carry = *src;
+            odd = true;
+        }
+    }
+
+    if (odd) {
+        *pma = carry;
+    }
+}
+
+static void pma_read(uint16_t offset, uint8_t *data, size_t length, uint8_t *data2, size_t length2)
+{
+    volatile uint16_t *pma = &USB_PMA_WORD(offset);
+    uint16_t word = 0U;
+    bool odd = false;
+
+    for (int block = 0; block < 2; block++) {
+        uint8_t *dst = (block == 0) ? data : data2;
+        size_t left = (block == 0) ? length : length2;
+
+        if (odd && left > 0U) {
+            *dst++ = (uint8_t)(word >> 8);
+            left--;
+            odd = false;
+        }
+        for (; left >= 2U; left -= 2U, dst += 2) {
+            word = *pma++;
+            dst[0] = (uint8_t)word;
+            dst[1] = (uint8_t)(word >> 8);
+        }
+        if (left > 0U) {
+            word = *pma++;
+            *dst = (uint8_t)word;
+            odd = true;
+        }
+    }
+}
+
+/*
+ * Double buffering. The hardware uses the buffer its DTOG bit selects and
+ * NAKs while that is the buffer SW_BUF (the other direction's DTOG bit)
+ * gives to software. Only the oldest queued buffer is ever released, so the
+ * hardware completes at most one packet between two calls, which shows as
+ * DTOG no longer pointing at it; SW_BUF is then set again for the new state.
+ */
+static void update_double_buffer(uint8_t number, bool is_in)
+{
+    board_usb_ep_state_t *state = &ep_states[number][is_in ? 1 : 0];
+    uint16_t dtog_bit = is_in ? USB_EP_DTOG_TX : USB_EP_DTOG_RX;
+    uint16_t sw_buf_bit = is_in ? USB_EP_DTOG_RX : USB_EP_DTOG_TX;
+
+    /* Where DTOG is expected: the oldest packet to send, or the next free buffer to receive into */
+    uint8_t expected = (uint8_t)((state->next ^ state->queued) & 1U);
+    uint8_t dtog = ((USB_EP_REGISTER(number) & dtog_bit) != 0U) ? 1U : 0U;
+    if (is_in && state->queued > 0U && dtog != expected) {
+        state->queued--;
+    }
+    if (!is_in && state->queued < 2U && dtog != expected) {
+        state->queued++;
+    }
+
+    /*
+     * IN: send the oldest packet if there is one. OUT: receive while a buffer
+     * is free. From the same DTOG reading: a packet completing meanwhile
+     * moves DTOG onto SW_BUF, and the hardware waits for the next call.
+     */
+    bool release = is_in ? (state->queued > 0U) : (state->queued < 2U);
+    uint8_t sw_buf = release ? (uint8_t)(dtog ^ 1U) : dtog;
+    if ((((USB_EP_REGISTER(number) & sw_buf_bit) != 0U) ? 1U : 0U) != sw_buf) {
+        toggle_bits(number, sw_buf_bit);
+    }
+
+    /* Valid stays set between packets, except after the first one following the toggle reset */
+    if (release) {
+        if (is_in && (USB_EP_REGISTER(number) & USB_EPTX_STAT) == USB_EP_TX_NAK) {
+            set_tx_status(number, USB_EP_TX_VALID);
+        }
+        if (!is_in && (USB_EP_REGISTER(number) & USB_EPRX_STAT) == USB_EP_RX_NAK) {
+            set_rx_status(number, USB_EP_RX_VALID);
+        }
+    }
+}
+
+/* Descriptors, type, data toggles and status of an endpoint from its state; nothing queued */
+static void configure_endpoint(uint8_t address)
+{
+    uint8_t number = BOARD_USB_EP_NUMBER(address);
+    bool is_in = BOARD_USB_EP_IS_IN(address);
+    board_usb_ep_state_t *state = get_ep_state(address);
+    uint16_t size = (uint16_t)((state->max_packet + 1U) & ~1U);
+
+    if (state->double_buffered) {
+        for (uint16_t buffer = 0U; buffer < 2U; buffer++) {
+            USB_BD_ADDR(number, buffer) = (uint16_t)(state->buffer + buffer * size);
+            USB_BD_COUNT(number, buffer) = is_in ? 0U : rx_count_field(size);
+        }
+    } else if (is_in) {
+        USB_BD_ADDR(number, 0U) = state->buffer;
+        USB_BD_COUNT(number, 0U) = 0U;
+    } else {
+        USB_BD_ADDR(number, 1U) = state->buffer;
+        USB_BD_COUNT(number, 1U) = rx_count_field(size);
+    }
+    state->queued = 0U;
+    state->next = 0U;
+    ep_service[number][is_in ? 1 : 0] = false;
+
+    uint16_t type_bits = USB_EP_BULK;
+    switch (state->type) {
+        case BOARD_USB_EP_CONTROL: type_bits = USB_EP_CONTROL; break;
+        case BOARD_USB_EP_INTERRUPT: type_bits = USB_EP_INTERRUPT; break;
+        default: break;
+    }
+
+    /* Plain fields only: writing zeros leaves the toggle bits alone and clears stale CTR flags */
+    USB_EP_REGISTER(number) = (uint16_t)(type_bits | (state->double_buffered ? USB_EP_KIND : 0U) | number);
+
+    /* Back to DATA0; a double buffered endpoint also resets SW_BUF, the other direction's toggle */
+    uint16_t toggles = state->double_buffered ? (USB_EP_DTOG_TX | USB_EP_DTOG_RX)
+                                              : (is_in ? USB_EP_DTOG_TX : USB_EP_DTOG_RX);
+    toggles &= USB_EP_REGISTER(number);
+    if (toggles != 0U) {
+        toggle_bits(number, toggles);
+    }
+
+    if (is_in) {
+        set_tx_status(number, USB_EP_TX_NAK);
+    } else {
+        if (state->double_buffered) {
+            update_double_buffer(number, false);
+        }
+        set_rx_status(number, USB_EP_RX_VALID);
+    }
+}
+
+static void open_control_endpoint(void)
+{
+    (void)board_usb_ep_open(0x00U, BOARD_USB_EP_CONTROL, 64U, false);
+    (void)board_usb_ep_open(0x80U, BOARD_USB_EP_CONTROL, 64U, false);
+}
+
+static void handle_reset(void)
+{
+    for (uint8_t number = 0U; number < BOARD_USB_MAX_ENDPOINTS; number++) {
+        USB_EP_REGISTER(number) = 0U;
+        ep_states[number][0] = (board_usb_ep_state_t){0};
+        ep_states[number][1] = (board_usb_ep_state_t){0};
+    }
+    pma_next = USB_PMA_FIRST_BUFFER;
+    USB->DADDR = USB_DADDR_EF;
+
+    open_control_endpoint();
+    if (usb_callbacks->reset != NULL) {
+        usb_callbacks->reset(usb_context);
+    }
+}
+
+static void handle_transfer(uint8_t number)
+{
+    uint16_t reg = USB_EP_REGISTER(number);
+
+    if ((reg & USB_EP_CTR_RX) != 0U) {
+        clear_ctr(number, USB_EP_CTR_RX);
+        board_usb_ep_state_t *state = &ep_states[number][0];
+
+        if ((reg & USB_EP_SETUP) != 0U) {
+            uint8_t packet[BOARD_USB_SETUP_SIZE];
+            pma_read(USB_BD_ADDR(number, 1U), packet, sizeof(packet), NULL, 0U);
+            state->queued = 0U;
+            ep_states[number][1].queued = 0U;
+            /* A SETUP ends any stall and the previous transfer */
+            set_tx_status(number, USB_EP_TX_NAK);
+            set_rx_status(number, USB_EP_RX_VALID);
+            if (usb_callbacks->setup != NULL) {
+                usb_callbacks->setup(packet, usb_context);
+            }
+        } else {
+            if (state->double_buffered) {
+                update_double_buffer(number, false);
+            } else {
+                state->queued = 1U;
+            }
+            if (usb_callbacks->out != NULL) {
+                usb_callbacks->out(number, usb_context);
+            }
+        }
+    }
+
+    if ((reg & USB_EP_CTR_TX) != 0U) {
+        clear_ctr(number, USB_EP_CTR_TX);
+        board_usb_ep_state_t *state = &ep_states[number][1];
+
+        if (state->double_buffered) {
+            update_double_buffer(number, true);
+        } else {
+            state->queued = 0U;
+        }
+        if (usb_callbacks->in != NULL) {
+            usb_callbacks->in((uint8_t)(BOARD_USB_EP_IN | number), usb_context);
+        }
+    }
+}
+
+int board_usb_is_supported(void)
+{
+#if BOARD_HAS_USB
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+bool board_usb_init(const board_usb_callbacks_t *callbacks, void *context)
+{
+    if (callbacks == NULL || !board_usb_is_supported()) {
+        return false;
+    }
+
+    usb_callbacks = callbacks;
+    usb_context = context;
+
+    /*
+     * The USB kernel clock is HSI48 (CLK48SEL reset value), trimmed to the
+     * host's start-of-frame packets by the CRS, whose reset configuration
+     * already synchronises on USB SOF
+     */
+    RCC->CRRCR |= RCC_CRRCR_HSI48ON;
+    while ((RCC->CRRCR & RCC_CRRCR_HSI48RDY) == 0U) {
+    }
+    __HAL_RCC_CRS_CLK_ENABLE();
+    CRS->CR |= CRS_CR_AUTOTRIMEN | CRS_CR_CEN;
+    __HAL_RCC_USB_CLK_ENABLE();
+
+    /* Power up and hold the reset for the transceiver startup time */
+    USB->CNTR = USB_CNTR_FRES;
+    HAL_Delay(1U);
+    USB->CNTR = 0U;
+    USB->ISTR = 0U;
+    USB->BTABLE = USB_BTABLE_OFFSET;
+    USB->CNTR = USB_CNTR_CTRM | USB_CNTR_RESETM | USB_CNTR_SUSPM | USB_CNTR_WKUPM;
+
+    HAL_NVIC_SetPriority(USB_LP_IRQn, BOARD_IRQ_PRIORITY_USB, 0U);
+    HAL_NVIC_EnableIRQ(USB_LP_IRQn);
+
+    /* Internal D+ pull-up: the host sees a full-speed device and resets it */
+    USB->BCDR |= USB_BCDR_DPPU;
+
+    return true;
+}
+
+uint32_t board_usb_get_unique_id(void)
+{
+    /* The 96-bit device ID folded: wafer position, wafer and lot */
+    const volatile uint32_t *uid = (const volatile uint32_t *)UID_BASE;
+    return uid[0] ^ uid[1] ^ uid[2];
+}
+
+void board_usb_set_address(uint8_t address)
+{
+    USB->DADDR = (uint16_t)(USB_DADDR_EF | (address & USB_DADDR_ADD));
+}
+
+bool board_usb_ep_open(uint8_t address, board_usb_ep_type_t type, uint16_t max_packet, bool double_buffered)
+{
+    board_usb_ep_state_t *state = get_ep_state(address);
+    uint16_t size = (uint16_t)((max_packet + 1U) & ~1U);
+    uint16_t buffers = double_buffered ? 2U : 1U;
+
+    if (state == NULL || max_packet == 0U || max_packet > 64U || (double_buffered && type != BOARD_USB_EP_BULK) ||
+        (uint32_t)pma_next + (uint32_t)buffers * size > USB_PMA_SIZE) {
+        return false;
+    }
+
+    *state = (board_usb_ep_state_t){
+        .max_packet = max_packet,
+        .buffer = pma_next,
+        .type = type,
+        .open = true,
+        .double_buffered = double_buffered,
+    };
+    pma_next = (uint16_t)(pma_next + buffers * size);
+
+    configure_endpoint(address);
+    return true;
+}
+
+bool board_usb_ep_write(uint8_t address, const uint8_t *data, size_t length, const uint8_t *data2, size_t length2)
+{
+    board_usb_ep_state_t *state = get_ep_state(address);
+    uint8_t number = BOARD_USB_EP_NUMBER(address);
+
+    if (state == NULL || !state->open || !BOARD_USB_EP_IS_IN(address) || length + length2 > state->max_packet) {
+        return false;
+    }
+
+    if (state->double_buffered) {
+        if (state->queued >= 2U) {
+            return false;
+        }
+        pma_write(USB_BD_ADDR(number, state->next), data, length, data2, length2);
+        USB_BD_COUNT(number, state->next) = (uint16_t)(length + length2);
+        state->next ^= 1U;
+        state->queued++;
+        update_double_buffer(number, true);
+        return true;
+    }
+
+    if (state->queued != 0U) {
+        return false;
+    }
+    pma_write(USB_BD_ADDR(number, 0U), data, length, data2, length2);
+    USB_BD_COUNT(number, 0U) = (uint16_t)(length + length2);
+    state->queued = 1U;
+    set_tx_status(number, USB_EP_TX_VALID);
+    return true;
+}
+
+int board_usb_ep_rx_length(uint8_t address)
+{
+    board_usb_ep_state_t *state = get_ep_state(address);
+    uint8_t number = BOARD_USB_EP_NUMBER(address);
+
+    if (state == NULL || !state->open || BOARD_USB_EP_IS_IN(address)) {
+        return -1;
+    }
+    if (state->double_buffered) {
+        update_double_buffer(number, false);
+    }
+    if (state->queued == 0U) {
+        return -1;
+    }
+
+    uint16_t pair = state->double_buffered ? state->next : 1U;
+    return (int)(USB_BD_COUNT(number, pair) & USB_COUNT_RX_COUNT);
+}
+
+void board_usb_ep_read(uint8_t address, uint8_t *data, size_t length, uint8_t *data2, size_t length2)
+{
+    int received = board_usb_ep_rx_length(address);
+    board_usb_ep_state_t *state = get_ep_state(address);
+    uint8_t number = BOARD_USB_EP_NUMBER(address);
+
+    if (received < 0 || length + length2 < (size_t)received) {
+        return;
+    }
+    if (length > (size_t)received) {
+        length = (size_t)received;
+    }
+    length2 = (size_t)received - length;
+
+    uint16_t pair = state->double_buffered ? state->next : 1U;
+    pma_read(USB_BD_ADDR(number, pair), data, length, data2, length2);
+
+    if (state->double_buffered) {
+        state->next ^= 1U;
+        state->queued--;
+        update_double_buffer(number, false);
+    } else {
+        state->queued = 0U;
+        set_rx_status(number, USB_EP_RX_VALID);
+    }
+}
+
+void board_usb_ep_stall(uint8_t address, bool stalled)
+{
+    board_usb_ep_state_t *state = get_ep_state(address);
+    uint8_t number = BOARD_USB_EP_NUMBER(address);
+
+    if (state == NULL || !state->open) {
+        return;
+    }
+
+    if (stalled) {
+        if (BOARD_USB_EP_IS_IN(address)) {
+            set_tx_status(number, USB_EP_TX_STALL);
+        } else {
+            set_rx_status(number, USB_EP_RX_STALL);
+        }
+        return;
+    }
+
+    /* CLEAR_FEATURE(ENDPOINT_HALT) restarts the endpoint at DATA0 with nothing queued */
+    configure_endpoint(address);
+}
+
+bool board_usb_ep_is_stalled(uint8_t address)
+{
+    uint8_t number = BOARD_USB_EP_NUMBER(address);
+    if (number >= BOARD_USB_MAX_ENDPOINTS) {
+        return false;
+    }
+
+    uint16_t reg = USB_EP_REGISTER(number);
+    return BOARD_USB_EP_IS_IN(address) ? ((reg & USB_EPTX_STAT) == USB_EP_TX_STALL)
+                                       : ((reg & USB_EPRX_STAT) == USB_EP_RX_STALL);
+}
+
+void board_usb_ep_service(uint8_t address)
+{
+    uint8_t number = BOARD_USB_EP_NUMBER(address);
+    if (number >= BOARD_USB_MAX_ENDPOINTS) {
+        return;
+    }
+
+    ep_service[number][BOARD_USB_EP_IS_IN(address) ? 1 : 0] = true;
+    NVIC_SetPendingIRQ(USB_LP_IRQn);
+}
+
+#if BOARD_HAS_USB
+void USB_LP_IRQHandler(void)
+{
+#if BOARD_CPU_LOAD_ENABLE
+    const uint32_t preempted = board_cpu_load_enter(BOARD_CPU_LOAD_USB);
+#endif
+    uint16_t istr = USB->ISTR;
+
+    if ((istr & USB_ISTR_RESET) != 0U) {
+        USB->ISTR = (uint16_t)~USB_ISTR_RESET;
+        handle_reset();
+    }
+
+    while (((istr = USB->ISTR) & USB_ISTR_CTR) != 0U) {
+        handle_transfer((uint8_t)(istr & USB_ISTR_EP_ID));
+    }
+
+    if ((istr & USB_ISTR_SUSP) != 0U) {
+        USB->CNTR |= USB_CNTR_FSUSP;
+        USB->ISTR = (uint16_t)~USB_ISTR_SUSP;
+        if (usb_callbacks->suspend != NULL) {
+            usb_callbacks->suspend(true, usb_context);
+        }
+    }
+    if ((istr & USB_ISTR_WKUP) != 0U) {
+        USB->CNTR &= (uint16_t)~USB_CNTR_FSUSP;
+        USB->ISTR = (uint16_t)~USB_ISTR_WKUP;
+        if (usb_callbacks->suspend != NULL) {
+            usb_callbacks->suspend(false, usb_context);
+        }
+    }
+
+    /* Endpoints whose data or room changed outside the interrupt */
+    for (uint8_t number = 0U; number < BOARD_USB_MAX_ENDPOINTS; number++) {
+        if (ep_service[number][0]) {
+            ep_service[number][0] = false;
+            if (ep_states[number][0].open && usb_callbacks->out != NULL) {
+                usb_callbacks->out(number, usb_context);
+            }
+        }
+        if (ep_service[number][1]) {
+            ep_service[number][1] = false;
+            if (ep_states[number][1].open && usb_callbacks->in != NULL) {
+                usb_callbacks->in((uint8_t)(BOARD_USB_EP_IN | number), usb_context);
+            }
+        }
+    }
+#if BOARD_CPU_LOAD_ENABLE
+    board_cpu_load_exit(preempted);
+#endif
+}
+#endif
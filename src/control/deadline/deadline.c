@@ -0,0 +1,73 @@
+#include "control/deadline/deadline.h"
+#include "control_config.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if CONTROL_DEADLINE_ENABLE
+
+deadline_error_t deadline_init(deadline_monitor_t *monitor, uint32_t deadline_us, uint8_t max_level,
+                               deadline_degrade_callback_t callback, void *context)
+{
+    if (monitor == NULL || deadline_us == 0U) {
+        return DEADLINE_ERROR_INVALID_PARAM;
+    }
+
+    memset(monitor, 0, sizeof(*monitor));
+    board_timebase_init();
+
+    const uint64_t ticks = (uint64_t)deadline_us * board_timebase_frequency() / 1000000U;
+    monitor->deadline = (ticks > UINT32_MAX) ? UINT32_MAX : (uint32_t)ticks;
+    monitor->max_level = max_level;
+    monitor->callback = callback;
+    monitor->context = context;
+
+    return DEADLINE_SUCCESS;
+}
+
+void deadline_reset_stats(deadline_monitor_t *monitor)
+{
+    if (monitor == NULL) {
+        return;
+    }
+
+    const uint8_t level = monitor->stats.level;
+    memset(&monitor->stats, 0, sizeof(monitor->stats));
+    monitor->stats.level = level;
+}
+
+/* Up on a bad window, down only after a run of windows without a miss, so the level does not flap */
+void deadline_close_window(deadline_monitor_t *monitor)
+{
+    deadline_stats_t *stats = &monitor->stats;
+    uint8_t level = stats->level;
+
+    if (monitor->window_misses >= DEADLINE_MISS_LIMIT) {
+        monitor->clean_windows = 0U;
+        if (level < monitor->max_level) {
+            level++;
+            stats->degradations++;
+        }
+    } else if (monitor->window_misses == 0U) {
+        if (++monitor->clean_windows >= DEADLINE_RECOVER_WINDOWS) {
+            monitor->clean_windows = 0U;
+            if (level > 0U) {
+                level--;
+            }
+        }
+    } else {
+        monitor->clean_windows = 0U;
+    }
+
+    monitor->window_runs = 0U;
+    monitor->window_misses = 0U;
+
+    if (level != stats->level) {
+        stats->level = level;
+        if (monitor->callback != NULL) {
+            monitor->callback(monitor->context, level);
+        }
+    }
+}
+
+#endif
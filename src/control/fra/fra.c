@@ -0,0 +1,294 @@
+#include "control/fra/fra.h"
+#include "control_config.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "arm_math.h"
+
+#if CONTROL_FRA_ENABLE
+
+#define FRA_TWO_PI 6.28318530718f
+#define FRA_RAD_TO_DEG 57.2957795131f
+#define FRA_RPM_TO_RAD_S (FRA_TWO_PI / 60.0f)
+#define FRA_LINE_SIZE 80
+
+void fra_config_default(fra_config_t *config, fra_loop_t loop)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    float pwm_rate = (float)CONTROL_PWM_FREQUENCY_HZ;
+
+    config->points = FRA_MAX_POINTS;
+    config->settle_cycles = CONTROL_FRA_SETTLE_CYCLES;
+    config->measure_cycles = CONTROL_FRA_MEASURE_CYCLES;
+    config->mode = FRA_MODE_CLOSED_LOOP;
+    config->loop = loop;
+
+    if (loop == FRA_LOOP_SPEED) {
+        config->sample_rate = pwm_rate / (float)CONTROL_SPEED_LOOP_DIVIDER;
+        config->f_start = 1.0f;
+        config->amplitude = (float)CONTROL_FRA_SPEED_AMPLITUDE_RPM * FRA_RPM_TO_RAD_S;
+    } else {
+        config->sample_rate = pwm_rate;
+        config->f_start = 10.0f;
+        config->amplitude = (float)CONTROL_FRA_CURRENT_AMPLITUDE_MA * 0.001f;
+    }
+    config->f_stop = config->sample_rate / 10.0f;
+}
+
+fra_error_t fra_init(fra_t *fra, const fra_config_t *config, uart_t *stream)
+{
+    if (fra == NULL || config == NULL) {
+        return FRA_ERROR_INVALID_PARAM;
+    }
+
+    /* At least four samples per period keeps the oscillator and demodulator accurate */
+    if (config->sample_rate <= 0.0f || config->f_start <= 0.0f || config->f_stop < config->f_start ||
+        config->f_stop > config->sample_rate / 4.0f || config->points == 0U || config->points > FRA_MAX_POINTS ||
+        config->measure_cycles == 0U || config->amplitude == 0.0f) {
+        return FRA_ERROR_INVALID_PARAM;
+    }
+
+    memset(fra, 0, sizeof(*fra));
+    fra->config = *config;
+    fra->stream = stream;
+    fra->state = FRA_STATE_IDLE;
+    return FRA_SUCCESS;
+}
+
+/*
+ * The frequency is rounded so that measure_cycles periods span a whole number
+ * of ticks: the demodulation then covers exact periods and DC or other
+ * harmonics do not leak into the result.
+ */
+static void arm_point(fra_t *fra, uint16_t index)
+{
+    const fra_config_t *config = &fra->config;
+    float ratio = (config->points > 1U) ? (float)index / (float)(config->points - 1U) : 0.0f;
+    float frequency = config->f_start * powf(config->f_stop / config->f_start, ratio);
+
+    uint32_t measure_ticks = (uint32_t)((float)config->measure_cycles * config->sample_rate / frequency + 0.5f);
+    frequency = (float)config->measure_cycles * config->sample_rate / (float)measure_ticks;
+
+    float omega = FRA_TWO_PI * (float)config->measure_cycles / (float)measure_ticks;
+    fra->pending_cos = arm_cos_f32(omega);
+    fra->pending_sin = arm_sin_f32(omega);
+
+    uint32_t settle_ticks = (uint32_t)ceilf((float)config->settle_cycles * config->sample_rate / frequency);
+    fra->settle_ticks = (settle_ticks > 0U) ? settle_ticks : 1U;
+    fra->measure_ticks = measure_ticks;
+    fra->phase_ticks = 0;
+    fra->acc_xs = 0.0f;
+    fra->acc_xc = 0.0f;
+    fra->acc_ys = 0.0f;
+    fra->acc_yc = 0.0f;
+    fra->points[index].frequency = frequency;
+
+    /* Everything above must be visible before the ISR takes ownership */
+    atomic_signal_fence(memory_order_release);
+    fra->state = FRA_STATE_SETTLE;
+}
+
+fra_error_t fra_start(fra_t *fra)
+{
+    if (fra == NULL) {
+        return FRA_ERROR_INVALID_PARAM;
+    }
+
+    fra_state_t state = fra->state;
+    if (state >= FRA_STATE_SETTLE && state <= FRA_STATE_BIN_READY) {
+        return FRA_ERROR_BUSY;
+    }
+
+    fra->abort_request = false;
+    fra->index = 0;
+    fra->streamed = 0;
+    fra->end_streamed = false;
+    fra->osc_sin = 0.0f;
+    fra->osc_cos = 1.0f;
+    arm_point(fra, 0);
+    return FRA_SUCCESS;
+}
+
+void fra_abort(fra_t *fra)
+{
+    if (fra != NULL) {
+        fra->abort_request = true;
+    }
+}
+
+static void finish_point(fra_t *fra)
+{
+    fra_point_t *point = &fra->points[fra->index];
+    float x_re = fra->acc_xs;
+    float x_im = fra->acc_xc;
+    float denominator = x_re * x_re + x_im * x_im;
+
+    if (denominator <= 0.0f) {
+        point->re = 0.0f;
+        point->im = 0.0f;
+        return;
+    }
+
+    /* H = Y / X */
+    float re = (fra->acc_ys * x_re + fra->acc_yc * x_im) / denominator;
+    float im = (fra->acc_yc * x_re - fra->acc_ys * x_im) / denominator;
+
+    if (fra->config.mode == FRA_MODE_OPEN_LOOP) {
+        re = -re;
+        im = -im;
+    }
+
+    point->re = re;
+    point->im = im;
+}
+
+static size_t append_text(char *buffer, size_t length, const char *text)
+{
+    while (*text != '\0' && length < FRA_LINE_SIZE - 1U) {
+        buffer[length++] = *text++;
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+static size_t append_uint(char *buffer, size_t length, uint32_t value)
+{
+    char digits[11];
+    int count = 0;
+
+    do {
+        digits[count++] = (char)('0' + (value % 10U));
+        value /= 10U;
+    } while (value > 0U);
+
+    while (count > 0 && length < FRA_LINE_SIZE - 1U) {
+        buffer[length++] = digits[--count];
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+/* Fixed three decimals; printf float support is not linked with newlib-nano */
+static size_t append_fixed(char *buffer, size_t length, float value)
+{
+    if (!isfinite(value)) {
+        return append_text(buffer, length, "nan");
+    }
+
+    if (value < 0.0f) {
+        length = append_text(buffer, length, "-");
+        value = -value;
+    }
+    if (value > 4.0e6f) {
+        value = 4.0e6f;
+    }
+
+    uint32_t scaled = (uint32_t)(value * 1000.0f + 0.5f);
+    length = append_uint(buffer, length, scaled / 1000U);
+    length = append_text(buffer, length, ".");
+
+    uint32_t fraction = scaled % 1000U;
+    length = append_text(buffer, length, (fraction < 100U) ? ((fraction < 10U) ? "00" : "0") : "");
+    return append_uint(buffer, length, fraction);
+}
+
+static size_t format_prefix(const fra_t *fra, char *buffer)
+{
+    size_t length = append_text(buffer, 0, "fra,");
+    length = append_text(buffer, length, (fra->config.loop == FRA_LOOP_SPEED) ? "speed," : "current,");
+    return append_text(buffer, length, (fra->config.mode == FRA_MODE_OPEN_LOOP) ? "open," : "closed,");
+}
+
+/* One CSV line per point: fra,<loop>,<mode>,<index>,<frequency Hz>,<gain dB>,<phase deg> */
+static void stream_pending(fra_t *fra)
+{
+    char line[FRA_LINE_SIZE];
+    size_t length = format_prefix(fra, line);
+
+    if (fra->streamed < fra->index) {
+        const fra_point_t *point = &fra->points[fra->streamed];
+        float magnitude = 0.0f;
+        arm_sqrt_f32(point->re * point->re + point->im * point->im, &magnitude);
+
+        length = append_uint(line, length, fra->streamed);
+        length = append_text(line, length, ",");
+        length = append_fixed(line, length, point->frequency);
+        length = append_text(line, length, ",");
+        length = append_fixed(line, length, 20.0f * log10f(magnitude));
+        length = append_text(line, length, ",");
+        length = append_fixed(line, length, atan2f(point->im, point->re) * FRA_RAD_TO_DEG);
+        length = append_text(line, length, "\r\n");
+
+        if (uart_write(fra->stream, line, length) == UART_SUCCESS) {
+            fra->streamed++;
+        }
+        return;
+    }
+
+    fra_state_t state = fra->state;
+    if (!fra->end_streamed && (state == FRA_STATE_DONE || state == FRA_STATE_ABORTED)) {
+        length = append_text(line, length, (state == FRA_STATE_DONE) ? "end," : "aborted,");
+        length = append_uint(line, length, fra->index);
+        length = append_text(line, length, "\r\n");
+
+        if (uart_write(fra->stream, line, length) == UART_SUCCESS) {
+            fra->end_streamed = true;
+        }
+    }
+}
+
+bool fra_process(fra_t *fra)
+{
+    if (fra == NULL) {
+        return false;
+    }
+
+    if (fra->state == FRA_STATE_BIN_READY) {
+        finish_point(fra);
+        fra->index++;
+        if (fra->abort_request) {
+            fra->state = FRA_STATE_ABORTED;
+        } else if (fra->index >= fra->config.points) {
+            fra->state = FRA_STATE_DONE;
+        } else {
+            arm_point(fra, fra->index);
+        }
+    }
+
+    if (fra->stream != NULL) {
+        stream_pending(fra);
+    }
+
+    fra_state_t state = fra->state;
+    if (state >= FRA_STATE_SETTLE && state <= FRA_STATE_BIN_READY) {
+        return true;
+    }
+    return (fra->stream != NULL && !fra->end_streamed && state != FRA_STATE_IDLE);
+}
+
+fra_state_t fra_get_state(const fra_t *fra)
+{
+    return (fra != NULL) ? fra->state : FRA_STATE_IDLE;
+}
+
+fra_error_t fra_get_point(const fra_t *fra, uint16_t index, fra_point_t *point)
+{
+    if (fra == NULL || point == NULL) {
+        return FRA_ERROR_INVALID_PARAM;
+    }
+
+    if (index >= fra->index) {
+        return FRA_ERROR_NOT_COMPLETE;
+    }
+
+    *point = fra->points[index];
+    return FRA_SUCCESS;
+}
+
+#endif
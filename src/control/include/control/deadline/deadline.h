@@ -0,0 +1,129 @@
+#ifndef CONTROL_DEADLINE_H
+#define CONTROL_DEADLINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "control_config.h"
+#include "boards/timebase.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONTROL_DEADLINE_ENABLE
+#define DEADLINE_WINDOW CONTROL_DEADLINE_WINDOW
+#define DEADLINE_MISS_LIMIT CONTROL_DEADLINE_MISS_LIMIT
+#define DEADLINE_RECOVER_WINDOWS CONTROL_DEADLINE_RECOVER_WINDOWS
+#else
+#define DEADLINE_WINDOW 1000
+#define DEADLINE_MISS_LIMIT 5
+#define DEADLINE_RECOVER_WINDOWS 10
+#endif
+
+typedef enum {
+    DEADLINE_SUCCESS = 0,
+    DEADLINE_ERROR_INVALID_PARAM
+} deadline_error_t;
+
+/* Called from the monitored task when the degradation level changes */
+typedef void (*deadline_degrade_callback_t)(void *context, uint8_t level);
+
+/*
+ * Times in board timebase ticks. Plain words, so the sampler and the
+ * registry can read them while the task runs.
+ */
+typedef struct {
+    uint32_t runs;
+    uint32_t misses;        /* runs that ended after their deadline */
+    uint32_t latency_last;  /* from the release to the start */
+    uint32_t latency_max;
+    uint32_t run_time_last; /* from the start to the end */
+    uint32_t run_time_max;
+    uint32_t response_max;  /* from the release to the end */
+    uint32_t degradations;  /* times the level went up */
+    uint8_t level;          /* 0 in normal operation */
+} deadline_stats_t;
+
+/*
+ * Deadline monitor for a periodic control task. The task stamps its start
+ * with deadline_begin(), giving the time it was released, e.g. the PWM
+ * update event, and its end with deadline_end(). A run misses when it ends
+ * more than the deadline after its release.
+ *
+ * Misses are counted over windows of DEADLINE_WINDOW runs. A window with
+ * DEADLINE_MISS_LIMIT misses raises the degradation level, at once; each
+ * DEADLINE_RECOVER_WINDOWS clean windows in a row lower it again. What a
+ * level means is up to the callback: for example, level 1 runs the speed
+ * loop at a lower rate and level 2 also stops the observers, such as
+ * speed_loop_set_adaptive(loop, false).
+ */
+typedef struct {
+    deadline_stats_t stats;
+    uint32_t deadline; /* relative to the release */
+    uint32_t release;
+    uint32_t start;
+    uint32_t window_runs;
+    uint32_t window_misses;
+    uint32_t clean_windows;
+    uint8_t max_level;
+    deadline_degrade_callback_t callback;
+    void *context;
+} deadline_monitor_t;
+
+deadline_error_t deadline_init(deadline_monitor_t *monitor, uint32_t deadline_us, uint8_t max_level,
+                               deadline_degrade_callback_t callback, void *context);
+
+/* Background: clear the counters and maxima, keeping the level */
+void deadline_reset_stats(deadline_monitor_t *monitor);
+
+/* Ends a window early or at its end, and steps the level */
+void deadline_close_window(deadline_monitor_t *monitor);
+
+/* First thing in the task; release on the board timebase */
+static inline void deadline_begin(deadline_monitor_t *monitor, uint32_t release)
+{
+    monitor->start = board_timebase_now();
+    monitor->release = release;
+}
+
+/* Last thing in the task; returns true if this run missed its deadline */
+static inline bool deadline_end(deadline_monitor_t *monitor)
+{
+    const uint32_t end = board_timebase_now();
+    deadline_stats_t *stats = &monitor->stats;
+
+    const uint32_t latency = monitor->start - monitor->release;
+    const uint32_t run_time = end - monitor->start;
+    const uint32_t response = end - monitor->release;
+
+    stats->runs++;
+    stats->latency_last = latency;
+    stats->run_time_last = run_time;
+    if (latency > stats->latency_max) {
+        stats->latency_max = latency;
+    }
+    if (run_time > stats->run_time_max) {
+        stats->run_time_max = run_time;
+    }
+    if (response > stats->response_max) {
+        stats->response_max = response;
+    }
+
+    const bool missed = response > monitor->deadline;
+    if (missed) {
+        stats->misses++;
+        monitor->window_misses++;
+    }
+    if (++monitor->window_runs >= DEADLINE_WINDOW || monitor->window_misses >= DEADLINE_MISS_LIMIT) {
+        deadline_close_window(monitor);
+    }
+
+    return missed;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef CONTROL_FRA_H
+#define CONTROL_FRA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "control_config.h"
+#include "drivers/uart/uart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONTROL_FRA_ENABLE
+#define FRA_MAX_POINTS CONTROL_FRA_MAX_POINTS
+#else
+#define FRA_MAX_POINTS 1
+#endif
+
+typedef enum {
+    FRA_SUCCESS = 0,
+    FRA_ERROR_INVALID_PARAM,
+    FRA_ERROR_BUSY,
+    FRA_ERROR_NOT_COMPLETE
+} fra_error_t;
+
+typedef enum {
+    FRA_STATE_IDLE = 0,
+    FRA_STATE_SETTLE,
+    FRA_STATE_MEASURE,
+    FRA_STATE_BIN_READY,
+    FRA_STATE_DONE,
+    FRA_STATE_ABORTED
+} fra_state_t;
+
+typedef enum {
+    FRA_LOOP_CURRENT = 0,
+    FRA_LOOP_SPEED
+} fra_loop_t;
+
+/*
+ * Closed loop: the injection is added to the loop reference; x is the
+ * reference including the injection, y the measured feedback. H = Y / X.
+ *
+ * Open loop: the injection is added to the controller output; x is the plant
+ * input including the injection, y the controller output. The loop gain is
+ * L = -Y / X, measured while the loop stays closed.
+ */
+typedef enum {
+    FRA_MODE_CLOSED_LOOP = 0,
+    FRA_MODE_OPEN_LOOP
+} fra_mode_t;
+
+typedef struct {
+    float sample_rate;       /* rate of fra_step() calls [Hz] */
+    float f_start;           /* [Hz] */
+    float f_stop;            /* [Hz], points are log spaced */
+    uint16_t points;
+    float amplitude;         /* injection amplitude, in units of the injection point */
+    uint16_t settle_cycles;  /* excitation periods discarded after each frequency change */
+    uint16_t measure_cycles; /* excitation periods integrated per point */
+    fra_mode_t mode;
+    fra_loop_t loop;
+} fra_config_t;
+
+typedef struct {
+    float frequency; /* actual excitation frequency [Hz] */
+    float re;
+    float im;
+} fra_point_t;
+
+typedef struct {
+    fra_config_t config;
+    uart_t *stream;
+
+    volatile fra_state_t state;
+    volatile bool abort_request;
+
+    /* Owned by the ISR while settling or measuring, by the background otherwise */
+    float rot_cos;
+    float rot_sin;
+    float pending_cos;
+    float pending_sin;
+    float osc_sin;
+    float osc_cos;
+    uint32_t settle_ticks;
+    uint32_t measure_ticks;
+    uint32_t phase_ticks;
+    float acc_xs;
+    float acc_xc;
+    float acc_ys;
+    float acc_yc;
+
+    /* Background only */
+    uint16_t index;
+    uint16_t streamed;
+    bool end_streamed;
+    fra_point_t points[FRA_MAX_POINTS];
+} fra_t;
+
+/* Fill a configuration from the Kconfig defaults for the given loop */
+void fra_config_default(fra_config_t *config, fra_loop_t loop);
+
+/* stream may be NULL; results are then only available through fra_get_point() */
+fra_error_t fra_init(fra_t *fra, const fra_config_t *config, uart_t *stream);
+fra_error_t fra_start(fra_t *fra);
+void fra_abort(fra_t *fra);
+
+/*
+ * Called once per tick of the loop under test, from its ISR. x and y are the
+ * signals sampled this tick (see fra_mode_t); returns the injection to add at
+ * the injection point. Constant cost: one oscillator update and four MACs.
+ */
+static inline float fra_step(fra_t *fra, float x, float y)
+{
+    fra_state_t state = fra->state;
+
+    if (state < FRA_STATE_SETTLE || state > FRA_STATE_BIN_READY) {
+        return 0.0f;
+    }
+
+    if (fra->abort_request) {
+        /* A ready bin belongs to the background, which completes the abort in fra_process() */
+        if (state != FRA_STATE_BIN_READY) {
+            fra->state = FRA_STATE_ABORTED;
+        }
+        return 0.0f;
+    }
+
+    float s = fra->osc_sin;
+    float c = fra->osc_cos;
+
+    if (state == FRA_STATE_SETTLE) {
+        if (fra->phase_ticks == 0U) {
+            fra->rot_cos = fra->pending_cos;
+            fra->rot_sin = fra->pending_sin;
+        }
+        if (++fra->phase_ticks >= fra->settle_ticks) {
+            fra->phase_ticks = 0;
+            fra->state = FRA_STATE_MEASURE;
+        }
+    } else if (state == FRA_STATE_MEASURE) {
+        fra->acc_xs += x * s;
+        fra->acc_xc += x * c;
+        fra->acc_ys += y * s;
+        fra->acc_yc += y * c;
+        if (++fra->phase_ticks >= fra->measure_ticks) {
+            fra->state = FRA_STATE_BIN_READY;
+        }
+    }
+
+    /* Recursive oscillator with first-order amplitude correction */
+    float s_next = s * fra->rot_cos + c * fra->rot_sin;
+    float c_next = c * fra->rot_cos - s * fra->rot_sin;
+    float gain = 1.5f - 0.5f * (s_next * s_next + c_next * c_next);
+    fra->osc_sin = s_next * gain;
+    fra->osc_cos = c_next * gain;
+
+    /* Keep exciting while the background prepares the next point to avoid a transient */
+    return fra->config.amplitude * fra->osc_sin;
+}
+
+/*
+ * Background slice: finishes at most one point (demodulation, streaming) and
+ * arms the next frequency. Returns true while the sweep is still running.
+ */
+bool fra_process(fra_t *fra);
+
+fra_state_t fra_get_state(const fra_t *fra);
+fra_error_t fra_get_point(const fra_t *fra, uint16_t index, fra_point_t *point);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef CONTROL_MOTOR_ID_H
+#define CONTROL_MOTOR_ID_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "control/pi/pi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    MOTOR_ID_SUCCESS = 0,
+    MOTOR_ID_ERROR_INVALID_PARAM,
+    MOTOR_ID_ERROR_BUSY,
+    MOTOR_ID_ERROR_NOT_COMPLETE,
+    MOTOR_ID_ERROR_STORAGE
+} motor_id_error_t;
+
+typedef enum {
+    MOTOR_ID_STATE_IDLE = 0,
+    MOTOR_ID_STATE_ALIGN,
+    MOTOR_ID_STATE_RESISTANCE,
+    MOTOR_ID_STATE_INDUCTANCE_D,
+    MOTOR_ID_STATE_INDUCTANCE_Q,
+    MOTOR_ID_STATE_FLUX,
+    MOTOR_ID_STATE_SPIN_DOWN,
+    MOTOR_ID_STATE_INERTIA_ACCEL,
+    MOTOR_ID_STATE_INERTIA_COAST,
+    MOTOR_ID_STATE_DONE,
+    MOTOR_ID_STATE_ABORTED,
+    MOTOR_ID_STATE_FAULT
+} motor_id_state_t;
+
+typedef enum {
+    MOTOR_ID_FAULT_NONE = 0,
+    MOTOR_ID_FAULT_OVERCURRENT,
+    MOTOR_ID_FAULT_TIMEOUT,
+    MOTOR_ID_FAULT_NO_CURRENT,
+    MOTOR_ID_FAULT_IMPLAUSIBLE
+} motor_id_fault_t;
+
+/* Which rotor angle the caller must use for the Park transforms this tick */
+typedef enum {
+    MOTOR_ID_ANGLE_COMMANDED = 0,
+    MOTOR_ID_ANGLE_MEASURED
+} motor_id_angle_source_t;
+
+typedef struct {
+    float dt;                /* control tick period [s] */
+    uint8_t pole_pairs;
+    float test_current;      /* [A] */
+    float max_voltage;       /* per-axis voltage limit [V] */
+    float trip_current;      /* [A] */
+    float current_bandwidth; /* [rad/s] */
+    float speed_bw_ratio;
+    float spin_speed;        /* open-loop electrical speed for the flux test [rad/s] */
+    bool speed_feedback;     /* caller supplies rotor angle and speed: enables the inertia test */
+    uint32_t timeout_ticks;
+} motor_id_config_t;
+
+typedef struct {
+    float rs;       /* [ohm] */
+    float ld;       /* [H] */
+    float lq;       /* [H] */
+    float flux;     /* permanent magnet flux linkage [Wb] */
+    float inertia;  /* [kg m^2] */
+    float friction; /* viscous friction [N m s/rad] */
+} motor_params_t;
+
+typedef struct {
+    motor_params_t motor;
+    pi_gains_t current_d; /* V per A */
+    pi_gains_t current_q; /* V per A */
+    pi_gains_t speed;     /* A per mechanical rad/s; zero unless mechanical_valid */
+    bool mechanical_valid;
+} motor_id_result_t;
+
+typedef struct {
+    float i_d;        /* [A] */
+    float i_q;        /* [A] */
+    float omega_mech; /* [rad/s], only read when speed_feedback is set */
+} motor_id_input_t;
+
+typedef struct {
+    float v_d; /* [V] */
+    float v_q; /* [V] */
+    float theta_elec;
+    motor_id_angle_source_t angle_source;
+} motor_id_output_t;
+
+/* Online least-squares slope, numerically stable in single precision */
+typedef struct {
+    uint32_t n;
+    float mean_x;
+    float mean_y;
+    float cxy;
+    float m2x;
+} motor_id_regression_t;
+
+typedef struct {
+    motor_id_config_t config;
+    motor_id_result_t result;
+    volatile motor_id_state_t state;
+    volatile motor_id_fault_t fault;
+    volatile bool abort_request;
+
+    uint32_t total_ticks;
+    uint32_t phase_ticks;
+    uint8_t step;
+    uint8_t pulse;
+
+    /* Phase durations converted to ticks at start */
+    uint32_t align_ticks;
+    uint32_t settle_ticks;
+    uint32_t measure_ticks;
+    uint32_t pulse_max_ticks;
+    uint32_t pulse_rest_ticks;
+    uint32_t ramp_ticks;
+    uint32_t coast_ticks;
+
+    float v_d;
+    float v_q;
+    float theta;
+    float omega;
+    motor_id_angle_source_t angle_source;
+
+    float ki_align_dt;
+    float v_bias;
+    float i_bias;
+    float v_pulse;
+    float i_start;
+    float i_last;
+    float i_area; /* sum of the trapezoids of the current pulse [A ticks] */
+    uint32_t pulse_ticks;
+    uint32_t pulse_length;
+    float acc[4];
+    uint32_t acc_count;
+    float l_sum;
+    uint32_t l_count;
+    float omega_peak;
+    float accel_slope;
+    motor_id_regression_t regression;
+
+    pi_controller_t pi_d;
+    pi_controller_t pi_q;
+} motor_id_t;
+
+/* Fill a configuration from the Kconfig defaults */
+void motor_id_config_default(motor_id_config_t *config);
+
+motor_id_error_t motor_id_init(motor_id_t *id, const motor_id_config_t *config);
+motor_id_error_t motor_id_start(motor_id_t *id);
+void motor_id_abort(motor_id_t *id);
+
+/*
+ * Called once per current-loop tick from the PWM ISR with currents already
+ * transformed using the angle requested in the previous output. Bounded cost,
+ * no blocking.
+ */
+void motor_id_step(motor_id_t *id, const motor_id_input_t *in, motor_id_output_t *out);
+
+motor_id_state_t motor_id_get_state(const motor_id_t *id);
+motor_id_fault_t motor_id_get_fault(const motor_id_t *id);
+motor_id_error_t motor_id_get_result(const motor_id_t *id, motor_id_result_t *result);
+
+/* Background context only: flash writes stall the CPU */
+motor_id_error_t motor_id_save(const motor_id_t *id);
+motor_id_error_t motor_id_load(motor_id_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
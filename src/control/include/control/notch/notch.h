@@ -0,0 +1,65 @@
+#ifndef CONTROL_NOTCH_H
+#define CONTROL_NOTCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "arm_math.h"
+#include "control_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONTROL_NOTCH_ENABLE
+#define NOTCH_MAX_STAGES CONTROL_NOTCH_STAGES
+#else
+#define NOTCH_MAX_STAGES 1
+#endif
+#define NOTCH_COEFFS_PER_STAGE 5U
+
+typedef enum {
+    NOTCH_SUCCESS = 0,
+    NOTCH_ERROR_INVALID_PARAM
+} notch_error_t;
+
+typedef struct {
+    bool enabled;
+    float frequency; /* centre [Hz] */
+    float width;     /* -3 dB bandwidth of the pole pair [Hz] */
+    float depth;     /* gain at the centre, 0 < depth < 1 */
+} notch_params_t;
+
+/*
+ * Cascade of second-order notches run with arm_biquad_cascade_df2T_f32.
+ * Coefficients are double buffered: notch_set() designs into the idle bank
+ * and publishes it with a single pointer store, so the control ISR always
+ * sees a complete coefficient set. Disabled stages pass through.
+ */
+typedef struct {
+    arm_biquad_cascade_df2T_instance_f32 instance;
+    float coeffs[2][NOTCH_COEFFS_PER_STAGE * NOTCH_MAX_STAGES];
+    float state[2 * NOTCH_MAX_STAGES];
+    notch_params_t params[NOTCH_MAX_STAGES];
+    float sample_rate;
+    uint8_t active_bank;
+} notch_filter_t;
+
+notch_error_t notch_init(notch_filter_t *filter, float sample_rate);
+
+/* Background context only; must not be preempted by another notch_set() on the same filter */
+notch_error_t notch_set(notch_filter_t *filter, uint8_t stage, const notch_params_t *params);
+notch_error_t notch_get(const notch_filter_t *filter, uint8_t stage, notch_params_t *params);
+
+static inline float notch_apply(notch_filter_t *filter, float input)
+{
+    float output;
+    arm_biquad_cascade_df2T_f32(&filter->instance, &input, &output, 1);
+    return output;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
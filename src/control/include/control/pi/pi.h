@@ -0,0 +1,52 @@
+#ifndef CONTROL_PI_H
+#define CONTROL_PI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Parallel form: u = kp * e + ki * integral(e dt) */
+typedef struct {
+    float kp;
+    float ki;
+} pi_gains_t;
+
+typedef struct {
+    pi_gains_t gains;
+    float ki_dt;
+    float integral;
+    float out_min;
+    float out_max;
+} pi_controller_t;
+
+void pi_init(pi_controller_t *pi, const pi_gains_t *gains, float dt, float out_min, float out_max);
+void pi_set_gains(pi_controller_t *pi, const pi_gains_t *gains, float dt);
+void pi_reset(pi_controller_t *pi, float output);
+
+/* Inline: runs in the current loop ISR. Integration stops while the output saturates */
+static inline float pi_update(pi_controller_t *pi, float error)
+{
+    float integral = pi->integral + pi->ki_dt * error;
+    float output = pi->gains.kp * error + integral;
+
+    if (output > pi->out_max) {
+        output = pi->out_max;
+        if (error > 0.0f) {
+            integral = pi->integral;
+        }
+    } else if (output < pi->out_min) {
+        output = pi->out_min;
+        if (error < 0.0f) {
+            integral = pi->integral;
+        }
+    }
+
+    pi->integral = integral;
+    return output;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
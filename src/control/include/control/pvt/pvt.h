@@ -0,0 +1,116 @@
+#ifndef CONTROL_PVT_H
+#define CONTROL_PVT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "control_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONTROL_PVT_ENABLE
+#define PVT_BUFFER_SIZE CONTROL_PVT_BUFFER_SIZE
+#else
+#define PVT_BUFFER_SIZE 2
+#endif
+
+typedef enum {
+    PVT_SUCCESS = 0,
+    PVT_ERROR_INVALID_PARAM,
+    PVT_ERROR_BUFFER_FULL,
+    PVT_ERROR_INVALID_STATE
+} pvt_error_t;
+
+typedef enum {
+    PVT_MODE_PVT = 0, /* host supplies position and velocity */
+    PVT_MODE_PT       /* host supplies position only; velocities are estimated */
+} pvt_mode_t;
+
+typedef enum {
+    PVT_STATE_IDLE = 0,
+    PVT_STATE_FILLING,  /* buffering until the start delay is covered */
+    PVT_STATE_RUNNING,
+    PVT_STATE_FINISHED, /* reached the last point at rest */
+    PVT_STATE_UNDERRUN  /* ran out of points while moving: braking to a stop */
+} pvt_state_t;
+
+typedef struct {
+    uint32_t time_us; /* host timestamp, wraps */
+    float position;   /* [rad] */
+    float velocity;   /* [rad/s], ignored in PT mode */
+} pvt_point_t;
+
+typedef struct {
+    float position;     /* [rad] */
+    float velocity;     /* [rad/s] */
+    float acceleration; /* [rad/s^2] */
+} pvt_setpoint_t;
+
+typedef struct {
+    float dt;                /* evaluation period [s] */
+    pvt_mode_t mode;
+    uint32_t start_delay_us; /* stream span buffered before playback starts */
+    float lead;              /* evaluate this far ahead to cover loop latency [s] */
+    float underrun_decel;    /* [rad/s^2] */
+} pvt_config_t;
+
+/*
+ * Timestamped setpoint stream played back with cubic Hermite interpolation.
+ * The background pushes points into a single-producer single-consumer ring;
+ * the control ISR consumes them in pvt_evaluate(). Each segment's polynomial
+ * is computed once when the segment is entered, so a tick costs a handful of
+ * multiply-adds. Playback runs on the drive's own tick; host timestamps only
+ * define segment durations, and the start delay absorbs transport jitter.
+ *
+ * In PT mode the velocity at a point needs the point after it. A point must
+ * therefore arrive before playback reaches the one before it; a later one
+ * finds the stream finished at rest on that point.
+ */
+typedef struct {
+    pvt_config_t config;
+
+    /* Ring: head written by the producer, tail by the ISR */
+    pvt_point_t points[PVT_BUFFER_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t last_time_us; /* producer side: timestamp of the newest point */
+    bool has_last;
+
+    volatile pvt_state_t state;
+    volatile uint32_t underruns;
+
+    /* Current segment p(t) = c0 + c1 t + c2 t^2 + c3 t^3 */
+    float coeffs[4];
+    float segment_time;
+    float segment_duration;
+    float end_velocity;   /* velocity assigned to the segment end point */
+    bool end_provisional; /* PT mode: end velocity set to rest until the following point arrives */
+
+    pvt_setpoint_t output;
+} pvt_stream_t;
+
+/* Fill a configuration from the Kconfig defaults */
+void pvt_config_default(pvt_config_t *config, float dt);
+
+/* Playback holds position until a stream is started */
+pvt_error_t pvt_init(pvt_stream_t *stream, const pvt_config_t *config, float position);
+
+/* Background context: flush the buffer and arm playback for a new stream. Not while moving */
+pvt_error_t pvt_start(pvt_stream_t *stream);
+
+/* Background context, after pvt_start(); timestamps must increase. Fails without blocking when full */
+pvt_error_t pvt_push(pvt_stream_t *stream, const pvt_point_t *point);
+
+uint32_t pvt_get_free(const pvt_stream_t *stream);
+pvt_state_t pvt_get_state(const pvt_stream_t *stream);
+
+/* Control tick: advance playback by dt and return the setpoint with feed-forward */
+void pvt_evaluate(pvt_stream_t *stream, pvt_setpoint_t *setpoint);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef CONTROL_RESONANCE_H
+#define CONTROL_RESONANCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "arm_math.h"
+#include "control/notch/notch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Must match the real FFT tables selected for cmsis_dsp in the board CMakeLists */
+#define RESONANCE_FFT_SIZE 512U
+#define RESONANCE_MAX_PEAKS NOTCH_MAX_STAGES
+
+typedef enum {
+    RESONANCE_SUCCESS = 0,
+    RESONANCE_ERROR_INVALID_PARAM
+} resonance_error_t;
+
+typedef struct {
+    float sample_rate; /* rate of resonance_push() calls [Hz] */
+    float f_min;       /* [Hz] */
+    float f_max;       /* [Hz] */
+    float threshold;   /* peak to mean in-band spectrum ratio */
+} resonance_config_t;
+
+typedef struct {
+    float frequency; /* [Hz] */
+    float ratio;     /* peak to mean in-band spectrum ratio */
+} resonance_peak_t;
+
+/*
+ * The ISR fills the capture buffer one sample per tick; once full it is owned
+ * by the background until resonance_process() has analysed it.
+ */
+typedef struct {
+    resonance_config_t config;
+    arm_rfft_fast_instance_f32 fft;
+    float capture[RESONANCE_FFT_SIZE];
+    float spectrum[RESONANCE_FFT_SIZE];
+    volatile uint16_t count;
+    volatile bool ready;
+    resonance_peak_t peaks[RESONANCE_MAX_PEAKS];
+    uint8_t peak_count;
+} resonance_detector_t;
+
+void resonance_config_default(resonance_config_t *config, float sample_rate);
+resonance_error_t resonance_init(resonance_detector_t *detector, const resonance_config_t *config);
+
+static inline void resonance_push(resonance_detector_t *detector, float sample)
+{
+    if (detector->ready) {
+        return;
+    }
+
+    uint16_t count = detector->count;
+    detector->capture[count++] = sample;
+    if (count >= RESONANCE_FFT_SIZE) {
+        count = 0;
+        detector->ready = true;
+    }
+    detector->count = count;
+}
+
+/*
+ * Background: analyses a full capture (Hann window, real FFT, peak search with
+ * parabolic interpolation) and re-arms the capture. Returns true when a new
+ * analysis finished; the strongest peaks come first.
+ */
+bool resonance_process(resonance_detector_t *detector);
+uint8_t resonance_get_peaks(const resonance_detector_t *detector, const resonance_peak_t **peaks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef CONTROL_SCURVE_H
+#define CONTROL_SCURVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SCURVE_SUCCESS = 0,
+    SCURVE_ERROR_INVALID_PARAM
+} scurve_error_t;
+
+typedef struct {
+    float velocity;     /* [rad/s] */
+    float acceleration; /* [rad/s^2] */
+    float jerk;         /* [rad/s^3] */
+} scurve_limits_t;
+
+/* Setpoint and feed-forward terms for the position, speed and current loops */
+typedef struct {
+    float position;     /* [rad] */
+    float velocity;     /* [rad/s] */
+    float acceleration; /* [rad/s^2] */
+} scurve_setpoint_t;
+
+typedef struct {
+    float target;
+    scurve_limits_t limits;
+} scurve_command_t;
+
+/*
+ * Online seven-segment S-curve: each tick picks the jerk that drives the
+ * state towards the target along the time-optimal jerk-limited braking curve
+ * and integrates it exactly. Targets and limits may change at any time; the
+ * profile continues smoothly from the current state.
+ */
+typedef struct {
+    float dt;
+    scurve_setpoint_t state;
+    scurve_command_t command;
+    bool settled;
+
+    /*
+     * state.position - command.target, as error + error_carry. The profile
+     * is integrated on this rather than on the position, whose float
+     * resolution far from zero is coarser than a tick of motion near the
+     * target; error_carry keeps the rounding of the sum.
+     */
+    float error;
+    float error_carry;
+
+    /* Written by the background, latched by the ISR at the start of a tick */
+    scurve_command_t pending;
+    volatile uint32_t pending_sequence;
+    uint32_t latched_sequence;
+} scurve_t;
+
+/* Fill limits from the Kconfig defaults */
+void scurve_limits_default(scurve_limits_t *limits);
+
+scurve_error_t scurve_init(scurve_t *scurve, const scurve_limits_t *limits, float dt, float position);
+
+/* Background context; the new command takes effect on the next tick */
+scurve_error_t scurve_set_command(scurve_t *scurve, float target, const scurve_limits_t *limits);
+scurve_error_t scurve_set_target(scurve_t *scurve, float target);
+
+/* Control tick: constant cost, no trigonometry and no iteration */
+void scurve_step(scurve_t *scurve, scurve_setpoint_t *setpoint);
+
+bool scurve_is_settled(const scurve_t *scurve);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef CONTROL_SPEED_LOOP_H
+#define CONTROL_SPEED_LOOP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "control_config.h"
+#include "control/pi/pi.h"
+#include "control/notch/notch.h"
+#include "control/resonance/resonance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SPEED_LOOP_SUCCESS = 0,
+    SPEED_LOOP_ERROR_INVALID_PARAM
+} speed_loop_error_t;
+
+/*
+ * Speed PI followed by the notch cascade on the torque current reference.
+ * With resonance detection enabled, the speed error is captured every tick
+ * and speed_loop_process() places and retunes notches on detected peaks;
+ * a stage that has converged on its resonance is locked and never reused.
+ */
+typedef struct {
+    pi_controller_t pi;
+    float sample_rate;
+#if CONTROL_NOTCH_ENABLE
+    notch_filter_t notch;
+    float notch_width_ratio;
+    float notch_depth;
+#endif
+#if CONTROL_RESONANCE_DETECT_ENABLE
+    resonance_detector_t resonance;
+    volatile bool adaptive;
+    bool notch_locked[NOTCH_MAX_STAGES]; /* converged stages, kept until the loop is re-initialised */
+#endif
+} speed_loop_t;
+
+/* gains in A per mechanical rad/s, current_limit in A */
+speed_loop_error_t speed_loop_init(speed_loop_t *loop, const pi_gains_t *gains, float sample_rate,
+                                   float current_limit);
+speed_loop_error_t speed_loop_set_gains(speed_loop_t *loop, const pi_gains_t *gains);
+void speed_loop_reset(speed_loop_t *loop, float current);
+void speed_loop_set_adaptive(speed_loop_t *loop, bool enable);
+
+/* Called from the speed loop tick; returns the q-axis current reference [A] */
+static inline float speed_loop_update(speed_loop_t *loop, float speed_ref, float speed)
+{
+    float error = speed_ref - speed;
+    float current = pi_update(&loop->pi, error);
+
+#if CONTROL_RESONANCE_DETECT_ENABLE
+    if (loop->adaptive) {
+        resonance_push(&loop->resonance, error);
+    }
+#endif
+#if CONTROL_NOTCH_ENABLE
+    current = notch_apply(&loop->notch, current);
+#endif
+
+    return current;
+}
+
+/* Background slice: runs one resonance analysis when a capture is complete */
+void speed_loop_process(speed_loop_t *loop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
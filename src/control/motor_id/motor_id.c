@@ -0,0 +1,656 @@
+#include "control/motor_id/motor_id.h"
+#include "drivers/param_store/param_store.h"
+#include "control_config.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#if CONTROL_MOTOR_ID_ENABLE
+
+#define MOTOR_ID_PARAM_KEY 0x4D01U
+#define MOTOR_ID_TWO_PI 6.28318530718f
+
+/* Phase timing [s] */
+#define MOTOR_ID_ALIGN_TIME 0.5f
+#define MOTOR_ID_SETTLE_TIME 0.2f
+#define MOTOR_ID_MEASURE_TIME 0.2f
+#define MOTOR_ID_PULSE_MAX_TIME 0.005f
+#define MOTOR_ID_PULSE_REST_TIME 0.05f
+#define MOTOR_ID_RAMP_TIME 1.0f
+#define MOTOR_ID_COAST_TIME 1.0f
+
+#define MOTOR_ID_PULSE_COUNT 8U
+#define MOTOR_ID_PULSE_STEP 0.5f /* pulse ends once current moved by this fraction of the test current */
+#define MOTOR_ID_MIN_SAMPLES 16U
+
+enum {
+    PULSE_STEP_POSITIVE = 0,
+    PULSE_STEP_NEGATIVE,
+    PULSE_STEP_REST
+};
+
+static uint32_t seconds_to_ticks(const motor_id_t *id, float seconds)
+{
+    uint32_t ticks = (uint32_t)(seconds / id->config.dt + 0.5f);
+    return (ticks > 0U) ? ticks : 1U;
+}
+
+static float clampf(float value, float limit)
+{
+    if (value > limit) {
+        return limit;
+    }
+    if (value < -limit) {
+        return -limit;
+    }
+    return value;
+}
+
+static bool is_positive_finite(float value)
+{
+    return isfinite(value) && value > 0.0f;
+}
+
+static void regression_reset(motor_id_regression_t *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+static void regression_add(motor_id_regression_t *r, float x, float y)
+{
+    r->n++;
+    float dx = x - r->mean_x;
+    r->mean_x += dx / (float)r->n;
+    r->mean_y += (y - r->mean_y) / (float)r->n;
+    r->cxy += dx * (y - r->mean_y);
+    r->m2x += dx * (x - r->mean_x);
+}
+
+static float regression_slope(const motor_id_regression_t *r)
+{
+    return (r->m2x > 0.0f) ? (r->cxy / r->m2x) : 0.0f;
+}
+
+static void enter_state(motor_id_t *id, motor_id_state_t state)
+{
+    id->state = state;
+    id->phase_ticks = 0;
+    id->step = 0;
+    id->pulse = 0;
+    id->acc_count = 0;
+    memset(id->acc, 0, sizeof(id->acc));
+}
+
+static void finish(motor_id_t *id, motor_id_state_t state, motor_id_fault_t fault)
+{
+    id->v_d = 0.0f;
+    id->v_q = 0.0f;
+    id->omega = 0.0f;
+    id->angle_source = MOTOR_ID_ANGLE_COMMANDED;
+    id->fault = fault;
+    enter_state(id, state);
+}
+
+/* Pure integral current control used before the resistance is known */
+static void regulate_d_integral(motor_id_t *id, float i_ref, float i_d)
+{
+    id->v_d = clampf(id->v_d + id->ki_align_dt * (i_ref - i_d), id->config.max_voltage);
+}
+
+static void tune_current_loop(motor_id_t *id)
+{
+    motor_id_result_t *r = &id->result;
+    float wc = id->config.current_bandwidth;
+
+    /* Pole-zero cancellation of the R-L plant gives a first-order loop at wc */
+    r->current_d.kp = r->motor.ld * wc;
+    r->current_d.ki = r->motor.rs * wc;
+    r->current_q.kp = r->motor.lq * wc;
+    r->current_q.ki = r->motor.rs * wc;
+
+    pi_init(&id->pi_d, &r->current_d, id->config.dt, -id->config.max_voltage, id->config.max_voltage);
+    pi_init(&id->pi_q, &r->current_q, id->config.dt, -id->config.max_voltage, id->config.max_voltage);
+}
+
+static void tune_speed_loop(motor_id_t *id)
+{
+    motor_id_result_t *r = &id->result;
+    float kt = 1.5f * (float)id->config.pole_pairs * r->motor.flux;
+    float ws = id->config.current_bandwidth / id->config.speed_bw_ratio;
+
+    /* Crossover at ws with the PI zero a quarter of a decade below it */
+    r->speed.kp = r->motor.inertia * ws / kt;
+    r->speed.ki = r->speed.kp * ws * 0.25f;
+}
+
+static void step_align(motor_id_t *id, const motor_id_input_t *in)
+{
+    regulate_d_integral(id, id->config.test_current, in->i_d);
+
+    if (id->phase_ticks < id->align_ticks) {
+        return;
+    }
+
+    if (fabsf(in->i_d - id->config.test_current) > 0.2f * id->config.test_current) {
+        finish(id, MOTOR_ID_STATE_FAULT, MOTOR_ID_FAULT_NO_CURRENT);
+        return;
+    }
+
+    enter_state(id, MOTOR_ID_STATE_RESISTANCE);
+}
+
+/* Two DC levels: the slope cancels the inverter dead-time voltage offset */
+static void step_resistance(motor_id_t *id, const motor_id_input_t *in)
+{
+    float i_ref = (id->step == 0U) ? 0.5f * id->config.test_current : id->config.test_current;
+    regulate_d_integral(id, i_ref, in->i_d);
+
+    if (id->phase_ticks <= id->settle_ticks) {
+        return;
+    }
+
+    id->acc[2U * id->step] += id->v_d;
+    id->acc[2U * id->step + 1U] += in->i_d;
+    id->acc_count++;
+
+    if (id->acc_count < id->measure_ticks) {
+        return;
+    }
+
+    id->acc[2U * id->step] /= (float)id->acc_count;
+    id->acc[2U * id->step + 1U] /= (float)id->acc_count;
+
+    if (id->step == 0U) {
+        id->step = 1U;
+        id->phase_ticks = 0;
+        id->acc_count = 0;
+        return;
+    }
+
+    float dv = id->acc[2] - id->acc[0];
+    float di = id->acc[3] - id->acc[1];
+    id->result.motor.rs = (fabsf(di) > 0.1f * id->config.test_current) ? dv / di : 0.0f;
+    if (!is_positive_finite(id->result.motor.rs)) {
+        finish(id, MOTOR_ID_STATE_FAULT, MOTOR_ID_FAULT_IMPLAUSIBLE);
+        return;
+    }
+
+    id->v_bias = id->acc[2];
+    id->i_bias = id->acc[3];
+
+    /* Pulse amplitude: voltage that drives the test current through Rs, within headroom */
+    float headroom = id->config.max_voltage - fabsf(id->v_bias);
+    id->v_pulse = id->result.motor.rs * id->config.test_current;
+    if (id->v_pulse < 0.02f * id->config.max_voltage) {
+        id->v_pulse = 0.02f * id->config.max_voltage;
+    }
+    if (id->v_pulse > headroom) {
+        id->v_pulse = headroom;
+    }
+
+    id->l_sum = 0.0f;
+    id->l_count = 0;
+    enter_state(id, MOTOR_ID_STATE_INDUCTANCE_D);
+}
+
+static void accumulate_inductance(motor_id_t *id, float v_step, float i_end, float bias)
+{
+    float di = i_end - id->i_start;
+    if (fabsf(di) < 1e-6f) {
+        return;
+    }
+
+    /* Subtract the resistive drop of the mean current excursion from the step voltage */
+    float i_mean = id->i_area / (float)id->pulse_ticks - bias;
+    float l = (v_step - id->result.motor.rs * i_mean) * (float)id->pulse_ticks * id->config.dt / di;
+    if (is_positive_finite(l)) {
+        id->l_sum += l;
+        id->l_count++;
+    }
+}
+
+/*
+ * Alternating voltage pulses on one axis around a fixed bias. The positive half
+ * ends once the current has moved by MOTOR_ID_PULSE_STEP of the test current;
+ * the negative half mirrors its duration so the rotor sees no net torque.
+ */
+static bool step_pulses(motor_id_t *id, float *v_axis, float i_axis, float v_bias, float i_bias)
+{
+    /* Trapezoidal current integral: the current bends over a pulse as Rs pulls it back */
+    id->pulse_ticks++;
+    id->i_area += 0.5f * (id->i_last + i_axis);
+    id->i_last = i_axis;
+
+    switch (id->step) {
+        case PULSE_STEP_POSITIVE:
+            if (fabsf(i_axis - id->i_start) >= MOTOR_ID_PULSE_STEP * id->config.test_current ||
+                id->pulse_ticks >= id->pulse_max_ticks) {
+                accumulate_inductance(id, id->v_pulse, i_axis, i_bias);
+                id->i_start = i_axis;
+                id->i_area = 0.0f;
+                id->step = PULSE_STEP_NEGATIVE;
+                id->pulse_length = id->pulse_ticks;
+                id->pulse_ticks = 0;
+                *v_axis = v_bias - id->v_pulse;
+            }
+            break;
+
+        case PULSE_STEP_NEGATIVE:
+            if (id->pulse_ticks >= id->pulse_length) {
+                accumulate_inductance(id, -id->v_pulse, i_axis, i_bias);
+                id->step = PULSE_STEP_REST;
+                id->pulse_ticks = 0;
+                *v_axis = v_bias;
+            }
+            break;
+
+        default:
+            if (id->pulse_ticks >= id->pulse_rest_ticks) {
+                if (id->pulse >= MOTOR_ID_PULSE_COUNT) {
+                    return true;
+                }
+                id->pulse++;
+                id->i_start = i_axis;
+                id->i_area = 0.0f;
+                id->step = PULSE_STEP_POSITIVE;
+                id->pulse_ticks = 0;
+                *v_axis = v_bias + id->v_pulse;
+            }
+            break;
+    }
+
+    return false;
+}
+
+static bool finish_inductance(motor_id_t *id, float *l)
+{
+    if (id->l_count < MOTOR_ID_PULSE_COUNT) {
+        finish(id, MOTOR_ID_STATE_FAULT, MOTOR_ID_FAULT_IMPLAUSIBLE);
+        return false;
+    }
+
+    *l = id->l_sum / (float)id->l_count;
+    id->l_sum = 0.0f;
+    id->l_count = 0;
+    return true;
+}
+
+static void step_inductance_d(motor_id_t *id, const motor_id_input_t *in)
+{
+    if (id->phase_ticks == 1U) {
+        /* Start with a rest period so the bias current is settled */
+        id->step = PULSE_STEP_REST;
+        id->pulse_ticks = 0;
+        id->i_last = in->i_d;
+        id->v_d = id->v_bias;
+        return;
+    }
+
+    if (!step_pulses(id, &id->v_d, in->i_d, id->v_bias, id->i_bias)) {
+        return;
+    }
+
+    if (finish_inductance(id, &id->result.motor.ld)) {
+        enter_state(id, MOTOR_ID_STATE_INDUCTANCE_Q);
+    }
+}
+
+/* The d-axis bias keeps the rotor locked while q is pulsed */
+static void step_inductance_q(motor_id_t *id, const motor_id_input_t *in)
+{
+    if (id->phase_ticks == 1U) {
+        id->step = PULSE_STEP_REST;
+        id->pulse_ticks = 0;
+        id->i_last = in->i_q;
+        id->v_q = 0.0f;
+        return;
+    }
+
+    if (!step_pulses(id, &id->v_q, in->i_q, 0.0f, 0.0f)) {
+        return;
+    }
+
+    if (!finish_inductance(id, &id->result.motor.lq)) {
+        return;
+    }
+
+    tune_current_loop(id);
+    pi_reset(&id->pi_d, id->v_bias);
+    pi_reset(&id->pi_q, 0.0f);
+    id->theta = 0.0f;
+    id->omega = 0.0f;
+    enter_state(id, MOTOR_ID_STATE_FLUX);
+}
+
+static void advance_angle(motor_id_t *id)
+{
+    id->theta += id->omega * id->config.dt;
+    if (id->theta >= MOTOR_ID_TWO_PI) {
+        id->theta -= MOTOR_ID_TWO_PI;
+    } else if (id->theta < 0.0f) {
+        id->theta += MOTOR_ID_TWO_PI;
+    }
+}
+
+static void regulate_currents(motor_id_t *id, const motor_id_input_t *in, float i_d_ref, float i_q_ref)
+{
+    id->v_d = pi_update(&id->pi_d, i_d_ref - in->i_d);
+    id->v_q = pi_update(&id->pi_q, i_q_ref - in->i_q);
+}
+
+/*
+ * Open-loop current-vector spin (I/f). In the commanded frame the back-EMF is
+ * what remains of the voltage after the resistive and rotational inductive
+ * drops; its magnitude over the electrical speed is the flux linkage. The
+ * rotor trails the d current by no more than the load angle, so the
+ * commanded frame is taken as the rotor frame for the inductances. The
+ * inverter offset left over from the resistance test lies along the same
+ * d current and is removed too.
+ */
+static void step_flux(motor_id_t *id, const motor_id_input_t *in)
+{
+    float ramp = (float)id->phase_ticks / (float)id->ramp_ticks;
+    id->omega = id->config.spin_speed * ((ramp < 1.0f) ? ramp : 1.0f);
+    advance_angle(id);
+    regulate_currents(id, in, id->config.test_current, 0.0f);
+
+    if (id->phase_ticks <= id->ramp_ticks + id->settle_ticks) {
+        return;
+    }
+
+    id->acc[0] += id->v_d;
+    id->acc[1] += id->v_q;
+    id->acc[2] += in->i_d;
+    id->acc[3] += in->i_q;
+    id->acc_count++;
+
+    if (id->acc_count < 2U * id->measure_ticks) {
+        return;
+    }
+
+    float n = (float)id->acc_count;
+    float v_d = id->acc[0] / n;
+    float v_q = id->acc[1] / n;
+    float i_d = id->acc[2] / n;
+    float i_q = id->acc[3] / n;
+    float rs = id->result.motor.rs;
+    float w = id->omega;
+    float v_offset = id->v_bias - rs * id->i_bias;
+
+    float e_d = v_d - rs * i_d - v_offset + w * id->result.motor.lq * i_q;
+    float e_q = v_q - rs * i_q - w * id->result.motor.ld * i_d;
+    id->result.motor.flux = sqrtf(e_d * e_d + e_q * e_q) / w;
+
+    if (!is_positive_finite(id->result.motor.flux)) {
+        finish(id, MOTOR_ID_STATE_FAULT, MOTOR_ID_FAULT_IMPLAUSIBLE);
+        return;
+    }
+
+    enter_state(id, MOTOR_ID_STATE_SPIN_DOWN);
+}
+
+static void step_spin_down(motor_id_t *id, const motor_id_input_t *in)
+{
+    if (id->step == 0U) {
+        float ramp = 1.0f - (float)id->phase_ticks / (float)id->ramp_ticks;
+        id->omega = id->config.spin_speed * ((ramp > 0.0f) ? ramp : 0.0f);
+        advance_angle(id);
+        regulate_currents(id, in, id->config.test_current, 0.0f);
+
+        if (id->phase_ticks >= id->ramp_ticks) {
+            id->step = 1U;
+            id->phase_ticks = 0;
+        }
+        return;
+    }
+
+    /* Release the rotor and let it come to rest */
+    id->v_d = 0.0f;
+    id->v_q = 0.0f;
+    if (id->phase_ticks < id->coast_ticks) {
+        return;
+    }
+
+    if (!id->config.speed_feedback) {
+        id->result.mechanical_valid = false;
+        finish(id, MOTOR_ID_STATE_DONE, MOTOR_ID_FAULT_NONE);
+        return;
+    }
+
+    pi_reset(&id->pi_d, 0.0f);
+    pi_reset(&id->pi_q, 0.0f);
+    regression_reset(&id->regression);
+    id->angle_source = MOTOR_ID_ANGLE_MEASURED;
+    enter_state(id, MOTOR_ID_STATE_INERTIA_ACCEL);
+}
+
+/* Constant torque acceleration: J * dw/dt = Kt * iq - friction */
+static void step_inertia_accel(motor_id_t *id, const motor_id_input_t *in)
+{
+    regulate_currents(id, in, 0.0f, id->config.test_current);
+    regression_add(&id->regression, (float)id->phase_ticks * id->config.dt, in->omega_mech);
+
+    float speed_limit = 0.8f * id->config.spin_speed / (float)id->config.pole_pairs;
+    if (id->phase_ticks < id->ramp_ticks && fabsf(in->omega_mech) < speed_limit) {
+        return;
+    }
+
+    if (id->regression.n < MOTOR_ID_MIN_SAMPLES) {
+        finish(id, MOTOR_ID_STATE_FAULT, MOTOR_ID_FAULT_IMPLAUSIBLE);
+        return;
+    }
+
+    id->accel_slope = regression_slope(&id->regression);
+    id->omega_peak = fabsf(in->omega_mech);
+    regression_reset(&id->regression);
+    enter_state(id, MOTOR_ID_STATE_INERTIA_COAST);
+}
+
+/* Zero-torque coast: friction alone decelerates, so it cancels out of J */
+static void step_inertia_coast(motor_id_t *id, const motor_id_input_t *in)
+{
+    regulate_currents(id, in, 0.0f, 0.0f);
+    regression_add(&id->regression, (float)id->phase_ticks * id->config.dt, in->omega_mech);
+
+    bool slowed = fabsf(in->omega_mech) < 0.2f * id->omega_peak && id->regression.n >= MOTOR_ID_MIN_SAMPLES;
+    if (id->phase_ticks < id->coast_ticks && !slowed) {
+        return;
+    }
+
+    motor_params_t *motor = &id->result.motor;
+    float kt = 1.5f * (float)id->config.pole_pairs * motor->flux;
+    float decel_slope = regression_slope(&id->regression);
+    float omega_mean = id->regression.mean_y;
+
+    motor->inertia = kt * id->config.test_current / (id->accel_slope - decel_slope);
+    motor->friction = (fabsf(omega_mean) > 1e-3f) ? -motor->inertia * decel_slope / omega_mean : 0.0f;
+
+    if (!is_positive_finite(motor->inertia) || !isfinite(motor->friction)) {
+        finish(id, MOTOR_ID_STATE_FAULT, MOTOR_ID_FAULT_IMPLAUSIBLE);
+        return;
+    }
+
+    tune_speed_loop(id);
+    id->result.mechanical_valid = true;
+    finish(id, MOTOR_ID_STATE_DONE, MOTOR_ID_FAULT_NONE);
+}
+
+void motor_id_config_default(motor_id_config_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    config->dt = 1.0f / (float)CONTROL_PWM_FREQUENCY_HZ;
+    config->pole_pairs = CONTROL_MOTOR_ID_POLE_PAIRS;
+    config->test_current = (float)CONTROL_MOTOR_ID_TEST_CURRENT_MA * 1e-3f;
+    config->max_voltage = (float)CONTROL_MOTOR_ID_MAX_VOLTAGE_MV * 1e-3f;
+    config->trip_current = 2.0f * config->test_current;
+    config->current_bandwidth = MOTOR_ID_TWO_PI * (float)CONTROL_MOTOR_ID_CURRENT_BW_HZ;
+    config->speed_bw_ratio = (float)CONTROL_MOTOR_ID_SPEED_BW_RATIO;
+    config->spin_speed = MOTOR_ID_TWO_PI * (float)CONTROL_MOTOR_ID_SPIN_SPEED_RPM / 60.0f * (float)config->pole_pairs;
+    config->speed_feedback = CONTROL_MOTOR_ID_SPEED_FEEDBACK;
+    config->timeout_ticks = (uint32_t)CONTROL_MOTOR_ID_TIMEOUT_MS * (CONTROL_PWM_FREQUENCY_HZ / 1000U);
+}
+
+motor_id_error_t motor_id_init(motor_id_t *id, const motor_id_config_t *config)
+{
+    if (id == NULL || config == NULL) {
+        return MOTOR_ID_ERROR_INVALID_PARAM;
+    }
+
+    if (!(config->dt > 0.0f) || config->pole_pairs == 0U || !(config->test_current > 0.0f) ||
+        !(config->max_voltage > 0.0f) || !(config->trip_current > config->test_current) ||
+        !(config->current_bandwidth > 0.0f) || !(config->speed_bw_ratio > 1.0f) || !(config->spin_speed > 0.0f)) {
+        return MOTOR_ID_ERROR_INVALID_PARAM;
+    }
+
+    memset(id, 0, sizeof(*id));
+    id->config = *config;
+    id->state = MOTOR_ID_STATE_IDLE;
+    return MOTOR_ID_SUCCESS;
+}
+
+motor_id_error_t motor_id_start(motor_id_t *id)
+{
+    if (id == NULL) {
+        return MOTOR_ID_ERROR_INVALID_PARAM;
+    }
+
+    motor_id_state_t state = id->state;
+    if (state != MOTOR_ID_STATE_IDLE && state != MOTOR_ID_STATE_DONE && state != MOTOR_ID_STATE_ABORTED &&
+        state != MOTOR_ID_STATE_FAULT) {
+        return MOTOR_ID_ERROR_BUSY;
+    }
+
+    memset(&id->result, 0, sizeof(id->result));
+    id->align_ticks = seconds_to_ticks(id, MOTOR_ID_ALIGN_TIME);
+    id->settle_ticks = seconds_to_ticks(id, MOTOR_ID_SETTLE_TIME);
+    id->measure_ticks = seconds_to_ticks(id, MOTOR_ID_MEASURE_TIME);
+    id->pulse_max_ticks = seconds_to_ticks(id, MOTOR_ID_PULSE_MAX_TIME);
+    id->pulse_rest_ticks = seconds_to_ticks(id, MOTOR_ID_PULSE_REST_TIME);
+    id->ramp_ticks = seconds_to_ticks(id, MOTOR_ID_RAMP_TIME);
+    id->coast_ticks = seconds_to_ticks(id, MOTOR_ID_COAST_TIME);
+
+    /* Integral-only loop with a time constant of a tenth of the alignment time */
+    id->ki_align_dt = id->config.max_voltage / (id->config.test_current * 0.1f * MOTOR_ID_ALIGN_TIME) * id->config.dt;
+
+    id->v_d = 0.0f;
+    id->v_q = 0.0f;
+    id->theta = 0.0f;
+    id->omega = 0.0f;
+    id->angle_source = MOTOR_ID_ANGLE_COMMANDED;
+    id->total_ticks = 0;
+    id->fault = MOTOR_ID_FAULT_NONE;
+    id->abort_request = false;
+    enter_state(id, MOTOR_ID_STATE_ALIGN);
+
+    return MOTOR_ID_SUCCESS;
+}
+
+void motor_id_abort(motor_id_t *id)
+{
+    if (id != NULL) {
+        id->abort_request = true;
+    }
+}
+
+void motor_id_step(motor_id_t *id, const motor_id_input_t *in, motor_id_output_t *out)
+{
+    if (id == NULL || in == NULL || out == NULL) {
+        return;
+    }
+
+    motor_id_state_t state = id->state;
+    if (state == MOTOR_ID_STATE_IDLE || state >= MOTOR_ID_STATE_DONE) {
+        out->v_d = 0.0f;
+        out->v_q = 0.0f;
+        out->theta_elec = id->theta;
+        out->angle_source = MOTOR_ID_ANGLE_COMMANDED;
+        return;
+    }
+
+    if (id->abort_request) {
+        finish(id, MOTOR_ID_STATE_ABORTED, MOTOR_ID_FAULT_NONE);
+    } else if (fabsf(in->i_d) > id->config.trip_current || fabsf(in->i_q) > id->config.trip_current) {
+        finish(id, MOTOR_ID_STATE_FAULT, MOTOR_ID_FAULT_OVERCURRENT);
+    } else if (++id->total_ticks > id->config.timeout_ticks) {
+        finish(id, MOTOR_ID_STATE_FAULT, MOTOR_ID_FAULT_TIMEOUT);
+    } else {
+        id->phase_ticks++;
+
+        switch (state) {
+            case MOTOR_ID_STATE_ALIGN: step_align(id, in); break;
+            case MOTOR_ID_STATE_RESISTANCE: step_resistance(id, in); break;
+            case MOTOR_ID_STATE_INDUCTANCE_D: step_inductance_d(id, in); break;
+            case MOTOR_ID_STATE_INDUCTANCE_Q: step_inductance_q(id, in); break;
+            case MOTOR_ID_STATE_FLUX: step_flux(id, in); break;
+            case MOTOR_ID_STATE_SPIN_DOWN: step_spin_down(id, in); break;
+            case MOTOR_ID_STATE_INERTIA_ACCEL: step_inertia_accel(id, in); break;
+            case MOTOR_ID_STATE_INERTIA_COAST: step_inertia_coast(id, in); break;
+            default: break;
+        }
+    }
+
+    out->v_d = id->v_d;
+    out->v_q = id->v_q;
+    out->theta_elec = id->theta;
+    out->angle_source = id->angle_source;
+}
+
+motor_id_state_t motor_id_get_state(const motor_id_t *id)
+{
+    return (id != NULL) ? id->state : MOTOR_ID_STATE_IDLE;
+}
+
+motor_id_fault_t motor_id_get_fault(const motor_id_t *id)
+{
+    return (id != NULL) ? id->fault : MOTOR_ID_FAULT_NONE;
+}
+
+motor_id_error_t motor_id_get_result(const motor_id_t *id, motor_id_result_t *result)
+{
+    if (id == NULL || result == NULL) {
+        return MOTOR_ID_ERROR_INVALID_PARAM;
+    }
+
+    if (id->state != MOTOR_ID_STATE_DONE) {
+        return MOTOR_ID_ERROR_NOT_COMPLETE;
+    }
+
+    *result = id->result;
+    return MOTOR_ID_SUCCESS;
+}
+
+motor_id_error_t motor_id_save(const motor_id_t *id)
+{
+    if (id == NULL) {
+        return MOTOR_ID_ERROR_INVALID_PARAM;
+    }
+
+    if (id->state != MOTOR_ID_STATE_DONE) {
+        return MOTOR_ID_ERROR_NOT_COMPLETE;
+    }
+
+    if (param_store_write(MOTOR_ID_PARAM_KEY, &id->result, sizeof(id->result)) != PARAM_STORE_SUCCESS) {
+        return MOTOR_ID_ERROR_STORAGE;
+    }
+
+    return MOTOR_ID_SUCCESS;
+}
+
+motor_id_error_t motor_id_load(motor_id_result_t *result)
+{
+    if (result == NULL) {
+        return MOTOR_ID_ERROR_INVALID_PARAM;
+    }
+
+    if (param_store_read(MOTOR_ID_PARAM_KEY, result, sizeof(*result)) != PARAM_STORE_SUCCESS) {
+        return MOTOR_ID_ERROR_STORAGE;
+    }
+
+    return MOTOR_ID_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include "control/notch/notch.h"
+#include "control_config.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+#if CONTROL_NOTCH_ENABLE
+
+#define NOTCH_PI 3.14159265359f
+
+static void design_passthrough(float *coeffs)
+{
+    coeffs[0] = 1.0f;
+    coeffs[1] = 0.0f;
+    coeffs[2] = 0.0f;
+    coeffs[3] = 0.0f;
+    coeffs[4] = 0.0f;
+}
+
+/*
+ * Bilinear transform of (s^2 + depth * w/Q s + w^2) / (s^2 + w/Q s + w^2):
+ * unity gain at DC and Nyquist, depth at the centre frequency
+ */
+static void design_notch(float *coeffs, const notch_params_t *params, float sample_rate)
+{
+    float omega = 2.0f * NOTCH_PI * params->frequency / sample_rate;
+    float cos_omega = arm_cos_f32(omega);
+    float alpha = arm_sin_f32(omega) * params->width / (2.0f * params->frequency);
+    float a0 = 1.0f + alpha;
+
+    coeffs[0] = (1.0f + alpha * params->depth) / a0;
+    coeffs[1] = -2.0f * cos_omega / a0;
+    coeffs[2] = (1.0f - alpha * params->depth) / a0;
+    /* CMSIS stores the feedback terms with inverted sign */
+    coeffs[3] = 2.0f * cos_omega / a0;
+    coeffs[4] = -(1.0f - alpha) / a0;
+}
+
+static bool is_valid(const notch_params_t *params, float sample_rate)
+{
+    if (!params->enabled) {
+        return true;
+    }
+
+    return params->frequency > 0.0f && params->frequency < 0.45f * sample_rate && params->width > 0.0f &&
+           params->width < 2.0f * params->frequency && params->depth >= 0.0f && params->depth < 1.0f;
+}
+
+notch_error_t notch_init(notch_filter_t *filter, float sample_rate)
+{
+    if (filter == NULL || sample_rate <= 0.0f) {
+        return NOTCH_ERROR_INVALID_PARAM;
+    }
+
+    memset(filter, 0, sizeof(*filter));
+    filter->sample_rate = sample_rate;
+
+    for (uint8_t stage = 0; stage < NOTCH_MAX_STAGES; stage++) {
+        design_passthrough(&filter->coeffs[0][stage * NOTCH_COEFFS_PER_STAGE]);
+    }
+
+    arm_biquad_cascade_df2T_init_f32(&filter->instance, NOTCH_MAX_STAGES, filter->coeffs[0], filter->state);
+    return NOTCH_SUCCESS;
+}
+
+notch_error_t notch_set(notch_filter_t *filter, uint8_t stage, const notch_params_t *params)
+{
+    if (filter == NULL || params == NULL || stage >= NOTCH_MAX_STAGES || !is_valid(params, filter->sample_rate)) {
+        return NOTCH_ERROR_INVALID_PARAM;
+    }
+
+    filter->params[stage] = *params;
+
+    uint8_t bank = filter->active_bank ^ 1U;
+    float *coeffs = filter->coeffs[bank];
+    for (uint8_t i = 0; i < NOTCH_MAX_STAGES; i++) {
+        float *stage_coeffs = &coeffs[i * NOTCH_COEFFS_PER_STAGE];
+        if (filter->params[i].enabled) {
+            design_notch(stage_coeffs, &filter->params[i], filter->sample_rate);
+        } else {
+            design_passthrough(stage_coeffs);
+        }
+    }
+
+    /* The ISR only ever reads pCoeffs once per call: one word store swaps the whole set */
+    atomic_signal_fence(memory_order_release);
+    filter->instance.pCoeffs = coeffs;
+    filter->active_bank = bank;
+
+    return NOTCH_SUCCESS;
+}
+
+notch_error_t notch_get(const notch_filter_t *filter, uint8_t stage, notch_params_t *params)
+{
+    if (filter == NULL || params == NULL || stage >= NOTCH_MAX_STAGES) {
+        return NOTCH_ERROR_INVALID_PARAM;
+    }
+
+    *params = filter->params[stage];
+    return NOTCH_SUCCESS;
+}
+
+#endif
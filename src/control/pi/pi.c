@@ -0,0 +1,40 @@
+#include "control/pi/pi.h"
+
+#include <stddef.h>
+
+void pi_init(pi_controller_t *pi, const pi_gains_t *gains, float dt, float out_min, float out_max)
+{
+    if (pi == NULL || gains == NULL) {
+        return;
+    }
+
+    pi->out_min = out_min;
+    pi->out_max = out_max;
+    pi_set_gains(pi, gains, dt);
+    pi_reset(pi, 0.0f);
+}
+
+void pi_set_gains(pi_controller_t *pi, const pi_gains_t *gains, float dt)
+{
+    if (pi == NULL || gains == NULL) {
+        return;
+    }
+
+    pi->gains = *gains;
+    pi->ki_dt = gains->ki * dt;
+}
+
+void pi_reset(pi_controller_t *pi, float output)
+{
+    if (pi == NULL) {
+        return;
+    }
+
+    /* Preload the integrator so the first update continues from a known output */
+    if (output > pi->out_max) {
+        output = pi->out_max;
+    } else if (output < pi->out_min) {
+        output = pi->out_min;
+    }
+    pi->integral = output;
+}
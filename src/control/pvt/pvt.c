@@ -0,0 +1,317 @@
+#include "control/pvt/pvt.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#if CONTROL_PVT_ENABLE
+
+_Static_assert((PVT_BUFFER_SIZE & (PVT_BUFFER_SIZE - 1)) == 0, "PVT buffer size must be a power of two");
+
+#define PVT_MASK (PVT_BUFFER_SIZE - 1U)
+#define PVT_RPM_TO_RAD_S (6.28318530718f / 60.0f)
+
+static const pvt_point_t *get_point(const pvt_stream_t *stream, uint32_t index)
+{
+    return &stream->points[index & PVT_MASK];
+}
+
+static float get_duration(const pvt_point_t *from, const pvt_point_t *to)
+{
+    return (float)(to->time_us - from->time_us) * 1e-6f;
+}
+
+/* Hermite cubic from a position and velocity to another over duration */
+static void fit_segment(pvt_stream_t *stream, float position, float start_velocity, float end_position,
+                        float end_velocity, float duration)
+{
+    float slope = (end_position - position) / duration;
+    stream->coeffs[0] = position;
+    stream->coeffs[1] = start_velocity;
+    stream->coeffs[2] = (3.0f * slope - 2.0f * start_velocity - end_velocity) / duration;
+    stream->coeffs[3] = (start_velocity + end_velocity - 2.0f * slope) / (duration * duration);
+    stream->segment_duration = duration;
+    stream->end_velocity = end_velocity;
+}
+
+/* PT mode: central difference at the point after the tail; the caller guarantees the one after it is present */
+static float estimate_velocity(const pvt_stream_t *stream)
+{
+    const pvt_point_t *p0 = get_point(stream, stream->tail);
+    const pvt_point_t *p1 = get_point(stream, stream->tail + 1U);
+    const pvt_point_t *p2 = get_point(stream, stream->tail + 2U);
+    return (p2->position - p0->position) / (get_duration(p0, p1) + get_duration(p1, p2));
+}
+
+/* Segment from the point at the tail to the next one; the caller guarantees both are present */
+static void load_segment(pvt_stream_t *stream, uint32_t count, float start_velocity)
+{
+    const pvt_point_t *p0 = get_point(stream, stream->tail);
+    const pvt_point_t *p1 = get_point(stream, stream->tail + 1U);
+
+    float end_velocity = p1->velocity;
+    stream->end_provisional = false;
+    if (stream->config.mode == PVT_MODE_PT) {
+        /* Until the following point is known the segment ends at rest; refine_segment() corrects that */
+        end_velocity = (count >= 3U) ? estimate_velocity(stream) : 0.0f;
+        stream->end_provisional = count < 3U;
+    }
+
+    fit_segment(stream, p0->position, start_velocity, p1->position, end_velocity, get_duration(p0, p1));
+}
+
+/*
+ * PT mode: the point after the segment end arrived while the segment runs.
+ * Refit the rest of the segment from the present position and velocity to
+ * the estimated end velocity, so playback does not stop at the end point.
+ */
+static void refine_segment(pvt_stream_t *stream)
+{
+    const float *c = stream->coeffs;
+    float t = stream->segment_time;
+    float position = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+    float velocity = c[1] + t * (2.0f * c[2] + 3.0f * t * c[3]);
+
+    fit_segment(stream, position, velocity, get_point(stream, stream->tail + 1U)->position, estimate_velocity(stream),
+                stream->segment_duration - t);
+    stream->segment_time = 0.0f;
+    stream->end_provisional = false;
+}
+
+static void evaluate_segment(pvt_stream_t *stream)
+{
+    const float *c = stream->coeffs;
+    float t = stream->segment_time;
+    float lead = stream->config.lead;
+
+    float position = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+    float velocity = c[1] + t * (2.0f * c[2] + 3.0f * t * c[3]);
+    float acceleration = 2.0f * c[2] + 6.0f * t * c[3];
+
+    /* Second-order extrapolation by the lead time compensates the delay of the loops downstream */
+    stream->output.position = position + lead * (velocity + 0.5f * lead * acceleration);
+    stream->output.velocity = velocity + lead * acceleration;
+    stream->output.acceleration = acceleration;
+}
+
+/* Constant deceleration from the last output until standstill */
+static void brake(pvt_stream_t *stream)
+{
+    pvt_setpoint_t *out = &stream->output;
+    float dt = stream->config.dt;
+    float decel = stream->config.underrun_decel;
+
+    if (out->velocity == 0.0f) {
+        out->acceleration = 0.0f;
+        return;
+    }
+
+    float sign = (out->velocity > 0.0f) ? 1.0f : -1.0f;
+    float speed = fabsf(out->velocity);
+    if (speed <= decel * dt) {
+        out->position += sign * speed * speed / (2.0f * decel);
+        out->velocity = 0.0f;
+        out->acceleration = 0.0f;
+        return;
+    }
+
+    out->position += sign * dt * (speed - 0.5f * decel * dt);
+    out->velocity = sign * (speed - decel * dt);
+    out->acceleration = -sign * decel;
+}
+
+/* Past the last buffered point: stop on it if the stream ends at rest, otherwise brake */
+static void finish_stream(pvt_stream_t *stream)
+{
+    if (stream->end_velocity == 0.0f) {
+        stream->output.position = get_point(stream, stream->tail + 1U)->position;
+        stream->output.velocity = 0.0f;
+        stream->output.acceleration = 0.0f;
+        stream->state = PVT_STATE_FINISHED;
+        return;
+    }
+
+    stream->segment_time = stream->segment_duration;
+    evaluate_segment(stream);
+    stream->underruns = stream->underruns + 1U;
+    stream->state = PVT_STATE_UNDERRUN;
+    brake(stream);
+}
+
+/* Playback starts once the buffered points span the start delay, or the buffer is full */
+static bool start_playback(pvt_stream_t *stream, uint32_t count)
+{
+    if (count < 2U) {
+        return false;
+    }
+
+    const pvt_point_t *first = get_point(stream, stream->tail);
+    const pvt_point_t *last = get_point(stream, stream->tail + count - 1U);
+    if (count < PVT_BUFFER_SIZE && last->time_us - first->time_us < stream->config.start_delay_us) {
+        return false;
+    }
+
+    float start_velocity = (stream->config.mode == PVT_MODE_PT) ? 0.0f : first->velocity;
+    load_segment(stream, count, start_velocity);
+    stream->segment_time = 0.0f;
+    return true;
+}
+
+/* Move to the next segment; false when the buffer holds no complete segment */
+static bool next_segment(pvt_stream_t *stream, uint32_t count)
+{
+    if (count < 3U) {
+        return false;
+    }
+
+    stream->segment_time -= stream->segment_duration;
+    /* The ISR no longer reads the old start point: hand its slot back to the producer */
+    atomic_signal_fence(memory_order_release);
+    stream->tail = stream->tail + 1U;
+    load_segment(stream, count - 1U, stream->end_velocity);
+    return true;
+}
+
+void pvt_config_default(pvt_config_t *config, float dt)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    config->dt = dt;
+    config->mode = PVT_MODE_PVT;
+    config->start_delay_us = CONTROL_PVT_START_DELAY_US;
+    config->lead = (float)CONTROL_PVT_LEAD_US * 1e-6f;
+    config->underrun_decel = (float)CONTROL_PVT_UNDERRUN_DECEL_RPM_S * PVT_RPM_TO_RAD_S;
+}
+
+pvt_error_t pvt_init(pvt_stream_t *stream, const pvt_config_t *config, float position)
+{
+    if (stream == NULL || config == NULL || config->dt <= 0.0f || config->lead < 0.0f ||
+        config->underrun_decel <= 0.0f) {
+        return PVT_ERROR_INVALID_PARAM;
+    }
+
+    stream->config = *config;
+    stream->head = 0U;
+    stream->tail = 0U;
+    stream->has_last = false;
+    stream->state = PVT_STATE_IDLE;
+    stream->underruns = 0U;
+    stream->segment_time = 0.0f;
+    stream->segment_duration = 0.0f;
+    stream->end_velocity = 0.0f;
+    stream->end_provisional = false;
+    stream->output.position = position;
+    stream->output.velocity = 0.0f;
+    stream->output.acceleration = 0.0f;
+
+    return PVT_SUCCESS;
+}
+
+pvt_error_t pvt_start(pvt_stream_t *stream)
+{
+    if (stream == NULL) {
+        return PVT_ERROR_INVALID_PARAM;
+    }
+
+    pvt_state_t state = stream->state;
+    if (state == PVT_STATE_FILLING || state == PVT_STATE_RUNNING ||
+        (state == PVT_STATE_UNDERRUN && stream->output.velocity != 0.0f)) {
+        return PVT_ERROR_INVALID_STATE;
+    }
+
+    /* Park the ISR in IDLE, where it touches neither the ring nor the segment */
+    stream->state = PVT_STATE_IDLE;
+    atomic_signal_fence(memory_order_seq_cst);
+
+    stream->tail = stream->head;
+    stream->has_last = false;
+
+    atomic_signal_fence(memory_order_seq_cst);
+    stream->state = PVT_STATE_FILLING;
+
+    return PVT_SUCCESS;
+}
+
+pvt_error_t pvt_push(pvt_stream_t *stream, const pvt_point_t *point)
+{
+    if (stream == NULL || point == NULL || !isfinite(point->position) || !isfinite(point->velocity)) {
+        return PVT_ERROR_INVALID_PARAM;
+    }
+
+    pvt_state_t state = stream->state;
+    if (state != PVT_STATE_FILLING && state != PVT_STATE_RUNNING) {
+        return PVT_ERROR_INVALID_STATE;
+    }
+
+    if (stream->has_last && (int32_t)(point->time_us - stream->last_time_us) <= 0) {
+        return PVT_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t head = stream->head;
+    if (head - stream->tail >= PVT_BUFFER_SIZE) {
+        return PVT_ERROR_BUFFER_FULL;
+    }
+
+    stream->points[head & PVT_MASK] = *point;
+    stream->last_time_us = point->time_us;
+    stream->has_last = true;
+
+    /* Point must be in the ring before the ISR can see the new head */
+    atomic_signal_fence(memory_order_release);
+    stream->head = head + 1U;
+
+    return PVT_SUCCESS;
+}
+
+uint32_t pvt_get_free(const pvt_stream_t *stream)
+{
+    if (stream == NULL) {
+        return 0U;
+    }
+    return PVT_BUFFER_SIZE - (stream->head - stream->tail);
+}
+
+pvt_state_t pvt_get_state(const pvt_stream_t *stream)
+{
+    return (stream != NULL) ? stream->state : PVT_STATE_IDLE;
+}
+
+void pvt_evaluate(pvt_stream_t *stream, pvt_setpoint_t *setpoint)
+{
+    uint32_t count = stream->head - stream->tail;
+    atomic_signal_fence(memory_order_acquire);
+
+    switch (stream->state) {
+        case PVT_STATE_FILLING:
+            if (!start_playback(stream, count)) {
+                break;
+            }
+            stream->state = PVT_STATE_RUNNING;
+            /* fall through */
+        case PVT_STATE_RUNNING:
+            while (stream->segment_time >= stream->segment_duration && next_segment(stream, count)) {
+                count--;
+            }
+            if (stream->end_provisional && count >= 3U && stream->segment_time < stream->segment_duration) {
+                refine_segment(stream);
+            }
+            if (stream->segment_time >= stream->segment_duration) {
+                finish_stream(stream);
+                break;
+            }
+            evaluate_segment(stream);
+            stream->segment_time += stream->config.dt;
+            break;
+        case PVT_STATE_UNDERRUN:
+            brake(stream);
+            break;
+        default:
+            break;
+    }
+
+    *setpoint = stream->output;
+}
+
+#endif
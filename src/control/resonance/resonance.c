@@ -0,0 +1,154 @@
+#include "control/resonance/resonance.h"
+#include "control_config.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+#if CONTROL_RESONANCE_DETECT_ENABLE
+
+#define RESONANCE_TWO_PI 6.28318530718f
+#define RESONANCE_BINS (RESONANCE_FFT_SIZE / 2U)
+
+void resonance_config_default(resonance_config_t *config, float sample_rate)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    config->sample_rate = sample_rate;
+    config->f_min = (float)CONTROL_RESONANCE_MIN_HZ;
+    config->f_max = 0.4f * sample_rate;
+    config->threshold = powf(10.0f, (float)CONTROL_RESONANCE_THRESHOLD_DB / 20.0f);
+}
+
+resonance_error_t resonance_init(resonance_detector_t *detector, const resonance_config_t *config)
+{
+    if (detector == NULL || config == NULL || config->sample_rate <= 0.0f || config->f_min <= 0.0f ||
+        config->f_max <= config->f_min || config->f_max > 0.5f * config->sample_rate || config->threshold <= 1.0f) {
+        return RESONANCE_ERROR_INVALID_PARAM;
+    }
+
+    memset(detector, 0, sizeof(*detector));
+    detector->config = *config;
+
+    if (arm_rfft_fast_init_f32(&detector->fft, RESONANCE_FFT_SIZE) != ARM_MATH_SUCCESS) {
+        return RESONANCE_ERROR_INVALID_PARAM;
+    }
+
+    return RESONANCE_SUCCESS;
+}
+
+static void apply_window(float *samples)
+{
+    float mean = 0.0f;
+    for (uint32_t i = 0; i < RESONANCE_FFT_SIZE; i++) {
+        mean += samples[i];
+    }
+    mean /= (float)RESONANCE_FFT_SIZE;
+
+    /* Remove DC and taper with a Hann window to limit leakage from the setpoint response */
+    for (uint32_t i = 0; i < RESONANCE_FFT_SIZE; i++) {
+        float window = 0.5f - 0.5f * arm_cos_f32(RESONANCE_TWO_PI * (float)i / (float)RESONANCE_FFT_SIZE);
+        samples[i] = (samples[i] - mean) * window;
+    }
+}
+
+static void insert_peak(resonance_detector_t *detector, float frequency, float ratio)
+{
+    uint8_t position = detector->peak_count;
+
+    while (position > 0U && detector->peaks[position - 1U].ratio < ratio) {
+        if (position < RESONANCE_MAX_PEAKS) {
+            detector->peaks[position] = detector->peaks[position - 1U];
+        }
+        position--;
+    }
+
+    if (position < RESONANCE_MAX_PEAKS) {
+        detector->peaks[position].frequency = frequency;
+        detector->peaks[position].ratio = ratio;
+        if (detector->peak_count < RESONANCE_MAX_PEAKS) {
+            detector->peak_count++;
+        }
+    }
+}
+
+static void find_peaks(resonance_detector_t *detector, const float *magnitude)
+{
+    float bin_width = detector->config.sample_rate / (float)RESONANCE_FFT_SIZE;
+    uint32_t first = (uint32_t)ceilf(detector->config.f_min / bin_width);
+    uint32_t last = (uint32_t)(detector->config.f_max / bin_width);
+
+    if (first < 1U) {
+        first = 1U;
+    }
+    if (last > RESONANCE_BINS - 2U) {
+        last = RESONANCE_BINS - 2U;
+    }
+
+    detector->peak_count = 0;
+    if (last <= first) {
+        return;
+    }
+
+    float mean = 0.0f;
+    for (uint32_t bin = first; bin <= last; bin++) {
+        mean += magnitude[bin];
+    }
+    mean /= (float)(last - first + 1U);
+    if (mean <= 0.0f) {
+        return;
+    }
+
+    float limit = mean * detector->config.threshold;
+    for (uint32_t bin = first; bin <= last; bin++) {
+        float peak = magnitude[bin];
+        if (peak < limit || peak < magnitude[bin - 1U] || peak <= magnitude[bin + 1U]) {
+            continue;
+        }
+
+        /* Parabolic interpolation on the log magnitude; Hann keeps the error under a tenth of a bin */
+        float left = logf(magnitude[bin - 1U] + 1e-20f);
+        float centre = logf(peak);
+        float right = logf(magnitude[bin + 1U] + 1e-20f);
+        float curvature = left - 2.0f * centre + right;
+        float offset = (curvature < 0.0f) ? 0.5f * (left - right) / curvature : 0.0f;
+
+        insert_peak(detector, ((float)bin + offset) * bin_width, peak / mean);
+    }
+}
+
+bool resonance_process(resonance_detector_t *detector)
+{
+    if (detector == NULL || !detector->ready) {
+        return false;
+    }
+
+    atomic_signal_fence(memory_order_acquire);
+
+    apply_window(detector->capture);
+    arm_rfft_fast_f32(&detector->fft, detector->capture, detector->spectrum, 0);
+
+    /* Bin 0 packs DC and Nyquist; both are outside the search band */
+    detector->spectrum[1] = 0.0f;
+    arm_cmplx_mag_f32(detector->spectrum, detector->capture, RESONANCE_BINS);
+    find_peaks(detector, detector->capture);
+
+    atomic_signal_fence(memory_order_release);
+    detector->ready = false;
+    return true;
+}
+
+uint8_t resonance_get_peaks(const resonance_detector_t *detector, const resonance_peak_t **peaks)
+{
+    if (detector == NULL || peaks == NULL) {
+        return 0;
+    }
+
+    *peaks = detector->peaks;
+    return detector->peak_count;
+}
+
+#endif
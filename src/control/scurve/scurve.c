@@ -0,0 +1,268 @@
+#include "control/scurve/scurve.h"
+#include "control_config.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#if CONTROL_SCURVE_ENABLE
+
+#define SCURVE_RPM_TO_RAD_S (6.28318530718f / 60.0f)
+
+/* Close to the target the cruise speed falls off linearly, reaching it in about this many ticks */
+#define SCURVE_LINEAR_TICKS 2.0f
+
+/*
+ * Stopping distances are planned this much longer, relative, to absorb the float rounding of
+ * the velocity over a long move; the shortfall is closed by the linear approach
+ */
+#define SCURVE_STOP_MARGIN 1e-4f
+
+static float clampf(float value, float low, float high)
+{
+    if (value > high) {
+        return high;
+    }
+    if (value < low) {
+        return low;
+    }
+    return value;
+}
+
+static bool limits_valid(const scurve_limits_t *limits)
+{
+    return limits->velocity > 0.0f && limits->acceleration > 0.0f && limits->jerk > 0.0f;
+}
+
+/* Distance of a jerk-limited stop from speed v >= 0 at zero acceleration */
+static float rest_stopping_distance(float v, const scurve_limits_t *limits)
+{
+    float a_max = limits->acceleration;
+    float j_max = limits->jerk;
+
+    if (v * j_max < a_max * a_max) {
+        /* Triangular deceleration, peak sqrt(v * J) */
+        return v * sqrtf(v / j_max);
+    }
+    return 0.5f * v * (v / a_max + a_max / j_max);
+}
+
+/* Distance of the time-optimal jerk-limited stop from speed v > 0 and acceleration a */
+static float stopping_distance(float v, float a, const scurve_limits_t *limits)
+{
+    float j_max = limits->jerk;
+
+    if (a >= 0.0f) {
+        /* Acceleration is ramped out first, gaining a^2 / 2J of speed */
+        float t = a / j_max;
+        return t * (v + a * t / 3.0f) + rest_stopping_distance(v + 0.5f * a * t, limits);
+    }
+
+    /* Already braking: continue the profile that started from a = 0 at speed v0 */
+    float t0 = -a / j_max;
+    float v0 = v - 0.5f * a * t0;
+    float peak = fminf(limits->acceleration, sqrtf(v0 * j_max));
+    if (-a <= peak) {
+        return rest_stopping_distance(v0, limits) - t0 * (v0 - j_max * t0 * t0 / 6.0f);
+    }
+
+    /* Braking harder than needed: release at full jerk; speed reaches zero before acceleration does */
+    float discriminant = a * a - 2.0f * j_max * v;
+    if (discriminant < 0.0f) {
+        return t0 * (v + a * t0 / 3.0f) + rest_stopping_distance(v - 0.5f * a * a / j_max, limits);
+    }
+    float t = (-a - sqrtf(discriminant)) / j_max;
+    return t * (v + t * (0.5f * a + j_max * t / 6.0f));
+}
+
+/*
+ * Jerk that drives the velocity to v_goal in minimum time. The switching curve
+ * v + a|a|/2J = v_goal is solved for the acceleration that lands exactly on it
+ * at the end of the tick, so the law follows the curve without chattering.
+ */
+static float velocity_jerk(const scurve_setpoint_t *state, float v_goal, const scurve_limits_t *limits, float dt)
+{
+    float j_dt = limits->jerk * dt;
+    float excess = state->velocity + 0.5f * dt * state->acceleration - v_goal;
+    float a_next = 0.5f * (sqrtf(j_dt * j_dt + 8.0f * limits->jerk * fabsf(excess)) - j_dt);
+    if (excess > 0.0f) {
+        a_next = -a_next;
+    }
+
+    a_next = clampf(a_next, -limits->acceleration, limits->acceleration);
+    return clampf((a_next - state->acceleration) / dt, -limits->jerk, limits->jerk);
+}
+
+/* Distance left over after one tick at the given jerk followed by the optimal stop */
+static float braking_slack(const scurve_setpoint_t *state, float jerk, float remaining, const scurve_limits_t *limits,
+                           float dt)
+{
+    float position = dt * (state->velocity + dt * (0.5f * state->acceleration + dt * jerk / 6.0f));
+    float velocity = state->velocity + dt * (state->acceleration + 0.5f * dt * jerk);
+    float acceleration = state->acceleration + dt * jerk;
+
+    if (velocity <= 0.0f) {
+        return remaining - position;
+    }
+    return remaining - position - (1.0f + SCURVE_STOP_MARGIN) * stopping_distance(velocity, acceleration, limits);
+}
+
+/*
+ * Compensated sum: the rounding of each addition is kept in error_carry, so
+ * thousands of ticks of motion do not drift the profile off its stop.
+ */
+static void accumulate_error(scurve_t *scurve, float delta)
+{
+    float sum = scurve->error + delta;
+    if (fabsf(scurve->error) >= fabsf(delta)) {
+        scurve->error_carry += (scurve->error - sum) + delta;
+    } else {
+        scurve->error_carry += (delta - sum) + scurve->error;
+    }
+    scurve->error = sum;
+}
+
+void scurve_limits_default(scurve_limits_t *limits)
+{
+    if (limits == NULL) {
+        return;
+    }
+
+    limits->velocity = (float)CONTROL_SCURVE_VELOCITY_RPM * SCURVE_RPM_TO_RAD_S;
+    limits->acceleration = (float)CONTROL_SCURVE_ACCELERATION_RPM_S * SCURVE_RPM_TO_RAD_S;
+    limits->jerk = (float)CONTROL_SCURVE_JERK_RPM_S2 * SCURVE_RPM_TO_RAD_S;
+}
+
+scurve_error_t scurve_init(scurve_t *scurve, const scurve_limits_t *limits, float dt, float position)
+{
+    if (scurve == NULL || limits == NULL || dt <= 0.0f || !limits_valid(limits)) {
+        return SCURVE_ERROR_INVALID_PARAM;
+    }
+
+    scurve->dt = dt;
+    scurve->state.position = position;
+    scurve->error = 0.0f;
+    scurve->error_carry = 0.0f;
+    scurve->state.velocity = 0.0f;
+    scurve->state.acceleration = 0.0f;
+    scurve->command.target = position;
+    scurve->command.limits = *limits;
+    scurve->pending = scurve->command;
+    scurve->pending_sequence = 0;
+    scurve->latched_sequence = 0;
+    scurve->settled = true;
+
+    return SCURVE_SUCCESS;
+}
+
+scurve_error_t scurve_set_command(scurve_t *scurve, float target, const scurve_limits_t *limits)
+{
+    if (scurve == NULL || limits == NULL || !limits_valid(limits) || !isfinite(target)) {
+        return SCURVE_ERROR_INVALID_PARAM;
+    }
+
+    /* Odd sequence marks the pending command as being written; the ISR never latches it then */
+    uint32_t sequence = scurve->pending_sequence;
+    scurve->pending_sequence = sequence + 1U;
+    atomic_signal_fence(memory_order_seq_cst);
+
+    scurve->pending.target = target;
+    scurve->pending.limits = *limits;
+
+    atomic_signal_fence(memory_order_seq_cst);
+    scurve->pending_sequence = sequence + 2U;
+
+    return SCURVE_SUCCESS;
+}
+
+scurve_error_t scurve_set_target(scurve_t *scurve, float target)
+{
+    if (scurve == NULL) {
+        return SCURVE_ERROR_INVALID_PARAM;
+    }
+
+    scurve_limits_t limits = scurve->pending.limits;
+    return scurve_set_command(scurve, target, &limits);
+}
+
+void scurve_step(scurve_t *scurve, scurve_setpoint_t *setpoint)
+{
+    uint32_t sequence = scurve->pending_sequence;
+    if (sequence != scurve->latched_sequence && (sequence & 1U) == 0U) {
+        atomic_signal_fence(memory_order_acquire);
+        /* Difference of the targets first: exact when they are within a factor of two */
+        accumulate_error(scurve, scurve->command.target - scurve->pending.target);
+        scurve->command = scurve->pending;
+        scurve->latched_sequence = sequence;
+        scurve->settled = false;
+    }
+
+    const scurve_limits_t *limits = &scurve->command.limits;
+    scurve_setpoint_t *state = &scurve->state;
+    float dt = scurve->dt;
+    float j_max = limits->jerk;
+
+    /*
+     * Within one tick of jerk of rest on the target: finish exactly there.
+     * The distance is also allowed what the target's float resolution hides.
+     */
+    float distance = -(scurve->error + scurve->error_carry);
+    float resolution = fmaxf(j_max * dt * dt * dt, FLT_EPSILON * fabsf(scurve->command.target));
+    if (fabsf(distance) <= resolution && fabsf(state->velocity) <= j_max * dt * dt &&
+        fabsf(state->acceleration) <= j_max * dt) {
+        state->position = scurve->command.target;
+        state->velocity = 0.0f;
+        state->acceleration = 0.0f;
+        scurve->error = 0.0f;
+        scurve->error_carry = 0.0f;
+        scurve->settled = true;
+        *setpoint = *state;
+        return;
+    }
+
+    /* Mirror so that the target lies in the positive direction */
+    float sign = (distance < 0.0f) ? -1.0f : 1.0f;
+    float remaining = fabsf(distance);
+    scurve_setpoint_t mirrored = {
+        .velocity = sign * state->velocity,
+        .acceleration = sign * state->acceleration,
+    };
+
+    /* Cruise towards the target, or linearly approach it when close */
+    float v_cruise = fminf(limits->velocity, remaining / (SCURVE_LINEAR_TICKS * dt));
+    float jerk = velocity_jerk(&mirrored, v_cruise, limits, dt);
+
+    /*
+     * Brake once cruising for another tick would leave too little distance for
+     * the stop. Interpolating between the slack left by the cruise and the
+     * braking jerk removes the one-tick quantisation of the braking point.
+     */
+    float slack_cruise = braking_slack(&mirrored, jerk, remaining, limits, dt);
+    if (slack_cruise < 0.0f) {
+        float brake = velocity_jerk(&mirrored, 0.0f, limits, dt);
+        float slack_brake = braking_slack(&mirrored, brake, remaining, limits, dt);
+        float weight = 1.0f;
+        if (slack_brake > slack_cruise) {
+            weight = clampf(slack_cruise / (slack_cruise - slack_brake), 0.0f, 1.0f);
+        }
+        jerk += weight * (brake - jerk);
+    }
+
+    jerk *= sign;
+
+    /* Exact integration of constant jerk over the tick */
+    accumulate_error(scurve, dt * (state->velocity + dt * (0.5f * state->acceleration + dt * jerk / 6.0f)));
+    state->velocity += dt * (state->acceleration + 0.5f * dt * jerk);
+    state->acceleration += dt * jerk;
+    state->position = scurve->command.target + (scurve->error + scurve->error_carry);
+
+    *setpoint = *state;
+}
+
+bool scurve_is_settled(const scurve_t *scurve)
+{
+    return (scurve != NULL) ? scurve->settled : true;
+}
+
+#endif
@@ -0,0 +1,192 @@
+#include "control/speed_loop/speed_loop.h"
+#include "control_config.h"
+
+#include <math.h>
+#include <stddef.h>
+
+/* Retuning moves a notch this fraction of the way to a peak it already covers */
+#define SPEED_LOOP_RETUNE_GAIN 0.5f
+
+/* A stage locks once a retune moves it by less than this fraction of its width */
+#define SPEED_LOOP_LOCK_FRACTION 0.05f
+
+speed_loop_error_t speed_loop_init(speed_loop_t *loop, const pi_gains_t *gains, float sample_rate,
+                                   float current_limit)
+{
+    if (loop == NULL || gains == NULL || sample_rate <= 0.0f || current_limit <= 0.0f) {
+        return SPEED_LOOP_ERROR_INVALID_PARAM;
+    }
+
+    loop->sample_rate = sample_rate;
+    pi_init(&loop->pi, gains, 1.0f / sample_rate, -current_limit, current_limit);
+
+#if CONTROL_NOTCH_ENABLE
+    if (notch_init(&loop->notch, sample_rate) != NOTCH_SUCCESS) {
+        return SPEED_LOOP_ERROR_INVALID_PARAM;
+    }
+    loop->notch_width_ratio = (float)CONTROL_NOTCH_WIDTH_PERCENT / 100.0f;
+    loop->notch_depth = powf(10.0f, -(float)CONTROL_NOTCH_DEPTH_DB / 20.0f);
+#endif
+
+#if CONTROL_RESONANCE_DETECT_ENABLE
+    resonance_config_t config;
+    resonance_config_default(&config, sample_rate);
+    if (resonance_init(&loop->resonance, &config) != RESONANCE_SUCCESS) {
+        return SPEED_LOOP_ERROR_INVALID_PARAM;
+    }
+    for (uint8_t stage = 0; stage < NOTCH_MAX_STAGES; stage++) {
+        loop->notch_locked[stage] = false;
+    }
+    loop->adaptive = true;
+#endif
+
+    return SPEED_LOOP_SUCCESS;
+}
+
+speed_loop_error_t speed_loop_set_gains(speed_loop_t *loop, const pi_gains_t *gains)
+{
+    if (loop == NULL || gains == NULL) {
+        return SPEED_LOOP_ERROR_INVALID_PARAM;
+    }
+
+    pi_set_gains(&loop->pi, gains, 1.0f / loop->sample_rate);
+    return SPEED_LOOP_SUCCESS;
+}
+
+void speed_loop_reset(speed_loop_t *loop, float current)
+{
+    if (loop != NULL) {
+        pi_reset(&loop->pi, current);
+    }
+}
+
+void speed_loop_set_adaptive(speed_loop_t *loop, bool enable)
+{
+#if CONTROL_RESONANCE_DETECT_ENABLE
+    if (loop != NULL) {
+        loop->adaptive = enable;
+    }
+#else
+    (void)loop;
+    (void)enable;
+#endif
+}
+
+#if CONTROL_RESONANCE_DETECT_ENABLE
+/* Enabled stage nearest to frequency, -1 if none. With matched, only unlocked stages not matched this capture */
+static int nearest_stage(const speed_loop_t *loop, float frequency, const bool *matched, notch_params_t *nearest)
+{
+    int stage_found = -1;
+
+    for (uint8_t stage = 0; stage < NOTCH_MAX_STAGES; stage++) {
+        notch_params_t params;
+        notch_get(&loop->notch, stage, &params);
+
+        if (!params.enabled || (matched != NULL && (loop->notch_locked[stage] || matched[stage]))) {
+            continue;
+        }
+        if (stage_found < 0 || fabsf(params.frequency - frequency) < fabsf(nearest->frequency - frequency)) {
+            stage_found = stage;
+            *nearest = params;
+        }
+    }
+    return stage_found;
+}
+
+static void place_notch(speed_loop_t *loop, uint8_t stage, float frequency)
+{
+    notch_params_t params = {
+        .enabled = true,
+        .frequency = frequency,
+        .width = loop->notch_width_ratio * frequency,
+        .depth = loop->notch_depth,
+    };
+    notch_set(&loop->notch, stage, &params);
+}
+
+/*
+ * A notch that already sits on a resonance suppresses it, so a peak close to
+ * an active notch means the notch is off-centre and is pulled towards it; the
+ * stage locks once the pull is small. Returns false if no notch covers the peak.
+ */
+static bool retune_notch(speed_loop_t *loop, float frequency, bool *matched)
+{
+    notch_params_t nearest;
+    int stage = nearest_stage(loop, frequency, NULL, &nearest);
+
+    if (stage < 0 || fabsf(nearest.frequency - frequency) >= 0.5f * nearest.width) {
+        return false;
+    }
+
+    float step = SPEED_LOOP_RETUNE_GAIN * (frequency - nearest.frequency);
+    if (fabsf(step) < SPEED_LOOP_LOCK_FRACTION * nearest.width) {
+        loop->notch_locked[stage] = true;
+    }
+    place_notch(loop, (uint8_t)stage, nearest.frequency + step);
+    matched[stage] = true;
+    return true;
+}
+
+/*
+ * A new peak takes a free stage, else the nearest stage that has not locked
+ * and has no peak of its own in this capture. Locked stages are never taken:
+ * a notch hides its own resonance, so two resonances sharing one stage would
+ * otherwise hand it back and forth.
+ */
+static void place_new_notch(speed_loop_t *loop, float frequency, bool *matched)
+{
+    int stage = -1;
+
+    for (uint8_t free_stage = 0; free_stage < NOTCH_MAX_STAGES && stage < 0; free_stage++) {
+        notch_params_t params;
+        notch_get(&loop->notch, free_stage, &params);
+        if (!params.enabled) {
+            stage = free_stage;
+        }
+    }
+    if (stage < 0) {
+        notch_params_t nearest;
+        stage = nearest_stage(loop, frequency, matched, &nearest);
+    }
+
+    if (stage >= 0) {
+        loop->notch_locked[stage] = false;
+        place_notch(loop, (uint8_t)stage, frequency);
+        matched[stage] = true;
+    }
+}
+#endif
+
+void speed_loop_process(speed_loop_t *loop)
+{
+#if CONTROL_RESONANCE_DETECT_ENABLE
+    if (loop == NULL || !resonance_process(&loop->resonance)) {
+        return;
+    }
+
+    const resonance_peak_t *peaks;
+    uint8_t count = resonance_get_peaks(&loop->resonance, &peaks);
+    bool matched[NOTCH_MAX_STAGES] = {false};
+    bool covered[RESONANCE_MAX_PEAKS];
+    for (uint8_t i = 0; i < count; i++) {
+        covered[i] = retune_notch(loop, peaks[i].frequency, matched);
+    }
+
+    /* A stage placed before this capture and without a peak now has suppressed its resonance */
+    for (uint8_t stage = 0; stage < NOTCH_MAX_STAGES; stage++) {
+        notch_params_t params;
+        notch_get(&loop->notch, stage, &params);
+        if (params.enabled && !matched[stage]) {
+            loop->notch_locked[stage] = true;
+        }
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (!covered[i]) {
+            place_new_notch(loop, peaks[i].frequency, matched);
+        }
+    }
+#else
+    (void)loop;
+#endif
+}
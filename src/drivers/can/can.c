@@ -0,0 +1,127 @@
+#include "drivers/can/can.h"
+#include "driver_config.h"
+
+#include <string.h>
+
+#if DRIVER_CAN_ENABLE
+
+static void can_dispatch(uint8_t filter_index, const board_can_rx_frame_t *frame, void *context)
+{
+    can_t *can = (can_t *)context;
+
+    can->rx_count = can->rx_count + 1U;
+    if (filter_index < can->subscription_count) {
+        const can_subscription_t *subscription = &can->subscriptions[filter_index];
+        subscription->handler(frame, subscription->context);
+    }
+}
+
+void can_bitrate_default(board_can_bitrate_t *bitrate)
+{
+    if (bitrate == NULL) {
+        return;
+    }
+
+    bitrate->nominal_bitrate = DRIVER_CAN_NOMINAL_BITRATE;
+#if DRIVER_CAN_FD_ENABLE
+    bitrate->data_bitrate = DRIVER_CAN_DATA_BITRATE;
+#else
+    bitrate->data_bitrate = 0U;
+#endif
+}
+
+can_error_t can_init(can_t *can, const struct board_can_config_t *hw_config, const board_can_bitrate_t *bitrate)
+{
+    if (can == NULL || hw_config == NULL || bitrate == NULL || bitrate->nominal_bitrate == 0U) {
+        return CAN_ERROR_INVALID_PARAM;
+    }
+
+    memset(can, 0, sizeof(*can));
+    can->hw_config = hw_config;
+    can->bitrate = *bitrate;
+
+    return CAN_SUCCESS;
+}
+
+can_error_t can_subscribe(can_t *can, uint32_t id, uint32_t mask, uint8_t flags, can_handler_t handler,
+                          void *context)
+{
+    if (can == NULL || handler == NULL) {
+        return CAN_ERROR_INVALID_PARAM;
+    }
+
+    if (can->hw_config == NULL) {
+        return CAN_ERROR_NOT_INITIALIZED;
+    }
+
+    if (can->started) {
+        return CAN_ERROR_STARTED;
+    }
+
+    if (can->subscription_count >= CAN_MAX_HANDLERS) {
+        return CAN_ERROR_NO_SPACE;
+    }
+
+    uint8_t index = can->subscription_count;
+    can->filters[index].id = id;
+    can->filters[index].mask = mask;
+    can->filters[index].extended = (flags & CAN_FLAG_EXTENDED) != 0U;
+    can->subscriptions[index].handler = handler;
+    can->subscriptions[index].context = context;
+    can->subscription_count = index + 1U;
+
+    return CAN_SUCCESS;
+}
+
+can_error_t can_start(can_t *can)
+{
+    if (can == NULL) {
+        return CAN_ERROR_INVALID_PARAM;
+    }
+
+    if (can->hw_config == NULL) {
+        return CAN_ERROR_NOT_INITIALIZED;
+    }
+
+    if (can->started) {
+        return CAN_ERROR_STARTED;
+    }
+
+    if (!board_can_init(can->hw_config, &can->bitrate, can->filters, can->subscription_count, can_dispatch, can)) {
+        return CAN_ERROR_HARDWARE;
+    }
+
+    can->started = true;
+    return CAN_SUCCESS;
+}
+
+can_error_t can_send(can_t *can, uint32_t id, uint8_t flags, const void *data, uint8_t length)
+{
+    if (can == NULL || (data == NULL && length > 0U) || length > BOARD_CAN_MAX_DATA) {
+        return CAN_ERROR_INVALID_PARAM;
+    }
+
+    /* FD frames need the controller in FD mode, which a data bit rate enables */
+    bool fd = (flags & CAN_FLAG_FD) != 0U;
+    if ((!fd && length > 8U) || (fd && can->bitrate.data_bitrate == 0U)) {
+        return CAN_ERROR_INVALID_PARAM;
+    }
+
+    if (!can->started) {
+        return CAN_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!board_can_transmit(can->hw_config, id, flags, data, length)) {
+        can->tx_dropped = can->tx_dropped + 1U;
+        return CAN_ERROR_BUFFER_FULL;
+    }
+
+    return CAN_SUCCESS;
+}
+
+bool can_is_bus_off(const can_t *can)
+{
+    return can != NULL && can->started && board_can_is_bus_off(can->hw_config);
+}
+
+#endif
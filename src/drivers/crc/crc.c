@@ -0,0 +1,242 @@
+#include "drivers/crc/crc.h"
+#include "driver_config.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#if DRIVER_CRC_ENABLE
+
+/* Host builds define CRC_SOFTWARE_ONLY to compile without the board layer */
+#if DRIVER_CRC_HARDWARE && !defined(CRC_SOFTWARE_ONLY)
+#include "boards/crc.h"
+#define CRC_USE_HARDWARE 1
+#define CRC_USE_DMA DRIVER_CRC_DMA
+#else
+#define CRC_USE_HARDWARE 0
+#define CRC_USE_DMA 0
+#endif
+
+/* Below this the register setup costs more than the table */
+#define CRC_HARDWARE_MIN_LENGTH 16U
+/* Words per DMA transfer, within the 16-bit transfer counter */
+#define CRC_DMA_CHUNK_WORDS 0x8000U
+
+const crc_params_t crc_params_crc32 = {
+    .polynomial = 0x04C11DB7U, .init = 0xFFFFFFFFU, .xor_out = 0xFFFFFFFFU,
+    .width = 32U, .reflect_in = true, .reflect_out = true,
+};
+
+const crc_params_t crc_params_crc16_ccitt = {
+    .polynomial = 0x1021U, .init = 0xFFFFU, .xor_out = 0x0000U,
+    .width = 16U, .reflect_in = false, .reflect_out = false,
+};
+
+const crc_params_t crc_params_crc16_modbus = {
+    .polynomial = 0x8005U, .init = 0xFFFFU, .xor_out = 0x0000U,
+    .width = 16U, .reflect_in = true, .reflect_out = true,
+};
+
+#if CRC_USE_HARDWARE
+static atomic_flag hardware_busy = ATOMIC_FLAG_INIT;
+static bool hardware_ready;
+
+static bool acquire_hardware(void)
+{
+    return !atomic_flag_test_and_set_explicit(&hardware_busy, memory_order_acquire);
+}
+
+static void release_hardware(void)
+{
+    atomic_flag_clear_explicit(&hardware_busy, memory_order_release);
+}
+#endif
+
+static uint32_t reflect(uint32_t value, uint8_t width)
+{
+    value = ((value >> 1) & 0x55555555U) | ((value & 0x55555555U) << 1);
+    value = ((value >> 2) & 0x33333333U) | ((value & 0x33333333U) << 2);
+    value = ((value >> 4) & 0x0F0F0F0FU) | ((value & 0x0F0F0F0FU) << 4);
+    value = ((value >> 8) & 0x00FF00FFU) | ((value & 0x00FF00FFU) << 8);
+    value = (value >> 16) | (value << 16);
+    return value >> (32U - width);
+}
+
+/*
+ * The running state is always the register of the unreflected algorithm,
+ * right aligned, which is what the CRC unit holds. Reflected algorithms run
+ * the reflected table on the reflected register and convert at the ends.
+ */
+static uint32_t update_software(const crc_t *crc, uint32_t state, const uint8_t *data, size_t length)
+{
+    uint8_t width = crc->params->width;
+
+    if (crc->params->reflect_in) {
+        uint32_t reg = reflect(state, width);
+        for (size_t i = 0U; i < length; i++) {
+            reg = (reg >> 8) ^ crc->table[(reg ^ data[i]) & 0xFFU];
+        }
+        return reflect(reg, width);
+    }
+
+    uint32_t reg = state << (32U - width);
+    for (size_t i = 0U; i < length; i++) {
+        reg = (reg << 8) ^ crc->table[(reg >> 24) ^ data[i]];
+    }
+    return reg >> (32U - width);
+}
+
+crc_error_t crc_init(crc_t *crc, const crc_params_t *params)
+{
+    if (crc == NULL || params == NULL || (params->width != 8U && params->width != 16U && params->width != 32U)) {
+        return CRC_ERROR_INVALID_PARAM;
+    }
+
+    crc->params = params;
+    crc->mask = (params->width == 32U) ? 0xFFFFFFFFU : ((1U << params->width) - 1U);
+
+    if (params->reflect_in) {
+        uint32_t polynomial = reflect(params->polynomial, params->width);
+        for (uint32_t i = 0U; i < 256U; i++) {
+            uint32_t reg = i;
+            for (int bit = 0; bit < 8; bit++) {
+                reg = (reg >> 1) ^ (polynomial & (0U - (reg & 1U)));
+            }
+            crc->table[i] = reg;
+        }
+    } else {
+        uint32_t polynomial = params->polynomial << (32U - params->width);
+        for (uint32_t i = 0U; i < 256U; i++) {
+            uint32_t reg = i << 24;
+            for (int bit = 0; bit < 8; bit++) {
+                reg = (reg << 1) ^ (polynomial & (0U - (reg >> 31)));
+            }
+            crc->table[i] = reg;
+        }
+    }
+
+#if CRC_USE_HARDWARE
+    if (!hardware_ready) {
+        board_crc_init();
+        hardware_ready = true;
+    }
+#endif
+
+    return CRC_SUCCESS;
+}
+
+uint32_t crc_begin(const crc_t *crc)
+{
+    return crc->params->init & crc->mask;
+}
+
+uint32_t crc_update(const crc_t *crc, uint32_t state, const void *data, size_t length)
+{
+#if CRC_USE_HARDWARE
+    if (length >= CRC_HARDWARE_MIN_LENGTH && acquire_hardware()) {
+        board_crc_configure(crc->params->polynomial, crc->params->width, crc->params->reflect_in, state);
+        board_crc_feed(data, length);
+        state = board_crc_read() & crc->mask;
+        release_hardware();
+        return state;
+    }
+#endif
+
+    return update_software(crc, state, data, length);
+}
+
+uint32_t crc_finish(const crc_t *crc, uint32_t state)
+{
+    if (crc->params->reflect_out) {
+        state = reflect(state, crc->params->width);
+    }
+    return (state ^ crc->params->xor_out) & crc->mask;
+}
+
+uint32_t crc_compute(const crc_t *crc, const void *data, size_t length)
+{
+    return crc_finish(crc, crc_update(crc, crc_begin(crc), data, length));
+}
+
+#if CRC_USE_DMA
+static void start_dma_chunk(crc_block_t *block)
+{
+    size_t words = block->remaining / 4U;
+    if (words > CRC_DMA_CHUNK_WORDS) {
+        words = CRC_DMA_CHUNK_WORDS;
+    }
+
+    if (words > 0U && board_crc_feed_dma_start((const uint32_t *)(const void *)block->next, words)) {
+        block->next += words * 4U;
+        block->remaining -= words * 4U;
+    } else {
+        /* Ragged tail, or the DMA refused: finish on the CPU */
+        board_crc_feed(block->next, block->remaining);
+        block->next += block->remaining;
+        block->remaining = 0U;
+    }
+}
+#endif
+
+crc_error_t crc_block_start(const crc_t *crc, crc_block_t *block, const void *data, size_t length)
+{
+    if (crc == NULL || block == NULL || (data == NULL && length > 0U)) {
+        return CRC_ERROR_INVALID_PARAM;
+    }
+
+    block->crc = crc;
+    block->next = data;
+    block->remaining = length;
+    block->state = crc_begin(crc);
+    block->hardware = false;
+
+#if CRC_USE_DMA
+    /* The unit cannot byte-swap DMA words, so plain algorithms use the CPU path below */
+    if (crc->params->reflect_in && acquire_hardware()) {
+        block->hardware = true;
+        board_crc_configure(crc->params->polynomial, crc->params->width, true, block->state);
+
+        size_t head = (4U - ((uintptr_t)block->next & 3U)) & 3U;
+        if (head > block->remaining) {
+            head = block->remaining;
+        }
+        board_crc_feed(block->next, head);
+        block->next += head;
+        block->remaining -= head;
+
+        start_dma_chunk(block);
+        return CRC_SUCCESS;
+    }
+#endif
+
+    block->state = crc_update(crc, block->state, block->next, block->remaining);
+    block->next += block->remaining;
+    block->remaining = 0U;
+
+    return CRC_SUCCESS;
+}
+
+bool crc_block_poll(crc_block_t *block, uint32_t *result)
+{
+#if CRC_USE_DMA
+    if (block->hardware) {
+        if (board_crc_feed_dma_busy()) {
+            return false;
+        }
+        if (block->remaining > 0U) {
+            start_dma_chunk(block);
+            return false;
+        }
+
+        block->state = board_crc_read() & block->crc->mask;
+        block->hardware = false;
+        release_hardware();
+    }
+#endif
+
+    if (result != NULL) {
+        *result = crc_finish(block->crc, block->state);
+    }
+    return true;
+}
+
+#endif
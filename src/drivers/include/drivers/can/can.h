@@ -0,0 +1,84 @@
+#ifndef DRIVERS_CAN_H
+#define DRIVERS_CAN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "boards/can.h"
+#include "driver_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if DRIVER_CAN_ENABLE
+#define CAN_MAX_HANDLERS DRIVER_CAN_MAX_HANDLERS
+#else
+#define CAN_MAX_HANDLERS 1
+#endif
+
+#define CAN_FLAG_EXTENDED BOARD_CAN_FLAG_EXTENDED
+#define CAN_FLAG_FD BOARD_CAN_FLAG_FD
+#define CAN_FLAG_BRS BOARD_CAN_FLAG_BRS
+
+typedef enum {
+    CAN_SUCCESS = 0,
+    CAN_ERROR_INVALID_PARAM,
+    CAN_ERROR_NOT_INITIALIZED,
+    CAN_ERROR_HARDWARE,
+    CAN_ERROR_BUFFER_FULL,
+    CAN_ERROR_NO_SPACE,
+    CAN_ERROR_STARTED
+} can_error_t;
+
+typedef board_can_rx_frame_t can_frame_t;
+
+/* Runs in the CAN interrupt; frame->data is only valid until it returns */
+typedef void (*can_handler_t)(const can_frame_t *frame, void *context);
+
+typedef struct {
+    can_handler_t handler;
+    void *context;
+} can_subscription_t;
+
+/*
+ * Every subscription becomes one hardware acceptance filter, and the filter
+ * index the controller reports with each frame selects the handler directly:
+ * frames for other nodes never reach the CPU and dispatch needs no search.
+ */
+typedef struct {
+    const struct board_can_config_t *hw_config;
+    board_can_bitrate_t bitrate;
+    board_can_filter_t filters[CAN_MAX_HANDLERS];
+    can_subscription_t subscriptions[CAN_MAX_HANDLERS];
+    uint8_t subscription_count;
+    bool started;
+    volatile uint32_t rx_count;
+    volatile uint32_t tx_dropped;
+} can_t;
+
+/* Fill bit rates from the Kconfig defaults */
+void can_bitrate_default(board_can_bitrate_t *bitrate);
+
+can_error_t can_init(can_t *can, const struct board_can_config_t *hw_config, const board_can_bitrate_t *bitrate);
+
+/* Before can_start() only: filters are fixed while the controller is on the bus */
+can_error_t can_subscribe(can_t *can, uint32_t id, uint32_t mask, uint8_t flags, can_handler_t handler,
+                          void *context);
+
+can_error_t can_start(can_t *can);
+
+/*
+ * Queue a frame without blocking; CAN_ERROR_BUFFER_FULL when the hardware
+ * FIFO is full. Safe from both the control ISR and the background.
+ */
+can_error_t can_send(can_t *can, uint32_t id, uint8_t flags, const void *data, uint8_t length);
+
+bool can_is_bus_off(const can_t *can);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
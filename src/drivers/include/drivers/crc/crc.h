@@ -0,0 +1,73 @@
+#ifndef DRIVERS_CRC_H
+#define DRIVERS_CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CRC_SUCCESS = 0,
+    CRC_ERROR_INVALID_PARAM,
+    CRC_ERROR_BUSY
+} crc_error_t;
+
+/* Rocksoft model parameters; widths 8, 16 and 32 */
+typedef struct {
+    uint32_t polynomial; /* without the top bit, not reflected */
+    uint32_t init;
+    uint32_t xor_out;
+    uint8_t width;
+    bool reflect_in;
+    bool reflect_out;
+} crc_params_t;
+
+extern const crc_params_t crc_params_crc32;        /* IEEE 802.3, zlib */
+extern const crc_params_t crc_params_crc16_ccitt;  /* CRC-16/CCITT-FALSE, for serial framing */
+extern const crc_params_t crc_params_crc16_modbus; /* CRC-16/MODBUS */
+
+/*
+ * One algorithm. Calculations use the CRC unit when it is free and fall back
+ * to the byte table otherwise, so any context may compute at any time and
+ * both paths give identical results. On the host only the table is used.
+ */
+typedef struct {
+    const crc_params_t *params;
+    uint32_t mask;
+    uint32_t table[256];
+} crc_t;
+
+/* Large block calculation running in the background */
+typedef struct {
+    const crc_t *crc;
+    const uint8_t *next;
+    size_t remaining;
+    uint32_t state;
+    bool hardware;
+} crc_block_t;
+
+crc_error_t crc_init(crc_t *crc, const crc_params_t *params);
+
+/* Incremental calculation: crc_finish(crc, crc_update(crc, crc_begin(crc), data, length)) */
+uint32_t crc_begin(const crc_t *crc);
+uint32_t crc_update(const crc_t *crc, uint32_t state, const void *data, size_t length);
+uint32_t crc_finish(const crc_t *crc, uint32_t state);
+
+uint32_t crc_compute(const crc_t *crc, const void *data, size_t length);
+
+/*
+ * Background context: checksum a large block, e.g. a firmware image, with
+ * the CRC unit fed by DMA while the CPU does other work. Poll until it
+ * returns true. Meanwhile other users of the unit fall back to the table.
+ */
+crc_error_t crc_block_start(const crc_t *crc, crc_block_t *block, const void *data, size_t length);
+bool crc_block_poll(crc_block_t *block, uint32_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef DRIVERS_PARAM_STORE_H
+#define DRIVERS_PARAM_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PARAM_STORE_SUCCESS = 0,
+    PARAM_STORE_ERROR_INVALID_PARAM,
+    PARAM_STORE_ERROR_NOT_INITIALIZED,
+    PARAM_STORE_ERROR_NOT_FOUND,
+    PARAM_STORE_ERROR_NO_SPACE,
+    PARAM_STORE_ERROR_FLASH
+} param_store_error_t;
+
+/* Keys are chosen by the owning module; 0xFFFF is reserved for erased flash */
+#define PARAM_STORE_KEY_INVALID 0xFFFFU
+
+/*
+ * Records are appended to one of two flash banks; the newest record of a key
+ * wins. When the active bank is full, the latest record of every key is copied
+ * into the other bank before it is activated, so a power loss during a write
+ * never loses previously stored values.
+ *
+ * Writes erase and program flash and stall the CPU for milliseconds: call from
+ * background context only, never from an ISR.
+ */
+param_store_error_t param_store_init(void);
+param_store_error_t param_store_read(uint16_t key, void *data, size_t size);
+param_store_error_t param_store_write(uint16_t key, const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
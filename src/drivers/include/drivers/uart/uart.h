@@ -0,0 +1,78 @@
+#ifndef DRIVERS_UART_H
+#define DRIVERS_UART_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "driver_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if DRIVER_UART_ENABLE
+#define UART_TX_BUFFER_SIZE DRIVER_UART_TX_BUFFER_SIZE
+#define UART_RX_BUFFER_SIZE DRIVER_UART_RX_BUFFER_SIZE
+#define UART_RX_CONTIGUOUS_SIZE DRIVER_UART_RX_CONTIGUOUS_SIZE
+#else
+#define UART_TX_BUFFER_SIZE 1
+#define UART_RX_BUFFER_SIZE 1
+#define UART_RX_CONTIGUOUS_SIZE 0
+#endif
+
+struct board_uart_config_t;
+
+typedef enum {
+    UART_SUCCESS = 0,
+    UART_ERROR_INVALID_PARAM,
+    UART_ERROR_NOT_INITIALIZED,
+    UART_ERROR_HARDWARE,
+    UART_ERROR_BUFFER_FULL
+} uart_error_t;
+
+typedef struct {
+    const struct board_uart_config_t *hw_config;
+    uint8_t tx_buffer[UART_TX_BUFFER_SIZE];
+    volatile uint16_t tx_head; /* written by uart_write() only */
+    volatile uint16_t tx_tail; /* written by the UART interrupt only */
+    /* Receive ring, followed by room to unwrap data that crosses its end */
+    uint8_t rx_buffer[UART_RX_BUFFER_SIZE + UART_RX_CONTIGUOUS_SIZE];
+    volatile uint16_t rx_head; /* written by the UART interrupt only */
+    volatile uint16_t rx_tail; /* written by the reader only */
+    volatile uint32_t rx_dropped;
+} uart_t;
+
+uart_error_t uart_init(uart_t *uart, const struct board_uart_config_t *hw_config, uint32_t baudrate);
+
+/*
+ * Queue data for interrupt-driven transmission without blocking. Either the
+ * whole block is queued or nothing is (UART_ERROR_BUFFER_FULL), so framed
+ * output is never split. Single producer: call from one context only.
+ */
+uart_error_t uart_write(uart_t *uart, const void *data, size_t size);
+size_t uart_get_tx_free(const uart_t *uart);
+
+/*
+ * Zero-copy reception, single consumer. Received bytes stay in the ring and
+ * belong to the reader until uart_rx_consume() hands them back, so they may
+ * be parsed, and even rewritten, in place.
+ */
+size_t uart_rx_available(const uart_t *uart);
+
+/* Contiguous received bytes starting offset bytes past the read position; their count in *length */
+const uint8_t *uart_rx_span(const uart_t *uart, size_t offset, size_t *length);
+
+/*
+ * The first length received bytes as one writable block, moving the part
+ * past the end of the ring into the room behind it if needed. NULL when
+ * fewer bytes are available or length exceeds UART_RX_CONTIGUOUS_SIZE.
+ */
+uint8_t *uart_rx_contiguous(uart_t *uart, size_t length);
+
+void uart_rx_consume(uart_t *uart, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
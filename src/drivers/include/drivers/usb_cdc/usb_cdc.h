@@ -0,0 +1,109 @@
+#ifndef DRIVERS_USB_CDC_H
+#define DRIVERS_USB_CDC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "driver_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if DRIVER_USB_CDC_ENABLE
+#define USB_CDC_TX_BUFFER_SIZE DRIVER_USB_CDC_TX_BUFFER_SIZE
+#define USB_CDC_RX_BUFFER_SIZE DRIVER_USB_CDC_RX_BUFFER_SIZE
+#define USB_CDC_RX_CONTIGUOUS_SIZE DRIVER_USB_CDC_RX_CONTIGUOUS_SIZE
+#else
+#define USB_CDC_TX_BUFFER_SIZE 1
+#define USB_CDC_RX_BUFFER_SIZE 1
+#define USB_CDC_RX_CONTIGUOUS_SIZE 0
+#endif
+
+#define USB_CDC_PACKET_SIZE 64U
+#define USB_CDC_CONTROL_SIZE 64U
+
+typedef enum {
+    USB_CDC_SUCCESS = 0,
+    USB_CDC_ERROR_INVALID_PARAM,
+    USB_CDC_ERROR_NOT_INITIALIZED,
+    USB_CDC_ERROR_HARDWARE,
+    USB_CDC_ERROR_BUFFER_FULL,
+    USB_CDC_ERROR_NOT_CONNECTED
+} usb_cdc_error_t;
+
+/* SET_LINE_CODING as sent by the host; only reported, the data rate is the bus rate */
+typedef struct {
+    uint32_t baudrate;
+    uint8_t stop_bits;
+    uint8_t parity;
+    uint8_t data_bits;
+} usb_cdc_line_coding_t;
+
+/* Endpoint 0 transfer in progress */
+typedef struct {
+    uint8_t request[8];
+    const uint8_t *data;  /* IN data stage still to send, NULL when there is none */
+    uint16_t remaining;
+    bool zero_length;     /* the IN data stage ends with a zero-length packet */
+    uint16_t out_length;  /* OUT data stage bytes expected */
+    uint16_t out_received;
+    uint8_t address;      /* from SET_ADDRESS, applied after the status stage */
+    uint8_t buffer[USB_CDC_CONTROL_SIZE]; /* OUT data stage, and replies built on the fly */
+} usb_cdc_control_t;
+
+/*
+ * USB CDC-ACM device: a virtual serial port with a bulk endpoint in each
+ * direction, both double buffered. Packets are copied between the endpoint
+ * buffers and the rings by the USB interrupt, so a stream written to the
+ * transmit ring needs no further work from the writer. Same ring semantics
+ * as uart_t.
+ */
+typedef struct {
+    usb_cdc_control_t control;
+    usb_cdc_line_coding_t line_coding;
+    uint8_t configuration;
+    uint8_t control_lines; /* SET_CONTROL_LINE_STATE: bit 0 DTR, bit 1 RTS */
+    bool initialized;
+    bool endpoints_open;   /* since the last bus reset */
+    bool suspended;
+    uint8_t tx_buffer[USB_CDC_TX_BUFFER_SIZE];
+    volatile uint16_t tx_head; /* written by usb_cdc_write() only */
+    volatile uint16_t tx_tail; /* written by the USB interrupt only */
+    bool tx_zero_length;       /* last packet was full: end the transfer when the ring runs dry */
+    /* Receive ring, followed by room to unwrap data that crosses its end */
+    uint8_t rx_buffer[USB_CDC_RX_BUFFER_SIZE + USB_CDC_RX_CONTIGUOUS_SIZE];
+    volatile uint16_t rx_head; /* written by the USB interrupt only */
+    volatile uint16_t rx_tail; /* written by the reader only */
+    volatile bool rx_waiting;  /* a packet waits in the endpoint for room in the ring */
+} usb_cdc_t;
+
+/* Attach to the bus; enumeration and everything after runs in the USB interrupt */
+usb_cdc_error_t usb_cdc_init(usb_cdc_t *cdc);
+
+/* Configured by the host with the port open (DTR set) */
+bool usb_cdc_is_connected(const usb_cdc_t *cdc);
+
+/*
+ * Queue data without blocking, whole or not at all (USB_CDC_ERROR_BUFFER_FULL).
+ * USB_CDC_ERROR_NOT_CONNECTED while no host has the port open, so telemetry
+ * is dropped instead of going stale in the ring. Single producer.
+ */
+usb_cdc_error_t usb_cdc_write(usb_cdc_t *cdc, const void *data, size_t size);
+size_t usb_cdc_get_tx_free(const usb_cdc_t *cdc);
+
+/*
+ * Zero-copy reception, single consumer, as uart_rx_*(). The host is held
+ * off with NAKs while the ring is full: nothing received is dropped.
+ */
+size_t usb_cdc_rx_available(const usb_cdc_t *cdc);
+const uint8_t *usb_cdc_rx_span(const usb_cdc_t *cdc, size_t offset, size_t *length);
+uint8_t *usb_cdc_rx_contiguous(usb_cdc_t *cdc, size_t length);
+void usb_cdc_rx_consume(usb_cdc_t *cdc, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
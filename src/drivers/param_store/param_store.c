@@ -0,0 +1,263 @@
+#include "drivers/param_store/param_store.h"
+#include "drivers/crc/crc.h"
+#include "boards/flash.h"
+#include "driver_config.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#if DRIVER_PARAM_STORE_ENABLE
+
+#define PARAM_STORE_MAGIC 0x31524150U /* "PAR1" */
+#define PARAM_STORE_ALIGN(x) (((x) + BOARD_FLASH_PROGRAM_UNIT - 1U) & ~(BOARD_FLASH_PROGRAM_UNIT - 1U))
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+} bank_header_t;
+
+typedef struct {
+    uint16_t key;
+    uint16_t length;
+    uint32_t crc;
+} record_header_t;
+
+_Static_assert(sizeof(bank_header_t) == BOARD_FLASH_PROGRAM_UNIT, "bank header must be one program unit");
+_Static_assert(sizeof(record_header_t) == BOARD_FLASH_PROGRAM_UNIT, "record header must be one program unit");
+
+static uint32_t bank_base[2];
+static uint32_t bank_size;
+static int active_bank = -1;
+static uint32_t write_offset;
+static crc_t record_crc32;
+
+static uint32_t record_crc(uint16_t key, const void *data, uint16_t length)
+{
+    uint32_t state = crc_begin(&record_crc32);
+    state = crc_update(&record_crc32, state, &key, sizeof(key));
+    state = crc_update(&record_crc32, state, &length, sizeof(length));
+    state = crc_update(&record_crc32, state, data, length);
+    return crc_finish(&record_crc32, state);
+}
+
+static const bank_header_t *get_bank_header(int bank)
+{
+    return (const bank_header_t *)bank_base[bank];
+}
+
+static const record_header_t *get_record(int bank, uint32_t offset)
+{
+    return (const record_header_t *)(bank_base[bank] + offset);
+}
+
+static uint32_t get_record_size(uint16_t length)
+{
+    return (uint32_t)sizeof(record_header_t) + PARAM_STORE_ALIGN((uint32_t)length);
+}
+
+static bool is_record_valid(const record_header_t *record)
+{
+    return record->crc == record_crc(record->key, record + 1, record->length);
+}
+
+/* Offset of the first erased record slot, i.e. where the next append goes */
+static uint32_t find_bank_end(int bank)
+{
+    uint32_t offset = sizeof(bank_header_t);
+
+    while (offset + sizeof(record_header_t) <= bank_size) {
+        const record_header_t *record = get_record(bank, offset);
+        if (record->key == PARAM_STORE_KEY_INVALID) {
+            break;
+        }
+
+        uint32_t next = offset + get_record_size(record->length);
+        if (next > bank_size) {
+            break;
+        }
+        offset = next;
+    }
+
+    return offset;
+}
+
+static const record_header_t *find_latest_record(int bank, uint16_t key, uint32_t end)
+{
+    const record_header_t *latest = NULL;
+
+    for (uint32_t offset = sizeof(bank_header_t); offset < end;) {
+        const record_header_t *record = get_record(bank, offset);
+        if (record->key == key && is_record_valid(record)) {
+            latest = record;
+        }
+        offset += get_record_size(record->length);
+    }
+
+    return latest;
+}
+
+/* Header first: a record torn by power loss fails its CRC and is skipped */
+static bool program_record(int bank, uint32_t offset, uint16_t key, const void *data, uint16_t length)
+{
+    record_header_t header = {
+        .key = key,
+        .length = length,
+        .crc = record_crc(key, data, length),
+    };
+    uint32_t address = bank_base[bank] + offset;
+
+    if (!board_flash_program(address, &header, sizeof(header))) {
+        return false;
+    }
+    address += sizeof(header);
+
+    uint32_t body = length & ~(BOARD_FLASH_PROGRAM_UNIT - 1U);
+    if (body > 0U && !board_flash_program(address, data, body)) {
+        return false;
+    }
+
+    uint32_t tail = length - body;
+    if (tail > 0U) {
+        uint8_t padded[BOARD_FLASH_PROGRAM_UNIT];
+        memset(padded, 0xFF, sizeof(padded));
+        memcpy(padded, (const uint8_t *)data + body, tail);
+        if (!board_flash_program(address + body, padded, sizeof(padded))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Copy the live record set plus the new record into the other bank, header last */
+static param_store_error_t compact_and_write(uint16_t key, const void *data, uint16_t length)
+{
+    int target = active_bank ^ 1;
+    uint32_t offset = sizeof(bank_header_t);
+
+    if (!board_flash_erase(bank_base[target], bank_size)) {
+        return PARAM_STORE_ERROR_FLASH;
+    }
+
+    for (uint32_t source = sizeof(bank_header_t); source < write_offset;) {
+        const record_header_t *record = get_record(active_bank, source);
+        source += get_record_size(record->length);
+
+        if (record->key == key || find_latest_record(active_bank, record->key, write_offset) != record) {
+            continue;
+        }
+
+        if (offset + get_record_size(record->length) > bank_size) {
+            return PARAM_STORE_ERROR_NO_SPACE;
+        }
+        if (!program_record(target, offset, record->key, record + 1, record->length)) {
+            return PARAM_STORE_ERROR_FLASH;
+        }
+        offset += get_record_size(record->length);
+    }
+
+    if (offset + get_record_size(length) > bank_size) {
+        return PARAM_STORE_ERROR_NO_SPACE;
+    }
+    if (!program_record(target, offset, key, data, length)) {
+        return PARAM_STORE_ERROR_FLASH;
+    }
+    offset += get_record_size(length);
+
+    bank_header_t header = {
+        .magic = PARAM_STORE_MAGIC,
+        .sequence = get_bank_header(active_bank)->sequence + 1U,
+    };
+    if (!board_flash_program(bank_base[target], &header, sizeof(header))) {
+        return PARAM_STORE_ERROR_FLASH;
+    }
+
+    active_bank = target;
+    write_offset = offset;
+    return PARAM_STORE_SUCCESS;
+}
+
+param_store_error_t param_store_init(void)
+{
+    const board_flash_region_t *region = board_flash_get_param_region();
+    if (region == NULL || region->page_size == 0U || region->size < 2U * region->page_size) {
+        return PARAM_STORE_ERROR_INVALID_PARAM;
+    }
+
+    if (crc_init(&record_crc32, &crc_params_crc32) != CRC_SUCCESS) {
+        return PARAM_STORE_ERROR_INVALID_PARAM;
+    }
+
+    bank_size = region->size / 2U;
+    bank_base[0] = region->start;
+    bank_base[1] = region->start + bank_size;
+    active_bank = -1;
+
+    for (int bank = 0; bank < 2; bank++) {
+        if (get_bank_header(bank)->magic != PARAM_STORE_MAGIC) {
+            continue;
+        }
+        if (active_bank < 0 ||
+            (int32_t)(get_bank_header(bank)->sequence - get_bank_header(active_bank)->sequence) > 0) {
+            active_bank = bank;
+        }
+    }
+
+    if (active_bank < 0) {
+        bank_header_t header = {.magic = PARAM_STORE_MAGIC, .sequence = 0U};
+        if (!board_flash_erase(bank_base[0], bank_size) ||
+            !board_flash_program(bank_base[0], &header, sizeof(header))) {
+            return PARAM_STORE_ERROR_FLASH;
+        }
+        active_bank = 0;
+    }
+
+    write_offset = find_bank_end(active_bank);
+    return PARAM_STORE_SUCCESS;
+}
+
+param_store_error_t param_store_read(uint16_t key, void *data, size_t size)
+{
+    if (data == NULL || key == PARAM_STORE_KEY_INVALID) {
+        return PARAM_STORE_ERROR_INVALID_PARAM;
+    }
+
+    if (active_bank < 0) {
+        return PARAM_STORE_ERROR_NOT_INITIALIZED;
+    }
+
+    const record_header_t *record = find_latest_record(active_bank, key, write_offset);
+    /* A size mismatch means the owner's layout changed; treat the record as absent */
+    if (record == NULL || record->length != size) {
+        return PARAM_STORE_ERROR_NOT_FOUND;
+    }
+
+    memcpy(data, record + 1, size);
+    return PARAM_STORE_SUCCESS;
+}
+
+param_store_error_t param_store_write(uint16_t key, const void *data, size_t size)
+{
+    if (data == NULL || key == PARAM_STORE_KEY_INVALID || size == 0U || size > UINT16_MAX) {
+        return PARAM_STORE_ERROR_INVALID_PARAM;
+    }
+
+    if (active_bank < 0) {
+        return PARAM_STORE_ERROR_NOT_INITIALIZED;
+    }
+
+    uint32_t record_size = get_record_size((uint16_t)size);
+    if (record_size > bank_size - sizeof(bank_header_t)) {
+        return PARAM_STORE_ERROR_NO_SPACE;
+    }
+
+    if (write_offset + record_size <= bank_size &&
+        program_record(active_bank, write_offset, key, data, (uint16_t)size)) {
+        write_offset += record_size;
+        return PARAM_STORE_SUCCESS;
+    }
+
+    return compact_and_write(key, data, (uint16_t)size);
+}
+
+#endif
@@ -0,0 +1,164 @@
+#include "drivers/uart/uart.h"
+#include "boards/uart.h"
+#include "driver_config.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#if DRIVER_UART_ENABLE
+
+_Static_assert((UART_TX_BUFFER_SIZE & (UART_TX_BUFFER_SIZE - 1)) == 0, "TX buffer size must be a power of two");
+_Static_assert(UART_TX_BUFFER_SIZE <= 32768, "TX buffer indices are 16 bit");
+_Static_assert((UART_RX_BUFFER_SIZE & (UART_RX_BUFFER_SIZE - 1)) == 0, "RX buffer size must be a power of two");
+_Static_assert(UART_RX_BUFFER_SIZE <= 32768, "RX buffer indices are 16 bit");
+_Static_assert(UART_RX_CONTIGUOUS_SIZE <= UART_RX_BUFFER_SIZE, "contiguous reads cannot exceed the ring");
+
+#define UART_TX_MASK (UART_TX_BUFFER_SIZE - 1U)
+#define UART_RX_MASK (UART_RX_BUFFER_SIZE - 1U)
+
+static int uart_tx_next(void *context)
+{
+    uart_t *uart = (uart_t *)context;
+    uint16_t tail = uart->tx_tail;
+
+    if (tail == uart->tx_head) {
+        return -1;
+    }
+
+    uint8_t byte = uart->tx_buffer[tail & UART_TX_MASK];
+    uart->tx_tail = (uint16_t)(tail + 1U);
+    return byte;
+}
+
+static void uart_rx_byte(uint8_t byte, void *context)
+{
+    uart_t *uart = (uart_t *)context;
+    uint16_t head = uart->rx_head;
+
+    if ((uint16_t)(head - uart->rx_tail) >= UART_RX_BUFFER_SIZE) {
+        uart->rx_dropped++;
+        return;
+    }
+
+    uart->rx_buffer[head & UART_RX_MASK] = byte;
+    atomic_signal_fence(memory_order_release);
+    uart->rx_head = (uint16_t)(head + 1U);
+}
+
+uart_error_t uart_init(uart_t *uart, const struct board_uart_config_t *hw_config, uint32_t baudrate)
+{
+    if (uart == NULL || hw_config == NULL || baudrate == 0U) {
+        return UART_ERROR_INVALID_PARAM;
+    }
+
+    uart->hw_config = hw_config;
+    uart->tx_head = 0;
+    uart->tx_tail = 0;
+    uart->rx_head = 0;
+    uart->rx_tail = 0;
+    uart->rx_dropped = 0;
+
+    if (!board_uart_init(hw_config, baudrate, uart_tx_next, uart_rx_byte, uart)) {
+        uart->hw_config = NULL;
+        return UART_ERROR_HARDWARE;
+    }
+
+    return UART_SUCCESS;
+}
+
+size_t uart_get_tx_free(const uart_t *uart)
+{
+    if (uart == NULL || uart->hw_config == NULL) {
+        return 0;
+    }
+
+    return UART_TX_BUFFER_SIZE - (uint16_t)(uart->tx_head - uart->tx_tail);
+}
+
+uart_error_t uart_write(uart_t *uart, const void *data, size_t size)
+{
+    if (uart == NULL || (data == NULL && size > 0U)) {
+        return UART_ERROR_INVALID_PARAM;
+    }
+
+    if (uart->hw_config == NULL) {
+        return UART_ERROR_NOT_INITIALIZED;
+    }
+
+    if (size > uart_get_tx_free(uart)) {
+        return UART_ERROR_BUFFER_FULL;
+    }
+
+    const uint8_t *src = (const uint8_t *)data;
+    uint16_t head = uart->tx_head;
+    size_t first = UART_TX_BUFFER_SIZE - (head & UART_TX_MASK);
+    if (first > size) {
+        first = size;
+    }
+    memcpy(&uart->tx_buffer[head & UART_TX_MASK], src, first);
+    memcpy(uart->tx_buffer, src + first, size - first);
+
+    /* Data must be in the ring before the interrupt can see the new head */
+    atomic_signal_fence(memory_order_release);
+    uart->tx_head = (uint16_t)(head + size);
+
+    board_uart_start_tx(uart->hw_config);
+    return UART_SUCCESS;
+}
+
+size_t uart_rx_available(const uart_t *uart)
+{
+    if (uart == NULL || uart->hw_config == NULL) {
+        return 0;
+    }
+
+    size_t available = (uint16_t)(uart->rx_head - uart->rx_tail);
+    /* Bytes counted in the head are in the ring */
+    atomic_signal_fence(memory_order_acquire);
+    return available;
+}
+
+const uint8_t *uart_rx_span(const uart_t *uart, size_t offset, size_t *length)
+{
+    size_t available = uart_rx_available(uart);
+    if (length == NULL || offset >= available) {
+        if (length != NULL) {
+            *length = 0;
+        }
+        return NULL;
+    }
+
+    uint16_t start = (uint16_t)((uart->rx_tail + offset) & UART_RX_MASK);
+    size_t contiguous = UART_RX_BUFFER_SIZE - start;
+    *length = (available - offset < contiguous) ? available - offset : contiguous;
+    return &uart->rx_buffer[start];
+}
+
+uint8_t *uart_rx_contiguous(uart_t *uart, size_t length)
+{
+    if (length > UART_RX_CONTIGUOUS_SIZE || length > uart_rx_available(uart)) {
+        return NULL;
+    }
+
+    uint16_t start = uart->rx_tail & UART_RX_MASK;
+    size_t first = UART_RX_BUFFER_SIZE - start;
+    if (length > first) {
+        /* The interrupt only writes below UART_RX_BUFFER_SIZE, so the room behind the ring is the reader's */
+        memcpy(&uart->rx_buffer[UART_RX_BUFFER_SIZE], uart->rx_buffer, length - first);
+    }
+    return &uart->rx_buffer[start];
+}
+
+void uart_rx_consume(uart_t *uart, size_t length)
+{
+    size_t available = uart_rx_available(uart);
+    if (length > available) {
+        length = available;
+    }
+
+    /* Done with the bytes, including any rewriting, before the interrupt may reuse them */
+    atomic_signal_fence(memory_order_release);
+    uart->rx_tail = (uint16_t)(uart->rx_tail + length);
+}
+
+#endif
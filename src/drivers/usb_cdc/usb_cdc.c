@@ -0,0 +1,681 @@
+#include "drivers/usb_cdc/usb_cdc.h"
+#include "boards/usb.h"
+#include "driver_config.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#if DRIVER_USB_CDC_ENABLE
+
+_Static_assert((USB_CDC_TX_BUFFER_SIZE & (USB_CDC_TX_BUFFER_SIZE - 1)) == 0, "TX buffer size must be a power of two");
+_Static_assert(USB_CDC_TX_BUFFER_SIZE <= 32768, "TX buffer indices are 16 bit");
+_Static_assert((USB_CDC_RX_BUFFER_SIZE & (USB_CDC_RX_BUFFER_SIZE - 1)) == 0, "RX buffer size must be a power of two");
+_Static_assert(USB_CDC_RX_BUFFER_SIZE <= 32768, "RX buffer indices are 16 bit");
+_Static_assert(USB_CDC_RX_BUFFER_SIZE >= USB_CDC_PACKET_SIZE, "the RX ring must hold a packet");
+_Static_assert(USB_CDC_RX_CONTIGUOUS_SIZE <= USB_CDC_RX_BUFFER_SIZE, "contiguous reads cannot exceed the ring");
+
+#define USB_CDC_TX_MASK (USB_CDC_TX_BUFFER_SIZE - 1U)
+#define USB_CDC_RX_MASK (USB_CDC_RX_BUFFER_SIZE - 1U)
+
+/* Endpoints: notification on 3 (declared for the hosts that expect it, never sent), data on 1 and 2 */
+#define EP_CONTROL_OUT 0x00U
+#define EP_CONTROL_IN 0x80U
+#define EP_NOTIFY 0x83U
+#define EP_DATA_OUT 0x02U
+#define EP_DATA_IN 0x81U
+#define EP_NOTIFY_SIZE 8U
+
+/* ST's virtual COM port IDs, which hosts bind to their CDC-ACM driver */
+#define USB_CDC_VENDOR_ID 0x0483U
+#define USB_CDC_PRODUCT_ID 0x5740U
+
+/* Standard requests and descriptor types (USB 2.0 chapter 9) */
+#define REQUEST_GET_STATUS 0x00U
+#define REQUEST_CLEAR_FEATURE 0x01U
+#define REQUEST_SET_FEATURE 0x03U
+#define REQUEST_SET_ADDRESS 0x05U
+#define REQUEST_GET_DESCRIPTOR 0x06U
+#define REQUEST_GET_CONFIGURATION 0x08U
+#define REQUEST_SET_CONFIGURATION 0x09U
+#define REQUEST_GET_INTERFACE 0x0AU
+#define REQUEST_SET_INTERFACE 0x0BU
+#define FEATURE_ENDPOINT_HALT 0x00U
+
+#define DESCRIPTOR_DEVICE 0x01U
+#define DESCRIPTOR_CONFIGURATION 0x02U
+#define DESCRIPTOR_STRING 0x03U
+
+/* bmRequestType */
+#define REQUEST_TYPE_MASK 0x60U
+#define REQUEST_TYPE_STANDARD 0x00U
+#define REQUEST_TYPE_CLASS 0x20U
+#define REQUEST_RECIPIENT_MASK 0x1FU
+#define REQUEST_RECIPIENT_DEVICE 0x00U
+#define REQUEST_RECIPIENT_INTERFACE 0x01U
+#define REQUEST_RECIPIENT_ENDPOINT 0x02U
+
+/* CDC PSTN requests */
+#define CDC_SET_LINE_CODING 0x20U
+#define CDC_GET_LINE_CODING 0x21U
+#define CDC_SET_CONTROL_LINE_STATE 0x22U
+#define CDC_SEND_BREAK 0x23U
+#define CDC_LINE_CODING_SIZE 7U
+#define CDC_CONTROL_LINE_DTR 0x01U
+
+#define LOW(value) ((uint8_t)((value) & 0xFFU))
+#define HIGH(value) ((uint8_t)((value) >> 8))
+
+static const uint8_t device_descriptor[] = {
+    18, DESCRIPTOR_DEVICE, 0x00, 0x02, /* USB 2.0 */
+    0x02, 0x00, 0x00,                  /* communications device class */
+    USB_CDC_CONTROL_SIZE,
+    LOW(USB_CDC_VENDOR_ID), HIGH(USB_CDC_VENDOR_ID), LOW(USB_CDC_PRODUCT_ID), HIGH(USB_CDC_PRODUCT_ID),
+    0x00, 0x01, /* device release 1.00 */
+    1, 2, 3,    /* manufacturer, product, serial number strings */
+    1,          /* configurations */
+};
+
+static const uint8_t configuration_descriptor[] = {
+    9, DESCRIPTOR_CONFIGURATION, 67, 0, 2, 1, 0, 0xC0, 50, /* 2 interfaces, self-powered, 100 mA */
+
+    /* Communication interface: abstract control model */
+    9, 0x04, 0, 0, 1, 0x02, 0x02, 0x01, 0,
+    5, 0x24, 0x00, 0x10, 0x01, /* header, CDC 1.10 */
+    5, 0x24, 0x01, 0x00, 1,    /* call management: none, data interface 1 */
+    4, 0x24, 0x02, 0x02,       /* ACM: line coding and control line state */
+    5, 0x24, 0x06, 0, 1,       /* union: control 0, data 1 */
+    7, 0x05, EP_NOTIFY, 0x03, EP_NOTIFY_SIZE, 0, 16,
+
+    /* Data interface */
+    9, 0x04, 1, 0, 2, 0x0A, 0x00, 0x00, 0,
+    7, 0x05, EP_DATA_OUT, 0x02, USB_CDC_PACKET_SIZE, 0, 0,
+    7, 0x05, EP_DATA_IN, 0x02, USB_CDC_PACKET_SIZE, 0, 0,
+};
+
+_Static_assert(sizeof(configuration_descriptor) == 67, "configuration descriptor total length");
+
+static const char *const strings[] = {NULL, "CubeMot", "CubeMot Virtual COM Port"};
+
+static void control_in_next(usb_cdc_t *cdc);
+
+static uint16_t request_word(const usb_cdc_t *cdc, size_t offset)
+{
+    return (uint16_t)(cdc->control.request[offset] | ((uint16_t)cdc->control.request[offset + 1U] << 8));
+}
+
+static void control_stall(void)
+{
+    board_usb_ep_stall(EP_CONTROL_IN, true);
+    board_usb_ep_stall(EP_CONTROL_OUT, true);
+}
+
+static void control_status(void)
+{
+    (void)board_usb_ep_write(EP_CONTROL_IN, NULL, 0U, NULL, 0U);
+}
+
+/* IN data stage, cut to what the host asked for */
+static void control_send(usb_cdc_t *cdc, const uint8_t *data, size_t length)
+{
+    uint16_t requested = request_word(cdc, 6U);
+    if (length > requested) {
+        length = requested;
+    }
+
+    cdc->control.data = data;
+    cdc->control.remaining = (uint16_t)length;
+    /* A short answer that fills its last packet must be ended explicitly */
+    cdc->control.zero_length = (length < requested) && (length % USB_CDC_CONTROL_SIZE) == 0U;
+    control_in_next(cdc);
+}
+
+static void control_in_next(usb_cdc_t *cdc)
+{
+    usb_cdc_control_t *control = &cdc->control;
+    if (control->data == NULL) {
+        return;
+    }
+
+    uint16_t chunk = (control->remaining < USB_CDC_CONTROL_SIZE) ? control->remaining : USB_CDC_CONTROL_SIZE;
+    if (chunk == 0U && !control->zero_length) {
+        control->data = NULL;
+        return;
+    }
+    if (!board_usb_ep_write(EP_CONTROL_IN, control->data, chunk, NULL, 0U)) {
+        return;
+    }
+
+    control->data += chunk;
+    control->remaining = (uint16_t)(control->remaining - chunk);
+    if (chunk == 0U) {
+        control->zero_length = false;
+    }
+    if (control->remaining == 0U && !control->zero_length) {
+        control->data = NULL;
+    }
+}
+
+static size_t build_string(usb_cdc_t *cdc, uint8_t index)
+{
+    uint8_t *out = cdc->control.buffer;
+    char serial[9];
+
+    if (index == 0U) {
+        out[0] = 4U;
+        out[1] = DESCRIPTOR_STRING;
+        out[2] = 0x09U; /* English (United States) */
+        out[3] = 0x04U;
+        return 4U;
+    }
+
+    const char *text = NULL;
+    if (index < sizeof(strings) / sizeof(strings[0])) {
+        text = strings[index];
+    } else if (index == 3U) {
+        static const char hex[] = "0123456789ABCDEF";
+        uint32_t id = board_usb_get_unique_id();
+        for (int digit = 0; digit < 8; digit++) {
+            serial[digit] = hex[(id >> (28 - 4 * digit)) & 0xFU];
+        }
+        serial[8] = '\0';
+        text = serial;
+    }
+    if (text == NULL) {
+        return 0U;
+    }
+
+    size_t length = 2U;
+    for (; *text != '\0' && length + 2U <= sizeof(cdc->control.buffer); text++) {
+        out[length++] = (uint8_t)*text;
+        out[length++] = 0U;
+    }
+    out[0] = (uint8_t)length;
+    out[1] = DESCRIPTOR_STRING;
+    return length;
+}
+
+static void open_data_endpoints(usb_cdc_t *cdc)
+{
+    if (!cdc->endpoints_open) {
+        cdc->endpoints_open = board_usb_ep_open(EP_NOTIFY, BOARD_USB_EP_INTERRUPT, EP_NOTIFY_SIZE, false) &&
+                              board_usb_ep_open(EP_DATA_IN, BOARD_USB_EP_BULK, USB_CDC_PACKET_SIZE, true) &&
+                              board_usb_ep_open(EP_DATA_OUT, BOARD_USB_EP_BULK, USB_CDC_PACKET_SIZE, true);
+        return;
+    }
+
+    /* Reconfiguring resets the data toggles */
+    board_usb_ep_stall(EP_NOTIFY, false);
+    board_usb_ep_stall(EP_DATA_IN, false);
+    board_usb_ep_stall(EP_DATA_OUT, false);
+}
+
+/* Nothing sent from the ring yet goes to a host that closes the port */
+static void tx_discard(usb_cdc_t *cdc)
+{
+    cdc->tx_tail = cdc->tx_head;
+    cdc->tx_zero_length = false;
+}
+
+static bool handle_standard(usb_cdc_t *cdc)
+{
+    const uint8_t *request = cdc->control.request;
+    uint8_t *reply = cdc->control.buffer;
+    uint16_t value = request_word(cdc, 2U);
+    uint8_t recipient = request[0] & REQUEST_RECIPIENT_MASK;
+    uint8_t endpoint = (uint8_t)request_word(cdc, 4U);
+
+    switch (request[1]) {
+        case REQUEST_GET_DESCRIPTOR:
+            if (recipient != REQUEST_RECIPIENT_DEVICE) {
+                return false;
+            }
+            switch (HIGH(value)) {
+                case DESCRIPTOR_DEVICE:
+                    control_send(cdc, device_descriptor, sizeof(device_descriptor));
+                    return true;
+                case DESCRIPTOR_CONFIGURATION:
+                    control_send(cdc, configuration_descriptor, sizeof(configuration_descriptor));
+                    return true;
+                case DESCRIPTOR_STRING: {
+                    size_t length = build_string(cdc, LOW(value));
+                    if (length == 0U) {
+                        return false;
+                    }
+                    control_send(cdc, reply, length);
+                    return true;
+                }
+                default:
+                    /* Including the device qualifier: a full-speed only device has none */
+                    return false;
+            }
+
+        case REQUEST_SET_ADDRESS:
+            cdc->control.address = (uint8_t)(value & 0x7FU);
+            control_status();
+            return true;
+
+        case REQUEST_GET_CONFIGURATION:
+            reply[0] = cdc->configuration;
+            control_send(cdc, reply, 1U);
+            return true;
+
+        case REQUEST_SET_CONFIGURATION:
+            if (value > 1U) {
+                return false;
+            }
+            if (value == 1U) {
+                open_data_endpoints(cdc);
+                if (!cdc->endpoints_open) {
+                    return false;
+                }
+            }
+            cdc->configuration = (uint8_t)value;
+            cdc->control_lines = 0U;
+            tx_discard(cdc);
+            control_status();
+            return true;
+
+        case REQUEST_GET_STATUS:
+            reply[0] = 0U;
+            reply[1] = 0U;
+            if (recipient == REQUEST_RECIPIENT_DEVICE) {
+                reply[0] = 0x01U; /* self-powered */
+            } else if (recipient == REQUEST_RECIPIENT_ENDPOINT) {
+                reply[0] = board_usb_ep_is_stalled(endpoint) ? 1U : 0U;
+            }
+            control_send(cdc, reply, 2U);
+            return true;
+
+        case REQUEST_CLEAR_FEATURE:
+        case REQUEST_SET_FEATURE:
+            if (recipient != REQUEST_RECIPIENT_ENDPOINT || value != FEATURE_ENDPOINT_HALT ||
+                BOARD_USB_EP_NUMBER(endpoint) == 0U || cdc->configuration == 0U) {
+                return false;
+            }
+            board_usb_ep_stall(endpoint, request[1] == REQUEST_SET_FEATURE);
+            control_status();
+            return true;
+
+        case REQUEST_GET_INTERFACE:
+            if (cdc->configuration == 0U) {
+                return false;
+            }
+            reply[0] = 0U;
+            control_send(cdc, reply, 1U);
+            return true;
+
+        case REQUEST_SET_INTERFACE:
+            if (value != 0U || cdc->configuration == 0U) {
+                return false;
+            }
+            control_status();
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static bool handle_class(usb_cdc_t *cdc)
+{
+    const uint8_t *request = cdc->control.request;
+    uint8_t *reply = cdc->control.buffer;
+
+    switch (request[1]) {
+        case CDC_SET_LINE_CODING:
+            if (request_word(cdc, 6U) != CDC_LINE_CODING_SIZE) {
+                return false;
+            }
+            /* Status stage once the data stage arrived */
+            cdc->control.out_length = CDC_LINE_CODING_SIZE;
+            cdc->control.out_received = 0U;
+            return true;
+
+        case CDC_GET_LINE_CODING: {
+            uint32_t baudrate = cdc->line_coding.baudrate;
+            reply[0] = (uint8_t)baudrate;
+            reply[1] = (uint8_t)(baudrate >> 8);
+            reply[2] = (uint8_t)(baudrate >> 16);
+            reply[3] = (uint8_t)(baudrate >> 24);
+            reply[4] = cdc->line_coding.stop_bits;
+            reply[5] = cdc->line_coding.parity;
+            reply[6] = cdc->line_coding.data_bits;
+            control_send(cdc, reply, CDC_LINE_CODING_SIZE);
+            return true;
+        }
+
+        case CDC_SET_CONTROL_LINE_STATE:
+            cdc->control_lines = (uint8_t)request_word(cdc, 2U);
+            if ((cdc->control_lines & CDC_CONTROL_LINE_DTR) == 0U) {
+                tx_discard(cdc);
+            }
+            control_status();
+            board_usb_ep_service(EP_DATA_IN);
+            return true;
+
+        case CDC_SEND_BREAK:
+            control_status();
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static void handle_setup(const uint8_t *packet, void *context)
+{
+    usb_cdc_t *cdc = (usb_cdc_t *)context;
+    usb_cdc_control_t *control = &cdc->control;
+
+    memcpy(control->request, packet, sizeof(control->request));
+    control->data = NULL;
+    control->remaining = 0U;
+    control->zero_length = false;
+    control->out_length = 0U;
+
+    bool handled = false;
+    switch (packet[0] & REQUEST_TYPE_MASK) {
+        case REQUEST_TYPE_STANDARD:
+            handled = handle_standard(cdc);
+            break;
+        case REQUEST_TYPE_CLASS:
+            /* Interface 0 is the only one with class requests */
+            handled = (packet[0] & REQUEST_RECIPIENT_MASK) == REQUEST_RECIPIENT_INTERFACE && packet[4] == 0U &&
+                      handle_class(cdc);
+            break;
+        default:
+            break;
+    }
+
+    if (!handled) {
+        control->data = NULL;
+        control->out_length = 0U;
+        control_stall();
+    }
+}
+
+static void handle_control_out(usb_cdc_t *cdc)
+{
+    usb_cdc_control_t *control = &cdc->control;
+    int length = board_usb_ep_rx_length(EP_CONTROL_OUT);
+    if (length < 0) {
+        return;
+    }
+
+    if (control->out_length == 0U) {
+        /* Status stage of an IN transfer, or a packet nobody asked for */
+        uint8_t discard[USB_CDC_CONTROL_SIZE];
+        board_usb_ep_read(EP_CONTROL_OUT, discard, sizeof(discard), NULL, 0U);
+        return;
+    }
+
+    uint16_t room = (uint16_t)(sizeof(control->buffer) - control->out_received);
+    if ((size_t)length > room) {
+        control->out_length = 0U;
+        control_stall();
+        return;
+    }
+    board_usb_ep_read(EP_CONTROL_OUT, &control->buffer[control->out_received], (size_t)length, NULL, 0U);
+    control->out_received = (uint16_t)(control->out_received + length);
+    if (control->out_received < control->out_length) {
+        return;
+    }
+
+    /* SET_LINE_CODING is the only request with a data stage */
+    const uint8_t *data = control->buffer;
+    cdc->line_coding.baudrate =
+        (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    cdc->line_coding.stop_bits = data[4];
+    cdc->line_coding.parity = data[5];
+    cdc->line_coding.data_bits = data[6];
+    control->out_length = 0U;
+    control_status();
+}
+
+/* Copy packets from the transmit ring into the free endpoint buffers */
+static void tx_fill(usb_cdc_t *cdc)
+{
+    if (cdc->configuration == 0U) {
+        return;
+    }
+
+    for (;;) {
+        uint16_t tail = cdc->tx_tail;
+        size_t pending = (uint16_t)(cdc->tx_head - tail);
+        /* usb_cdc_write() moves the head only after its copy, so the packet taken here is complete */
+        atomic_signal_fence(memory_order_acquire);
+
+        if (pending == 0U) {
+            if (cdc->tx_zero_length && board_usb_ep_write(EP_DATA_IN, NULL, 0U, NULL, 0U)) {
+                cdc->tx_zero_length = false;
+            }
+            return;
+        }
+
+        size_t length = (pending < USB_CDC_PACKET_SIZE) ? pending : USB_CDC_PACKET_SIZE;
+        size_t first = USB_CDC_TX_BUFFER_SIZE - (tail & USB_CDC_TX_MASK);
+        if (first > length) {
+            first = length;
+        }
+        if (!board_usb_ep_write(EP_DATA_IN, &cdc->tx_buffer[tail & USB_CDC_TX_MASK], first, cdc->tx_buffer,
+                                length - first)) {
+            return;
+        }
+
+        /* The host may read in larger blocks: a full packet leaves its transfer open */
+        cdc->tx_zero_length = (length == USB_CDC_PACKET_SIZE);
+        cdc->tx_tail = (uint16_t)(tail + length);
+    }
+}
+
+/* Move received packets into the ring while it has room; the rest waits in the endpoint */
+static void rx_drain(usb_cdc_t *cdc)
+{
+    for (;;) {
+        int length = board_usb_ep_rx_length(EP_DATA_OUT);
+        if (length < 0) {
+            cdc->rx_waiting = false;
+            return;
+        }
+
+        uint16_t head = cdc->rx_head;
+        size_t room = USB_CDC_RX_BUFFER_SIZE - (uint16_t)(head - cdc->rx_tail);
+        if ((size_t)length > room) {
+            cdc->rx_waiting = true;
+            return;
+        }
+
+        size_t first = USB_CDC_RX_BUFFER_SIZE - (head & USB_CDC_RX_MASK);
+        if (first > (size_t)length) {
+            first = (size_t)length;
+        }
+        board_usb_ep_read(EP_DATA_OUT, &cdc->rx_buffer[head & USB_CDC_RX_MASK], first, cdc->rx_buffer,
+                          (size_t)length - first);
+
+        /* The whole packet leaves the endpoint memory before the reader can count it */
+        atomic_signal_fence(memory_order_release);
+        cdc->rx_head = (uint16_t)(head + (uint16_t)length);
+    }
+}
+
+static void handle_reset(void *context)
+{
+    usb_cdc_t *cdc = (usb_cdc_t *)context;
+
+    memset(&cdc->control, 0, sizeof(cdc->control));
+    cdc->configuration = 0U;
+    cdc->control_lines = 0U;
+    cdc->endpoints_open = false;
+    cdc->suspended = false;
+    cdc->rx_waiting = false;
+    tx_discard(cdc);
+}
+
+static void handle_out(uint8_t address, void *context)
+{
+    usb_cdc_t *cdc = (usb_cdc_t *)context;
+
+    if (address == EP_CONTROL_OUT) {
+        handle_control_out(cdc);
+    } else if (address == EP_DATA_OUT) {
+        rx_drain(cdc);
+    }
+}
+
+static void handle_in(uint8_t address, void *context)
+{
+    usb_cdc_t *cdc = (usb_cdc_t *)context;
+
+    if (address == EP_CONTROL_IN) {
+        if (cdc->control.address != 0U && cdc->control.data == NULL) {
+            board_usb_set_address(cdc->control.address);
+            cdc->control.address = 0U;
+        }
+        control_in_next(cdc);
+    } else if (address == EP_DATA_IN) {
+        tx_fill(cdc);
+    }
+}
+
+static void handle_suspend(bool suspended, void *context)
+{
+    ((usb_cdc_t *)context)->suspended = suspended;
+}
+
+static const board_usb_callbacks_t usb_cdc_callbacks = {
+    .reset = handle_reset,
+    .setup = handle_setup,
+    .out = handle_out,
+    .in = handle_in,
+    .suspend = handle_suspend,
+};
+
+usb_cdc_error_t usb_cdc_init(usb_cdc_t *cdc)
+{
+    if (cdc == NULL) {
+        return USB_CDC_ERROR_INVALID_PARAM;
+    }
+
+    memset(cdc, 0, sizeof(*cdc));
+    cdc->line_coding = (usb_cdc_line_coding_t){.baudrate = 115200U, .stop_bits = 0U, .parity = 0U, .data_bits = 8U};
+    cdc->initialized = true;
+
+    if (!board_usb_init(&usb_cdc_callbacks, cdc)) {
+        cdc->initialized = false;
+        return USB_CDC_ERROR_HARDWARE;
+    }
+
+    return USB_CDC_SUCCESS;
+}
+
+bool usb_cdc_is_connected(const usb_cdc_t *cdc)
+{
+    return cdc != NULL && cdc->initialized && cdc->configuration != 0U && !cdc->suspended &&
+           (cdc->control_lines & CDC_CONTROL_LINE_DTR) != 0U;
+}
+
+size_t usb_cdc_get_tx_free(const usb_cdc_t *cdc)
+{
+    if (cdc == NULL || !cdc->initialized) {
+        return 0;
+    }
+
+    return USB_CDC_TX_BUFFER_SIZE - (uint16_t)(cdc->tx_head - cdc->tx_tail);
+}
+
+usb_cdc_error_t usb_cdc_write(usb_cdc_t *cdc, const void *data, size_t size)
+{
+    if (cdc == NULL || (data == NULL && size > 0U)) {
+        return USB_CDC_ERROR_INVALID_PARAM;
+    }
+
+    if (!cdc->initialized) {
+        return USB_CDC_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!usb_cdc_is_connected(cdc)) {
+        return USB_CDC_ERROR_NOT_CONNECTED;
+    }
+
+    if (size > usb_cdc_get_tx_free(cdc)) {
+        return USB_CDC_ERROR_BUFFER_FULL;
+    }
+
+    const uint8_t *src = (const uint8_t *)data;
+    uint16_t head = cdc->tx_head;
+    size_t first = USB_CDC_TX_BUFFER_SIZE - (head & USB_CDC_TX_MASK);
+    if (first > size) {
+        first = size;
+    }
+    memcpy(&cdc->tx_buffer[head & USB_CDC_TX_MASK], src, first);
+    memcpy(cdc->tx_buffer, src + first, size - first);
+
+    /* tx_fill() may run in the USB interrupt as soon as the head moves */
+    atomic_signal_fence(memory_order_release);
+    cdc->tx_head = (uint16_t)(head + size);
+
+    board_usb_ep_service(EP_DATA_IN);
+    return USB_CDC_SUCCESS;
+}
+
+size_t usb_cdc_rx_available(const usb_cdc_t *cdc)
+{
+    if (cdc == NULL || !cdc->initialized) {
+        return 0;
+    }
+
+    size_t available = (uint16_t)(cdc->rx_head - cdc->rx_tail);
+    /* rx_drain() counts a packet only once it is copied, so every counted byte can be read */
+    atomic_signal_fence(memory_order_acquire);
+    return available;
+}
+
+const uint8_t *usb_cdc_rx_span(const usb_cdc_t *cdc, size_t offset, size_t *length)
+{
+    size_t available = usb_cdc_rx_available(cdc);
+    if (length == NULL || offset >= available) {
+        if (length != NULL) {
+            *length = 0;
+        }
+        return NULL;
+    }
+
+    uint16_t start = (uint16_t)((cdc->rx_tail + offset) & USB_CDC_RX_MASK);
+    size_t contiguous = USB_CDC_RX_BUFFER_SIZE - start;
+    *length = (available - offset < contiguous) ? available - offset : contiguous;
+    return &cdc->rx_buffer[start];
+}
+
+uint8_t *usb_cdc_rx_contiguous(usb_cdc_t *cdc, size_t length)
+{
+    if (length > USB_CDC_RX_CONTIGUOUS_SIZE || length > usb_cdc_rx_available(cdc)) {
+        return NULL;
+    }
+
+    uint16_t start = cdc->rx_tail & USB_CDC_RX_MASK;
+    size_t first = USB_CDC_RX_BUFFER_SIZE - start;
+    if (length > first) {
+        /* rx_drain() wraps packets at USB_CDC_RX_BUFFER_SIZE and never touches the spill area behind it */
+        memcpy(&cdc->rx_buffer[USB_CDC_RX_BUFFER_SIZE], cdc->rx_buffer, length - first);
+    }
+    return &cdc->rx_buffer[start];
+}
+
+void usb_cdc_rx_consume(usb_cdc_t *cdc, size_t length)
+{
+    size_t available = usb_cdc_rx_available(cdc);
+    if (length > available) {
+        length = available;
+    }
+
+    /* The next OUT packet may land on these bytes once the tail moves, so reads and in-place edits end here */
+    atomic_signal_fence(memory_order_release);
+    cdc->rx_tail = (uint16_t)(cdc->rx_tail + length);
+
+    /* A packet held back for lack of room fits now, or the interrupt marks it again */
+    if (cdc->rx_waiting) {
+        board_usb_ep_service(EP_DATA_OUT);
+    }
+}
+
+#endif
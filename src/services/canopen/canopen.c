@@ -0,0 +1,230 @@
+#include "services/canopen/canopen.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#if SERVICE_CANOPEN_ENABLE
+
+#define CANOPEN_NMT_START 0x01U
+#define CANOPEN_NMT_STOP 0x02U
+#define CANOPEN_NMT_ENTER_PRE_OPERATIONAL 0x80U
+#define CANOPEN_NMT_RESET_NODE 0x81U
+#define CANOPEN_NMT_RESET_COMMUNICATION 0x82U
+
+#define CANOPEN_CLASSIC_MAX_LENGTH 8U
+#define CANOPEN_COB_ID_MASK 0x7FFU
+
+static uint32_t pdo_cob_id(uint32_t base, uint8_t pdo, uint8_t node_id)
+{
+    return base + 0x100U * pdo + node_id;
+}
+
+static void reset_communication(canopen_t *co)
+{
+    for (uint8_t i = 0U; i < CANOPEN_PDO_COUNT; i++) {
+        pdo_rx_buffer_init(&co->rpdo_buffers[i]);
+    }
+    co->sync_pending = false;
+}
+
+static void nmt_handler(const can_frame_t *frame, void *context)
+{
+    canopen_t *co = context;
+
+    if (frame->length < 2U || (frame->data[1] != 0U && frame->data[1] != co->node_id)) {
+        return;
+    }
+
+    switch (frame->data[0]) {
+        case CANOPEN_NMT_START:
+            co->nmt_state = CANOPEN_NMT_OPERATIONAL;
+            break;
+        case CANOPEN_NMT_STOP:
+            co->nmt_state = CANOPEN_NMT_STOPPED;
+            break;
+        case CANOPEN_NMT_ENTER_PRE_OPERATIONAL:
+            co->nmt_state = CANOPEN_NMT_PRE_OPERATIONAL;
+            break;
+        case CANOPEN_NMT_RESET_NODE:
+        case CANOPEN_NMT_RESET_COMMUNICATION:
+            /* The application owns the object values, so both resets only restart communication */
+            co->nmt_state = CANOPEN_NMT_PRE_OPERATIONAL;
+            reset_communication(co);
+            uint8_t state = CANOPEN_NMT_INITIALISING;
+            (void)can_send(co->can, CANOPEN_COB_HEARTBEAT + co->node_id, 0U, &state, 1U);
+            break;
+        default:
+            break;
+    }
+}
+
+static void sync_handler(const can_frame_t *frame, void *context)
+{
+    canopen_t *co = context;
+
+    if (co->sync_callback != NULL) {
+        co->sync_callback(frame->timestamp, co->sync_context);
+    }
+
+    if (co->nmt_state != CANOPEN_NMT_OPERATIONAL) {
+        return;
+    }
+
+    for (uint8_t i = 0U; i < CANOPEN_PDO_COUNT; i++) {
+        pdo_rx_buffer_swap(&co->rpdo_buffers[i]);
+    }
+    co->sync_count++;
+    atomic_signal_fence(memory_order_release);
+    co->sync_pending = true;
+}
+
+static void rpdo_handler(const can_frame_t *frame, void *context)
+{
+    const canopen_rpdo_handler_t *rpdo = context;
+    canopen_t *co = rpdo->co;
+
+    if (co->nmt_state == CANOPEN_NMT_OPERATIONAL) {
+        pdo_rx_buffer_write(&co->rpdo_buffers[rpdo->pdo], frame->data, frame->length);
+    }
+}
+
+canopen_error_t canopen_init(canopen_t *co, can_t *can, uint8_t node_id)
+{
+    if (co == NULL || can == NULL || node_id == 0U || node_id > 127U) {
+        return CANOPEN_ERROR_INVALID_PARAM;
+    }
+
+    memset(co, 0, sizeof(*co));
+    co->can = can;
+    co->node_id = node_id;
+    co->fd = can->bitrate.data_bitrate != 0U;
+    co->nmt_state = CANOPEN_NMT_INITIALISING;
+    reset_communication(co);
+
+    /* Classic and FD frames alike: the master decides the format */
+    if (can_subscribe(can, CANOPEN_COB_NMT, CANOPEN_COB_ID_MASK, 0U, nmt_handler, co) != CAN_SUCCESS ||
+        can_subscribe(can, CANOPEN_COB_SYNC, CANOPEN_COB_ID_MASK, 0U, sync_handler, co) != CAN_SUCCESS) {
+        return CANOPEN_ERROR_CAN;
+    }
+
+    for (uint8_t i = 0U; i < CANOPEN_PDO_COUNT; i++) {
+        co->rpdo_handlers[i].co = co;
+        co->rpdo_handlers[i].pdo = i;
+        if (can_subscribe(can, pdo_cob_id(CANOPEN_COB_RPDO1, i, node_id), CANOPEN_COB_ID_MASK, 0U, rpdo_handler,
+                          &co->rpdo_handlers[i]) != CAN_SUCCESS) {
+            return CANOPEN_ERROR_CAN;
+        }
+    }
+
+    return CANOPEN_SUCCESS;
+}
+
+canopen_error_t canopen_start(canopen_t *co)
+{
+    if (co == NULL || co->can == NULL) {
+        return CANOPEN_ERROR_INVALID_PARAM;
+    }
+
+    uint8_t state = CANOPEN_NMT_INITIALISING;
+    co->nmt_state = CANOPEN_NMT_PRE_OPERATIONAL;
+    if (can_send(co->can, CANOPEN_COB_HEARTBEAT + co->node_id, 0U, &state, 1U) != CAN_SUCCESS) {
+        return CANOPEN_ERROR_CAN;
+    }
+
+    return CANOPEN_SUCCESS;
+}
+
+void canopen_set_sync_callback(canopen_t *co, canopen_sync_callback_t callback, void *context)
+{
+    if (co != NULL) {
+        co->sync_callback = callback;
+        co->sync_context = context;
+    }
+}
+
+static canopen_error_t map_pdo(canopen_t *co, pdo_map_t *map, const pdo_object_t *dictionary,
+                               size_t dictionary_size, const uint32_t *mapping, uint8_t count, uint8_t access)
+{
+    if (co->nmt_state == CANOPEN_NMT_OPERATIONAL) {
+        return CANOPEN_ERROR_STATE;
+    }
+
+    pdo_map_t resolved;
+    if (pdo_map_configure(&resolved, dictionary, dictionary_size, mapping, count, access) != PDO_SUCCESS) {
+        return CANOPEN_ERROR_MAPPING;
+    }
+
+    if (resolved.length > (co->fd ? PDO_MAX_LENGTH : CANOPEN_CLASSIC_MAX_LENGTH)) {
+        return CANOPEN_ERROR_MAPPING;
+    }
+
+    *map = resolved;
+    return CANOPEN_SUCCESS;
+}
+
+canopen_error_t canopen_map_rpdo(canopen_t *co, uint8_t pdo, const pdo_object_t *dictionary, size_t dictionary_size,
+                                 const uint32_t *mapping, uint8_t count)
+{
+    if (co == NULL || pdo >= CANOPEN_PDO_COUNT) {
+        return CANOPEN_ERROR_INVALID_PARAM;
+    }
+
+    return map_pdo(co, &co->rpdo_maps[pdo], dictionary, dictionary_size, mapping, count, PDO_ACCESS_RX);
+}
+
+canopen_error_t canopen_map_tpdo(canopen_t *co, uint8_t pdo, const pdo_object_t *dictionary, size_t dictionary_size,
+                                 const uint32_t *mapping, uint8_t count)
+{
+    if (co == NULL || pdo >= CANOPEN_PDO_COUNT) {
+        return CANOPEN_ERROR_INVALID_PARAM;
+    }
+
+    return map_pdo(co, &co->tpdo_maps[pdo], dictionary, dictionary_size, mapping, count, PDO_ACCESS_TX);
+}
+
+bool canopen_sync_begin(canopen_t *co)
+{
+    if (!co->sync_pending) {
+        return false;
+    }
+    co->sync_pending = false;
+    atomic_signal_fence(memory_order_acquire);
+
+    for (uint8_t i = 0U; i < CANOPEN_PDO_COUNT; i++) {
+        if (co->rpdo_maps[i].count != 0U) {
+            (void)pdo_rx_buffer_apply(&co->rpdo_buffers[i], &co->rpdo_maps[i]);
+        }
+    }
+
+    return true;
+}
+
+void canopen_sync_end(canopen_t *co)
+{
+    if (co->nmt_state != CANOPEN_NMT_OPERATIONAL) {
+        return;
+    }
+
+    uint8_t flags = co->fd ? (CAN_FLAG_FD | CAN_FLAG_BRS) : 0U;
+    uint8_t buffer[PDO_MAX_LENGTH];
+
+    for (uint8_t i = 0U; i < CANOPEN_PDO_COUNT; i++) {
+        const pdo_map_t *map = &co->tpdo_maps[i];
+        if (map->count == 0U) {
+            continue;
+        }
+
+        pdo_pack(map, buffer);
+        if (can_send(co->can, pdo_cob_id(CANOPEN_COB_TPDO1, i, co->node_id), flags, buffer, map->length) !=
+            CAN_SUCCESS) {
+            co->tpdo_dropped++;
+        }
+    }
+}
+
+canopen_nmt_state_t canopen_get_nmt_state(const canopen_t *co)
+{
+    return (co != NULL) ? co->nmt_state : CANOPEN_NMT_INITIALISING;
+}
+
+#endif
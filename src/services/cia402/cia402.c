@@ -0,0 +1,257 @@
+#include "services/cia402/cia402.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#if SERVICE_CIA402_ENABLE
+
+#define CIA402_CONTROL_FAULT_RESET (1U << 7)
+#define CIA402_STATUS_STATE_MASK 0x006FU
+#define CIA402_STATUS_REMOTE (1U << 9)
+
+typedef struct {
+    uint16_t mask;
+    uint16_t value;
+    cia402_command_t command;
+} cia402_command_pattern_t;
+
+/* Controlword bits 7, 3..0; checked in order, the first match wins */
+static const cia402_command_pattern_t command_patterns[] = {
+    {.mask = 0x0082U, .value = 0x0000U, .command = CIA402_COMMAND_DISABLE_VOLTAGE},
+    {.mask = 0x0086U, .value = 0x0002U, .command = CIA402_COMMAND_QUICK_STOP},
+    {.mask = 0x0087U, .value = 0x0006U, .command = CIA402_COMMAND_SHUTDOWN},
+    {.mask = 0x008FU, .value = 0x0007U, .command = CIA402_COMMAND_SWITCH_ON},
+    {.mask = 0x008FU, .value = 0x000FU, .command = CIA402_COMMAND_ENABLE_OPERATION},
+};
+
+/* Next state per state and command; the state itself where the command does not apply */
+static const uint8_t transitions[CIA402_STATE_COUNT][CIA402_COMMAND_COUNT] = {
+    [CIA402_STATE_NOT_READY_TO_SWITCH_ON] = {
+        [CIA402_COMMAND_NONE] = CIA402_STATE_NOT_READY_TO_SWITCH_ON,
+        [CIA402_COMMAND_SHUTDOWN] = CIA402_STATE_NOT_READY_TO_SWITCH_ON,
+        [CIA402_COMMAND_SWITCH_ON] = CIA402_STATE_NOT_READY_TO_SWITCH_ON,
+        [CIA402_COMMAND_ENABLE_OPERATION] = CIA402_STATE_NOT_READY_TO_SWITCH_ON,
+        [CIA402_COMMAND_DISABLE_VOLTAGE] = CIA402_STATE_NOT_READY_TO_SWITCH_ON,
+        [CIA402_COMMAND_QUICK_STOP] = CIA402_STATE_NOT_READY_TO_SWITCH_ON,
+        [CIA402_COMMAND_FAULT_RESET] = CIA402_STATE_NOT_READY_TO_SWITCH_ON,
+    },
+    [CIA402_STATE_SWITCH_ON_DISABLED] = {
+        [CIA402_COMMAND_NONE] = CIA402_STATE_SWITCH_ON_DISABLED,
+        [CIA402_COMMAND_SHUTDOWN] = CIA402_STATE_READY_TO_SWITCH_ON,                    /* 2 */
+        [CIA402_COMMAND_SWITCH_ON] = CIA402_STATE_SWITCH_ON_DISABLED,
+        [CIA402_COMMAND_ENABLE_OPERATION] = CIA402_STATE_SWITCH_ON_DISABLED,
+        [CIA402_COMMAND_DISABLE_VOLTAGE] = CIA402_STATE_SWITCH_ON_DISABLED,
+        [CIA402_COMMAND_QUICK_STOP] = CIA402_STATE_SWITCH_ON_DISABLED,
+        [CIA402_COMMAND_FAULT_RESET] = CIA402_STATE_SWITCH_ON_DISABLED,
+    },
+    [CIA402_STATE_READY_TO_SWITCH_ON] = {
+        [CIA402_COMMAND_NONE] = CIA402_STATE_READY_TO_SWITCH_ON,
+        [CIA402_COMMAND_SHUTDOWN] = CIA402_STATE_READY_TO_SWITCH_ON,
+        [CIA402_COMMAND_SWITCH_ON] = CIA402_STATE_SWITCHED_ON,                          /* 3 */
+        [CIA402_COMMAND_ENABLE_OPERATION] = CIA402_STATE_SWITCHED_ON,                   /* 3, then 4 */
+        [CIA402_COMMAND_DISABLE_VOLTAGE] = CIA402_STATE_SWITCH_ON_DISABLED,             /* 7 */
+        [CIA402_COMMAND_QUICK_STOP] = CIA402_STATE_SWITCH_ON_DISABLED,                  /* 7 */
+        [CIA402_COMMAND_FAULT_RESET] = CIA402_STATE_READY_TO_SWITCH_ON,
+    },
+    [CIA402_STATE_SWITCHED_ON] = {
+        [CIA402_COMMAND_NONE] = CIA402_STATE_SWITCHED_ON,
+        [CIA402_COMMAND_SHUTDOWN] = CIA402_STATE_READY_TO_SWITCH_ON,                    /* 6 */
+        [CIA402_COMMAND_SWITCH_ON] = CIA402_STATE_SWITCHED_ON,
+        [CIA402_COMMAND_ENABLE_OPERATION] = CIA402_STATE_OPERATION_ENABLED,             /* 4 */
+        [CIA402_COMMAND_DISABLE_VOLTAGE] = CIA402_STATE_SWITCH_ON_DISABLED,             /* 10 */
+        [CIA402_COMMAND_QUICK_STOP] = CIA402_STATE_SWITCH_ON_DISABLED,                  /* 10 */
+        [CIA402_COMMAND_FAULT_RESET] = CIA402_STATE_SWITCHED_ON,
+    },
+    [CIA402_STATE_OPERATION_ENABLED] = {
+        [CIA402_COMMAND_NONE] = CIA402_STATE_OPERATION_ENABLED,
+        [CIA402_COMMAND_SHUTDOWN] = CIA402_STATE_READY_TO_SWITCH_ON,                    /* 8 */
+        [CIA402_COMMAND_SWITCH_ON] = CIA402_STATE_SWITCHED_ON,                          /* 5 */
+        [CIA402_COMMAND_ENABLE_OPERATION] = CIA402_STATE_OPERATION_ENABLED,
+        [CIA402_COMMAND_DISABLE_VOLTAGE] = CIA402_STATE_SWITCH_ON_DISABLED,             /* 9 */
+        [CIA402_COMMAND_QUICK_STOP] = CIA402_STATE_QUICK_STOP_ACTIVE,                   /* 11 */
+        [CIA402_COMMAND_FAULT_RESET] = CIA402_STATE_OPERATION_ENABLED,
+    },
+    [CIA402_STATE_QUICK_STOP_ACTIVE] = {
+        [CIA402_COMMAND_NONE] = CIA402_STATE_QUICK_STOP_ACTIVE,
+        [CIA402_COMMAND_SHUTDOWN] = CIA402_STATE_QUICK_STOP_ACTIVE,
+        [CIA402_COMMAND_SWITCH_ON] = CIA402_STATE_QUICK_STOP_ACTIVE,
+        [CIA402_COMMAND_ENABLE_OPERATION] = CIA402_STATE_OPERATION_ENABLED,             /* 16 */
+        [CIA402_COMMAND_DISABLE_VOLTAGE] = CIA402_STATE_SWITCH_ON_DISABLED,             /* 12 */
+        [CIA402_COMMAND_QUICK_STOP] = CIA402_STATE_QUICK_STOP_ACTIVE,
+        [CIA402_COMMAND_FAULT_RESET] = CIA402_STATE_QUICK_STOP_ACTIVE,
+    },
+    [CIA402_STATE_FAULT_REACTION_ACTIVE] = {
+        [CIA402_COMMAND_NONE] = CIA402_STATE_FAULT_REACTION_ACTIVE,
+        [CIA402_COMMAND_SHUTDOWN] = CIA402_STATE_FAULT_REACTION_ACTIVE,
+        [CIA402_COMMAND_SWITCH_ON] = CIA402_STATE_FAULT_REACTION_ACTIVE,
+        [CIA402_COMMAND_ENABLE_OPERATION] = CIA402_STATE_FAULT_REACTION_ACTIVE,
+        [CIA402_COMMAND_DISABLE_VOLTAGE] = CIA402_STATE_FAULT_REACTION_ACTIVE,
+        [CIA402_COMMAND_QUICK_STOP] = CIA402_STATE_FAULT_REACTION_ACTIVE,
+        [CIA402_COMMAND_FAULT_RESET] = CIA402_STATE_FAULT_REACTION_ACTIVE,
+    },
+    [CIA402_STATE_FAULT] = {
+        [CIA402_COMMAND_NONE] = CIA402_STATE_FAULT,
+        [CIA402_COMMAND_SHUTDOWN] = CIA402_STATE_FAULT,
+        [CIA402_COMMAND_SWITCH_ON] = CIA402_STATE_FAULT,
+        [CIA402_COMMAND_ENABLE_OPERATION] = CIA402_STATE_FAULT,
+        [CIA402_COMMAND_DISABLE_VOLTAGE] = CIA402_STATE_FAULT,
+        [CIA402_COMMAND_QUICK_STOP] = CIA402_STATE_FAULT,
+        [CIA402_COMMAND_FAULT_RESET] = CIA402_STATE_SWITCH_ON_DISABLED,                 /* 15 */
+    },
+};
+
+/* Statusword bits 6, 5, 3..0 for each state */
+static const uint16_t state_status[CIA402_STATE_COUNT] = {
+    [CIA402_STATE_NOT_READY_TO_SWITCH_ON] = 0x0000U,
+    [CIA402_STATE_SWITCH_ON_DISABLED] = 0x0040U,
+    [CIA402_STATE_READY_TO_SWITCH_ON] = 0x0021U,
+    [CIA402_STATE_SWITCHED_ON] = 0x0023U,
+    [CIA402_STATE_OPERATION_ENABLED] = 0x0027U,
+    [CIA402_STATE_QUICK_STOP_ACTIVE] = 0x0007U,
+    [CIA402_STATE_FAULT_REACTION_ACTIVE] = 0x000FU,
+    [CIA402_STATE_FAULT] = 0x0008U,
+};
+
+static cia402_command_t decode_controlword(uint16_t controlword, uint16_t previous)
+{
+    /* Fault reset acts on the rising edge of bit 7 only */
+    if ((controlword & CIA402_CONTROL_FAULT_RESET) != 0U) {
+        return ((previous & CIA402_CONTROL_FAULT_RESET) == 0U) ? CIA402_COMMAND_FAULT_RESET : CIA402_COMMAND_NONE;
+    }
+
+    for (size_t i = 0U; i < sizeof(command_patterns) / sizeof(command_patterns[0]); i++) {
+        if ((controlword & command_patterns[i].mask) == command_patterns[i].value) {
+            return command_patterns[i].command;
+        }
+    }
+
+    return CIA402_COMMAND_NONE;
+}
+
+void cia402_init(cia402_t *drive)
+{
+    if (drive == NULL) {
+        return;
+    }
+
+    memset(drive, 0, sizeof(*drive));
+    drive->state = CIA402_STATE_NOT_READY_TO_SWITCH_ON;
+    drive->statusword = state_status[CIA402_STATE_NOT_READY_TO_SWITCH_ON];
+}
+
+size_t cia402_get_objects(cia402_t *drive, pdo_object_t *objects, size_t max_objects)
+{
+    if (drive == NULL || objects == NULL || max_objects < CIA402_OBJECT_COUNT) {
+        return 0U;
+    }
+
+    const pdo_object_t table[CIA402_OBJECT_COUNT] = {
+        {0x6040U, 0U, sizeof(drive->controlword), PDO_ACCESS_RX, &drive->controlword},
+        {0x6041U, 0U, sizeof(drive->statusword), PDO_ACCESS_TX, &drive->statusword},
+        {0x6060U, 0U, sizeof(drive->mode), PDO_ACCESS_RX, &drive->mode},
+        {0x6061U, 0U, sizeof(drive->mode_display), PDO_ACCESS_TX, &drive->mode_display},
+        {0x603FU, 0U, sizeof(drive->error_code), PDO_ACCESS_TX, &drive->error_code},
+        {0x607AU, 0U, sizeof(drive->target_position), PDO_ACCESS_RX, &drive->target_position},
+        {0x6064U, 0U, sizeof(drive->position_actual), PDO_ACCESS_TX, &drive->position_actual},
+        {0x60FFU, 0U, sizeof(drive->target_velocity), PDO_ACCESS_RX, &drive->target_velocity},
+        {0x606CU, 0U, sizeof(drive->velocity_actual), PDO_ACCESS_TX, &drive->velocity_actual},
+        {0x6071U, 0U, sizeof(drive->target_torque), PDO_ACCESS_RX, &drive->target_torque},
+        {0x6077U, 0U, sizeof(drive->torque_actual), PDO_ACCESS_TX, &drive->torque_actual},
+    };
+
+    memcpy(objects, table, sizeof(table));
+    return CIA402_OBJECT_COUNT;
+}
+
+void cia402_process(cia402_t *drive)
+{
+    cia402_state_t state = drive->state;
+
+    /* Transition 1 happens once initialisation is over, i.e. on the first cycle */
+    if (state == CIA402_STATE_NOT_READY_TO_SWITCH_ON) {
+        state = CIA402_STATE_SWITCH_ON_DISABLED;
+    }
+
+    if (drive->fault_pending) {
+        drive->fault_pending = false;
+        drive->error_code = drive->fault_code;
+        if (state != CIA402_STATE_FAULT) {
+            drive->reaction_complete = false;
+            state = CIA402_STATE_FAULT_REACTION_ACTIVE;                                /* 13 */
+        }
+    }
+
+    if (drive->reaction_complete) {
+        drive->reaction_complete = false;
+        if (state == CIA402_STATE_FAULT_REACTION_ACTIVE) {
+            state = CIA402_STATE_FAULT;                                                /* 14 */
+        } else if (state == CIA402_STATE_QUICK_STOP_ACTIVE) {
+            state = CIA402_STATE_SWITCH_ON_DISABLED;                                   /* 12 */
+        }
+    }
+
+    cia402_command_t command = decode_controlword(drive->controlword, drive->last_controlword);
+    drive->last_controlword = drive->controlword;
+
+    cia402_state_t next = (cia402_state_t)transitions[state][command];
+    if (state == CIA402_STATE_FAULT && next != CIA402_STATE_FAULT) {
+        drive->error_code = 0U;
+    }
+    drive->state = next;
+
+    /* A quick stop or fault reaction finishes in the mode it started in; otherwise the requested mode applies */
+    if (next != CIA402_STATE_QUICK_STOP_ACTIVE && next != CIA402_STATE_FAULT_REACTION_ACTIVE) {
+        drive->mode_display = drive->mode;
+    }
+    drive->statusword = state_status[next] | CIA402_STATUS_REMOTE |
+                        (drive->drive_status & (CIA402_STATUS_VOLTAGE_ENABLED | CIA402_STATUS_WARNING |
+                                                CIA402_STATUS_TARGET_REACHED | CIA402_STATUS_INTERNAL_LIMIT));
+}
+
+void cia402_raise_fault(cia402_t *drive, uint16_t error_code)
+{
+    if (drive == NULL) {
+        return;
+    }
+
+    drive->fault_code = error_code;
+    atomic_signal_fence(memory_order_release);
+    drive->fault_pending = true;
+}
+
+void cia402_reaction_done(cia402_t *drive)
+{
+    if (drive != NULL) {
+        drive->reaction_complete = true;
+    }
+}
+
+void cia402_set_drive_status(cia402_t *drive, uint16_t flags)
+{
+    if (drive != NULL) {
+        drive->drive_status = flags;
+    }
+}
+
+cia402_state_t cia402_get_state(const cia402_t *drive)
+{
+    return (drive != NULL) ? drive->state : CIA402_STATE_NOT_READY_TO_SWITCH_ON;
+}
+
+bool cia402_is_power_enabled(const cia402_t *drive)
+{
+    if (drive == NULL) {
+        return false;
+    }
+
+    cia402_state_t state = drive->state;
+    return state == CIA402_STATE_OPERATION_ENABLED || state == CIA402_STATE_QUICK_STOP_ACTIVE ||
+           state == CIA402_STATE_FAULT_REACTION_ACTIVE;
+}
+
+bool cia402_is_operation_enabled(const cia402_t *drive)
+{
+    return drive != NULL && drive->state == CIA402_STATE_OPERATION_ENABLED;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include "services/cobs/cobs.h"
+#include "service_config.h"
+
+#include <string.h>
+
+#if SERVICE_PROTOCOL_ENABLE
+
+#define COBS_MAX_BLOCK 0xFFU
+
+void cobs_encoder_begin(cobs_encoder_t *encoder, uint8_t *out)
+{
+    encoder->out = out;
+    encoder->code_pos = 0U;
+    encoder->length = 1U;
+    encoder->code = 1U;
+}
+
+void cobs_encoder_put(cobs_encoder_t *encoder, const void *data, size_t length)
+{
+    const uint8_t *src = (const uint8_t *)data;
+    uint8_t *out = encoder->out;
+    size_t pos = encoder->length;
+    size_t code_pos = encoder->code_pos;
+    uint8_t code = encoder->code;
+
+    for (size_t i = 0U; i < length; i++) {
+        if (src[i] != 0U) {
+            out[pos++] = src[i];
+            code++;
+        }
+        /* A zero, or a full block of 254 data bytes, closes the block */
+        if (src[i] == 0U || code == COBS_MAX_BLOCK) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1U;
+        }
+    }
+
+    encoder->length = pos;
+    encoder->code_pos = code_pos;
+    encoder->code = code;
+}
+
+size_t cobs_encoder_end(cobs_encoder_t *encoder)
+{
+    encoder->out[encoder->code_pos] = encoder->code;
+    return encoder->length;
+}
+
+bool cobs_decode_in_place(uint8_t *buffer, size_t length, size_t *decoded_length)
+{
+    size_t read = 0U;
+    size_t write = 0U;
+
+    while (read < length) {
+        uint8_t code = buffer[read++];
+        size_t block = (size_t)code - 1U;
+        if (code == 0U || block > length - read) {
+            return false;
+        }
+
+        /* The output trails the input by at least the code byte */
+        memmove(&buffer[write], &buffer[read], block);
+        write += block;
+        read += block;
+
+        if (code != COBS_MAX_BLOCK && read < length) {
+            buffer[write++] = 0U;
+        }
+    }
+
+    *decoded_length = write;
+    return true;
+}
+
+#endif
@@ -0,0 +1,154 @@
+#include "services/deferred/deferred.h"
+#include "boards/irq.h"
+#include "boards/timebase.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#if SERVICE_DEFERRED_ENABLE
+
+_Static_assert((DEFERRED_QUEUE_SIZE & (DEFERRED_QUEUE_SIZE - 1)) == 0, "deferred queue size must be a power of two");
+
+#define DEFERRED_QUEUE_MASK ((uint32_t)DEFERRED_QUEUE_SIZE - 1U)
+
+/*
+ * A slot's sequence says whose turn it is: equal to the position to post
+ * at when free, one past it once posted, and a lap further on once run.
+ */
+typedef struct {
+    _Atomic uint32_t sequence;
+    deferred_handler_t handler;
+    void *context;
+    uint32_t posted_at;
+    uint32_t payload[(DEFERRED_PAYLOAD_SIZE + 3U) / 4U];
+} deferred_item_t;
+
+typedef struct {
+    deferred_item_t items[DEFERRED_QUEUE_SIZE];
+    _Atomic uint32_t head; /* next position to post at */
+    _Atomic uint32_t tail; /* next position to run, advanced by the software interrupt only */
+    _Atomic uint32_t posted;
+    _Atomic uint32_t dropped;
+    _Atomic uint32_t depth_max;
+    uint32_t latency_last;
+    uint32_t latency_max;
+    uint32_t run_time_max;
+} deferred_queue_t;
+
+static deferred_queue_t deferred_queue;
+
+/* Software interrupt: stops at the first slot still being filled; its poster pends again when done */
+static void deferred_run(void)
+{
+    deferred_queue_t *queue = &deferred_queue;
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    for (;;) {
+        deferred_item_t *item = &queue->items[tail & DEFERRED_QUEUE_MASK];
+        if (atomic_load_explicit(&item->sequence, memory_order_acquire) != tail + 1U) {
+            break;
+        }
+
+        const uint32_t start = board_timebase_now();
+        item->handler(item->context, item->payload);
+        const uint32_t end = board_timebase_now();
+
+        queue->latency_last = start - item->posted_at;
+        if (queue->latency_last > queue->latency_max) {
+            queue->latency_max = queue->latency_last;
+        }
+        if (end - start > queue->run_time_max) {
+            queue->run_time_max = end - start;
+        }
+
+        atomic_store_explicit(&item->sequence, tail + DEFERRED_QUEUE_SIZE, memory_order_release);
+        tail++;
+        atomic_store_explicit(&queue->tail, tail, memory_order_relaxed);
+    }
+}
+
+deferred_error_t deferred_init(void)
+{
+    deferred_queue_t *queue = &deferred_queue;
+
+    memset(queue, 0, sizeof(*queue));
+    for (uint32_t i = 0U; i < DEFERRED_QUEUE_SIZE; i++) {
+        atomic_init(&queue->items[i].sequence, i);
+    }
+    atomic_init(&queue->head, 0U);
+    atomic_init(&queue->tail, 0U);
+    atomic_init(&queue->posted, 0U);
+    atomic_init(&queue->dropped, 0U);
+    atomic_init(&queue->depth_max, 0U);
+
+    board_timebase_init();
+    board_irq_soft_init(deferred_run);
+
+    return DEFERRED_SUCCESS;
+}
+
+deferred_error_t deferred_post(deferred_handler_t handler, void *context, const void *payload, size_t size)
+{
+    if (handler == NULL || size > DEFERRED_PAYLOAD_SIZE || (payload == NULL && size != 0U)) {
+        return DEFERRED_ERROR_INVALID_PARAM;
+    }
+
+    deferred_queue_t *queue = &deferred_queue;
+    const uint32_t now = board_timebase_now();
+
+    /* Claim a slot; a post preempting this one may take it first, then try the next */
+    uint32_t position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    deferred_item_t *item;
+    for (;;) {
+        item = &queue->items[position & DEFERRED_QUEUE_MASK];
+        const int32_t lag = (int32_t)(atomic_load_explicit(&item->sequence, memory_order_acquire) - position);
+        if (lag == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &position, position + 1U, memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (lag < 0) {
+            atomic_fetch_add_explicit(&queue->dropped, 1U, memory_order_relaxed);
+            return DEFERRED_ERROR_FULL;
+        } else {
+            position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+
+    item->handler = handler;
+    item->context = context;
+    item->posted_at = now;
+    if (size != 0U) {
+        memcpy(item->payload, payload, size);
+    }
+
+    /* The tail cannot pass this slot before it is published */
+    const uint32_t depth = position + 1U - atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    atomic_store_explicit(&item->sequence, position + 1U, memory_order_release);
+
+    atomic_fetch_add_explicit(&queue->posted, 1U, memory_order_relaxed);
+    uint32_t depth_max = atomic_load_explicit(&queue->depth_max, memory_order_relaxed);
+    while (depth > depth_max && !atomic_compare_exchange_weak_explicit(&queue->depth_max, &depth_max, depth,
+                                                                        memory_order_relaxed, memory_order_relaxed)) {
+    }
+
+    board_irq_soft_pend();
+    return DEFERRED_SUCCESS;
+}
+
+void deferred_get_stats(deferred_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    deferred_queue_t *queue = &deferred_queue;
+    stats->posted = atomic_load_explicit(&queue->posted, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&queue->dropped, memory_order_relaxed);
+    stats->depth_max = atomic_load_explicit(&queue->depth_max, memory_order_relaxed);
+    stats->latency_last = queue->latency_last;
+    stats->latency_max = queue->latency_max;
+    stats->run_time_max = queue->run_time_max;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#include "services/delta/delta.h"
+#include "service_config.h"
+
+#if SERVICE_SAMPLER_ENABLE
+
+size_t delta_encode_word(uint8_t *out, uint32_t value, uint32_t previous, delta_lanes_t lanes)
+{
+    const unsigned bits = DELTA_LANE_BITS(lanes);
+    uint8_t *end = out;
+
+    for (unsigned shift = 0U; shift < 32U; shift += bits) {
+        uint32_t code = delta_code(value >> shift, previous >> shift, bits);
+        while (code >= 0x80U) {
+            *end++ = (uint8_t)(code | 0x80U);
+            code >>= 7;
+        }
+        *end++ = (uint8_t)code;
+    }
+    return (size_t)(end - out);
+}
+
+void delta_packer_begin(delta_packer_t *packer, uint8_t *out)
+{
+    packer->out = out;
+    packer->pending = 0U;
+    packer->count = 0U;
+}
+
+void delta_packer_put(delta_packer_t *packer, uint32_t code, unsigned width)
+{
+    /* Fewer than 8 bits are pending, so 32 more still fit */
+    packer->pending |= (uint64_t)(code & (uint32_t)((1ULL << width) - 1U)) << packer->count;
+    packer->count += width;
+    while (packer->count >= 8U) {
+        *packer->out++ = (uint8_t)packer->pending;
+        packer->pending >>= 8;
+        packer->count -= 8U;
+    }
+}
+
+uint8_t *delta_packer_end(delta_packer_t *packer)
+{
+    if (packer->count > 0U) {
+        *packer->out++ = (uint8_t)packer->pending;
+        packer->pending = 0U;
+        packer->count = 0U;
+    }
+    return packer->out;
+}
+
+#endif
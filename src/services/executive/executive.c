@@ -0,0 +1,184 @@
+#include "services/executive/executive.h"
+#include "boards/clock.h"
+#include "boards/timebase.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if SERVICE_EXECUTIVE_ENABLE
+
+static void executive_timer_expired(void *context)
+{
+    executive_timer_t *timer = (executive_timer_t *)context;
+    executive_signal(timer->exec, timer->task);
+}
+
+static void executive_run_task(executive_t *exec, uint8_t task_id)
+{
+    executive_task_t *task = &exec->tasks[task_id];
+    executive_task_stats_t *stats = &task->stats;
+
+    const uint32_t start = board_timebase_now();
+    task->handler(task->context);
+    const uint32_t end = board_timebase_now();
+
+    stats->runs++;
+    stats->latency_last = start - task->signalled_at;
+    if (stats->latency_last > stats->latency_max) {
+        stats->latency_max = stats->latency_last;
+    }
+    stats->run_time_last = end - start;
+    if (stats->run_time_last > stats->run_time_max) {
+        stats->run_time_max = stats->run_time_last;
+    }
+    stats->run_time_total += stats->run_time_last;
+}
+
+/* Checked with interrupts masked right before sleeping */
+static bool executive_ready(void *context)
+{
+    executive_t *exec = (executive_t *)context;
+    return atomic_load_explicit(&exec->pending, memory_order_relaxed) != 0U ||
+           timer_wheel_next(&exec->timers) <= board_clock_now64();
+}
+
+static void executive_account_idle(executive_t *exec, uint32_t slept)
+{
+    const uint32_t now = board_clock_now();
+    const uint32_t elapsed = now - exec->window_start;
+
+    exec->window_idle += slept;
+    if (slept > exec->idle_max) {
+        exec->idle_max = slept;
+    }
+
+    if (elapsed >= EXECUTIVE_LOAD_WINDOW_US) {
+        const uint32_t idle = (exec->window_idle < elapsed) ? exec->window_idle : elapsed;
+        exec->load = (uint16_t)(((uint64_t)(elapsed - idle) * 1000U) / elapsed);
+        exec->window_start = now;
+        exec->window_idle = 0U;
+    }
+}
+
+executive_error_t executive_init(executive_t *exec)
+{
+    if (exec == NULL) {
+        return EXECUTIVE_ERROR_INVALID_PARAM;
+    }
+
+    memset(exec, 0, sizeof(*exec));
+    atomic_init(&exec->pending, 0U);
+
+    board_timebase_init();
+    /* Any interrupt ends the sleep; the alarm has nothing left to do */
+    board_clock_init(NULL, NULL);
+    exec->window_start = board_clock_now();
+    timer_wheel_init(&exec->timers, board_clock_now64());
+
+    return EXECUTIVE_SUCCESS;
+}
+
+executive_error_t executive_add_task(executive_t *exec, const char *name, executive_handler_t handler, void *context,
+                                     uint8_t *task_id)
+{
+    if (exec == NULL || handler == NULL || task_id == NULL) {
+        return EXECUTIVE_ERROR_INVALID_PARAM;
+    }
+    if (exec->task_count >= EXECUTIVE_MAX_TASKS) {
+        return EXECUTIVE_ERROR_TOO_MANY;
+    }
+
+    executive_task_t *task = &exec->tasks[exec->task_count];
+    task->handler = handler;
+    task->context = context;
+    task->name = name;
+    *task_id = exec->task_count++;
+
+    return EXECUTIVE_SUCCESS;
+}
+
+void executive_signal(executive_t *exec, uint8_t task_id)
+{
+    if (exec == NULL || task_id >= exec->task_count) {
+        return;
+    }
+
+    const uint32_t now = board_timebase_now();
+    const uint32_t bit = 1UL << task_id;
+
+    /* Latency runs from the first signal; repeats before the task runs coalesce */
+    if ((atomic_fetch_or_explicit(&exec->pending, bit, memory_order_acq_rel) & bit) == 0U) {
+        exec->tasks[task_id].signalled_at = now;
+    }
+}
+
+executive_error_t executive_timer_start(executive_t *exec, executive_timer_t *timer, uint8_t task_id,
+                                        uint32_t delay_us, uint32_t period_us)
+{
+    if (exec == NULL || timer == NULL || task_id >= exec->task_count || delay_us > EXECUTIVE_MAX_DELAY_US ||
+        period_us > EXECUTIVE_MAX_DELAY_US) {
+        return EXECUTIVE_ERROR_INVALID_PARAM;
+    }
+
+    timer_wheel_stop(&exec->timers, &timer->node);
+    timer_wheel_timer_init(&timer->node, executive_timer_expired, timer);
+    timer->exec = exec;
+    timer->task = task_id;
+    timer_wheel_start(&exec->timers, &timer->node, board_clock_now64(), delay_us, period_us);
+
+    return EXECUTIVE_SUCCESS;
+}
+
+void executive_timer_stop(executive_t *exec, executive_timer_t *timer)
+{
+    if (exec == NULL || timer == NULL) {
+        return;
+    }
+    timer_wheel_stop(&exec->timers, &timer->node);
+}
+
+bool executive_poll(executive_t *exec)
+{
+    bool ran = false;
+
+    timer_wheel_advance(&exec->timers, board_clock_now64());
+
+    /* Rescan after every task so a more urgent one signalled meanwhile goes next */
+    for (;;) {
+        const uint32_t pending = atomic_load_explicit(&exec->pending, memory_order_acquire);
+        if (pending == 0U) {
+            break;
+        }
+
+        const uint8_t task_id = (uint8_t)__builtin_ctz(pending);
+        atomic_fetch_and_explicit(&exec->pending, ~(1UL << task_id), memory_order_acq_rel);
+        executive_run_task(exec, task_id);
+        ran = true;
+    }
+
+    return ran;
+}
+
+void executive_run(executive_t *exec)
+{
+    for (;;) {
+        executive_poll(exec);
+
+        /* Without timers still wake before the clock wraps, which the HAL tick catch-up could not tell */
+        const uint64_t now = board_clock_now64();
+        uint64_t wake = timer_wheel_next(&exec->timers);
+        if (wake > now + EXECUTIVE_MAX_DELAY_US) {
+            wake = now + EXECUTIVE_MAX_DELAY_US;
+        }
+        board_clock_set_alarm((uint32_t)wake);
+
+        executive_account_idle(exec, board_clock_sleep(executive_ready, exec));
+    }
+}
+
+uint16_t executive_load(const executive_t *exec)
+{
+    return (exec != NULL) ? exec->load : 0U;
+}
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef SERVICES_CANOPEN_H
+#define SERVICES_CANOPEN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "drivers/can/can.h"
+#include "services/pdo/pdo.h"
+#include "service_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if SERVICE_CANOPEN_ENABLE
+#define CANOPEN_PDO_COUNT SERVICE_CANOPEN_PDO_COUNT
+#else
+#define CANOPEN_PDO_COUNT 1
+#endif
+
+#define CANOPEN_COB_NMT 0x000U
+#define CANOPEN_COB_SYNC 0x080U
+#define CANOPEN_COB_TPDO1 0x180U
+#define CANOPEN_COB_RPDO1 0x200U
+#define CANOPEN_COB_HEARTBEAT 0x700U
+
+typedef enum {
+    CANOPEN_SUCCESS = 0,
+    CANOPEN_ERROR_INVALID_PARAM,
+    CANOPEN_ERROR_CAN,
+    CANOPEN_ERROR_MAPPING,
+    CANOPEN_ERROR_STATE
+} canopen_error_t;
+
+/* CAN interrupt: called for every SYNC in any NMT state, with its timestamp on the board timebase */
+typedef void (*canopen_sync_callback_t)(uint32_t timestamp, void *context);
+
+/* NMT states, valued as in the heartbeat message */
+typedef enum {
+    CANOPEN_NMT_INITIALISING = 0x00,
+    CANOPEN_NMT_STOPPED = 0x04,
+    CANOPEN_NMT_OPERATIONAL = 0x05,
+    CANOPEN_NMT_PRE_OPERATIONAL = 0x7F
+} canopen_nmt_state_t;
+
+typedef struct canopen_t canopen_t;
+
+/* Context of one RPDO subscription: the node and the PDO number the frame belongs to */
+typedef struct {
+    canopen_t *co;
+    uint8_t pdo;
+} canopen_rpdo_handler_t;
+
+/*
+ * CANopen NMT slave with SYNC-driven PDOs. The CAN interrupt stores RPDOs in
+ * double buffers and publishes them on SYNC; the control loop then unpacks
+ * them, runs, and answers with its TPDOs in the same cycle. With a CAN FD bit
+ * rate configured the PDOs carry up to 64 bytes and are sent with bit rate
+ * switching, so a whole axis fits in one frame each way.
+ */
+struct canopen_t {
+    can_t *can;
+    uint8_t node_id;
+    bool fd;
+    volatile canopen_nmt_state_t nmt_state;
+    volatile bool sync_pending;
+    volatile uint32_t sync_count;
+    canopen_sync_callback_t sync_callback;
+    void *sync_context;
+    pdo_map_t rpdo_maps[CANOPEN_PDO_COUNT];
+    pdo_rx_buffer_t rpdo_buffers[CANOPEN_PDO_COUNT];
+    canopen_rpdo_handler_t rpdo_handlers[CANOPEN_PDO_COUNT];
+    pdo_map_t tpdo_maps[CANOPEN_PDO_COUNT];
+    uint32_t tpdo_dropped;
+};
+
+/* Subscribe NMT, SYNC and the RPDOs; call before can_start() */
+canopen_error_t canopen_init(canopen_t *co, can_t *can, uint8_t node_id);
+
+/* Announce the node once the bus is started and enter pre-operational */
+canopen_error_t canopen_start(canopen_t *co);
+
+/* Before canopen_start(): observe SYNC frames, e.g. to synchronise the control loop to the bus */
+void canopen_set_sync_callback(canopen_t *co, canopen_sync_callback_t callback, void *context);
+
+/* Map a PDO (0-based number); mappings only change outside the operational state */
+canopen_error_t canopen_map_rpdo(canopen_t *co, uint8_t pdo, const pdo_object_t *dictionary, size_t dictionary_size,
+                                 const uint32_t *mapping, uint8_t count);
+canopen_error_t canopen_map_tpdo(canopen_t *co, uint8_t pdo, const pdo_object_t *dictionary, size_t dictionary_size,
+                                 const uint32_t *mapping, uint8_t count);
+
+/*
+ * Control loop, at the start of a cycle: true once after every SYNC received
+ * in the operational state, with the RPDO objects updated.
+ */
+bool canopen_sync_begin(canopen_t *co);
+
+/* Control loop, after the cycle that canopen_sync_begin() opened: send the TPDOs */
+void canopen_sync_end(canopen_t *co);
+
+canopen_nmt_state_t canopen_get_nmt_state(const canopen_t *co);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
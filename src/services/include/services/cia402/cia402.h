@@ -0,0 +1,112 @@
+#ifndef SERVICES_CIA402_H
+#define SERVICES_CIA402_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "services/pdo/pdo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CIA402_OBJECT_COUNT 11U
+
+typedef enum {
+    CIA402_STATE_NOT_READY_TO_SWITCH_ON = 0,
+    CIA402_STATE_SWITCH_ON_DISABLED,
+    CIA402_STATE_READY_TO_SWITCH_ON,
+    CIA402_STATE_SWITCHED_ON,
+    CIA402_STATE_OPERATION_ENABLED,
+    CIA402_STATE_QUICK_STOP_ACTIVE,
+    CIA402_STATE_FAULT_REACTION_ACTIVE,
+    CIA402_STATE_FAULT,
+    CIA402_STATE_COUNT
+} cia402_state_t;
+
+/* Device control commands decoded from the controlword */
+typedef enum {
+    CIA402_COMMAND_NONE = 0,
+    CIA402_COMMAND_SHUTDOWN,
+    CIA402_COMMAND_SWITCH_ON, /* also "disable operation" */
+    CIA402_COMMAND_ENABLE_OPERATION,
+    CIA402_COMMAND_DISABLE_VOLTAGE,
+    CIA402_COMMAND_QUICK_STOP,
+    CIA402_COMMAND_FAULT_RESET,
+    CIA402_COMMAND_COUNT
+} cia402_command_t;
+
+/* Modes of operation (0x6060) */
+typedef enum {
+    CIA402_MODE_NONE = 0,
+    CIA402_MODE_PROFILE_POSITION = 1,
+    CIA402_MODE_PROFILE_VELOCITY = 3,
+    CIA402_MODE_CYCLIC_SYNC_POSITION = 8,
+    CIA402_MODE_CYCLIC_SYNC_VELOCITY = 9,
+    CIA402_MODE_CYCLIC_SYNC_TORQUE = 10
+} cia402_mode_t;
+
+/* Statusword flags owned by the drive rather than the state machine */
+#define CIA402_STATUS_VOLTAGE_ENABLED (1U << 4)
+#define CIA402_STATUS_WARNING (1U << 7)
+#define CIA402_STATUS_TARGET_REACHED (1U << 10)
+#define CIA402_STATUS_INTERNAL_LIMIT (1U << 11)
+
+/*
+ * CiA 402 device control. The objects below are mapped into PDOs by
+ * reference; cia402_process() runs once per SYNC cycle in the control loop
+ * after the RPDOs are unpacked, so a controlword takes effect on the same
+ * tick on every axis.
+ */
+typedef struct {
+    /* Process data objects */
+    uint16_t controlword;        /* 0x6040 */
+    uint16_t statusword;         /* 0x6041 */
+    int8_t mode;                 /* 0x6060 modes of operation */
+    int8_t mode_display;         /* 0x6061 */
+    uint16_t error_code;         /* 0x603F */
+    int32_t target_position;     /* 0x607A [inc] */
+    int32_t position_actual;     /* 0x6064 [inc] */
+    int32_t target_velocity;     /* 0x60FF [inc/s] */
+    int32_t velocity_actual;     /* 0x606C [inc/s] */
+    int16_t target_torque;       /* 0x6071 [per mille of rated torque] */
+    int16_t torque_actual;       /* 0x6077 [per mille of rated torque] */
+
+    volatile cia402_state_t state;
+    uint16_t drive_status; /* CIA402_STATUS_* flags from the drive */
+    uint16_t last_controlword;
+    volatile bool fault_pending;
+    volatile uint16_t fault_code;
+    volatile bool reaction_complete;
+} cia402_t;
+
+void cia402_init(cia402_t *drive);
+
+/* Dictionary entries for the CiA 402 objects; returns how many were written */
+size_t cia402_get_objects(cia402_t *drive, pdo_object_t *objects, size_t max_objects);
+
+/* Control loop, once per cycle: decode the controlword, step the state machine, update the statusword */
+void cia402_process(cia402_t *drive);
+
+/* Any context: enter the fault reaction with a CiA 402 error code */
+void cia402_raise_fault(cia402_t *drive, uint16_t error_code);
+
+/* Quick stop ramp or fault reaction has brought the motor to rest */
+void cia402_reaction_done(cia402_t *drive);
+
+void cia402_set_drive_status(cia402_t *drive, uint16_t flags);
+
+cia402_state_t cia402_get_state(const cia402_t *drive);
+
+/* Power stage must be enabled: operation enabled, quick stop or fault reaction in progress */
+bool cia402_is_power_enabled(const cia402_t *drive);
+
+/* Setpoints should be followed; false during quick stop and fault reaction */
+bool cia402_is_operation_enabled(const cia402_t *drive);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef SERVICES_COBS_H
+#define SERVICES_COBS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Encoded size of length bytes, without the zero delimiter */
+#define COBS_MAX_ENCODED_SIZE(length) ((length) + (length) / 254U + 1U)
+
+/*
+ * Consistent overhead byte stuffing: the encoding contains no zero bytes, so
+ * a zero delimits frames. The encoder takes its input in pieces, so a frame
+ * can be encoded straight from a header, a payload struct and a checksum.
+ */
+typedef struct {
+    uint8_t *out;
+    size_t length;   /* bytes written so far */
+    size_t code_pos; /* where the current block's code byte goes */
+    uint8_t code;
+} cobs_encoder_t;
+
+/* out must hold COBS_MAX_ENCODED_SIZE() of the total input */
+void cobs_encoder_begin(cobs_encoder_t *encoder, uint8_t *out);
+void cobs_encoder_put(cobs_encoder_t *encoder, const void *data, size_t length);
+/* Returns the encoded length, without the delimiter */
+size_t cobs_encoder_end(cobs_encoder_t *encoder);
+
+/*
+ * Decode a frame, without its delimiter, in place: the decoded bytes start
+ * at buffer[0]. false if the frame is malformed.
+ */
+bool cobs_decode_in_place(uint8_t *buffer, size_t length, size_t *decoded_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SERVICES_DEFERRED_H
+#define SERVICES_DEFERRED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "service_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if SERVICE_DEFERRED_ENABLE
+#define DEFERRED_QUEUE_SIZE SERVICE_DEFERRED_QUEUE_SIZE
+#define DEFERRED_PAYLOAD_SIZE SERVICE_DEFERRED_PAYLOAD_SIZE
+#else
+#define DEFERRED_QUEUE_SIZE 1
+#define DEFERRED_PAYLOAD_SIZE 4
+#endif
+
+typedef enum {
+    DEFERRED_SUCCESS = 0,
+    DEFERRED_ERROR_INVALID_PARAM,
+    DEFERRED_ERROR_FULL
+} deferred_error_t;
+
+/* Runs in the deferred-work software interrupt with the payload posted */
+typedef void (*deferred_handler_t)(void *context, const void *payload);
+
+/*
+ * Deferred work, the bottom half of an interrupt. An interrupt posts a
+ * handler and a copy of up to DEFERRED_PAYLOAD_SIZE bytes instead of doing
+ * the work itself; a software interrupt at BOARD_IRQ_PRIORITY_DEFERRED
+ * (boards/irq.h) runs the handlers in the order posted once every
+ * interrupt above it has returned.
+ *
+ * The queue is lock-free: posting takes a slot with one compare-and-swap
+ * and never masks interrupts, so an interrupt of any priority may post,
+ * also into a post it has preempted. Handlers may post too.
+ */
+
+/* Times in board timebase ticks */
+typedef struct {
+    uint32_t posted;
+    uint32_t dropped; /* queue full */
+    uint32_t depth_max;
+    uint32_t latency_last; /* from the post to the start of the handler */
+    uint32_t latency_max;
+    uint32_t run_time_max;
+} deferred_stats_t;
+
+deferred_error_t deferred_init(void);
+
+/* Any context. Fails without blocking when the queue is full */
+deferred_error_t deferred_post(deferred_handler_t handler, void *context, const void *payload, size_t size);
+
+void deferred_get_stats(deferred_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
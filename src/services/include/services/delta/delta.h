@@ -0,0 +1,64 @@
+#ifndef SERVICES_DELTA_H
+#define SERVICES_DELTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Delta + zigzag coding of 32-bit words. A word is split into lanes matching
+ * the variables it holds; each lane is coded as its difference to the
+ * previous word, sign-extended to the lane width and zigzag mapped, so small
+ * steps either way give small codes. Codes are then written as
+ * little-endian base-128 varints (LEB128), or bit-packed at a fixed width.
+ */
+typedef enum {
+    DELTA_LANES_32 = 0, /* one 32-bit value */
+    DELTA_LANES_16,     /* two 16-bit values */
+    DELTA_LANES_8       /* four 8-bit values */
+} delta_lanes_t;
+
+#define DELTA_LANE_BITS(lanes) (32U >> (unsigned)(lanes))
+#define DELTA_LANE_COUNT(lanes) (1U << (unsigned)(lanes))
+
+/* Worst case varint size of a word: lanes * ceil(lane bits / 7) */
+#define DELTA_MAX_WORD_SIZE(lanes) ((lanes) == DELTA_LANES_32 ? 5U : ((lanes) == DELTA_LANES_16 ? 6U : 8U))
+
+/* Code of a lane of bits width held in the low bits of value and previous; the bits above are ignored */
+static inline uint32_t delta_code(uint32_t value, uint32_t previous, unsigned bits)
+{
+    const unsigned unused = 32U - bits;
+    const int32_t delta = (int32_t)((value - previous) << unused) >> unused;
+    return ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+}
+
+/* Bits needed for codes, which may be several codes ORed together */
+static inline unsigned delta_width(uint32_t codes)
+{
+    return (codes != 0U) ? 32U - (unsigned)__builtin_clz(codes) : 0U;
+}
+
+/* Varint codes of value against previous; out must hold DELTA_MAX_WORD_SIZE(lanes). Returns bytes written */
+size_t delta_encode_word(uint8_t *out, uint32_t value, uint32_t previous, delta_lanes_t lanes);
+
+/* Bit packer: codes are appended least significant bit first */
+typedef struct {
+    uint8_t *out;
+    uint64_t pending;
+    unsigned count; /* bits in pending */
+} delta_packer_t;
+
+void delta_packer_begin(delta_packer_t *packer, uint8_t *out);
+/* The low width bits of code, width 0 to 32 */
+void delta_packer_put(delta_packer_t *packer, uint32_t code, unsigned width);
+/* Flushes the last partial byte; returns the end of the output */
+uint8_t *delta_packer_end(delta_packer_t *packer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
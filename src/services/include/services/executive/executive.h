@@ -0,0 +1,114 @@
+#ifndef SERVICES_EXECUTIVE_H
+#define SERVICES_EXECUTIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "service_config.h"
+#include "services/timer_wheel/timer_wheel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if SERVICE_EXECUTIVE_ENABLE
+#define EXECUTIVE_MAX_TASKS SERVICE_EXECUTIVE_MAX_TASKS
+#else
+#define EXECUTIVE_MAX_TASKS 1
+#endif
+
+/* CPU load is measured over windows of this length */
+#define EXECUTIVE_LOAD_WINDOW_US 1000000U
+
+/* Longest timer delay or period, and longest sleep: the alarm is set on the wrapping 32-bit clock */
+#define EXECUTIVE_MAX_DELAY_US 0x7FFFFFFFU
+
+typedef enum {
+    EXECUTIVE_SUCCESS = 0,
+    EXECUTIVE_ERROR_INVALID_PARAM,
+    EXECUTIVE_ERROR_TOO_MANY
+} executive_error_t;
+
+typedef void (*executive_handler_t)(void *context);
+
+/* Times in board timebase ticks */
+typedef struct {
+    uint32_t runs;
+    uint32_t latency_last; /* from the signal to the start of the handler */
+    uint32_t latency_max;
+    uint32_t run_time_last;
+    uint32_t run_time_max;
+    uint64_t run_time_total;
+} executive_task_stats_t;
+
+typedef struct {
+    executive_handler_t handler;
+    void *context;
+    const char *name;
+    volatile uint32_t signalled_at;
+    executive_task_stats_t stats;
+} executive_task_t;
+
+/* Owned by the caller and filed in the executive's timer wheel while it runs */
+typedef struct {
+    timer_wheel_timer_t node;
+    struct executive *exec;
+    uint8_t task;
+} executive_timer_t;
+
+/*
+ * Cooperative run-to-completion executive. Tasks are handlers run from the
+ * main loop when signalled, by an interrupt or by a timer; lower task IDs
+ * run first. When nothing is pending the core sleeps until the next timer
+ * deadline or interrupt, so the main loop never busy-waits.
+ *
+ * executive_signal() may be called from any context. Everything else
+ * belongs to the main loop and the task handlers.
+ */
+typedef struct executive {
+    executive_task_t tasks[EXECUTIVE_MAX_TASKS];
+    uint8_t task_count;
+    _Atomic uint32_t pending; /* a bit per task */
+    timer_wheel_t timers;
+    /* CPU load */
+    uint32_t window_start; /* board clock [us] */
+    uint32_t window_idle;  /* [us] */
+    uint16_t load;         /* busy share of the last window [permille] */
+    uint32_t idle_max;     /* longest single sleep [us] */
+} executive_t;
+
+executive_error_t executive_init(executive_t *exec);
+
+/* Task IDs are given out in order of registration, so register the most urgent first */
+executive_error_t executive_add_task(executive_t *exec, const char *name, executive_handler_t handler, void *context,
+                                     uint8_t *task_id);
+
+/* Any context. A task signalled again before it runs runs once */
+void executive_signal(executive_t *exec, uint8_t task_id);
+
+/*
+ * Signal task_id after delay_us and then every period_us, or once if
+ * period_us is 0. Both are rounded up to the timer wheel tick
+ * (SERVICE_TIMER_WHEEL_TICK_US). Periods missed while the main loop was
+ * busy are skipped, not made up. Restarts the timer if it is already
+ * running.
+ */
+executive_error_t executive_timer_start(executive_t *exec, executive_timer_t *timer, uint8_t task_id,
+                                        uint32_t delay_us, uint32_t period_us);
+void executive_timer_stop(executive_t *exec, executive_timer_t *timer);
+
+/* Signal the tasks of expired timers, then run every pending task. Returns true if any ran */
+bool executive_poll(executive_t *exec);
+
+/* Poll and sleep in between, forever */
+void executive_run(executive_t *exec);
+
+/* Busy share of the last complete load window [permille] */
+uint16_t executive_load(const executive_t *exec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
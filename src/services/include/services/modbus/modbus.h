@@ -0,0 +1,95 @@
+#ifndef SERVICES_MODBUS_H
+#define SERVICES_MODBUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "drivers/crc/crc.h"
+#include "service_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MODBUS_BROADCAST_ADDRESS 0U
+#define MODBUS_MAX_ADU 256U /* RTU frame: address, PDU of up to 253 bytes, CRC */
+
+/* Function codes */
+#define MODBUS_FC_READ_HOLDING_REGISTERS 0x03U
+#define MODBUS_FC_READ_INPUT_REGISTERS 0x04U
+#define MODBUS_FC_WRITE_SINGLE_REGISTER 0x06U
+#define MODBUS_FC_DIAGNOSTICS 0x08U
+#define MODBUS_FC_WRITE_MULTIPLE_REGISTERS 0x10U
+
+/* Exception codes */
+#define MODBUS_EXCEPTION_ILLEGAL_FUNCTION 0x01U
+#define MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS 0x02U
+#define MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE 0x03U
+
+struct board_rs485_config_t;
+
+typedef enum {
+    MODBUS_SUCCESS = 0,
+    MODBUS_ERROR_INVALID_PARAM,
+    MODBUS_ERROR_HARDWARE
+} modbus_error_t;
+
+/*
+ * Consecutive registers backed directly by application storage: register
+ * address + i is data[i], read and written in place. A 32-bit variable
+ * takes two registers, low half first as it is stored in memory, and the
+ * master may see its halves from different control cycles.
+ */
+typedef struct {
+    uint16_t address;
+    uint16_t count;
+    volatile uint16_t *data;
+    bool writable; /* holding registers only; input registers are always read-only */
+} modbus_block_t;
+
+typedef struct {
+    const modbus_block_t *holding;
+    size_t holding_count;
+    const modbus_block_t *input;
+    size_t input_count;
+} modbus_map_t;
+
+/* Counters as served by the diagnostics function, and the response latency */
+typedef struct {
+    uint32_t bus_messages;   /* frames with a valid CRC, for any slave */
+    uint32_t bus_errors;     /* frames lost to CRC, parity or framing errors */
+    uint32_t exceptions;
+    uint32_t slave_messages; /* addressed to this slave, broadcasts included */
+    uint32_t no_responses;   /* broadcasts, which are never answered */
+    /* Board timebase ticks from the receiver timeout to the start of the reply */
+    uint32_t latency_last;
+    uint32_t latency_max;
+} modbus_stats_t;
+
+/*
+ * Modbus RTU slave on an RS-485 UART. The hardware receiver timeout marks
+ * the end of a request after 3.5 character times of silence (1.75 ms above
+ * 19200 baud), and the request is answered from that interrupt, so the
+ * response time is bounded by the timeout plus the handling measured in
+ * stats. The 1.5 character inter-byte limit is not checked.
+ */
+typedef struct {
+    const struct board_rs485_config_t *hw_config;
+    const modbus_map_t *map;
+    uint8_t slave_id;
+    crc_t crc;
+    modbus_stats_t stats;
+    uint8_t rx_buffer[MODBUS_MAX_ADU];
+    uint8_t tx_buffer[MODBUS_MAX_ADU];
+} modbus_t;
+
+/* Blocks must not overlap; the map and the storage it points to must outlive the slave */
+modbus_error_t modbus_init(modbus_t *mb, const struct board_rs485_config_t *hw_config, uint8_t slave_id,
+                           const modbus_map_t *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef SERVICES_PDO_H
+#define SERVICES_PDO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "service_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if SERVICE_CANOPEN_ENABLE
+#define PDO_MAX_ENTRIES SERVICE_PDO_MAX_ENTRIES
+#else
+#define PDO_MAX_ENTRIES 1
+#endif
+#define PDO_MAX_LENGTH 64U
+
+/* CANopen mapping entry: index, subindex and length in bits */
+#define PDO_MAPPING(index, subindex, bits) (((uint32_t)(index) << 16) | ((uint32_t)(subindex) << 8) | (uint32_t)(bits))
+
+typedef enum {
+    PDO_SUCCESS = 0,
+    PDO_ERROR_INVALID_PARAM,
+    PDO_ERROR_NO_OBJECT,
+    PDO_ERROR_LENGTH,
+    PDO_ERROR_NOT_MAPPABLE
+} pdo_error_t;
+
+#define PDO_ACCESS_RX 0x01U /* may be written by an RPDO */
+#define PDO_ACCESS_TX 0x02U /* may be read into a TPDO */
+
+/* Object dictionary entry backed by a variable; CANopen and the target are both little endian */
+typedef struct {
+    uint16_t index;
+    uint8_t subindex;
+    uint8_t size; /* [bytes] */
+    uint8_t access;
+    void *data;
+} pdo_object_t;
+
+typedef struct {
+    uint8_t *data;
+    uint8_t size;
+} pdo_item_t;
+
+/*
+ * A PDO mapping resolved once against the object dictionary. Packing and
+ * unpacking then walk a short array of pointer/size pairs with no lookups.
+ */
+typedef struct {
+    pdo_item_t items[PDO_MAX_ENTRIES];
+    uint8_t count;
+    uint8_t length; /* [bytes] */
+} pdo_map_t;
+
+/*
+ * Received process data double buffer. The CAN interrupt fills the back
+ * buffer; SYNC publishes it to the front, which the control loop reads. The
+ * control loop interrupt must have the higher priority, so it never sees a
+ * buffer the CAN interrupt is writing.
+ */
+typedef struct {
+    uint8_t buffers[2][PDO_MAX_LENGTH];
+    uint8_t lengths[2];
+    volatile uint8_t front;
+    volatile bool received; /* back buffer holds a frame since the last SYNC */
+    volatile bool fresh;    /* front buffer not consumed yet */
+} pdo_rx_buffer_t;
+
+/* Resolve CANopen mapping entries; access is PDO_ACCESS_RX or PDO_ACCESS_TX */
+pdo_error_t pdo_map_configure(pdo_map_t *map, const pdo_object_t *dictionary, size_t dictionary_size,
+                              const uint32_t *mapping, uint8_t count, uint8_t access);
+
+const pdo_object_t *pdo_find_object(const pdo_object_t *dictionary, size_t dictionary_size, uint16_t index,
+                                    uint8_t subindex);
+
+static inline void pdo_pack(const pdo_map_t *map, uint8_t *buffer)
+{
+    for (uint8_t i = 0U; i < map->count; i++) {
+        memcpy(buffer, map->items[i].data, map->items[i].size);
+        buffer += map->items[i].size;
+    }
+}
+
+static inline void pdo_unpack(const pdo_map_t *map, const uint8_t *buffer)
+{
+    for (uint8_t i = 0U; i < map->count; i++) {
+        memcpy(map->items[i].data, buffer, map->items[i].size);
+        buffer += map->items[i].size;
+    }
+}
+
+void pdo_rx_buffer_init(pdo_rx_buffer_t *buffer);
+
+/* CAN interrupt: store a received frame in the back buffer */
+static inline void pdo_rx_buffer_write(pdo_rx_buffer_t *buffer, const uint8_t *data, uint8_t length)
+{
+    uint8_t back = buffer->front ^ 1U;
+    if (length > PDO_MAX_LENGTH) {
+        length = PDO_MAX_LENGTH;
+    }
+    memcpy(buffer->buffers[back], data, length);
+    buffer->lengths[back] = length;
+    buffer->received = true;
+}
+
+/* CAN interrupt, on SYNC: publish the frame received during the last cycle */
+static inline void pdo_rx_buffer_swap(pdo_rx_buffer_t *buffer)
+{
+    if (buffer->received) {
+        buffer->received = false;
+        buffer->front ^= 1U;
+        buffer->fresh = true;
+    }
+}
+
+/* Control loop: unpack the published frame once; false when there is none or it is too short */
+static inline bool pdo_rx_buffer_apply(pdo_rx_buffer_t *buffer, const pdo_map_t *map)
+{
+    if (!buffer->fresh) {
+        return false;
+    }
+    buffer->fresh = false;
+
+    uint8_t front = buffer->front;
+    if (buffer->lengths[front] < map->length) {
+        return false;
+    }
+    pdo_unpack(map, buffer->buffers[front]);
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
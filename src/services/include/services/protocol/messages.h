@@ -0,0 +1,120 @@
+#ifndef SERVICES_PROTOCOL_MESSAGES_H
+#define SERVICES_PROTOCOL_MESSAGES_H
+
+#include <stdint.h>
+
+/*
+ * Message identifiers and payload layouts, shared by the firmware and host
+ * tools. Payloads are packed little-endian structs read in place from the
+ * receive buffer; packing makes the compiler use unaligned-safe accesses.
+ */
+
+#define PROTOCOL_PACKED __attribute__((packed))
+
+#define PROTOCOL_VERSION 1U
+
+/*
+ * Requests from the host use IDs below 0x7E; replies set the top bit of the
+ * request ID. 0xFE and 0xFF are sent by the device on its own.
+ */
+#define PROTOCOL_REPLY(id) ((uint8_t)((id) | 0x80U))
+
+#define PROTOCOL_MSG_PING 0x00U     /* any payload, echoed back */
+#define PROTOCOL_MSG_GET_INFO 0x01U /* no payload, replied with protocol_info_t */
+
+/* Variable registry (services/registry) */
+#define PROTOCOL_MSG_REGISTRY_READ 0x02U     /* protocol_registry_id_t, replied with protocol_registry_value_t */
+#define PROTOCOL_MSG_REGISTRY_WRITE 0x03U    /* protocol_registry_value_t, replied with the value now held */
+#define PROTOCOL_MSG_REGISTRY_FIND 0x04U     /* variable name, replied with protocol_registry_info_t */
+#define PROTOCOL_MSG_REGISTRY_DESCRIBE 0x05U /* protocol_registry_id_t, replied with protocol_registry_info_t */
+
+/* Memory sampler (services/sampler) */
+#define PROTOCOL_MSG_SAMPLER_SUBSCRIBE 0x06U /* protocol_sampler_subscribe_t, replied with protocol_sampler_status_t */
+#define PROTOCOL_MSG_SAMPLER_CONTROL 0x07U   /* protocol_sampler_control_t, replied with protocol_sampler_status_t */
+#define PROTOCOL_MSG_SAMPLER_FORMAT 0x08U    /* protocol_sampler_format_t, replied with protocol_sampler_status_t */
+#define PROTOCOL_MSG_SAMPLER_DATA 0xFEU      /* protocol_sampler_data_t, streamed while running */
+#define PROTOCOL_MSG_ERROR 0xFFU    /* protocol_error_payload_t, in place of a reply */
+
+typedef enum {
+    PROTOCOL_STATUS_UNKNOWN_MESSAGE = 1,
+    PROTOCOL_STATUS_BAD_LENGTH,
+    PROTOCOL_STATUS_REJECTED,
+    PROTOCOL_STATUS_NOT_FOUND,
+    PROTOCOL_STATUS_OUT_OF_RANGE
+} protocol_status_t;
+
+typedef struct PROTOCOL_PACKED {
+    uint8_t message_id;
+    uint8_t status; /* protocol_status_t */
+} protocol_error_payload_t;
+
+typedef struct PROTOCOL_PACKED {
+    uint16_t version;
+    uint16_t max_payload;
+    uint8_t max_messages;
+} protocol_info_t;
+
+typedef struct PROTOCOL_PACKED {
+    uint16_t id;
+} protocol_registry_id_t;
+
+typedef struct PROTOCOL_PACKED {
+    uint16_t id;
+    uint8_t type;   /* registry_type_t; ignored in a write */
+    uint32_t value; /* registry_value_t bits */
+} protocol_registry_value_t;
+
+/* Followed by the name, without terminator, to the end of the payload */
+typedef struct PROTOCOL_PACKED {
+    uint16_t id;
+    uint16_t count; /* variables in the registry */
+    uint8_t type;
+    uint8_t access;
+} protocol_registry_info_t;
+
+/* Followed by the 32-bit word addresses to sample, to the end of the payload; none unsubscribes */
+typedef struct PROTOCOL_PACKED {
+    uint16_t divider; /* sample every divider-th tick */
+} protocol_sampler_subscribe_t;
+
+typedef struct PROTOCOL_PACKED {
+    uint8_t run;
+} protocol_sampler_control_t;
+
+/*
+ * Sampler data encodings. Delta coded frames start with the first sample as
+ * it is; the codes of services/delta for the others refer to the sample
+ * before. Bit-packed frames put a width byte per lane in front.
+ */
+#define PROTOCOL_SAMPLER_RAW 0U    /* the words as they are */
+#define PROTOCOL_SAMPLER_DELTA 1U  /* varints */
+#define PROTOCOL_SAMPLER_PACKED 2U /* bit-packed at the widest code of each lane in the frame */
+
+/*
+ * Followed by one delta_lanes_t per subscribed word, except for
+ * PROTOCOL_SAMPLER_RAW. A new subscription goes back to PROTOCOL_SAMPLER_RAW.
+ */
+typedef struct PROTOCOL_PACKED {
+    uint8_t encoding;
+} protocol_sampler_format_t;
+
+typedef struct PROTOCOL_PACKED {
+    uint32_t next_index; /* index of the next sample taken */
+    uint32_t overruns;   /* samples dropped because the buffer was full */
+    uint16_t divider;
+    uint8_t words;
+    uint8_t running;
+} protocol_sampler_status_t;
+
+/*
+ * Followed by records consecutive samples of words 32-bit words each, in
+ * the encoding of protocol_sampler_format_t. Every frame decodes on its own.
+ */
+typedef struct PROTOCOL_PACKED {
+    uint32_t first_index;
+    uint8_t words;
+    uint8_t records;
+    uint8_t encoding;
+} protocol_sampler_data_t;
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef SERVICES_PROTOCOL_H
+#define SERVICES_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "drivers/crc/crc.h"
+#include "drivers/uart/uart.h"
+#include "drivers/usb_cdc/usb_cdc.h"
+#include "services/protocol/messages.h"
+#include "service_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if SERVICE_PROTOCOL_ENABLE
+#define PROTOCOL_MAX_PAYLOAD SERVICE_PROTOCOL_MAX_PAYLOAD
+#define PROTOCOL_MAX_MESSAGES SERVICE_PROTOCOL_MAX_MESSAGES
+#else
+#define PROTOCOL_MAX_PAYLOAD 1
+#define PROTOCOL_MAX_MESSAGES 1
+#endif
+
+typedef enum {
+    PROTOCOL_SUCCESS = 0,
+    PROTOCOL_ERROR_INVALID_PARAM,
+    PROTOCOL_ERROR_LENGTH,
+    PROTOCOL_ERROR_BUFFER_FULL
+} protocol_error_t;
+
+typedef struct {
+    uint8_t id;
+    uint8_t seq;
+    uint16_t length;
+    const uint8_t *payload; /* in the receive ring; only valid during the handler */
+} protocol_frame_t;
+
+/* The payload as a message struct, or NULL when the length does not match */
+#define PROTOCOL_PAYLOAD(frame, type) \
+    ((frame)->length == sizeof(type) ? (const type *)(const void *)(frame)->payload : NULL)
+
+typedef struct protocol_t protocol_t;
+
+typedef void (*protocol_handler_t)(protocol_t *protocol, const protocol_frame_t *frame, void *context);
+
+typedef struct {
+    protocol_handler_t handler;
+    void *context;
+} protocol_subscription_t;
+
+typedef enum {
+    PROTOCOL_LINK_UART = 0,
+    PROTOCOL_LINK_USB_CDC
+} protocol_link_t;
+
+/*
+ * Binary request/reply and telemetry protocol over a UART or the USB
+ * virtual serial port. Frame, before COBS encoding and the zero delimiter:
+ *
+ *   id (1) | seq (1) | payload (0..PROTOCOL_MAX_PAYLOAD) | CRC-16/CCITT-FALSE (2, little endian)
+ *
+ * Frames are decoded in place in the receive ring of the link and dispatched
+ * by ID through a table; handlers see the payload where it was received.
+ */
+struct protocol_t {
+    protocol_link_t link;
+    union {
+        uart_t *uart;
+        usb_cdc_t *usb_cdc;
+    };
+    crc_t crc;
+    protocol_subscription_t handlers[PROTOCOL_MAX_MESSAGES];
+    size_t scanned; /* received bytes already searched for a delimiter */
+    uint8_t tx_seq;
+    uint32_t rx_frames;
+    uint32_t rx_errors;
+    uint32_t tx_dropped;
+};
+
+/* Registers the built-in PING and GET_INFO handlers */
+protocol_error_t protocol_init(protocol_t *protocol, uart_t *uart);
+protocol_error_t protocol_init_usb_cdc(protocol_t *protocol, usb_cdc_t *usb_cdc);
+
+protocol_error_t protocol_register(protocol_t *protocol, uint8_t id, protocol_handler_t handler, void *context);
+
+/* Background context: handle every complete frame received; returns how many */
+size_t protocol_poll(protocol_t *protocol);
+
+/* Background context: send a frame, whole or not at all */
+protocol_error_t protocol_send(protocol_t *protocol, uint8_t id, uint8_t seq, const void *payload, size_t length);
+
+/* Answer a request with the reply ID and its sequence number */
+protocol_error_t protocol_reply(protocol_t *protocol, const protocol_frame_t *request, const void *payload,
+                                size_t length);
+
+protocol_error_t protocol_send_error(protocol_t *protocol, const protocol_frame_t *request, protocol_status_t status);
+
+/* Unsolicited message, e.g. telemetry, with a running sequence number */
+protocol_error_t protocol_publish(protocol_t *protocol, uint8_t id, const void *payload, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef SERVICES_REGISTRY_H
+#define SERVICES_REGISTRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "service_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    REGISTRY_SUCCESS = 0,
+    REGISTRY_ERROR_INVALID_PARAM,
+    REGISTRY_ERROR_NOT_FOUND,
+    REGISTRY_ERROR_READ_ONLY,
+    REGISTRY_ERROR_RANGE
+} registry_error_t;
+
+/* Wire values of the registry messages; keep in step with tools/gen_registry.py */
+typedef enum {
+    REGISTRY_TYPE_BOOL = 0,
+    REGISTRY_TYPE_U8,
+    REGISTRY_TYPE_I8,
+    REGISTRY_TYPE_U16,
+    REGISTRY_TYPE_I16,
+    REGISTRY_TYPE_U32,
+    REGISTRY_TYPE_I32,
+    REGISTRY_TYPE_FLOAT
+} registry_type_t;
+
+#define REGISTRY_ACCESS_READ 0x01U
+#define REGISTRY_ACCESS_WRITE 0x02U
+
+/* A variable's value widened to 32 bits; the member in use follows the entry type */
+typedef union {
+    uint32_t u;
+    int32_t i;
+    float f;
+} registry_value_t;
+
+/*
+ * Variables are at most 32 bits wide and naturally aligned, so every read
+ * and write is a single load or store and never tears against an
+ * interrupt updating the same variable.
+ */
+typedef struct {
+    const char *name;
+    volatile void *data;
+    uint32_t hash; /* registry_hash() of the name */
+    registry_value_t min;
+    registry_value_t max;
+    uint8_t type;
+    uint8_t access;
+} registry_entry_t;
+
+/*
+ * Generated by tools/gen_registry.py. Entries are indexed by ID. A name
+ * hash h selects bucket h % bucket_count, whose seed places it in slot
+ * registry_mix(h, seed) % count; slots holds the ID for each slot.
+ */
+typedef struct {
+    const registry_entry_t *entries;
+    const uint16_t *slots;
+    const uint16_t *seeds;
+    uint16_t count;
+    uint16_t bucket_count;
+} registry_table_t;
+
+/* Defined by the generated registry source linked into the application */
+extern const registry_table_t registry_table;
+
+/* FNV-1a of the name */
+static inline uint32_t registry_hash(const char *name, size_t length)
+{
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0U; i < length; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static inline uint32_t registry_mix(uint32_t hash, uint32_t seed)
+{
+    hash ^= seed * 0x9E3779B9U;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6BU;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35U;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+uint16_t registry_count(void);
+
+/* NULL for an unknown ID */
+const registry_entry_t *registry_get(uint16_t id);
+
+/*
+ * Name to ID with one hash and one table probe. The name is not compared:
+ * the generator guarantees distinct 32-bit hashes, so a stored hash that
+ * matches identifies the variable.
+ */
+registry_error_t registry_find(const char *name, size_t length, uint16_t *id);
+
+registry_error_t registry_read(uint16_t id, registry_value_t *value);
+
+/* Checked against the access and range from the registry definition */
+registry_error_t registry_write(uint16_t id, registry_value_t value);
+
+#if SERVICE_REGISTRY_ENABLE && SERVICE_PROTOCOL_ENABLE
+struct protocol_t;
+
+/* Serve the registry messages of services/protocol/messages.h */
+void registry_protocol_register(struct protocol_t *protocol);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
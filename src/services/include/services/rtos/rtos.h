@@ -0,0 +1,118 @@
+#ifndef SERVICES_RTOS_H
+#define SERVICES_RTOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cmsis_os2.h"
+#include "boards/rtos_port.h"
+#include "service_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Minimal preemptive kernel behind the CMSIS-RTOS2 API (cmsis_os2.h). It
+ * implements the kernel, thread, event flags, mutex and message queue
+ * functions; the others are not provided.
+ *
+ * Nothing is allocated at run time. Control blocks come from cb_mem in the
+ * attributes, sized by the types below, or from a fixed pool of
+ * SERVICE_RTOS_POOL_SIZE of each kind. Thread stacks and message queue
+ * storage must be passed in stack_mem and mq_mem.
+ *
+ * Differences to the full API:
+ * - Threads are detached; osThreadJoin() and thread flags are not provided.
+ * - Messages are delivered in FIFO order; msg_prio is ignored.
+ * - Threads of equal priority are not time sliced; they take turns on
+ *   osThreadYield() or when blocking.
+ * - Mutexes held by a terminated thread are released, robust or not.
+ */
+#if SERVICE_RTOS_ENABLE
+#define RTOS_POOL_SIZE SERVICE_RTOS_POOL_SIZE
+#define RTOS_TICK_FREQUENCY SERVICE_RTOS_TICK_FREQUENCY
+#else
+#define RTOS_POOL_SIZE 1
+#define RTOS_TICK_FREQUENCY 1000
+#endif
+
+/* Bytes of mq_mem for msg_count messages of msg_size bytes */
+#define RTOS_MESSAGE_QUEUE_MEM_SIZE(msg_count, msg_size) ((msg_count) * (((msg_size) + 3U) & ~3U))
+
+typedef struct rtos_thread rtos_thread_t;
+typedef struct rtos_mutex rtos_mutex_t;
+
+/* Common to every control block */
+typedef struct {
+    uint8_t type;
+    bool pooled;
+    const char *name;
+} rtos_object_t;
+
+struct rtos_thread {
+    board_rtos_thread_t port; /* first: the context switch keeps the saved context here */
+    rtos_object_t object;
+    uint8_t priority; /* including inherited priority */
+    uint8_t base_priority;
+    osThreadState_t state;
+    rtos_thread_t *next; /* in the ready list or a wait list */
+    rtos_thread_t **wait_list;
+    rtos_thread_t *delay_next;
+    uint32_t wake_tick;
+    bool delayed;
+    osStatus_t wait_status;
+    uint32_t wait_flags; /* event flags waited for, then the flags that ended the wait */
+    uint32_t wait_options;
+    void *wait_message; /* message to fill or to take */
+    rtos_mutex_t *mutexes; /* held */
+    rtos_mutex_t *blocked_on;
+    uint8_t *stack;
+    uint32_t stack_size;
+};
+
+struct rtos_mutex {
+    rtos_object_t object;
+    uint32_t attr_bits;
+    rtos_thread_t *owner;
+    uint32_t count;
+    rtos_thread_t *waiters;
+    rtos_mutex_t *next_held;
+};
+
+typedef struct {
+    rtos_object_t object;
+    uint32_t flags;
+    rtos_thread_t *waiters;
+} rtos_event_flags_t;
+
+typedef struct {
+    rtos_object_t object;
+    uint8_t *buffer;
+    uint32_t msg_size;
+    uint32_t slot_size;
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t head;
+    rtos_thread_t *getters;
+    rtos_thread_t *putters;
+} rtos_message_queue_t;
+
+/*
+ * Context switch latency in board timebase ticks: from the kernel deciding
+ * to switch, in a kernel call or interrupt, to the new thread's registers
+ * being restored.
+ */
+typedef struct {
+    uint32_t switches;
+    uint32_t latency_last;
+    uint32_t latency_max;
+} rtos_switch_stats_t;
+
+void rtos_get_switch_stats(rtos_switch_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
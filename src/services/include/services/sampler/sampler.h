@@ -0,0 +1,126 @@
+#ifndef SERVICES_SAMPLER_H
+#define SERVICES_SAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "services/protocol/protocol.h"
+#include "services/delta/delta.h"
+#include "service_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if SERVICE_SAMPLER_ENABLE
+#define SAMPLER_MAX_WORDS SERVICE_SAMPLER_MAX_WORDS
+#define SAMPLER_BUFFER_WORDS SERVICE_SAMPLER_BUFFER_WORDS
+#else
+#define SAMPLER_MAX_WORDS 1
+#define SAMPLER_BUFFER_WORDS 2
+#endif
+
+typedef enum {
+    SAMPLER_SUCCESS = 0,
+    SAMPLER_ERROR_INVALID_PARAM,
+    SAMPLER_ERROR_ADDRESS,
+    SAMPLER_ERROR_TOO_MANY,
+    SAMPLER_ERROR_ENCODING
+} sampler_error_t;
+
+/*
+ * Samples a list of aligned 32-bit words every divider-th control tick. The
+ * host resolves variable names to addresses from the firmware ELF and
+ * subscribes the words holding them; narrower variables are cut out of
+ * their word on the host. A sample is the sample index followed by the
+ * words, so a tick costs one load and one store per subscribed word.
+ *
+ * The control loop is the only producer and the background context the
+ * only consumer of the sample buffer. Encoding happens in the background
+ * context, so delta coding adds nothing to the tick.
+ */
+typedef struct {
+    const volatile uint32_t *addresses[SAMPLER_MAX_WORDS];
+    uint32_t buffer[SAMPLER_BUFFER_WORDS];
+    uint8_t words;
+    uint16_t divider;
+    uint16_t countdown;
+    uint16_t capacity; /* samples that fit the buffer */
+    volatile uint16_t head;
+    volatile uint16_t tail;
+    volatile bool running;
+    uint32_t next_index;
+    uint32_t overruns;
+    uint8_t encoding; /* PROTOCOL_SAMPLER_RAW, _DELTA or _PACKED */
+    uint8_t lanes[SAMPLER_MAX_WORDS]; /* delta_lanes_t of each word */
+    uint8_t lane_count;
+    uint16_t max_sample_size; /* varint bytes of a sample, worst case */
+    /* Bit-packing: the codes of a frame ORed per lane */
+    uint32_t lane_codes[SAMPLER_MAX_WORDS * DELTA_LANE_COUNT(DELTA_LANES_8)];
+} sampler_t;
+
+sampler_error_t sampler_init(sampler_t *sampler);
+
+/*
+ * Background context: replace the subscription and discard buffered
+ * samples; stops sampling. Addresses must be word aligned and inside the
+ * variables in RAM. A count of zero unsubscribes.
+ */
+sampler_error_t sampler_subscribe(sampler_t *sampler, const uint32_t *addresses, uint8_t count, uint16_t divider);
+
+/*
+ * Background context: how sampler_process() encodes samples from now on.
+ * lanes gives a delta_lanes_t per subscribed word and is not read for
+ * PROTOCOL_SAMPLER_RAW. Buffered samples are kept.
+ */
+sampler_error_t sampler_set_encoding(sampler_t *sampler, uint8_t encoding, const uint8_t *lanes);
+
+void sampler_start(sampler_t *sampler);
+void sampler_stop(sampler_t *sampler);
+
+/* Control loop, once per tick */
+static inline void sampler_tick(sampler_t *sampler)
+{
+    if (!sampler->running || --sampler->countdown != 0U) {
+        return;
+    }
+    sampler->countdown = sampler->divider;
+
+    uint16_t head = sampler->head;
+    uint16_t next = (uint16_t)(head + 1U);
+    if (next == sampler->capacity) {
+        next = 0U;
+    }
+    if (next == sampler->tail) {
+        sampler->next_index++;
+        sampler->overruns++;
+        return;
+    }
+
+    uint32_t *sample = &sampler->buffer[(size_t)head * (sampler->words + 1U)];
+    sample[0] = sampler->next_index++;
+    for (uint8_t i = 0U; i < sampler->words; i++) {
+        sample[i + 1U] = *sampler->addresses[i];
+    }
+
+    atomic_signal_fence(memory_order_release);
+    sampler->head = next;
+}
+
+/*
+ * Background context: send buffered samples as PROTOCOL_MSG_SAMPLER_DATA
+ * frames; returns samples sent. Each sample is coded at most three times,
+ * and each time costs at most four lane codes per word.
+ */
+size_t sampler_process(sampler_t *sampler, protocol_t *protocol);
+
+/* Serve the sampler messages of services/protocol/messages.h */
+void sampler_protocol_register(sampler_t *sampler, protocol_t *protocol);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef SERVICES_TIME_SYNC_H
+#define SERVICES_TIME_SYNC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TIME_SYNC_SUCCESS = 0,
+    TIME_SYNC_ERROR_INVALID_PARAM
+} time_sync_error_t;
+
+typedef enum {
+    TIME_SYNC_STATE_UNLOCKED = 0, /* no SYNC yet, or SYNC lost: holding the last frequency correction */
+    TIME_SYNC_STATE_ACQUIRING,
+    TIME_SYNC_STATE_LOCKED
+} time_sync_state_t;
+
+/* All times on the board timebase (boards/timebase.h) */
+typedef struct {
+    uint32_t tick_period;    /* nominal control tick [timebase ticks] */
+    uint32_t pwm_period;     /* PWM timer period giving one nominal control tick [timer counts] */
+    uint16_t ticks_per_sync; /* control ticks per SYNC period */
+    int32_t phase_offset;    /* target delay from SYNC to cycle tick 0 [timebase ticks] */
+    float kp;                /* phase correction per SYNC, fraction of the error */
+    float ki;                /* frequency correction per SYNC, fraction of the error */
+    float max_adjust;        /* period change limit, fraction of the nominal period */
+    uint32_t lock_window;    /* |phase error| to count as locked [timebase ticks] */
+    uint16_t lock_count;     /* SYNCs inside the window before reporting lock */
+    uint16_t timeout_syncs;  /* missed SYNC periods before dropping to holdover */
+} time_sync_config_t;
+
+typedef struct {
+    time_sync_state_t state;
+    int32_t phase_error_ns; /* control tick 0 relative to its target, positive when late */
+    int32_t adjust_ppm;     /* current period correction */
+    uint32_t sync_count;
+    uint32_t holdovers;     /* times the SYNC was lost */
+} time_sync_status_t;
+
+/*
+ * Phase-locks the control loop to the bus SYNC. The CAN interrupt hands over
+ * the hardware timestamp of every SYNC; on the next control tick a PI loop
+ * turns the phase error into a small change of the PWM period, applied over
+ * the following SYNC period. Once locked, cycle tick 0 falls phase_offset
+ * after each SYNC on every drive on the bus, so setpoints interpolated by
+ * the master take effect on the same tick everywhere.
+ */
+typedef struct {
+    time_sync_config_t config;
+    volatile uint32_t sync_timestamp;
+    volatile bool sync_pending;
+    time_sync_state_t state;
+    float integral;         /* frequency correction [timebase ticks per tick] */
+    float adjust;           /* period correction in force [timebase ticks per tick] */
+    float counts_per_tick;  /* PWM timer counts per timebase tick */
+    float period_remainder; /* fractional timer counts carried to the next tick */
+    int32_t phase_error;    /* [timebase ticks] */
+    uint16_t cycle_tick;
+    uint16_t in_window;
+    uint32_t ticks_since_sync;
+    uint32_t sync_count;
+    uint32_t holdovers;
+    uint32_t timebase_frequency;
+} time_sync_t;
+
+/* Fill the configuration from the Kconfig defaults */
+void time_sync_config_default(time_sync_config_t *config, uint32_t timebase_frequency, uint32_t pwm_period);
+
+time_sync_error_t time_sync_init(time_sync_t *sync, const time_sync_config_t *config, uint32_t timebase_frequency);
+
+/* CAN interrupt: timestamp of a received SYNC frame */
+void time_sync_on_sync(time_sync_t *sync, uint32_t timestamp);
+
+/*
+ * Control loop, at the start of every tick with now read from the board
+ * timebase. Returns the PWM timer period to load for the next tick.
+ */
+uint32_t time_sync_tick(time_sync_t *sync, uint32_t now);
+
+/* Position of the current tick in the SYNC cycle; tick 0 is the one aligned to SYNC */
+uint16_t time_sync_get_cycle_tick(const time_sync_t *sync);
+
+time_sync_state_t time_sync_get_state(const time_sync_t *sync);
+
+void time_sync_get_status(const time_sync_t *sync, time_sync_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
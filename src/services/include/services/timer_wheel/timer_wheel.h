@@ -0,0 +1,92 @@
+#ifndef SERVICES_TIMER_WHEEL_H
+#define SERVICES_TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "service_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if SERVICE_TIMER_WHEEL_ENABLE
+#define TIMER_WHEEL_TICK_US SERVICE_TIMER_WHEEL_TICK_US
+#else
+#define TIMER_WHEEL_TICK_US 1000
+#endif
+
+/* Five levels of 32 slots cover 2^25 ticks, 9.3 hours at 1 ms; longer timers are re-filed on the way */
+#define TIMER_WHEEL_SLOT_BITS 5U
+#define TIMER_WHEEL_SLOTS (1U << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_LEVELS 5U
+
+#define TIMER_WHEEL_NEVER UINT64_MAX
+
+typedef enum {
+    TIMER_WHEEL_SUCCESS = 0,
+    TIMER_WHEEL_ERROR_INVALID_PARAM
+} timer_wheel_error_t;
+
+typedef void (*timer_wheel_callback_t)(void *context);
+
+/* Owned by the caller, usually static; zero-initialized is stopped */
+typedef struct timer_wheel_timer {
+    struct timer_wheel_timer *next;
+    struct timer_wheel_timer **pprev; /* NULL while stopped */
+    uint64_t expires;                 /* [tick] */
+    uint32_t period;                  /* [tick], 0 for one-shot */
+    uint8_t slot;                     /* level * TIMER_WHEEL_SLOTS + slot */
+    timer_wheel_callback_t callback;
+    void *context;
+} timer_wheel_timer_t;
+
+/*
+ * Hierarchical timing wheel. Level n has 32 slots of 32^n ticks each; a
+ * timer is filed by how far ahead it expires and moves down a level each
+ * time its slot comes round, so starting and stopping a timer is O(1)
+ * whatever the number of timers. Advancing skips straight to the next
+ * occupied slot, so idle time and idle timers cost nothing.
+ *
+ * Times are on the board clock (boards/clock.h, board_clock_now64()) in
+ * microseconds, counted in ticks of TIMER_WHEEL_TICK_US. Expiry is rounded
+ * up to the next tick, so a timer never fires early.
+ *
+ * Not thread-safe: use a wheel from one context, such as the main loop.
+ * Callbacks run from timer_wheel_advance() and may start or stop any timer.
+ */
+typedef struct {
+    timer_wheel_timer_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint32_t occupied[TIMER_WHEEL_LEVELS]; /* a bit per non-empty slot */
+    uint64_t now;                          /* last tick processed */
+} timer_wheel_t;
+
+timer_wheel_error_t timer_wheel_init(timer_wheel_t *wheel, uint64_t now_us);
+
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_callback_t callback, void *context);
+
+/*
+ * Fire after delay_us and then every period_us, or once if period_us is 0.
+ * Periods missed while the wheel was not advanced are skipped, not made up.
+ * Restarts the timer if it is already running.
+ */
+timer_wheel_error_t timer_wheel_start(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint64_t now_us,
+                                      uint32_t delay_us, uint32_t period_us);
+void timer_wheel_stop(timer_wheel_t *wheel, timer_wheel_timer_t *timer);
+bool timer_wheel_active(const timer_wheel_timer_t *timer);
+
+/* Run the callbacks of every timer expired by now_us, tick by tick in order of expiry */
+void timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_us);
+
+/*
+ * Time the wheel next needs advancing [us], TIMER_WHEEL_NEVER if no timer
+ * is running. Not later than the earliest expiry, but may be earlier when
+ * a long timer is due to move down a level.
+ */
+uint64_t timer_wheel_next(const timer_wheel_t *wheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
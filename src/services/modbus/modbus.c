@@ -0,0 +1,307 @@
+#include "services/modbus/modbus.h"
+#include "boards/rs485.h"
+#include "boards/timebase.h"
+
+#include <string.h>
+
+#if SERVICE_MODBUS_ENABLE
+
+#define MODBUS_CRC_SIZE 2U
+#define MODBUS_MIN_FRAME 4U /* address, function code, CRC */
+
+/* Quantity limits that keep a request and its reply within one frame */
+#define MODBUS_MAX_READ 125U
+#define MODBUS_MAX_WRITE 123U
+
+#define MODBUS_EXCEPTION_FLAG 0x80U
+
+/* Diagnostics sub-functions */
+#define MODBUS_DIAG_RETURN_QUERY_DATA 0x0000U
+#define MODBUS_DIAG_CLEAR_COUNTERS 0x000AU
+#define MODBUS_DIAG_BUS_MESSAGE_COUNT 0x000BU
+#define MODBUS_DIAG_BUS_ERROR_COUNT 0x000CU
+#define MODBUS_DIAG_EXCEPTION_COUNT 0x000DU
+#define MODBUS_DIAG_SLAVE_MESSAGE_COUNT 0x000EU
+#define MODBUS_DIAG_NO_RESPONSE_COUNT 0x000FU
+
+/* Character: start, 8 data, parity or second stop, stop */
+#define MODBUS_CHARACTER_BITS 11U
+#define MODBUS_FIXED_TIMING_BAUDRATE 19200U
+#define MODBUS_FIXED_T35_US 1750U
+
+#if SERVICE_MODBUS_PARITY == 1
+#define MODBUS_PARITY BOARD_RS485_PARITY_EVEN
+#elif SERVICE_MODBUS_PARITY == 2
+#define MODBUS_PARITY BOARD_RS485_PARITY_ODD
+#else
+#define MODBUS_PARITY BOARD_RS485_PARITY_NONE
+#endif
+
+static uint16_t get_u16(const uint8_t *data)
+{
+    return (uint16_t)(((uint16_t)data[0] << 8) | data[1]);
+}
+
+static void put_u16(uint8_t *data, uint16_t value)
+{
+    data[0] = (uint8_t)(value >> 8);
+    data[1] = (uint8_t)value;
+}
+
+/* 3.5 characters, or the fixed 1750 us the specification sets for the faster rates */
+static uint32_t frame_timeout_bits(uint32_t baudrate)
+{
+    if (baudrate > MODBUS_FIXED_TIMING_BAUDRATE) {
+        return (uint32_t)(((uint64_t)baudrate * MODBUS_FIXED_T35_US + 999999U) / 1000000U);
+    }
+    return (MODBUS_CHARACTER_BITS * 7U + 1U) / 2U;
+}
+
+static volatile uint16_t *find_register(const modbus_block_t *blocks, size_t count, uint16_t address)
+{
+    for (size_t i = 0U; i < count; i++) {
+        if (address >= blocks[i].address && (uint32_t)address - blocks[i].address < blocks[i].count) {
+            return &blocks[i].data[address - blocks[i].address];
+        }
+    }
+    return NULL;
+}
+
+/* Every register of the range mapped, and writable if asked */
+static bool range_mapped(const modbus_block_t *blocks, size_t count, uint16_t start, uint16_t quantity, bool write)
+{
+    if ((uint32_t)start + quantity > 0x10000U) {
+        return false;
+    }
+
+    for (uint16_t i = 0U; i < quantity; i++) {
+        bool found = false;
+        for (size_t b = 0U; b < count; b++) {
+            uint16_t address = (uint16_t)(start + i);
+            if (address >= blocks[b].address && (uint32_t)address - blocks[b].address < blocks[b].count) {
+                found = !write || blocks[b].writable;
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t exception(modbus_t *mb, uint8_t code)
+{
+    mb->stats.exceptions++;
+    mb->tx_buffer[1] |= MODBUS_EXCEPTION_FLAG;
+    mb->tx_buffer[2] = code;
+    return 3U;
+}
+
+static size_t read_registers(modbus_t *mb, const uint8_t *request, size_t length, const modbus_block_t *blocks,
+                             size_t count)
+{
+    if (length != 6U) {
+        return exception(mb, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+    }
+
+    uint16_t start = get_u16(&request[2]);
+    uint16_t quantity = get_u16(&request[4]);
+    if (quantity == 0U || quantity > MODBUS_MAX_READ) {
+        return exception(mb, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+    }
+    if (!range_mapped(blocks, count, start, quantity, false)) {
+        return exception(mb, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+    }
+
+    uint8_t *reply = mb->tx_buffer;
+    reply[2] = (uint8_t)(quantity * 2U);
+    for (uint16_t i = 0U; i < quantity; i++) {
+        put_u16(&reply[3U + 2U * i], *find_register(blocks, count, (uint16_t)(start + i)));
+    }
+    return 3U + 2U * (size_t)quantity;
+}
+
+static size_t write_single(modbus_t *mb, const uint8_t *request, size_t length)
+{
+    const modbus_map_t *map = mb->map;
+
+    if (length != 6U) {
+        return exception(mb, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+    }
+
+    uint16_t address = get_u16(&request[2]);
+    if (!range_mapped(map->holding, map->holding_count, address, 1U, true)) {
+        return exception(mb, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+    }
+
+    *find_register(map->holding, map->holding_count, address) = get_u16(&request[4]);
+    /* The reply echoes the request */
+    memcpy(&mb->tx_buffer[2], &request[2], 4U);
+    return 6U;
+}
+
+static size_t write_multiple(modbus_t *mb, const uint8_t *request, size_t length)
+{
+    const modbus_map_t *map = mb->map;
+
+    if (length < 7U) {
+        return exception(mb, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+    }
+
+    uint16_t start = get_u16(&request[2]);
+    uint16_t quantity = get_u16(&request[4]);
+    if (quantity == 0U || quantity > MODBUS_MAX_WRITE || request[6] != quantity * 2U ||
+        length != 7U + 2U * (size_t)quantity) {
+        return exception(mb, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+    }
+    /* All or nothing: the whole range is checked before the first write */
+    if (!range_mapped(map->holding, map->holding_count, start, quantity, true)) {
+        return exception(mb, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+    }
+
+    for (uint16_t i = 0U; i < quantity; i++) {
+        *find_register(map->holding, map->holding_count, (uint16_t)(start + i)) = get_u16(&request[7U + 2U * i]);
+    }
+    memcpy(&mb->tx_buffer[2], &request[2], 4U);
+    return 6U;
+}
+
+static size_t diagnostics(modbus_t *mb, const uint8_t *request, size_t length)
+{
+    modbus_stats_t *stats = &mb->stats;
+    uint8_t *reply = mb->tx_buffer;
+
+    if (length < 6U) {
+        return exception(mb, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+    }
+
+    uint16_t counter;
+    switch (get_u16(&request[2])) {
+        case MODBUS_DIAG_RETURN_QUERY_DATA:
+            memcpy(&reply[2], &request[2], length - 2U);
+            return length;
+        case MODBUS_DIAG_CLEAR_COUNTERS:
+            memset(stats, 0, sizeof(*stats));
+            memcpy(&reply[2], &request[2], 4U);
+            return 6U;
+        case MODBUS_DIAG_BUS_MESSAGE_COUNT: counter = (uint16_t)stats->bus_messages; break;
+        case MODBUS_DIAG_BUS_ERROR_COUNT: counter = (uint16_t)stats->bus_errors; break;
+        case MODBUS_DIAG_EXCEPTION_COUNT: counter = (uint16_t)stats->exceptions; break;
+        case MODBUS_DIAG_SLAVE_MESSAGE_COUNT: counter = (uint16_t)stats->slave_messages; break;
+        case MODBUS_DIAG_NO_RESPONSE_COUNT: counter = (uint16_t)stats->no_responses; break;
+        default: return exception(mb, MODBUS_EXCEPTION_ILLEGAL_FUNCTION);
+    }
+
+    memcpy(&reply[2], &request[2], 2U);
+    put_u16(&reply[4], counter);
+    return 6U;
+}
+
+/* Build the reply PDU behind the address in tx_buffer; returns its length with the address */
+static size_t handle_request(modbus_t *mb, const uint8_t *request, size_t length)
+{
+    const modbus_map_t *map = mb->map;
+
+    mb->tx_buffer[0] = mb->slave_id;
+    mb->tx_buffer[1] = request[1];
+
+    switch (request[1]) {
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+            return read_registers(mb, request, length, map->holding, map->holding_count);
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            return read_registers(mb, request, length, map->input, map->input_count);
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            return write_single(mb, request, length);
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return write_multiple(mb, request, length);
+        case MODBUS_FC_DIAGNOSTICS:
+            return diagnostics(mb, request, length);
+        default:
+            return exception(mb, MODBUS_EXCEPTION_ILLEGAL_FUNCTION);
+    }
+}
+
+static void rx_callback(size_t length, bool error, uint32_t timestamp, void *context)
+{
+    modbus_t *mb = context;
+    const uint8_t *frame = mb->rx_buffer;
+
+    if (error || length < MODBUS_MIN_FRAME || length > MODBUS_MAX_ADU) {
+        mb->stats.bus_errors++;
+        board_rs485_receive(mb->hw_config);
+        return;
+    }
+
+    size_t body = length - MODBUS_CRC_SIZE;
+    uint16_t crc = (uint16_t)(frame[body] | ((uint16_t)frame[body + 1U] << 8));
+    if (crc != (uint16_t)crc_compute(&mb->crc, frame, body)) {
+        mb->stats.bus_errors++;
+        board_rs485_receive(mb->hw_config);
+        return;
+    }
+
+    mb->stats.bus_messages++;
+    if (frame[0] != mb->slave_id && frame[0] != MODBUS_BROADCAST_ADDRESS) {
+        board_rs485_receive(mb->hw_config);
+        return;
+    }
+
+    mb->stats.slave_messages++;
+    size_t reply = handle_request(mb, frame, body);
+    if (frame[0] == MODBUS_BROADCAST_ADDRESS) {
+        /* Writes take effect, but nobody is answered */
+        mb->stats.no_responses++;
+        board_rs485_receive(mb->hw_config);
+        return;
+    }
+
+    crc = (uint16_t)crc_compute(&mb->crc, mb->tx_buffer, reply);
+    mb->tx_buffer[reply] = (uint8_t)crc;
+    mb->tx_buffer[reply + 1U] = (uint8_t)(crc >> 8);
+
+    uint32_t latency = board_timebase_now() - timestamp;
+    mb->stats.latency_last = latency;
+    if (latency > mb->stats.latency_max) {
+        mb->stats.latency_max = latency;
+    }
+
+    /* Reception resumes once the reply is out, so its echo on the bus is not taken for a request */
+    if (!board_rs485_transmit(mb->hw_config, mb->tx_buffer, reply + MODBUS_CRC_SIZE)) {
+        board_rs485_receive(mb->hw_config);
+    }
+}
+
+static void tx_callback(void *context)
+{
+    modbus_t *mb = context;
+    board_rs485_receive(mb->hw_config);
+}
+
+modbus_error_t modbus_init(modbus_t *mb, const struct board_rs485_config_t *hw_config, uint8_t slave_id,
+                           const modbus_map_t *map)
+{
+    if (mb == NULL || hw_config == NULL || map == NULL || slave_id == MODBUS_BROADCAST_ADDRESS || slave_id > 247U ||
+        (map->holding == NULL && map->holding_count > 0U) || (map->input == NULL && map->input_count > 0U)) {
+        return MODBUS_ERROR_INVALID_PARAM;
+    }
+
+    memset(mb, 0, sizeof(*mb));
+    mb->hw_config = hw_config;
+    mb->map = map;
+    mb->slave_id = slave_id;
+
+    if (crc_init(&mb->crc, &crc_params_crc16_modbus) != CRC_SUCCESS) {
+        return MODBUS_ERROR_INVALID_PARAM;
+    }
+
+    if (!board_rs485_init(hw_config, SERVICE_MODBUS_BAUDRATE, MODBUS_PARITY,
+                          frame_timeout_bits(SERVICE_MODBUS_BAUDRATE), mb->rx_buffer, sizeof(mb->rx_buffer),
+                          rx_callback, tx_callback, mb)) {
+        return MODBUS_ERROR_HARDWARE;
+    }
+
+    return MODBUS_SUCCESS;
+}
+
+#endif
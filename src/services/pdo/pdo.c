@@ -0,0 +1,72 @@
+#include "services/pdo/pdo.h"
+
+#if SERVICE_CANOPEN_ENABLE
+
+const pdo_object_t *pdo_find_object(const pdo_object_t *dictionary, size_t dictionary_size, uint16_t index,
+                                    uint8_t subindex)
+{
+    if (dictionary == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0U; i < dictionary_size; i++) {
+        if (dictionary[i].index == index && dictionary[i].subindex == subindex) {
+            return &dictionary[i];
+        }
+    }
+
+    return NULL;
+}
+
+pdo_error_t pdo_map_configure(pdo_map_t *map, const pdo_object_t *dictionary, size_t dictionary_size,
+                              const uint32_t *mapping, uint8_t count, uint8_t access)
+{
+    if (map == NULL || dictionary == NULL || (mapping == NULL && count > 0U) || count > PDO_MAX_ENTRIES) {
+        return PDO_ERROR_INVALID_PARAM;
+    }
+
+    map->count = 0U;
+    map->length = 0U;
+
+    uint32_t length = 0U;
+    for (uint8_t i = 0U; i < count; i++) {
+        uint16_t index = (uint16_t)(mapping[i] >> 16);
+        uint8_t subindex = (uint8_t)(mapping[i] >> 8);
+        uint8_t bits = (uint8_t)mapping[i];
+
+        const pdo_object_t *object = pdo_find_object(dictionary, dictionary_size, index, subindex);
+        if (object == NULL) {
+            return PDO_ERROR_NO_OBJECT;
+        }
+        /* Whole objects only: no bit-granular or partial mapping */
+        if (bits != object->size * 8U) {
+            return PDO_ERROR_LENGTH;
+        }
+        if ((object->access & access) == 0U) {
+            return PDO_ERROR_NOT_MAPPABLE;
+        }
+
+        length += object->size;
+        if (length > PDO_MAX_LENGTH) {
+            return PDO_ERROR_LENGTH;
+        }
+
+        map->items[i].data = (uint8_t *)object->data;
+        map->items[i].size = object->size;
+    }
+
+    map->count = count;
+    map->length = (uint8_t)length;
+    return PDO_SUCCESS;
+}
+
+void pdo_rx_buffer_init(pdo_rx_buffer_t *buffer)
+{
+    if (buffer == NULL) {
+        return;
+    }
+
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+#endif
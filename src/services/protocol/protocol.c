@@ -0,0 +1,294 @@
+#include "services/protocol/protocol.h"
+#include "services/cobs/cobs.h"
+
+#include <string.h>
+
+#if SERVICE_PROTOCOL_ENABLE
+
+#define PROTOCOL_HEADER_SIZE 2U
+#define PROTOCOL_CRC_SIZE 2U
+#define PROTOCOL_MAX_FRAME (PROTOCOL_HEADER_SIZE + PROTOCOL_MAX_PAYLOAD + PROTOCOL_CRC_SIZE)
+#define PROTOCOL_MAX_ENCODED COBS_MAX_ENCODED_SIZE(PROTOCOL_MAX_FRAME)
+
+#if DRIVER_UART_ENABLE
+_Static_assert(PROTOCOL_MAX_ENCODED <= UART_RX_CONTIGUOUS_SIZE,
+               "UART contiguous read size must hold an encoded frame of the maximum payload");
+#endif
+#if DRIVER_USB_CDC_ENABLE
+_Static_assert(PROTOCOL_MAX_ENCODED <= USB_CDC_RX_CONTIGUOUS_SIZE,
+               "USB CDC contiguous read size must hold an encoded frame of the maximum payload");
+#endif
+_Static_assert(PROTOCOL_MAX_MESSAGES <= 0x7E, "request IDs are below 0x7E");
+
+static void handle_ping(protocol_t *protocol, const protocol_frame_t *frame, void *context)
+{
+    (void)context;
+    (void)protocol_reply(protocol, frame, frame->payload, frame->length);
+}
+
+static void handle_get_info(protocol_t *protocol, const protocol_frame_t *frame, void *context)
+{
+    (void)context;
+    const protocol_info_t info = {
+        .version = PROTOCOL_VERSION,
+        .max_payload = PROTOCOL_MAX_PAYLOAD,
+        .max_messages = PROTOCOL_MAX_MESSAGES,
+    };
+    (void)protocol_reply(protocol, frame, &info, sizeof(info));
+}
+
+/* Byte stream of the link: the UART and USB CDC drivers share their ring semantics */
+static bool link_write(protocol_t *protocol, const void *data, size_t size)
+{
+    switch (protocol->link) {
+#if DRIVER_UART_ENABLE
+        case PROTOCOL_LINK_UART: return uart_write(protocol->uart, data, size) == UART_SUCCESS;
+#endif
+#if DRIVER_USB_CDC_ENABLE
+        case PROTOCOL_LINK_USB_CDC: return usb_cdc_write(protocol->usb_cdc, data, size) == USB_CDC_SUCCESS;
+#endif
+        default: return false;
+    }
+}
+
+static const uint8_t *link_rx_span(protocol_t *protocol, size_t offset, size_t *length)
+{
+    switch (protocol->link) {
+#if DRIVER_UART_ENABLE
+        case PROTOCOL_LINK_UART: return uart_rx_span(protocol->uart, offset, length);
+#endif
+#if DRIVER_USB_CDC_ENABLE
+        case PROTOCOL_LINK_USB_CDC: return usb_cdc_rx_span(protocol->usb_cdc, offset, length);
+#endif
+        default: break;
+    }
+
+    *length = 0;
+    return NULL;
+}
+
+static uint8_t *link_rx_contiguous(protocol_t *protocol, size_t length)
+{
+    switch (protocol->link) {
+#if DRIVER_UART_ENABLE
+        case PROTOCOL_LINK_UART: return uart_rx_contiguous(protocol->uart, length);
+#endif
+#if DRIVER_USB_CDC_ENABLE
+        case PROTOCOL_LINK_USB_CDC: return usb_cdc_rx_contiguous(protocol->usb_cdc, length);
+#endif
+        default: return NULL;
+    }
+}
+
+static void link_rx_consume(protocol_t *protocol, size_t length)
+{
+    switch (protocol->link) {
+#if DRIVER_UART_ENABLE
+        case PROTOCOL_LINK_UART: uart_rx_consume(protocol->uart, length); break;
+#endif
+#if DRIVER_USB_CDC_ENABLE
+        case PROTOCOL_LINK_USB_CDC: usb_cdc_rx_consume(protocol->usb_cdc, length); break;
+#endif
+        default: break;
+    }
+}
+
+static protocol_error_t init_link(protocol_t *protocol, protocol_link_t link, void *port)
+{
+    if (protocol == NULL || port == NULL) {
+        return PROTOCOL_ERROR_INVALID_PARAM;
+    }
+
+    memset(protocol, 0, sizeof(*protocol));
+    protocol->link = link;
+    if (link == PROTOCOL_LINK_USB_CDC) {
+        protocol->usb_cdc = (usb_cdc_t *)port;
+    } else {
+        protocol->uart = (uart_t *)port;
+    }
+    if (crc_init(&protocol->crc, &crc_params_crc16_ccitt) != CRC_SUCCESS) {
+        return PROTOCOL_ERROR_INVALID_PARAM;
+    }
+
+    (void)protocol_register(protocol, PROTOCOL_MSG_PING, handle_ping, NULL);
+    (void)protocol_register(protocol, PROTOCOL_MSG_GET_INFO, handle_get_info, NULL);
+
+    return PROTOCOL_SUCCESS;
+}
+
+protocol_error_t protocol_init(protocol_t *protocol, uart_t *uart)
+{
+    return init_link(protocol, PROTOCOL_LINK_UART, uart);
+}
+
+protocol_error_t protocol_init_usb_cdc(protocol_t *protocol, usb_cdc_t *usb_cdc)
+{
+    return init_link(protocol, PROTOCOL_LINK_USB_CDC, usb_cdc);
+}
+
+protocol_error_t protocol_register(protocol_t *protocol, uint8_t id, protocol_handler_t handler, void *context)
+{
+    if (protocol == NULL || id >= PROTOCOL_MAX_MESSAGES) {
+        return PROTOCOL_ERROR_INVALID_PARAM;
+    }
+
+    protocol->handlers[id].handler = handler;
+    protocol->handlers[id].context = context;
+    return PROTOCOL_SUCCESS;
+}
+
+/* Decode, check and dispatch one frame in place; false if it is corrupt */
+static bool process_frame(protocol_t *protocol, uint8_t *buffer, size_t encoded_length)
+{
+    size_t length;
+    if (!cobs_decode_in_place(buffer, encoded_length, &length) ||
+        length < PROTOCOL_HEADER_SIZE + PROTOCOL_CRC_SIZE) {
+        return false;
+    }
+
+    size_t body = length - PROTOCOL_CRC_SIZE;
+    uint16_t crc = (uint16_t)(buffer[body] | ((uint16_t)buffer[body + 1U] << 8));
+    if (crc != (uint16_t)crc_compute(&protocol->crc, buffer, body)) {
+        return false;
+    }
+
+    protocol_frame_t frame = {
+        .id = buffer[0],
+        .seq = buffer[1],
+        .length = (uint16_t)(body - PROTOCOL_HEADER_SIZE),
+        .payload = &buffer[PROTOCOL_HEADER_SIZE],
+    };
+    protocol->rx_frames++;
+
+    const protocol_subscription_t *subscription =
+        (frame.id < PROTOCOL_MAX_MESSAGES) ? &protocol->handlers[frame.id] : NULL;
+    if (subscription == NULL || subscription->handler == NULL) {
+        (void)protocol_send_error(protocol, &frame, PROTOCOL_STATUS_UNKNOWN_MESSAGE);
+    } else {
+        subscription->handler(protocol, &frame, subscription->context);
+    }
+
+    return true;
+}
+
+/* Offset of the next delimiter at or after the scan position, or the bytes available if there is none */
+static size_t find_delimiter(protocol_t *protocol, bool *found)
+{
+    size_t offset = protocol->scanned;
+    size_t span_length;
+    const uint8_t *span;
+
+    while ((span = link_rx_span(protocol, offset, &span_length)) != NULL) {
+        const uint8_t *zero = memchr(span, 0, span_length);
+        if (zero != NULL) {
+            *found = true;
+            return offset + (size_t)(zero - span);
+        }
+        offset += span_length;
+    }
+
+    *found = false;
+    return offset;
+}
+
+size_t protocol_poll(protocol_t *protocol)
+{
+    size_t handled = 0U;
+
+    for (;;) {
+        bool found;
+        size_t end = find_delimiter(protocol, &found);
+
+        if (!found) {
+            if (end > PROTOCOL_MAX_ENCODED) {
+                /* No delimiter where one must be: drop what is there and resynchronise on the next one */
+                link_rx_consume(protocol, end);
+                protocol->rx_errors++;
+                end = 0U;
+            }
+            protocol->scanned = end;
+            return handled;
+        }
+
+        if (end > 0U) {
+            uint8_t *frame = link_rx_contiguous(protocol, end);
+            if (frame == NULL || !process_frame(protocol, frame, end)) {
+                protocol->rx_errors++;
+            } else {
+                handled++;
+            }
+        }
+
+        link_rx_consume(protocol, end + 1U);
+        protocol->scanned = 0U;
+    }
+}
+
+protocol_error_t protocol_send(protocol_t *protocol, uint8_t id, uint8_t seq, const void *payload, size_t length)
+{
+    if (protocol == NULL || (payload == NULL && length > 0U)) {
+        return PROTOCOL_ERROR_INVALID_PARAM;
+    }
+    if (length > PROTOCOL_MAX_PAYLOAD) {
+        return PROTOCOL_ERROR_LENGTH;
+    }
+
+    const uint8_t header[PROTOCOL_HEADER_SIZE] = {id, seq};
+    uint32_t state = crc_begin(&protocol->crc);
+    state = crc_update(&protocol->crc, state, header, sizeof(header));
+    state = crc_update(&protocol->crc, state, payload, length);
+    uint16_t crc = (uint16_t)crc_finish(&protocol->crc, state);
+    const uint8_t trailer[PROTOCOL_CRC_SIZE] = {(uint8_t)crc, (uint8_t)(crc >> 8)};
+
+    uint8_t encoded[PROTOCOL_MAX_ENCODED + 1U];
+    cobs_encoder_t encoder;
+    cobs_encoder_begin(&encoder, encoded);
+    cobs_encoder_put(&encoder, header, sizeof(header));
+    cobs_encoder_put(&encoder, payload, length);
+    cobs_encoder_put(&encoder, trailer, sizeof(trailer));
+    size_t encoded_length = cobs_encoder_end(&encoder);
+    encoded[encoded_length++] = 0U;
+
+    if (!link_write(protocol, encoded, encoded_length)) {
+        protocol->tx_dropped++;
+        return PROTOCOL_ERROR_BUFFER_FULL;
+    }
+
+    return PROTOCOL_SUCCESS;
+}
+
+protocol_error_t protocol_reply(protocol_t *protocol, const protocol_frame_t *request, const void *payload,
+                                size_t length)
+{
+    if (request == NULL) {
+        return PROTOCOL_ERROR_INVALID_PARAM;
+    }
+
+    return protocol_send(protocol, PROTOCOL_REPLY(request->id), request->seq, payload, length);
+}
+
+protocol_error_t protocol_send_error(protocol_t *protocol, const protocol_frame_t *request, protocol_status_t status)
+{
+    if (request == NULL) {
+        return PROTOCOL_ERROR_INVALID_PARAM;
+    }
+
+    const protocol_error_payload_t error = {.message_id = request->id, .status = (uint8_t)status};
+    return protocol_send(protocol, PROTOCOL_MSG_ERROR, request->seq, &error, sizeof(error));
+}
+
+protocol_error_t protocol_publish(protocol_t *protocol, uint8_t id, const void *payload, size_t length)
+{
+    if (protocol == NULL) {
+        return PROTOCOL_ERROR_INVALID_PARAM;
+    }
+
+    /* Consecutive sequence numbers let the host count lost frames */
+    protocol_error_t error = protocol_send(protocol, id, protocol->tx_seq, payload, length);
+    if (error == PROTOCOL_SUCCESS) {
+        protocol->tx_seq++;
+    }
+    return error;
+}
+
+#endif
@@ -0,0 +1,217 @@
+#include "services/registry/registry.h"
+
+#include <string.h>
+
+#if SERVICE_REGISTRY_ENABLE
+
+#if SERVICE_PROTOCOL_ENABLE
+#include "services/protocol/protocol.h"
+#endif
+
+uint16_t registry_count(void)
+{
+    return registry_table.count;
+}
+
+const registry_entry_t *registry_get(uint16_t id)
+{
+    return (id < registry_table.count) ? &registry_table.entries[id] : NULL;
+}
+
+registry_error_t registry_find(const char *name, size_t length, uint16_t *id)
+{
+    if (name == NULL || id == NULL) {
+        return REGISTRY_ERROR_INVALID_PARAM;
+    }
+    if (registry_table.count == 0U) {
+        return REGISTRY_ERROR_NOT_FOUND;
+    }
+
+    uint32_t hash = registry_hash(name, length);
+    uint16_t seed = registry_table.seeds[hash % registry_table.bucket_count];
+    uint16_t candidate = registry_table.slots[registry_mix(hash, seed) % registry_table.count];
+    if (registry_table.entries[candidate].hash != hash) {
+        return REGISTRY_ERROR_NOT_FOUND;
+    }
+
+    *id = candidate;
+    return REGISTRY_SUCCESS;
+}
+
+registry_error_t registry_read(uint16_t id, registry_value_t *value)
+{
+    const registry_entry_t *entry = registry_get(id);
+    if (entry == NULL || value == NULL) {
+        return (entry == NULL) ? REGISTRY_ERROR_NOT_FOUND : REGISTRY_ERROR_INVALID_PARAM;
+    }
+
+    switch ((registry_type_t)entry->type) {
+        case REGISTRY_TYPE_BOOL: value->u = *(volatile bool *)entry->data ? 1U : 0U; break;
+        case REGISTRY_TYPE_U8: value->u = *(volatile uint8_t *)entry->data; break;
+        case REGISTRY_TYPE_I8: value->i = *(volatile int8_t *)entry->data; break;
+        case REGISTRY_TYPE_U16: value->u = *(volatile uint16_t *)entry->data; break;
+        case REGISTRY_TYPE_I16: value->i = *(volatile int16_t *)entry->data; break;
+        case REGISTRY_TYPE_U32: value->u = *(volatile uint32_t *)entry->data; break;
+        case REGISTRY_TYPE_I32: value->i = *(volatile int32_t *)entry->data; break;
+        case REGISTRY_TYPE_FLOAT: value->f = *(volatile float *)entry->data; break;
+        default: return REGISTRY_ERROR_INVALID_PARAM;
+    }
+
+    return REGISTRY_SUCCESS;
+}
+
+static bool in_range(const registry_entry_t *entry, registry_value_t value)
+{
+    switch ((registry_type_t)entry->type) {
+        case REGISTRY_TYPE_BOOL: return value.u <= 1U;
+        case REGISTRY_TYPE_U8:
+        case REGISTRY_TYPE_U16:
+        case REGISTRY_TYPE_U32: return value.u >= entry->min.u && value.u <= entry->max.u;
+        case REGISTRY_TYPE_I8:
+        case REGISTRY_TYPE_I16:
+        case REGISTRY_TYPE_I32: return value.i >= entry->min.i && value.i <= entry->max.i;
+        /* NaN compares false and is rejected */
+        case REGISTRY_TYPE_FLOAT: return value.f >= entry->min.f && value.f <= entry->max.f;
+        default: return false;
+    }
+}
+
+registry_error_t registry_write(uint16_t id, registry_value_t value)
+{
+    const registry_entry_t *entry = registry_get(id);
+    if (entry == NULL) {
+        return REGISTRY_ERROR_NOT_FOUND;
+    }
+    if ((entry->access & REGISTRY_ACCESS_WRITE) == 0U) {
+        return REGISTRY_ERROR_READ_ONLY;
+    }
+    /* The generated range never exceeds the type, so a checked value always fits */
+    if (!in_range(entry, value)) {
+        return REGISTRY_ERROR_RANGE;
+    }
+
+    switch ((registry_type_t)entry->type) {
+        case REGISTRY_TYPE_BOOL: *(volatile bool *)entry->data = (value.u != 0U); break;
+        case REGISTRY_TYPE_U8: *(volatile uint8_t *)entry->data = (uint8_t)value.u; break;
+        case REGISTRY_TYPE_I8: *(volatile int8_t *)entry->data = (int8_t)value.i; break;
+        case REGISTRY_TYPE_U16: *(volatile uint16_t *)entry->data = (uint16_t)value.u; break;
+        case REGISTRY_TYPE_I16: *(volatile int16_t *)entry->data = (int16_t)value.i; break;
+        case REGISTRY_TYPE_U32: *(volatile uint32_t *)entry->data = value.u; break;
+        case REGISTRY_TYPE_I32: *(volatile int32_t *)entry->data = value.i; break;
+        case REGISTRY_TYPE_FLOAT: *(volatile float *)entry->data = value.f; break;
+        default: return REGISTRY_ERROR_INVALID_PARAM;
+    }
+
+    return REGISTRY_SUCCESS;
+}
+
+#if SERVICE_PROTOCOL_ENABLE
+
+static protocol_status_t to_status(registry_error_t error)
+{
+    switch (error) {
+        case REGISTRY_ERROR_NOT_FOUND: return PROTOCOL_STATUS_NOT_FOUND;
+        case REGISTRY_ERROR_RANGE: return PROTOCOL_STATUS_OUT_OF_RANGE;
+        default: return PROTOCOL_STATUS_REJECTED;
+    }
+}
+
+static void reply_value(protocol_t *protocol, const protocol_frame_t *frame, uint16_t id)
+{
+    registry_value_t value;
+    registry_error_t error = registry_read(id, &value);
+    if (error != REGISTRY_SUCCESS) {
+        (void)protocol_send_error(protocol, frame, to_status(error));
+        return;
+    }
+
+    const protocol_registry_value_t reply = {.id = id, .type = registry_get(id)->type, .value = value.u};
+    (void)protocol_reply(protocol, frame, &reply, sizeof(reply));
+}
+
+static void reply_info(protocol_t *protocol, const protocol_frame_t *frame, uint16_t id)
+{
+    const registry_entry_t *entry = registry_get(id);
+    if (entry == NULL) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_NOT_FOUND);
+        return;
+    }
+
+    uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+    const protocol_registry_info_t info = {
+        .id = id,
+        .count = registry_table.count,
+        .type = entry->type,
+        .access = entry->access,
+    };
+    size_t name_length = strlen(entry->name);
+    if (name_length > sizeof(payload) - sizeof(info)) {
+        name_length = sizeof(payload) - sizeof(info);
+    }
+    memcpy(payload, &info, sizeof(info));
+    memcpy(&payload[sizeof(info)], entry->name, name_length);
+    (void)protocol_reply(protocol, frame, payload, sizeof(info) + name_length);
+}
+
+static void handle_read(protocol_t *protocol, const protocol_frame_t *frame, void *context)
+{
+    (void)context;
+    const protocol_registry_id_t *request = PROTOCOL_PAYLOAD(frame, protocol_registry_id_t);
+    if (request == NULL) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_BAD_LENGTH);
+        return;
+    }
+    reply_value(protocol, frame, request->id);
+}
+
+static void handle_write(protocol_t *protocol, const protocol_frame_t *frame, void *context)
+{
+    (void)context;
+    const protocol_registry_value_t *request = PROTOCOL_PAYLOAD(frame, protocol_registry_value_t);
+    if (request == NULL) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_BAD_LENGTH);
+        return;
+    }
+
+    uint16_t id = request->id;
+    registry_error_t error = registry_write(id, (registry_value_t){.u = request->value});
+    if (error != REGISTRY_SUCCESS) {
+        (void)protocol_send_error(protocol, frame, to_status(error));
+        return;
+    }
+    reply_value(protocol, frame, id);
+}
+
+static void handle_find(protocol_t *protocol, const protocol_frame_t *frame, void *context)
+{
+    (void)context;
+    uint16_t id;
+    if (registry_find((const char *)frame->payload, frame->length, &id) != REGISTRY_SUCCESS) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_NOT_FOUND);
+        return;
+    }
+    reply_info(protocol, frame, id);
+}
+
+static void handle_describe(protocol_t *protocol, const protocol_frame_t *frame, void *context)
+{
+    (void)context;
+    const protocol_registry_id_t *request = PROTOCOL_PAYLOAD(frame, protocol_registry_id_t);
+    if (request == NULL) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_BAD_LENGTH);
+        return;
+    }
+    reply_info(protocol, frame, request->id);
+}
+
+void registry_protocol_register(struct protocol_t *protocol)
+{
+    (void)protocol_register(protocol, PROTOCOL_MSG_REGISTRY_READ, handle_read, NULL);
+    (void)protocol_register(protocol, PROTOCOL_MSG_REGISTRY_WRITE, handle_write, NULL);
+    (void)protocol_register(protocol, PROTOCOL_MSG_REGISTRY_FIND, handle_find, NULL);
+    (void)protocol_register(protocol, PROTOCOL_MSG_REGISTRY_DESCRIBE, handle_describe, NULL);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,1247 @@
+#include "services/rtos/rtos.h"
+#include "boards/timebase.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if SERVICE_RTOS_ENABLE
+
+#define RTOS_API_VERSION 20010003U    /* 2.1.3 */
+#define RTOS_KERNEL_VERSION 10000000U /* 1.0.0 */
+#define RTOS_KERNEL_ID "CubeMot RTOS"
+
+/* Written over fresh stacks to find the deepest use */
+#define RTOS_STACK_FILL 0xA5U
+
+typedef enum {
+    RTOS_FREE = 0,
+    RTOS_THREAD,
+    RTOS_MUTEX,
+    RTOS_EVENT_FLAGS,
+    RTOS_MESSAGE_QUEUE
+} rtos_type_t;
+
+typedef struct {
+    osKernelState_t state;
+    bool locked;
+    uint32_t tick;
+    rtos_thread_t *current; /* running, or about to be once the pending switch is done */
+    rtos_thread_t *ready;   /* by priority, first come first within one */
+    rtos_thread_t *delayed; /* by wake tick */
+    bool switch_pending;
+    uint32_t switch_requested_at;
+    rtos_switch_stats_t stats;
+} rtos_kernel_t;
+
+static rtos_kernel_t kernel;
+
+static rtos_thread_t thread_pool[RTOS_POOL_SIZE];
+static rtos_mutex_t mutex_pool[RTOS_POOL_SIZE];
+static rtos_event_flags_t event_flags_pool[RTOS_POOL_SIZE];
+static rtos_message_queue_t message_queue_pool[RTOS_POOL_SIZE];
+
+static rtos_thread_t idle_thread;
+static uint64_t idle_stack[SERVICE_RTOS_IDLE_STACK_SIZE / sizeof(uint64_t)];
+
+/* Control blocks: the caller's, or a free one from the pool. object_offset locates the rtos_object_t */
+static void *rtos_allocate(void *cb_mem, uint32_t cb_size, size_t size, void *pool, size_t object_offset,
+                           rtos_type_t type, const char *name)
+{
+    uint8_t *cb = NULL;
+    bool pooled = false;
+
+    if (cb_mem != NULL) {
+        if (cb_size >= size) {
+            cb = (uint8_t *)cb_mem;
+        }
+    } else {
+        for (size_t i = 0U; i < RTOS_POOL_SIZE; i++) {
+            uint8_t *candidate = (uint8_t *)pool + i * size;
+            if (((rtos_object_t *)(candidate + object_offset))->type == RTOS_FREE) {
+                cb = candidate;
+                pooled = true;
+                break;
+            }
+        }
+    }
+
+    if (cb != NULL) {
+        memset(cb, 0, size);
+        rtos_object_t *object = (rtos_object_t *)(cb + object_offset);
+        object->type = (uint8_t)type;
+        object->pooled = pooled;
+        object->name = name;
+    }
+    return cb;
+}
+
+#define RTOS_ALLOCATE(attr, pool, cb_type, type)                                                                      \
+    rtos_allocate(((attr) != NULL) ? (attr)->cb_mem : NULL, ((attr) != NULL) ? (attr)->cb_size : 0U, sizeof(cb_type), \
+                  (pool), offsetof(cb_type, object), (type), ((attr) != NULL) ? (attr)->name : NULL)
+
+static bool rtos_is_thread(const rtos_thread_t *thread)
+{
+    return thread != NULL && thread->object.type == RTOS_THREAD;
+}
+
+/* ---- Lists ---- */
+
+static void rtos_list_insert(rtos_thread_t **list, rtos_thread_t *thread)
+{
+    while (*list != NULL && (*list)->priority >= thread->priority) {
+        list = &(*list)->next;
+    }
+    thread->next = *list;
+    *list = thread;
+}
+
+static void rtos_list_remove(rtos_thread_t **list, rtos_thread_t *thread)
+{
+    for (; *list != NULL; list = &(*list)->next) {
+        if (*list == thread) {
+            *list = thread->next;
+            break;
+        }
+    }
+    thread->next = NULL;
+}
+
+static void rtos_delay_insert(rtos_thread_t *thread)
+{
+    rtos_thread_t **link = &kernel.delayed;
+    while (*link != NULL && (int32_t)((*link)->wake_tick - thread->wake_tick) <= 0) {
+        link = &(*link)->delay_next;
+    }
+    thread->delay_next = *link;
+    *link = thread;
+    thread->delayed = true;
+}
+
+static void rtos_delay_remove(rtos_thread_t *thread)
+{
+    for (rtos_thread_t **link = &kernel.delayed; *link != NULL; link = &(*link)->delay_next) {
+        if (*link == thread) {
+            *link = thread->delay_next;
+            break;
+        }
+    }
+    thread->delay_next = NULL;
+    thread->delayed = false;
+}
+
+/* ---- Scheduling ---- */
+
+static bool rtos_is_ready(const rtos_thread_t *thread)
+{
+    return thread->state == osThreadReady || thread->state == osThreadRunning;
+}
+
+static void rtos_switch_done(void)
+{
+    if (kernel.switch_pending && board_rtos_current == board_rtos_next) {
+        kernel.switch_pending = false;
+        kernel.stats.switches++;
+        kernel.stats.latency_last = board_rtos_switched_at - kernel.switch_requested_at;
+        if (kernel.stats.latency_last > kernel.stats.latency_max) {
+            kernel.stats.latency_max = kernel.stats.latency_last;
+        }
+    }
+}
+
+static void rtos_switch_to(rtos_thread_t *thread)
+{
+    rtos_thread_t *current = kernel.current;
+    if (thread == current) {
+        return;
+    }
+
+    if (current->state == osThreadRunning) {
+        current->state = osThreadReady;
+    }
+    thread->state = osThreadRunning;
+    kernel.current = thread;
+
+    rtos_switch_done();
+    if (!kernel.switch_pending) {
+        kernel.switch_pending = true;
+        kernel.switch_requested_at = board_timebase_now();
+    }
+    board_rtos_next = &thread->port;
+    board_rtos_switch();
+}
+
+/* The running thread keeps the core against threads of its own priority */
+static void rtos_reschedule(void)
+{
+    if (kernel.state != osKernelRunning || kernel.locked) {
+        return;
+    }
+
+    rtos_thread_t *current = kernel.current;
+    if (current->state == osThreadRunning && current->priority >= kernel.ready->priority) {
+        return;
+    }
+    rtos_switch_to(kernel.ready);
+}
+
+static void rtos_make_ready(rtos_thread_t *thread)
+{
+    thread->state = osThreadReady;
+    rtos_list_insert(&kernel.ready, thread);
+}
+
+static void rtos_set_priority(rtos_thread_t *thread, uint8_t priority);
+
+/* Inherit the priority of the most urgent thread waiting on any mutex held */
+static void rtos_update_priority(rtos_thread_t *thread)
+{
+    uint8_t priority = thread->base_priority;
+    for (const rtos_mutex_t *mutex = thread->mutexes; mutex != NULL; mutex = mutex->next_held) {
+        if ((mutex->attr_bits & osMutexPrioInherit) != 0U && mutex->waiters != NULL &&
+            mutex->waiters->priority > priority) {
+            priority = mutex->waiters->priority;
+        }
+    }
+    rtos_set_priority(thread, priority);
+}
+
+static void rtos_set_priority(rtos_thread_t *thread, uint8_t priority)
+{
+    if (thread->priority == priority) {
+        return;
+    }
+    thread->priority = priority;
+
+    /* Keep the lists it is in ordered, and pass the change on along a chain of mutex owners */
+    if (rtos_is_ready(thread)) {
+        rtos_list_remove(&kernel.ready, thread);
+        rtos_list_insert(&kernel.ready, thread);
+    } else if (thread->wait_list != NULL) {
+        rtos_list_remove(thread->wait_list, thread);
+        rtos_list_insert(thread->wait_list, thread);
+    }
+    if (thread->blocked_on != NULL && thread->blocked_on->owner != NULL) {
+        rtos_update_priority(thread->blocked_on->owner);
+    }
+}
+
+/*
+ * Take the running thread off the ready list until rtos_wake(). The switch
+ * happens on unlocking. Set blocked_on first when waiting for a mutex.
+ */
+static void rtos_block(rtos_thread_t **wait_list, uint32_t timeout)
+{
+    rtos_thread_t *thread = kernel.current;
+
+    rtos_list_remove(&kernel.ready, thread);
+    thread->state = osThreadBlocked;
+    thread->wait_status = osOK;
+    thread->wait_list = wait_list;
+    if (wait_list != NULL) {
+        rtos_list_insert(wait_list, thread);
+    }
+    if (timeout != osWaitForever) {
+        thread->wake_tick = kernel.tick + timeout;
+        rtos_delay_insert(thread);
+    }
+    /* Raise a mutex owner before choosing who runs next */
+    if (thread->blocked_on != NULL && thread->blocked_on->owner != NULL) {
+        rtos_update_priority(thread->blocked_on->owner);
+    }
+    rtos_switch_to(kernel.ready);
+}
+
+static void rtos_wake(rtos_thread_t *thread, osStatus_t status)
+{
+    if (thread->wait_list != NULL) {
+        rtos_list_remove(thread->wait_list, thread);
+        thread->wait_list = NULL;
+    }
+    if (thread->delayed) {
+        rtos_delay_remove(thread);
+    }
+    thread->wait_status = status;
+    rtos_make_ready(thread);
+}
+
+/* Blocking needs a thread to block, and a scheduler free to run another */
+static bool rtos_can_block(void)
+{
+    return !board_rtos_in_isr() && kernel.state == osKernelRunning && !kernel.locked;
+}
+
+static void rtos_tick(void)
+{
+    const uint32_t state = board_rtos_lock();
+
+    kernel.tick++;
+    rtos_switch_done();
+
+    while (kernel.delayed != NULL && (int32_t)(kernel.tick - kernel.delayed->wake_tick) >= 0) {
+        rtos_thread_t *thread = kernel.delayed;
+        rtos_mutex_t *mutex = thread->blocked_on;
+        thread->blocked_on = NULL;
+
+        /* A delay ends as planned, any other wait times out */
+        rtos_wake(thread, (thread->wait_list != NULL) ? osErrorTimeout : osOK);
+        if (mutex != NULL && mutex->owner != NULL) {
+            rtos_update_priority(mutex->owner);
+        }
+    }
+
+    rtos_reschedule();
+    board_rtos_unlock(state);
+}
+
+void rtos_get_switch_stats(rtos_switch_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    const uint32_t state = board_rtos_lock();
+    rtos_switch_done();
+    *stats = kernel.stats;
+    board_rtos_unlock(state);
+}
+
+/* ---- Kernel ---- */
+
+static void rtos_idle(void *argument)
+{
+    (void)argument;
+    for (;;) {
+        board_rtos_idle();
+    }
+}
+
+static void rtos_thread_return(void)
+{
+    osThreadExit();
+}
+
+osStatus_t osKernelInitialize(void)
+{
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (kernel.state != osKernelInactive) {
+        return osError;
+    }
+
+    memset(&kernel, 0, sizeof(kernel));
+    board_timebase_init();
+
+    idle_thread.object.type = RTOS_THREAD;
+    idle_thread.object.name = "idle";
+    idle_thread.priority = osPriorityIdle;
+    idle_thread.base_priority = osPriorityIdle;
+    idle_thread.stack = (uint8_t *)idle_stack;
+    idle_thread.stack_size = sizeof(idle_stack);
+    memset(idle_stack, RTOS_STACK_FILL, sizeof(idle_stack));
+    if (!board_rtos_thread_init(&idle_thread.port, idle_stack, sizeof(idle_stack), rtos_idle, NULL, NULL)) {
+        kernel.state = osKernelError;
+        return osError;
+    }
+    rtos_make_ready(&idle_thread);
+
+    kernel.state = osKernelReady;
+    return osOK;
+}
+
+osStatus_t osKernelGetInfo(osVersion_t *version, char *id_buf, uint32_t id_size)
+{
+    if (version != NULL) {
+        version->api = RTOS_API_VERSION;
+        version->kernel = RTOS_KERNEL_VERSION;
+    }
+    if (id_buf != NULL && id_size > 0U) {
+        strncpy(id_buf, RTOS_KERNEL_ID, id_size - 1U);
+        id_buf[id_size - 1U] = '\0';
+    }
+    return osOK;
+}
+
+osKernelState_t osKernelGetState(void)
+{
+    return (kernel.state == osKernelRunning && kernel.locked) ? osKernelLocked : kernel.state;
+}
+
+osStatus_t osKernelStart(void)
+{
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (kernel.state != osKernelReady) {
+        return osError;
+    }
+
+    (void)board_rtos_lock();
+    kernel.state = osKernelRunning;
+    kernel.current = kernel.ready;
+    kernel.current->state = osThreadRunning;
+    board_rtos_start(&kernel.current->port, RTOS_TICK_FREQUENCY, rtos_tick);
+    return osError;
+}
+
+int32_t osKernelLock(void)
+{
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (kernel.state != osKernelRunning) {
+        return osError;
+    }
+    const int32_t previous = kernel.locked ? 1 : 0;
+    kernel.locked = true;
+    return previous;
+}
+
+int32_t osKernelRestoreLock(int32_t lock)
+{
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (kernel.state != osKernelRunning || (lock != 0 && lock != 1)) {
+        return osError;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    kernel.locked = (lock != 0);
+    rtos_reschedule();
+    board_rtos_unlock(state);
+    return lock;
+}
+
+int32_t osKernelUnlock(void)
+{
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (kernel.state != osKernelRunning) {
+        return osError;
+    }
+    const int32_t previous = kernel.locked ? 1 : 0;
+    (void)osKernelRestoreLock(0);
+    return previous;
+}
+
+uint32_t osKernelGetTickCount(void)
+{
+    return kernel.tick;
+}
+
+uint32_t osKernelGetTickFreq(void)
+{
+    return RTOS_TICK_FREQUENCY;
+}
+
+uint32_t osKernelGetSysTimerCount(void)
+{
+    return board_timebase_now();
+}
+
+uint32_t osKernelGetSysTimerFreq(void)
+{
+    return board_timebase_frequency();
+}
+
+/* ---- Threads ---- */
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr)
+{
+    if (board_rtos_in_isr() || func == NULL || attr == NULL || attr->stack_mem == NULL || attr->stack_size == 0U) {
+        return NULL;
+    }
+
+    const osPriority_t priority = (attr->priority != osPriorityNone) ? attr->priority : osPriorityNormal;
+    if (priority < osPriorityIdle || priority > osPriorityISR) {
+        return NULL;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    rtos_thread_t *thread = RTOS_ALLOCATE(attr, thread_pool, rtos_thread_t, RTOS_THREAD);
+    board_rtos_unlock(state);
+    if (thread == NULL) {
+        return NULL;
+    }
+
+    thread->state = osThreadInactive;
+    thread->priority = (uint8_t)priority;
+    thread->base_priority = (uint8_t)priority;
+    thread->stack = (uint8_t *)attr->stack_mem;
+    thread->stack_size = attr->stack_size;
+    memset(thread->stack, RTOS_STACK_FILL, thread->stack_size);
+    if (!board_rtos_thread_init(&thread->port, thread->stack, thread->stack_size, func, argument,
+                                rtos_thread_return)) {
+        thread->object.type = RTOS_FREE;
+        return NULL;
+    }
+
+    const uint32_t lock_state = board_rtos_lock();
+    rtos_make_ready(thread);
+    rtos_reschedule();
+    board_rtos_unlock(lock_state);
+    return thread;
+}
+
+const char *osThreadGetName(osThreadId_t thread_id)
+{
+    const rtos_thread_t *thread = (const rtos_thread_t *)thread_id;
+    return rtos_is_thread(thread) ? thread->object.name : NULL;
+}
+
+osThreadId_t osThreadGetId(void)
+{
+    return kernel.current;
+}
+
+osThreadState_t osThreadGetState(osThreadId_t thread_id)
+{
+    const rtos_thread_t *thread = (const rtos_thread_t *)thread_id;
+    return rtos_is_thread(thread) ? thread->state : osThreadError;
+}
+
+uint32_t osThreadGetStackSize(osThreadId_t thread_id)
+{
+    const rtos_thread_t *thread = (const rtos_thread_t *)thread_id;
+    return rtos_is_thread(thread) ? thread->stack_size : 0U;
+}
+
+/* Bytes never written since the thread was created */
+uint32_t osThreadGetStackSpace(osThreadId_t thread_id)
+{
+    const rtos_thread_t *thread = (const rtos_thread_t *)thread_id;
+    if (!rtos_is_thread(thread)) {
+        return 0U;
+    }
+
+    uint32_t space = 0U;
+    while (space < thread->stack_size && thread->stack[space] == RTOS_STACK_FILL) {
+        space++;
+    }
+    return space;
+}
+
+osStatus_t osThreadSetPriority(osThreadId_t thread_id, osPriority_t priority)
+{
+    rtos_thread_t *thread = (rtos_thread_t *)thread_id;
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (!rtos_is_thread(thread) || priority < osPriorityIdle || priority > osPriorityISR) {
+        return osErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    if (thread->state == osThreadTerminated) {
+        board_rtos_unlock(state);
+        return osErrorResource;
+    }
+    thread->base_priority = (uint8_t)priority;
+    rtos_update_priority(thread);
+    rtos_reschedule();
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+osPriority_t osThreadGetPriority(osThreadId_t thread_id)
+{
+    const rtos_thread_t *thread = (const rtos_thread_t *)thread_id;
+    if (board_rtos_in_isr()) {
+        return osPriorityError;
+    }
+    return rtos_is_thread(thread) ? (osPriority_t)thread->priority : osPriorityError;
+}
+
+osStatus_t osThreadYield(void)
+{
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    if (kernel.state == osKernelRunning && !kernel.locked) {
+        rtos_thread_t *current = kernel.current;
+        rtos_list_remove(&kernel.ready, current);
+        rtos_list_insert(&kernel.ready, current);
+        rtos_switch_to(kernel.ready);
+    }
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+osStatus_t osThreadSuspend(osThreadId_t thread_id)
+{
+    rtos_thread_t *thread = (rtos_thread_t *)thread_id;
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (!rtos_is_thread(thread)) {
+        return osErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    if (!rtos_is_ready(thread) || thread == &idle_thread) {
+        board_rtos_unlock(state);
+        return osErrorResource;
+    }
+    if (thread == kernel.current && !rtos_can_block()) {
+        board_rtos_unlock(state);
+        return osError;
+    }
+
+    rtos_list_remove(&kernel.ready, thread);
+    thread->state = osThreadBlocked;
+    thread->wait_list = NULL;
+    if (thread == kernel.current) {
+        rtos_switch_to(kernel.ready);
+    }
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+osStatus_t osThreadResume(osThreadId_t thread_id)
+{
+    rtos_thread_t *thread = (rtos_thread_t *)thread_id;
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (!rtos_is_thread(thread)) {
+        return osErrorParameter;
+    }
+
+    /* Only a suspended thread, blocked on nothing */
+    const uint32_t state = board_rtos_lock();
+    if (thread->state != osThreadBlocked || thread->wait_list != NULL || thread->delayed) {
+        board_rtos_unlock(state);
+        return osErrorResource;
+    }
+    rtos_wake(thread, osOK);
+    rtos_reschedule();
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+static void rtos_mutex_hand_over(rtos_mutex_t *mutex);
+
+/* Called locked; the caller switches away if thread is the running one */
+static void rtos_thread_terminate(rtos_thread_t *thread)
+{
+    if (rtos_is_ready(thread)) {
+        rtos_list_remove(&kernel.ready, thread);
+    }
+    if (thread->wait_list != NULL) {
+        rtos_list_remove(thread->wait_list, thread);
+        thread->wait_list = NULL;
+    }
+    if (thread->delayed) {
+        rtos_delay_remove(thread);
+    }
+    if (thread->blocked_on != NULL) {
+        rtos_mutex_t *mutex = thread->blocked_on;
+        thread->blocked_on = NULL;
+        if (mutex->owner != NULL) {
+            rtos_update_priority(mutex->owner);
+        }
+    }
+    while (thread->mutexes != NULL) {
+        rtos_mutex_t *mutex = thread->mutexes;
+        thread->mutexes = mutex->next_held;
+        rtos_mutex_hand_over(mutex);
+    }
+
+    thread->state = osThreadTerminated;
+    if (thread->object.pooled) {
+        thread->object.type = RTOS_FREE;
+    }
+}
+
+__NO_RETURN void osThreadExit(void)
+{
+    (void)board_rtos_lock();
+    rtos_thread_terminate(kernel.current);
+    rtos_switch_to(kernel.ready);
+    board_rtos_unlock(0U);
+
+    for (;;) {
+    }
+}
+
+osStatus_t osThreadTerminate(osThreadId_t thread_id)
+{
+    rtos_thread_t *thread = (rtos_thread_t *)thread_id;
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (!rtos_is_thread(thread) || thread == &idle_thread) {
+        return osErrorParameter;
+    }
+    if (thread == kernel.current) {
+        osThreadExit();
+    }
+
+    const uint32_t state = board_rtos_lock();
+    if (thread->state == osThreadTerminated) {
+        board_rtos_unlock(state);
+        return osErrorResource;
+    }
+    rtos_thread_terminate(thread);
+    rtos_reschedule();
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+osStatus_t osDelay(uint32_t ticks)
+{
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (ticks == 0U) {
+        return osOK;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    if (!rtos_can_block()) {
+        board_rtos_unlock(state);
+        return osError;
+    }
+    rtos_block(NULL, ticks);
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+osStatus_t osDelayUntil(uint32_t ticks)
+{
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    const uint32_t delay = ticks - kernel.tick;
+    if (delay == 0U || delay > 0x7FFFFFFFU) {
+        board_rtos_unlock(state);
+        return osErrorParameter;
+    }
+    if (!rtos_can_block()) {
+        board_rtos_unlock(state);
+        return osError;
+    }
+    rtos_block(NULL, delay);
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+/* ---- Event flags ---- */
+
+static bool rtos_flags_match(uint32_t flags, uint32_t wanted, uint32_t options)
+{
+    return ((options & osFlagsWaitAll) != 0U) ? ((flags & wanted) == wanted) : ((flags & wanted) != 0U);
+}
+
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *attr)
+{
+    if (board_rtos_in_isr()) {
+        return NULL;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    rtos_event_flags_t *event_flags = RTOS_ALLOCATE(attr, event_flags_pool, rtos_event_flags_t, RTOS_EVENT_FLAGS);
+    board_rtos_unlock(state);
+    return event_flags;
+}
+
+static rtos_event_flags_t *rtos_event_flags(osEventFlagsId_t ef_id)
+{
+    rtos_event_flags_t *event_flags = (rtos_event_flags_t *)ef_id;
+    return (event_flags != NULL && event_flags->object.type == RTOS_EVENT_FLAGS) ? event_flags : NULL;
+}
+
+const char *osEventFlagsGetName(osEventFlagsId_t ef_id)
+{
+    const rtos_event_flags_t *event_flags = rtos_event_flags(ef_id);
+    return (event_flags != NULL) ? event_flags->object.name : NULL;
+}
+
+uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags)
+{
+    rtos_event_flags_t *event_flags = rtos_event_flags(ef_id);
+    if (event_flags == NULL || (flags & osFlagsError) != 0U) {
+        return osFlagsErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    event_flags->flags |= flags;
+
+    /* Most urgent waiter first; each may clear flags the next one wanted */
+    rtos_thread_t *thread = event_flags->waiters;
+    while (thread != NULL) {
+        rtos_thread_t *next = thread->next;
+        if (rtos_flags_match(event_flags->flags, thread->wait_flags, thread->wait_options)) {
+            const uint32_t wanted = thread->wait_flags;
+            thread->wait_flags = event_flags->flags;
+            if ((thread->wait_options & osFlagsNoClear) == 0U) {
+                event_flags->flags &= ~wanted;
+            }
+            rtos_wake(thread, osOK);
+        }
+        thread = next;
+    }
+
+    const uint32_t result = event_flags->flags;
+    rtos_reschedule();
+    board_rtos_unlock(state);
+    return result;
+}
+
+uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags)
+{
+    rtos_event_flags_t *event_flags = rtos_event_flags(ef_id);
+    if (event_flags == NULL || (flags & osFlagsError) != 0U) {
+        return osFlagsErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    const uint32_t previous = event_flags->flags;
+    event_flags->flags &= ~flags;
+    board_rtos_unlock(state);
+    return previous;
+}
+
+uint32_t osEventFlagsGet(osEventFlagsId_t ef_id)
+{
+    const rtos_event_flags_t *event_flags = rtos_event_flags(ef_id);
+    return (event_flags != NULL) ? event_flags->flags : 0U;
+}
+
+uint32_t osEventFlagsWait(osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout)
+{
+    rtos_event_flags_t *event_flags = rtos_event_flags(ef_id);
+    if (event_flags == NULL || flags == 0U || (flags & osFlagsError) != 0U ||
+        (board_rtos_in_isr() && timeout != 0U)) {
+        return osFlagsErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    if (rtos_flags_match(event_flags->flags, flags, options)) {
+        const uint32_t result = event_flags->flags;
+        if ((options & osFlagsNoClear) == 0U) {
+            event_flags->flags &= ~flags;
+        }
+        board_rtos_unlock(state);
+        return result;
+    }
+    if (timeout == 0U) {
+        board_rtos_unlock(state);
+        return osFlagsErrorResource;
+    }
+    if (!rtos_can_block()) {
+        board_rtos_unlock(state);
+        return osFlagsErrorUnknown;
+    }
+
+    rtos_thread_t *thread = kernel.current;
+    thread->wait_flags = flags;
+    thread->wait_options = options;
+    rtos_block(&event_flags->waiters, timeout);
+    board_rtos_unlock(state);
+
+    switch (thread->wait_status) {
+        case osOK:
+            return thread->wait_flags;
+        case osErrorTimeout:
+            return osFlagsErrorTimeout;
+        default:
+            return osFlagsErrorResource;
+    }
+}
+
+osStatus_t osEventFlagsDelete(osEventFlagsId_t ef_id)
+{
+    rtos_event_flags_t *event_flags = rtos_event_flags(ef_id);
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (event_flags == NULL) {
+        return osErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    while (event_flags->waiters != NULL) {
+        rtos_wake(event_flags->waiters, osErrorResource);
+    }
+    event_flags->object.type = RTOS_FREE;
+    rtos_reschedule();
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+/* ---- Mutexes ---- */
+
+osMutexId_t osMutexNew(const osMutexAttr_t *attr)
+{
+    if (board_rtos_in_isr()) {
+        return NULL;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    rtos_mutex_t *mutex = RTOS_ALLOCATE(attr, mutex_pool, rtos_mutex_t, RTOS_MUTEX);
+    if (mutex != NULL) {
+        mutex->attr_bits = (attr != NULL) ? attr->attr_bits : 0U;
+    }
+    board_rtos_unlock(state);
+    return mutex;
+}
+
+static rtos_mutex_t *rtos_mutex(osMutexId_t mutex_id)
+{
+    rtos_mutex_t *mutex = (rtos_mutex_t *)mutex_id;
+    return (mutex != NULL && mutex->object.type == RTOS_MUTEX) ? mutex : NULL;
+}
+
+static void rtos_mutex_take(rtos_mutex_t *mutex, rtos_thread_t *thread)
+{
+    mutex->owner = thread;
+    mutex->count = 1U;
+    mutex->next_held = thread->mutexes;
+    thread->mutexes = mutex;
+}
+
+static void rtos_mutex_drop(rtos_mutex_t *mutex, rtos_thread_t *thread)
+{
+    for (rtos_mutex_t **link = &thread->mutexes; *link != NULL; link = &(*link)->next_held) {
+        if (*link == mutex) {
+            *link = mutex->next_held;
+            break;
+        }
+    }
+    mutex->next_held = NULL;
+}
+
+/* Pass a mutex its owner no longer holds straight to the most urgent waiter */
+static void rtos_mutex_hand_over(rtos_mutex_t *mutex)
+{
+    mutex->owner = NULL;
+    mutex->count = 0U;
+    mutex->next_held = NULL;
+
+    rtos_thread_t *thread = mutex->waiters;
+    if (thread != NULL) {
+        thread->blocked_on = NULL;
+        rtos_wake(thread, osOK);
+        rtos_mutex_take(mutex, thread);
+        rtos_update_priority(thread);
+    }
+}
+
+const char *osMutexGetName(osMutexId_t mutex_id)
+{
+    const rtos_mutex_t *mutex = rtos_mutex(mutex_id);
+    return (mutex != NULL) ? mutex->object.name : NULL;
+}
+
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout)
+{
+    rtos_mutex_t *mutex = rtos_mutex(mutex_id);
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (mutex == NULL) {
+        return osErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    rtos_thread_t *thread = kernel.current;
+
+    if (mutex->owner == NULL) {
+        rtos_mutex_take(mutex, thread);
+        board_rtos_unlock(state);
+        return osOK;
+    }
+    if (mutex->owner == thread) {
+        osStatus_t status = osErrorResource;
+        if ((mutex->attr_bits & osMutexRecursive) != 0U && mutex->count < UINT32_MAX) {
+            mutex->count++;
+            status = osOK;
+        }
+        board_rtos_unlock(state);
+        return status;
+    }
+    if (timeout == 0U) {
+        board_rtos_unlock(state);
+        return osErrorResource;
+    }
+    if (!rtos_can_block()) {
+        board_rtos_unlock(state);
+        return osError;
+    }
+
+    thread->blocked_on = mutex;
+    rtos_block(&mutex->waiters, timeout);
+    board_rtos_unlock(state);
+
+    /* Handed over by the releasing thread, or timed out */
+    return thread->wait_status;
+}
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id)
+{
+    rtos_mutex_t *mutex = rtos_mutex(mutex_id);
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (mutex == NULL) {
+        return osErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    rtos_thread_t *thread = kernel.current;
+    if (mutex->owner != thread) {
+        board_rtos_unlock(state);
+        return osErrorResource;
+    }
+
+    if (--mutex->count == 0U) {
+        rtos_mutex_drop(mutex, thread);
+        rtos_mutex_hand_over(mutex);
+        rtos_update_priority(thread);
+        rtos_reschedule();
+    }
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+osThreadId_t osMutexGetOwner(osMutexId_t mutex_id)
+{
+    const rtos_mutex_t *mutex = rtos_mutex(mutex_id);
+    if (board_rtos_in_isr() || mutex == NULL) {
+        return NULL;
+    }
+    return mutex->owner;
+}
+
+osStatus_t osMutexDelete(osMutexId_t mutex_id)
+{
+    rtos_mutex_t *mutex = rtos_mutex(mutex_id);
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (mutex == NULL) {
+        return osErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    rtos_thread_t *owner = mutex->owner;
+    while (mutex->waiters != NULL) {
+        rtos_thread_t *thread = mutex->waiters;
+        thread->blocked_on = NULL;
+        rtos_wake(thread, osErrorResource);
+    }
+    if (owner != NULL) {
+        rtos_mutex_drop(mutex, owner);
+        rtos_update_priority(owner);
+    }
+    mutex->object.type = RTOS_FREE;
+    rtos_reschedule();
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+/* ---- Message queues ---- */
+
+osMessageQueueId_t osMessageQueueNew(uint32_t msg_count, uint32_t msg_size, const osMessageQueueAttr_t *attr)
+{
+    if (board_rtos_in_isr() || msg_count == 0U || msg_size == 0U || attr == NULL || attr->mq_mem == NULL ||
+        msg_size > UINT32_MAX - 3U || msg_count > UINT32_MAX / ((msg_size + 3U) & ~3U) ||
+        attr->mq_size < RTOS_MESSAGE_QUEUE_MEM_SIZE(msg_count, msg_size)) {
+        return NULL;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    rtos_message_queue_t *queue = RTOS_ALLOCATE(attr, message_queue_pool, rtos_message_queue_t, RTOS_MESSAGE_QUEUE);
+    if (queue != NULL) {
+        queue->buffer = (uint8_t *)attr->mq_mem;
+        queue->msg_size = msg_size;
+        queue->slot_size = (msg_size + 3U) & ~3U;
+        queue->capacity = msg_count;
+    }
+    board_rtos_unlock(state);
+    return queue;
+}
+
+static rtos_message_queue_t *rtos_message_queue(osMessageQueueId_t mq_id)
+{
+    rtos_message_queue_t *queue = (rtos_message_queue_t *)mq_id;
+    return (queue != NULL && queue->object.type == RTOS_MESSAGE_QUEUE) ? queue : NULL;
+}
+
+static void rtos_queue_push(rtos_message_queue_t *queue, const void *msg_ptr)
+{
+    const uint32_t tail = (queue->head + queue->count) % queue->capacity;
+    memcpy(&queue->buffer[tail * queue->slot_size], msg_ptr, queue->msg_size);
+    queue->count++;
+}
+
+static void rtos_queue_pop(rtos_message_queue_t *queue, void *msg_ptr)
+{
+    memcpy(msg_ptr, &queue->buffer[queue->head * queue->slot_size], queue->msg_size);
+    queue->head = (queue->head + 1U) % queue->capacity;
+    queue->count--;
+}
+
+/* Let blocked senders in while there is room */
+static void rtos_queue_admit(rtos_message_queue_t *queue)
+{
+    while (queue->putters != NULL && queue->count < queue->capacity) {
+        rtos_thread_t *thread = queue->putters;
+        rtos_queue_push(queue, thread->wait_message);
+        rtos_wake(thread, osOK);
+    }
+}
+
+const char *osMessageQueueGetName(osMessageQueueId_t mq_id)
+{
+    const rtos_message_queue_t *queue = rtos_message_queue(mq_id);
+    return (queue != NULL) ? queue->object.name : NULL;
+}
+
+osStatus_t osMessageQueuePut(osMessageQueueId_t mq_id, const void *msg_ptr, uint8_t msg_prio, uint32_t timeout)
+{
+    rtos_message_queue_t *queue = rtos_message_queue(mq_id);
+    (void)msg_prio;
+    if (queue == NULL || msg_ptr == NULL || (board_rtos_in_isr() && timeout != 0U)) {
+        return osErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+
+    /* A waiting receiver means the queue is empty: copy straight into its buffer */
+    if (queue->getters != NULL) {
+        rtos_thread_t *thread = queue->getters;
+        memcpy(thread->wait_message, msg_ptr, queue->msg_size);
+        rtos_wake(thread, osOK);
+        rtos_reschedule();
+        board_rtos_unlock(state);
+        return osOK;
+    }
+    if (queue->count < queue->capacity) {
+        rtos_queue_push(queue, msg_ptr);
+        board_rtos_unlock(state);
+        return osOK;
+    }
+    if (timeout == 0U) {
+        board_rtos_unlock(state);
+        return osErrorResource;
+    }
+    if (!rtos_can_block()) {
+        board_rtos_unlock(state);
+        return osError;
+    }
+
+    rtos_thread_t *thread = kernel.current;
+    thread->wait_message = (void *)msg_ptr;
+    rtos_block(&queue->putters, timeout);
+    board_rtos_unlock(state);
+    return thread->wait_status;
+}
+
+osStatus_t osMessageQueueGet(osMessageQueueId_t mq_id, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout)
+{
+    rtos_message_queue_t *queue = rtos_message_queue(mq_id);
+    if (queue == NULL || msg_ptr == NULL || (board_rtos_in_isr() && timeout != 0U)) {
+        return osErrorParameter;
+    }
+    if (msg_prio != NULL) {
+        *msg_prio = 0U;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    if (queue->count > 0U) {
+        rtos_queue_pop(queue, msg_ptr);
+        rtos_queue_admit(queue);
+        rtos_reschedule();
+        board_rtos_unlock(state);
+        return osOK;
+    }
+    if (timeout == 0U) {
+        board_rtos_unlock(state);
+        return osErrorResource;
+    }
+    if (!rtos_can_block()) {
+        board_rtos_unlock(state);
+        return osError;
+    }
+
+    rtos_thread_t *thread = kernel.current;
+    thread->wait_message = msg_ptr;
+    rtos_block(&queue->getters, timeout);
+    board_rtos_unlock(state);
+    return thread->wait_status;
+}
+
+uint32_t osMessageQueueGetCapacity(osMessageQueueId_t mq_id)
+{
+    const rtos_message_queue_t *queue = rtos_message_queue(mq_id);
+    return (queue != NULL) ? queue->capacity : 0U;
+}
+
+uint32_t osMessageQueueGetMsgSize(osMessageQueueId_t mq_id)
+{
+    const rtos_message_queue_t *queue = rtos_message_queue(mq_id);
+    return (queue != NULL) ? queue->msg_size : 0U;
+}
+
+uint32_t osMessageQueueGetCount(osMessageQueueId_t mq_id)
+{
+    const rtos_message_queue_t *queue = rtos_message_queue(mq_id);
+    return (queue != NULL) ? queue->count : 0U;
+}
+
+uint32_t osMessageQueueGetSpace(osMessageQueueId_t mq_id)
+{
+    const rtos_message_queue_t *queue = rtos_message_queue(mq_id);
+    return (queue != NULL) ? queue->capacity - queue->count : 0U;
+}
+
+osStatus_t osMessageQueueReset(osMessageQueueId_t mq_id)
+{
+    rtos_message_queue_t *queue = rtos_message_queue(mq_id);
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (queue == NULL) {
+        return osErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    queue->count = 0U;
+    queue->head = 0U;
+    rtos_queue_admit(queue);
+    rtos_reschedule();
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+osStatus_t osMessageQueueDelete(osMessageQueueId_t mq_id)
+{
+    rtos_message_queue_t *queue = rtos_message_queue(mq_id);
+    if (board_rtos_in_isr()) {
+        return osErrorISR;
+    }
+    if (queue == NULL) {
+        return osErrorParameter;
+    }
+
+    const uint32_t state = board_rtos_lock();
+    while (queue->getters != NULL) {
+        rtos_wake(queue->getters, osErrorResource);
+    }
+    while (queue->putters != NULL) {
+        rtos_wake(queue->putters, osErrorResource);
+    }
+    queue->object.type = RTOS_FREE;
+    rtos_reschedule();
+    board_rtos_unlock(state);
+    return osOK;
+}
+
+#endif
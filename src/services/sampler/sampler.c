@@ -0,0 +1,405 @@
+#include "services/sampler/sampler.h"
+
+#include <string.h>
+
+#if SERVICE_SAMPLER_ENABLE
+
+_Static_assert(PROTOCOL_MAX_PAYLOAD >= sizeof(protocol_sampler_data_t) + SAMPLER_MAX_WORDS * sizeof(uint32_t),
+               "a data frame must hold one sample of the maximum subscription");
+_Static_assert(SAMPLER_BUFFER_WORDS / 2U <= UINT16_MAX, "sample positions are 16 bits");
+
+#ifndef SAMPLER_NO_ADDRESS_CHECK
+/* Initialised and zeroed variables, from the linker script */
+extern uint32_t _sdata[];
+extern uint32_t _ebss[];
+#endif
+
+/* Only variables can be subscribed: anything else may be a peripheral with read side effects, or fault */
+static bool address_valid(uint32_t address)
+{
+    if ((address & 3U) != 0U || address == 0U) {
+        return false;
+    }
+#ifndef SAMPLER_NO_ADDRESS_CHECK
+    if (address < (uint32_t)(uintptr_t)_sdata || address + sizeof(uint32_t) > (uint32_t)(uintptr_t)_ebss) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+sampler_error_t sampler_init(sampler_t *sampler)
+{
+    if (sampler == NULL) {
+        return SAMPLER_ERROR_INVALID_PARAM;
+    }
+
+    memset(sampler, 0, sizeof(*sampler));
+    sampler->divider = 1U;
+    sampler->capacity = 1U;
+    sampler->encoding = PROTOCOL_SAMPLER_RAW;
+    return SAMPLER_SUCCESS;
+}
+
+sampler_error_t sampler_subscribe(sampler_t *sampler, const uint32_t *addresses, uint8_t count, uint16_t divider)
+{
+    if (sampler == NULL || (addresses == NULL && count > 0U) || divider == 0U) {
+        return SAMPLER_ERROR_INVALID_PARAM;
+    }
+    if (count > SAMPLER_MAX_WORDS) {
+        return SAMPLER_ERROR_TOO_MANY;
+    }
+    for (uint8_t i = 0U; i < count; i++) {
+        if (!address_valid(addresses[i])) {
+            return SAMPLER_ERROR_ADDRESS;
+        }
+    }
+
+    /* The control loop preempts this context, so no tick is half done once sampling is off */
+    sampler_stop(sampler);
+
+    for (uint8_t i = 0U; i < count; i++) {
+        sampler->addresses[i] = (const volatile uint32_t *)(uintptr_t)addresses[i];
+    }
+    sampler->words = count;
+    sampler->divider = divider;
+    sampler->capacity = (count > 0U) ? (uint16_t)(SAMPLER_BUFFER_WORDS / (count + 1U)) : 1U;
+    sampler->head = 0U;
+    sampler->tail = 0U;
+    sampler->next_index = 0U;
+    sampler->overruns = 0U;
+    sampler->encoding = PROTOCOL_SAMPLER_RAW;
+    sampler->max_sample_size = (uint16_t)(count * sizeof(uint32_t));
+    return SAMPLER_SUCCESS;
+}
+
+sampler_error_t sampler_set_encoding(sampler_t *sampler, uint8_t encoding, const uint8_t *lanes)
+{
+    if (sampler == NULL) {
+        return SAMPLER_ERROR_INVALID_PARAM;
+    }
+
+    if (encoding == PROTOCOL_SAMPLER_RAW) {
+        sampler->encoding = encoding;
+        sampler->max_sample_size = (uint16_t)(sampler->words * sizeof(uint32_t));
+        return SAMPLER_SUCCESS;
+    }
+    if ((encoding != PROTOCOL_SAMPLER_DELTA && encoding != PROTOCOL_SAMPLER_PACKED) ||
+        (lanes == NULL && sampler->words > 0U)) {
+        return SAMPLER_ERROR_ENCODING;
+    }
+
+    size_t max_size = 0U;
+    size_t lane_count = 0U;
+    for (uint8_t i = 0U; i < sampler->words; i++) {
+        if (lanes[i] > (uint8_t)DELTA_LANES_8) {
+            return SAMPLER_ERROR_ENCODING;
+        }
+        max_size += DELTA_MAX_WORD_SIZE(lanes[i]);
+        lane_count += DELTA_LANE_COUNT(lanes[i]);
+    }
+    /* Every frame must take at least its first sample, which goes as it is */
+    size_t first_size = sampler->words * sizeof(uint32_t);
+    if (encoding == PROTOCOL_SAMPLER_PACKED) {
+        first_size += lane_count;
+    }
+    if (sizeof(protocol_sampler_data_t) + first_size > PROTOCOL_MAX_PAYLOAD) {
+        return SAMPLER_ERROR_TOO_MANY;
+    }
+
+    for (uint8_t i = 0U; i < sampler->words; i++) {
+        sampler->lanes[i] = lanes[i];
+    }
+    sampler->encoding = encoding;
+    sampler->lane_count = (uint8_t)lane_count;
+    sampler->max_sample_size = (uint16_t)max_size;
+    return SAMPLER_SUCCESS;
+}
+
+void sampler_start(sampler_t *sampler)
+{
+    if (sampler == NULL || sampler->words == 0U) {
+        return;
+    }
+
+    sampler->countdown = 1U;
+    atomic_signal_fence(memory_order_release);
+    sampler->running = true;
+}
+
+void sampler_stop(sampler_t *sampler)
+{
+    if (sampler != NULL) {
+        sampler->running = false;
+        atomic_signal_fence(memory_order_seq_cst);
+    }
+}
+
+static uint16_t next_position(const sampler_t *sampler, uint16_t position)
+{
+    position = (uint16_t)(position + 1U);
+    return (position == sampler->capacity) ? 0U : position;
+}
+
+/* The words of the sample at a buffer position, after its index */
+static const uint32_t *sample_words(const sampler_t *sampler, uint16_t position)
+{
+    return &sampler->buffer[(size_t)position * (sampler->words + 1U) + 1U];
+}
+
+/* Samples one after the other, as they are or as varints. Returns the end of the payload */
+static uint8_t *fill_frame(const sampler_t *sampler, protocol_sampler_data_t *header, uint16_t *tail, uint16_t head,
+                           uint8_t *out, const uint8_t *end)
+{
+    const size_t raw_size = sampler->words * sizeof(uint32_t);
+    const uint32_t *previous = NULL;
+
+    while (*tail != head && header->records < UINT8_MAX) {
+        const uint32_t *words = sample_words(sampler, *tail);
+        if (words[-1] != header->first_index + header->records) {
+            break;
+        }
+
+        if (previous == NULL || sampler->encoding == PROTOCOL_SAMPLER_RAW) {
+            if ((size_t)(end - out) < raw_size) {
+                break;
+            }
+            memcpy(out, words, raw_size);
+            out += raw_size;
+        } else if ((size_t)(end - out) >= sampler->max_sample_size) {
+            for (uint8_t i = 0U; i < sampler->words; i++) {
+                out += delta_encode_word(out, words[i], previous[i], (delta_lanes_t)sampler->lanes[i]);
+            }
+        } else {
+            /* Near the end of the frame a sample is encoded aside, and left for the next frame if too long */
+            uint8_t scratch[SAMPLER_MAX_WORDS * DELTA_MAX_WORD_SIZE(DELTA_LANES_8)];
+            size_t size = 0U;
+            for (uint8_t i = 0U; i < sampler->words; i++) {
+                size += delta_encode_word(&scratch[size], words[i], previous[i], (delta_lanes_t)sampler->lanes[i]);
+            }
+            if (size > (size_t)(end - out)) {
+                break;
+            }
+            memcpy(out, scratch, size);
+            out += size;
+        }
+
+        /* Delta codes refer to the sample before, which stays in the buffer until the frame is sent */
+        previous = words;
+        header->records++;
+        *tail = next_position(sampler, *tail);
+    }
+    return out;
+}
+
+/*
+ * Lane widths, the first sample as it is, then the codes of the others at
+ * the width of their lane. The first pass finds how many samples fit at the
+ * widths they need, the second packs them. Returns the end of the payload.
+ */
+static uint8_t *pack_frame(sampler_t *sampler, protocol_sampler_data_t *header, uint16_t *tail, uint16_t head,
+                           uint8_t *out, const uint8_t *end)
+{
+    const size_t raw_size = sampler->words * sizeof(uint32_t);
+    const size_t budget = (size_t)(end - out) - sampler->lane_count - raw_size; /* bytes for codes */
+    uint32_t *codes = sampler->lane_codes;
+    memset(codes, 0, sampler->lane_count * sizeof(uint32_t));
+
+    const uint16_t first = *tail;
+    const uint32_t *previous = sample_words(sampler, first);
+    header->records = 1U;
+    *tail = next_position(sampler, first);
+
+    while (*tail != head && header->records < UINT8_MAX) {
+        const uint32_t *words = sample_words(sampler, *tail);
+        if (words[-1] != header->first_index + header->records) {
+            break;
+        }
+
+        /* Bits of all codes so far if this sample joins, with the widths it needs */
+        size_t bits = 0U;
+        size_t lane = 0U;
+        for (uint8_t i = 0U; i < sampler->words; i++) {
+            const unsigned lane_bits = DELTA_LANE_BITS(sampler->lanes[i]);
+            for (unsigned shift = 0U; shift < 32U; shift += lane_bits) {
+                bits += delta_width(codes[lane++] | delta_code(words[i] >> shift, previous[i] >> shift, lane_bits));
+            }
+        }
+        if (bits * header->records > budget * 8U) {
+            break;
+        }
+
+        lane = 0U;
+        for (uint8_t i = 0U; i < sampler->words; i++) {
+            const unsigned lane_bits = DELTA_LANE_BITS(sampler->lanes[i]);
+            for (unsigned shift = 0U; shift < 32U; shift += lane_bits) {
+                codes[lane++] |= delta_code(words[i] >> shift, previous[i] >> shift, lane_bits);
+            }
+        }
+        previous = words;
+        header->records++;
+        *tail = next_position(sampler, *tail);
+    }
+
+    for (size_t lane = 0U; lane < sampler->lane_count; lane++) {
+        codes[lane] = delta_width(codes[lane]);
+        *out++ = (uint8_t)codes[lane];
+    }
+    previous = sample_words(sampler, first);
+    memcpy(out, previous, raw_size);
+    out += raw_size;
+
+    delta_packer_t packer;
+    delta_packer_begin(&packer, out);
+    uint16_t position = first;
+    for (uint8_t record = 1U; record < header->records; record++) {
+        position = next_position(sampler, position);
+        const uint32_t *words = sample_words(sampler, position);
+        size_t lane = 0U;
+        for (uint8_t i = 0U; i < sampler->words; i++) {
+            const unsigned lane_bits = DELTA_LANE_BITS(sampler->lanes[i]);
+            for (unsigned shift = 0U; shift < 32U; shift += lane_bits) {
+                delta_packer_put(&packer, delta_code(words[i] >> shift, previous[i] >> shift, lane_bits),
+                                 codes[lane++]);
+            }
+        }
+        previous = words;
+    }
+    return delta_packer_end(&packer);
+}
+
+size_t sampler_process(sampler_t *sampler, protocol_t *protocol)
+{
+    if (sampler == NULL || protocol == NULL || sampler->words == 0U) {
+        return 0U;
+    }
+
+    uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+    const uint8_t *const end = &payload[PROTOCOL_MAX_PAYLOAD];
+    size_t sent = 0U;
+
+    for (;;) {
+        uint16_t tail = sampler->tail;
+        uint16_t head = sampler->head;
+        atomic_signal_fence(memory_order_acquire);
+        if (tail == head) {
+            break;
+        }
+
+        /* One frame carries a run of consecutive samples; an overrun starts a new frame */
+        protocol_sampler_data_t header = {
+            .first_index = sample_words(sampler, tail)[-1],
+            .words = sampler->words,
+            .records = 0U,
+            .encoding = sampler->encoding,
+        };
+        uint8_t *out;
+        if (sampler->encoding == PROTOCOL_SAMPLER_PACKED) {
+            out = pack_frame(sampler, &header, &tail, head, &payload[sizeof(header)], end);
+        } else {
+            out = fill_frame(sampler, &header, &tail, head, &payload[sizeof(header)], end);
+        }
+        memcpy(payload, &header, sizeof(header));
+
+        /* Samples stay buffered until the UART can take them */
+        if (protocol_publish(protocol, PROTOCOL_MSG_SAMPLER_DATA, payload, (size_t)(out - payload)) !=
+            PROTOCOL_SUCCESS) {
+            break;
+        }
+
+        atomic_signal_fence(memory_order_release);
+        sampler->tail = tail;
+        sent += header.records;
+    }
+
+    return sent;
+}
+
+static void reply_status(sampler_t *sampler, protocol_t *protocol, const protocol_frame_t *frame)
+{
+    const protocol_sampler_status_t status = {
+        .next_index = sampler->next_index,
+        .overruns = sampler->overruns,
+        .divider = sampler->divider,
+        .words = sampler->words,
+        .running = sampler->running ? 1U : 0U,
+    };
+    (void)protocol_reply(protocol, frame, &status, sizeof(status));
+}
+
+static void handle_subscribe(protocol_t *protocol, const protocol_frame_t *frame, void *context)
+{
+    sampler_t *sampler = context;
+    protocol_sampler_subscribe_t request;
+    if (frame->length < sizeof(request) || ((frame->length - sizeof(request)) % sizeof(uint32_t)) != 0U) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_BAD_LENGTH);
+        return;
+    }
+    size_t address_bytes = frame->length - sizeof(request);
+    memcpy(&request, frame->payload, sizeof(request));
+
+    size_t count = address_bytes / sizeof(uint32_t);
+    if (count > SAMPLER_MAX_WORDS) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_OUT_OF_RANGE);
+        return;
+    }
+
+    /* The addresses are not aligned in the payload */
+    uint32_t addresses[SAMPLER_MAX_WORDS];
+    memcpy(addresses, &frame->payload[sizeof(request)], address_bytes);
+    if (sampler_subscribe(sampler, addresses, (uint8_t)count, request.divider) != SAMPLER_SUCCESS) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_REJECTED);
+        return;
+    }
+    reply_status(sampler, protocol, frame);
+}
+
+static void handle_control(protocol_t *protocol, const protocol_frame_t *frame, void *context)
+{
+    sampler_t *sampler = context;
+    const protocol_sampler_control_t *request = PROTOCOL_PAYLOAD(frame, protocol_sampler_control_t);
+    if (request == NULL) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_BAD_LENGTH);
+        return;
+    }
+
+    if (request->run != 0U) {
+        sampler_start(sampler);
+    } else {
+        sampler_stop(sampler);
+    }
+    reply_status(sampler, protocol, frame);
+}
+
+static void handle_format(protocol_t *protocol, const protocol_frame_t *frame, void *context)
+{
+    sampler_t *sampler = context;
+    protocol_sampler_format_t request;
+    if (frame->length < sizeof(request)) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_BAD_LENGTH);
+        return;
+    }
+    memcpy(&request, frame->payload, sizeof(request));
+
+    /* One lane byte per subscribed word follows for delta coding */
+    size_t lanes = (request.encoding != PROTOCOL_SAMPLER_RAW) ? sampler->words : 0U;
+    if (frame->length != sizeof(request) + lanes) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_BAD_LENGTH);
+        return;
+    }
+
+    if (sampler_set_encoding(sampler, request.encoding, &frame->payload[sizeof(request)]) != SAMPLER_SUCCESS) {
+        (void)protocol_send_error(protocol, frame, PROTOCOL_STATUS_REJECTED);
+        return;
+    }
+    reply_status(sampler, protocol, frame);
+}
+
+void sampler_protocol_register(sampler_t *sampler, protocol_t *protocol)
+{
+    (void)protocol_register(protocol, PROTOCOL_MSG_SAMPLER_SUBSCRIBE, handle_subscribe, sampler);
+    (void)protocol_register(protocol, PROTOCOL_MSG_SAMPLER_CONTROL, handle_control, sampler);
+    (void)protocol_register(protocol, PROTOCOL_MSG_SAMPLER_FORMAT, handle_format, sampler);
+}
+
+#endif
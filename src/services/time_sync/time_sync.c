@@ -0,0 +1,173 @@
+#include "services/time_sync/time_sync.h"
+#include "service_config.h"
+#include "control_config.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#if SERVICE_TIME_SYNC_ENABLE
+
+#define TIME_SYNC_KP 0.5f
+#define TIME_SYNC_KI 0.1f
+#define TIME_SYNC_LOCK_COUNT 8U
+#define TIME_SYNC_TIMEOUT_SYNCS 4U
+
+static float clampf(float value, float limit)
+{
+    if (value > limit) {
+        return limit;
+    }
+    if (value < -limit) {
+        return -limit;
+    }
+    return value;
+}
+
+static int32_t ticks_to_ns(const time_sync_t *sync, int32_t ticks)
+{
+    return (int32_t)((int64_t)ticks * 1000000000LL / (int64_t)sync->timebase_frequency);
+}
+
+void time_sync_config_default(time_sync_config_t *config, uint32_t timebase_frequency, uint32_t pwm_period)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    uint64_t sync_ticks = (uint64_t)SERVICE_TIME_SYNC_PERIOD_US * CONTROL_PWM_FREQUENCY_HZ;
+
+    config->tick_period = timebase_frequency / CONTROL_PWM_FREQUENCY_HZ;
+    config->pwm_period = pwm_period;
+    config->ticks_per_sync = (uint16_t)((sync_ticks + 500000U) / 1000000U);
+    config->phase_offset = (int32_t)((uint64_t)SERVICE_TIME_SYNC_OFFSET_US * timebase_frequency / 1000000U);
+    config->kp = TIME_SYNC_KP;
+    config->ki = TIME_SYNC_KI;
+    config->max_adjust = (float)SERVICE_TIME_SYNC_MAX_ADJUST_PPM * 1e-6f;
+    config->lock_window = (uint32_t)((uint64_t)SERVICE_TIME_SYNC_LOCK_WINDOW_NS * timebase_frequency / 1000000000U);
+    config->lock_count = TIME_SYNC_LOCK_COUNT;
+    config->timeout_syncs = TIME_SYNC_TIMEOUT_SYNCS;
+}
+
+time_sync_error_t time_sync_init(time_sync_t *sync, const time_sync_config_t *config, uint32_t timebase_frequency)
+{
+    if (sync == NULL || config == NULL || config->tick_period == 0U || config->pwm_period == 0U ||
+        config->ticks_per_sync == 0U || timebase_frequency == 0U || config->max_adjust <= 0.0f) {
+        return TIME_SYNC_ERROR_INVALID_PARAM;
+    }
+
+    memset(sync, 0, sizeof(*sync));
+    sync->config = *config;
+    sync->state = TIME_SYNC_STATE_UNLOCKED;
+    sync->counts_per_tick = (float)config->pwm_period / (float)config->tick_period;
+    sync->timebase_frequency = timebase_frequency;
+
+    return TIME_SYNC_SUCCESS;
+}
+
+void time_sync_on_sync(time_sync_t *sync, uint32_t timestamp)
+{
+    sync->sync_timestamp = timestamp;
+    atomic_signal_fence(memory_order_release);
+    sync->sync_pending = true;
+}
+
+/*
+ * Measure where this tick sits against the SYNC: the delay past the target
+ * offset splits into whole ticks, which give the position in the cycle, and
+ * the remainder within half a tick, which is the phase error.
+ */
+static void update_phase(time_sync_t *sync, uint32_t now, uint32_t timestamp)
+{
+    const time_sync_config_t *config = &sync->config;
+    int32_t period = (int32_t)config->tick_period;
+    int32_t delay = (int32_t)(now - timestamp) - config->phase_offset;
+
+    int32_t ticks = (delay >= 0) ? (delay + period / 2) / period : -((-delay + period / 2) / period);
+    int32_t error = delay - ticks * period;
+
+    int32_t cycle = ticks % (int32_t)config->ticks_per_sync;
+    if (cycle < 0) {
+        cycle += (int32_t)config->ticks_per_sync;
+    }
+    sync->cycle_tick = (uint16_t)cycle;
+    sync->phase_error = error;
+
+    /* PI on the phase: the integral tracks the frequency offset to the master */
+    float limit = config->max_adjust * (float)period;
+    float correction = (float)error / (float)config->ticks_per_sync;
+    sync->integral = clampf(sync->integral + config->ki * correction, limit);
+    sync->adjust = clampf(-(config->kp * correction + sync->integral), limit);
+
+    uint32_t magnitude = (uint32_t)((error < 0) ? -error : error);
+    if (sync->state == TIME_SYNC_STATE_LOCKED) {
+        /* Some hysteresis so timestamp jitter near the window edge does not toggle the lock */
+        if (magnitude > 2U * config->lock_window) {
+            sync->state = TIME_SYNC_STATE_ACQUIRING;
+            sync->in_window = 0U;
+        }
+    } else {
+        sync->state = TIME_SYNC_STATE_ACQUIRING;
+        sync->in_window = (magnitude <= config->lock_window) ? (uint16_t)(sync->in_window + 1U) : 0U;
+        if (sync->in_window >= config->lock_count) {
+            sync->state = TIME_SYNC_STATE_LOCKED;
+        }
+    }
+}
+
+uint32_t time_sync_tick(time_sync_t *sync, uint32_t now)
+{
+    const time_sync_config_t *config = &sync->config;
+
+    if (++sync->cycle_tick >= config->ticks_per_sync) {
+        sync->cycle_tick = 0U;
+    }
+
+    if (sync->sync_pending) {
+        sync->sync_pending = false;
+        atomic_signal_fence(memory_order_acquire);
+        uint32_t timestamp = sync->sync_timestamp;
+
+        sync->sync_count++;
+        sync->ticks_since_sync = 0U;
+        update_phase(sync, now, timestamp);
+    } else if (sync->state != TIME_SYNC_STATE_UNLOCKED &&
+               ++sync->ticks_since_sync > (uint32_t)config->timeout_syncs * config->ticks_per_sync) {
+        /* Holdover: keep the learned frequency, drop the phase term */
+        sync->state = TIME_SYNC_STATE_UNLOCKED;
+        sync->in_window = 0U;
+        sync->adjust = -sync->integral;
+        sync->holdovers++;
+    }
+
+    /* Carry the fraction so the average period is exact to well below one timer count */
+    float period = (float)config->pwm_period + sync->adjust * sync->counts_per_tick + sync->period_remainder;
+    uint32_t counts = (uint32_t)(period + 0.5f);
+    sync->period_remainder = period - (float)counts;
+
+    return counts;
+}
+
+uint16_t time_sync_get_cycle_tick(const time_sync_t *sync)
+{
+    return sync->cycle_tick;
+}
+
+time_sync_state_t time_sync_get_state(const time_sync_t *sync)
+{
+    return (sync != NULL) ? sync->state : TIME_SYNC_STATE_UNLOCKED;
+}
+
+void time_sync_get_status(const time_sync_t *sync, time_sync_status_t *status)
+{
+    if (sync == NULL || status == NULL) {
+        return;
+    }
+
+    status->state = sync->state;
+    status->phase_error_ns = ticks_to_ns(sync, sync->phase_error);
+    status->adjust_ppm = (int32_t)(sync->adjust / (float)sync->config.tick_period * 1e6f);
+    status->sync_count = sync->sync_count;
+    status->holdovers = sync->holdovers;
+}
+
+#endif
@@ -0,0 +1,245 @@
+#include "services/timer_wheel/timer_wheel.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if SERVICE_TIMER_WHEEL_ENABLE
+
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1U)
+#define TIMER_WHEEL_SLOT_NONE 0xFFU
+
+/* Ticks covered by the wheel; a timer further out is filed at the far end and re-filed when it gets there */
+#define TIMER_WHEEL_RANGE (1ULL << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS))
+
+static uint64_t timer_wheel_ticks(uint64_t us)
+{
+    return (us + TIMER_WHEEL_TICK_US - 1U) / TIMER_WHEEL_TICK_US;
+}
+
+static uint32_t timer_wheel_rotate_right(uint32_t bits, uint32_t count)
+{
+    return (count == 0U) ? bits : ((bits >> count) | (bits << (32U - count)));
+}
+
+static void timer_wheel_link(timer_wheel_timer_t **head, timer_wheel_timer_t *timer)
+{
+    timer->next = *head;
+    if (*head != NULL) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+static void timer_wheel_unlink(timer_wheel_t *wheel, timer_wheel_timer_t *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) {
+        timer->next->pprev = timer->pprev;
+    }
+
+    if (timer->slot != TIMER_WHEEL_SLOT_NONE) {
+        const uint32_t level = timer->slot / TIMER_WHEEL_SLOTS;
+        const uint32_t slot = timer->slot & TIMER_WHEEL_SLOT_MASK;
+        if (wheel->slots[level][slot] == NULL) {
+            wheel->occupied[level] &= ~(1UL << slot);
+        }
+    }
+
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->slot = TIMER_WHEEL_SLOT_NONE;
+}
+
+/* By how far ahead it expires: level n holds timers 32^n to 32^(n+1) ticks out */
+static void timer_wheel_file(timer_wheel_t *wheel, timer_wheel_timer_t *timer)
+{
+    uint64_t ahead = timer->expires - wheel->now;
+    if (ahead >= TIMER_WHEEL_RANGE) {
+        ahead = TIMER_WHEEL_RANGE - 1U;
+    }
+
+    uint32_t level = 0U;
+    while (level + 1U < TIMER_WHEEL_LEVELS && ahead >= (1ULL << (TIMER_WHEEL_SLOT_BITS * (level + 1U)))) {
+        level++;
+    }
+    const uint32_t slot = (uint32_t)((wheel->now + ahead) >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK;
+
+    timer_wheel_link(&wheel->slots[level][slot], timer);
+    timer->slot = (uint8_t)(level * TIMER_WHEEL_SLOTS + slot);
+    wheel->occupied[level] |= 1UL << slot;
+}
+
+/* Move a slot's timers to a list of their own, where stopping one still unlinks it */
+static void timer_wheel_take(timer_wheel_t *wheel, uint32_t level, uint32_t slot, timer_wheel_timer_t **list)
+{
+    *list = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+    wheel->occupied[level] &= ~(1UL << slot);
+
+    if (*list != NULL) {
+        (*list)->pprev = list;
+    }
+    for (timer_wheel_timer_t *timer = *list; timer != NULL; timer = timer->next) {
+        timer->slot = TIMER_WHEEL_SLOT_NONE;
+    }
+}
+
+/*
+ * A level-n slot comes round on ticks that are a multiple of 32^n, the
+ * first of them past now whose index is marked occupied.
+ */
+static uint64_t timer_wheel_next_tick(const timer_wheel_t *wheel)
+{
+    uint64_t next = TIMER_WHEEL_NEVER;
+
+    for (uint32_t level = 0U; level < TIMER_WHEEL_LEVELS; level++) {
+        if (wheel->occupied[level] == 0U) {
+            continue;
+        }
+        const uint32_t shift = TIMER_WHEEL_SLOT_BITS * level;
+        const uint64_t first = (wheel->now >> shift) + 1U;
+        const uint32_t pending =
+            timer_wheel_rotate_right(wheel->occupied[level], (uint32_t)first & TIMER_WHEEL_SLOT_MASK);
+        const uint64_t tick = (first + (uint32_t)__builtin_ctz(pending)) << shift;
+        if (tick < next) {
+            next = tick;
+        }
+    }
+
+    return next;
+}
+
+/* Move the timers of higher-level slots coming round down the wheel, then fire the ones due */
+static void timer_wheel_process(timer_wheel_t *wheel, uint64_t tick, uint64_t target)
+{
+    timer_wheel_timer_t *expired = NULL;
+    wheel->now = tick;
+
+    for (uint32_t level = TIMER_WHEEL_LEVELS - 1U; level > 0U; level--) {
+        const uint32_t shift = TIMER_WHEEL_SLOT_BITS * level;
+        if ((tick & ((1ULL << shift) - 1U)) != 0U) {
+            continue;
+        }
+
+        timer_wheel_timer_t *due;
+        timer_wheel_take(wheel, level, (uint32_t)(tick >> shift) & TIMER_WHEEL_SLOT_MASK, &due);
+        while (due != NULL) {
+            timer_wheel_timer_t *timer = due;
+            timer_wheel_unlink(wheel, timer);
+            if (timer->expires <= tick) {
+                timer_wheel_link(&expired, timer);
+            } else {
+                timer_wheel_file(wheel, timer);
+            }
+        }
+    }
+
+    timer_wheel_timer_t *due;
+    timer_wheel_take(wheel, 0U, (uint32_t)tick & TIMER_WHEEL_SLOT_MASK, &due);
+    while (due != NULL) {
+        timer_wheel_timer_t *timer = due;
+        timer_wheel_unlink(wheel, timer);
+        timer_wheel_link(&expired, timer);
+    }
+
+    while (expired != NULL) {
+        timer_wheel_timer_t *timer = expired;
+        timer_wheel_unlink(wheel, timer);
+
+        /* Re-armed first, so the callback may stop or restart it */
+        if (timer->period != 0U) {
+            timer->expires += timer->period;
+            if (timer->expires <= target) {
+                timer->expires += ((target - timer->expires) / timer->period + 1U) * timer->period;
+            }
+            timer_wheel_file(wheel, timer);
+        }
+        timer->callback(timer->context);
+    }
+}
+
+timer_wheel_error_t timer_wheel_init(timer_wheel_t *wheel, uint64_t now_us)
+{
+    if (wheel == NULL) {
+        return TIMER_WHEEL_ERROR_INVALID_PARAM;
+    }
+
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->now = now_us / TIMER_WHEEL_TICK_US;
+
+    return TIMER_WHEEL_SUCCESS;
+}
+
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_callback_t callback, void *context)
+{
+    if (timer == NULL) {
+        return;
+    }
+
+    memset(timer, 0, sizeof(*timer));
+    timer->slot = TIMER_WHEEL_SLOT_NONE;
+    timer->callback = callback;
+    timer->context = context;
+}
+
+timer_wheel_error_t timer_wheel_start(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint64_t now_us,
+                                      uint32_t delay_us, uint32_t period_us)
+{
+    if (wheel == NULL || timer == NULL || timer->callback == NULL) {
+        return TIMER_WHEEL_ERROR_INVALID_PARAM;
+    }
+
+    if (timer->pprev != NULL) {
+        timer_wheel_unlink(wheel, timer);
+    }
+
+    timer->period = (uint32_t)timer_wheel_ticks(period_us);
+    timer->expires = timer_wheel_ticks(now_us + delay_us);
+    if (timer->expires <= wheel->now) {
+        timer->expires = wheel->now + 1U;
+    }
+    timer_wheel_file(wheel, timer);
+
+    return TIMER_WHEEL_SUCCESS;
+}
+
+void timer_wheel_stop(timer_wheel_t *wheel, timer_wheel_timer_t *timer)
+{
+    if (wheel == NULL || timer == NULL || timer->pprev == NULL) {
+        return;
+    }
+    timer_wheel_unlink(wheel, timer);
+}
+
+bool timer_wheel_active(const timer_wheel_timer_t *timer)
+{
+    return timer != NULL && timer->pprev != NULL;
+}
+
+void timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_us)
+{
+    if (wheel == NULL) {
+        return;
+    }
+
+    const uint64_t target = now_us / TIMER_WHEEL_TICK_US;
+    for (uint64_t tick = timer_wheel_next_tick(wheel); tick <= target; tick = timer_wheel_next_tick(wheel)) {
+        timer_wheel_process(wheel, tick, target);
+    }
+    if (target > wheel->now) {
+        wheel->now = target;
+    }
+}
+
+uint64_t timer_wheel_next(const timer_wheel_t *wheel)
+{
+    if (wheel == NULL) {
+        return TIMER_WHEEL_NEVER;
+    }
+
+    const uint64_t tick = timer_wheel_next_tick(wheel);
+    return (tick == TIMER_WHEEL_NEVER) ? TIMER_WHEEL_NEVER : tick * TIMER_WHEEL_TICK_US;
+}
+
+#endif
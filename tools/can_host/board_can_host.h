@@ -0,0 +1,26 @@
+#ifndef BOARD_CAN_HOST_H
+#define BOARD_CAN_HOST_H
+
+#include <stdbool.h>
+
+#include "boards/can.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Select the SocketCAN interface before board_can_init(); defaults to $CUBEMOT_CAN_IF or "vcan0" */
+void board_can_host_set_interface(const char *name);
+
+/*
+ * Stand-in for the CAN interrupt: wait up to timeout_ms for frames and run
+ * the receive callback for each one that passes the filters. Returns false
+ * on a socket error.
+ */
+bool board_can_host_poll(int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,244 @@
+/*
+ * Host implementation of boards/can.h on Linux SocketCAN, so the CAN driver
+ * and the protocol layers above it run unchanged against vcan or a USB CAN
+ * FD adapter. Filters behave like the FDCAN acceptance filters: first match
+ * in list order, non-matching frames dropped. The kernel applies the same
+ * filters so unrelated traffic never wakes the process.
+ */
+#define _GNU_SOURCE
+
+#include "board_can_host.h"
+#include "boards/timebase.h"
+
+#include <errno.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define CAN_HOST_DEFAULT_INTERFACE "vcan0"
+
+typedef struct {
+    int socket;
+    board_can_filter_t filters[BOARD_CAN_MAX_STD_FILTERS + BOARD_CAN_MAX_EXT_FILTERS];
+    uint8_t filter_count;
+    board_can_rx_callback_t rx_callback;
+    void *context;
+} board_can_host_t;
+
+static const board_can_config_t board_can_configs[BOARD_CAN_COUNT] = {
+    [BOARD_CAN_1] = {.instance_index = BOARD_CAN_1},
+};
+
+static board_can_host_t host = {.socket = -1};
+static const char *interface_name;
+
+static const uint8_t fd_lengths[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+
+/* Lengths between valid DLC sizes are padded with zeros, as the controller does */
+static uint8_t round_up_fd_length(uint8_t length)
+{
+    size_t i = 0U;
+    while (fd_lengths[i] < length) {
+        i++;
+    }
+    return fd_lengths[i];
+}
+
+static bool filter_matches(const board_can_filter_t *filter, uint32_t id, bool extended)
+{
+    return filter->extended == extended && ((id ^ filter->id) & filter->mask) == 0U;
+}
+
+static int find_filter(uint32_t id, bool extended)
+{
+    for (uint8_t i = 0U; i < host.filter_count; i++) {
+        if (filter_matches(&host.filters[i], id, extended)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool install_kernel_filters(void)
+{
+    struct can_filter filters[BOARD_CAN_MAX_STD_FILTERS + BOARD_CAN_MAX_EXT_FILTERS];
+
+    for (uint8_t i = 0U; i < host.filter_count; i++) {
+        const board_can_filter_t *filter = &host.filters[i];
+        if (filter->extended) {
+            filters[i].can_id = (filter->id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+            filters[i].can_mask = (filter->mask & CAN_EFF_MASK) | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        } else {
+            filters[i].can_id = filter->id & CAN_SFF_MASK;
+            filters[i].can_mask = (filter->mask & CAN_SFF_MASK) | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        }
+    }
+
+    /* An empty list installs no filter at all, which drops everything as the hardware does */
+    return setsockopt(host.socket, SOL_CAN_RAW, CAN_RAW_FILTER, filters,
+                      (socklen_t)(host.filter_count * sizeof(filters[0]))) == 0;
+}
+
+void board_can_host_set_interface(const char *name)
+{
+    interface_name = name;
+}
+
+const board_can_config_t *board_can_get_config(board_can_id_t can_id)
+{
+    if (can_id < 0 || can_id >= BOARD_CAN_COUNT) {
+        return NULL;
+    }
+    return &board_can_configs[can_id];
+}
+
+int board_can_is_supported(board_can_id_t can_id)
+{
+    return can_id == BOARD_CAN_1;
+}
+
+bool board_can_init(const board_can_config_t *config, const board_can_bitrate_t *bitrate,
+                    const board_can_filter_t *filters, uint8_t filter_count, board_can_rx_callback_t rx_callback,
+                    void *context)
+{
+    if (config == NULL || bitrate == NULL || bitrate->nominal_bitrate == 0U || (filters == NULL && filter_count > 0U) ||
+        filter_count > BOARD_CAN_MAX_STD_FILTERS + BOARD_CAN_MAX_EXT_FILTERS) {
+        return false;
+    }
+
+    const char *name = interface_name;
+    if (name == NULL) {
+        name = getenv("CUBEMOT_CAN_IF");
+    }
+    if (name == NULL) {
+        name = CAN_HOST_DEFAULT_INTERFACE;
+    }
+
+    if (host.socket >= 0) {
+        close(host.socket);
+    }
+    host.socket = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (host.socket < 0) {
+        return false;
+    }
+
+    int enable = 1;
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+    struct sockaddr_can address = {.can_family = AF_CAN};
+
+    memcpy(host.filters, filters, filter_count * sizeof(filters[0]));
+    host.filter_count = filter_count;
+    host.rx_callback = rx_callback;
+    host.context = context;
+
+    if (setsockopt(host.socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) != 0 ||
+        ioctl(host.socket, SIOCGIFINDEX, &ifr) != 0 || !install_kernel_filters()) {
+        close(host.socket);
+        host.socket = -1;
+        return false;
+    }
+
+    address.can_ifindex = ifr.ifr_ifindex;
+    if (bind(host.socket, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(host.socket);
+        host.socket = -1;
+        return false;
+    }
+
+    return true;
+}
+
+bool board_can_transmit(const board_can_config_t *config, uint32_t id, uint8_t flags, const void *data,
+                        uint8_t length)
+{
+    if (config == NULL || host.socket < 0 || (data == NULL && length > 0U) || length > BOARD_CAN_MAX_DATA ||
+        ((flags & BOARD_CAN_FLAG_FD) == 0U && length > 8U)) {
+        return false;
+    }
+
+    struct canfd_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id =
+        ((flags & BOARD_CAN_FLAG_EXTENDED) != 0U) ? ((id & CAN_EFF_MASK) | CAN_EFF_FLAG) : (id & CAN_SFF_MASK);
+    frame.len = length;
+    if (length > 0U) {
+        memcpy(frame.data, data, length);
+    }
+
+    size_t size = CAN_MTU;
+    if ((flags & BOARD_CAN_FLAG_FD) != 0U) {
+        size = CANFD_MTU;
+        frame.len = round_up_fd_length(length);
+        if ((flags & BOARD_CAN_FLAG_BRS) != 0U) {
+            frame.flags |= CANFD_BRS;
+        }
+    }
+
+    /* Non-blocking like the hardware FIFO: a full socket queue reports the frame as not queued */
+    return send(host.socket, &frame, size, MSG_DONTWAIT) == (ssize_t)size;
+}
+
+bool board_can_is_bus_off(const board_can_config_t *config)
+{
+    (void)config;
+    return false;
+}
+
+bool board_can_host_poll(int timeout_ms)
+{
+    if (host.socket < 0) {
+        return false;
+    }
+
+    struct pollfd descriptor = {.fd = host.socket, .events = POLLIN};
+    int ready = poll(&descriptor, 1, timeout_ms);
+    if (ready < 0) {
+        return errno == EINTR;
+    }
+
+    while (ready > 0) {
+        struct canfd_frame frame;
+        ssize_t size = recv(host.socket, &frame, sizeof(frame), MSG_DONTWAIT);
+        if (size < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if (size != CAN_MTU && size != CANFD_MTU) {
+            continue;
+        }
+
+        bool extended = (frame.can_id & CAN_EFF_FLAG) != 0U;
+        uint32_t id = frame.can_id & (extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+        int filter_index = find_filter(id, extended);
+        if (filter_index < 0 || (frame.can_id & CAN_RTR_FLAG) != 0U) {
+            continue;
+        }
+
+        board_can_rx_frame_t rx = {
+            .id = id,
+            .flags = extended ? BOARD_CAN_FLAG_EXTENDED : 0U,
+            .length = frame.len,
+            .timestamp = board_timebase_now(),
+            .data = frame.data,
+        };
+        if (size == CANFD_MTU) {
+            rx.flags |= BOARD_CAN_FLAG_FD;
+            if ((frame.flags & CANFD_BRS) != 0U) {
+                rx.flags |= BOARD_CAN_FLAG_BRS;
+            }
+        }
+
+        if (host.rx_callback != NULL) {
+            host.rx_callback((uint8_t)filter_index, &rx, host.context);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,22 @@
+/* Host implementation of boards/timebase.h: CLOCK_MONOTONIC in nanoseconds */
+#define _GNU_SOURCE
+
+#include "boards/timebase.h"
+
+#include <time.h>
+
+void board_timebase_init(void)
+{
+}
+
+uint32_t board_timebase_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+}
+
+uint32_t board_timebase_frequency(void)
+{
+    return 1000000000U;
+}
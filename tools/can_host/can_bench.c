@@ -0,0 +1,297 @@
+/*
+ * Loopback check and benchmark for drivers/can on the SocketCAN stand-in.
+ * A raw socket on the same interface plays the other node. Frames inside
+ * and just outside each acceptance filter must reach exactly the handler
+ * of their filter or nothing; a 64-byte CAN FD frame with bit rate switch
+ * and a classic frame must come back unchanged through a handler that
+ * echoes them with can_send(). Then 64-byte frames are streamed through
+ * the echo with a window outstanding, for throughput and round-trip time.
+ */
+#define _GNU_SOURCE
+
+#include "drivers/can/can.h"
+#include "board_can_host.h"
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_ECHO_ID 0x7E5U
+#define BENCH_REPLY_ID 0x7E4U
+#define BENCH_WINDOW 16U
+#define BENCH_SECONDS 1.0
+#define BENCH_MAX_SAMPLES 2000000U
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+typedef struct {
+    uint32_t count;
+    uint32_t last_id;
+    uint8_t last_flags;
+} handler_stats_t;
+
+typedef struct {
+    uint32_t id;
+    bool extended;
+    int handler; /* expected handler, -1 for rejected */
+} filter_case_t;
+
+static int failures;
+static can_t can;
+static handler_stats_t stats[3];
+static int peer = -1;
+static double sent_at[BENCH_WINDOW];
+static double samples[BENCH_MAX_SAMPLES];
+
+static const filter_case_t filter_cases[] = {
+    {0x200U, false, 0},      {0x27FU, false, 0},      {0x1FFU, false, -1},     {0x280U, false, -1},
+    {0x200U, true, -1},      {0x18DA00F1U, true, 1},  {0x18DA00F0U, true, 1},  {0x18DA01F1U, true, -1},
+    {0x0DA00F1U, true, -1},  {0x0F1U, false, -1},     {BENCH_ECHO_ID, false, 2}, {BENCH_ECHO_ID, true, -1},
+};
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void count_frame(const can_frame_t *frame, void *context)
+{
+    handler_stats_t *s = (handler_stats_t *)context;
+    s->count++;
+    s->last_id = frame->id;
+    s->last_flags = frame->flags;
+}
+
+/* Sends the frame back under the reply ID with the flags it came with */
+static void echo_frame(const can_frame_t *frame, void *context)
+{
+    count_frame(frame, context);
+    (void)can_send(&can, BENCH_REPLY_ID, frame->flags, frame->data, frame->length);
+}
+
+static bool open_peer(const char *name)
+{
+    peer = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (peer < 0) {
+        return false;
+    }
+
+    int enable = 1;
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+    struct sockaddr_can address = {.can_family = AF_CAN};
+    if (setsockopt(peer, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) != 0 ||
+        ioctl(peer, SIOCGIFINDEX, &ifr) != 0) {
+        return false;
+    }
+    address.can_ifindex = ifr.ifr_ifindex;
+    return bind(peer, (struct sockaddr *)&address, sizeof(address)) == 0;
+}
+
+static bool peer_send(uint32_t id, bool extended, bool fd, bool brs, const uint8_t *data, uint8_t length)
+{
+    struct canfd_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = extended ? ((id & CAN_EFF_MASK) | CAN_EFF_FLAG) : (id & CAN_SFF_MASK);
+    frame.len = length;
+    frame.flags = brs ? CANFD_BRS : 0U;
+    memcpy(frame.data, data, length);
+    const size_t size = fd ? CANFD_MTU : CAN_MTU;
+    return send(peer, &frame, size, 0) == (ssize_t)size;
+}
+
+/* Frame from the driver, or false when none arrives in time */
+static bool peer_receive(struct canfd_frame *frame, ssize_t *size, int timeout_ms)
+{
+    const double deadline = now_s() + timeout_ms * 1e-3;
+    do {
+        *size = recv(peer, frame, sizeof(*frame), MSG_DONTWAIT);
+        if (*size > 0) {
+            return true;
+        }
+        board_can_host_poll(1);
+    } while (now_s() < deadline);
+    return false;
+}
+
+/* Runs the driver until nothing has arrived for a while */
+static void drain(void)
+{
+    const uint32_t quiet_polls = 20U;
+    uint32_t quiet = 0U;
+    while (quiet < quiet_polls) {
+        const uint32_t before = can.rx_count;
+        board_can_host_poll(5);
+        quiet = (can.rx_count == before) ? quiet + 1U : 0U;
+    }
+}
+
+static void check_filters(void)
+{
+    const uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    const uint32_t cases = sizeof(filter_cases) / sizeof(filter_cases[0]);
+    uint32_t accepted = 0U;
+
+    for (uint32_t i = 0U; i < cases; i++) {
+        const filter_case_t *c = &filter_cases[i];
+        memset(stats, 0, sizeof(stats));
+        const uint32_t before = can.rx_count;
+        CHECK(peer_send(c->id, c->extended, false, false, data, sizeof(data)));
+        drain();
+
+        for (int handler = 0; handler < 3; handler++) {
+            CHECK(stats[handler].count == ((handler == c->handler) ? 1U : 0U));
+        }
+        if (c->handler >= 0) {
+            CHECK(stats[c->handler].last_id == c->id);
+            CHECK(((stats[c->handler].last_flags & CAN_FLAG_EXTENDED) != 0U) == c->extended);
+            accepted++;
+        }
+        /* Rejected frames never reach the driver at all */
+        CHECK(can.rx_count - before == ((c->handler >= 0) ? 1U : 0U));
+    }
+
+    /* The echo answered its one frame; take the reply off the bus */
+    struct canfd_frame reply;
+    while (recv(peer, &reply, sizeof(reply), MSG_DONTWAIT) > 0) {
+    }
+    printf("filters: %u frames, %u accepted by their filter, the others rejected\n", cases, accepted);
+}
+
+static void check_round_trip(bool fd, bool brs, uint8_t length)
+{
+    uint8_t data[64];
+    for (uint8_t i = 0U; i < length; i++) {
+        data[i] = (uint8_t)(0xA5U ^ (i * 7U));
+    }
+
+    CHECK(peer_send(BENCH_ECHO_ID, false, fd, brs, data, length));
+    struct canfd_frame reply;
+    ssize_t size = 0;
+    const bool received = peer_receive(&reply, &size, 100);
+    CHECK(received);
+    if (!received) {
+        return;
+    }
+
+    CHECK(size == (fd ? (ssize_t)CANFD_MTU : (ssize_t)CAN_MTU));
+    CHECK(reply.can_id == BENCH_REPLY_ID);
+    CHECK(reply.len == length);
+    CHECK(((reply.flags & CANFD_BRS) != 0U) == brs);
+    CHECK(memcmp(reply.data, data, length) == 0);
+    printf("round trip: %u bytes %s%s unchanged\n", length, fd ? "CAN FD" : "classic", brs ? " with BRS" : "");
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* 64-byte BRS frames through the echo, BENCH_WINDOW outstanding; the sequence number sits in the first byte */
+static void bench_throughput(void)
+{
+    uint8_t data[64];
+    memset(data, 0x55, sizeof(data));
+
+    uint32_t sent = 0U;
+    uint32_t received = 0U;
+    uint32_t errors = 0U;
+    uint32_t count = 0U;
+    const uint32_t dropped_before = can.tx_dropped;
+    const double start = now_s();
+    double now = start;
+
+    while (now - start < BENCH_SECONDS || received < sent) {
+        if (sent - received < BENCH_WINDOW && now - start < BENCH_SECONDS) {
+            data[0] = (uint8_t)(sent % BENCH_WINDOW);
+            sent_at[sent % BENCH_WINDOW] = now;
+            if (peer_send(BENCH_ECHO_ID, false, true, true, data, sizeof(data))) {
+                sent++;
+            }
+        }
+
+        board_can_host_poll(0);
+
+        struct canfd_frame reply;
+        while (recv(peer, &reply, sizeof(reply), MSG_DONTWAIT) > 0) {
+            now = now_s();
+            if (reply.can_id != BENCH_REPLY_ID || reply.len != sizeof(data) ||
+                reply.data[0] != (uint8_t)(received % BENCH_WINDOW)) {
+                errors++;
+            }
+            if (count < BENCH_MAX_SAMPLES) {
+                samples[count++] = now - sent_at[received % BENCH_WINDOW];
+            }
+            received++;
+        }
+
+        now = now_s();
+        if (now - start > BENCH_SECONDS + 1.0) {
+            break;
+        }
+    }
+
+    const double elapsed = now - start;
+    qsort(samples, count, sizeof(samples[0]), compare_double);
+    printf("throughput: %u frames of 64 bytes in %.2f s, %.0f frames/s, %.2f MB/s payload,"
+           " rtt p50 %.1f us p99 %.1f us, %u errors, %u dropped\n",
+           received, elapsed, received / elapsed, received * 64.0 / elapsed / 1e6,
+           (count > 0U) ? samples[count / 2U] * 1e6 : 0.0, (count > 0U) ? samples[count * 99U / 100U] * 1e6 : 0.0,
+           errors, can.tx_dropped - dropped_before);
+    CHECK(received == sent);
+    CHECK(errors == 0U);
+    CHECK(can.tx_dropped == dropped_before);
+}
+
+int main(void)
+{
+    const char *name = getenv("CUBEMOT_CAN_IF");
+    if (name == NULL) {
+        name = "vcan0";
+    }
+
+    board_can_bitrate_t bitrate;
+    can_bitrate_default(&bitrate);
+    if (bitrate.data_bitrate == 0U) {
+        fprintf(stderr, "DRIVER_CAN_FD_ENABLE must be set\n");
+        return EXIT_FAILURE;
+    }
+
+    CHECK(can_init(&can, board_can_get_config(BOARD_CAN_1), &bitrate) == CAN_SUCCESS);
+    CHECK(can_subscribe(&can, 0x200U, 0x780U, 0U, count_frame, &stats[0]) == CAN_SUCCESS);
+    CHECK(can_subscribe(&can, 0x18DA00F0U, 0x1FFFFFFEU, CAN_FLAG_EXTENDED, count_frame, &stats[1]) == CAN_SUCCESS);
+    CHECK(can_subscribe(&can, BENCH_ECHO_ID, 0x7FFU, 0U, echo_frame, &stats[2]) == CAN_SUCCESS);
+    if (can_start(&can) != CAN_SUCCESS || !open_peer(name)) {
+        fprintf(stderr, "cannot open %s; create it with tools/can_host/setup_vcan.sh\n", name);
+        return EXIT_FAILURE;
+    }
+
+    check_filters();
+    check_round_trip(true, true, 64);
+    check_round_trip(true, false, 64);
+    check_round_trip(true, true, 12);
+    check_round_trip(false, false, 8);
+    bench_throughput();
+
+    close(peer);
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,16 @@
+#!/bin/bash
+# Create a virtual CAN FD interface for running the CAN stack on the host.
+# usage: sudo ./setup_vcan.sh [interface]
+set -e
+
+IFACE="${1:-vcan0}"
+
+modprobe vcan
+if ! ip link show "$IFACE" > /dev/null 2>&1; then
+    ip link add dev "$IFACE" type vcan
+fi
+# MTU 72 enables CAN FD frames
+ip link set "$IFACE" mtu 72
+ip link set up "$IFACE"
+
+echo "$IFACE is up (CAN FD). Watch traffic with: candump -td $IFACE"
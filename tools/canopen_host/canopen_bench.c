@@ -0,0 +1,504 @@
+/*
+ * Host check and benchmark for the CANopen PDO path and CiA 402 device
+ * control. The CAN driver is replaced by a stub that keeps the subscriptions
+ * and records the frames sent, so the bench can play the master: it delivers
+ * NMT, RPDO and SYNC frames to the handlers as the CAN interrupt would, runs
+ * the control loop side of each cycle and reads back the TPDOs.
+ */
+#define _GNU_SOURCE
+
+#include "services/canopen/canopen.h"
+#include "services/cia402/cia402.h"
+#include "services/pdo/pdo.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_NODE_ID 5U
+#define BENCH_OTHER_NODE_ID 6U
+#define BENCH_FD_BITRATE 5000000U
+#define BENCH_MAX_SUBSCRIPTIONS 16U
+#define BENCH_MAX_SENT 8U
+#define BENCH_CYCLES 1000000U
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+typedef struct {
+    can_t *can;
+    uint32_t id;
+    uint32_t mask;
+    can_handler_t handler;
+    void *context;
+} subscription_t;
+
+typedef struct {
+    uint32_t id;
+    uint8_t flags;
+    uint8_t length;
+    uint8_t data[PDO_MAX_LENGTH];
+} sent_frame_t;
+
+typedef struct {
+    uint16_t controlword;
+    int32_t target_velocity;
+    int8_t mode;
+} rpdo_content_t;
+
+/* Controlwords of the device control commands, fault reset with bit 7 rising */
+static const uint16_t command_controlwords[CIA402_COMMAND_COUNT] = {
+    [CIA402_COMMAND_NONE] = 0x0080U,
+    [CIA402_COMMAND_SHUTDOWN] = 0x0006U,
+    [CIA402_COMMAND_SWITCH_ON] = 0x0007U,
+    [CIA402_COMMAND_ENABLE_OPERATION] = 0x000FU,
+    [CIA402_COMMAND_DISABLE_VOLTAGE] = 0x0000U,
+    [CIA402_COMMAND_QUICK_STOP] = 0x0002U,
+    [CIA402_COMMAND_FAULT_RESET] = 0x0080U,
+};
+
+typedef struct {
+    cia402_state_t from;
+    cia402_command_t command;
+    cia402_state_t to;
+} transition_case_t;
+
+/* The CiA 402 transitions by number; every other command leaves the state as it is */
+static const transition_case_t transition_cases[] = {
+    {CIA402_STATE_SWITCH_ON_DISABLED, CIA402_COMMAND_SHUTDOWN, CIA402_STATE_READY_TO_SWITCH_ON},      /* 2 */
+    {CIA402_STATE_READY_TO_SWITCH_ON, CIA402_COMMAND_SWITCH_ON, CIA402_STATE_SWITCHED_ON},            /* 3 */
+    {CIA402_STATE_READY_TO_SWITCH_ON, CIA402_COMMAND_ENABLE_OPERATION, CIA402_STATE_SWITCHED_ON},     /* 3 */
+    {CIA402_STATE_SWITCHED_ON, CIA402_COMMAND_ENABLE_OPERATION, CIA402_STATE_OPERATION_ENABLED},      /* 4 */
+    {CIA402_STATE_OPERATION_ENABLED, CIA402_COMMAND_SWITCH_ON, CIA402_STATE_SWITCHED_ON},             /* 5 */
+    {CIA402_STATE_SWITCHED_ON, CIA402_COMMAND_SHUTDOWN, CIA402_STATE_READY_TO_SWITCH_ON},             /* 6 */
+    {CIA402_STATE_READY_TO_SWITCH_ON, CIA402_COMMAND_DISABLE_VOLTAGE, CIA402_STATE_SWITCH_ON_DISABLED}, /* 7 */
+    {CIA402_STATE_READY_TO_SWITCH_ON, CIA402_COMMAND_QUICK_STOP, CIA402_STATE_SWITCH_ON_DISABLED},    /* 7 */
+    {CIA402_STATE_OPERATION_ENABLED, CIA402_COMMAND_SHUTDOWN, CIA402_STATE_READY_TO_SWITCH_ON},       /* 8 */
+    {CIA402_STATE_OPERATION_ENABLED, CIA402_COMMAND_DISABLE_VOLTAGE, CIA402_STATE_SWITCH_ON_DISABLED}, /* 9 */
+    {CIA402_STATE_SWITCHED_ON, CIA402_COMMAND_DISABLE_VOLTAGE, CIA402_STATE_SWITCH_ON_DISABLED},      /* 10 */
+    {CIA402_STATE_SWITCHED_ON, CIA402_COMMAND_QUICK_STOP, CIA402_STATE_SWITCH_ON_DISABLED},           /* 10 */
+    {CIA402_STATE_OPERATION_ENABLED, CIA402_COMMAND_QUICK_STOP, CIA402_STATE_QUICK_STOP_ACTIVE},      /* 11 */
+    {CIA402_STATE_QUICK_STOP_ACTIVE, CIA402_COMMAND_DISABLE_VOLTAGE, CIA402_STATE_SWITCH_ON_DISABLED}, /* 12 */
+    {CIA402_STATE_FAULT, CIA402_COMMAND_FAULT_RESET, CIA402_STATE_SWITCH_ON_DISABLED},                /* 15 */
+    {CIA402_STATE_QUICK_STOP_ACTIVE, CIA402_COMMAND_ENABLE_OPERATION, CIA402_STATE_OPERATION_ENABLED}, /* 16 */
+};
+
+/* Statusword bits 6, 5, 3..0 per state, from the standard */
+static const uint16_t expected_status[CIA402_STATE_COUNT] = {
+    [CIA402_STATE_NOT_READY_TO_SWITCH_ON] = 0x0000U, [CIA402_STATE_SWITCH_ON_DISABLED] = 0x0040U,
+    [CIA402_STATE_READY_TO_SWITCH_ON] = 0x0021U,     [CIA402_STATE_SWITCHED_ON] = 0x0023U,
+    [CIA402_STATE_OPERATION_ENABLED] = 0x0027U,      [CIA402_STATE_QUICK_STOP_ACTIVE] = 0x0007U,
+    [CIA402_STATE_FAULT_REACTION_ACTIVE] = 0x000FU,  [CIA402_STATE_FAULT] = 0x0008U,
+};
+
+static int failures;
+static subscription_t subscriptions[BENCH_MAX_SUBSCRIPTIONS];
+static uint32_t subscription_count;
+static sent_frame_t sent[BENCH_MAX_SENT];
+static uint32_t sent_count;
+static uint32_t timestamp;
+
+/* Driver stub: the CAN interrupt is replaced by deliver() */
+can_error_t can_subscribe(can_t *can, uint32_t id, uint32_t mask, uint8_t flags, can_handler_t handler,
+                          void *context)
+{
+    (void)flags;
+    if (subscription_count == BENCH_MAX_SUBSCRIPTIONS) {
+        return CAN_ERROR_NO_SPACE;
+    }
+    subscriptions[subscription_count++] = (subscription_t){can, id, mask, handler, context};
+    return CAN_SUCCESS;
+}
+
+can_error_t can_send(can_t *can, uint32_t id, uint8_t flags, const void *data, uint8_t length)
+{
+    (void)can;
+    if (sent_count == BENCH_MAX_SENT) {
+        return CAN_ERROR_BUFFER_FULL;
+    }
+    sent_frame_t *frame = &sent[sent_count++];
+    frame->id = id;
+    frame->flags = flags;
+    frame->length = length;
+    memcpy(frame->data, data, length);
+    return CAN_SUCCESS;
+}
+
+/* A frame from the master; the first matching subscription gets it, as with the hardware filters */
+static void deliver(can_t *can, uint32_t id, const void *data, uint8_t length)
+{
+    const can_frame_t frame = {.id = id, .flags = 0U, .length = length, .timestamp = timestamp++, .data = data};
+    for (uint32_t i = 0U; i < subscription_count; i++) {
+        if (subscriptions[i].can == can && ((id ^ subscriptions[i].id) & subscriptions[i].mask) == 0U) {
+            subscriptions[i].handler(&frame, subscriptions[i].context);
+            return;
+        }
+    }
+}
+
+static void nmt(can_t *can, uint8_t command, uint8_t node_id)
+{
+    const uint8_t data[2] = {command, node_id};
+    deliver(can, CANOPEN_COB_NMT, data, sizeof(data));
+}
+
+static void sync(can_t *can)
+{
+    deliver(can, CANOPEN_COB_SYNC, NULL, 0U);
+}
+
+static void rpdo(can_t *can, uint8_t node_id, const rpdo_content_t *content)
+{
+    uint8_t data[7];
+    memcpy(&data[0], &content->controlword, 2U);
+    memcpy(&data[2], &content->target_velocity, 4U);
+    memcpy(&data[6], &content->mode, 1U);
+    deliver(can, CANOPEN_COB_RPDO1 + node_id, data, sizeof(data));
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void check_pdo_map(void)
+{
+    uint8_t u8 = 0x11U;
+    uint16_t u16 = 0x2233U;
+    uint32_t u32 = 0x44556677U;
+    uint8_t big[31] = {0};
+    const pdo_object_t dictionary[] = {
+        {0x2000U, 1U, sizeof(u8), PDO_ACCESS_RX | PDO_ACCESS_TX, &u8},
+        {0x2000U, 2U, sizeof(u16), PDO_ACCESS_RX | PDO_ACCESS_TX, &u16},
+        {0x2001U, 0U, sizeof(u32), PDO_ACCESS_TX, &u32},
+        {0x2002U, 0U, sizeof(big), PDO_ACCESS_TX, big},
+    };
+    const size_t size = sizeof(dictionary) / sizeof(dictionary[0]);
+    pdo_map_t map;
+
+    /* Mapping order, not dictionary order, sets the layout; the values are read when packing */
+    const uint32_t mapping[] = {PDO_MAPPING(0x2001U, 0U, 32U), PDO_MAPPING(0x2000U, 1U, 8U),
+                                PDO_MAPPING(0x2000U, 2U, 16U)};
+    CHECK(pdo_map_configure(&map, dictionary, size, mapping, 3U, PDO_ACCESS_TX) == PDO_SUCCESS);
+    CHECK(map.count == 3U && map.length == 7U);
+    u32 = 0x8899AABBU;
+
+    uint8_t buffer[PDO_MAX_LENGTH];
+    const uint8_t expected[7] = {0xBBU, 0xAAU, 0x99U, 0x88U, 0x11U, 0x33U, 0x22U};
+    pdo_pack(&map, buffer);
+    CHECK(memcmp(buffer, expected, sizeof(expected)) == 0);
+
+    const uint32_t rx_mapping[] = {PDO_MAPPING(0x2000U, 2U, 16U), PDO_MAPPING(0x2000U, 1U, 8U)};
+    const uint8_t received[3] = {0xCDU, 0xABU, 0xEFU};
+    CHECK(pdo_map_configure(&map, dictionary, size, rx_mapping, 2U, PDO_ACCESS_RX) == PDO_SUCCESS);
+    pdo_unpack(&map, received);
+    CHECK(u16 == 0xABCDU && u8 == 0xEFU);
+
+    /* Rejected mappings leave an empty map behind */
+    const uint32_t unknown[] = {PDO_MAPPING(0x2003U, 0U, 8U)};
+    const uint32_t partial[] = {PDO_MAPPING(0x2001U, 0U, 16U)};
+    const uint32_t too_long[] = {PDO_MAPPING(0x2002U, 0U, 248U), PDO_MAPPING(0x2002U, 0U, 248U),
+                                 PDO_MAPPING(0x2001U, 0U, 32U)};
+    CHECK(pdo_map_configure(&map, dictionary, size, unknown, 1U, PDO_ACCESS_TX) == PDO_ERROR_NO_OBJECT);
+    CHECK(pdo_map_configure(&map, dictionary, size, partial, 1U, PDO_ACCESS_TX) == PDO_ERROR_LENGTH);
+    CHECK(pdo_map_configure(&map, dictionary, size, &mapping[0], 1U, PDO_ACCESS_RX) == PDO_ERROR_NOT_MAPPABLE);
+    CHECK(pdo_map_configure(&map, dictionary, size, too_long, 3U, PDO_ACCESS_TX) == PDO_ERROR_LENGTH);
+    CHECK(pdo_map_configure(&map, dictionary, size, mapping, PDO_MAX_ENTRIES + 1U, PDO_ACCESS_TX) ==
+          PDO_ERROR_INVALID_PARAM);
+    CHECK(map.count == 0U && map.length == 0U);
+    printf("pdo: pack and unpack follow the mapping, bad mappings rejected\n");
+}
+
+/* Node with RPDO1 = controlword, target velocity, mode and TPDO1 = statusword, velocity actual, mode display */
+static void setup_node(canopen_t *co, can_t *can, cia402_t *drive, uint8_t node_id)
+{
+    pdo_object_t dictionary[CIA402_OBJECT_COUNT];
+    const uint32_t rx_mapping[] = {PDO_MAPPING(0x6040U, 0U, 16U), PDO_MAPPING(0x60FFU, 0U, 32U),
+                                   PDO_MAPPING(0x6060U, 0U, 8U)};
+    const uint32_t tx_mapping[] = {PDO_MAPPING(0x6041U, 0U, 16U), PDO_MAPPING(0x606CU, 0U, 32U),
+                                   PDO_MAPPING(0x6061U, 0U, 8U)};
+
+    cia402_init(drive);
+    const size_t size = cia402_get_objects(drive, dictionary, CIA402_OBJECT_COUNT);
+    CHECK(size == CIA402_OBJECT_COUNT);
+    CHECK(canopen_init(co, can, node_id) == CANOPEN_SUCCESS);
+    CHECK(canopen_map_rpdo(co, 0U, dictionary, size, rx_mapping, 3U) == CANOPEN_SUCCESS);
+    CHECK(canopen_map_tpdo(co, 0U, dictionary, size, tx_mapping, 3U) == CANOPEN_SUCCESS);
+}
+
+static void check_sync_buffer(void)
+{
+    can_t can = {.bitrate = {.data_bitrate = BENCH_FD_BITRATE}};
+    canopen_t co;
+    cia402_t drive;
+    subscription_count = 0U;
+    setup_node(&co, &can, &drive, BENCH_NODE_ID);
+
+    sent_count = 0U;
+    CHECK(canopen_start(&co) == CANOPEN_SUCCESS);
+    CHECK(sent_count == 1U && sent[0].id == CANOPEN_COB_HEARTBEAT + BENCH_NODE_ID && sent[0].data[0] == 0x00U);
+    CHECK(canopen_get_nmt_state(&co) == CANOPEN_NMT_PRE_OPERATIONAL);
+
+    /* Pre-operational: process data and SYNC are ignored, no TPDO goes out */
+    const rpdo_content_t first = {0x0006U, 1000, CIA402_MODE_CYCLIC_SYNC_VELOCITY};
+    sent_count = 0U;
+    rpdo(&can, BENCH_NODE_ID, &first);
+    sync(&can);
+    CHECK(!canopen_sync_begin(&co));
+    canopen_sync_end(&co);
+    CHECK(sent_count == 0U && drive.target_velocity == 0);
+
+    nmt(&can, 0x01U, BENCH_OTHER_NODE_ID);
+    CHECK(canopen_get_nmt_state(&co) == CANOPEN_NMT_PRE_OPERATIONAL);
+    nmt(&can, 0x01U, 0U);
+    CHECK(canopen_get_nmt_state(&co) == CANOPEN_NMT_OPERATIONAL);
+    CHECK(canopen_map_rpdo(&co, 0U, NULL, 0U, NULL, 0U) == CANOPEN_ERROR_STATE);
+
+    /* An RPDO only takes effect at the next SYNC, and the last one before it wins */
+    const rpdo_content_t second = {0x0007U, 2000, CIA402_MODE_CYCLIC_SYNC_TORQUE};
+    rpdo(&can, BENCH_NODE_ID, &first);
+    rpdo(&can, BENCH_NODE_ID, &second);
+    CHECK(!canopen_sync_begin(&co));
+    CHECK(drive.controlword == 0U && drive.target_velocity == 0);
+    sync(&can);
+
+    /* One arriving between the SYNC and the control loop belongs to the next cycle */
+    const rpdo_content_t third = {0x000FU, 3000, CIA402_MODE_CYCLIC_SYNC_VELOCITY};
+    rpdo(&can, BENCH_NODE_ID, &third);
+    CHECK(canopen_sync_begin(&co));
+    CHECK(!canopen_sync_begin(&co));
+    CHECK(drive.controlword == second.controlword && drive.target_velocity == second.target_velocity &&
+          drive.mode == second.mode);
+
+    /* The TPDO answers in the same cycle, with bit rate switching on an FD bus */
+    drive.velocity_actual = -1234;
+    cia402_process(&drive);
+    sent_count = 0U;
+    canopen_sync_end(&co);
+    CHECK(sent_count == 1U);
+    CHECK(sent[0].id == CANOPEN_COB_TPDO1 + BENCH_NODE_ID && sent[0].length == 7U);
+    CHECK(sent[0].flags == (CAN_FLAG_FD | CAN_FLAG_BRS));
+    int32_t velocity;
+    memcpy(&velocity, &sent[0].data[2], sizeof(velocity));
+    CHECK(velocity == -1234 && (int8_t)sent[0].data[6] == drive.mode_display);
+
+    sync(&can);
+    CHECK(canopen_sync_begin(&co) && drive.target_velocity == third.target_velocity);
+
+    /* A SYNC without a new RPDO keeps the objects the application may have changed since */
+    drive.target_velocity = 42;
+    sync(&can);
+    CHECK(canopen_sync_begin(&co) && drive.target_velocity == 42);
+    CHECK(co.sync_count == 3U);
+
+    /* Reset communication drops what was buffered and announces the node again */
+    rpdo(&can, BENCH_NODE_ID, &first);
+    sent_count = 0U;
+    nmt(&can, 0x82U, BENCH_NODE_ID);
+    CHECK(canopen_get_nmt_state(&co) == CANOPEN_NMT_PRE_OPERATIONAL);
+    CHECK(sent_count == 1U && sent[0].id == CANOPEN_COB_HEARTBEAT + BENCH_NODE_ID);
+    nmt(&can, 0x01U, BENCH_NODE_ID);
+    sync(&can);
+    CHECK(canopen_sync_begin(&co) && drive.target_velocity == 42);
+    printf("sync: RPDOs published on SYNC only, TPDOs answer in the same cycle\n");
+}
+
+/* Two nodes, each on its own controller, must keep their own RPDO subscriptions */
+static void check_instances(void)
+{
+    can_t cans[2] = {{.bitrate = {.data_bitrate = 0U}}, {.bitrate = {.data_bitrate = 0U}}};
+    canopen_t nodes[2];
+    cia402_t drives[2];
+    const uint8_t node_ids[2] = {BENCH_NODE_ID, BENCH_OTHER_NODE_ID};
+    const rpdo_content_t content[2] = {{0x0006U, 111, CIA402_MODE_PROFILE_VELOCITY},
+                                       {0x0007U, 222, CIA402_MODE_CYCLIC_SYNC_POSITION}};
+    subscription_count = 0U;
+    for (int i = 0; i < 2; i++) {
+        setup_node(&nodes[i], &cans[i], &drives[i], node_ids[i]);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        nmt(&cans[i], 0x01U, 0U);
+        rpdo(&cans[i], node_ids[i], &content[i]);
+        sync(&cans[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        CHECK(canopen_sync_begin(&nodes[i]));
+        CHECK(drives[i].target_velocity == content[i].target_velocity && drives[i].mode == content[i].mode);
+    }
+
+    /* Classic CAN: the TPDO goes out without FD flags and a mapping over 8 bytes is refused */
+    sent_count = 0U;
+    canopen_sync_end(&nodes[0]);
+    CHECK(sent_count == 1U && sent[0].flags == 0U);
+    nmt(&cans[0], 0x80U, 0U);
+    pdo_object_t dictionary[CIA402_OBJECT_COUNT];
+    const size_t size = cia402_get_objects(&drives[0], dictionary, CIA402_OBJECT_COUNT);
+    const uint32_t long_mapping[] = {PDO_MAPPING(0x6041U, 0U, 16U), PDO_MAPPING(0x6064U, 0U, 32U),
+                                     PDO_MAPPING(0x606CU, 0U, 32U)};
+    CHECK(canopen_map_tpdo(&nodes[0], 1U, dictionary, size, long_mapping, 3U) == CANOPEN_ERROR_MAPPING);
+    printf("instances: two nodes keep their own process data\n");
+}
+
+static void step(cia402_t *drive, uint16_t controlword)
+{
+    drive->controlword = controlword;
+    cia402_process(drive);
+}
+
+/* Bring a fresh drive into a state through the regular transitions */
+static void enter_state(cia402_t *drive, cia402_state_t state)
+{
+    cia402_init(drive);
+    step(drive, 0x0000U);
+    switch (state) {
+        case CIA402_STATE_READY_TO_SWITCH_ON:
+            step(drive, 0x0006U);
+            break;
+        case CIA402_STATE_SWITCHED_ON:
+            step(drive, 0x0006U);
+            step(drive, 0x0007U);
+            break;
+        case CIA402_STATE_OPERATION_ENABLED:
+        case CIA402_STATE_QUICK_STOP_ACTIVE:
+        case CIA402_STATE_FAULT_REACTION_ACTIVE:
+        case CIA402_STATE_FAULT:
+            step(drive, 0x0006U);
+            step(drive, 0x0007U);
+            step(drive, 0x000FU);
+            if (state == CIA402_STATE_QUICK_STOP_ACTIVE) {
+                step(drive, 0x0002U);
+            } else if (state != CIA402_STATE_OPERATION_ENABLED) {
+                cia402_raise_fault(drive, 0x2310U);
+                step(drive, 0x000FU);
+                if (state == CIA402_STATE_FAULT) {
+                    cia402_reaction_done(drive);
+                    step(drive, 0x000FU);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static cia402_state_t expected_next(cia402_state_t from, cia402_command_t command)
+{
+    for (size_t i = 0U; i < sizeof(transition_cases) / sizeof(transition_cases[0]); i++) {
+        if (transition_cases[i].from == from && transition_cases[i].command == command) {
+            return transition_cases[i].to;
+        }
+    }
+    return from;
+}
+
+static void check_cia402(void)
+{
+    cia402_t drive;
+    uint32_t transitions = 0U;
+
+    cia402_init(&drive);
+    CHECK(cia402_get_state(&drive) == CIA402_STATE_NOT_READY_TO_SWITCH_ON);
+    step(&drive, 0x0000U);
+    CHECK(cia402_get_state(&drive) == CIA402_STATE_SWITCH_ON_DISABLED); /* 1 */
+    cia402_init(&drive);
+    step(&drive, 0x0006U);
+    CHECK(cia402_get_state(&drive) == CIA402_STATE_READY_TO_SWITCH_ON); /* 1 and 2 in the first cycle */
+
+    for (int state = CIA402_STATE_SWITCH_ON_DISABLED; state < CIA402_STATE_COUNT; state++) {
+        enter_state(&drive, (cia402_state_t)state);
+        CHECK(cia402_get_state(&drive) == (cia402_state_t)state);
+        CHECK(drive.statusword == (expected_status[state] | (1U << 9)));
+
+        for (int command = CIA402_COMMAND_SHUTDOWN; command < CIA402_COMMAND_COUNT; command++) {
+            enter_state(&drive, (cia402_state_t)state);
+            step(&drive, command_controlwords[command]);
+            const cia402_state_t next = expected_next((cia402_state_t)state, (cia402_command_t)command);
+            CHECK(cia402_get_state(&drive) == next);
+            transitions += (next != (cia402_state_t)state) ? 1U : 0U;
+        }
+
+        /* Fault reset acts on the edge of bit 7: holding it is no command */
+        step(&drive, command_controlwords[CIA402_COMMAND_NONE]);
+        const cia402_state_t held = cia402_get_state(&drive);
+        step(&drive, command_controlwords[CIA402_COMMAND_NONE]);
+        CHECK(cia402_get_state(&drive) == held);
+    }
+
+    /* Fault: the error code shows until the reset; the drive flags pass through the statusword */
+    enter_state(&drive, CIA402_STATE_FAULT);
+    CHECK(drive.error_code == 0x2310U && !cia402_is_power_enabled(&drive));
+    cia402_set_drive_status(&drive, 0xFFFFU);
+    step(&drive, 0x0080U);
+    CHECK(drive.error_code == 0U);
+    CHECK(drive.statusword == (0x0040U | (1U << 9) | CIA402_STATUS_VOLTAGE_ENABLED | CIA402_STATUS_WARNING |
+                               CIA402_STATUS_TARGET_REACHED | CIA402_STATUS_INTERNAL_LIMIT));
+
+    /* Quick stop: power stays on without following setpoints, and the stop finishes in its own mode */
+    enter_state(&drive, CIA402_STATE_OPERATION_ENABLED);
+    drive.mode = CIA402_MODE_CYCLIC_SYNC_VELOCITY;
+    step(&drive, 0x000FU);
+    CHECK(drive.mode_display == CIA402_MODE_CYCLIC_SYNC_VELOCITY && cia402_is_operation_enabled(&drive));
+    step(&drive, 0x0002U);
+    drive.mode = CIA402_MODE_CYCLIC_SYNC_POSITION;
+    step(&drive, 0x0002U);
+    CHECK(cia402_is_power_enabled(&drive) && !cia402_is_operation_enabled(&drive));
+    CHECK(drive.mode_display == CIA402_MODE_CYCLIC_SYNC_VELOCITY);
+    cia402_reaction_done(&drive);
+    step(&drive, 0x0002U);
+    CHECK(cia402_get_state(&drive) == CIA402_STATE_SWITCH_ON_DISABLED); /* 12 */
+    CHECK(drive.mode_display == CIA402_MODE_CYCLIC_SYNC_POSITION && !cia402_is_power_enabled(&drive));
+
+    printf("cia402: %u transitions and every other command checked from each state\n", transitions);
+}
+
+/* One control cycle: RPDO and SYNC in the CAN interrupt, then unpack, device control and TPDO */
+static void bench_cycle(void)
+{
+    can_t can = {.bitrate = {.data_bitrate = BENCH_FD_BITRATE}};
+    canopen_t co;
+    cia402_t drive;
+    subscription_count = 0U;
+    setup_node(&co, &can, &drive, BENCH_NODE_ID);
+    nmt(&can, 0x01U, BENCH_NODE_ID);
+
+    rpdo_content_t content = {0x000FU, 0, CIA402_MODE_CYCLIC_SYNC_VELOCITY};
+    uint32_t cycles = 0U;
+    const uint64_t start = now_ns();
+    for (uint32_t i = 0U; i < BENCH_CYCLES; i++) {
+        content.target_velocity = (int32_t)i;
+        rpdo(&can, BENCH_NODE_ID, &content);
+        sync(&can);
+        if (canopen_sync_begin(&co)) {
+            cycles++;
+        }
+        drive.velocity_actual = drive.target_velocity;
+        cia402_process(&drive);
+        sent_count = 0U;
+        canopen_sync_end(&co);
+    }
+    const double elapsed = (double)(now_ns() - start);
+
+    CHECK(cycles == BENCH_CYCLES && co.tpdo_dropped == 0U);
+    printf("cycle: %.1f ns for RPDO, SYNC, unpack, device control and TPDO\n", elapsed / BENCH_CYCLES);
+}
+
+int main(void)
+{
+    check_pdo_map();
+    check_sync_buffer();
+    check_instances();
+    check_cia402();
+    bench_cycle();
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
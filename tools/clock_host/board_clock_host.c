@@ -0,0 +1,115 @@
+/*
+ * Host implementation of boards/clock.h on CLOCK_MONOTONIC. The alarm is a
+ * POSIX timer raising SIGALRM, whose handler is the alarm interrupt;
+ * blocking SIGALRM stands in for masking interrupts around the sleep.
+ */
+#define _GNU_SOURCE
+
+#include "boards/clock.h"
+
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    board_clock_alarm_callback_t callback;
+    void *context;
+    uint64_t start; /* [ns] */
+    timer_t timer;
+    bool started;
+} board_clock_host_state_t;
+
+static board_clock_host_state_t clock_state;
+
+static uint64_t host_monotonic_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static void host_alarm(int signal)
+{
+    (void)signal;
+    if (clock_state.callback != NULL) {
+        clock_state.callback(clock_state.context);
+    }
+}
+
+void board_clock_init(board_clock_alarm_callback_t callback, void *context)
+{
+    clock_state.callback = callback;
+    clock_state.context = context;
+
+    if (clock_state.started) {
+        return;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = host_alarm;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, NULL);
+
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGALRM;
+    timer_create(CLOCK_MONOTONIC, &event, &clock_state.timer);
+
+    clock_state.start = host_monotonic_ns();
+    clock_state.started = true;
+}
+
+uint32_t board_clock_now(void)
+{
+    return (uint32_t)board_clock_now64();
+}
+
+uint64_t board_clock_now64(void)
+{
+    return (host_monotonic_ns() - clock_state.start) / 1000U;
+}
+
+void board_clock_set_alarm(uint32_t time)
+{
+    /* Place the wrapping time on the 64-bit clock; a time already passed fires at once */
+    const uint64_t now = board_clock_now64();
+    const int32_t ahead = (int32_t)(time - (uint32_t)now);
+    /* Never zero, which would disarm the timer instead */
+    const uint64_t at = clock_state.start + (now + (uint64_t)(ahead > 0 ? ahead : 0)) * 1000U + 1U;
+
+    const struct itimerspec spec = {
+        .it_value = {.tv_sec = (time_t)(at / 1000000000ULL), .tv_nsec = (long)(at % 1000000000ULL)},
+    };
+    timer_settime(clock_state.timer, TIMER_ABSTIME, &spec, NULL);
+}
+
+void board_clock_cancel_alarm(void)
+{
+    const struct itimerspec spec = {0};
+    timer_settime(clock_state.timer, 0, &spec, NULL);
+}
+
+uint32_t board_clock_sleep(bool (*ready)(void *context), void *context)
+{
+    sigset_t block;
+    sigset_t previous;
+    sigemptyset(&block);
+    sigaddset(&block, SIGALRM);
+    sigprocmask(SIG_BLOCK, &block, &previous);
+
+    uint32_t slept = 0U;
+    if (ready == NULL || !ready(context)) {
+        /* Unblocks SIGALRM and waits for it in one step, as WFI with PRIMASK set */
+        sigset_t wait = previous;
+        sigdelset(&wait, SIGALRM);
+        const uint32_t start = board_clock_now();
+        sigsuspend(&wait);
+        slept = board_clock_now() - start;
+    }
+
+    sigprocmask(SIG_SETMASK, &previous, NULL);
+    return slept;
+}
@@ -0,0 +1,154 @@
+/*
+ * Host check and benchmark for boards/clock.h on the clock_gettime port
+ * (board_clock_host.c): monotonicity and read cost of the 64-bit clock,
+ * alarm lateness, and the executive (services/executive) running its
+ * timers on it.
+ */
+#define _GNU_SOURCE
+
+#include "boards/clock.h"
+#include "services/executive/executive.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_READS 10000000U
+#define BENCH_ALARMS 200U
+#define BENCH_ALARM_DELAY_US 2000U
+#define BENCH_TIMER_PERIOD_US 10000U
+#define BENCH_TIMER_RUNS 50U
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+static int failures;
+
+static volatile bool alarm_fired;
+static volatile uint32_t alarm_fired_at;
+
+static uint32_t lateness[BENCH_ALARMS];
+
+static executive_t exec;
+static executive_timer_t timer;
+static uint32_t timer_runs;
+static uint64_t timer_started_at;
+
+static void on_alarm(void *context)
+{
+    (void)context;
+    alarm_fired_at = board_clock_now();
+    alarm_fired = true;
+}
+
+static bool alarm_ready(void *context)
+{
+    (void)context;
+    return alarm_fired;
+}
+
+static uint32_t wait_alarm(uint32_t time)
+{
+    alarm_fired = false;
+    board_clock_set_alarm(time);
+    while (!alarm_fired) {
+        board_clock_sleep(alarm_ready, NULL);
+    }
+    return alarm_fired_at;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void check_monotonic(void)
+{
+    struct timespec begin;
+    struct timespec end;
+
+    uint64_t last = board_clock_now64();
+    uint32_t backwards = 0U;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (uint32_t i = 0U; i < BENCH_READS; i++) {
+        const uint64_t now = board_clock_now64();
+        backwards += (now < last) ? 1U : 0U;
+        last = now;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    CHECK(backwards == 0U);
+
+    const uint32_t low = board_clock_now();
+    CHECK(low - (uint32_t)board_clock_now64() <= 1U || (uint32_t)board_clock_now64() - low <= 1U);
+
+    const double ns = (double)(end.tv_sec - begin.tv_sec) * 1e9 + (double)(end.tv_nsec - begin.tv_nsec);
+    printf("board_clock_now64: %.1f ns per read\n", ns / BENCH_READS);
+}
+
+static void check_alarm(void)
+{
+    for (uint32_t i = 0U; i < BENCH_ALARMS; i++) {
+        const uint32_t deadline = board_clock_now() + BENCH_ALARM_DELAY_US;
+        const uint32_t fired_at = wait_alarm(deadline);
+        CHECK((int32_t)(fired_at - deadline) >= 0);
+        lateness[i] = fired_at - deadline;
+    }
+
+    /* A time already passed fires at once */
+    const uint32_t start = board_clock_now();
+    CHECK(wait_alarm(start - 1000U) - start < BENCH_ALARM_DELAY_US);
+
+    /* A cancelled alarm does not fire, and a later one replaces it */
+    alarm_fired = false;
+    board_clock_set_alarm(board_clock_now() + 1000U);
+    board_clock_cancel_alarm();
+    const uint32_t later = board_clock_now() + 5U * BENCH_ALARM_DELAY_US;
+    CHECK((int32_t)(wait_alarm(later) - later) >= 0);
+
+    qsort(lateness, BENCH_ALARMS, sizeof(lateness[0]), compare_u32);
+    printf("alarm lateness, %u alarms: p50 %u us  p99 %u us  max %u us\n", BENCH_ALARMS, lateness[BENCH_ALARMS / 2U],
+           lateness[BENCH_ALARMS * 99U / 100U], lateness[BENCH_ALARMS - 1U]);
+}
+
+static void timer_task(void *context)
+{
+    (void)context;
+    if (++timer_runs < BENCH_TIMER_RUNS) {
+        return;
+    }
+
+    const uint64_t elapsed = board_clock_now64() - timer_started_at;
+    CHECK(elapsed >= (uint64_t)BENCH_TIMER_PERIOD_US * BENCH_TIMER_RUNS);
+    CHECK(elapsed < (uint64_t)BENCH_TIMER_PERIOD_US * (BENCH_TIMER_RUNS + 5U));
+    printf("executive: %u periods of %u us in %llu us\n", BENCH_TIMER_RUNS, BENCH_TIMER_PERIOD_US,
+           (unsigned long long)elapsed);
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    exit((failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+int main(void)
+{
+    board_clock_init(on_alarm, NULL);
+    check_monotonic();
+    check_alarm();
+
+    /* The executive takes the alarm over and never returns */
+    uint8_t task_id = 0U;
+    if (executive_init(&exec) != EXECUTIVE_SUCCESS ||
+        executive_add_task(&exec, "timer", timer_task, NULL, &task_id) != EXECUTIVE_SUCCESS) {
+        fprintf(stderr, "executive setup failed\n");
+        return EXIT_FAILURE;
+    }
+    timer_started_at = board_clock_now64();
+    executive_timer_start(&exec, &timer, task_id, BENCH_TIMER_PERIOD_US, BENCH_TIMER_PERIOD_US);
+    executive_run(&exec);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,216 @@
+/*
+ * Host check and benchmark for control/deadline. The bench supplies the
+ * board timebase itself: a simulated 170 MHz counter that starts just short
+ * of its wrap and only moves when a periodic task played by the bench
+ * advances it by a set latency and run time. Exact responses around the
+ * deadline must count as they should; phases of clean runs and of overruns
+ * must raise and lower the degradation level by the windows configured, and
+ * report every change to the callback. Then the cost of a begin and end pair
+ * is timed.
+ */
+#define _GNU_SOURCE
+
+#include "control/deadline/deadline.h"
+#include "boards/timebase.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_TIMEBASE_HZ 170000000U
+#define BENCH_TIMEBASE_START 0xFFFF0000U /* wraps during the first run */
+#define BENCH_DEADLINE_US 1000U
+#define BENCH_LATENCY_US 2U
+#define BENCH_RUN_US 10U
+#define BENCH_OVERRUN_US 1100U
+#define BENCH_MAX_LEVEL 2U
+#define BENCH_SAMPLES 1000000U
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+static int failures;
+
+static uint32_t now_ticks = BENCH_TIMEBASE_START;
+static deadline_monitor_t monitor;
+static uint8_t levels[16];
+static uint32_t level_changes;
+
+static void on_degrade(void *context, uint8_t level)
+{
+    (void)context;
+    if (level_changes < sizeof(levels)) {
+        levels[level_changes] = level;
+    }
+    level_changes++;
+}
+
+/* Simulated timebase: stands still until the task below moves it */
+void board_timebase_init(void)
+{
+}
+
+uint32_t board_timebase_now(void)
+{
+    return now_ticks;
+}
+
+uint32_t board_timebase_frequency(void)
+{
+    return BENCH_TIMEBASE_HZ;
+}
+
+static uint32_t ticks(uint32_t us)
+{
+    return (uint32_t)((uint64_t)us * BENCH_TIMEBASE_HZ / 1000000U);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* One run starting latency_ticks after its release and taking run_ticks; the next release is a deadline later */
+static bool run_ticks(uint32_t latency_ticks, uint32_t run_ticks)
+{
+    const uint32_t release = now_ticks;
+    now_ticks += latency_ticks;
+    deadline_begin(&monitor, release);
+    now_ticks += run_ticks;
+    const bool missed = deadline_end(&monitor);
+    if (now_ticks - release < ticks(BENCH_DEADLINE_US)) {
+        now_ticks = release + ticks(BENCH_DEADLINE_US);
+    }
+    return missed;
+}
+
+static bool run(uint32_t run_us)
+{
+    return run_ticks(ticks(BENCH_LATENCY_US), ticks(run_us));
+}
+
+static void run_count(uint32_t count, uint32_t run_us)
+{
+    for (uint32_t i = 0U; i < count; i++) {
+        run(run_us);
+    }
+}
+
+/* The deadline covers the response, latency included, and a run ending on it is in time */
+static void check_response(void)
+{
+    const uint32_t deadline = ticks(BENCH_DEADLINE_US);
+    CHECK(deadline_init(&monitor, BENCH_DEADLINE_US, BENCH_MAX_LEVEL, NULL, NULL) == DEADLINE_SUCCESS);
+    CHECK(monitor.deadline == deadline);
+
+    CHECK(!run_ticks(0U, deadline));
+    CHECK(run_ticks(0U, deadline + 1U));
+    CHECK(!run_ticks(deadline / 2U, deadline - deadline / 2U));
+    CHECK(run_ticks(deadline / 2U, deadline - deadline / 2U + 1U));
+    CHECK(run_ticks(deadline + 1U, 0U));
+    CHECK(monitor.stats.runs == 5U && monitor.stats.misses == 3U);
+
+    CHECK(monitor.stats.latency_max == deadline + 1U);
+    CHECK(monitor.stats.run_time_max == deadline + 1U);
+    CHECK(monitor.stats.response_max == deadline + 1U);
+    CHECK(monitor.stats.latency_last == deadline + 1U && monitor.stats.run_time_last == 0U);
+
+    deadline_reset_stats(&monitor);
+    CHECK(monitor.stats.runs == 0U && monitor.stats.misses == 0U && monitor.stats.response_max == 0U);
+    printf("response: a run ending on the deadline is in time, one tick later is a miss\n");
+}
+
+static void check_degradation(void)
+{
+    CHECK(deadline_init(NULL, BENCH_DEADLINE_US, BENCH_MAX_LEVEL, on_degrade, NULL) == DEADLINE_ERROR_INVALID_PARAM);
+    CHECK(deadline_init(&monitor, 0U, BENCH_MAX_LEVEL, on_degrade, NULL) == DEADLINE_ERROR_INVALID_PARAM);
+    CHECK(deadline_init(&monitor, BENCH_DEADLINE_US, BENCH_MAX_LEVEL, on_degrade, NULL) == DEADLINE_SUCCESS);
+
+    /* A run past the deadline is a miss, one within it is not */
+    CHECK(!run(BENCH_RUN_US));
+    CHECK(run(BENCH_OVERRUN_US));
+    CHECK(monitor.stats.misses == 1U);
+    CHECK(monitor.stats.response_max == ticks(BENCH_LATENCY_US + BENCH_OVERRUN_US));
+    if (DEADLINE_MISS_LIMIT > 1U) {
+        run_count(DEADLINE_WINDOW - 2U, BENCH_RUN_US);
+        CHECK(monitor.stats.level == 0U);
+
+        /* Fewer misses than the limit per window are tolerated */
+        for (uint32_t i = 0U; i < 3U; i++) {
+            run_count(DEADLINE_MISS_LIMIT - 1U, BENCH_OVERRUN_US);
+            run_count(DEADLINE_WINDOW - (DEADLINE_MISS_LIMIT - 1U), BENCH_RUN_US);
+            CHECK(monitor.stats.level == 0U);
+        }
+    } else {
+        CHECK(monitor.stats.level == 1U);
+        level_changes = 0U;
+        deadline_init(&monitor, BENCH_DEADLINE_US, BENCH_MAX_LEVEL, on_degrade, NULL);
+    }
+    deadline_reset_stats(&monitor);
+
+    /* Each burst of misses closes its window early and steps down a level, until the last */
+    for (uint32_t level = 1U; level <= BENCH_MAX_LEVEL + 1U; level++) {
+        run_count(DEADLINE_MISS_LIMIT, BENCH_OVERRUN_US);
+        CHECK(monitor.stats.level == ((level < BENCH_MAX_LEVEL) ? level : BENCH_MAX_LEVEL));
+    }
+    CHECK(monitor.stats.degradations == BENCH_MAX_LEVEL);
+
+    /* Windows without a miss step back up; a window with a few misses starts the count again */
+    run_count((DEADLINE_RECOVER_WINDOWS - 1U) * DEADLINE_WINDOW, BENCH_RUN_US);
+    CHECK(monitor.stats.level == BENCH_MAX_LEVEL);
+    if (DEADLINE_MISS_LIMIT > 1U) {
+        run_count(1U, BENCH_OVERRUN_US);
+        run_count(DEADLINE_WINDOW - 1U, BENCH_RUN_US);
+        run_count((DEADLINE_RECOVER_WINDOWS - 1U) * DEADLINE_WINDOW, BENCH_RUN_US);
+        CHECK(monitor.stats.level == BENCH_MAX_LEVEL);
+    }
+    run_count(DEADLINE_WINDOW, BENCH_RUN_US);
+    CHECK(monitor.stats.level == BENCH_MAX_LEVEL - 1U);
+    run_count(DEADLINE_RECOVER_WINDOWS * DEADLINE_WINDOW * BENCH_MAX_LEVEL, BENCH_RUN_US);
+    CHECK(monitor.stats.level == 0U);
+
+    CHECK(level_changes == 2U * BENCH_MAX_LEVEL);
+    for (uint32_t i = 0U; i < BENCH_MAX_LEVEL && i < level_changes; i++) {
+        CHECK(levels[i] == i + 1U);
+        CHECK(levels[BENCH_MAX_LEVEL + i] == BENCH_MAX_LEVEL - 1U - i);
+    }
+
+    printf("%u runs, %u misses, %u degradations; run time max %.1f us, response max %.1f us\n", monitor.stats.runs,
+           monitor.stats.misses, monitor.stats.degradations,
+           monitor.stats.run_time_max * 1e6 / board_timebase_frequency(),
+           monitor.stats.response_max * 1e6 / board_timebase_frequency());
+}
+
+static void bench_overhead(void)
+{
+    deadline_init(&monitor, BENCH_DEADLINE_US, BENCH_MAX_LEVEL, NULL, NULL);
+
+    const uint64_t start = now_ns();
+    for (uint32_t i = 0U; i < BENCH_SAMPLES; i++) {
+        deadline_begin(&monitor, now_ticks);
+        now_ticks += ticks(BENCH_RUN_US);
+        deadline_end(&monitor);
+    }
+    const uint64_t elapsed = now_ns() - start;
+
+    /* The simulated timebase is a plain load; on the target it is a cycle counter read */
+    printf("begin and end: %.1f ns per run\n", (double)elapsed / BENCH_SAMPLES);
+    CHECK(monitor.stats.runs == BENCH_SAMPLES && monitor.stats.misses == 0U);
+}
+
+int main(void)
+{
+    check_response();
+    check_degradation();
+    bench_overhead();
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,44 @@
+/*
+ * Host implementation of the boards/irq.h software interrupt. SIGUSR1 is
+ * the software interrupt. Interrupts of higher priority are signal
+ * handlers that block SIGUSR1 while they run, so work they pend runs
+ * once they return, as with the NVIC. Blocking SIGUSR1 in the main
+ * context stands in for masking interrupts.
+ */
+#define _GNU_SOURCE
+
+#include "boards/irq.h"
+
+#include <signal.h>
+#include <string.h>
+
+static board_irq_soft_handler_t soft_handler;
+
+static void host_soft_irq(int signal)
+{
+    (void)signal;
+    if (soft_handler != NULL) {
+        soft_handler();
+    }
+}
+
+void board_irq_init(void)
+{
+}
+
+void board_irq_soft_init(board_irq_soft_handler_t handler)
+{
+    soft_handler = handler;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = host_soft_irq;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+}
+
+void board_irq_soft_pend(void)
+{
+    raise(SIGUSR1);
+}
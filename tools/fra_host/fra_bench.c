@@ -0,0 +1,318 @@
+/*
+ * Host check and benchmark for control/fra. Sweeps are run against
+ * discrete plants whose response is known exactly: a resonant second-order
+ * current loop in closed-loop mode, and a PI speed loop around an inertia in
+ * open-loop mode. Every point must match the model in gain and phase, and
+ * the stream must carry every point and the end line. An abort must end the
+ * sweep as aborted however it meets the background. Then the cost of a
+ * tick is timed.
+ */
+#define _GNU_SOURCE
+
+#include "control/fra/fra.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_GAIN_TOLERANCE_DB 0.1
+#define BENCH_PHASE_TOLERANCE_DEG 1.0
+#define BENCH_TICK_LIMIT 10000000U
+
+/* Resonant current loop: poles at radius 0.95 and 1 kHz, one tick of delay, unity DC gain */
+#define BENCH_PLANT_RADIUS 0.95
+#define BENCH_PLANT_RESONANCE_HZ 1000.0
+
+/* Speed loop: PI around an inertia, crossover near 100 Hz */
+#define BENCH_INERTIA_GAIN 200.0 /* [rad/s per tick per unit of torque] */
+#define BENCH_PI_KP 0.3
+#define BENCH_PI_KI 60.0 /* [1/s] */
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+typedef struct {
+    double a1;
+    double a2;
+    double b1;
+    double x1;
+    double y1;
+    double y2;
+} plant_t;
+
+static int failures;
+
+/* The stream goes to a text buffer; a full buffer refuses the line like a full UART */
+static uart_t stream;
+static char streamed[8192];
+static size_t streamed_length;
+
+uart_error_t uart_write(uart_t *uart, const void *data, size_t size)
+{
+    if (uart != &stream) {
+        return UART_ERROR_INVALID_PARAM;
+    }
+    if (streamed_length + size >= sizeof(streamed)) {
+        return UART_ERROR_BUFFER_FULL;
+    }
+    memcpy(&streamed[streamed_length], data, size);
+    streamed_length += size;
+    streamed[streamed_length] = '\0';
+    return UART_SUCCESS;
+}
+
+static void plant_init(plant_t *plant, double sample_rate)
+{
+    const double theta = 2.0 * M_PI * BENCH_PLANT_RESONANCE_HZ / sample_rate;
+    memset(plant, 0, sizeof(*plant));
+    plant->a1 = -2.0 * BENCH_PLANT_RADIUS * cos(theta);
+    plant->a2 = BENCH_PLANT_RADIUS * BENCH_PLANT_RADIUS;
+    plant->b1 = 1.0 + plant->a1 + plant->a2;
+}
+
+static double plant_step(plant_t *plant, double x)
+{
+    const double y = plant->b1 * plant->x1 - plant->a1 * plant->y1 - plant->a2 * plant->y2;
+    plant->x1 = x;
+    plant->y2 = plant->y1;
+    plant->y1 = y;
+    return y;
+}
+
+/* H(z) = b1 z^-1 / (1 + a1 z^-1 + a2 z^-2) */
+static double complex plant_response(const plant_t *plant, double frequency, double sample_rate)
+{
+    const double complex z1 = cexp(-I * 2.0 * M_PI * frequency / sample_rate);
+    return plant->b1 * z1 / (1.0 + plant->a1 * z1 + plant->a2 * z1 * z1);
+}
+
+/* L(z) = C(z) P(z): PI with the integral updated before use, inertia with one tick of delay */
+static double complex loop_response(double frequency, double sample_rate)
+{
+    const double complex z1 = cexp(-I * 2.0 * M_PI * frequency / sample_rate);
+    const double complex controller = BENCH_PI_KP + BENCH_PI_KI / sample_rate / (1.0 - z1);
+    const double complex inertia = BENCH_INERTIA_GAIN / sample_rate * z1 / (1.0 - z1);
+    return controller * inertia;
+}
+
+static uint32_t count_lines(const char *prefix)
+{
+    uint32_t count = 0U;
+    for (const char *line = strstr(streamed, prefix); line != NULL; line = strstr(line + 1, prefix)) {
+        count++;
+    }
+    return count;
+}
+
+/* A background slice every few ticks, as the main loop would run them; false once the sweep has ended */
+static bool process(fra_t *fra, uint32_t tick)
+{
+    return ((tick % 16U) != 0U) || fra_process(fra);
+}
+
+static void check_points(const fra_t *fra, double complex (*model)(const void *, double, double), const void *context,
+                         const char *name)
+{
+    double gain_error = 0.0;
+    double phase_error = 0.0;
+
+    for (uint16_t i = 0U; i < fra->config.points; i++) {
+        fra_point_t point;
+        CHECK(fra_get_point(fra, i, &point) == FRA_SUCCESS);
+
+        const double complex expected = model(context, point.frequency, fra->config.sample_rate);
+        const double complex ratio = (point.re + I * point.im) / expected;
+        gain_error = fmax(gain_error, fabs(20.0 * log10(cabs(ratio))));
+        phase_error = fmax(phase_error, fabs(carg(ratio)) * 180.0 / M_PI);
+    }
+
+    printf("%-28s %2u points %7.1f to %6.1f Hz, worst error %.3f dB %.3f deg\n", name, fra->config.points,
+           fra->points[0].frequency, fra->points[fra->config.points - 1U].frequency, gain_error, phase_error);
+    CHECK(gain_error <= BENCH_GAIN_TOLERANCE_DB);
+    CHECK(phase_error <= BENCH_PHASE_TOLERANCE_DEG);
+}
+
+static double complex plant_model(const void *context, double frequency, double sample_rate)
+{
+    return plant_response(context, frequency, sample_rate);
+}
+
+static double complex loop_model(const void *context, double frequency, double sample_rate)
+{
+    (void)context;
+    return loop_response(frequency, sample_rate);
+}
+
+/* Closed loop: the injection is added to the reference of a loop that behaves as the plant */
+static void check_closed_loop(void)
+{
+    static fra_t fra;
+    fra_config_t config;
+    plant_t plant;
+
+    fra_config_default(&config, FRA_LOOP_CURRENT);
+    plant_init(&plant, config.sample_rate);
+    CHECK(fra_init(&fra, &config, &stream) == FRA_SUCCESS);
+    streamed_length = 0U;
+    streamed[0] = '\0';
+    CHECK(fra_start(&fra) == FRA_SUCCESS);
+    CHECK(fra_start(&fra) == FRA_ERROR_BUSY);
+
+    float injection = 0.0f;
+    for (uint32_t tick = 0U; process(&fra, tick) && tick < BENCH_TICK_LIMIT; tick++) {
+        const float x = injection;
+        const float y = (float)plant_step(&plant, x);
+        injection = fra_step(&fra, x, y);
+    }
+
+    CHECK(fra_get_state(&fra) == FRA_STATE_DONE);
+    check_points(&fra, plant_model, &plant, "closed loop, resonant plant");
+    CHECK(count_lines("fra,current,closed,") == config.points + 1U);
+    CHECK(strstr(streamed, "end,") != NULL);
+}
+
+/*
+ * Open loop: the injection is added to the PI output, x is the inertia's
+ * input and y the PI output, while the loop stays closed around zero speed
+ */
+static void check_open_loop(void)
+{
+    static fra_t fra;
+    fra_config_t config;
+
+    fra_config_default(&config, FRA_LOOP_SPEED);
+    config.mode = FRA_MODE_OPEN_LOOP;
+    CHECK(fra_init(&fra, &config, NULL) == FRA_SUCCESS);
+    CHECK(fra_start(&fra) == FRA_SUCCESS);
+
+    const double dt = 1.0 / config.sample_rate;
+    double speed = 0.0;
+    double torque = 0.0;
+    double integral = 0.0;
+    float injection = 0.0f;
+    for (uint32_t tick = 0U; process(&fra, tick) && tick < BENCH_TICK_LIMIT; tick++) {
+        speed += BENCH_INERTIA_GAIN * dt * torque;
+        const double error = -speed;
+        integral += BENCH_PI_KI * dt * error;
+        const double output = BENCH_PI_KP * error + integral;
+        torque = output + injection;
+        injection = fra_step(&fra, (float)torque, (float)output);
+    }
+
+    CHECK(fra_get_state(&fra) == FRA_STATE_DONE);
+    check_points(&fra, loop_model, NULL, "open loop, PI and inertia");
+}
+
+/* Steps the sweep until it reaches state, without the background */
+static void run_until(fra_t *fra, plant_t *plant, fra_state_t state)
+{
+    float injection = 0.0f;
+    for (uint32_t tick = 0U; fra_get_state(fra) != state && tick < BENCH_TICK_LIMIT; tick++) {
+        injection = fra_step(fra, injection, (float)plant_step(plant, injection));
+    }
+}
+
+/* An abort must win whether the ISR or the background sees it first */
+static void check_abort(void)
+{
+    static fra_t fra;
+    fra_config_t config;
+    plant_t plant;
+
+    fra_config_default(&config, FRA_LOOP_CURRENT);
+    config.points = 2U;
+    plant_init(&plant, config.sample_rate);
+
+    /* Requested while measuring: the ISR stops the sweep */
+    CHECK(fra_init(&fra, &config, &stream) == FRA_SUCCESS);
+    streamed_length = 0U;
+    CHECK(fra_start(&fra) == FRA_SUCCESS);
+    run_until(&fra, &plant, FRA_STATE_MEASURE);
+    fra_abort(&fra);
+    CHECK(fra_step(&fra, 0.0f, 0.0f) == 0.0f);
+    CHECK(fra_get_state(&fra) == FRA_STATE_ABORTED);
+    while (fra_process(&fra)) {
+    }
+    CHECK(fra_get_state(&fra) == FRA_STATE_ABORTED);
+    CHECK(strstr(streamed, "aborted,0") != NULL);
+
+    /* Requested on the last bin, ticks running until the background takes it: no DONE over the abort */
+    config.points = 1U;
+    CHECK(fra_init(&fra, &config, &stream) == FRA_SUCCESS);
+    streamed_length = 0U;
+    CHECK(fra_start(&fra) == FRA_SUCCESS);
+    run_until(&fra, &plant, FRA_STATE_BIN_READY);
+    fra_abort(&fra);
+    CHECK(fra_step(&fra, 0.0f, 0.0f) == 0.0f);
+    CHECK(fra_get_state(&fra) == FRA_STATE_BIN_READY);
+    while (fra_process(&fra)) {
+    }
+    CHECK(fra_get_state(&fra) == FRA_STATE_ABORTED);
+    CHECK(strstr(streamed, "aborted,1") != NULL);
+    CHECK(strstr(streamed, "end,") == NULL);
+
+    /* Requested on a bin with points left: the next point is not armed */
+    config.points = 2U;
+    CHECK(fra_init(&fra, &config, NULL) == FRA_SUCCESS);
+    CHECK(fra_start(&fra) == FRA_SUCCESS);
+    run_until(&fra, &plant, FRA_STATE_BIN_READY);
+    fra_abort(&fra);
+    CHECK(!fra_process(&fra));
+    CHECK(fra_get_state(&fra) == FRA_STATE_ABORTED);
+    CHECK(fra_step(&fra, 0.0f, 0.0f) == 0.0f);
+    CHECK(fra_get_state(&fra) == FRA_STATE_ABORTED);
+
+    printf("abort checked while measuring, on the last bin and on a bin with points left\n");
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Measuring ticks, the phase with the most work */
+static void bench_step(void)
+{
+    static fra_t fra;
+    fra_config_t config;
+    const uint32_t ticks = 10000000U;
+
+    fra_config_default(&config, FRA_LOOP_CURRENT);
+    config.points = 1U;
+    config.settle_cycles = 0U;
+    config.measure_cycles = 60000U;
+    config.f_start = 10.0f;
+    config.f_stop = config.f_start;
+    fra_init(&fra, &config, NULL);
+    fra_start(&fra);
+
+    float x = 0.0f;
+    const double start = now_ns();
+    for (uint32_t tick = 0U; tick < ticks; tick++) {
+        x = fra_step(&fra, x, 0.5f * x);
+    }
+    const double elapsed = now_ns() - start;
+    printf("step: %.1f ns per tick (%s)\n", elapsed / ticks,
+           (fra_get_state(&fra) == FRA_STATE_MEASURE) ? "measuring" : "left the measurement");
+}
+
+int main(void)
+{
+    check_closed_loop();
+    check_open_loop();
+    check_abort();
+    bench_step();
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -12,6 +12,7 @@ Usage:
 """
 
 import os
+import re
 import sys
 import argparse
 from collections import defaultdict
@@ -37,6 +38,16 @@ OUTPUT_FILE_MAPPING = {
         'guard': 'DRIVER_CONFIG_H',
         'comment': 'Driver Configuration'
     },
+    'control_config': {
+        'file': 'src/control/control_config.h',
+        'guard': 'CONTROL_CONFIG_H',
+        'comment': 'Control Configuration'
+    },
+    'service_config': {
+        'file': 'src/services/service_config.h',
+        'guard': 'SERVICE_CONFIG_H',
+        'comment': 'Service Configuration'
+    },
     'app_config': {
         'file': 'src/application/app_config.h',
         'guard': 'APP_CONFIG_H',
@@ -133,6 +144,8 @@ def get_value_for_header(sym):
 LOCATION_MAP = [
     ('src/boards/', 'board_config'),
     ('src/drivers/', 'driver_config'),
+    ('src/control/', 'control_config'),
+    ('src/services/', 'service_config'),
     ('src/application/', 'app_config'),
 ]
 
@@ -191,6 +204,45 @@ def write_macro(f, sym):
     val = f'"{value}"' if sym.type == kconfiglib.STRING else value
     f.write(f"#define {macro_name}  {val}\n\n")
 
+def collect_gpio_pins(kconf):
+    """Pins configured as a BOARD_<NAME>_PORT and BOARD_<NAME>_PIN pair, skipping disabled ones"""
+    pins = []
+    for sym in kconf.unique_defined_syms:
+        match = re.fullmatch(r'BOARD_(\w+)_PORT', sym.name)
+        if not match or sym.type != kconfiglib.INT:
+            continue
+
+        name = match.group(1)
+        pin = kconf.syms.get(f'BOARD_{name}_PIN')
+        if pin is None or not sym.str_value or not pin.str_value:
+            continue
+
+        active_low = kconf.syms.get(f'BOARD_{name}_ACTIVE_LOW')
+        pins.append({
+            'name': name,
+            'port': int(sym.str_value),
+            'pin': int(pin.str_value),
+            'active_low': active_low is not None and active_low.tri_value == 2,
+        })
+    return pins
+
+
+def write_gpio_descriptors(f, kconf):
+    """Write constant port and pin descriptors, so pin accesses fold into a single register access"""
+    pins = collect_gpio_pins(kconf)
+    if not pins:
+        return
+
+    f.write("\n/* GPIO descriptors, for the macros of boards/gpio.h */\n")
+    for gpio in pins:
+        prefix = f"BOARD_GPIO_{gpio['name']}"
+        f.write(f"#define {prefix}_PORT  GPIO{chr(ord('A') + gpio['port'])}\n")
+        f.write(f"#define {prefix}_PORT_INDEX  {gpio['port']}\n")
+        f.write(f"#define {prefix}_PIN  {gpio['pin']}\n")
+        f.write(f"#define {prefix}_MASK  0x{1 << gpio['pin']:04X}U\n")
+        f.write(f"#define {prefix}_ACTIVE_LOW  {1 if gpio['active_low'] else 0}\n\n")
+
+
 def generate_header_file(kconf, symbols, config_type, output_dir):
     """Generate a configuration header file for a group of symbols"""
     if not symbols:
@@ -224,6 +276,7 @@ def generate_header_file(kconf, symbols, config_type, output_dir):
             led_count = sum(1 for i in [1,2,3]
                           if kconf.syms.get(f'BOARD_HAS_LED{i}', kconfiglib.Symbol()).tri_value == 2)
             f.write(f"\n#define BOARD_LED_COUNT {led_count}\n")
+            write_gpio_descriptors(f, kconf)
 
         f.write(f"\n#endif /* {info['guard']} */\n")
 
@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+"""
+Variable registry generator
+
+Reads the registry definition (src/application/registry.json) and generates
+the constant lookup table used by src/services/registry:
+
+  registry_ids.h      REGISTRY_ID_<NAME> for every variable
+  registry_table.c    entry table and a minimal perfect hash of the names
+
+Definition format:
+
+  {
+    "includes": ["app_tuning.h"],
+    "variables": [
+      {"name": "speed.kp", "symbol": "app_speed_loop.pi.kp", "type": "float",
+       "access": "rw", "min": 0.0, "max": 5.0}
+    ]
+  }
+
+IDs follow the order of the list, so append new variables at the end to keep
+existing IDs. "access" is "r" or "rw"; "min" and "max" default to the limits
+of the type. Every symbol is checked at compile time for its type and
+alignment, which keeps each access to a single load or store.
+
+Usage:
+  gen_registry.py <definition.json> <output_dir>
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+
+# name: (registry_type_t enumerator, C type, value member, minimum, maximum)
+TYPES = {
+    'bool': ('REGISTRY_TYPE_BOOL', 'bool', 'u', 0, 1),
+    'uint8': ('REGISTRY_TYPE_U8', 'uint8_t', 'u', 0, 0xFF),
+    'int8': ('REGISTRY_TYPE_I8', 'int8_t', 'i', -0x80, 0x7F),
+    'uint16': ('REGISTRY_TYPE_U16', 'uint16_t', 'u', 0, 0xFFFF),
+    'int16': ('REGISTRY_TYPE_I16', 'int16_t', 'i', -0x8000, 0x7FFF),
+    'uint32': ('REGISTRY_TYPE_U32', 'uint32_t', 'u', 0, 0xFFFFFFFF),
+    'int32': ('REGISTRY_TYPE_I32', 'int32_t', 'i', -0x80000000, 0x7FFFFFFF),
+    'float': ('REGISTRY_TYPE_FLOAT', 'float', 'f', -3.4028234663852886e38, 3.4028234663852886e38),
+}
+
+ACCESS = {
+    'r': 'REGISTRY_ACCESS_READ',
+    'rw': 'REGISTRY_ACCESS_READ | REGISTRY_ACCESS_WRITE',
+}
+
+# Average names per bucket; lower finds seeds faster at the cost of a longer seed table
+BUCKET_LOAD = 4
+MAX_SEED = 0xFFFF
+MASK32 = 0xFFFFFFFF
+NAME_PATTERN = re.compile(r'[A-Za-z0-9_.]{1,64}')
+
+
+def registry_hash(name):
+    """FNV-1a, as registry_hash() in services/registry/registry.h"""
+    value = 2166136261
+    for byte in name.encode('utf-8'):
+        value ^= byte
+        value = (value * 16777619) & MASK32
+    return value
+
+
+def registry_mix(value, seed):
+    """As registry_mix() in services/registry/registry.h"""
+    value ^= (seed * 0x9E3779B9) & MASK32
+    value ^= value >> 16
+    value = (value * 0x85EBCA6B) & MASK32
+    value ^= value >> 13
+    value = (value * 0xC2B2AE35) & MASK32
+    value ^= value >> 16
+    return value
+
+
+def build_perfect_hash(hashes):
+    """Hash and displace: a seed per bucket placing its names in free slots
+
+    Returns (seeds, slots) with slots[slot] = ID.
+    """
+    count = len(hashes)
+    bucket_count = max(1, (count + BUCKET_LOAD - 1) // BUCKET_LOAD)
+
+    buckets = [[] for _ in range(bucket_count)]
+    for ident, value in enumerate(hashes):
+        buckets[value % bucket_count].append(ident)
+
+    seeds = [0] * bucket_count
+    slots = [None] * count
+
+    # Largest buckets first, while most slots are still free
+    for bucket in sorted(range(bucket_count), key=lambda b: len(buckets[b]), reverse=True):
+        members = buckets[bucket]
+        if not members:
+            continue
+        for seed in range(MAX_SEED + 1):
+            placed = [registry_mix(hashes[ident], seed) % count for ident in members]
+            if len(set(placed)) == len(placed) and all(slots[slot] is None for slot in placed):
+                break
+        else:
+            raise ValueError(f"no perfect hash seed found for bucket {bucket}")
+        seeds[bucket] = seed
+        for ident, slot in zip(members, placed):
+            slots[slot] = ident
+
+    return seeds, slots
+
+
+def identifier(name):
+    return 'REGISTRY_ID_' + re.sub(r'[^A-Za-z0-9]', '_', name).upper()
+
+
+def c_value(member, value):
+    if member == 'f':
+        return f"{{.f = {float(value)!r}f}}"
+    if member == 'i':
+        return f"{{.i = {int(value)}}}"
+    return f"{{.u = {int(value)}U}}"
+
+
+def load_definition(path):
+    with open(path) as f:
+        definition = json.load(f)
+
+    includes = definition.get('includes', [])
+    variables = definition.get('variables', [])
+    names = set()
+    identifiers = set()
+    hashes = set()
+
+    for var in variables:
+        name = var.get('name')
+        if not name or 'symbol' not in var:
+            raise ValueError(f"variable needs a name and a symbol: {var}")
+        if not NAME_PATTERN.fullmatch(name):
+            raise ValueError(f"{name}: names use letters, digits, '_' and '.', up to 64 characters")
+        if var.get('type') not in TYPES:
+            raise ValueError(f"{name}: type must be one of {', '.join(TYPES)}")
+        if var.get('access', 'rw') not in ACCESS:
+            raise ValueError(f"{name}: access must be 'r' or 'rw'")
+
+        _, _, member, type_min, type_max = TYPES[var['type']]
+        minimum = var.get('min', type_min)
+        maximum = var.get('max', type_max)
+        if member != 'f' and (minimum != int(minimum) or maximum != int(maximum)):
+            raise ValueError(f"{name}: integer limits expected")
+        if not type_min <= minimum <= maximum <= type_max:
+            raise ValueError(f"{name}: limits must be ordered and within the type")
+        var['min'] = minimum
+        var['max'] = maximum
+
+        if name in names or identifier(name) in identifiers:
+            raise ValueError(f"{name}: duplicate name or ID macro")
+        value = registry_hash(name)
+        if value in hashes:
+            raise ValueError(f"{name}: hash collides with another name; rename one of them")
+        names.add(name)
+        identifiers.add(identifier(name))
+        hashes.add(value)
+
+    if len(variables) > 0xFFFF:
+        raise ValueError("at most 65535 variables")
+
+    return includes, variables
+
+
+def write_ids(path, variables):
+    with open(path, 'w') as f:
+        f.write("/* Auto-generated by gen_registry.py - DO NOT EDIT */\n\n")
+        f.write("#ifndef REGISTRY_IDS_H\n")
+        f.write("#define REGISTRY_IDS_H\n\n")
+        for ident, var in enumerate(variables):
+            f.write(f"#define {identifier(var['name'])} {ident}U\n")
+        f.write(f"\n#define REGISTRY_COUNT {len(variables)}U\n")
+        f.write("\n#endif /* REGISTRY_IDS_H */\n")
+
+
+def write_array(f, name, values, per_line=12):
+    f.write(f"static const uint16_t {name}[] = {{\n")
+    for start in range(0, len(values), per_line):
+        f.write("    " + " ".join(f"{value}U," for value in values[start:start + per_line]) + "\n")
+    f.write("};\n\n")
+
+
+def write_table(path, includes, variables):
+    hashes = [registry_hash(var['name']) for var in variables]
+    seeds, slots = build_perfect_hash(hashes) if variables else ([], [])
+
+    with open(path, 'w') as f:
+        f.write("/* Auto-generated by gen_registry.py - DO NOT EDIT */\n\n")
+        f.write('#include "registry_ids.h"\n')
+        f.write('#include "services/registry/registry.h"\n')
+        for include in includes:
+            f.write(f'#include "{include}"\n')
+        f.write("\n#if SERVICE_REGISTRY_ENABLE\n\n")
+
+        if not variables:
+            f.write("const registry_table_t registry_table = {.entries = NULL, .slots = NULL, .seeds = NULL};\n")
+            f.write("\n#endif\n")
+            return
+
+        for var in variables:
+            _, c_type, _, _, _ = TYPES[var['type']]
+            symbol = var['symbol']
+            f.write(f"_Static_assert(_Generic(({symbol}), {c_type}: 1, default: 0), "
+                    f"\"{var['name']}: {symbol} is not {c_type}\");\n")
+            f.write(f"_Static_assert(__alignof__({symbol}) >= sizeof({c_type}), "
+                    f"\"{var['name']}: {symbol} is not naturally aligned\");\n")
+
+        f.write("\nstatic const registry_entry_t entries[] = {\n")
+        for var, value in zip(variables, hashes):
+            enum, _, member, _, _ = TYPES[var['type']]
+            f.write(f"    [{identifier(var['name'])}] = {{\n")
+            f.write(f"        .name = \"{var['name']}\",\n")
+            f.write(f"        .data = &({var['symbol']}),\n")
+            f.write(f"        .hash = 0x{value:08X}U,\n")
+            f.write(f"        .min = {c_value(member, var['min'])},\n")
+            f.write(f"        .max = {c_value(member, var['max'])},\n")
+            f.write(f"        .type = {enum},\n")
+            f.write(f"        .access = {ACCESS[var.get('access', 'rw')]},\n")
+            f.write("    },\n")
+        f.write("};\n\n")
+
+        write_array(f, 'slots', slots)
+        write_array(f, 'seeds', seeds)
+
+        f.write("const registry_table_t registry_table = {\n")
+        f.write("    .entries = entries,\n")
+        f.write("    .slots = slots,\n")
+        f.write("    .seeds = seeds,\n")
+        f.write(f"    .count = {len(variables)}U,\n")
+        f.write(f"    .bucket_count = {len(seeds)}U,\n")
+        f.write("};\n\n#endif\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument('definition', help='Registry definition (JSON)')
+    parser.add_argument('output_dir', help='Output directory for registry_ids.h and registry_table.c')
+    args = parser.parse_args()
+
+    try:
+        includes, variables = load_definition(args.definition)
+        os.makedirs(args.output_dir, exist_ok=True)
+        write_ids(os.path.join(args.output_dir, 'registry_ids.h'), variables)
+        write_table(os.path.join(args.output_dir, 'registry_table.c'), includes, variables)
+    except (OSError, ValueError) as e:
+        print(f"Error generating registry: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    print(f"Generated registry with {len(variables)} variable(s) in {args.output_dir}")
+
+
+if __name__ == '__main__':
+    main()
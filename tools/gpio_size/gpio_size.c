@@ -0,0 +1,57 @@
+/*
+ * Probes of the compile-time GPIO macros of boards/gpio.h, one macro per
+ * function, for gpio_size.py to disassemble. Each probe must come down to
+ * a single register access without a call; gpio_size_led_on_hal is the
+ * HAL call the macros replace, for comparison. Probes of pins disabled in
+ * Kconfig are left out. Not part of the firmware build.
+ */
+#include "boards/gpio.h"
+#include "boards/board_config.h"
+#include "main.h"
+
+#include <stdbool.h>
+
+#define PROBE __attribute__((noinline, used))
+
+#ifdef BOARD_GPIO_LED1_PORT
+PROBE void gpio_size_led_on(void)
+{
+    BOARD_GPIO_ACTIVATE(LED1);
+}
+
+PROBE void gpio_size_led_off(void)
+{
+    BOARD_GPIO_DEACTIVATE(LED1);
+}
+
+PROBE void gpio_size_led_on_hal(void)
+{
+    HAL_GPIO_WritePin(BOARD_GPIO_LED1_PORT, BOARD_GPIO_LED1_MASK, GPIO_PIN_SET);
+}
+#endif
+
+#if defined(BOARD_GPIO_GATE_EN_U_PORT) && BOARD_GPIO_GATE_EN_MERGED
+PROBE void gpio_size_gates_enable(void)
+{
+    BOARD_GPIO_GATES_ENABLE();
+}
+
+PROBE void gpio_size_gates_disable(void)
+{
+    BOARD_GPIO_GATES_DISABLE();
+}
+#endif
+
+#ifdef BOARD_GPIO_FAULT_PORT
+PROBE bool gpio_size_fault_active(void)
+{
+    return BOARD_GPIO_IS_ACTIVE(FAULT);
+}
+#endif
+
+#ifdef BOARD_GPIO_DEBUG1_PORT
+PROBE void gpio_size_debug_toggle(void)
+{
+    BOARD_GPIO_TOGGLE(DEBUG1);
+}
+#endif
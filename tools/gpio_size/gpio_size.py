@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Code size check of the compile-time GPIO macros
+
+Compiles gpio_size.c for the target with the configuration headers of the
+tree, as the Release build does, disassembles it and checks every probe
+against its budget: the number of stores, no calls, and an upper bound on
+its size in bytes, literal pool included. Probes of pins disabled in
+Kconfig are reported as skipped. Exits non-zero if a probe is over budget,
+unless --report-only is given.
+
+Run it after a CMake configure, which generates the headers.
+
+Usage:
+  gpio_size.py [--cc arm-none-eabi-gcc] [--objdump arm-none-eabi-objdump] [--report-only]
+  gpio_size.py --object gpio_size.o [--objdump llvm-objdump]
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+
+# As TARGET_FLAGS and CMAKE_C_FLAGS_RELEASE of cmake/gcc_arm_none_eabi_toolchain.cmake
+CFLAGS = [
+    '-mcpu=cortex-m4', '-mthumb', '-mfpu=fpv4-sp-d16', '-mfloat-abi=hard', '-Os', '-std=c11',
+    '-ffunction-sections', '-DUSE_HAL_DRIVER', '-DSTM32G431xx',
+]
+
+INCLUDES = [
+    'src/boards/include',
+    'src/boards/nucleo_g431rb/stm32cubemx_generated/Core/Inc',
+    'src/boards/nucleo_g431rb/stm32cubemx_generated/Drivers/STM32G4xx_HAL_Driver/Inc',
+    'src/boards/nucleo_g431rb/stm32cubemx_generated/Drivers/CMSIS/Device/ST/STM32G4xx/Include',
+    'src/boards/nucleo_g431rb/stm32cubemx_generated/Drivers/CMSIS/Include',
+]
+
+# name: (stores, most bytes), None for probes only reported. The byte bounds are
+# estimates from the instruction sequences, not yet taken from a build
+BUDGETS = {
+    'gpio_size_led_on': (1, 20),
+    'gpio_size_led_off': (1, 20),
+    'gpio_size_led_on_hal': None,
+    'gpio_size_gates_enable': (1, 20),
+    'gpio_size_gates_disable': (1, 20),
+    'gpio_size_fault_active': (0, 24),
+    'gpio_size_debug_toggle': (1, 28),
+}
+
+CALL_RELOCATIONS = ('R_ARM_THM_CALL', 'R_ARM_THM_JUMP24', 'R_ARM_CALL', 'R_ARM_JUMP24')
+
+
+def compile_probes(cc, output):
+    """Compile gpio_size.c into output"""
+    command = [cc, *CFLAGS]
+    command += [f'-I{os.path.join(ROOT, include)}' for include in INCLUDES]
+    command += ['-c', os.path.join(os.path.dirname(__file__), 'gpio_size.c'), '-o', output]
+    subprocess.run(command, check=True)
+
+
+def parse_disassembly(text):
+    """Bytes, stores and calls of each function of objdump -dr output"""
+    functions = {}
+    current = None
+    for line in text.splitlines():
+        header = re.match(r'^[0-9a-fA-F]+ <([^>]+)>:$', line.strip())
+        if header:
+            # LLVM puts the literal pool under a $d mapping symbol of its own
+            if not header.group(1).startswith('$'):
+                current = functions.setdefault(header.group(1), {'bytes': 0, 'stores': 0, 'calls': 0})
+            continue
+        if current is None or ':' not in line:
+            continue
+
+        if 'R_ARM_' in line:
+            if any(relocation in line for relocation in CALL_RELOCATIONS):
+                current['calls'] += 1
+            continue
+
+        address, rest = line.split(':', 1)
+        if not re.fullmatch(r'\s*[0-9a-fA-F]+', address):
+            continue
+
+        # Encoding then mnemonic, tab separated by both GNU and LLVM objdump
+        fields = [field.strip() for field in rest.split('\t') if field.strip()]
+        if len(fields) < 2:
+            continue
+        encoding, mnemonic = fields[0], fields[1].lower()
+
+        current['bytes'] += len(encoding.replace(' ', '')) // 2
+        if mnemonic.startswith(('str', 'stm')):
+            current['stores'] += 1
+    return functions
+
+
+def check(functions):
+    """Print every probe against its budget; True if all are within"""
+    passed = True
+    print(f"{'probe':<26} {'bytes':>5} {'stores':>6} {'calls':>5}  result")
+    for name, budget in BUDGETS.items():
+        probe = functions.get(name)
+        if probe is None:
+            print(f"{name:<26} {'-':>5} {'-':>6} {'-':>5}  skipped")
+            continue
+
+        result = 'reported'
+        if budget is not None:
+            stores, most_bytes = budget
+            if probe['calls'] == 0 and probe['stores'] == stores and probe['bytes'] <= most_bytes:
+                result = 'ok'
+            else:
+                result = f'over budget ({stores} stores, no call, {most_bytes} bytes)'
+                passed = False
+        print(f"{name:<26} {probe['bytes']:>5} {probe['stores']:>6} {probe['calls']:>5}  {result}")
+    return passed
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Code size check of the compile-time GPIO macros')
+    parser.add_argument('--cc', default='arm-none-eabi-gcc', help='Target C compiler')
+    parser.add_argument('--objdump', default='arm-none-eabi-objdump', help='Disassembler')
+    parser.add_argument('--object', default=None, help='Check this object instead of compiling gpio_size.c')
+    parser.add_argument('--report-only', action='store_true', help='Print the sizes but do not fail on a budget')
+    args = parser.parse_args()
+
+    try:
+        with tempfile.TemporaryDirectory() as tmp:
+            obj = args.object
+            if obj is None:
+                obj = os.path.join(tmp, 'gpio_size.o')
+                compile_probes(args.cc, obj)
+            command = [args.objdump, '-dr', obj]
+            if 'llvm' in os.path.basename(args.objdump):
+                command.append('--triple=thumbv7em-none-eabi')
+            disassembly = subprocess.run(command, check=True, capture_output=True, text=True).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        sys.exit(2)
+
+    passed = check(parse_disassembly(disassembly))
+    sys.exit(0 if passed or args.report_only else 1)
+
+
+if __name__ == '__main__':
+    main()
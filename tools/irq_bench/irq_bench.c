@@ -0,0 +1,125 @@
+/*
+ * Target benchmark of the HAL tick interrupt with the vector table in
+ * flash and in SRAM (BOARD_IRQ_VECTORS_IN_RAM). Each sample forces a TIM3
+ * update and times, on the cycle counter, from the write that raises it
+ * to the first instruction after the handler has returned. The cost of
+ * the sequence without the interrupt is measured first and subtracted.
+ *
+ * Not part of the firmware build: link it in, call irq_bench_run() once
+ * after board_irq_init() and read irq_bench with the debugger or the
+ * memory sampler.
+ */
+#include "boards/irq.h"
+#include "boards/board_config.h"
+#include "boards/timebase.h"
+#include "main.h"
+#include "stm32g4xx.h"
+#include "stm32g4xx_it.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define IRQ_BENCH_SAMPLES 256U
+#define IRQ_BENCH_FLASH_VECTORS FLASH_BASE
+
+typedef struct {
+    uint32_t min; /* [cycles] */
+    uint32_t median;
+    uint32_t max;
+} irq_bench_figure_t;
+
+typedef struct {
+    irq_bench_figure_t baseline;      /* the sequence alone, interrupt disabled */
+    irq_bench_figure_t hal_flash;     /* TIM3_IRQHandler and HAL_TIM_IRQHandler, table in flash */
+    irq_bench_figure_t hal_ram;       /* the same handlers, table in SRAM */
+    irq_bench_figure_t direct_ram;    /* the direct tick handler, table in SRAM */
+    uint32_t done;
+} irq_bench_t;
+
+irq_bench_t irq_bench;
+
+static uint32_t samples[IRQ_BENCH_SAMPLES];
+
+/* Insertion sort: the bench runs once and the samples are mostly in order */
+static void sort(uint32_t *values, uint32_t count)
+{
+    for (uint32_t i = 1U; i < count; i++) {
+        const uint32_t value = values[i];
+        uint32_t j = i;
+        while (j > 0U && values[j - 1U] > value) {
+            values[j] = values[j - 1U];
+            j--;
+        }
+        values[j] = value;
+    }
+}
+
+static irq_bench_figure_t measure(uint32_t baseline)
+{
+    for (uint32_t i = 0U; i < IRQ_BENCH_SAMPLES; i++) {
+        const uint32_t start = DWT->CYCCNT;
+        TIM3->EGR = TIM_EGR_UG;
+        __DSB();
+        __ISB();
+        const uint32_t end = DWT->CYCCNT;
+
+        const uint32_t cycles = end - start;
+        samples[i] = (cycles > baseline) ? cycles - baseline : 0U;
+    }
+
+    sort(samples, IRQ_BENCH_SAMPLES);
+    const irq_bench_figure_t figure = {
+        .min = samples[0],
+        .median = samples[IRQ_BENCH_SAMPLES / 2U],
+        .max = samples[IRQ_BENCH_SAMPLES - 1U],
+    };
+    return figure;
+}
+
+static void use_vectors(uint32_t vectors)
+{
+    SCB->VTOR = vectors;
+    __DSB();
+    __ISB();
+}
+
+void irq_bench_run(void)
+{
+    memset(&irq_bench, 0, sizeof(irq_bench));
+    board_timebase_init();
+
+    const uint32_t ram_vectors = SCB->VTOR;
+    const board_irq_handler_t direct = board_irq_get_handler(TIM3_IRQn);
+    const uint32_t tick = uwTick;
+    const uint32_t priority = NVIC_GetPriority(TIM3_IRQn);
+
+    /* Only the tick can interrupt the bench, and it comes in at once */
+    NVIC_SetPriority(TIM3_IRQn, 0U);
+    __set_BASEPRI(1U << (8U - __NVIC_PRIO_BITS));
+
+    NVIC_DisableIRQ(TIM3_IRQn);
+    irq_bench.baseline = measure(0U);
+    TIM3->SR = ~TIM_SR_UIF;
+    NVIC_ClearPendingIRQ(TIM3_IRQn);
+    NVIC_EnableIRQ(TIM3_IRQn);
+
+    const uint32_t baseline = irq_bench.baseline.min;
+
+    use_vectors(IRQ_BENCH_FLASH_VECTORS);
+    irq_bench.hal_flash = measure(baseline);
+
+    if (ram_vectors != IRQ_BENCH_FLASH_VECTORS) {
+        use_vectors(ram_vectors);
+        board_irq_set_handler(TIM3_IRQn, TIM3_IRQHandler);
+        irq_bench.hal_ram = measure(baseline);
+
+        board_irq_set_handler(TIM3_IRQn, direct);
+        irq_bench.direct_ram = measure(baseline);
+    }
+    use_vectors(ram_vectors);
+
+    __set_BASEPRI(0U);
+    NVIC_SetPriority(TIM3_IRQn, priority);
+    uwTick = tick;
+    irq_bench.done = 1U;
+}
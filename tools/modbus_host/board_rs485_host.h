@@ -0,0 +1,29 @@
+#ifndef BOARD_RS485_HOST_H
+#define BOARD_RS485_HOST_H
+
+#include <stdbool.h>
+
+#include "boards/rs485.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Create the pseudo terminal that board_rs485_init() attaches to and return
+ * the path of its other end, for the master to open. NULL on failure.
+ */
+const char *board_rs485_host_open_pty(void);
+
+/*
+ * Stand-in for the UART interrupt: wait up to timeout_ms for a frame, which
+ * ends once the line stays quiet for the receiver timeout, and report it
+ * and the completion of the reply. Returns false on a terminal error.
+ */
+bool board_rs485_host_poll(int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
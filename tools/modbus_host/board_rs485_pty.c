@@ -0,0 +1,176 @@
+/*
+ * Host implementation of boards/rs485.h on a Linux pseudo terminal, so the
+ * Modbus slave runs unchanged against a master on the other end of the pty.
+ * The receiver timeout is emulated with the poll timeout: a frame ends when
+ * no byte follows for the configured number of bit times. Line errors
+ * cannot occur on a pty.
+ */
+#define _GNU_SOURCE
+
+#include "board_rs485_host.h"
+#include "boards/timebase.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RS485_HOST_CHUNK 512U
+
+typedef struct {
+    int master;
+    board_rs485_rx_callback_t rx_callback;
+    board_rs485_tx_callback_t tx_callback;
+    void *context;
+    uint8_t *rx_buffer;
+    size_t rx_size;
+    struct timespec gap;
+    bool receiving;
+    bool tx_done;
+} board_rs485_host_t;
+
+static const board_rs485_config_t board_rs485_configs[BOARD_RS485_COUNT] = {
+    [BOARD_RS485_1] = {.instance_index = BOARD_RS485_1},
+};
+
+static board_rs485_host_t host = {.master = -1};
+
+const char *board_rs485_host_open_pty(void)
+{
+    if (host.master >= 0) {
+        close(host.master);
+    }
+
+    host.master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (host.master < 0 || grantpt(host.master) != 0 || unlockpt(host.master) != 0) {
+        return NULL;
+    }
+
+    struct termios attributes;
+    if (tcgetattr(host.master, &attributes) == 0) {
+        cfmakeraw(&attributes);
+        tcsetattr(host.master, TCSANOW, &attributes);
+    }
+
+    return ptsname(host.master);
+}
+
+const board_rs485_config_t *board_rs485_get_config(board_rs485_id_t rs485_id)
+{
+    if (rs485_id < 0 || rs485_id >= BOARD_RS485_COUNT) {
+        return NULL;
+    }
+    return &board_rs485_configs[rs485_id];
+}
+
+int board_rs485_is_supported(board_rs485_id_t rs485_id)
+{
+    return rs485_id >= 0 && rs485_id < BOARD_RS485_COUNT;
+}
+
+bool board_rs485_init(const board_rs485_config_t *config, uint32_t baudrate, board_rs485_parity_t parity,
+                      uint32_t timeout_bits, uint8_t *rx_buffer, size_t rx_size, board_rs485_rx_callback_t rx_callback,
+                      board_rs485_tx_callback_t tx_callback, void *context)
+{
+    (void)parity;
+    if (config == NULL || baudrate == 0U || timeout_bits == 0U || rx_buffer == NULL || rx_size == 0U ||
+        (host.master < 0 && board_rs485_host_open_pty() == NULL)) {
+        return false;
+    }
+
+    uint64_t gap_ns = (uint64_t)timeout_bits * 1000000000ULL / baudrate;
+    host.gap.tv_sec = (time_t)(gap_ns / 1000000000ULL);
+    host.gap.tv_nsec = (long)(gap_ns % 1000000000ULL);
+    host.rx_callback = rx_callback;
+    host.tx_callback = tx_callback;
+    host.context = context;
+    host.rx_buffer = rx_buffer;
+    host.rx_size = rx_size;
+    host.receiving = true;
+    host.tx_done = false;
+    return true;
+}
+
+void board_rs485_receive(const board_rs485_config_t *config)
+{
+    (void)config;
+    host.receiving = true;
+}
+
+bool board_rs485_transmit(const board_rs485_config_t *config, const uint8_t *data, size_t length)
+{
+    if (config == NULL || data == NULL || length == 0U || host.master < 0) {
+        return false;
+    }
+
+    /* A whole reply is far below the pty buffer; wait out EAGAIN like a slow line */
+    while (length > 0U) {
+        ssize_t written = write(host.master, data, length);
+        if (written < 0) {
+            struct pollfd descriptor = {.fd = host.master, .events = POLLOUT};
+            if (poll(&descriptor, 1, 100) <= 0) {
+                return false;
+            }
+            continue;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+
+    /* Reported from the next poll, as the interrupt would after the last stop bit */
+    host.tx_done = true;
+    return true;
+}
+
+bool board_rs485_host_poll(int timeout_ms)
+{
+    if (host.master < 0) {
+        return false;
+    }
+
+    struct pollfd descriptor = {.fd = host.master, .events = POLLIN};
+    if (poll(&descriptor, 1, host.tx_done ? 0 : timeout_ms) < 0) {
+        return false;
+    }
+
+    size_t length = 0U;
+    bool overflow = false;
+    while ((descriptor.revents & POLLIN) != 0) {
+        uint8_t chunk[RS485_HOST_CHUNK];
+        ssize_t count = read(host.master, chunk, sizeof(chunk));
+        if (count <= 0) {
+            break;
+        }
+        /* Bytes while reception is stopped belong to no frame */
+        if (host.receiving) {
+            size_t room = host.rx_size - length;
+            size_t take = ((size_t)count < room) ? (size_t)count : room;
+            memcpy(&host.rx_buffer[length], chunk, take);
+            length += take;
+            overflow = overflow || take < (size_t)count;
+        }
+        descriptor.revents = 0;
+        if (ppoll(&descriptor, 1, &host.gap, NULL) < 0) {
+            return false;
+        }
+    }
+
+    if (length > 0U && host.receiving) {
+        uint32_t timestamp = board_timebase_now();
+        host.receiving = false;
+        if (host.rx_callback != NULL) {
+            host.rx_callback(length, overflow, timestamp, host.context);
+        }
+    }
+
+    if (host.tx_done) {
+        host.tx_done = false;
+        if (host.tx_callback != NULL) {
+            host.tx_callback(host.context);
+        }
+    }
+    return true;
+}
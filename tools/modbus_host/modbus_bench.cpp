@@ -0,0 +1,303 @@
+// Conformance check and latency benchmark of the Modbus RTU slave. The
+// firmware service runs on a device thread behind a pseudo terminal
+// (board_rs485_pty.c); a minimal master on the other end exercises every
+// function code and exception, then times register reads and reports the
+// round trip next to the latency the slave measured itself.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "board_rs485_host.h"
+#include "boards/timebase.h"
+#include "services/modbus/modbus.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint8_t kSlave = 17;
+constexpr int kReplyTimeoutMs = 200;
+constexpr int kBenchRequests = 2000;
+
+std::atomic<bool> running{true};
+int failures = 0;
+
+#define CHECK(condition)                                                                       \
+    do {                                                                                       \
+        if (!(condition)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                        \
+        }                                                                                      \
+    } while (0)
+
+// Application storage the registers map onto
+uint16_t parameters[8] = {10, 11, 12, 13, 14, 15, 16, 17};
+float gain = 0.25f;
+const uint16_t firmware[2] = {0x0102, 0x0304};
+uint16_t telemetry[125];
+
+const modbus_block_t holding[] = {
+    {100, 8, parameters, true},
+    {108, 2, reinterpret_cast<volatile uint16_t *>(&gain), true},
+    {200, 2, const_cast<uint16_t *>(firmware), false},
+};
+const modbus_block_t input[] = {
+    {0, 125, telemetry, false},
+};
+const modbus_map_t register_map = {holding, 3, input, 1};
+
+// Reference implementation, independent of the firmware CRC driver
+uint16_t crc16_modbus(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1U) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001U) : static_cast<uint16_t>(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+class Master {
+public:
+    bool open(const char *path)
+    {
+        fd_ = ::open(path, O_RDWR | O_NOCTTY);
+        if (fd_ < 0) {
+            return false;
+        }
+        termios attributes;
+        if (tcgetattr(fd_, &attributes) == 0) {
+            cfmakeraw(&attributes);
+            tcsetattr(fd_, TCSANOW, &attributes);
+        }
+        return true;
+    }
+
+    ~Master()
+    {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    // Send address + PDU with its CRC (corrupted on request); the reply PDU without address and CRC, empty if none
+    std::vector<uint8_t> transact(uint8_t address, const std::vector<uint8_t> &pdu, bool corrupt = false)
+    {
+        std::vector<uint8_t> frame{address};
+        frame.insert(frame.end(), pdu.begin(), pdu.end());
+        uint16_t crc = crc16_modbus(frame.data(), frame.size());
+        frame.push_back(static_cast<uint8_t>(crc));
+        frame.push_back(static_cast<uint8_t>((crc >> 8) ^ (corrupt ? 0x5AU : 0U)));
+        if (::write(fd_, frame.data(), frame.size()) != static_cast<ssize_t>(frame.size())) {
+            return {};
+        }
+
+        // Read until the bytes form a valid frame, rather than waiting out the frame gap
+        std::vector<uint8_t> reply;
+        pollfd descriptor{fd_, POLLIN, 0};
+        while (!complete(reply) && ::poll(&descriptor, 1, kReplyTimeoutMs) > 0) {
+            uint8_t chunk[512];
+            ssize_t count = ::read(fd_, chunk, sizeof(chunk));
+            if (count <= 0) {
+                break;
+            }
+            reply.insert(reply.end(), chunk, chunk + count);
+        }
+
+        if (!complete(reply) || reply[0] != address) {
+            return {};
+        }
+        return std::vector<uint8_t>(reply.begin() + 1, reply.end() - 2);
+    }
+
+private:
+    static bool complete(const std::vector<uint8_t> &frame)
+    {
+        size_t size = frame.size();
+        return size >= 4U && crc16_modbus(frame.data(), size - 2U) ==
+                                 static_cast<uint16_t>(frame[size - 2U] | (frame[size - 1U] << 8));
+    }
+
+    int fd_ = -1;
+};
+
+std::vector<uint8_t> request(uint8_t function, uint16_t a, uint16_t b)
+{
+    return {function, static_cast<uint8_t>(a >> 8), static_cast<uint8_t>(a), static_cast<uint8_t>(b >> 8),
+            static_cast<uint8_t>(b)};
+}
+
+uint16_t reg(const std::vector<uint8_t> &reply, size_t index)
+{
+    return static_cast<uint16_t>((reply[2U + 2U * index] << 8) | reply[3U + 2U * index]);
+}
+
+bool is_exception(const std::vector<uint8_t> &reply, uint8_t function, uint8_t code)
+{
+    return reply.size() == 2U && reply[0] == (function | 0x80U) && reply[1] == code;
+}
+
+void run_device()
+{
+    while (running.load(std::memory_order_relaxed)) {
+        if (!board_rs485_host_poll(1)) {
+            break;
+        }
+    }
+}
+
+void check_functions(Master &master)
+{
+    // Across the parameter block into the float behind it
+    auto reply = master.transact(kSlave, request(MODBUS_FC_READ_HOLDING_REGISTERS, 100, 10));
+    CHECK(reply.size() == 22U && reply[1] == 20U);
+    if (reply.size() == 22U) {
+        CHECK(reg(reply, 0) == 10U && reg(reply, 7) == 17U);
+        uint32_t bits;
+        std::memcpy(&bits, &gain, sizeof(bits));
+        CHECK(reg(reply, 8) == (bits & 0xFFFFU) && reg(reply, 9) == (bits >> 16));
+    }
+
+    for (size_t i = 0; i < 125U; i++) {
+        telemetry[i] = static_cast<uint16_t>(0xA000U + i);
+    }
+    reply = master.transact(kSlave, request(MODBUS_FC_READ_INPUT_REGISTERS, 0, 125));
+    CHECK(reply.size() == 252U && reg(reply, 0) == 0xA000U && reg(reply, 124) == 0xA07CU);
+
+    auto write = request(MODBUS_FC_WRITE_SINGLE_REGISTER, 101, 0x1234);
+    CHECK(master.transact(kSlave, write) == write);
+    CHECK(parameters[1] == 0x1234U);
+
+    uint32_t bits;
+    float value = 1.5f;
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto multiple = request(MODBUS_FC_WRITE_MULTIPLE_REGISTERS, 108, 2);
+    multiple.insert(multiple.end(), {4, static_cast<uint8_t>(bits >> 8), static_cast<uint8_t>(bits),
+                                     static_cast<uint8_t>(bits >> 24), static_cast<uint8_t>(bits >> 16)});
+    reply = master.transact(kSlave, multiple);
+    CHECK(reply == request(MODBUS_FC_WRITE_MULTIPLE_REGISTERS, 108, 2));
+    CHECK(gain == 1.5f);
+
+    // Exceptions
+    CHECK(is_exception(master.transact(kSlave, request(MODBUS_FC_WRITE_SINGLE_REGISTER, 200, 1)),
+                       MODBUS_FC_WRITE_SINGLE_REGISTER, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS));
+    CHECK(firmware[0] == 0x0102U);
+    CHECK(is_exception(master.transact(kSlave, request(MODBUS_FC_READ_HOLDING_REGISTERS, 109, 2)),
+                       MODBUS_FC_READ_HOLDING_REGISTERS, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS));
+    CHECK(is_exception(master.transact(kSlave, request(MODBUS_FC_READ_HOLDING_REGISTERS, 100, 0)),
+                       MODBUS_FC_READ_HOLDING_REGISTERS, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE));
+    CHECK(is_exception(master.transact(kSlave, request(MODBUS_FC_READ_INPUT_REGISTERS, 0, 126)),
+                       MODBUS_FC_READ_INPUT_REGISTERS, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE));
+    CHECK(is_exception(master.transact(kSlave, {0x2B, 0x0E, 0x01, 0x00}), 0x2B, MODBUS_EXCEPTION_ILLEGAL_FUNCTION));
+    // A range running past the map is not written at all
+    auto partial = request(MODBUS_FC_WRITE_MULTIPLE_REGISTERS, 107, 4);
+    partial.insert(partial.end(), {8, 0, 1, 0, 2, 0, 3, 0, 4});
+    CHECK(is_exception(master.transact(kSlave, partial), MODBUS_FC_WRITE_MULTIPLE_REGISTERS,
+                       MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS));
+    CHECK(parameters[7] == 17U && gain == 1.5f);
+
+    // Other slaves, broadcasts and damaged frames get no reply
+    CHECK(master.transact(kSlave + 1U, request(MODBUS_FC_READ_HOLDING_REGISTERS, 100, 1)).empty());
+    CHECK(master.transact(MODBUS_BROADCAST_ADDRESS, request(MODBUS_FC_WRITE_SINGLE_REGISTER, 100, 7)).empty());
+    CHECK(parameters[0] == 7U);
+    CHECK(master.transact(kSlave, request(MODBUS_FC_WRITE_SINGLE_REGISTER, 100, 9), true).empty());
+    CHECK(parameters[0] == 7U);
+
+    // Diagnostics
+    auto echo = request(MODBUS_FC_DIAGNOSTICS, 0x0000, 0xBEEF);
+    CHECK(master.transact(kSlave, echo) == echo);
+    reply = master.transact(kSlave, request(MODBUS_FC_DIAGNOSTICS, 0x000C, 0));
+    CHECK(reply.size() == 5U && reply[3] == 0U && reply[4] == 1U);
+    reply = master.transact(kSlave, request(MODBUS_FC_DIAGNOSTICS, 0x000F, 0));
+    CHECK(reply.size() == 5U && reply[3] == 0U && reply[4] == 1U);
+    CHECK(master.transact(kSlave, request(MODBUS_FC_DIAGNOSTICS, 0x000A, 0)).size() == 5U);
+    reply = master.transact(kSlave, request(MODBUS_FC_DIAGNOSTICS, 0x000D, 0));
+    CHECK(reply.size() == 5U && reply[3] == 0U && reply[4] == 0U);
+}
+
+double percentile(std::vector<double> &values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(values.size() - 1U));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return values[index];
+}
+
+void bench(Master &master, modbus_t &mb, uint16_t quantity)
+{
+    std::vector<double> rtt_us;
+    int errors = 0;
+    mb.stats.latency_max = 0U;
+
+    for (int i = 0; i < kBenchRequests; i++) {
+        auto start = Clock::now();
+        auto reply = master.transact(kSlave, request(MODBUS_FC_READ_INPUT_REGISTERS, 0, quantity));
+        rtt_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        if (reply.size() != 2U + 2U * quantity) {
+            errors++;
+        }
+    }
+
+    double ticks_per_us = board_timebase_frequency() / 1e6;
+    std::printf("%9u %10.1fus %10.1fus %10.1fus %8d\n", quantity, percentile(rtt_us, 0.50), percentile(rtt_us, 0.99),
+                mb.stats.latency_max / ticks_per_us, errors);
+    CHECK(errors == 0);
+}
+
+} // namespace
+
+int main()
+{
+    const char *path = board_rs485_host_open_pty();
+    if (path == nullptr) {
+        std::perror("pty");
+        return 1;
+    }
+
+    static modbus_t mb;
+    if (modbus_init(&mb, board_rs485_get_config(BOARD_RS485_1), kSlave, &register_map) != MODBUS_SUCCESS) {
+        std::fprintf(stderr, "slave init failed\n");
+        return 1;
+    }
+
+    Master master;
+    if (!master.open(path)) {
+        std::perror(path);
+        return 1;
+    }
+
+    std::thread device(run_device);
+
+    check_functions(master);
+
+    // The round trip includes the pty and the frame gap the stand-in waits out; the slave's own figure does not
+    std::printf("%9s %12s %12s %12s %8s\n", "registers", "rtt p50", "rtt p99", "slave max", "errors");
+    for (uint16_t quantity : {1, 16, 125}) {
+        bench(master, mb, quantity);
+    }
+
+    running.store(false, std::memory_order_relaxed);
+    device.join();
+
+    std::printf("slave: %u bus messages, %u bus errors, %u exceptions\n", mb.stats.bus_messages,
+                mb.stats.bus_errors, mb.stats.exceptions);
+    if (failures != 0) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
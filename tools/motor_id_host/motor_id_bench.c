@@ -0,0 +1,326 @@
+/*
+ * Host check and benchmark for control/motor_id against a simulated motor.
+ * The plant is a PMSM in its rotor frame (Rs, Ld, Lq, flux linkage) driving
+ * an inertia with viscous friction, fed through an inverter with optional
+ * dead time and sampled once per PWM tick. The identification runs from
+ * alignment to the inertia coast, and every recovered parameter must match
+ * the model within its tolerance, with and without dead time. The result
+ * is saved and loaded back through a stand-in parameter store. An abort
+ * in the middle of a measurement must end the run with the voltage off,
+ * and a new run must start from there. Then the cost of a tick is timed.
+ */
+#define _GNU_SOURCE
+
+#include "control/motor_id/motor_id.h"
+#include "drivers/param_store/param_store.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SUBSTEPS 8U
+#define BENCH_DEAD_TIME_CURRENT 0.05 /* [A] below which the dead time loss fades */
+#define BENCH_START_ANGLE 0.3f /* rotor electrical angle before alignment [rad] */
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+typedef struct {
+    motor_params_t motor;
+    double dead_time_voltage; /* [V] lost per phase against the phase current */
+} plant_config_t;
+
+typedef struct {
+    const plant_config_t *config;
+    uint8_t pole_pairs;
+    double i_d; /* rotor frame [A] */
+    double i_q;
+    double omega_mech; /* [rad/s] */
+    double theta_elec; /* [rad] */
+} plant_t;
+
+typedef struct {
+    double i_d;
+    double i_q;
+    double omega_mech;
+    double theta_elec;
+} plant_derivative_t;
+
+static int failures;
+
+/* A single record is enough for motor_id_save() and motor_id_load() */
+static uint16_t stored_key;
+static uint8_t stored[256];
+static size_t stored_size;
+
+param_store_error_t param_store_write(uint16_t key, const void *data, size_t size)
+{
+    if (size > sizeof(stored)) {
+        return PARAM_STORE_ERROR_INVALID_PARAM;
+    }
+    stored_key = key;
+    stored_size = size;
+    memcpy(stored, data, size);
+    return PARAM_STORE_SUCCESS;
+}
+
+param_store_error_t param_store_read(uint16_t key, void *data, size_t size)
+{
+    if (stored_size == 0U || key != stored_key || size != stored_size) {
+        return PARAM_STORE_ERROR_NOT_FOUND;
+    }
+    memcpy(data, stored, size);
+    return PARAM_STORE_SUCCESS;
+}
+
+/*
+ * Dead time as a loss of dead_time_voltage in every phase against its
+ * current, mapped back into the rotor frame. Around zero current the
+ * switching edges are slow and the loss fades out linearly.
+ */
+static void dead_time_loss(const plant_t *plant, double *v_d, double *v_q)
+{
+    const double dead_time_voltage = plant->config->dead_time_voltage;
+    if (dead_time_voltage == 0.0) {
+        return;
+    }
+
+    const double c = cos(plant->theta_elec);
+    const double s = sin(plant->theta_elec);
+    const double i_alpha = c * plant->i_d - s * plant->i_q;
+    const double i_beta = s * plant->i_d + c * plant->i_q;
+    const double i_phase[3] = {i_alpha, -0.5 * i_alpha + 0.866025403784 * i_beta,
+                               -0.5 * i_alpha - 0.866025403784 * i_beta};
+
+    double v_phase[3];
+    for (int k = 0; k < 3; k++) {
+        v_phase[k] = -dead_time_voltage * fmax(-1.0, fmin(1.0, i_phase[k] / BENCH_DEAD_TIME_CURRENT));
+    }
+    const double v_alpha = (2.0 * v_phase[0] - v_phase[1] - v_phase[2]) / 3.0;
+    const double v_beta = (v_phase[1] - v_phase[2]) / 1.73205080757;
+    *v_d += c * v_alpha + s * v_beta;
+    *v_q += -s * v_alpha + c * v_beta;
+}
+
+static plant_derivative_t plant_derivative(const plant_t *plant, double v_d, double v_q)
+{
+    const motor_params_t *m = &plant->config->motor;
+    const double omega_elec = (double)plant->pole_pairs * plant->omega_mech;
+    const double torque =
+        1.5 * plant->pole_pairs * (m->flux * plant->i_q + ((double)m->ld - m->lq) * plant->i_d * plant->i_q);
+
+    plant_derivative_t derivative = {
+        .i_d = (v_d - m->rs * plant->i_d + omega_elec * m->lq * plant->i_q) / m->ld,
+        .i_q = (v_q - m->rs * plant->i_q - omega_elec * (m->ld * plant->i_d + m->flux)) / m->lq,
+        .omega_mech = (torque - m->friction * plant->omega_mech) / m->inertia,
+        .theta_elec = omega_elec,
+    };
+    return derivative;
+}
+
+static plant_t plant_offset(const plant_t *plant, const plant_derivative_t *derivative, double h)
+{
+    plant_t moved = *plant;
+    moved.i_d += h * derivative->i_d;
+    moved.i_q += h * derivative->i_q;
+    moved.omega_mech += h * derivative->omega_mech;
+    moved.theta_elec += h * derivative->theta_elec;
+    return moved;
+}
+
+/* One PWM period with the voltage vector fixed in the frame at angle theta_frame: RK4 substeps */
+static void plant_step(plant_t *plant, double v_d_frame, double v_q_frame, double theta_frame, double dt)
+{
+    const double h = dt / BENCH_SUBSTEPS;
+
+    for (uint32_t substep = 0U; substep < BENCH_SUBSTEPS; substep++) {
+        /* The inverter holds the vector in the stator frame; the rotor turns under it */
+        const double delta = theta_frame - plant->theta_elec;
+        double v_d = cos(delta) * v_d_frame - sin(delta) * v_q_frame;
+        double v_q = sin(delta) * v_d_frame + cos(delta) * v_q_frame;
+        dead_time_loss(plant, &v_d, &v_q);
+
+        const plant_derivative_t k1 = plant_derivative(plant, v_d, v_q);
+        plant_t p2 = plant_offset(plant, &k1, 0.5 * h);
+        const plant_derivative_t k2 = plant_derivative(&p2, v_d, v_q);
+        plant_t p3 = plant_offset(plant, &k2, 0.5 * h);
+        const plant_derivative_t k3 = plant_derivative(&p3, v_d, v_q);
+        plant_t p4 = plant_offset(plant, &k3, h);
+        const plant_derivative_t k4 = plant_derivative(&p4, v_d, v_q);
+
+        plant->i_d += h / 6.0 * (k1.i_d + 2.0 * k2.i_d + 2.0 * k3.i_d + k4.i_d);
+        plant->i_q += h / 6.0 * (k1.i_q + 2.0 * k2.i_q + 2.0 * k3.i_q + k4.i_q);
+        plant->omega_mech += h / 6.0 * (k1.omega_mech + 2.0 * k2.omega_mech + 2.0 * k3.omega_mech + k4.omega_mech);
+        plant->theta_elec += h / 6.0 * (k1.theta_elec + 2.0 * k2.theta_elec + 2.0 * k3.theta_elec + k4.theta_elec);
+    }
+}
+
+/* Rotor frame currents seen in the frame at angle theta_frame */
+static void plant_currents(const plant_t *plant, double theta_frame, motor_id_input_t *in)
+{
+    const double delta = plant->theta_elec - theta_frame;
+    in->i_d = (float)(cos(delta) * plant->i_d - sin(delta) * plant->i_q);
+    in->i_q = (float)(sin(delta) * plant->i_d + cos(delta) * plant->i_q);
+    in->omega_mech = (float)plant->omega_mech;
+}
+
+/*
+ * Runs an identification to its end; the frame angle is the commanded one or the rotor's. The run is aborted
+ * on entering abort_in, unless that is MOTOR_ID_STATE_IDLE.
+ */
+static motor_id_state_t run_identification(motor_id_t *id, const plant_config_t *config, motor_id_state_t abort_in,
+                                           uint32_t *ticks)
+{
+    plant_t plant = {.config = config, .pole_pairs = id->config.pole_pairs, .theta_elec = BENCH_START_ANGLE};
+    motor_id_output_t out = {.theta_elec = 0.0f, .angle_source = MOTOR_ID_ANGLE_COMMANDED};
+
+    CHECK(motor_id_start(id) == MOTOR_ID_SUCCESS);
+    *ticks = 0U;
+    while (motor_id_get_state(id) < MOTOR_ID_STATE_DONE && *ticks <= id->config.timeout_ticks) {
+        double theta = (out.angle_source == MOTOR_ID_ANGLE_MEASURED) ? plant.theta_elec : (double)out.theta_elec;
+        motor_id_input_t in;
+        plant_currents(&plant, theta, &in);
+        if (abort_in != MOTOR_ID_STATE_IDLE && motor_id_get_state(id) == abort_in) {
+            motor_id_abort(id);
+        }
+        motor_id_step(id, &in, &out);
+
+        theta = (out.angle_source == MOTOR_ID_ANGLE_MEASURED) ? plant.theta_elec : (double)out.theta_elec;
+        plant_step(&plant, out.v_d, out.v_q, theta, id->config.dt);
+        (*ticks)++;
+    }
+
+    /* Whatever ended the run, the last output leaves the motor unpowered */
+    CHECK(motor_id_get_state(id) < MOTOR_ID_STATE_DONE || (out.v_d == 0.0f && out.v_q == 0.0f));
+    return motor_id_get_state(id);
+}
+
+static bool within(const char *name, double measured, double expected, double tolerance)
+{
+    const double error = (measured - expected) / expected;
+    printf("  %-9s %12.6g, model %12.6g, error %+6.2f %% (limit %.0f %%)\n", name, measured, expected,
+           100.0 * error, 100.0 * tolerance);
+    return fabs(error) <= tolerance;
+}
+
+static void check_identification(const char *name, const plant_config_t *config, bool mechanical)
+{
+    static motor_id_t id;
+    motor_id_config_t id_config;
+    motor_id_config_default(&id_config);
+    id_config.speed_feedback = mechanical;
+    CHECK(motor_id_init(&id, &id_config) == MOTOR_ID_SUCCESS);
+
+    uint32_t ticks;
+    const motor_id_state_t state = run_identification(&id, config, MOTOR_ID_STATE_IDLE, &ticks);
+    printf("%s: state %d, fault %d after %.2f s\n", name, (int)state, (int)motor_id_get_fault(&id),
+           ticks * (double)id_config.dt);
+    CHECK(state == MOTOR_ID_STATE_DONE);
+
+    motor_id_result_t result;
+    CHECK(motor_id_get_result(&id, &result) == MOTOR_ID_SUCCESS);
+    const motor_params_t *model = &config->motor;
+    CHECK(within("Rs", result.motor.rs, model->rs, 0.01));
+    CHECK(within("Ld", result.motor.ld, model->ld, 0.02));
+    CHECK(within("Lq", result.motor.lq, model->lq, 0.02));
+    /* The open-loop spin leaves the rotor swinging about the current vector; that costs flux and J a percent */
+    CHECK(within("flux", result.motor.flux, model->flux, 0.02));
+    CHECK(result.mechanical_valid == mechanical);
+    if (mechanical) {
+        CHECK(within("J", result.motor.inertia, model->inertia, 0.03));
+        CHECK(within("B", result.motor.friction, model->friction, 0.05));
+    }
+
+    /* Gains follow from the parameters: pole-zero cancellation of the current loop */
+    CHECK(fabsf(result.current_d.kp - result.motor.ld * id_config.current_bandwidth) <= 1e-6f * result.current_d.kp);
+    CHECK(fabsf(result.current_q.ki - result.motor.rs * id_config.current_bandwidth) <= 1e-6f * result.current_q.ki);
+
+    /* Saved and loaded back unchanged */
+    motor_id_result_t loaded;
+    CHECK(motor_id_save(&id) == MOTOR_ID_SUCCESS);
+    CHECK(motor_id_load(&loaded) == MOTOR_ID_SUCCESS);
+    CHECK(memcmp(&loaded, &id.result, sizeof(loaded)) == 0);
+}
+
+/* Aborts while the current pulses run and while the rotor spins up, then runs once more to the end */
+static void check_abort(const plant_config_t *config)
+{
+    static motor_id_t id;
+    motor_id_config_t id_config;
+    motor_id_config_default(&id_config);
+    CHECK(motor_id_init(&id, &id_config) == MOTOR_ID_SUCCESS);
+
+    const motor_id_state_t abort_in[] = {MOTOR_ID_STATE_INDUCTANCE_Q, MOTOR_ID_STATE_INERTIA_ACCEL};
+    motor_id_result_t result;
+    uint32_t ticks;
+    for (size_t i = 0U; i < sizeof(abort_in) / sizeof(abort_in[0]); i++) {
+        const motor_id_state_t state = run_identification(&id, config, abort_in[i], &ticks);
+        printf("abort in state %d: state %d, fault %d after %.2f s\n", (int)abort_in[i], (int)state,
+               (int)motor_id_get_fault(&id), ticks * (double)id_config.dt);
+        CHECK(state == MOTOR_ID_STATE_ABORTED);
+        CHECK(motor_id_get_fault(&id) == MOTOR_ID_FAULT_NONE);
+        CHECK(motor_id_get_result(&id, &result) == MOTOR_ID_ERROR_NOT_COMPLETE);
+    }
+
+    CHECK(run_identification(&id, config, MOTOR_ID_STATE_IDLE, &ticks) == MOTOR_ID_STATE_DONE);
+    CHECK(motor_id_get_result(&id, &result) == MOTOR_ID_SUCCESS);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* The controller alone, on a first-order stand-in for the d axis; cost is flat across states */
+static void bench_step(void)
+{
+    static motor_id_t id;
+    motor_id_config_t config;
+    motor_id_config_default(&config);
+    config.timeout_ticks = UINT32_MAX;
+    motor_id_init(&id, &config);
+    motor_id_start(&id);
+
+    const uint32_t ticks = 1000000U;
+    motor_id_input_t in = {0};
+    motor_id_output_t out = {0};
+    float sink = 0.0f;
+    const double start = now_ns();
+    for (uint32_t tick = 0U; tick < ticks; tick++) {
+        in.i_d += 0.1f * (out.v_d / 0.5f - in.i_d);
+        motor_id_step(&id, &in, &out);
+        sink += out.v_d;
+    }
+    printf("step: %.1f ns per tick (%.0f)\n", (now_ns() - start) / ticks, (double)sink);
+}
+
+int main(void)
+{
+    const plant_config_t motor = {
+        .motor = {.rs = 0.5f, .ld = 400e-6f, .lq = 600e-6f, .flux = 5e-3f, .inertia = 20e-6f, .friction = 10e-6f},
+    };
+    const plant_config_t round_rotor = {
+        .motor = {.rs = 2.0f, .ld = 2e-3f, .lq = 2e-3f, .flux = 10e-3f, .inertia = 100e-6f, .friction = 50e-6f},
+    };
+    plant_config_t dead_time = motor;
+    dead_time.dead_time_voltage = 0.2;
+
+    check_identification("salient PMSM", &motor, true);
+    check_identification("salient PMSM, no speed feedback", &motor, false);
+    check_identification("salient PMSM, 0.2 V dead time", &dead_time, true);
+    check_identification("round rotor PMSM", &round_rotor, true);
+    check_abort(&motor);
+    bench_step();
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
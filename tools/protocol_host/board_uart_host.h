@@ -0,0 +1,28 @@
+#ifndef BOARD_UART_HOST_H
+#define BOARD_UART_HOST_H
+
+#include <stdbool.h>
+
+#include "boards/uart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Create the pseudo terminal that board_uart_init() attaches to and return
+ * the path of its other end, for the host client to open. NULL on failure.
+ */
+const char *board_uart_host_open_pty(void);
+
+/*
+ * Stand-in for the UART interrupt: send what the driver has queued and, for
+ * up to timeout_ms, receive into it. Returns false on a terminal error.
+ */
+bool board_uart_host_poll(int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * Host implementation of boards/uart.h on a Linux pseudo terminal, so the
+ * UART driver and the serial protocol run unchanged against a host client
+ * on the other end of the pty. Every UART maps to the same terminal.
+ */
+#define _GNU_SOURCE
+
+#include "board_uart_host.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define UART_HOST_CHUNK 4096U
+
+typedef struct {
+    int master;
+    board_uart_tx_callback_t tx_callback;
+    board_uart_rx_callback_t rx_callback;
+    void *context;
+    uint8_t tx_pending[UART_HOST_CHUNK];
+    size_t tx_pending_length;
+} board_uart_host_t;
+
+static const board_uart_config_t board_uart_configs[BOARD_UART_COUNT] = {
+    [BOARD_UART_1] = {.instance_index = BOARD_UART_1},
+    [BOARD_UART_2] = {.instance_index = BOARD_UART_2},
+};
+
+static board_uart_host_t host = {.master = -1};
+
+const char *board_uart_host_open_pty(void)
+{
+    if (host.master >= 0) {
+        close(host.master);
+    }
+
+    host.master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (host.master < 0 || grantpt(host.master) != 0 || unlockpt(host.master) != 0) {
+        return NULL;
+    }
+
+    /* Binary transparent: no echo, no line editing, no CR/LF translation */
+    struct termios attributes;
+    if (tcgetattr(host.master, &attributes) == 0) {
+        cfmakeraw(&attributes);
+        tcsetattr(host.master, TCSANOW, &attributes);
+    }
+
+    return ptsname(host.master);
+}
+
+const board_uart_config_t *board_uart_get_config(board_uart_id_t uart_id)
+{
+    if (uart_id < 0 || uart_id >= BOARD_UART_COUNT) {
+        return NULL;
+    }
+    return &board_uart_configs[uart_id];
+}
+
+int board_uart_is_supported(board_uart_id_t uart_id)
+{
+    return uart_id >= 0 && uart_id < BOARD_UART_COUNT;
+}
+
+bool board_uart_init(const board_uart_config_t *config, uint32_t baudrate, board_uart_tx_callback_t tx_callback,
+                     board_uart_rx_callback_t rx_callback, void *context)
+{
+    if (config == NULL || baudrate == 0U || (host.master < 0 && board_uart_host_open_pty() == NULL)) {
+        return false;
+    }
+
+    host.tx_callback = tx_callback;
+    host.rx_callback = rx_callback;
+    host.context = context;
+    host.tx_pending_length = 0U;
+    return true;
+}
+
+void board_uart_start_tx(const board_uart_config_t *config)
+{
+    /* Nothing to kick: board_uart_host_poll() drains the driver */
+    (void)config;
+}
+
+static bool flush_tx(void)
+{
+    while (host.tx_pending_length < UART_HOST_CHUNK && host.tx_callback != NULL) {
+        int next = host.tx_callback(host.context);
+        if (next < 0) {
+            break;
+        }
+        host.tx_pending[host.tx_pending_length++] = (uint8_t)next;
+    }
+
+    if (host.tx_pending_length == 0U) {
+        return true;
+    }
+
+    ssize_t written = write(host.master, host.tx_pending, host.tx_pending_length);
+    if (written < 0) {
+        /* EIO until the client opens its end; keep the data like a stalled transmitter */
+        return true;
+    }
+
+    memmove(host.tx_pending, &host.tx_pending[written], host.tx_pending_length - (size_t)written);
+    host.tx_pending_length -= (size_t)written;
+    return true;
+}
+
+bool board_uart_host_poll(int timeout_ms)
+{
+    if (host.master < 0) {
+        return false;
+    }
+
+    flush_tx();
+
+    struct pollfd descriptor = {.fd = host.master, .events = POLLIN};
+    if (host.tx_pending_length > 0U) {
+        descriptor.events |= POLLOUT;
+    }
+    if (poll(&descriptor, 1, timeout_ms) < 0) {
+        return false;
+    }
+
+    if ((descriptor.revents & POLLIN) != 0) {
+        uint8_t buffer[UART_HOST_CHUNK];
+        ssize_t count = read(host.master, buffer, sizeof(buffer));
+        for (ssize_t i = 0; i < count; i++) {
+            if (host.rx_callback != NULL) {
+                host.rx_callback(buffer[i], host.context);
+            }
+        }
+    }
+
+    flush_tx();
+    return true;
+}
@@ -0,0 +1,257 @@
+#include "cubemot_protocol.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace cubemot {
+
+namespace {
+
+constexpr size_t kHeaderSize = 2;
+constexpr size_t kCrcSize = 2;
+constexpr size_t kReadChunk = 4096;
+
+std::array<uint16_t, 256> make_crc_table()
+{
+    std::array<uint16_t, 256> table{};
+    for (unsigned i = 0; i < 256; i++) {
+        uint16_t reg = static_cast<uint16_t>(i << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            reg = static_cast<uint16_t>((reg & 0x8000) ? (reg << 1) ^ 0x1021 : reg << 1);
+        }
+        table[i] = reg;
+    }
+    return table;
+}
+
+const std::array<uint16_t, 256> crc_table = make_crc_table();
+
+class CobsEncoder {
+public:
+    explicit CobsEncoder(std::vector<uint8_t> &out) : out_(out), code_pos_(out.size()) { out_.push_back(0); }
+
+    void put(const uint8_t *data, size_t length)
+    {
+        for (size_t i = 0; i < length; i++) {
+            if (data[i] != 0) {
+                out_.push_back(data[i]);
+                code_++;
+            }
+            if (data[i] == 0 || code_ == 0xFF) {
+                out_[code_pos_] = code_;
+                code_pos_ = out_.size();
+                out_.push_back(0);
+                code_ = 1;
+            }
+        }
+    }
+
+    void end()
+    {
+        out_[code_pos_] = code_;
+        out_.push_back(0);
+    }
+
+private:
+    std::vector<uint8_t> &out_;
+    size_t code_pos_;
+    uint8_t code_ = 1;
+};
+
+speed_t to_speed(unsigned baudrate)
+{
+    switch (baudrate) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+        case 1000000: return B1000000;
+        case 2000000: return B2000000;
+        default: return B115200;
+    }
+}
+
+} // namespace
+
+uint16_t crc16_ccitt(const uint8_t *data, size_t length, uint16_t crc)
+{
+    for (size_t i = 0; i < length; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ crc_table[((crc >> 8) ^ data[i]) & 0xFF]);
+    }
+    return crc;
+}
+
+void encode_frame(uint8_t id, uint8_t seq, const void *payload, size_t length, std::vector<uint8_t> &out)
+{
+    const uint8_t header[kHeaderSize] = {id, seq};
+    const uint8_t *body = static_cast<const uint8_t *>(payload);
+    uint16_t crc = crc16_ccitt(header, sizeof(header));
+    crc = crc16_ccitt(body, length, crc);
+    const uint8_t trailer[kCrcSize] = {static_cast<uint8_t>(crc), static_cast<uint8_t>(crc >> 8)};
+
+    CobsEncoder encoder(out);
+    encoder.put(header, sizeof(header));
+    encoder.put(body, length);
+    encoder.put(trailer, sizeof(trailer));
+    encoder.end();
+}
+
+bool cobs_decode_in_place(uint8_t *buffer, size_t length, size_t &decoded_length)
+{
+    size_t read = 0;
+    size_t write = 0;
+
+    while (read < length) {
+        uint8_t code = buffer[read++];
+        size_t block = static_cast<size_t>(code) - 1;
+        if (code == 0 || block > length - read) {
+            return false;
+        }
+        std::memmove(&buffer[write], &buffer[read], block);
+        write += block;
+        read += block;
+        if (code != 0xFF && read < length) {
+            buffer[write++] = 0;
+        }
+    }
+
+    decoded_length = write;
+    return true;
+}
+
+ProtocolClient::~ProtocolClient()
+{
+    close();
+}
+
+bool ProtocolClient::open(const std::string &path, unsigned baudrate)
+{
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd_ < 0) {
+        return false;
+    }
+
+    termios attributes{};
+    if (tcgetattr(fd_, &attributes) == 0) {
+        cfmakeraw(&attributes);
+        cfsetispeed(&attributes, to_speed(baudrate));
+        cfsetospeed(&attributes, to_speed(baudrate));
+        tcsetattr(fd_, TCSANOW, &attributes);
+    }
+
+    rx_.clear();
+    rx_scanned_ = 0;
+    return true;
+}
+
+void ProtocolClient::close()
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool ProtocolClient::send(uint8_t id, uint8_t seq, const void *payload, size_t length)
+{
+    if (fd_ < 0 || (payload == nullptr && length > 0)) {
+        return false;
+    }
+
+    tx_.clear();
+    encode_frame(id, seq, payload, length, tx_);
+
+    size_t offset = 0;
+    while (offset < tx_.size()) {
+        ssize_t written = ::write(fd_, tx_.data() + offset, tx_.size() - offset);
+        if (written > 0) {
+            offset += static_cast<size_t>(written);
+            continue;
+        }
+        if (written < 0 && errno != EAGAIN && errno != EINTR) {
+            return false;
+        }
+        pollfd descriptor{fd_, POLLOUT, 0};
+        ::poll(&descriptor, 1, 100);
+    }
+    return true;
+}
+
+int ProtocolClient::poll(int timeout_ms, const Handler &handler)
+{
+    if (fd_ < 0) {
+        return -1;
+    }
+
+    pollfd descriptor{fd_, POLLIN, 0};
+    int ready = ::poll(&descriptor, 1, timeout_ms);
+    if (ready < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+
+    if (ready > 0 && (descriptor.revents & POLLIN) != 0) {
+        size_t old_size = rx_.size();
+        rx_.resize(old_size + kReadChunk);
+        ssize_t count = ::read(fd_, rx_.data() + old_size, kReadChunk);
+        rx_.resize(old_size + static_cast<size_t>(std::max<ssize_t>(count, 0)));
+        if (count < 0 && errno != EAGAIN && errno != EINTR) {
+            return -1;
+        }
+    }
+
+    return process(handler);
+}
+
+// Frames are decoded where they were received, then the buffer is compacted once
+int ProtocolClient::process(const Handler &handler)
+{
+    int frames = 0;
+    size_t start = 0;
+
+    for (;;) {
+        auto begin = rx_.begin() + static_cast<std::ptrdiff_t>(start + rx_scanned_);
+        auto zero = std::find(begin, rx_.end(), uint8_t{0});
+        if (zero == rx_.end()) {
+            rx_scanned_ = rx_.size() - start;
+            break;
+        }
+
+        size_t end = static_cast<size_t>(zero - rx_.begin());
+        size_t decoded = 0;
+        uint8_t *frame = rx_.data() + start;
+        if (end > start) {
+            if (cobs_decode_in_place(frame, end - start, decoded) && decoded >= kHeaderSize + kCrcSize) {
+                size_t body = decoded - kCrcSize;
+                uint16_t crc = static_cast<uint16_t>(frame[body] | (frame[body + 1] << 8));
+                if (crc == crc16_ccitt(frame, body)) {
+                    handler(Frame{frame[0], frame[1], frame + kHeaderSize, body - kHeaderSize});
+                    frames++;
+                } else {
+                    rx_errors_++;
+                }
+            } else {
+                rx_errors_++;
+            }
+        }
+
+        start = end + 1;
+        rx_scanned_ = 0;
+    }
+
+    rx_.erase(rx_.begin(), rx_.begin() + static_cast<std::ptrdiff_t>(start));
+    return frames;
+}
+
+} // namespace cubemot
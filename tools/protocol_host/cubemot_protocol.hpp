@@ -0,0 +1,79 @@
+// Host client for the CubeMot binary serial protocol (src/services/protocol).
+// Same framing as the firmware: id | seq | payload | CRC-16/CCITT-FALSE,
+// COBS encoded and terminated by a zero byte. Message IDs and payload
+// structs come from the firmware's services/protocol/messages.h.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "services/protocol/messages.h"
+
+namespace cubemot {
+
+struct Frame {
+    uint8_t id;
+    uint8_t seq;
+    const uint8_t *payload; // in the client's receive buffer; only valid during the handler
+    size_t length;
+
+    // The payload as a message struct, or nullptr when the length does not match
+    template <typename T> const T *as() const
+    {
+        return length == sizeof(T) ? reinterpret_cast<const T *>(payload) : nullptr;
+    }
+};
+
+uint16_t crc16_ccitt(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF);
+
+// Appends the COBS encoding of a complete frame, delimiter included
+void encode_frame(uint8_t id, uint8_t seq, const void *payload, size_t length, std::vector<uint8_t> &out);
+
+// Decodes in place; the result starts at buffer[0]. false if malformed
+bool cobs_decode_in_place(uint8_t *buffer, size_t length, size_t &decoded_length);
+
+class ProtocolClient {
+public:
+    using Handler = std::function<void(const Frame &)>;
+
+    ProtocolClient() = default;
+    ~ProtocolClient();
+    ProtocolClient(const ProtocolClient &) = delete;
+    ProtocolClient &operator=(const ProtocolClient &) = delete;
+
+    // Serial device or pty, switched to raw mode at the given baud rate
+    bool open(const std::string &path, unsigned baudrate = 115200);
+    void close();
+    bool is_open() const { return fd_ >= 0; }
+
+    // Blocks until the whole frame is written
+    bool send(uint8_t id, uint8_t seq, const void *payload, size_t length);
+
+    template <typename T> bool send(uint8_t id, uint8_t seq, const T &payload)
+    {
+        return send(id, seq, &payload, sizeof(payload));
+    }
+
+    uint8_t next_seq() { return seq_++; }
+
+    // Waits up to timeout_ms for data and hands every complete, valid frame
+    // to the handler. Returns the number of frames, or -1 on an I/O error.
+    int poll(int timeout_ms, const Handler &handler);
+
+    uint32_t rx_errors() const { return rx_errors_; }
+
+private:
+    int fd_ = -1;
+    uint8_t seq_ = 0;
+    uint32_t rx_errors_ = 0;
+    std::vector<uint8_t> rx_;
+    size_t rx_scanned_ = 0;
+    std::vector<uint8_t> tx_;
+
+    int process(const Handler &handler);
+};
+
+} // namespace cubemot
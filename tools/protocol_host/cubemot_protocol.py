@@ -0,0 +1,179 @@
+"""
+Python client for the CubeMot binary serial protocol (src/services/protocol)
+
+Same framing as the firmware and cubemot_protocol.hpp: id | seq | payload |
+CRC-16/CCITT-FALSE (little endian), COBS encoded and terminated by a zero
+byte. Message IDs mirror services/protocol/messages.h.
+"""
+
+import os
+import select
+import struct
+import termios
+import time
+
+MSG_PING = 0x00
+MSG_GET_INFO = 0x01
+MSG_SAMPLER_SUBSCRIBE = 0x06
+MSG_SAMPLER_CONTROL = 0x07
+MSG_SAMPLER_FORMAT = 0x08
+MSG_SAMPLER_DATA = 0xFE
+MSG_ERROR = 0xFF
+
+STATUS_NAMES = {
+    1: 'unknown message',
+    2: 'bad length',
+    3: 'rejected',
+    4: 'not found',
+    5: 'out of range',
+}
+
+BAUD_RATES = {
+    9600: termios.B9600, 19200: termios.B19200, 38400: termios.B38400, 57600: termios.B57600,
+    115200: termios.B115200, 230400: termios.B230400, 460800: termios.B460800, 921600: termios.B921600,
+}
+
+
+def reply_id(request_id):
+    return request_id | 0x80
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_pos = 0
+    code = 1
+    for byte in data:
+        if byte != 0:
+            out.append(byte)
+            code += 1
+        if byte == 0 or code == 0xFF:
+            out[code_pos] = code
+            code_pos = len(out)
+            out.append(0)
+            code = 1
+    out[code_pos] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    """Decoded bytes, or None if malformed"""
+    out = bytearray()
+    index = 0
+    while index < len(data):
+        code = data[index]
+        index += 1
+        if code == 0 or index + code - 1 > len(data):
+            return None
+        out += data[index:index + code - 1]
+        index += code - 1
+        if code != 0xFF and index < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(message_id, seq, payload=b''):
+    body = bytes([message_id, seq]) + bytes(payload)
+    return cobs_encode(body + struct.pack('<H', crc16_ccitt(body))) + b'\x00'
+
+
+class ProtocolError(Exception):
+    pass
+
+
+class Client:
+    """Protocol client on a serial port or pty"""
+
+    def __init__(self, path, baudrate=115200):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+        self.seq = 0
+        self.rx_errors = 0
+        self._buffer = bytearray()
+        try:
+            attributes = termios.tcgetattr(self.fd)
+        except termios.error:
+            return
+        # cfmakeraw
+        attributes[0] &= ~(termios.IGNBRK | termios.BRKINT | termios.PARMRK | termios.ISTRIP | termios.INLCR |
+                           termios.IGNCR | termios.ICRNL | termios.IXON)
+        attributes[1] &= ~termios.OPOST
+        attributes[2] &= ~(termios.CSIZE | termios.PARENB)
+        attributes[2] |= termios.CS8
+        attributes[3] &= ~(termios.ECHO | termios.ECHONL | termios.ICANON | termios.ISIG | termios.IEXTEN)
+        speed = BAUD_RATES.get(baudrate, termios.B115200)
+        attributes[4] = attributes[5] = speed
+        termios.tcsetattr(self.fd, termios.TCSANOW, attributes)
+
+    def close(self):
+        if self.fd >= 0:
+            os.close(self.fd)
+            self.fd = -1
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def next_seq(self):
+        seq = self.seq
+        self.seq = (self.seq + 1) & 0xFF
+        return seq
+
+    def send(self, message_id, seq, payload=b''):
+        data = encode_frame(message_id, seq, payload)
+        while data:
+            try:
+                written = os.write(self.fd, data)
+                data = data[written:]
+            except BlockingIOError:
+                select.select([], [self.fd], [], 0.1)
+
+    def poll(self, timeout):
+        """Frames (id, seq, payload) received within timeout seconds"""
+        readable, _, _ = select.select([self.fd], [], [], timeout)
+        if readable:
+            try:
+                self._buffer += os.read(self.fd, 65536)
+            except BlockingIOError:
+                pass
+
+        frames = []
+        while True:
+            end = self._buffer.find(0)
+            if end < 0:
+                break
+            encoded = bytes(self._buffer[:end])
+            del self._buffer[:end + 1]
+            if not encoded:
+                continue
+            body = cobs_decode(encoded)
+            if body is None or len(body) < 4 or crc16_ccitt(body[:-2]) != struct.unpack('<H', body[-2:])[0]:
+                self.rx_errors += 1
+                continue
+            frames.append((body[0], body[1], body[2:-2]))
+        return frames
+
+    def request(self, message_id, payload=b'', timeout=0.5, on_other=None):
+        """Send a request and return the payload of its reply; frames that are not the reply go to on_other"""
+        seq = self.next_seq()
+        self.send(message_id, seq, payload)
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            for frame_id, frame_seq, frame_payload in self.poll(0.01):
+                if frame_seq == seq and frame_id == reply_id(message_id):
+                    return frame_payload
+                if frame_seq == seq and frame_id == MSG_ERROR and len(frame_payload) == 2:
+                    status = STATUS_NAMES.get(frame_payload[1], str(frame_payload[1]))
+                    raise ProtocolError(f"request 0x{message_id:02X}: {status}")
+                if on_other is not None:
+                    on_other(frame_id, frame_seq, frame_payload)
+        raise ProtocolError(f"request 0x{message_id:02X}: no reply")
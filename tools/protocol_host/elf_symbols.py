@@ -0,0 +1,301 @@
+"""
+Resolve global variables in the firmware ELF to address, size and type
+
+Debug information is read from the DWARF dump of the toolchain's readelf,
+so no extra Python packages are needed. Paths follow C syntax:
+
+  motor_state              a whole variable
+  speed_loop.pi.integral   a struct member
+  phase_current[2]         an array element
+
+A path that names a struct or array expands to all scalars inside it.
+Without DWARF (release builds use -g0) only plain symbol names resolve,
+from the symbol table, and read as unsigned integers unless a type is
+given as "name:float", "name:int16" and so on.
+"""
+
+import re
+import shutil
+import subprocess
+from dataclasses import dataclass
+
+TYPE_NAMES = {
+    'bool': ('bool', 1), 'uint8': ('unsigned', 1), 'int8': ('signed', 1), 'uint16': ('unsigned', 2),
+    'int16': ('signed', 2), 'uint32': ('unsigned', 4), 'int32': ('signed', 4), 'float': ('float', 4),
+}
+
+QUALIFIERS = ('DW_TAG_typedef', 'DW_TAG_volatile_type', 'DW_TAG_const_type', 'DW_TAG_restrict_type',
+              'DW_TAG_atomic_type')
+
+MAX_EXPANDED = 256
+
+DIE_PATTERN = re.compile(r'^\s*<(\d+)><([0-9a-f]+)>: Abbrev Number: (\d+)(?: \((\w+)\))?')
+ATTRIBUTE_PATTERN = re.compile(r'^\s*<[0-9a-f]+>\s+(DW_AT_\w+)\s*:\s*(.*)$')
+FORM_PATTERN = re.compile(r'^\((?:data\d+|[su]data|strp|line_strp|string|strx\d?|ref\d|ref_udata|flag\w*|exprloc|block\d?|'
+                          r'sec_offset|implicit_const|addrx?\d?)\)\s*')
+STRING_PATTERN = re.compile(r'^\((?:indirect string|indexed string|offset)[^)]*\):\s*(.*)$')
+PATH_PATTERN = re.compile(r'\.?([A-Za-z_]\w*)|\[(\d+)\]')
+
+
+@dataclass
+class Variable:
+    name: str
+    address: int
+    size: int
+    kind: str  # 'float', 'signed', 'unsigned' or 'bool'
+
+
+class ResolveError(Exception):
+    pass
+
+
+class Die:
+    __slots__ = ('offset', 'tag', 'attributes', 'children')
+
+    def __init__(self, offset, tag):
+        self.offset = offset
+        self.tag = tag
+        self.attributes = {}
+        self.children = []
+
+    def value(self, attribute):
+        """Raw value with the form annotation of newer readelf versions removed"""
+        value = self.attributes.get(attribute)
+        return FORM_PATTERN.sub('', value, count=1) if value is not None else None
+
+    def text(self, attribute):
+        """String value without the string table annotation"""
+        value = self.value(attribute)
+        if value is None:
+            return None
+        match = STRING_PATTERN.match(value)
+        return (match.group(1) if match else value).strip()
+
+    def number(self, attribute):
+        value = self.value(attribute)
+        if value is None:
+            return None
+        match = re.search(r'DW_OP_plus_uconst: (\d+)', value) or re.match(r'^\s*(0x[0-9a-f]+|-?\d+)', value)
+        return int(match.group(1), 0) if match else None
+
+    def reference(self, attribute):
+        value = self.attributes.get(attribute)
+        match = re.search(r'<0x([0-9a-f]+)>', value) if value else None
+        return int(match.group(1), 16) if match else None
+
+
+def find_readelf():
+    for name in ('arm-none-eabi-readelf', 'readelf'):
+        path = shutil.which(name)
+        if path:
+            return path
+    raise ResolveError("readelf not found; install the toolchain or pass --readelf")
+
+
+class ElfSymbols:
+    def __init__(self, elf_path, readelf=None):
+        self.readelf = readelf or find_readelf()
+        self.elf_path = elf_path
+        self.dies = {}
+        self.globals = {}
+        self.symbols = {}
+        self._load_dwarf()
+        if not self.globals:
+            self._load_symtab()
+
+    def _run(self, *args):
+        result = subprocess.run([self.readelf, *args, self.elf_path], capture_output=True, text=True)
+        if result.returncode != 0:
+            raise ResolveError(result.stderr.strip() or f"{self.readelf} failed")
+        return result.stdout
+
+    def _load_dwarf(self):
+        stack = []
+        for line in self._run('--wide', '--debug-dump=info').splitlines():
+            match = DIE_PATTERN.match(line)
+            if match:
+                depth = int(match.group(1))
+                del stack[depth:]
+                if match.group(3) == '0':
+                    continue
+                die = Die(int(match.group(2), 16), match.group(4))
+                self.dies[die.offset] = die
+                if stack:
+                    stack[-1].children.append(die)
+                stack.append(die)
+                continue
+            match = ATTRIBUTE_PATTERN.match(line)
+            if match and stack:
+                stack[-1].attributes[match.group(1)] = match.group(2)
+
+        for die in self.dies.values():
+            if die.tag != 'DW_TAG_variable':
+                continue
+            location = die.attributes.get('DW_AT_location', '')
+            address = re.search(r'DW_OP_addr: ([0-9a-f]+)', location)
+            if not address:
+                continue
+            declaration = die
+            specification = die.reference('DW_AT_specification') or die.reference('DW_AT_abstract_origin')
+            if specification in self.dies:
+                declaration = self.dies[specification]
+            name = die.text('DW_AT_name') or declaration.text('DW_AT_name')
+            type_offset = die.reference('DW_AT_type') or declaration.reference('DW_AT_type')
+            if name and type_offset is not None:
+                self.globals.setdefault(name, []).append((int(address.group(1), 16), type_offset))
+
+    def _load_symtab(self):
+        for line in self._run('--wide', '--syms').splitlines():
+            fields = line.split()
+            if len(fields) >= 8 and fields[3] == 'OBJECT':
+                self.symbols[fields[7]] = (int(fields[1], 16), int(fields[2], 0))
+
+    def _strip(self, offset):
+        die = self.dies.get(offset)
+        while die is not None and die.tag in QUALIFIERS:
+            die = self.dies.get(die.reference('DW_AT_type'))
+        if die is None:
+            raise ResolveError("incomplete type information")
+        return die
+
+    def _dimensions(self, array):
+        dimensions = []
+        for child in array.children:
+            if child.tag == 'DW_TAG_subrange_type':
+                count = child.number('DW_AT_count')
+                upper = child.number('DW_AT_upper_bound')
+                dimensions.append(count if count is not None else (upper + 1 if upper is not None else 0))
+        return dimensions
+
+    def _size(self, die):
+        if die.tag == 'DW_TAG_array_type':
+            element = self._strip(die.reference('DW_AT_type'))
+            total = self._size(element)
+            for dimension in self._dimensions(die):
+                total *= dimension
+            return total
+        size = die.number('DW_AT_byte_size')
+        if size is None:
+            raise ResolveError(f"no size for {die.tag}")
+        return size
+
+    def _scalar_kind(self, die):
+        if die.tag == 'DW_TAG_base_type':
+            encoding = die.attributes.get('DW_AT_encoding', '')
+            if 'float' in encoding:
+                return 'float'
+            if 'boolean' in encoding:
+                return 'bool'
+            return 'signed' if 'signed' in encoding and 'unsigned' not in encoding else 'unsigned'
+        if die.tag == 'DW_TAG_enumeration_type':
+            return 'signed'
+        if die.tag == 'DW_TAG_pointer_type':
+            return 'unsigned'
+        return None
+
+    def _member(self, struct, name):
+        for child in struct.children:
+            if child.tag == 'DW_TAG_member' and child.text('DW_AT_name') == name:
+                return child.number('DW_AT_data_member_location') or 0, self._strip(child.reference('DW_AT_type'))
+        raise ResolveError(f"{struct.text('DW_AT_name') or 'struct'} has no member {name}")
+
+    def _element(self, array, indices):
+        element = self._strip(array.reference('DW_AT_type'))
+        dimensions = self._dimensions(array)
+        if len(indices) > len(dimensions):
+            raise ResolveError("too many array indices")
+
+        offset = 0
+        for position, index in enumerate(indices):
+            if index >= dimensions[position]:
+                raise ResolveError(f"index {index} out of bounds")
+            stride = self._size(element)
+            for dimension in dimensions[position + 1:]:
+                stride *= dimension
+            offset += index * stride
+
+        if len(indices) < len(dimensions):
+            # A partly indexed array: the rest is a smaller array with the same element type
+            return offset, ('subarray', element, dimensions[len(indices):])
+        return offset, element
+
+    def _expand(self, name, address, die, out):
+        if len(out) > MAX_EXPANDED:
+            raise ResolveError(f"{name} expands to more than {MAX_EXPANDED} scalars")
+        if isinstance(die, tuple):
+            _, element, dimensions = die
+            stride = self._size(element)
+            for dimension in dimensions[1:]:
+                stride *= dimension
+            for index in range(dimensions[0]):
+                inner = element if len(dimensions) == 1 else ('subarray', element, dimensions[1:])
+                self._expand(f"{name}[{index}]", address + index * stride, inner, out)
+            return
+        kind = self._scalar_kind(die)
+        if kind is not None:
+            out.append(Variable(name, address, self._size(die), kind))
+        elif die.tag in ('DW_TAG_structure_type', 'DW_TAG_union_type'):
+            for child in die.children:
+                if child.tag == 'DW_TAG_member' and child.text('DW_AT_name'):
+                    if 'DW_AT_bit_size' in child.attributes:
+                        continue
+                    offset = child.number('DW_AT_data_member_location') or 0
+                    self._expand(f"{name}.{child.text('DW_AT_name')}", address + offset,
+                                 self._strip(child.reference('DW_AT_type')), out)
+        elif die.tag == 'DW_TAG_array_type':
+            self._expand(name, address, ('subarray', self._strip(die.reference('DW_AT_type')), self._dimensions(die)),
+                         out)
+
+    def resolve(self, path):
+        """Scalar variables at the path, expanded when it names a struct or array"""
+        path, _, type_name = path.partition(':')
+        tokens = [(m.group(1), m.group(2)) for m in PATH_PATTERN.finditer(path)]
+        if not tokens or tokens[0][0] is None or ''.join(m.group(0) for m in PATH_PATTERN.finditer(path)) != path:
+            raise ResolveError(f"{path}: not a variable path")
+
+        if not self.globals:
+            return [self._resolve_symbol(path, type_name)]
+
+        candidates = self.globals.get(tokens[0][0])
+        if not candidates:
+            raise ResolveError(f"{tokens[0][0]}: no such global variable")
+        if len({address for address, _ in candidates}) > 1:
+            raise ResolveError(f"{tokens[0][0]}: ambiguous, several static variables have this name")
+        address, type_offset = candidates[0]
+        die = self._strip(type_offset)
+
+        position = 1
+        while position < len(tokens):
+            member, index = tokens[position]
+            if member is not None:
+                if isinstance(die, tuple) or die.tag not in ('DW_TAG_structure_type', 'DW_TAG_union_type'):
+                    raise ResolveError(f"{path}: .{member} on a non-struct")
+                offset, die = self._member(die, member)
+                address += offset
+                position += 1
+                continue
+            indices = []
+            while position < len(tokens) and tokens[position][1] is not None:
+                indices.append(int(tokens[position][1]))
+                position += 1
+            if isinstance(die, tuple) or die.tag != 'DW_TAG_array_type':
+                raise ResolveError(f"{path}: [] on a non-array")
+            offset, die = self._element(die, indices)
+            address += offset
+
+        variables = []
+        self._expand(path, address, die, variables)
+        if not variables:
+            raise ResolveError(f"{path}: nothing to sample")
+        return variables
+
+    def _resolve_symbol(self, path, type_name):
+        if path not in self.symbols:
+            raise ResolveError(f"{path}: not in the symbol table (build with debug information for members)")
+        address, size = self.symbols[path]
+        kind, type_size = TYPE_NAMES.get(type_name, ('unsigned', size))
+        if type_name and type_name not in TYPE_NAMES:
+            raise ResolveError(f"{type_name}: unknown type")
+        if type_size > size:
+            raise ResolveError(f"{path}: {type_name} is larger than the symbol")
+        return Variable(path, address, type_size, kind)
@@ -0,0 +1,198 @@
+// Round-trip benchmark of the serial protocol. The firmware UART driver and
+// protocol service run on a device thread behind a pseudo terminal
+// (board_uart_pty.c); the host client pings it with payloads of increasing
+// size, checks every echo and reports throughput and round-trip times.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "board_uart_host.h"
+#include "cubemot_protocol.hpp"
+#include "services/cobs/cobs.h"
+#include "services/protocol/protocol.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Outstanding request bytes, kept below the device's transmit ring so no echo is dropped
+constexpr size_t kWindowBytes = 384;
+constexpr auto kRunTime = std::chrono::seconds(1);
+constexpr auto kReplyTimeout = std::chrono::seconds(2);
+
+std::atomic<bool> running{true};
+
+void run_device(protocol_t *protocol)
+{
+    while (running.load(std::memory_order_relaxed)) {
+        if (!board_uart_host_poll(1)) {
+            break;
+        }
+        protocol_poll(protocol);
+    }
+}
+
+bool check_info(cubemot::ProtocolClient &client)
+{
+    uint8_t seq = client.next_seq();
+    if (!client.send(PROTOCOL_MSG_GET_INFO, seq, nullptr, 0)) {
+        return false;
+    }
+
+    bool answered = false;
+    auto deadline = Clock::now() + kReplyTimeout;
+    while (!answered && Clock::now() < deadline) {
+        client.poll(10, [&](const cubemot::Frame &frame) {
+            const auto *info = frame.as<protocol_info_t>();
+            if (frame.id == PROTOCOL_REPLY(PROTOCOL_MSG_GET_INFO) && frame.seq == seq && info != nullptr) {
+                std::printf("device: protocol %u, max payload %u, %u message IDs\n", info->version,
+                            info->max_payload, info->max_messages);
+                answered = true;
+            }
+        });
+    }
+    return answered;
+}
+
+struct Result {
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    uint64_t mismatches = 0;
+    double seconds = 0.0;
+    std::vector<double> rtt_us;
+};
+
+Result ping(cubemot::ProtocolClient &client, size_t payload_size)
+{
+    struct Pending {
+        Clock::time_point sent;
+        std::vector<uint8_t> payload;
+    };
+
+    Result result;
+    std::map<uint8_t, Pending> pending;
+    size_t frame_bytes = COBS_MAX_ENCODED_SIZE(payload_size + 4U) + 1U;
+    size_t window = std::max<size_t>(1U, std::min<size_t>(kWindowBytes / frame_bytes, 128U));
+    uint32_t counter = 0;
+
+    auto start = Clock::now();
+    auto stop_sending = start + kRunTime;
+    auto last_reply = start;
+
+    while (true) {
+        auto now = Clock::now();
+        bool sending = now < stop_sending;
+        if (!sending && pending.empty()) {
+            break;
+        }
+        if (now - last_reply > kReplyTimeout) {
+            result.mismatches += pending.size();
+            break;
+        }
+
+        while (sending && pending.size() < window) {
+            std::vector<uint8_t> payload(payload_size);
+            for (size_t i = 0; i < payload_size; i++) {
+                // Mix in zeros so COBS has work to do
+                payload[i] = static_cast<uint8_t>((i % 7U == 0U) ? 0U : counter + i);
+            }
+            counter++;
+            uint8_t seq = client.next_seq();
+            client.send(PROTOCOL_MSG_PING, seq, payload.data(), payload.size());
+            pending[seq] = Pending{Clock::now(), std::move(payload)};
+        }
+
+        client.poll(1, [&](const cubemot::Frame &frame) {
+            auto it = pending.find(frame.seq);
+            if (frame.id != PROTOCOL_REPLY(PROTOCOL_MSG_PING) || it == pending.end()) {
+                result.mismatches++;
+                return;
+            }
+            auto received = Clock::now();
+            const auto &expected = it->second.payload;
+            if (frame.length != expected.size() || std::memcmp(frame.payload, expected.data(), frame.length) != 0) {
+                result.mismatches++;
+            }
+            result.rtt_us.push_back(std::chrono::duration<double, std::micro>(received - it->second.sent).count());
+            result.frames++;
+            result.bytes += frame.length;
+            pending.erase(it);
+            last_reply = received;
+        });
+    }
+
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+double percentile(std::vector<double> &values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(values.size() - 1U));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return values[index];
+}
+
+} // namespace
+
+int main()
+{
+    const char *path = board_uart_host_open_pty();
+    if (path == nullptr) {
+        std::perror("pty");
+        return 1;
+    }
+
+    static uart_t uart;
+    static protocol_t protocol;
+    if (uart_init(&uart, board_uart_get_config(BOARD_UART_1), 115200U) != UART_SUCCESS ||
+        protocol_init(&protocol, &uart) != PROTOCOL_SUCCESS) {
+        std::fprintf(stderr, "device init failed\n");
+        return 1;
+    }
+
+    cubemot::ProtocolClient client;
+    if (!client.open(path)) {
+        std::perror(path);
+        return 1;
+    }
+
+    std::thread device(run_device, &protocol);
+
+    int status = 0;
+    if (!check_info(client)) {
+        std::fprintf(stderr, "no reply to GET_INFO\n");
+        status = 1;
+    }
+
+    const size_t sizes[] = {0U, 16U, 64U, 128U, PROTOCOL_MAX_PAYLOAD};
+    std::printf("%8s %10s %10s %10s %10s %10s\n", "payload", "frames/s", "MB/s", "rtt p50", "rtt p99", "errors");
+    for (size_t size : sizes) {
+        if (status != 0) {
+            break;
+        }
+        Result result = ping(client, size);
+        double p50 = percentile(result.rtt_us, 0.50);
+        double p99 = percentile(result.rtt_us, 0.99);
+        std::printf("%8zu %10.0f %10.2f %8.1fus %8.1fus %10llu\n", size, result.frames / result.seconds,
+                    result.bytes / result.seconds / 1e6, p50, p99,
+                    static_cast<unsigned long long>(result.mismatches));
+        if (result.mismatches != 0U || result.frames == 0U) {
+            status = 1;
+        }
+    }
+
+    running.store(false, std::memory_order_relaxed);
+    device.join();
+
+    std::printf("device: %u frames, %u errors, %u replies dropped; host: %u errors\n", protocol.rx_frames,
+                protocol.rx_errors, protocol.tx_dropped, client.rx_errors());
+    return status;
+}
@@ -0,0 +1,211 @@
+// Command line access to the variable registry (src/services/registry) over
+// the serial protocol:
+//
+//   registry_cli <port> list
+//   registry_cli <port> get <name>
+//   registry_cli <port> set <name> <value>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "cubemot_protocol.hpp"
+#include "services/registry/registry.h"
+
+namespace {
+
+constexpr int kTimeoutMs = 500;
+
+struct Variable {
+    uint16_t id;
+    uint16_t count;
+    uint8_t type;
+    uint8_t access;
+    std::string name;
+};
+
+const char *status_name(uint8_t status)
+{
+    switch (status) {
+        case PROTOCOL_STATUS_UNKNOWN_MESSAGE: return "unknown message";
+        case PROTOCOL_STATUS_BAD_LENGTH: return "bad length";
+        case PROTOCOL_STATUS_REJECTED: return "rejected";
+        case PROTOCOL_STATUS_NOT_FOUND: return "not found";
+        case PROTOCOL_STATUS_OUT_OF_RANGE: return "out of range";
+        default: return "unknown";
+    }
+}
+
+// Sends a request and waits for its reply or error; the payload of the reply is returned
+std::optional<std::vector<uint8_t>> request(cubemot::ProtocolClient &client, uint8_t id, const void *payload,
+                                            size_t length)
+{
+    uint8_t seq = client.next_seq();
+    if (!client.send(id, seq, payload, length)) {
+        return std::nullopt;
+    }
+
+    std::optional<std::vector<uint8_t>> reply;
+    bool done = false;
+    for (int waited = 0; !done && waited < kTimeoutMs; waited += 10) {
+        client.poll(10, [&](const cubemot::Frame &frame) {
+            if (frame.seq != seq) {
+                return;
+            }
+            if (frame.id == PROTOCOL_REPLY(id)) {
+                reply.emplace(frame.payload, frame.payload + frame.length);
+            } else if (const auto *error = frame.as<protocol_error_payload_t>()) {
+                std::fprintf(stderr, "device error: %s\n", status_name(error->status));
+            }
+            done = frame.id == PROTOCOL_REPLY(id) || frame.id == PROTOCOL_MSG_ERROR;
+        });
+    }
+    if (!done) {
+        std::fprintf(stderr, "no reply\n");
+    }
+    return reply;
+}
+
+std::optional<Variable> parse_info(const std::vector<uint8_t> &payload)
+{
+    protocol_registry_info_t info;
+    if (payload.size() < sizeof(info)) {
+        return std::nullopt;
+    }
+    std::memcpy(&info, payload.data(), sizeof(info));
+    return Variable{info.id, info.count, info.type, info.access,
+                    std::string(payload.begin() + sizeof(info), payload.end())};
+}
+
+std::optional<Variable> describe(cubemot::ProtocolClient &client, uint16_t id)
+{
+    const protocol_registry_id_t payload = {id};
+    auto reply = request(client, PROTOCOL_MSG_REGISTRY_DESCRIBE, &payload, sizeof(payload));
+    return reply ? parse_info(*reply) : std::nullopt;
+}
+
+std::optional<Variable> find(cubemot::ProtocolClient &client, const std::string &name)
+{
+    auto reply = request(client, PROTOCOL_MSG_REGISTRY_FIND, name.data(), name.size());
+    return reply ? parse_info(*reply) : std::nullopt;
+}
+
+const char *type_name(uint8_t type)
+{
+    static const char *const names[] = {"bool", "uint8", "int8", "uint16", "int16", "uint32", "int32", "float"};
+    return (type < sizeof(names) / sizeof(names[0])) ? names[type] : "?";
+}
+
+std::string format(uint8_t type, uint32_t bits)
+{
+    registry_value_t value;
+    value.u = bits;
+    char text[32];
+    switch (type) {
+        case REGISTRY_TYPE_FLOAT: std::snprintf(text, sizeof(text), "%.9g", value.f); break;
+        case REGISTRY_TYPE_I8:
+        case REGISTRY_TYPE_I16:
+        case REGISTRY_TYPE_I32: std::snprintf(text, sizeof(text), "%ld", static_cast<long>(value.i)); break;
+        default: std::snprintf(text, sizeof(text), "%lu", static_cast<unsigned long>(value.u)); break;
+    }
+    return text;
+}
+
+std::optional<uint32_t> parse(uint8_t type, const char *text)
+{
+    char *end = nullptr;
+    registry_value_t value;
+    errno = 0;
+    switch (type) {
+        case REGISTRY_TYPE_FLOAT: value.f = std::strtof(text, &end); break;
+        case REGISTRY_TYPE_I8:
+        case REGISTRY_TYPE_I16:
+        case REGISTRY_TYPE_I32: value.i = static_cast<int32_t>(std::strtol(text, &end, 0)); break;
+        default: value.u = static_cast<uint32_t>(std::strtoul(text, &end, 0)); break;
+    }
+    if (end == text || *end != '\0' || errno != 0) {
+        return std::nullopt;
+    }
+    return value.u;
+}
+
+void print_value(const Variable &variable, const std::vector<uint8_t> &payload)
+{
+    protocol_registry_value_t value;
+    if (payload.size() == sizeof(value)) {
+        std::memcpy(&value, payload.data(), sizeof(value));
+        std::printf("%s = %s\n", variable.name.c_str(), format(value.type, value.value).c_str());
+    }
+}
+
+int usage()
+{
+    std::fprintf(stderr, "usage: registry_cli <port> list | get <name> | set <name> <value>\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        return usage();
+    }
+
+    cubemot::ProtocolClient client;
+    if (!client.open(argv[1])) {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    std::string command = argv[2];
+    if (command == "list" && argc == 3) {
+        auto first = describe(client, 0);
+        if (!first) {
+            std::printf("registry is empty\n");
+            return 0;
+        }
+        for (uint16_t id = 0; id < first->count; id++) {
+            auto variable = (id == 0) ? first : describe(client, id);
+            if (!variable) {
+                return 1;
+            }
+            bool writable = (variable->access & REGISTRY_ACCESS_WRITE) != 0;
+            std::printf("%5u  %-6s  %-2s  %s\n", variable->id, type_name(variable->type), writable ? "rw" : "r",
+                        variable->name.c_str());
+        }
+        return 0;
+    }
+
+    if ((command == "get" && argc == 4) || (command == "set" && argc == 5)) {
+        auto variable = find(client, argv[3]);
+        if (!variable || variable->name != argv[3]) {
+            std::fprintf(stderr, "%s: not found\n", argv[3]);
+            return 1;
+        }
+
+        std::optional<std::vector<uint8_t>> reply;
+        if (command == "get") {
+            const protocol_registry_id_t payload = {variable->id};
+            reply = request(client, PROTOCOL_MSG_REGISTRY_READ, &payload, sizeof(payload));
+        } else {
+            auto bits = parse(variable->type, argv[4]);
+            if (!bits) {
+                std::fprintf(stderr, "%s: not a %s value\n", argv[4], type_name(variable->type));
+                return 1;
+            }
+            const protocol_registry_value_t payload = {variable->id, variable->type, *bits};
+            reply = request(client, PROTOCOL_MSG_REGISTRY_WRITE, &payload, sizeof(payload));
+        }
+        if (!reply) {
+            return 1;
+        }
+        print_value(*variable, *reply);
+        return 0;
+    }
+
+    return usage();
+}
@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""
+Stream firmware variables by name through the memory sampler (src/services/sampler)
+
+Names are resolved against the firmware ELF, e.g. the one that
+consolidate_outputs_to_target_dir() copies to target/<board>/<build type>/.
+The device is told the 32-bit words holding the variables, and the samples
+it streams back are decoded into CSV, one row per sample.
+
+Usage:
+  sampler.py --elf CubeMot.elf /dev/ttyACM0 speed_loop.pi.integral motor.omega
+  sampler.py /dev/ttyACM0 @0x20000410:float      (raw address, no ELF needed)
+
+Variables that share a word cost one word. Samples are delta coded and
+bit-packed unless --encoding says otherwise. Options select the tick
+divider, the tick rate used for the time column, and how long to record.
+"""
+
+import argparse
+import signal
+import struct
+import sys
+import time
+
+import cubemot_protocol as protocol
+import sampler_codec as codec
+from elf_symbols import TYPE_NAMES, ElfSymbols, ResolveError, Variable
+
+STATUS = struct.Struct('<IIHBB')
+
+
+def parse_raw(spec):
+    """@ADDRESS:TYPE"""
+    address, _, type_name = spec[1:].partition(':')
+    if type_name not in TYPE_NAMES:
+        raise ResolveError(f"{spec}: give a type, one of {', '.join(TYPE_NAMES)}")
+    kind, size = TYPE_NAMES[type_name]
+    return Variable(spec, int(address, 0), size, kind)
+
+
+def resolve(specs, elf, readelf):
+    symbols = None
+    variables = []
+    for spec in specs:
+        if spec.startswith('@'):
+            variables.append(parse_raw(spec))
+            continue
+        if symbols is None:
+            if elf is None:
+                raise ResolveError(f"{spec}: --elf is needed to resolve names")
+            symbols = ElfSymbols(elf, readelf)
+        variables.extend(symbols.resolve(spec))
+    return variables
+
+
+class Layout:
+    """Maps variables onto the words the device samples"""
+
+    def __init__(self, variables):
+        self.words = []
+        self.fields = []
+        for var in variables:
+            word = var.address & ~3
+            if var.size > 4 or (var.address & 3) + var.size > 4:
+                raise ResolveError(f"{var.name}: {var.size} bytes at 0x{var.address:08X} do not fit one aligned word")
+            if word not in self.words:
+                self.words.append(word)
+            self.fields.append((var, self.words.index(word), (var.address & 3) * 8))
+
+        # Delta lanes follow the variables, so a step in one does not spill into its neighbours
+        self.lanes = []
+        for index in range(len(self.words)):
+            placed = [(shift // 8, var.size) for var, word, shift in self.fields if word == index]
+            self.lanes.append(codec.word_lanes(placed))
+
+    def decode(self, words):
+        values = []
+        for var, index, shift in self.fields:
+            raw = (words[index] >> shift) & ((1 << (8 * var.size)) - 1)
+            if var.kind == 'float':
+                values.append(struct.unpack('<f', struct.pack('<I', raw))[0])
+            elif var.kind == 'signed' and raw & (1 << (8 * var.size - 1)):
+                values.append(raw - (1 << (8 * var.size)))
+            elif var.kind == 'bool':
+                values.append(int(raw != 0))
+            else:
+                values.append(raw)
+        return values
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('port', help='Serial port of the device')
+    parser.add_argument('variables', nargs='+', help='Variable paths, or @ADDRESS:TYPE')
+    parser.add_argument('--elf', help='Firmware ELF with the variables')
+    parser.add_argument('--readelf', help='readelf to use (default: arm-none-eabi-readelf, then readelf)')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--divider', type=int, default=1, help='Sample every Nth control tick')
+    parser.add_argument('--encoding', choices=codec.ENCODINGS, default='packed', help='Sample encoding on the wire')
+    parser.add_argument('--rate', type=float, help='Control tick rate [Hz], adds a time column')
+    parser.add_argument('--count', type=int, help='Stop after this many samples')
+    parser.add_argument('--duration', type=float, help='Stop after this many seconds')
+    parser.add_argument('--output', help='CSV file (default: stdout)')
+    args = parser.parse_args()
+
+    try:
+        layout = Layout(resolve(args.variables, args.elf, args.readelf))
+    except ResolveError as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    columns = ['index'] + (['time'] if args.rate else []) + [var.name for var, _, _ in layout.fields]
+    out.write(','.join(columns) + '\n')
+
+    stop = False
+
+    def interrupt(*_):
+        nonlocal stop
+        stop = True
+
+    signal.signal(signal.SIGINT, interrupt)
+
+    samples = 0
+    missing = 0
+    errors = 0
+    expected = None
+
+    def on_frame(frame_id, _seq, payload):
+        nonlocal samples, missing, expected, errors
+        if frame_id != protocol.MSG_SAMPLER_DATA:
+            return
+        if args.count is not None and samples >= args.count:
+            return
+        try:
+            first, records = codec.decode_data(payload, layout.lanes)
+        except codec.DecodeError:
+            errors += 1
+            return
+        if records and len(records[0]) != len(layout.words):
+            errors += 1
+            return
+        if expected is not None and first != expected:
+            missing += (first - expected) & 0xFFFFFFFF
+        expected = (first + len(records)) & 0xFFFFFFFF
+        if args.count is not None:
+            records = records[:args.count - samples]
+        for record, values in enumerate(records):
+            index = first + record
+            row = [str(index)]
+            if args.rate:
+                row.append(f"{index * args.divider / args.rate:.6f}")
+            row += [f"{value:.9g}" if isinstance(value, float) else str(value) for value in layout.decode(values)]
+            out.write(','.join(row) + '\n')
+        samples += len(records)
+
+    try:
+        with protocol.Client(args.port, args.baud) as client:
+            subscribe = struct.pack('<H', args.divider) + b''.join(struct.pack('<I', w) for w in layout.words)
+            client.request(protocol.MSG_SAMPLER_SUBSCRIBE, subscribe)
+            encoding = codec.ENCODINGS[args.encoding]
+            lanes = bytes(layout.lanes) if encoding != codec.ENCODING_RAW else b''
+            client.request(protocol.MSG_SAMPLER_FORMAT, bytes([encoding]) + lanes)
+            client.request(protocol.MSG_SAMPLER_CONTROL, b'\x01', on_other=on_frame)
+
+            deadline = time.monotonic() + args.duration if args.duration else None
+            while not stop and (args.count is None or samples < args.count) and \
+                    (deadline is None or time.monotonic() < deadline):
+                for frame in client.poll(0.05):
+                    on_frame(*frame)
+
+            status = client.request(protocol.MSG_SAMPLER_CONTROL, b'\x00', on_other=on_frame)
+            _, overruns, _, _, _ = STATUS.unpack(status)
+            # Drain what was sent before the device stopped
+            for frame in client.poll(0.05):
+                on_frame(*frame)
+    except (OSError, protocol.ProtocolError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+    finally:
+        if out is not sys.stdout:
+            out.close()
+
+    print(f"{samples} samples, {missing} missing, {overruns} dropped on the device, {errors} undecodable frames",
+          file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+Compression benchmark of the sampler encodings on recorded traces
+
+Traces are CSV files written by sampler.py. Column types are inferred from
+the values: integer columns take the smallest type that holds their range,
+anything else is a float. The columns are laid out in words like a C struct
+and framed exactly as sampler_process() does, so the sizes include frame
+headers, CRC and COBS overhead. Every frame is decoded again and compared.
+
+Usage:
+  sampler_bench.py run.csv other.csv --rate 20000 --baud 921600
+  sampler_bench.py --synthetic      (simulated 20 kHz FOC traces, no recording needed)
+"""
+
+import argparse
+import csv
+import math
+import random
+import struct
+import sys
+
+import cubemot_protocol as protocol
+import sampler_codec as codec
+
+INTEGER_TYPES = ((1, -0x80, 0x7F), (1, 0, 0xFF), (2, -0x8000, 0x7FFF), (2, 0, 0xFFFF), (4, -0x80000000, 0xFFFFFFFF))
+
+
+class Trace:
+    def __init__(self, name, columns, rows):
+        """columns: (name, size, is_float), rows: values in column order"""
+        self.name = name
+        self.columns = columns
+        self.rows = rows
+
+    @classmethod
+    def load(cls, path):
+        with open(path, newline='') as f:
+            reader = csv.reader(f)
+            header = next(reader)
+            keep = [i for i, name in enumerate(header) if name not in ('index', 'time')]
+            text = [[row[i] for i in keep] for row in reader if row]
+        columns = []
+        values = [[] for _ in keep]
+        for position, index in enumerate(keep):
+            cells = [row[position] for row in text]
+            try:
+                numbers = [int(cell) for cell in cells]
+            except ValueError:
+                columns.append((header[index], 4, True))
+                values[position] = [float(cell) for cell in cells]
+                continue
+            low, high = min(numbers, default=0), max(numbers, default=0)
+            size = next(size for size, minimum, maximum in INTEGER_TYPES if minimum <= low and high <= maximum)
+            columns.append((header[index], size, False))
+            values[position] = numbers
+        return cls(path, columns, [list(row) for row in zip(*values)])
+
+    def layout(self):
+        """Word of each column and byte offset in it, placed with natural alignment; lanes per word"""
+        placement = []
+        offset = 0
+        for _, size, _ in self.columns:
+            offset = (offset + size - 1) // size * size
+            placement.append((offset // 4, offset % 4))
+            offset += size
+        words = (offset + 3) // 4
+        lanes = [codec.word_lanes([(byte, size) for (word, byte), (_, size, _) in zip(placement, self.columns)
+                                   if word == index]) for index in range(words)]
+        return placement, lanes
+
+    def words(self):
+        placement, lanes = self.layout()
+        samples = []
+        for row in self.rows:
+            sample = [0] * len(lanes)
+            for (word, byte), (_, size, is_float), value in zip(placement, self.columns, row):
+                raw = struct.unpack('<I', struct.pack('<f', value))[0] if is_float else value & ((1 << (8 * size)) - 1)
+                sample[word] |= raw << (8 * byte)
+            samples.append(sample)
+        return samples, lanes
+
+
+def synthetic(rate=20000.0, seconds=1.0, seed=1):
+    """
+    Speed-controlled PMSM from standstill: ADC and PWM counts as 16-bit
+    integers and controller state as floats, and the integers on their own
+    """
+    rng = random.Random(seed)
+    columns = [('adc_ia', 2, False), ('adc_ib', 2, False), ('adc_vbus', 2, False), ('angle', 2, False),
+               ('duty_a', 2, False), ('duty_b', 2, False), ('duty_c', 2, False), ('state', 1, False),
+               ('id', 4, True), ('iq', 4, True), ('omega', 4, True), ('iq_ref', 4, True)]
+    rows = []
+    angle = 0.0
+    omega = 0.0
+    for n in range(int(rate * seconds)):
+        t = n / rate
+        omega_ref = 300.0 if t > 0.1 else 0.0
+        iq_ref = max(-5.0, min(5.0, 0.05 * (omega_ref - omega)))
+        iq = iq_ref + rng.gauss(0.0, 0.03)
+        omega += (2.0 * iq - 0.002 * omega) / rate * 50.0
+        angle = (angle + 4.0 * omega / rate) % (2.0 * math.pi)
+        i_a = iq * -math.sin(angle)
+        i_b = iq * -math.sin(angle - 2.0 * math.pi / 3.0)
+        duty = [int(4250 + 3000 * math.sin(angle + k * 2.0 * math.pi / 3.0) * min(1.0, omega / 400.0 + 0.05))
+                for k in (0, -1, 1)]
+        rows.append([int(2048 + 200 * i_a + rng.gauss(0.0, 3.0)), int(2048 + 200 * i_b + rng.gauss(0.0, 3.0)),
+                     int(2950 + rng.gauss(0.0, 2.0) - 10 * abs(iq)), int(angle / (2.0 * math.pi) * 65536) & 0xFFFF,
+                     *duty, 2 if t > 0.1 else 1, rng.gauss(0.0, 0.03), iq, omega, iq_ref])
+    return [Trace(f"synthetic FOC, {rate:g} Hz", columns, rows),
+            Trace(f"synthetic FOC, {rate:g} Hz, integers only", columns[:8], [row[:8] for row in rows])]
+
+
+def wire_bytes(frames):
+    return sum(len(protocol.encode_frame(protocol.MSG_SAMPLER_DATA, 0, frame)) for frame in frames)
+
+
+def bench(trace, max_payload, rate, baud):
+    samples, lanes = trace.words()
+    if not samples:
+        print(f"{trace.name}: no samples")
+        return True
+    print(f"{trace.name}: {len(samples)} samples, {len(trace.columns)} variables in {len(lanes)} words")
+
+    raw = None
+    ok = True
+    for name, encoding in codec.ENCODINGS.items():
+        frames = codec.encode_data(samples, lanes, encoding, max_payload)
+        decoded = []
+        for frame in frames:
+            decoded += codec.decode_data(frame, lanes)[1]
+        if decoded != samples:
+            print(f"  {name}: decoded samples differ")
+            ok = False
+        total = wire_bytes(frames)
+        raw = raw or total
+        per_sample = total / len(samples)
+        line = f"  {name:6} {per_sample:7.2f} bytes/sample  ratio {raw / total:5.2f}  {len(frames)} frames"
+        if rate:
+            need = per_sample * rate * 10  # start and stop bit
+            line += f"  {need / 1000:8.1f} kbit/s at {rate:g} Hz ({need / baud:.0%} of {baud})"
+        print(line)
+
+    # Where the bytes go, without frame overhead: mean varint size and code bits of each word
+    placement, _ = trace.layout()
+    steps = max(1, len(samples) - 1)
+    for word, lane in enumerate(lanes):
+        names = [name for (column_word, _), (name, _, _) in zip(placement, trace.columns) if column_word == word]
+        pairs = list(zip(samples, samples[1:]))
+        size = sum(len(codec.encode_word(sample[word], previous[word], lane)) for previous, sample in pairs) / steps
+        bits = sum(code.bit_length() for previous, sample in pairs
+                   for code in codec.lane_codes(sample[word], previous[word], lane)) / steps
+        print(f"    word {word:2}  {32 >> lane:2}-bit lanes  {size:4.2f} bytes  {bits:5.2f} bits  {', '.join(names)}")
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('traces', nargs='*', help='CSV files written by sampler.py')
+    parser.add_argument('--synthetic', action='store_true', help='Add simulated motor traces')
+    parser.add_argument('--max-payload', type=int, default=240, help='SERVICE_PROTOCOL_MAX_PAYLOAD of the firmware')
+    parser.add_argument('--rate', type=float, default=20000.0, help='Sample rate for the bandwidth column [Hz]')
+    parser.add_argument('--baud', type=int, default=921600)
+    args = parser.parse_args()
+
+    traces = [Trace.load(path) for path in args.traces]
+    if args.synthetic or not traces:
+        traces += synthetic(rate=args.rate)
+
+    ok = all([bench(trace, args.max_payload, args.rate, args.baud) for trace in traces])
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,209 @@
+"""
+Sampler data frames (src/services/sampler) and the delta coding of src/services/delta
+
+Delta coded frames carry the first sample as it is and zigzag codes of the
+lane differences for the others, as varints or bit-packed at a width per
+lane and frame.
+
+decode_data() turns the payload of a SAMPLER_DATA frame back into samples.
+encode_data() builds frames the way sampler_process() does, for the
+compression benchmark.
+"""
+
+import struct
+
+ENCODING_RAW = 0
+ENCODING_DELTA = 1
+ENCODING_PACKED = 2
+ENCODINGS = {'raw': ENCODING_RAW, 'delta': ENCODING_DELTA, 'packed': ENCODING_PACKED}
+
+LANES_32 = 0
+LANES_16 = 1
+LANES_8 = 2
+
+DATA_HEADER = struct.Struct('<IBBB')
+
+
+class DecodeError(Exception):
+    pass
+
+
+def max_word_size(lanes):
+    return (5, 6, 8)[lanes]
+
+
+def word_lanes(fields):
+    """
+    Lanes for a word holding fields of (byte offset, size). Lanes never split
+    a field, and each lane costs at least a byte, so bytes share 16-bit lanes
+    unless all four are subscribed.
+    """
+    if any(size == 4 or offset & (size - 1) for offset, size in fields):
+        return LANES_32
+    if len(fields) == 4:
+        return LANES_8
+    return LANES_16
+
+
+def lane_codes(value, previous, lanes):
+    """Zigzag codes of the lane differences, lowest lane first"""
+    bits = 32 >> lanes
+    mask = (1 << bits) - 1
+    codes = []
+    for shift in range(0, 32, bits):
+        delta = ((value >> shift) - (previous >> shift)) & mask
+        if delta >> (bits - 1):
+            delta -= 1 << bits
+        codes.append(((delta << 1) ^ -(delta < 0)) & mask)
+    return codes
+
+
+def apply_codes(previous, codes, lanes):
+    bits = 32 >> lanes
+    mask = (1 << bits) - 1
+    value = 0
+    for lane, code in enumerate(codes):
+        delta = (code >> 1) ^ -(code & 1)
+        value |= (((previous >> (lane * bits)) + delta) & mask) << (lane * bits)
+    return value
+
+
+def encode_word(value, previous, lanes):
+    out = bytearray()
+    for code in lane_codes(value, previous, lanes):
+        while code >= 0x80:
+            out.append((code & 0x7F) | 0x80)
+            code >>= 7
+        out.append(code)
+    return bytes(out)
+
+
+def decode_word(data, pos, previous, lanes):
+    """Returns the word and the position after it"""
+    codes = []
+    for _ in range(1 << lanes):
+        code = 0
+        for count in range(5):
+            if pos >= len(data):
+                raise DecodeError("truncated varint")
+            byte = data[pos]
+            pos += 1
+            code |= (byte & 0x7F) << (7 * count)
+            if not byte & 0x80:
+                break
+        else:
+            raise DecodeError("varint too long")
+        codes.append(code)
+    return apply_codes(previous, codes, lanes), pos
+
+
+def decode_data(payload, lanes=None):
+    """(first index, list of samples) of a SAMPLER_DATA payload; lanes per word for delta coded frames"""
+    if len(payload) < DATA_HEADER.size:
+        raise DecodeError("short frame")
+    first, words, records, encoding = DATA_HEADER.unpack_from(payload)
+    pos = DATA_HEADER.size
+
+    if encoding == ENCODING_RAW:
+        if len(payload) != pos + 4 * words * records:
+            raise DecodeError("bad length")
+        samples = [list(struct.unpack_from(f'<{words}I', payload, pos + 4 * words * record))
+                   for record in range(records)]
+        return first, samples
+
+    if encoding not in (ENCODING_DELTA, ENCODING_PACKED) or lanes is None or len(lanes) != words:
+        raise DecodeError(f"unexpected encoding {encoding}")
+    if records == 0:
+        return first, []
+
+    widths = []
+    if encoding == ENCODING_PACKED:
+        count = sum(1 << lane for lane in lanes)
+        widths = list(payload[pos:pos + count])
+        pos += count
+        if len(widths) != count or max(widths, default=0) > 32:
+            raise DecodeError("bad lane widths")
+    if len(payload) < pos + 4 * words:
+        raise DecodeError("short frame")
+    samples = [list(struct.unpack_from(f'<{words}I', payload, pos))]
+    pos += 4 * words
+
+    if encoding == ENCODING_DELTA:
+        for _ in range(records - 1):
+            sample = []
+            for word in range(words):
+                value, pos = decode_word(payload, pos, samples[-1][word], lanes[word])
+                sample.append(value)
+            samples.append(sample)
+        if pos != len(payload):
+            raise DecodeError("bad length")
+        return first, samples
+
+    bits = int.from_bytes(payload[pos:], 'little')
+    total = 8 * (len(payload) - pos)
+    used = 0
+    for _ in range(records - 1):
+        sample = []
+        lane = 0
+        for word in range(words):
+            codes = []
+            for _ in range(1 << lanes[word]):
+                codes.append((bits >> used) & ((1 << widths[lane]) - 1))
+                used += widths[lane]
+                lane += 1
+            sample.append(apply_codes(samples[-1][word], codes, lanes[word]))
+        samples.append(sample)
+    if used > total or total - used >= 8:
+        raise DecodeError("bad length")
+    return first, samples
+
+
+def encode_data(samples, lanes, encoding, max_payload, first_index=0):
+    """Payloads of the frames sampler_process() sends for consecutive samples"""
+    words = len(lanes)
+    lane_count = sum(1 << lane for lane in lanes)
+    if DATA_HEADER.size + 4 * words + (lane_count if encoding == ENCODING_PACKED else 0) > max_payload:
+        raise ValueError("a sample does not fit a frame")
+
+    frames = []
+    position = 0
+    while position < len(samples):
+        start = position
+        first = samples[position]
+        body = bytearray(struct.pack(f'<{words}I', *first))
+        position += 1
+
+        if encoding == ENCODING_PACKED:
+            budget = 8 * (max_payload - DATA_HEADER.size - lane_count - 4 * words)
+            widths = [0] * lane_count
+            while position < len(samples) and position - start < 255:
+                codes = [code for word in range(words)
+                         for code in lane_codes(samples[position][word], samples[position - 1][word], lanes[word])]
+                joined = [max(width, code.bit_length()) for width, code in zip(widths, codes)]
+                if sum(joined) * (position - start) > budget:
+                    break
+                widths = joined
+                position += 1
+            bits = 0
+            used = 0
+            for index in range(start + 1, position):
+                codes = [code for word in range(words)
+                         for code in lane_codes(samples[index][word], samples[index - 1][word], lanes[word])]
+                for code, width in zip(codes, widths):
+                    bits |= code << used
+                    used += width
+            body = bytes(widths) + body + bits.to_bytes((used + 7) // 8, 'little')
+        else:
+            while position < len(samples) and position - start < 255:
+                if encoding == ENCODING_RAW:
+                    encoded = struct.pack(f'<{words}I', *samples[position])
+                else:
+                    encoded = b''.join(encode_word(samples[position][word], samples[position - 1][word], lanes[word])
+                                       for word in range(words))
+                if DATA_HEADER.size + len(body) + len(encoded) > max_payload:
+                    break
+                body += encoded
+                position += 1
+
+        frames.append(DATA_HEADER.pack(first_index + start, words, position - start, encoding) + bytes(body))
+    return frames
@@ -0,0 +1,323 @@
+/*
+ * Host check and benchmark for control/pvt. A trajectory sampled every
+ * millisecond is streamed into the buffer as fast as it frees up and played
+ * back at the control rate: the interpolated position, velocity and
+ * acceleration must follow the trajectory in PVT and PT mode, and the lead
+ * must shift the output ahead by its time. In PT mode points that arrive in
+ * the middle of the segment before them must not bring the motor to rest
+ * on every point. A stream that runs dry while moving must brake at the
+ * configured deceleration and stop where that deceleration predicts. Then
+ * the cost of a tick is timed.
+ */
+#define _GNU_SOURCE
+
+#include "control/pvt/pvt.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_RATE_HZ 20000.0f
+#define BENCH_DT (1.0f / BENCH_RATE_HZ)
+#define BENCH_TICKS_PER_POINT 20U
+#define BENCH_POINT_US 1000U
+#define BENCH_TIME_START 0xFFFFF000U /* host timestamps wrap during the first few points */
+#define BENCH_AMPLITUDE 2.0          /* [rad] */
+#define BENCH_FREQUENCY 2.0          /* [Hz] */
+#define BENCH_POINTS 501U            /* one period, from rest to rest */
+#define BENCH_LEAD_US 500U
+#define BENCH_SPEED 10.0f            /* [rad/s] constant speed streams */
+#define BENCH_SAMPLES 1000000U
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+typedef struct {
+    double position;
+    double velocity;
+    double acceleration;
+} errors_t;
+
+static int failures;
+static pvt_stream_t stream;
+
+/* p(t) = A (1 - cos wt): starts and ends a period at rest */
+static double trajectory(double t, int derivative)
+{
+    const double w = 2.0 * M_PI * BENCH_FREQUENCY;
+    switch (derivative) {
+        case 0:
+            return BENCH_AMPLITUDE * (1.0 - cos(w * t));
+        case 1:
+            return BENCH_AMPLITUDE * w * sin(w * t);
+        default:
+            return BENCH_AMPLITUDE * w * w * cos(w * t);
+    }
+}
+
+/* The host ends the move with a velocity of exactly zero, not the rounding residue of sin(2 pi) */
+static pvt_point_t trajectory_point(uint32_t index)
+{
+    const double t = index * BENCH_POINT_US * 1e-6;
+    const float velocity = (index % (BENCH_POINTS - 1U) == 0U) ? 0.0f : (float)trajectory(t, 1);
+    return (pvt_point_t){BENCH_TIME_START + index * BENCH_POINT_US, (float)trajectory(t, 0), velocity};
+}
+
+static pvt_point_t constant_speed_point(uint32_t index)
+{
+    const float t = (float)(index * BENCH_POINT_US) * 1e-6f;
+    return (pvt_point_t){BENCH_TIME_START + index * BENCH_POINT_US, BENCH_SPEED * t, BENCH_SPEED};
+}
+
+static void start_stream(pvt_mode_t mode, uint32_t lead_us, uint32_t start_delay_us, float position)
+{
+    pvt_config_t config;
+    pvt_config_default(&config, BENCH_DT);
+    config.mode = mode;
+    config.lead = (float)lead_us * 1e-6f;
+    config.start_delay_us = start_delay_us;
+    CHECK(pvt_init(&stream, &config, position) == PVT_SUCCESS);
+    CHECK(pvt_start(&stream) == PVT_SUCCESS);
+}
+
+/* Keep the buffer full, as a host streaming ahead does */
+static void feed(uint32_t *next, uint32_t total)
+{
+    while (*next < total && pvt_get_free(&stream) > 0U) {
+        const pvt_point_t point = trajectory_point(*next);
+        CHECK(pvt_push(&stream, &point) == PVT_SUCCESS);
+        (*next)++;
+    }
+}
+
+/* Plays the whole trajectory; errors against it shifted by the lead while running */
+static void play_trajectory(pvt_mode_t mode, uint32_t lead_us, errors_t *errors)
+{
+    const double lead = lead_us * 1e-6;
+    const double duration = (BENCH_POINTS - 1U) * BENCH_POINT_US * 1e-6;
+    uint32_t next = 0U;
+    uint32_t running = 0U;
+    bool started = false;
+    pvt_setpoint_t setpoint = {0};
+
+    *errors = (errors_t){0};
+    start_stream(mode, lead_us, CONTROL_PVT_START_DELAY_US, 0.0f);
+    for (uint32_t tick = 0U; tick < 2U * BENCH_POINTS * BENCH_TICKS_PER_POINT; tick++) {
+        feed(&next, BENCH_POINTS);
+        pvt_evaluate(&stream, &setpoint);
+        const pvt_state_t state = pvt_get_state(&stream);
+        started = started || state != PVT_STATE_FILLING;
+        if (state != PVT_STATE_RUNNING) {
+            if (started) {
+                break;
+            }
+            continue;
+        }
+
+        const double t = running * (double)BENCH_DT + lead;
+        running++;
+        if (t > duration) {
+            continue;
+        }
+        errors->position = fmax(errors->position, fabs(setpoint.position - trajectory(t, 0)));
+        errors->velocity = fmax(errors->velocity, fabs(setpoint.velocity - trajectory(t, 1)));
+        errors->acceleration = fmax(errors->acceleration, fabs(setpoint.acceleration - trajectory(t, 2)));
+    }
+
+    /* From rest to rest: the stream stops exactly on its last point */
+    CHECK(pvt_get_state(&stream) == PVT_STATE_FINISHED);
+    CHECK(stream.underruns == 0U);
+    CHECK(setpoint.position == trajectory_point(BENCH_POINTS - 1U).position && setpoint.velocity == 0.0f);
+    CHECK(running >= (BENCH_POINTS - 1U) * BENCH_TICKS_PER_POINT - 1U &&
+          running <= (BENCH_POINTS - 1U) * BENCH_TICKS_PER_POINT + 1U);
+}
+
+static void check_interpolation(void)
+{
+    const double peak_velocity = trajectory(0.25 / BENCH_FREQUENCY, 1);
+    const double peak_acceleration = trajectory(0.0, 2);
+    errors_t errors;
+
+    /* Exact velocities: float resolution of the 1 ms segments limits the error */
+    play_trajectory(PVT_MODE_PVT, 0U, &errors);
+    CHECK(errors.position < 1e-5);
+    CHECK(errors.velocity < 1e-3 * peak_velocity);
+    CHECK(errors.acceleration < 1e-2 * peak_acceleration);
+    printf("pvt: errors %.2e rad, %.2e rad/s, %.2e rad/s^2 (peaks %.1f rad/s, %.1f rad/s^2)\n", errors.position,
+           errors.velocity, errors.acceleration, peak_velocity, peak_acceleration);
+
+    /* Estimated velocities: the central difference is second-order accurate */
+    play_trajectory(PVT_MODE_PT, 0U, &errors);
+    CHECK(errors.position < 1e-5);
+    CHECK(errors.velocity < 1e-2 * peak_velocity);
+    CHECK(errors.acceleration < 5e-2 * peak_acceleration);
+    printf("pt: errors %.2e rad, %.2e rad/s, %.2e rad/s^2\n", errors.position, errors.velocity,
+           errors.acceleration);
+}
+
+/* Output evaluated the lead ahead: against the shifted trajectory it is as good as without lead */
+static void check_lead(void)
+{
+    const double lag = trajectory(0.25 / BENCH_FREQUENCY, 1) * BENCH_LEAD_US * 1e-6;
+    errors_t errors;
+
+    play_trajectory(PVT_MODE_PVT, BENCH_LEAD_US, &errors);
+    CHECK(errors.position < 1e-4);
+    CHECK(errors.position < 1e-2 * lag);
+    CHECK(errors.velocity < 1e-2 * trajectory(0.25 / BENCH_FREQUENCY, 1));
+    printf("lead: %u us ahead to within %.2e rad, %.2e rad/s; uncompensated the lag is %.2e rad\n", BENCH_LEAD_US,
+           errors.position, errors.velocity, lag);
+}
+
+/*
+ * PT mode with the start delay at one point period: each point arrives
+ * halfway through the segment before it, so every segment is loaded ending
+ * at rest and has to be refitted once the next point shows up.
+ */
+static void check_late_points(void)
+{
+    const uint32_t total = 40U;
+    const uint32_t arrival = BENCH_TICKS_PER_POINT / 2U;
+    uint32_t next = 0U;
+    uint32_t running = 0U;
+    float min_velocity = INFINITY;
+    float max_velocity = 0.0f;
+    float point_error = 0.0f;
+    pvt_setpoint_t setpoint = {0};
+
+    start_stream(PVT_MODE_PT, 0U, BENCH_POINT_US, 0.0f);
+    for (; next < 2U; next++) {
+        const pvt_point_t point = constant_speed_point(next);
+        CHECK(pvt_push(&stream, &point) == PVT_SUCCESS);
+    }
+
+    for (uint32_t tick = 0U; tick < (total + 2U) * BENCH_TICKS_PER_POINT; tick++) {
+        /* Point n + 2 arrives while playback is halfway between points n and n + 1 */
+        if (next < total && running == (next - 2U) * BENCH_TICKS_PER_POINT + arrival) {
+            const pvt_point_t point = constant_speed_point(next);
+            CHECK(pvt_push(&stream, &point) == PVT_SUCCESS);
+            next++;
+        }
+
+        pvt_evaluate(&stream, &setpoint);
+        if (pvt_get_state(&stream) != PVT_STATE_RUNNING) {
+            break;
+        }
+
+        /* Past the first segment, which starts from rest, until the last, which ends at rest */
+        if (running >= BENCH_TICKS_PER_POINT && running < (total - 2U) * BENCH_TICKS_PER_POINT) {
+            min_velocity = fminf(min_velocity, setpoint.velocity);
+            max_velocity = fmaxf(max_velocity, setpoint.velocity);
+            if (running % BENCH_TICKS_PER_POINT == 0U) {
+                const pvt_point_t point = constant_speed_point(running / BENCH_TICKS_PER_POINT);
+                point_error = fmaxf(point_error, fabsf(setpoint.position - point.position));
+                CHECK(fabsf(setpoint.velocity - BENCH_SPEED) < 1e-2f * BENCH_SPEED);
+            }
+        }
+        running++;
+    }
+
+    CHECK(next == total);
+    CHECK(pvt_get_state(&stream) == PVT_STATE_FINISHED && stream.underruns == 0U);
+    CHECK(setpoint.position == constant_speed_point(total - 1U).position);
+    CHECK(point_error < 1e-4f);
+    CHECK(min_velocity > 0.25f * BENCH_SPEED && max_velocity < 1.5f * BENCH_SPEED);
+    printf("late points: passes every point at %.1f rad/s, between them %.1f to %.1f rad/s\n", BENCH_SPEED,
+           min_velocity, max_velocity);
+}
+
+/* A stream that ends while moving brakes at the underrun deceleration and stops where it predicts */
+static void check_underrun(void)
+{
+    const uint32_t total = 10U;
+    uint32_t braking = 0U;
+    pvt_setpoint_t setpoint = {0};
+    pvt_setpoint_t previous = {0};
+
+    start_stream(PVT_MODE_PVT, 0U, CONTROL_PVT_START_DELAY_US, 0.0f);
+    for (uint32_t i = 0U; i < total; i++) {
+        const pvt_point_t point = constant_speed_point(i);
+        CHECK(pvt_push(&stream, &point) == PVT_SUCCESS);
+    }
+
+    const float decel = stream.config.underrun_decel;
+    const pvt_point_t last = constant_speed_point(total - 1U);
+    for (uint32_t tick = 0U; tick < (total + 10U) * BENCH_TICKS_PER_POINT; tick++) {
+        previous = setpoint;
+        pvt_evaluate(&stream, &setpoint);
+        if (pvt_get_state(&stream) != PVT_STATE_UNDERRUN) {
+            continue;
+        }
+
+        if (braking == 0U) {
+            /* Continues from the last point, one tick of braking on */
+            CHECK(fabsf(setpoint.position - last.position) < BENCH_SPEED * BENCH_DT * 1.01f);
+            CHECK(pvt_start(&stream) == PVT_ERROR_INVALID_STATE);
+            CHECK(pvt_push(&stream, &last) == PVT_ERROR_INVALID_STATE);
+        } else if (setpoint.velocity > 0.0f) {
+            CHECK(fabsf(previous.velocity - setpoint.velocity - decel * BENCH_DT) < 1e-4f * decel * BENCH_DT);
+            CHECK(setpoint.acceleration == -decel);
+        }
+        CHECK(setpoint.velocity <= previous.velocity && setpoint.position >= previous.position);
+        if (setpoint.velocity > 0.0f) {
+            braking++;
+        }
+    }
+
+    const float expected_ticks = BENCH_SPEED / (decel * BENCH_DT);
+    const float stop = last.position + BENCH_SPEED * BENCH_SPEED / (2.0f * decel);
+    CHECK(stream.underruns == 1U);
+    CHECK(setpoint.velocity == 0.0f && setpoint.acceleration == 0.0f);
+    CHECK((float)braking >= expected_ticks - 1.0f && (float)braking <= expected_ticks + 1.0f);
+    CHECK(fabsf(setpoint.position - stop) < 1e-5f);
+    CHECK(pvt_start(&stream) == PVT_SUCCESS);
+    printf("underrun: from %.1f rad/s to rest in %u ticks, %.4f rad past the last point\n", BENCH_SPEED, braking,
+           setpoint.position - last.position);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Endless PVT stream topped up every point period; one segment change per BENCH_TICKS_PER_POINT ticks */
+static void bench_tick(void)
+{
+    uint32_t next = 0U;
+    pvt_setpoint_t setpoint;
+    float sink = 0.0f;
+
+    start_stream(PVT_MODE_PVT, BENCH_LEAD_US, CONTROL_PVT_START_DELAY_US, 0.0f);
+    const uint64_t start = now_ns();
+    for (uint32_t i = 0U; i < BENCH_SAMPLES; i++) {
+        if (i % BENCH_TICKS_PER_POINT == 0U) {
+            feed(&next, next + 1U);
+        }
+        pvt_evaluate(&stream, &setpoint);
+        sink += setpoint.position;
+    }
+    const uint64_t elapsed = now_ns() - start;
+
+    CHECK(pvt_get_state(&stream) == PVT_STATE_RUNNING && isfinite(sink));
+    printf("tick: %.1f ns\n", (double)elapsed / BENCH_SAMPLES);
+}
+
+int main(void)
+{
+    check_interpolation();
+    check_lead();
+    check_late_points();
+    check_underrun();
+    bench_tick();
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,217 @@
+/*
+ * Host check and benchmark for tools/gen_registry.py and services/registry.
+ * registry_host.json defines 60 variables of every type, named as the
+ * parameters of ten modules; the table generated from it is linked with the
+ * registry service. Every name must resolve to the ID of its place in the
+ * definition, and near misses of each name must be rejected. Reads and
+ * writes must respect the access and range of the definition. Then the cost
+ * of a lookup is timed.
+ */
+#define _GNU_SOURCE
+
+#include "services/registry/registry.h"
+#include "registry_ids.h"
+#include "registry_bench_vars.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MODULES 10U
+#define BENCH_PARAMS 6U
+#define BENCH_VARIABLES (BENCH_MODULES * BENCH_PARAMS)
+#define BENCH_ROUNDS 100000U
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+float bench_float[30];
+bool bench_bool[10];
+uint32_t bench_uint32[8];
+int16_t bench_int16[8];
+uint16_t bench_uint16[1];
+uint8_t bench_uint8[1];
+int32_t bench_int32[1];
+int8_t bench_int8[1];
+
+/* As in registry_host.json, where the variable of module m and parameter p is ID m * BENCH_PARAMS + p */
+static const char *const modules[BENCH_MODULES] = {
+    "current", "speed", "position", "observer", "pwm", "adc", "fault", "can", "pvt", "diag",
+};
+static const char *const params[BENCH_PARAMS] = {"kp", "ki", "limit", "enable", "count", "offset"};
+
+static int failures;
+static char names[BENCH_VARIABLES][32];
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool find(const char *name, uint16_t *id)
+{
+    return registry_find(name, strlen(name), id) == REGISTRY_SUCCESS;
+}
+
+static void check_table(void)
+{
+    bool used[BENCH_VARIABLES] = {false};
+
+    CHECK(registry_count() == BENCH_VARIABLES && REGISTRY_COUNT == BENCH_VARIABLES);
+    CHECK(registry_table.bucket_count == (BENCH_VARIABLES + 3U) / 4U);
+
+    /* Minimal perfect hash: the slots hold every ID once */
+    for (uint16_t slot = 0U; slot < registry_table.count; slot++) {
+        const uint16_t id = registry_table.slots[slot];
+        CHECK(id < BENCH_VARIABLES && !used[id]);
+        if (id < BENCH_VARIABLES) {
+            used[id] = true;
+        }
+    }
+
+    for (uint16_t id = 0U; id < BENCH_VARIABLES; id++) {
+        snprintf(names[id], sizeof(names[id]), "%s.%s", modules[id / BENCH_PARAMS], params[id % BENCH_PARAMS]);
+        const registry_entry_t *entry = registry_get(id);
+        uint16_t found = 0xFFFFU;
+        CHECK(entry != NULL && strcmp(entry->name, names[id]) == 0);
+        CHECK(entry != NULL && entry->hash == registry_hash(names[id], strlen(names[id])));
+        CHECK(find(names[id], &found) && found == id);
+    }
+    CHECK(registry_get(BENCH_VARIABLES) == NULL);
+
+    /* IDs follow the definition order, and the entries point at their symbols */
+    CHECK(REGISTRY_ID_CURRENT_KP == 0U && REGISTRY_ID_DIAG_OFFSET == BENCH_VARIABLES - 1U);
+    CHECK(registry_get(REGISTRY_ID_SPEED_KI)->data == &bench_float[4]);
+    CHECK(registry_get(REGISTRY_ID_PWM_COUNT)->data == &bench_uint16[0]);
+    CHECK(registry_get(REGISTRY_ID_ADC_OFFSET)->type == REGISTRY_TYPE_I8);
+    printf("table: %u names in %u buckets, every name found under its ID\n", registry_table.count,
+           registry_table.bucket_count);
+}
+
+static void check_unknown(void)
+{
+    uint32_t rejected = 0U;
+    uint32_t tried = 0U;
+    uint16_t id = 0U;
+
+    for (uint16_t i = 0U; i < BENCH_VARIABLES; i++) {
+        char variant[40];
+        const size_t length = strlen(names[i]);
+
+        /* Shorter by one, longer by one, a changed case and a changed separator */
+        tried++;
+        rejected += (registry_find(names[i], length - 1U, &id) == REGISTRY_ERROR_NOT_FOUND) ? 1U : 0U;
+        snprintf(variant, sizeof(variant), "%sx", names[i]);
+        tried++;
+        rejected += !find(variant, &id) ? 1U : 0U;
+        snprintf(variant, sizeof(variant), "%s", names[i]);
+        variant[0] = (char)(variant[0] - 'a' + 'A');
+        tried++;
+        rejected += !find(variant, &id) ? 1U : 0U;
+        *strchr(variant, '.') = '_';
+        variant[0] = names[i][0];
+        tried++;
+        rejected += !find(variant, &id) ? 1U : 0U;
+    }
+
+    CHECK(rejected == tried);
+    CHECK(!find("", &id) && !find("current", &id) && !find("current.kp.kp", &id));
+    CHECK(registry_find(NULL, 0U, &id) == REGISTRY_ERROR_INVALID_PARAM);
+    CHECK(registry_find("current.kp", 10U, NULL) == REGISTRY_ERROR_INVALID_PARAM);
+    printf("unknown: %u near misses rejected\n", rejected + 3U);
+}
+
+static registry_error_t write_float(uint16_t id, float value)
+{
+    return registry_write(id, (registry_value_t){.f = value});
+}
+
+static registry_error_t write_int(uint16_t id, int32_t value)
+{
+    return registry_write(id, (registry_value_t){.i = value});
+}
+
+static registry_error_t write_uint(uint16_t id, uint32_t value)
+{
+    return registry_write(id, (registry_value_t){.u = value});
+}
+
+static void check_access(void)
+{
+    registry_value_t value;
+
+    /* Float with limits from the definition; NaN is out of any range */
+    CHECK(write_float(REGISTRY_ID_SPEED_KP, 2.5f) == REGISTRY_SUCCESS && bench_float[3] == 2.5f);
+    CHECK(write_float(REGISTRY_ID_SPEED_KP, 10.5f) == REGISTRY_ERROR_RANGE);
+    CHECK(write_float(REGISTRY_ID_SPEED_KP, -0.1f) == REGISTRY_ERROR_RANGE);
+    CHECK(write_float(REGISTRY_ID_SPEED_KP, NAN) == REGISTRY_ERROR_RANGE);
+    CHECK(registry_read(REGISTRY_ID_SPEED_KP, &value) == REGISTRY_SUCCESS && value.f == 2.5f);
+    CHECK(write_float(REGISTRY_ID_SPEED_KI, -1e30f) == REGISTRY_SUCCESS);
+
+    /* Booleans take 0 and 1 only */
+    CHECK(write_uint(REGISTRY_ID_FAULT_ENABLE, 1U) == REGISTRY_SUCCESS && bench_bool[6]);
+    CHECK(write_uint(REGISTRY_ID_FAULT_ENABLE, 2U) == REGISTRY_ERROR_RANGE && bench_bool[6]);
+
+    /* Counters are read-only and keep their value */
+    bench_uint32[0] = 1234U;
+    CHECK(write_uint(REGISTRY_ID_CURRENT_COUNT, 0U) == REGISTRY_ERROR_READ_ONLY);
+    CHECK(registry_read(REGISTRY_ID_CURRENT_COUNT, &value) == REGISTRY_SUCCESS && value.u == 1234U);
+    CHECK(write_uint(REGISTRY_ID_PWM_COUNT, 0U) == REGISTRY_ERROR_READ_ONLY);
+    CHECK(write_int(REGISTRY_ID_ADC_COUNT, 0) == REGISTRY_ERROR_READ_ONLY);
+
+    /* Integer limits from the definition, or of the type when none are given */
+    CHECK(write_int(REGISTRY_ID_CURRENT_OFFSET, -1000) == REGISTRY_SUCCESS && bench_int16[0] == -1000);
+    CHECK(write_int(REGISTRY_ID_CURRENT_OFFSET, -1001) == REGISTRY_ERROR_RANGE);
+    CHECK(write_uint(REGISTRY_ID_PWM_OFFSET, 255U) == REGISTRY_SUCCESS && bench_uint8[0] == 255U);
+    CHECK(write_uint(REGISTRY_ID_PWM_OFFSET, 256U) == REGISTRY_ERROR_RANGE && bench_uint8[0] == 255U);
+    CHECK(write_int(REGISTRY_ID_ADC_OFFSET, -128) == REGISTRY_SUCCESS && bench_int8[0] == -128);
+    CHECK(write_int(REGISTRY_ID_ADC_OFFSET, -129) == REGISTRY_ERROR_RANGE);
+    CHECK(registry_read(REGISTRY_ID_ADC_OFFSET, &value) == REGISTRY_SUCCESS && value.i == -128);
+
+    CHECK(registry_read(BENCH_VARIABLES, &value) == REGISTRY_ERROR_NOT_FOUND);
+    CHECK(write_uint(BENCH_VARIABLES, 0U) == REGISTRY_ERROR_NOT_FOUND);
+    CHECK(registry_read(REGISTRY_ID_CURRENT_KP, NULL) == REGISTRY_ERROR_INVALID_PARAM);
+    printf("access: ranges, read-only and booleans enforced\n");
+}
+
+static void bench_find(void)
+{
+    uint16_t id = 0U;
+    uint32_t sum = 0U;
+    size_t lengths[BENCH_VARIABLES];
+    for (uint16_t i = 0U; i < BENCH_VARIABLES; i++) {
+        lengths[i] = strlen(names[i]);
+    }
+
+    const uint64_t start = now_ns();
+    for (uint32_t round = 0U; round < BENCH_ROUNDS; round++) {
+        for (uint16_t i = 0U; i < BENCH_VARIABLES; i++) {
+            (void)registry_find(names[i], lengths[i], &id);
+            sum += id;
+        }
+    }
+    const uint64_t elapsed = now_ns() - start;
+
+    CHECK(sum == BENCH_ROUNDS * (BENCH_VARIABLES * (BENCH_VARIABLES - 1U) / 2U));
+    printf("find: %.1f ns per name\n", (double)elapsed / ((double)BENCH_ROUNDS * BENCH_VARIABLES));
+}
+
+int main(void)
+{
+    check_table();
+    check_unknown();
+    check_access();
+    bench_find();
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,17 @@
+#ifndef REGISTRY_BENCH_VARS_H
+#define REGISTRY_BENCH_VARS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Variables behind tools/registry_host/registry_host.json, defined in registry_bench.c */
+extern float bench_float[30];
+extern bool bench_bool[10];
+extern uint32_t bench_uint32[8];
+extern int16_t bench_int16[8];
+extern uint16_t bench_uint16[1];
+extern uint8_t bench_uint8[1];
+extern int32_t bench_int32[1];
+extern int8_t bench_int8[1];
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Host implementation of boards/rtos_port.h, so the kernel in services/rtos
+ * runs unchanged in a Linux process. Threads are ucontexts on the stacks
+ * the kernel is given; SIGALRM from an interval timer is the tick
+ * interrupt, and blocking it is the critical section. A switch requested
+ * inside a critical section or the tick handler happens when either ends,
+ * as PendSV would on the target.
+ */
+#define _GNU_SOURCE
+
+#include "boards/rtos_port.h"
+#include "boards/timebase.h"
+
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+/* The C library and the tick handler run on the thread stacks too */
+#define RTOS_HOST_MIN_STACK 16384U
+
+typedef struct {
+    ucontext_t context;
+    void (*entry)(void *);
+    void *argument;
+    void (*exit)(void);
+} board_rtos_host_frame_t;
+
+board_rtos_thread_t *volatile board_rtos_current;
+board_rtos_thread_t *volatile board_rtos_next;
+volatile uint32_t board_rtos_switched_at;
+
+static void (*host_tick)(void);
+static volatile sig_atomic_t host_in_isr;
+static volatile sig_atomic_t host_switch_pending;
+
+static void host_switch(void)
+{
+    host_switch_pending = 0;
+
+    board_rtos_thread_t *from = board_rtos_current;
+    board_rtos_thread_t *to = board_rtos_next;
+    if (from != to) {
+        board_rtos_current = to;
+        swapcontext(&((board_rtos_host_frame_t *)from->context)->context,
+                    &((board_rtos_host_frame_t *)to->context)->context);
+    }
+    /* Back in the thread switched to, whichever call switched away from it */
+    board_rtos_switched_at = board_timebase_now();
+}
+
+static void host_thread_start(void)
+{
+    board_rtos_switched_at = board_timebase_now();
+
+    const board_rtos_host_frame_t *frame = (const board_rtos_host_frame_t *)board_rtos_current->context;
+    frame->entry(frame->argument);
+    if (frame->exit != NULL) {
+        frame->exit();
+    }
+}
+
+static void host_signal(int signal)
+{
+    (void)signal;
+
+    host_in_isr = 1;
+    if (host_tick != NULL) {
+        host_tick();
+    }
+    host_in_isr = 0;
+
+    if (host_switch_pending) {
+        host_switch();
+    }
+}
+
+bool board_rtos_thread_init(board_rtos_thread_t *thread, void *stack, size_t stack_size, void (*entry)(void *),
+                            void *argument, void (*exit)(void))
+{
+    if (thread == NULL || stack == NULL || entry == NULL ||
+        stack_size < sizeof(board_rtos_host_frame_t) + RTOS_HOST_MIN_STACK) {
+        return false;
+    }
+
+    /* The context lives at the top, so the bottom of the stack shows how deep it was used */
+    uintptr_t top = ((uintptr_t)stack + stack_size - sizeof(board_rtos_host_frame_t)) & ~(uintptr_t)15U;
+    board_rtos_host_frame_t *frame = (board_rtos_host_frame_t *)top;
+    memset(frame, 0, sizeof(*frame));
+    if (getcontext(&frame->context) != 0) {
+        return false;
+    }
+
+    frame->entry = entry;
+    frame->argument = argument;
+    frame->exit = exit;
+    frame->context.uc_link = NULL;
+    frame->context.uc_stack.ss_sp = stack;
+    frame->context.uc_stack.ss_size = top - (uintptr_t)stack;
+    sigemptyset(&frame->context.uc_sigmask);
+    makecontext(&frame->context, host_thread_start, 0);
+
+    thread->context = frame;
+    return true;
+}
+
+void board_rtos_start(board_rtos_thread_t *first, uint32_t tick_frequency, void (*tick)(void))
+{
+    static board_rtos_host_frame_t start_frame;
+    static board_rtos_thread_t start_thread = {.context = &start_frame};
+
+    (void)board_rtos_lock();
+    host_tick = tick;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = host_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, NULL);
+
+    const long period_us = (long)(1000000U / tick_frequency);
+    struct itimerval timer = {
+        .it_interval = {.tv_sec = period_us / 1000000L, .tv_usec = period_us % 1000000L},
+        .it_value = {.tv_sec = period_us / 1000000L, .tv_usec = period_us % 1000000L},
+    };
+    setitimer(ITIMER_REAL, &timer, NULL);
+
+    board_rtos_current = &start_thread;
+    board_rtos_next = first;
+    host_switch_pending = 1;
+    board_rtos_unlock(0U);
+
+    for (;;) {
+        pause();
+    }
+}
+
+void board_rtos_switch(void)
+{
+    host_switch_pending = 1;
+}
+
+uint32_t board_rtos_lock(void)
+{
+    sigset_t block;
+    sigset_t previous;
+    sigemptyset(&block);
+    sigaddset(&block, SIGALRM);
+    sigprocmask(SIG_BLOCK, &block, &previous);
+    return sigismember(&previous, SIGALRM) ? 1U : 0U;
+}
+
+void board_rtos_unlock(uint32_t state)
+{
+    if (state != 0U) {
+        return;
+    }
+
+    if (host_switch_pending && !host_in_isr) {
+        host_switch();
+    }
+
+    sigset_t unblock;
+    sigemptyset(&unblock);
+    sigaddset(&unblock, SIGALRM);
+    sigprocmask(SIG_UNBLOCK, &unblock, NULL);
+}
+
+bool board_rtos_in_isr(void)
+{
+    return host_in_isr != 0;
+}
+
+void board_rtos_idle(void)
+{
+    pause();
+}
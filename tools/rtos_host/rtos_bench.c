@@ -0,0 +1,298 @@
+/*
+ * Host check and context switch benchmark for the kernel in services/rtos,
+ * on the ucontext port (board_rtos_host.c). A test thread checks
+ * preemption, delays, event flags, message queues and mutex priority
+ * inheritance, then times a thread woken by event flags over many rounds.
+ */
+#define _GNU_SOURCE
+
+#include "services/rtos/rtos.h"
+#include "boards/timebase.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_STACK_SIZE (64U * 1024U)
+#define BENCH_THREADS 4U
+#define BENCH_ROUNDS 100000U
+
+#define FLAG_GO 0x1U
+#define FLAG_PING 0x2U
+#define FLAG_ALL 0x7U
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+static int failures;
+
+static uint64_t stacks[BENCH_THREADS + 1U][BENCH_STACK_SIZE / sizeof(uint64_t)];
+static rtos_thread_t thread_cbs[BENCH_THREADS];
+
+/* Order in which threads got to run, one letter each */
+static char trace[16];
+static size_t trace_length;
+
+static osEventFlagsId_t flags;
+static osMutexId_t mutex;
+static osMessageQueueId_t queue;
+static uint32_t queue_storage[RTOS_MESSAGE_QUEUE_MEM_SIZE(4U, sizeof(uint32_t)) / sizeof(uint32_t)];
+
+static uint32_t ping_sent_at;
+static uint32_t latencies[BENCH_ROUNDS];
+
+static void record(char letter)
+{
+    if (trace_length < sizeof(trace) - 1U) {
+        trace[trace_length++] = letter;
+        trace[trace_length] = '\0';
+    }
+}
+
+static void clear_trace(void)
+{
+    trace_length = 0U;
+    trace[0] = '\0';
+}
+
+static osThreadId_t spawn(osThreadFunc_t function, const char *name, osPriority_t priority, unsigned slot)
+{
+    const osThreadAttr_t attr = {
+        .name = name,
+        .cb_mem = &thread_cbs[slot],
+        .cb_size = sizeof(thread_cbs[slot]),
+        .stack_mem = stacks[slot + 1U],
+        .stack_size = BENCH_STACK_SIZE,
+        .priority = priority,
+    };
+    return osThreadNew(function, NULL, &attr);
+}
+
+static void preempting_thread(void *argument)
+{
+    (void)argument;
+    record('P');
+}
+
+/* ---- Priority inheritance: L holds the mutex H wants, M must not get in between ---- */
+
+static void low_thread(void *argument)
+{
+    (void)argument;
+    osMutexAcquire(mutex, osWaitForever);
+    osEventFlagsWait(flags, FLAG_GO, osFlagsWaitAny | osFlagsNoClear, osWaitForever);
+    record('L');
+    osMutexRelease(mutex);
+}
+
+static void high_thread(void *argument)
+{
+    (void)argument;
+    if (osMutexAcquire(mutex, osWaitForever) == osOK) {
+        record('H');
+        osMutexRelease(mutex);
+    }
+}
+
+static void medium_thread(void *argument)
+{
+    (void)argument;
+    osEventFlagsWait(flags, FLAG_GO, osFlagsWaitAny | osFlagsNoClear, osWaitForever);
+    record('M');
+}
+
+/* ---- Message queue ---- */
+
+static void consumer_thread(void *argument)
+{
+    (void)argument;
+    for (uint32_t expected = 0U; expected < 10U; expected++) {
+        uint32_t value = UINT32_MAX;
+        if (osMessageQueueGet(queue, &value, NULL, 100U) != osOK || value != expected) {
+            failures++;
+            return;
+        }
+    }
+    record('C');
+}
+
+/* ---- Switch latency ---- */
+
+static void ping_thread(void *argument)
+{
+    (void)argument;
+    for (uint32_t round = 0U; round < BENCH_ROUNDS; round++) {
+        osEventFlagsWait(flags, FLAG_PING, osFlagsWaitAny, osWaitForever);
+        latencies[round] = board_timebase_now() - ping_sent_at;
+    }
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void check_threads(void)
+{
+    clear_trace();
+    CHECK(spawn(preempting_thread, "preempting", osPriorityHigh, 0U) != NULL);
+    record('T');
+    CHECK(strcmp(trace, "PT") == 0);
+
+    CHECK(spawn(preempting_thread, "waiting", osPriorityLow, 0U) != NULL);
+    CHECK(trace_length == 2U);
+    const uint32_t start = osKernelGetTickCount();
+    CHECK(osDelay(5U) == osOK);
+    CHECK(osKernelGetTickCount() - start >= 5U);
+    CHECK(trace_length == 3U && trace[2] == 'P');
+    CHECK(osThreadGetState(&thread_cbs[0]) == osThreadTerminated);
+    CHECK(osThreadGetStackSpace(osThreadGetId()) > 0U);
+}
+
+static void check_event_flags(void)
+{
+    osEventFlagsClear(flags, FLAG_ALL);
+    CHECK(osEventFlagsWait(flags, FLAG_GO, osFlagsWaitAny, 0U) == osFlagsErrorResource);
+
+    const uint32_t start = osKernelGetTickCount();
+    CHECK(osEventFlagsWait(flags, FLAG_GO, osFlagsWaitAny, 3U) == osFlagsErrorTimeout);
+    CHECK(osKernelGetTickCount() - start >= 3U);
+
+    osEventFlagsSet(flags, FLAG_PING);
+    CHECK(osEventFlagsWait(flags, FLAG_GO | FLAG_PING, osFlagsWaitAll, 0U) == osFlagsErrorResource);
+    CHECK(osEventFlagsWait(flags, FLAG_GO | FLAG_PING, osFlagsWaitAny | osFlagsNoClear, 0U) == FLAG_PING);
+    CHECK(osEventFlagsWait(flags, FLAG_PING, osFlagsWaitAny, 0U) == FLAG_PING);
+    CHECK(osEventFlagsGet(flags) == 0U);
+}
+
+static void check_message_queue(void)
+{
+    uint32_t value = 0U;
+    CHECK(osMessageQueueGet(queue, &value, NULL, 0U) == osErrorResource);
+
+    /* Fill the queue, then let the consumer drain it while the rest wait for room */
+    clear_trace();
+    for (uint32_t i = 0U; i < 4U; i++) {
+        CHECK(osMessageQueuePut(queue, &i, 0U, 0U) == osOK);
+    }
+    CHECK(osMessageQueuePut(queue, &value, 0U, 0U) == osErrorResource);
+    CHECK(osMessageQueueGetSpace(queue) == 0U);
+
+    CHECK(spawn(consumer_thread, "consumer", osPriorityLow, 1U) != NULL);
+    for (uint32_t i = 4U; i < 10U; i++) {
+        CHECK(osMessageQueuePut(queue, &i, 0U, 100U) == osOK);
+    }
+    CHECK(osDelay(2U) == osOK);
+    CHECK(strcmp(trace, "C") == 0);
+    CHECK(osMessageQueueGetCount(queue) == 0U);
+}
+
+static void check_priority_inheritance(void)
+{
+    clear_trace();
+    osEventFlagsClear(flags, FLAG_ALL);
+
+    osThreadId_t low = spawn(low_thread, "low", osPriorityLow, 0U);
+    CHECK(osDelay(1U) == osOK); /* low takes the mutex and waits */
+    CHECK(osMutexGetOwner(mutex) == low);
+
+    CHECK(spawn(high_thread, "high", osPriorityHigh, 1U) != NULL);
+    CHECK(osThreadGetPriority(low) == osPriorityHigh);
+
+    CHECK(spawn(medium_thread, "medium", osPriorityAboveNormal, 2U) != NULL);
+    osEventFlagsSet(flags, FLAG_GO);
+
+    /* Inherited priority lets low finish before medium runs */
+    CHECK(strcmp(trace, "LHM") == 0);
+    CHECK(osMutexGetOwner(mutex) == NULL);
+    CHECK(osThreadGetPriority(low) == osPriorityLow);
+    CHECK(osMutexRelease(mutex) == osErrorResource);
+
+    const osMutexAttr_t recursive_attr = {.name = "recursive", .attr_bits = osMutexRecursive};
+    osMutexId_t recursive = osMutexNew(&recursive_attr);
+    CHECK(osMutexAcquire(recursive, 0U) == osOK);
+    CHECK(osMutexAcquire(recursive, 0U) == osOK);
+    CHECK(osMutexRelease(recursive) == osOK);
+    CHECK(osMutexGetOwner(recursive) == osThreadGetId());
+    CHECK(osMutexRelease(recursive) == osOK);
+    CHECK(osMutexGetOwner(recursive) == NULL);
+    CHECK(osMutexDelete(recursive) == osOK);
+
+    CHECK(osDelay(1U) == osOK);
+}
+
+static void bench_switch(void)
+{
+    osEventFlagsClear(flags, FLAG_ALL);
+    osThreadId_t ping = spawn(ping_thread, "ping", osPriorityHigh, 3U);
+    CHECK(ping != NULL);
+
+    for (uint32_t round = 0U; round < BENCH_ROUNDS; round++) {
+        ping_sent_at = board_timebase_now();
+        osEventFlagsSet(flags, FLAG_PING);
+    }
+
+    rtos_switch_stats_t stats;
+    rtos_get_switch_stats(&stats);
+
+    qsort(latencies, BENCH_ROUNDS, sizeof(latencies[0]), compare_u32);
+    const double ns_per_tick = 1e9 / (double)board_timebase_frequency();
+    printf("event flags set to woken thread running, %u rounds:\n", BENCH_ROUNDS);
+    printf("  p50 %.0f ns  p99 %.0f ns  max %.0f ns\n", latencies[BENCH_ROUNDS / 2U] * ns_per_tick,
+           latencies[BENCH_ROUNDS * 99U / 100U] * ns_per_tick, latencies[BENCH_ROUNDS - 1U] * ns_per_tick);
+    printf("kernel switch latency: last %.0f ns  max %.0f ns over %u switches\n", stats.latency_last * ns_per_tick,
+           stats.latency_max * ns_per_tick, stats.switches);
+}
+
+static void test_thread(void *argument)
+{
+    (void)argument;
+
+    const osEventFlagsAttr_t flags_attr = {.name = "flags"};
+    const osMutexAttr_t mutex_attr = {.name = "mutex", .attr_bits = osMutexPrioInherit};
+    const osMessageQueueAttr_t queue_attr = {
+        .name = "queue",
+        .mq_mem = queue_storage,
+        .mq_size = sizeof(queue_storage),
+    };
+    flags = osEventFlagsNew(&flags_attr);
+    mutex = osMutexNew(&mutex_attr);
+    queue = osMessageQueueNew(4U, sizeof(uint32_t), &queue_attr);
+    CHECK(flags != NULL && mutex != NULL && queue != NULL);
+
+    check_threads();
+    check_event_flags();
+    check_message_queue();
+    check_priority_inheritance();
+    bench_switch();
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    exit((failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+int main(void)
+{
+    static rtos_thread_t test_cb;
+    const osThreadAttr_t attr = {
+        .name = "test",
+        .cb_mem = &test_cb,
+        .cb_size = sizeof(test_cb),
+        .stack_mem = stacks[0],
+        .stack_size = BENCH_STACK_SIZE,
+        .priority = osPriorityNormal,
+    };
+
+    if (osKernelInitialize() != osOK || osThreadNew(test_thread, NULL, &attr) == NULL) {
+        fprintf(stderr, "kernel setup failed\n");
+        return EXIT_FAILURE;
+    }
+    osKernelStart();
+    return EXIT_FAILURE;
+}
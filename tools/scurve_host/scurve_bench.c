@@ -0,0 +1,209 @@
+/*
+ * Host check and benchmark for control/scurve. Moves are played tick by
+ * tick at the control rate: every setpoint must respect the jerk,
+ * acceleration and velocity limits, never pass the target by more than a
+ * tick of jerk, and the move must end at rest exactly on the target within
+ * a bound of the time-optimal duration. Far from the origin and for moves of a fraction of a radian the
+ * float resolution of the target is what limits the profile. Then the cost
+ * of a tick is timed.
+ */
+#define _GNU_SOURCE
+
+#include "control/scurve/scurve.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_RATE_HZ 20000.0f
+#define BENCH_DT (1.0f / BENCH_RATE_HZ)
+#define BENCH_TIME_MARGIN 1.25 /* of the time-optimal move */
+#define BENCH_TIME_SLACK 20U   /* [ticks] */
+#define BENCH_LIMIT_MARGIN 1e-3
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+typedef struct {
+    double start;
+    double target;
+} move_t;
+
+typedef struct {
+    double jerk;
+    double acceleration;
+    double velocity;
+    double overshoot;
+} peaks_t;
+
+static int failures;
+
+static const move_t moves[] = {
+    {0.0, 20.0},    {0.0, 30.0},       {0.0, 50.0},          {0.0, 100.0},         {0.0, -20.0},
+    {0.0, -30.0},   {1000.0, 1010.0},  {10000.0, 10100.0},   {100000.0, 100000.5}, {0.0, 0.5},
+    {0.0, 1e-3},    {0.0, 1e-6},       {-5.0, 5.0},          {3.14159, -3.14159},
+};
+
+/* Time of a jerk-limited change of speed from rest to v */
+static double accel_time(double v, const scurve_limits_t *limits)
+{
+    const double a = limits->acceleration;
+    const double j = limits->jerk;
+    return (v * j >= a * a) ? v / a + a / j : 2.0 * sqrt(v / j);
+}
+
+/* Duration of the time-optimal rest-to-rest move over distance */
+static double optimal_time(double distance, const scurve_limits_t *limits)
+{
+    const double v_max = limits->velocity;
+    if (v_max * accel_time(v_max, limits) <= distance) {
+        return accel_time(v_max, limits) + distance / v_max;
+    }
+
+    /* Peak speed below the limit: distance v * t(v) grows with v */
+    double low = 0.0;
+    double high = v_max;
+    for (int i = 0; i < 100; i++) {
+        const double v = 0.5 * (low + high);
+        if (v * accel_time(v, limits) < distance) {
+            low = v;
+        } else {
+            high = v;
+        }
+    }
+    return 2.0 * accel_time(low, limits);
+}
+
+/* Limits are checked on the float setpoints, with a relative margin for rounding */
+static void check_limits(const scurve_setpoint_t *previous, const scurve_setpoint_t *setpoint,
+                         const scurve_limits_t *limits, peaks_t *peaks)
+{
+    const double jerk = fabs((double)setpoint->acceleration - previous->acceleration) / BENCH_DT;
+    peaks->jerk = fmax(peaks->jerk, jerk / limits->jerk);
+    peaks->acceleration = fmax(peaks->acceleration, fabs(setpoint->acceleration) / limits->acceleration);
+    peaks->velocity = fmax(peaks->velocity, fabs(setpoint->velocity) / limits->velocity);
+}
+
+static void run_move(const move_t *move, const scurve_limits_t *limits, peaks_t *all)
+{
+    scurve_t scurve;
+    scurve_setpoint_t setpoint = {.position = (float)move->start};
+    peaks_t peaks = {0};
+
+    CHECK(scurve_init(&scurve, limits, BENCH_DT, (float)move->start) == SCURVE_SUCCESS);
+    CHECK(scurve_set_target(&scurve, (float)move->target) == SCURVE_SUCCESS);
+
+    const float target = (float)move->target;
+    const double distance = fabs((double)target - (float)move->start);
+    const double direction = (target >= (float)move->start) ? 1.0 : -1.0;
+    const uint32_t budget =
+        (uint32_t)(optimal_time(distance, limits) * BENCH_TIME_MARGIN * BENCH_RATE_HZ) + BENCH_TIME_SLACK;
+
+    uint32_t tick = 0U;
+    do {
+        const scurve_setpoint_t previous = setpoint;
+        scurve_step(&scurve, &setpoint);
+        check_limits(&previous, &setpoint, limits, &peaks);
+        peaks.overshoot = fmax(peaks.overshoot, direction * ((double)setpoint.position - target));
+        tick++;
+    } while (!scurve_is_settled(&scurve) && tick <= budget);
+
+    printf("%10.7g -> %-10.7g %6u ticks (optimal %6.0f), peak jerk %.3f acc %.3f vel %.3f of limit\n", move->start,
+           move->target, tick, optimal_time(distance, limits) * BENCH_RATE_HZ, peaks.jerk, peaks.acceleration,
+           peaks.velocity);
+
+    CHECK(scurve_is_settled(&scurve));
+    CHECK(setpoint.position == target);
+    CHECK(setpoint.velocity == 0.0f && setpoint.acceleration == 0.0f);
+    CHECK(peaks.overshoot <= limits->jerk * BENCH_DT * BENCH_DT * BENCH_DT);
+    CHECK(peaks.jerk <= 1.0 + BENCH_LIMIT_MARGIN);
+    CHECK(peaks.acceleration <= 1.0 + BENCH_LIMIT_MARGIN);
+    CHECK(peaks.velocity <= 1.0 + BENCH_LIMIT_MARGIN);
+
+    all->jerk = fmax(all->jerk, peaks.jerk);
+    all->acceleration = fmax(all->acceleration, peaks.acceleration);
+    all->velocity = fmax(all->velocity, peaks.velocity);
+}
+
+/* A new target mid-move, behind the current position, must be reached without breaking a limit */
+static void check_retarget(const scurve_limits_t *limits)
+{
+    scurve_t scurve;
+    scurve_setpoint_t setpoint = {0};
+    peaks_t peaks = {0};
+
+    scurve_init(&scurve, limits, BENCH_DT, 0.0f);
+    scurve_set_target(&scurve, 50.0f);
+    for (uint32_t tick = 0U; tick < (uint32_t)(0.2f * BENCH_RATE_HZ); tick++) {
+        const scurve_setpoint_t previous = setpoint;
+        scurve_step(&scurve, &setpoint);
+        check_limits(&previous, &setpoint, limits, &peaks);
+    }
+    CHECK(setpoint.velocity > 0.0f);
+
+    scurve_set_target(&scurve, 1.0f);
+    uint32_t tick = 0U;
+    do {
+        const scurve_setpoint_t previous = setpoint;
+        scurve_step(&scurve, &setpoint);
+        check_limits(&previous, &setpoint, limits, &peaks);
+        tick++;
+    } while (!scurve_is_settled(&scurve) && tick < (uint32_t)(10.0f * BENCH_RATE_HZ));
+
+    printf("retarget 50 -> 1 at %.1f rad: %u ticks, peak jerk %.3f acc %.3f vel %.3f of limit\n",
+           (double)setpoint.position, tick, peaks.jerk, peaks.acceleration, peaks.velocity);
+    CHECK(scurve_is_settled(&scurve));
+    CHECK(setpoint.position == 1.0f);
+    CHECK(peaks.jerk <= 1.0 + BENCH_LIMIT_MARGIN);
+    CHECK(peaks.acceleration <= 1.0 + BENCH_LIMIT_MARGIN);
+    CHECK(peaks.velocity <= 1.0 + BENCH_LIMIT_MARGIN);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Back and forth moves, so the cost covers every phase of the profile */
+static void bench_tick(const scurve_limits_t *limits)
+{
+    scurve_t scurve;
+    scurve_setpoint_t setpoint;
+    const uint32_t ticks = 2000000U;
+
+    scurve_init(&scurve, limits, BENCH_DT, 0.0f);
+    const double start = now_ns();
+    for (uint32_t tick = 0U; tick < ticks; tick++) {
+        if (scurve_is_settled(&scurve)) {
+            scurve_set_target(&scurve, (setpoint.position > 5.0f) ? 0.0f : 10.0f);
+        }
+        scurve_step(&scurve, &setpoint);
+    }
+    printf("step: %.1f ns per tick\n", (now_ns() - start) / ticks);
+}
+
+int main(void)
+{
+    scurve_limits_t limits;
+    scurve_limits_default(&limits);
+    printf("limits: %.1f rad/s, %.0f rad/s^2, %.0f rad/s^3 at %.0f Hz\n", limits.velocity, limits.acceleration,
+           limits.jerk, BENCH_RATE_HZ);
+
+    peaks_t all = {0};
+    for (size_t i = 0U; i < sizeof(moves) / sizeof(moves[0]); i++) {
+        run_move(&moves[i], &limits, &all);
+    }
+    check_retarget(&limits);
+    bench_tick(&limits);
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,236 @@
+/*
+ * Host check and benchmark for the resonance detector and the adaptive
+ * notches of control/speed_loop. Synthetic speed errors are fed at the
+ * speed loop rate: single tones must be found within a tenth of a bin, and
+ * white noise alone must give no peak. Then one resonance more than there
+ * are notch stages is played, each attenuated by the live notch cascade:
+ * the strongest must end up notched and the stages must then stay put
+ * instead of being handed back and forth. Finally the cost of a tick and
+ * of an analysis is timed.
+ */
+#define _GNU_SOURCE
+
+#include "control/speed_loop/speed_loop.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_SAMPLE_RATE ((float)CONTROL_PWM_FREQUENCY_HZ / (float)CONTROL_SPEED_LOOP_DIVIDER)
+#define BENCH_NOISE 0.02f
+#define BENCH_BIN_TOLERANCE 0.1f
+#define BENCH_LOWEST_HZ 60.0f
+#define BENCH_ANALYSES 40U
+#define BENCH_WARMUP_ANALYSES 8U
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+typedef struct {
+    float frequency;
+    float amplitude;
+    float phase;
+} tone_t;
+
+static int failures;
+static uint32_t random_state = 12345U;
+
+/* Uniform in [-1, 1) from a 32-bit LCG, so runs repeat exactly */
+static float uniform(void)
+{
+    random_state = random_state * 1664525U + 1013904223U;
+    return (float)(random_state >> 8) / 8388608.0f - 1.0f;
+}
+
+/* Sum of four uniforms: close enough to Gaussian for a noise floor, standard deviation sigma */
+static float noise(float sigma)
+{
+    return sigma * 0.866f * (uniform() + uniform() + uniform() + uniform());
+}
+
+/* Gain of the active coefficient bank at frequency */
+static float notch_gain(const notch_filter_t *filter, float frequency)
+{
+    const double complex z1 = cexp(-I * 2.0 * M_PI * frequency / filter->sample_rate);
+    double complex response = 1.0;
+    for (uint8_t stage = 0U; stage < NOTCH_MAX_STAGES; stage++) {
+        const float *c = &filter->instance.pCoeffs[stage * NOTCH_COEFFS_PER_STAGE];
+        response *= (c[0] + c[1] * z1 + c[2] * z1 * z1) / (1.0 - c[3] * z1 - c[4] * z1 * z1);
+    }
+    return (float)cabs(response);
+}
+
+/* Tones at non-integer bins across the band, one capture each */
+static void check_detector(void)
+{
+    static resonance_detector_t detector;
+    resonance_config_t config;
+    resonance_config_default(&config, BENCH_SAMPLE_RATE);
+    CHECK(resonance_init(&detector, &config) == RESONANCE_SUCCESS);
+
+    const float bin_width = BENCH_SAMPLE_RATE / (float)RESONANCE_FFT_SIZE;
+    float worst = 0.0f;
+    uint32_t tones = 0U;
+    for (float frequency = config.f_min + 0.37f * bin_width; frequency < config.f_max; frequency *= 1.13f) {
+        for (uint32_t n = 0U; n < RESONANCE_FFT_SIZE; n++) {
+            const float t = (float)n / BENCH_SAMPLE_RATE;
+            resonance_push(&detector, sinf(2.0f * (float)M_PI * frequency * t) + noise(BENCH_NOISE));
+        }
+        CHECK(resonance_process(&detector));
+
+        const resonance_peak_t *peaks;
+        const uint8_t count = resonance_get_peaks(&detector, &peaks);
+        CHECK(count >= 1U);
+        if (count >= 1U) {
+            worst = fmaxf(worst, fabsf(peaks[0].frequency - frequency) / bin_width);
+        }
+        tones++;
+    }
+    printf("detector: %u tones %.0f to %.0f Hz, worst error %.3f bin of %.2f Hz\n", tones, config.f_min,
+           config.f_max, worst, bin_width);
+    CHECK(worst <= BENCH_BIN_TOLERANCE);
+
+    /* Noise alone stays under the threshold */
+    uint8_t false_peaks = 0U;
+    for (uint32_t capture = 0U; capture < 20U; capture++) {
+        for (uint32_t n = 0U; n < RESONANCE_FFT_SIZE; n++) {
+            resonance_push(&detector, noise(BENCH_NOISE));
+        }
+        CHECK(resonance_process(&detector));
+        const resonance_peak_t *peaks;
+        false_peaks += resonance_get_peaks(&detector, &peaks);
+    }
+    printf("detector: %u peaks in 20 captures of white noise\n", false_peaks);
+    CHECK(false_peaks == 0U);
+}
+
+/* One capture of the tones, each attenuated by the notches as they stand */
+static void play_capture(speed_loop_t *loop, const tone_t *tones, uint32_t count, uint32_t *tick)
+{
+    float gains[NOTCH_MAX_STAGES + 1U];
+    for (uint32_t k = 0U; k < count; k++) {
+        gains[k] = notch_gain(&loop->notch, tones[k].frequency);
+    }
+
+    for (uint32_t n = 0U; n < RESONANCE_FFT_SIZE; n++, (*tick)++) {
+        const float t = (float)*tick / BENCH_SAMPLE_RATE;
+        float error = noise(BENCH_NOISE);
+        for (uint32_t k = 0U; k < count; k++) {
+            error += gains[k] * tones[k].amplitude * sinf(2.0f * (float)M_PI * tones[k].frequency * t + tones[k].phase);
+        }
+        speed_loop_update(loop, error, 0.0f);
+    }
+    speed_loop_process(loop);
+}
+
+static bool covers(const notch_params_t *params, float frequency)
+{
+    return params->enabled && fabsf(params->frequency - frequency) < 0.5f * params->width;
+}
+
+/*
+ * One resonance more than there are stages, spaced by more than a notch
+ * width and weaker with frequency, so the spare one is nearest to a stage
+ * that is also in demand.
+ */
+static void check_adaptive(void)
+{
+    static speed_loop_t loop;
+    const pi_gains_t gains = {.kp = 0.0f, .ki = 0.0f};
+    CHECK(speed_loop_init(&loop, &gains, BENCH_SAMPLE_RATE, 1.0f) == SPEED_LOOP_SUCCESS);
+
+    const uint32_t count = NOTCH_MAX_STAGES + 1U;
+    const float spacing = 1.0f + 1.25f * loop.notch_width_ratio;
+    tone_t tones[NOTCH_MAX_STAGES + 1U];
+    for (uint32_t k = 0U; k < count; k++) {
+        tones[k].frequency = BENCH_LOWEST_HZ * powf(spacing, (float)k);
+        tones[k].amplitude = 1.0f - 0.1f * (float)k;
+        tones[k].phase = (float)k;
+    }
+    if (tones[count - 1U].frequency > loop.resonance.config.f_max) {
+        printf("adaptive: skipped, %u resonances a notch width apart do not fit below %.0f Hz\n", count,
+               loop.resonance.config.f_max);
+        return;
+    }
+
+    uint32_t tick = 0U;
+    uint32_t moves = 0U;
+    notch_params_t previous[NOTCH_MAX_STAGES] = {0};
+    for (uint32_t analysis = 0U; analysis < BENCH_ANALYSES; analysis++) {
+        play_capture(&loop, tones, count, &tick);
+
+        for (uint8_t stage = 0U; stage < NOTCH_MAX_STAGES; stage++) {
+            notch_params_t params;
+            notch_get(&loop.notch, stage, &params);
+            if (analysis >= BENCH_WARMUP_ANALYSES &&
+                (params.enabled != previous[stage].enabled || !covers(&previous[stage], params.frequency))) {
+                moves++;
+            }
+            previous[stage] = params;
+        }
+    }
+
+    /* Every stage on one of the strongest resonances, none on the spare one */
+    uint32_t covered = 0U;
+    for (uint8_t stage = 0U; stage < NOTCH_MAX_STAGES; stage++) {
+        for (uint32_t k = 0U; k + 1U < count; k++) {
+            covered += covers(&previous[stage], tones[k].frequency) ? 1U : 0U;
+        }
+    }
+
+    printf("adaptive: %u resonances %.0f to %.0f Hz on %u stages, %u of the strongest notched,"
+           " %u stage moves after %u analyses\n",
+           count, tones[0].frequency, tones[count - 1U].frequency, (unsigned)NOTCH_MAX_STAGES, covered, moves,
+           BENCH_WARMUP_ANALYSES);
+    CHECK(covered == NOTCH_MAX_STAGES);
+    CHECK(moves == 0U);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(void)
+{
+    static speed_loop_t loop;
+    const pi_gains_t gains = {.kp = 0.1f, .ki = 10.0f};
+    speed_loop_init(&loop, &gains, BENCH_SAMPLE_RATE, 1.0f);
+
+    const uint32_t ticks = RESONANCE_FFT_SIZE * 2000U;
+    double analyses = 0.0;
+    float sink = 0.0f;
+    const double start = now_ns();
+    for (uint32_t tick = 0U; tick < ticks; tick++) {
+        sink += speed_loop_update(&loop, 0.5f * sinf(0.3f * (float)tick), 0.0f);
+
+        /* Only slices with a full capture do any work; those are timed on their own */
+        if (loop.resonance.ready) {
+            const double analysis_start = now_ns();
+            speed_loop_process(&loop);
+            analyses += now_ns() - analysis_start;
+        }
+    }
+    const double total = now_ns() - start;
+    printf("update: %.1f ns per tick, process: %.1f us per analysis (%.0f)\n", (total - analyses) / ticks,
+           analyses / 1000.0 / (ticks / RESONANCE_FFT_SIZE), (double)sink);
+}
+
+int main(void)
+{
+    check_detector();
+    check_adaptive();
+    bench();
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
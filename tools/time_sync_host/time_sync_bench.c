@@ -0,0 +1,283 @@
+/*
+ * Host check and benchmark for services/time_sync. A slave control loop
+ * runs on a simulated 170 MHz timebase that wraps during the run, its PWM
+ * period loaded one tick late as the timer preload does, against a master
+ * whose SYNC runs fast or slow by a set offset with timestamp jitter. The
+ * phase lock must converge, put cycle tick 0 on the SYNC plus the offset
+ * and learn the frequency offset; the period trim must have the right
+ * sign and stay within its clamp, also when the master is out of range;
+ * the trim must hold through a lost SYNC and relock. Then the cost of a
+ * tick is timed.
+ */
+#define _GNU_SOURCE
+
+#include "services/time_sync/time_sync.h"
+#include "service_config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_TIMEBASE_HZ 170000000U
+#define BENCH_PWM_PERIOD 4250U        /* center-aligned timer counts per control tick at 170 MHz */
+#define BENCH_START_TIME 4294000000.0 /* [timebase ticks] just before the 32-bit wrap */
+#define BENCH_JITTER 170.0            /* peak SYNC timestamp jitter [timebase ticks], 1 us */
+#define BENCH_LOCK_SYNCS 100U         /* SYNCs allowed to lock from any phase */
+#define BENCH_LOCKED_SYNCS 200U       /* SYNCs observed once locked */
+#define BENCH_PPM_TOLERANCE 10.0      /* mean learned frequency against the master's offset [ppm] */
+#define BENCH_HOLD_TOLERANCE 250.0    /* frequency held from a single SYNC, with its jitter [ppm] */
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+typedef struct {
+    time_sync_t sync;
+    double now;           /* slave time [timebase ticks] */
+    double tick_time;     /* start of the last tick [timebase ticks] */
+    uint32_t period;      /* timer period of the tick under way [counts] */
+    uint32_t preload;     /* timer period loaded for the next tick [counts] */
+    double master_period; /* SYNC period on the slave timebase [timebase ticks] */
+    double next_sync;
+    double last_sync;
+    bool sync_on;
+    double worst_counts;  /* largest period change seen [counts] */
+} link_t;
+
+static int failures;
+static uint32_t random_state = 12345U;
+
+/* Uniform in [-1, 1) from a 32-bit LCG, so runs repeat exactly */
+static double uniform(void)
+{
+    random_state = random_state * 1664525U + 1013904223U;
+    return (double)(random_state >> 8) / 8388608.0 - 1.0;
+}
+
+/* Master SYNC offset_ppm fast or slow, its first SYNC phase_ticks after the slave's first tick */
+static void link_init(link_t *link, double offset_ppm, double phase_ticks)
+{
+    time_sync_config_t config;
+    time_sync_config_default(&config, BENCH_TIMEBASE_HZ, BENCH_PWM_PERIOD);
+    CHECK(time_sync_init(&link->sync, &config, BENCH_TIMEBASE_HZ) == TIME_SYNC_SUCCESS);
+
+    link->now = BENCH_START_TIME;
+    link->period = BENCH_PWM_PERIOD;
+    link->preload = BENCH_PWM_PERIOD;
+    link->master_period =
+        (double)SERVICE_TIME_SYNC_PERIOD_US * (BENCH_TIMEBASE_HZ / 1000000U) * (1.0 + offset_ppm * 1e-6);
+    link->next_sync = link->now + phase_ticks;
+    link->last_sync = link->next_sync - link->master_period;
+    link->sync_on = true;
+    link->worst_counts = 0.0;
+}
+
+/* One control tick: SYNCs received since the last one, then the tick and the timer */
+static void link_tick(link_t *link)
+{
+    while (link->next_sync <= link->now) {
+        if (link->sync_on) {
+            time_sync_on_sync(&link->sync, (uint32_t)fmod(link->next_sync + BENCH_JITTER * uniform(), 4294967296.0));
+        }
+        link->last_sync = link->next_sync;
+        link->next_sync += link->master_period;
+    }
+
+    link->tick_time = link->now;
+    const uint32_t counts = time_sync_tick(&link->sync, (uint32_t)fmod(link->now, 4294967296.0));
+    link->worst_counts = fmax(link->worst_counts, fabs((double)counts - BENCH_PWM_PERIOD));
+
+    /* The value loaded now takes effect at the next update event */
+    link->now += (double)link->period / link->sync.counts_per_tick;
+    link->period = link->preload;
+    link->preload = counts;
+}
+
+/* Frequency correction learned by the integral, without the phase term that follows the jitter */
+static double learned_ppm(const link_t *link)
+{
+    return -(double)link->sync.integral / (double)link->sync.config.tick_period * 1e6;
+}
+
+/* Runs whole SYNC periods; returns how many passed before the lock, or UINT32_MAX */
+static uint32_t link_run(link_t *link, uint32_t syncs)
+{
+    uint32_t locked_at = UINT32_MAX;
+    for (uint32_t tick = 0U; tick < syncs * link->sync.config.ticks_per_sync; tick++) {
+        link_tick(link);
+        if (locked_at == UINT32_MAX && time_sync_get_state(&link->sync) == TIME_SYNC_STATE_LOCKED) {
+            locked_at = tick / link->sync.config.ticks_per_sync;
+        }
+    }
+    return locked_at;
+}
+
+/* Distance of cycle tick 0 from the SYNC plus the offset, by the true times; at tick 0 only */
+static double tick0_error(const link_t *link)
+{
+    const time_sync_config_t *config = &link->sync.config;
+    return link->tick_time - link->last_sync - (double)config->phase_offset;
+}
+
+/* A late tick must shorten the next period and an early one lengthen it */
+static void check_sign(void)
+{
+    time_sync_t sync;
+    time_sync_config_t config;
+    time_sync_config_default(&config, BENCH_TIMEBASE_HZ, BENCH_PWM_PERIOD);
+
+    const uint32_t timestamp = 0xFFFFFF00U; /* the tick falls after the wrap */
+    const int32_t step = (int32_t)config.tick_period / 10;
+
+    time_sync_init(&sync, &config, BENCH_TIMEBASE_HZ);
+    time_sync_on_sync(&sync, timestamp);
+    const uint32_t late = time_sync_tick(&sync, timestamp + (uint32_t)(config.phase_offset + step));
+    CHECK(sync.phase_error == step);
+    CHECK(late < BENCH_PWM_PERIOD);
+
+    time_sync_init(&sync, &config, BENCH_TIMEBASE_HZ);
+    time_sync_on_sync(&sync, timestamp);
+    const uint32_t early = time_sync_tick(&sync, timestamp + (uint32_t)(config.phase_offset - step));
+    CHECK(sync.phase_error == -step);
+    CHECK(early > BENCH_PWM_PERIOD);
+
+    printf("sign: %+d ticks late gives %u counts, early gives %u, nominal %u\n", step, late, early,
+           BENCH_PWM_PERIOD);
+}
+
+/* From several start phases and master offsets within range */
+static void check_lock(double offset_ppm, double phase_fraction)
+{
+    static link_t link;
+    link_init(&link, offset_ppm, phase_fraction * (double)link.sync.config.tick_period + 1000.0);
+
+    const time_sync_config_t *config = &link.sync.config;
+    const uint32_t locked_at = link_run(&link, BENCH_LOCK_SYNCS);
+
+    /* Locked: measure where tick 0 lands and what the trim learned */
+    double worst = 0.0;
+    double learned = 0.0;
+    double spread = 0.0;
+    bool stayed = true;
+    for (uint32_t tick = 0U; tick < BENCH_LOCKED_SYNCS * config->ticks_per_sync; tick++) {
+        link_tick(&link);
+        stayed = stayed && time_sync_get_state(&link.sync) == TIME_SYNC_STATE_LOCKED;
+        if (time_sync_get_cycle_tick(&link.sync) == 0U) {
+            worst = fmax(worst, fabs(tick0_error(&link)));
+            learned += learned_ppm(&link) / BENCH_LOCKED_SYNCS;
+            spread = fmax(spread, fabs(learned_ppm(&link) - offset_ppm));
+        }
+    }
+
+    const double window = (double)config->lock_window + BENCH_JITTER;
+    printf("lock %+6.0f ppm from %+.2f tick: locked after %u SYNCs, tick 0 within %.0f ns,"
+           " learned %+.1f ppm (peak error %.0f ppm)\n",
+           offset_ppm, phase_fraction, locked_at, worst * 1e9 / BENCH_TIMEBASE_HZ, learned, spread);
+    CHECK(locked_at < BENCH_LOCK_SYNCS);
+    CHECK(stayed);
+    CHECK(worst <= window);
+    /* Near the clamp the phase term is cut on one side and the integral has to sit further out */
+    if (fabs(offset_ppm) <= 0.5 * SERVICE_TIME_SYNC_MAX_ADJUST_PPM) {
+        CHECK(fabs(learned - offset_ppm) <= BENCH_PPM_TOLERANCE);
+    }
+    CHECK(link.worst_counts <= SERVICE_TIME_SYNC_MAX_ADJUST_PPM * 1e-6 * BENCH_PWM_PERIOD + 1.0);
+}
+
+/* A master beyond the trim range: the trim saturates at its clamp and never locks */
+static void check_clamp(void)
+{
+    static link_t link;
+    const double offset_ppm = 2.5 * SERVICE_TIME_SYNC_MAX_ADJUST_PPM;
+    link_init(&link, offset_ppm, 1000.0);
+
+    const uint32_t locked_at = link_run(&link, 4U * BENCH_LOCK_SYNCS);
+    const float limit = link.sync.config.max_adjust * (float)link.sync.config.tick_period;
+    printf("clamp %+.0f ppm: trim at most %.1f counts, integral %.3f of limit\n", offset_ppm, link.worst_counts,
+           link.sync.integral / limit);
+    CHECK(locked_at == UINT32_MAX);
+    CHECK(fabsf(link.sync.integral) <= limit);
+    CHECK(fabsf(link.sync.adjust) <= limit);
+    CHECK(link.worst_counts <= SERVICE_TIME_SYNC_MAX_ADJUST_PPM * 1e-6 * BENCH_PWM_PERIOD + 1.0);
+}
+
+/* SYNC lost for a while: holdover keeps the learned trim, then the lock comes back */
+static void check_holdover(void)
+{
+    static link_t link;
+    const double offset_ppm = 500.0;
+    link_init(&link, offset_ppm, 2000.0);
+    link_run(&link, BENCH_LOCK_SYNCS);
+    CHECK(time_sync_get_state(&link.sync) == TIME_SYNC_STATE_LOCKED);
+
+    const float integral = link.sync.integral;
+    link.sync_on = false;
+    link_run(&link, 50U);
+    time_sync_status_t status;
+    time_sync_get_status(&link.sync, &status);
+    CHECK(status.state == TIME_SYNC_STATE_UNLOCKED);
+    CHECK(status.holdovers == 1U);
+    CHECK(link.sync.adjust == -integral);
+    CHECK(fabs(status.adjust_ppm - offset_ppm) <= BENCH_HOLD_TOLERANCE);
+
+    /* The frequency held, so the phase barely drifted and the lock returns quickly */
+    link.sync_on = true;
+    const uint32_t locked_at = link_run(&link, BENCH_LOCK_SYNCS);
+    printf("holdover %+.0f ppm: trim held at %+d ppm over 50 SYNCs, relocked after %u SYNCs\n", offset_ppm,
+           status.adjust_ppm, locked_at);
+    CHECK(locked_at < BENCH_LOCK_SYNCS);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(void)
+{
+    static link_t link;
+    link_init(&link, 300.0, 1000.0);
+
+    const uint32_t ticks = 2000000U;
+    const double start = now_ns();
+    for (uint32_t tick = 0U; tick < ticks; tick++) {
+        link_tick(&link);
+    }
+    const double with_model = now_ns() - start;
+
+    /* The same without the model: SYNC on every cycle tick 0, fixed period */
+    uint32_t now = 0U;
+    uint32_t sink = 0U;
+    const double bare_start = now_ns();
+    for (uint32_t tick = 0U; tick < ticks; tick++) {
+        if (time_sync_get_cycle_tick(&link.sync) == 0U) {
+            time_sync_on_sync(&link.sync, now - (uint32_t)link.sync.config.phase_offset);
+        }
+        sink += time_sync_tick(&link.sync, now);
+        now += link.sync.config.tick_period;
+    }
+    printf("tick: %.1f ns (%.1f ns with the simulation) (%u)\n", (now_ns() - bare_start) / ticks,
+           with_model / ticks, sink);
+}
+
+int main(void)
+{
+    check_sign();
+    check_lock(0.0, 0.45);
+    check_lock(300.0, -0.45);
+    check_lock(-300.0, 0.2);
+    check_lock(0.9 * SERVICE_TIME_SYNC_MAX_ADJUST_PPM, 0.45);
+    check_lock(-0.9 * SERVICE_TIME_SYNC_MAX_ADJUST_PPM, -0.3);
+    check_clamp();
+    check_holdover();
+    bench();
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
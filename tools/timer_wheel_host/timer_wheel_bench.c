@@ -0,0 +1,286 @@
+/*
+ * Host check and benchmark for services/timer_wheel. Thousands of timers
+ * are started, restarted and stopped at random while time jumps ahead by
+ * random steps, and every expiry is checked against a model: each timer
+ * must fire on the first advance that reaches its tick, never before.
+ * Then the wheel is timed against a sorted list, the structure the
+ * executive used before, at growing timer counts.
+ */
+#define _GNU_SOURCE
+
+#include "services/timer_wheel/timer_wheel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CHECK_TIMERS 4096U
+#define CHECK_STEPS 500000U
+#define BENCH_OPERATIONS 200000U
+#define BENCH_MAX_TIMERS 10000U
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+static int failures;
+
+/* ---- Model check ---- */
+
+typedef struct {
+    timer_wheel_timer_t timer;
+    uint64_t expires; /* [tick], as the model expects it */
+    uint64_t period;  /* [tick] */
+    bool active;
+    uint32_t fired;
+} check_timer_t;
+
+static timer_wheel_t wheel;
+static check_timer_t check_timers[CHECK_TIMERS];
+static uint64_t previous_tick; /* of the last advance */
+static uint64_t advance_tick;  /* of the advance running */
+static uint32_t late;
+static uint32_t early;
+static uint64_t fired_total;
+
+static uint64_t random_u64(void)
+{
+    return ((uint64_t)(uint32_t)rand() << 33) ^ ((uint64_t)(uint32_t)rand() << 12) ^ (uint64_t)(uint32_t)rand();
+}
+
+static uint64_t ticks_up(uint64_t us)
+{
+    return (us + TIMER_WHEEL_TICK_US - 1U) / TIMER_WHEEL_TICK_US;
+}
+
+static void on_check_expired(void *context)
+{
+    check_timer_t *timer = (check_timer_t *)context;
+
+    if (!timer->active || timer->expires > advance_tick) {
+        early++;
+    } else if (timer->expires <= previous_tick) {
+        late++;
+    }
+    timer->fired++;
+    fired_total++;
+
+    if (timer->period != 0U) {
+        timer->expires += timer->period;
+        if (timer->expires <= advance_tick) {
+            timer->expires += ((advance_tick - timer->expires) / timer->period + 1U) * timer->period;
+        }
+    } else {
+        timer->active = false;
+    }
+}
+
+/* Mostly short delays, some long ones, a few beyond the whole wheel */
+static uint32_t random_delay(void)
+{
+    const uint32_t kind = (uint32_t)rand() % 100U;
+    if (kind < 60U) {
+        return (uint32_t)(random_u64() % (64U * TIMER_WHEEL_TICK_US));
+    }
+    if (kind < 90U) {
+        return (uint32_t)(random_u64() % 10000000U);
+    }
+    return (uint32_t)random_u64();
+}
+
+static void check_start(check_timer_t *timer, uint64_t now_us)
+{
+    const uint32_t delay = random_delay();
+    const uint32_t period = ((uint32_t)rand() % 8U == 0U) ? 1U + (uint32_t)(random_u64() % 5000000U) : 0U;
+
+    CHECK(timer_wheel_start(&wheel, &timer->timer, now_us, delay, period) == TIMER_WHEEL_SUCCESS);
+    timer->expires = ticks_up(now_us + delay);
+    if (timer->expires <= previous_tick) {
+        timer->expires = previous_tick + 1U;
+    }
+    timer->period = ticks_up(period);
+    timer->active = true;
+}
+
+static void check_advance(uint64_t now_us)
+{
+    advance_tick = now_us / TIMER_WHEEL_TICK_US;
+    timer_wheel_advance(&wheel, now_us);
+    if (advance_tick > previous_tick) {
+        previous_tick = advance_tick;
+    }
+
+    CHECK(timer_wheel_next(&wheel) == TIMER_WHEEL_NEVER || timer_wheel_next(&wheel) > now_us);
+}
+
+static void check_model(void)
+{
+    uint64_t now_us = random_u64() % (1ULL << 40);
+    srand(1);
+    CHECK(timer_wheel_init(&wheel, now_us) == TIMER_WHEEL_SUCCESS);
+    previous_tick = now_us / TIMER_WHEEL_TICK_US;
+
+    for (uint32_t i = 0U; i < CHECK_TIMERS; i++) {
+        timer_wheel_timer_init(&check_timers[i].timer, on_check_expired, &check_timers[i]);
+    }
+
+    for (uint32_t step = 0U; step < CHECK_STEPS; step++) {
+        check_timer_t *timer = &check_timers[(uint32_t)rand() % CHECK_TIMERS];
+        const uint32_t action = (uint32_t)rand() % 100U;
+
+        if (action < 45U) {
+            check_start(timer, now_us);
+        } else if (action < 55U) {
+            timer_wheel_stop(&wheel, &timer->timer);
+            timer->active = false;
+        } else {
+            /* Mostly within a tick or two, sometimes far past many timers */
+            const uint32_t jump = (uint32_t)rand() % 1000U;
+            now_us += (jump < 990U) ? random_u64() % (2U * TIMER_WHEEL_TICK_US) : random_u64() % (1ULL << 33);
+            check_advance(now_us);
+        }
+    }
+
+    /* Every timer left running must fire: one-shots once, periodic ones at least once */
+    for (uint32_t i = 0U; i < CHECK_TIMERS; i++) {
+        check_timers[i].fired = 0U;
+        CHECK(timer_wheel_active(&check_timers[i].timer) == check_timers[i].active);
+    }
+    now_us += 1ULL << 34;
+    check_advance(now_us);
+    for (uint32_t i = 0U; i < CHECK_TIMERS; i++) {
+        CHECK(!check_timers[i].active || check_timers[i].period != 0U);
+        CHECK(check_timers[i].fired <= 1U);
+    }
+
+    CHECK(early == 0U);
+    CHECK(late == 0U);
+    printf("model check: %llu expiries over %u operations, %u early, %u late\n", (unsigned long long)fired_total,
+           CHECK_STEPS, early, late);
+}
+
+/* ---- Benchmark against a sorted list ---- */
+
+typedef struct list_timer {
+    struct list_timer *next;
+    uint64_t deadline; /* [us] */
+} list_timer_t;
+
+static list_timer_t *list_head;
+static list_timer_t list_timers[BENCH_MAX_TIMERS];
+static timer_wheel_timer_t wheel_timers[BENCH_MAX_TIMERS];
+static uint32_t bench_fired;
+static volatile uint64_t sink;
+
+static void list_start(list_timer_t *timer, uint64_t deadline)
+{
+    for (list_timer_t **link = &list_head; *link != NULL; link = &(*link)->next) {
+        if (*link == timer) {
+            *link = timer->next;
+            break;
+        }
+    }
+
+    list_timer_t **link = &list_head;
+    while (*link != NULL && (*link)->deadline <= deadline) {
+        link = &(*link)->next;
+    }
+    timer->deadline = deadline;
+    timer->next = *link;
+    *link = timer;
+}
+
+static void list_advance(uint64_t now_us)
+{
+    while (list_head != NULL && list_head->deadline <= now_us) {
+        list_head = list_head->next;
+        bench_fired++;
+    }
+}
+
+static void on_bench_expired(void *context)
+{
+    (void)context;
+    bench_fired++;
+}
+
+static double elapsed_ns(const struct timespec *begin)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - begin->tv_sec) * 1e9 + (double)(end.tv_nsec - begin->tv_nsec);
+}
+
+/*
+ * Communication timeouts: count timers between 10 ms and 1 s, each
+ * restarted at random, most before they expire, while time moves on by
+ * 100 us per restart.
+ */
+static void bench(uint32_t count)
+{
+    struct timespec begin;
+    uint64_t now_us = 0U;
+
+    srand(2);
+    list_head = NULL;
+    timer_wheel_init(&wheel, now_us);
+    for (uint32_t i = 0U; i < count; i++) {
+        const uint32_t delay = 10000U + (uint32_t)rand() % 990000U;
+        timer_wheel_timer_init(&wheel_timers[i], on_bench_expired, NULL);
+        timer_wheel_start(&wheel, &wheel_timers[i], now_us, delay, 0U);
+        list_timers[i].next = NULL;
+        list_start(&list_timers[i], now_us + delay);
+    }
+
+    srand(3);
+    bench_fired = 0U;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (uint32_t op = 0U; op < BENCH_OPERATIONS; op++) {
+        now_us += 100U;
+        list_start(&list_timers[(uint32_t)rand() % count], now_us + 10000U + (uint32_t)rand() % 990000U);
+        list_advance(now_us);
+    }
+    const double list_ns = elapsed_ns(&begin) / BENCH_OPERATIONS;
+    const uint32_t list_fired = bench_fired;
+
+    srand(3);
+    now_us = 0U;
+    bench_fired = 0U;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (uint32_t op = 0U; op < BENCH_OPERATIONS; op++) {
+        now_us += 100U;
+        timer_wheel_start(&wheel, &wheel_timers[(uint32_t)rand() % count], now_us, 10000U + (uint32_t)rand() % 990000U,
+                          0U);
+        timer_wheel_advance(&wheel, now_us);
+    }
+    const double wheel_ns = elapsed_ns(&begin) / BENCH_OPERATIONS;
+    const uint32_t wheel_fired = bench_fired;
+
+    /* The idle loop asks for the next deadline before every sleep */
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (uint32_t op = 0U; op < BENCH_OPERATIONS; op++) {
+        sink += timer_wheel_next(&wheel);
+    }
+    const double next_ns = elapsed_ns(&begin) / BENCH_OPERATIONS;
+
+    printf("%6u timers: sorted list %8.1f ns  wheel %6.1f ns per restart and advance, next %5.1f ns"
+           " (%u / %u expired)\n",
+           count, list_ns, wheel_ns, next_ns, list_fired, wheel_fired);
+}
+
+int main(void)
+{
+    check_model();
+
+    printf("tick %u us\n", (unsigned)TIMER_WHEEL_TICK_US);
+    for (uint32_t count = 10U; count <= BENCH_MAX_TIMERS; count *= 10U) {
+        bench(count);
+    }
+
+    printf("%s\n", (failures == 0) ? "all checks passed" : "checks FAILED");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
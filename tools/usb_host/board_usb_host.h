@@ -0,0 +1,46 @@
+#ifndef BOARD_USB_HOST_H
+#define BOARD_USB_HOST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "boards/usb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Results of a host transaction other than a packet length */
+#define BOARD_USB_HOST_NAK (-1)
+#define BOARD_USB_HOST_STALL (-2)
+
+/* Open every endpoint single buffered from the next SET_CONFIGURATION on, for comparison */
+void board_usb_host_single_buffered(bool single);
+
+/* Bus reset: endpoint 0 open at address 0 */
+void board_usb_host_reset(void);
+
+/* SETUP token with its 8-byte packet; always acknowledged, as by the hardware */
+void board_usb_host_setup(uint8_t address, const uint8_t *packet);
+
+/* IN token: the packet length copied to data (up to the max packet size), or NAK/STALL */
+int board_usb_host_in(uint8_t address, uint8_t endpoint, uint8_t *data);
+
+/* OUT token with a packet: 0 when accepted, or NAK/STALL */
+int board_usb_host_out(uint8_t address, uint8_t endpoint, const uint8_t *data, size_t length);
+
+/*
+ * Stand-in for the USB interrupt: report the transactions completed since
+ * the last call and the endpoints board_usb_ep_service() asked for.
+ */
+void board_usb_host_interrupt(void);
+
+/* Address the device answers on */
+uint8_t board_usb_host_device_address(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ * Simulated USB device peripheral behind boards/usb.h. Endpoints hold one or
+ * two packet buffers like the packet memory on the target: an IN buffer is
+ * sent once the class layer fills it, an OUT buffer holds its packet until it
+ * is read, and a host token finding no buffer is NAKed. Completions are only
+ * reported when the test program runs board_usb_host_interrupt(), so it
+ * controls how far the interrupt lags behind the bus.
+ */
+#include "board_usb_host.h"
+
+#include <string.h>
+
+#define SIM_MAX_PACKET 64U
+
+typedef struct {
+    uint8_t data[SIM_MAX_PACKET];
+    size_t length;
+} sim_packet_t;
+
+typedef struct {
+    bool open;
+    bool stalled;
+    uint16_t max_packet;
+    uint8_t buffers;     /* 1, or 2 when double buffered */
+    sim_packet_t queue[2];
+    uint8_t queued;      /* IN: filled and not yet sent, OUT: received and not yet read */
+    bool completed;      /* a transaction finished since the last interrupt */
+    bool setup;          /* endpoint 0 OUT: the completed transaction was a SETUP */
+    bool service;
+} sim_endpoint_t;
+
+static const board_usb_callbacks_t *sim_callbacks;
+static void *sim_context;
+static sim_endpoint_t sim_endpoints[BOARD_USB_MAX_ENDPOINTS][2];
+static uint8_t sim_setup[BOARD_USB_SETUP_SIZE];
+static uint8_t sim_address;
+static bool sim_single_buffered;
+
+static sim_endpoint_t *endpoint(uint8_t address)
+{
+    return &sim_endpoints[BOARD_USB_EP_NUMBER(address) % BOARD_USB_MAX_ENDPOINTS][BOARD_USB_EP_IS_IN(address)];
+}
+
+static void open_endpoint(sim_endpoint_t *ep, uint16_t max_packet, bool double_buffered)
+{
+    memset(ep, 0, sizeof(*ep));
+    ep->open = true;
+    ep->max_packet = max_packet;
+    ep->buffers = double_buffered ? 2U : 1U;
+}
+
+int board_usb_is_supported(void)
+{
+    return 1;
+}
+
+bool board_usb_init(const board_usb_callbacks_t *callbacks, void *context)
+{
+    if (callbacks == NULL) {
+        return false;
+    }
+    sim_callbacks = callbacks;
+    sim_context = context;
+    return true;
+}
+
+uint32_t board_usb_get_unique_id(void)
+{
+    return 0x0C0FFEE5U;
+}
+
+void board_usb_set_address(uint8_t address)
+{
+    sim_address = address;
+}
+
+bool board_usb_ep_open(uint8_t address, board_usb_ep_type_t type, uint16_t max_packet, bool double_buffered)
+{
+    if (BOARD_USB_EP_NUMBER(address) >= BOARD_USB_MAX_ENDPOINTS || max_packet == 0U || max_packet > SIM_MAX_PACKET ||
+        (double_buffered && type != BOARD_USB_EP_BULK)) {
+        return false;
+    }
+    open_endpoint(endpoint(address), max_packet, double_buffered && !sim_single_buffered);
+    return true;
+}
+
+bool board_usb_ep_write(uint8_t address, const uint8_t *data, size_t length, const uint8_t *data2, size_t length2)
+{
+    sim_endpoint_t *ep = endpoint(address);
+    if (!ep->open || ep->queued >= ep->buffers || length + length2 > ep->max_packet) {
+        return false;
+    }
+
+    sim_packet_t *packet = &ep->queue[ep->queued++];
+    if (length > 0U) {
+        memcpy(packet->data, data, length);
+    }
+    if (length2 > 0U) {
+        memcpy(&packet->data[length], data2, length2);
+    }
+    packet->length = length + length2;
+    return true;
+}
+
+int board_usb_ep_rx_length(uint8_t address)
+{
+    sim_endpoint_t *ep = endpoint(address);
+    return (ep->open && ep->queued > 0U) ? (int)ep->queue[0].length : -1;
+}
+
+void board_usb_ep_read(uint8_t address, uint8_t *data, size_t length, uint8_t *data2, size_t length2)
+{
+    sim_endpoint_t *ep = endpoint(address);
+    if (!ep->open || ep->queued == 0U) {
+        return;
+    }
+
+    const sim_packet_t *packet = &ep->queue[0];
+    size_t first = (packet->length < length) ? packet->length : length;
+    memcpy(data, packet->data, first);
+    if (packet->length > first && packet->length - first <= length2) {
+        memcpy(data2, &packet->data[first], packet->length - first);
+    }
+    ep->queue[0] = ep->queue[1];
+    ep->queued--;
+}
+
+void board_usb_ep_stall(uint8_t address, bool stalled)
+{
+    sim_endpoint_t *ep = endpoint(address);
+    if (stalled) {
+        ep->stalled = true;
+    } else if (ep->open) {
+        /* Reconfigured at DATA0 with its buffers empty, as on the target */
+        open_endpoint(ep, ep->max_packet, ep->buffers == 2U);
+    }
+}
+
+bool board_usb_ep_is_stalled(uint8_t address)
+{
+    return endpoint(address)->stalled;
+}
+
+void board_usb_ep_service(uint8_t address)
+{
+    endpoint(address)->service = true;
+}
+
+void board_usb_host_single_buffered(bool single)
+{
+    sim_single_buffered = single;
+}
+
+void board_usb_host_reset(void)
+{
+    memset(sim_endpoints, 0, sizeof(sim_endpoints));
+    sim_address = 0U;
+    open_endpoint(endpoint(0x00U), 64U, false);
+    open_endpoint(endpoint(0x80U), 64U, false);
+    sim_callbacks->reset(sim_context);
+}
+
+void board_usb_host_setup(uint8_t address, const uint8_t *packet)
+{
+    if (address != sim_address) {
+        return;
+    }
+
+    /* A SETUP overrides whatever endpoint 0 was doing, stall included */
+    sim_endpoint_t *out = endpoint(0x00U);
+    sim_endpoint_t *in = endpoint(0x80U);
+    out->stalled = false;
+    out->queued = 0U;
+    in->stalled = false;
+    in->queued = 0U;
+    memcpy(sim_setup, packet, sizeof(sim_setup));
+    out->setup = true;
+    out->completed = true;
+}
+
+int board_usb_host_in(uint8_t address, uint8_t endpoint_number, uint8_t *data)
+{
+    sim_endpoint_t *ep = endpoint((uint8_t)(endpoint_number | BOARD_USB_EP_IN));
+    if (address != sim_address || !ep->open) {
+        return BOARD_USB_HOST_NAK;
+    }
+    if (ep->stalled) {
+        return BOARD_USB_HOST_STALL;
+    }
+    if (ep->queued == 0U) {
+        return BOARD_USB_HOST_NAK;
+    }
+
+    size_t length = ep->queue[0].length;
+    memcpy(data, ep->queue[0].data, length);
+    ep->queue[0] = ep->queue[1];
+    ep->queued--;
+    ep->completed = true;
+    return (int)length;
+}
+
+int board_usb_host_out(uint8_t address, uint8_t endpoint_number, const uint8_t *data, size_t length)
+{
+    sim_endpoint_t *ep = endpoint(endpoint_number);
+    if (address != sim_address || !ep->open) {
+        return BOARD_USB_HOST_NAK;
+    }
+    if (ep->stalled) {
+        return BOARD_USB_HOST_STALL;
+    }
+    if (ep->queued >= ep->buffers || length > ep->max_packet) {
+        return BOARD_USB_HOST_NAK;
+    }
+
+    sim_packet_t *packet = &ep->queue[ep->queued++];
+    memcpy(packet->data, data, length);
+    packet->length = length;
+    ep->completed = true;
+    return 0;
+}
+
+void board_usb_host_interrupt(void)
+{
+    for (uint8_t number = 0U; number < BOARD_USB_MAX_ENDPOINTS; number++) {
+        for (uint8_t is_in = 0U; is_in < 2U; is_in++) {
+            sim_endpoint_t *ep = &sim_endpoints[number][is_in];
+            uint8_t address = (uint8_t)(number | (is_in ? BOARD_USB_EP_IN : 0U));
+            bool report = ep->completed || ep->service;
+            bool setup = ep->setup;
+            ep->completed = false;
+            ep->service = false;
+            ep->setup = false;
+
+            if (setup) {
+                sim_callbacks->setup(sim_setup, sim_context);
+            } else if (report && ep->open) {
+                if (is_in) {
+                    sim_callbacks->in(address, sim_context);
+                } else {
+                    sim_callbacks->out(address, sim_context);
+                }
+            }
+        }
+    }
+}
+
+uint8_t board_usb_host_device_address(void)
+{
+    return sim_address;
+}
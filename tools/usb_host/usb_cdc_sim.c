@@ -0,0 +1,383 @@
+/*
+ * Host check of the USB CDC-ACM driver against the simulated peripheral
+ * (board_usb_sim.c). A scripted host enumerates the device, sets the line
+ * coding and control lines, and exercises halt, reset and stray requests.
+ * Then it streams in both directions frame by frame, at most 19 bulk
+ * packets per 1 ms frame as on a full-speed bus, and checks every byte:
+ * device to host throughput, zero-length packets ending full transfers,
+ * and NAK flow control while the receive ring is full.
+ */
+#include "board_usb_host.h"
+#include "drivers/usb_cdc/usb_cdc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PACKET 64U
+#define SLOTS_PER_FRAME 19U /* full-speed bulk packets of 64 bytes that fit a frame */
+#define STREAM_FRAMES 2000U
+#define RETRIES 16
+
+static usb_cdc_t cdc;
+static int failures;
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+/* Deterministic stream contents: byte n of a stream */
+static uint8_t pattern(uint32_t n)
+{
+    uint32_t x = n * 2654435761U;
+    return (uint8_t)(x >> 24);
+}
+
+static uint32_t random_state = 12345U;
+
+static uint32_t random_below(uint32_t limit)
+{
+    random_state = random_state * 1103515245U + 12345U;
+    return (random_state >> 8) % limit;
+}
+
+static int in_retry(uint8_t address, uint8_t endpoint, uint8_t *data)
+{
+    for (int attempt = 0; attempt < RETRIES; attempt++) {
+        int result = board_usb_host_in(address, endpoint, data);
+        if (result != BOARD_USB_HOST_NAK) {
+            return result;
+        }
+        board_usb_host_interrupt();
+    }
+    return BOARD_USB_HOST_NAK;
+}
+
+static int out_retry(uint8_t address, uint8_t endpoint, const uint8_t *data, size_t length)
+{
+    for (int attempt = 0; attempt < RETRIES; attempt++) {
+        int result = board_usb_host_out(address, endpoint, data, length);
+        if (result != BOARD_USB_HOST_NAK) {
+            return result;
+        }
+        board_usb_host_interrupt();
+    }
+    return BOARD_USB_HOST_NAK;
+}
+
+/*
+ * One control transfer: SETUP, data stage and status stage. Returns the
+ * data stage length, or -1 when the device stalled or stopped answering.
+ */
+static int control(uint8_t type, uint8_t request, uint16_t value, uint16_t index, uint8_t *data, uint16_t length)
+{
+    uint8_t address = board_usb_host_device_address();
+    uint8_t setup[8] = {type,
+                        request,
+                        (uint8_t)value,
+                        (uint8_t)(value >> 8),
+                        (uint8_t)index,
+                        (uint8_t)(index >> 8),
+                        (uint8_t)length,
+                        (uint8_t)(length >> 8)};
+    uint8_t packet[PACKET];
+    int total = 0;
+
+    board_usb_host_setup(address, setup);
+    board_usb_host_interrupt();
+
+    if ((type & 0x80U) != 0U) {
+        while (total < length) {
+            int result = in_retry(address, 0U, packet);
+            if (result < 0) {
+                return -1;
+            }
+            if (total + result > length) {
+                return -1;
+            }
+            memcpy(&data[total], packet, (size_t)result);
+            total += result;
+            board_usb_host_interrupt();
+            if (result < (int)PACKET) {
+                break;
+            }
+        }
+        if (out_retry(address, 0U, NULL, 0U) != 0) {
+            return -1;
+        }
+    } else {
+        while (total < length) {
+            size_t chunk = (length - total < (int)PACKET) ? (size_t)(length - total) : PACKET;
+            if (out_retry(address, 0U, &data[total], chunk) != 0) {
+                return -1;
+            }
+            total += (int)chunk;
+            board_usb_host_interrupt();
+        }
+        if (in_retry(address, 0U, packet) != 0) {
+            return -1;
+        }
+    }
+
+    /* The status stage completion, where SET_ADDRESS takes effect */
+    board_usb_host_interrupt();
+    return total;
+}
+
+static bool enumerate(void)
+{
+    uint8_t buffer[256];
+
+    board_usb_host_reset();
+    board_usb_host_interrupt();
+
+    /* Hosts read the first 8 bytes at address 0 to learn the endpoint 0 size */
+    CHECK(control(0x80, 0x06, 0x0100, 0, buffer, 8) == 8);
+    CHECK(buffer[7] == PACKET);
+    CHECK(control(0x00, 0x05, 7, 0, NULL, 0) == 0);
+    CHECK(board_usb_host_device_address() == 7U);
+
+    CHECK(control(0x80, 0x06, 0x0100, 0, buffer, 18) == 18);
+    CHECK(buffer[4] == 0x02U);
+    CHECK(control(0x80, 0x06, 0x0200, 0, buffer, 9) == 9);
+    uint16_t total = (uint16_t)(buffer[2] | (buffer[3] << 8));
+    CHECK(control(0x80, 0x06, 0x0200, 0, buffer, 255) == total);
+    CHECK(total == 67U);
+
+    /* Serial number from the unique ID, UTF-16LE */
+    int length = control(0x80, 0x06, 0x0303, 0x0409, buffer, 255);
+    CHECK(length == 18);
+    CHECK(length == 18 && buffer[2] == '0' && buffer[4] == 'C' && buffer[16] == '5');
+    CHECK(control(0x80, 0x06, 0x0300, 0, buffer, 255) == 4);
+    CHECK(control(0x80, 0x06, 0x0304, 0x0409, buffer, 255) < 0);
+    /* No device qualifier on a full-speed only device */
+    CHECK(control(0x80, 0x06, 0x0600, 0, buffer, 10) < 0);
+
+    CHECK(control(0x00, 0x09, 1, 0, NULL, 0) == 0);
+    CHECK(control(0x80, 0x08, 0, 0, buffer, 1) == 1 && buffer[0] == 1U);
+    return failures == 0;
+}
+
+static void check_line_state(void)
+{
+    uint8_t coding[7] = {0x00, 0x10, 0x0E, 0x00, 0, 0, 8}; /* 921600 8N1 */
+    uint8_t readback[7];
+
+    CHECK(control(0x21, 0x20, 0, 0, coding, sizeof(coding)) == 7);
+    CHECK(cdc.line_coding.baudrate == 921600U);
+    CHECK(control(0xA1, 0x21, 0, 0, readback, sizeof(readback)) == 7);
+    CHECK(memcmp(coding, readback, sizeof(coding)) == 0);
+
+    /* Nobody listening yet: telemetry is dropped, not queued */
+    CHECK(usb_cdc_write(&cdc, "x", 1U) == USB_CDC_ERROR_NOT_CONNECTED);
+    CHECK(control(0x21, 0x22, 0x0003, 0, NULL, 0) == 0);
+    CHECK(usb_cdc_is_connected(&cdc));
+
+    /* Vendor requests and class requests to the data interface stall */
+    CHECK(control(0x40, 0x01, 0, 0, NULL, 0) < 0);
+    CHECK(control(0x21, 0x22, 0x0003, 1, NULL, 0) < 0);
+}
+
+static void check_halt(void)
+{
+    uint8_t packet[PACKET];
+    uint8_t status[2];
+    uint8_t address = board_usb_host_device_address();
+
+    CHECK(control(0x02, 0x03, 0, 0x81, NULL, 0) == 0);
+    CHECK(board_usb_host_in(address, 1U, packet) == BOARD_USB_HOST_STALL);
+    CHECK(control(0x82, 0x00, 0, 0x81, status, 2) == 2 && status[0] == 1U);
+    CHECK(control(0x02, 0x01, 0, 0x81, NULL, 0) == 0);
+    CHECK(board_usb_host_in(address, 1U, packet) == BOARD_USB_HOST_NAK);
+    CHECK(control(0x82, 0x00, 0, 0x81, status, 2) == 2 && status[0] == 0U);
+}
+
+/*
+ * Device to host: the main loop writes chunks of random size while the host
+ * polls the bulk IN endpoint in every slot. The interrupt runs after every
+ * interrupt_every slots, standing in for the higher-priority control loop
+ * holding it off.
+ */
+static double stream_in(unsigned interrupt_every)
+{
+    uint8_t address = board_usb_host_device_address();
+    uint8_t packet[PACKET];
+    uint8_t chunk[512];
+    uint32_t written = 0U;
+    uint32_t received = 0U;
+    uint32_t streamed = 0U;
+    unsigned zero_length = 0U;
+    int last = -1;
+
+    for (unsigned frame = 0U; frame < STREAM_FRAMES + 10U; frame++) {
+        if (frame == STREAM_FRAMES) {
+            /* End on a full packet, which leaves the transfer open until a zero-length packet */
+            size_t size = PACKET - (written % PACKET);
+            for (size_t i = 0U; i < size; i++) {
+                chunk[i] = pattern(written + (uint32_t)i);
+            }
+            CHECK(usb_cdc_write(&cdc, chunk, size) == USB_CDC_SUCCESS);
+            written += (uint32_t)size;
+        }
+        while (frame < STREAM_FRAMES) {
+            size_t size = 1U + random_below(sizeof(chunk));
+            if (usb_cdc_get_tx_free(&cdc) < size) {
+                break;
+            }
+            for (size_t i = 0U; i < size; i++) {
+                chunk[i] = pattern(written + (uint32_t)i);
+            }
+            CHECK(usb_cdc_write(&cdc, chunk, size) == USB_CDC_SUCCESS);
+            written += (uint32_t)size;
+        }
+
+        for (unsigned slot = 0U; slot < SLOTS_PER_FRAME; slot++) {
+            int length = board_usb_host_in(address, 1U, packet);
+            if (length >= 0) {
+                for (int i = 0; i < length; i++) {
+                    if (packet[i] != pattern(received + (uint32_t)i)) {
+                        CHECK(packet[i] == pattern(received + (uint32_t)i));
+                        return 0.0;
+                    }
+                }
+                received += (uint32_t)length;
+                zero_length += (length == 0);
+                last = length;
+            }
+            if ((slot + 1U) % interrupt_every == 0U) {
+                board_usb_host_interrupt();
+            }
+        }
+        board_usb_host_interrupt();
+        if (frame == STREAM_FRAMES - 1U) {
+            streamed = received;
+        }
+    }
+
+    CHECK(received == written);
+    CHECK(last == 0);
+    CHECK(zero_length > 0U);
+    return (double)streamed / STREAM_FRAMES; /* bytes per 1 ms frame, i.e. kB/s */
+}
+
+/*
+ * Host to device: the host sends as fast as the bus allows while the reader
+ * takes a limited amount per frame, so the receive ring fills and the
+ * endpoint must NAK instead of dropping packets.
+ */
+static void stream_out(void)
+{
+    uint8_t address = board_usb_host_device_address();
+    uint8_t packet[PACKET];
+    const uint32_t total = 256U * 1024U;
+    uint32_t sent = 0U;
+    uint32_t consumed = 0U;
+    unsigned naks = 0U;
+
+    for (unsigned frame = 0U; consumed < total && frame < 100000U; frame++) {
+        for (unsigned slot = 0U; slot < SLOTS_PER_FRAME && sent < total; slot++) {
+            size_t length = 1U + random_below(PACKET);
+            if (length > total - sent) {
+                length = total - sent;
+            }
+            for (size_t i = 0U; i < length; i++) {
+                packet[i] = pattern(sent + (uint32_t)i);
+            }
+            int result = board_usb_host_out(address, 2U, packet, length);
+            CHECK(result != BOARD_USB_HOST_STALL);
+            if (result == 0) {
+                sent += (uint32_t)length;
+            } else {
+                naks++;
+            }
+            if (slot % 2U == 1U) {
+                board_usb_host_interrupt();
+            }
+        }
+        board_usb_host_interrupt();
+
+        /* The reader: a contiguous block when it fits, otherwise span by span */
+        size_t budget = 100U + random_below(400U);
+        uint8_t *block = usb_cdc_rx_contiguous(&cdc, USB_CDC_RX_CONTIGUOUS_SIZE);
+        if (block != NULL && budget >= USB_CDC_RX_CONTIGUOUS_SIZE) {
+            for (size_t i = 0U; i < USB_CDC_RX_CONTIGUOUS_SIZE; i++) {
+                CHECK(block[i] == pattern(consumed + (uint32_t)i));
+            }
+            usb_cdc_rx_consume(&cdc, USB_CDC_RX_CONTIGUOUS_SIZE);
+            consumed += USB_CDC_RX_CONTIGUOUS_SIZE;
+            continue;
+        }
+        size_t length = 0U;
+        const uint8_t *span = usb_cdc_rx_span(&cdc, 0U, &length);
+        if (span == NULL) {
+            continue;
+        }
+        if (length > budget) {
+            length = budget;
+        }
+        for (size_t i = 0U; i < length; i++) {
+            if (span[i] != pattern(consumed + (uint32_t)i)) {
+                CHECK(span[i] == pattern(consumed + (uint32_t)i));
+                return;
+            }
+        }
+        usb_cdc_rx_consume(&cdc, length);
+        consumed += (uint32_t)length;
+    }
+
+    CHECK(sent == total);
+    CHECK(consumed == total);
+    CHECK(naks > 0U);
+    printf("host to device: %u bytes in order, %u NAKs while the ring was full\n", consumed, naks);
+}
+
+static void check_disconnect(void)
+{
+    CHECK(usb_cdc_write(&cdc, "pending", 7U) == USB_CDC_SUCCESS);
+    CHECK(control(0x21, 0x22, 0x0000, 0, NULL, 0) == 0);
+    CHECK(!usb_cdc_is_connected(&cdc));
+    CHECK(usb_cdc_get_tx_free(&cdc) == USB_CDC_TX_BUFFER_SIZE);
+    CHECK(usb_cdc_write(&cdc, "late", 4U) == USB_CDC_ERROR_NOT_CONNECTED);
+
+    CHECK(control(0x21, 0x22, 0x0001, 0, NULL, 0) == 0);
+    board_usb_host_reset();
+    board_usb_host_interrupt();
+    CHECK(!usb_cdc_is_connected(&cdc));
+    CHECK(cdc.configuration == 0U);
+}
+
+int main(void)
+{
+    CHECK(usb_cdc_init(&cdc) == USB_CDC_SUCCESS);
+
+    if (!enumerate()) {
+        fprintf(stderr, "enumeration failed\n");
+        return 1;
+    }
+    check_line_state();
+    check_halt();
+
+    double double_buffered = stream_in(2U);
+    stream_out();
+    check_disconnect();
+
+    /* Same stream with one buffer per endpoint, for comparison */
+    board_usb_host_single_buffered(true);
+    enumerate();
+    CHECK(control(0x21, 0x22, 0x0001, 0, NULL, 0) == 0);
+    double single_buffered = stream_in(2U);
+
+    printf("device to host: %.0f kB/s double buffered, %.0f kB/s single buffered (bus limit %u kB/s)\n",
+           double_buffered, single_buffered, SLOTS_PER_FRAME * PACKET);
+
+    if (failures != 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}